@@ -3,7 +3,7 @@ TEMPLATE = lib
 TARGET = qgsttools_p
 QPRO_PWD = $$PWD
 
-QT = core-private multimedia-private gui-private
+QT = core-private multimedia-private gui-private network
 
 !static:DEFINES += QT_MAKEDLL
 DEFINES += GLIB_VERSION_MIN_REQUIRED=GLIB_VERSION_2_26
@@ -51,6 +51,7 @@ PRIVATE_HEADERS += \
     qgstreamermessage_p.h \
     qgstutils_p.h \
     qgstvideobuffer_p.h \
+    qgstaudiobuffer_p.h \
     qvideosurfacegstsink_p.h \
     qgstreamerbufferprobe_p.h \
     qgstreamervideorendererinterface_p.h \
@@ -58,26 +59,31 @@ PRIVATE_HEADERS += \
     qgstreamervideorenderer_p.h \
     qgstreamervideoinputdevicecontrol_p.h \
     qgstcodecsinfo_p.h \
+    qgstimagecaptureworker_p.h \
     qgstreamervideoprobecontrol_p.h \
     qgstreameraudioprobecontrol_p.h \
     qgstreamervideowindow_p.h \
-    qgstreamervideooverlay_p.h
+    qgstreamervideooverlay_p.h \
+    qgstreamermediacache_p.h
 
 SOURCES += \
     qgstreamerbushelper.cpp \
     qgstreamermessage.cpp \
     qgstutils.cpp \
     qgstvideobuffer.cpp \
+    qgstaudiobuffer.cpp \
     qgstreamerbufferprobe.cpp \
     qgstreamervideorendererinterface.cpp \
     qgstreameraudioinputselector.cpp \
     qgstreamervideorenderer.cpp \
     qgstreamervideoinputdevicecontrol.cpp \
     qgstcodecsinfo.cpp \
+    qgstimagecaptureworker.cpp \
     qgstreamervideoprobecontrol.cpp \
     qgstreameraudioprobecontrol.cpp \
     qgstreamervideowindow.cpp \
-    qgstreamervideooverlay.cpp
+    qgstreamervideooverlay.cpp \
+    qgstreamermediacache.cpp
 
 qtHaveModule(widgets) {
     QT += multimediawidgets
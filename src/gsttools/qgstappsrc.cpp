@@ -32,9 +32,95 @@
 ****************************************************************************/
 
 #include <QDebug>
+#include <QtCore/qbuffer.h>
+#include <QtCore/qfile.h>
+#include <QtCore/qthread.h>
 
 #include "qgstappsrc_p.h"
 
+QT_BEGIN_NAMESPACE
+
+// Block sizes read or wrapped per buffer in the memory and worker feeds.
+static const qint64 MinimumBlockSize = 16 * 1024;
+static const qint64 InitialBlockSize = 64 * 1024;
+static const qint64 MaximumBlockSize = 1024 * 1024;
+
+static qint64 readAheadBytes()
+{
+    bool ok = false;
+    const qint64 kilobytes = qgetenv("QT_GSTREAMER_APPSRC_READAHEAD").toLongLong(&ok);
+    return ok && kilobytes > 0 ? kilobytes * 1024 : 4 * 1024 * 1024;
+}
+
+// Reference counted memory of a QBuffer or a mapped file, kept alive until
+// the last buffer wrapping it has been released downstream.
+class QGstAppSrcMemory
+{
+public:
+    static QGstAppSrcMemory *create(QIODevice *stream);
+
+    static void release(gpointer memory)
+    {
+        QGstAppSrcMemory *self = static_cast<QGstAppSrcMemory *>(memory);
+        if (!self->ref.deref())
+            delete self;
+    }
+
+    QAtomicInt ref;
+    QByteArray array;
+    QFile file;
+    const uchar *data;
+    qint64 size;
+
+private:
+    QGstAppSrcMemory() : ref(1), data(0), size(0) {}
+};
+
+QGstAppSrcMemory *QGstAppSrcMemory::create(QIODevice *stream)
+{
+    if (QBuffer *buffer = qobject_cast<QBuffer *>(stream)) {
+        if (buffer->data().isEmpty())
+            return 0;
+
+        // A shallow copy, writes to the QBuffer detach from it
+        QGstAppSrcMemory *memory = new QGstAppSrcMemory;
+        memory->array = buffer->data();
+        memory->data = reinterpret_cast<const uchar *>(memory->array.constData());
+        memory->size = memory->array.size();
+        return memory;
+    }
+
+    QFile *file = qobject_cast<QFile *>(stream);
+    if (!file || file->fileName().isEmpty() || file->isSequential())
+        return 0;
+
+    // Map a file of our own, the stream may be closed while buffers are in flight
+    QGstAppSrcMemory *memory = new QGstAppSrcMemory;
+    memory->file.setFileName(file->fileName());
+    if (memory->file.open(QIODevice::ReadOnly) && memory->file.size() > 0) {
+        memory->size = memory->file.size();
+        memory->data = memory->file.map(0, memory->size);
+    }
+
+    if (!memory->data) {
+        delete memory;
+        return 0;
+    }
+    return memory;
+}
+
+class QGstAppSrcWorker : public QThread
+{
+public:
+    QGstAppSrcWorker(QGstAppSrc *appSrc) : m_appSrc(appSrc) {}
+
+protected:
+    void run() { m_appSrc->feedFromWorker(); }
+
+private:
+    QGstAppSrc * const m_appSrc;
+};
+
 QGstAppSrc::QGstAppSrc(QObject *parent)
     :QObject(parent)
     ,m_stream(0)
@@ -45,6 +131,16 @@ QGstAppSrc::QGstAppSrc(QObject *parent)
     ,m_dataRequested(false)
     ,m_enoughData(false)
     ,m_forceData(false)
+    ,m_workerEnabled(true)
+    ,m_feedMode(OwnerThreadFeed)
+    ,m_memory(0)
+    ,m_worker(0)
+    ,m_feedOffset(0)
+    ,m_blockSize(InitialBlockSize)
+    ,m_seekGeneration(0)
+    ,m_seekPending(false)
+    ,m_feedEnd(false)
+    ,m_stopFeeding(false)
 {
     m_callbacks.need_data   = &QGstAppSrc::on_need_data;
     m_callbacks.enough_data = &QGstAppSrc::on_enough_data;
@@ -53,12 +149,16 @@ QGstAppSrc::QGstAppSrc(QObject *parent)
 
 QGstAppSrc::~QGstAppSrc()
 {
+    stopFeeding();
+
     if (m_appSrc)
         gst_object_unref(G_OBJECT(m_appSrc));
 }
 
 bool QGstAppSrc::setup(GstElement* appsrc)
 {
+    stopFeeding();
+
     if (m_appSrc) {
         gst_object_unref(G_OBJECT(m_appSrc));
         m_appSrc = 0;
@@ -69,21 +169,29 @@ bool QGstAppSrc::setup(GstElement* appsrc)
 
     m_appSrc = GST_APP_SRC(appsrc);
     gst_object_ref(G_OBJECT(m_appSrc));
-    gst_app_src_set_callbacks(m_appSrc, (GstAppSrcCallbacks*)&m_callbacks, this, (GDestroyNotify)&QGstAppSrc::destroy_notify);
 
     m_maxBytes = gst_app_src_get_max_bytes(m_appSrc);
     m_streamType = GST_APP_STREAM_TYPE_SEEKABLE;
     gst_app_src_set_stream_type(m_appSrc, m_streamType);
-    gst_app_src_set_size(m_appSrc, m_stream->size());
+    // A random access stream still downloading may not know its size yet
+    const qint64 size = m_stream->size();
+    gst_app_src_set_size(m_appSrc, m_sequential || size > 0 ? size : -1);
+
+    // The feed mode must be settled before the first callback arrives
+    startFeeding();
+    gst_app_src_set_callbacks(m_appSrc, (GstAppSrcCallbacks*)&m_callbacks, this, (GDestroyNotify)&QGstAppSrc::destroy_notify);
 
     return true;
 }
 
 void QGstAppSrc::setStream(QIODevice *stream)
 {
+    stopFeeding();
+
     if (m_stream) {
         disconnect(m_stream, SIGNAL(readyRead()), this, SLOT(onDataReady()));
         disconnect(m_stream, SIGNAL(destroyed()), this, SLOT(streamDestroyed()));
+        disconnect(m_stream, SIGNAL(aboutToClose()), this, SLOT(streamAboutToClose()));
         m_stream = 0;
     }
 
@@ -104,6 +212,8 @@ void QGstAppSrc::setStream(QIODevice *stream)
         m_stream->reset();
         connect(m_stream, SIGNAL(destroyed()), SLOT(streamDestroyed()));
         connect(m_stream, SIGNAL(readyRead()), this, SLOT(onDataReady()));
+        // The worker must be done with the stream before it goes away
+        connect(m_stream, SIGNAL(aboutToClose()), this, SLOT(streamAboutToClose()), Qt::DirectConnection);
         m_sequential = m_stream->isSequential();
     }
 }
@@ -113,6 +223,11 @@ QIODevice *QGstAppSrc::stream() const
     return m_stream;
 }
 
+void QGstAppSrc::setWorkerEnabled(bool enabled)
+{
+    m_workerEnabled = enabled;
+}
+
 GstAppSrc *QGstAppSrc::element()
 {
     return m_appSrc;
@@ -120,6 +235,9 @@ GstAppSrc *QGstAppSrc::element()
 
 void QGstAppSrc::onDataReady()
 {
+    if (m_feedMode != OwnerThreadFeed)
+        return;
+
     if (!m_enoughData) {
         m_dataRequested = true;
         pushDataToAppSrc();
@@ -129,16 +247,26 @@ void QGstAppSrc::onDataReady()
 void QGstAppSrc::streamDestroyed()
 {
     if (sender() == m_stream) {
+        stopFeeding();
         m_stream = 0;
         sendEOS();
     }
 }
 
+void QGstAppSrc::streamAboutToClose()
+{
+    if (sender() == m_stream && m_feedMode == WorkerFeed)
+        stopFeeding();
+}
+
 void QGstAppSrc::pushDataToAppSrc()
 {
-    if (!isStreamValid() || !m_appSrc)
+    if (!isStreamValid() || !m_appSrc || m_feedMode != OwnerThreadFeed)
         return;
 
+    if (!m_sequential && m_stream->size() > 0 && gst_app_src_get_size(m_appSrc) != m_stream->size())
+        gst_app_src_set_size(m_appSrc, m_stream->size());
+
     if (m_dataRequested && !m_enoughData) {
         qint64 size;
         if (m_dataRequestSize == ~0u)
@@ -186,7 +314,7 @@ void QGstAppSrc::pushDataToAppSrc()
                 }
 #endif
             }
-        } else {
+        } else if (m_stream->atEnd()) {
             sendEOS();
         }
     } else if (m_stream->atEnd()) {
@@ -206,7 +334,24 @@ gboolean QGstAppSrc::on_seek_data(GstAppSrc *element, guint64 arg0, gpointer use
 {
     Q_UNUSED(element);
     QGstAppSrc *self = reinterpret_cast<QGstAppSrc*>(userdata);
-    if (self && self->isStreamValid()) {
+    if (!self)
+        return false;
+
+    {
+        QMutexLocker locker(&self->m_feedMutex);
+        if (self->m_feedMode != OwnerThreadFeed) {
+            // Applied before returning, the element drops what was queued
+            // so far and a read racing the seek is discarded by the feeder.
+            self->m_feedOffset = arg0;
+            ++self->m_seekGeneration;
+            self->m_seekPending = self->m_feedMode == WorkerFeed;
+            self->m_feedEnd = false;
+            self->m_feedCondition.wakeAll();
+            return true;
+        }
+    }
+
+    if (self->isStreamValid()) {
         if (!self->stream()->isSequential())
             QMetaObject::invokeMethod(self, "doSeek", Qt::AutoConnection, Q_ARG(qint64, arg0));
     }
@@ -220,20 +365,38 @@ void QGstAppSrc::on_enough_data(GstAppSrc *element, gpointer userdata)
 {
     Q_UNUSED(element);
     QGstAppSrc *self = reinterpret_cast<QGstAppSrc*>(userdata);
-    if (self)
+    if (self) {
+        // May be called from within a push holding m_feedMutex
+        self->m_feedEnough.store(1);
+        self->m_enoughSinceNeed.store(1);
         self->enoughData() = true;
+    }
 }
 
 void QGstAppSrc::on_need_data(GstAppSrc *element, guint arg0, gpointer userdata)
 {
     Q_UNUSED(element);
     QGstAppSrc *self = reinterpret_cast<QGstAppSrc*>(userdata);
-    if (self) {
-        self->dataRequested() = true;
-        self->enoughData() = false;
-        self->dataRequestSize()= arg0;
-        QMetaObject::invokeMethod(self, "pushDataToAppSrc", Qt::AutoConnection);
+    if (!self)
+        return;
+
+    {
+        QMutexLocker locker(&self->m_feedMutex);
+        if (self->m_feedMode != OwnerThreadFeed) {
+            self->m_feedEnough.store(0);
+            self->adaptBlockSize();
+            if (self->m_feedMode == MemoryFeed)
+                self->pushMemory();
+            else
+                self->m_feedCondition.wakeAll();
+            return;
+        }
     }
+
+    self->dataRequested() = true;
+    self->enoughData() = false;
+    self->dataRequestSize()= arg0;
+    QMetaObject::invokeMethod(self, "pushDataToAppSrc", Qt::AutoConnection);
 }
 
 void QGstAppSrc::destroy_notify(gpointer data)
@@ -250,3 +413,219 @@ void QGstAppSrc::sendEOS()
     if (isStreamValid() && !stream()->isSequential())
         stream()->reset();
 }
+
+void QGstAppSrc::startFeeding()
+{
+    m_feedMode = OwnerThreadFeed;
+    if (m_sequential || !m_workerEnabled || qgetenv("QT_GSTREAMER_APPSRC_OWNER_THREAD") == "1")
+        return;
+
+    FeedMode mode = OwnerThreadFeed;
+#if GST_CHECK_VERSION(1,0,0)
+    m_memory = QGstAppSrcMemory::create(m_stream);
+    if (m_memory)
+        mode = MemoryFeed;
+#endif
+    // Anything that can't be read right away waits on its own thread for data
+    if (mode == OwnerThreadFeed && m_stream->size() > 0
+            && m_stream->bytesAvailable() >= m_stream->size() - m_stream->pos()) {
+        mode = WorkerFeed;
+    }
+    if (mode == OwnerThreadFeed)
+        return;
+
+    QMutexLocker locker(&m_feedMutex);
+    m_feedMode = mode;
+    m_feedOffset = m_stream->pos();
+    m_blockSize = InitialBlockSize;
+    m_seekGeneration = 0;
+    m_seekPending = false;
+    m_feedEnd = false;
+    m_stopFeeding = false;
+    // Nothing is pushed before the element asks for it, buffers pushed
+    // ahead of the element starting would be flushed.
+    m_feedEnough.store(1);
+    m_enoughSinceNeed.store(0);
+
+    // The element's queue is the read-ahead
+    m_maxBytes = readAheadBytes();
+    gst_app_src_set_max_bytes(m_appSrc, m_maxBytes);
+
+    if (m_feedMode == WorkerFeed) {
+        m_worker = new QGstAppSrcWorker(this);
+        m_worker->start();
+    }
+}
+
+void QGstAppSrc::stopFeeding()
+{
+    if (m_worker) {
+        m_feedMutex.lock();
+        m_stopFeeding = true;
+        m_feedCondition.wakeAll();
+        m_feedMutex.unlock();
+
+        m_worker->wait();
+        delete m_worker;
+        m_worker = 0;
+    }
+
+    QMutexLocker locker(&m_feedMutex);
+    m_feedMode = OwnerThreadFeed;
+    if (m_memory) {
+        QGstAppSrcMemory::release(m_memory);
+        m_memory = 0;
+    }
+#if GST_CHECK_VERSION(1,0,0)
+    // Buffers still downstream are freed as they come back
+    foreach (GstBufferPool *pool, m_pools) {
+        gst_buffer_pool_set_active(pool, FALSE);
+        gst_object_unref(pool);
+    }
+    m_pools.clear();
+#endif
+}
+
+// Called with m_feedMutex held on each need-data.
+void QGstAppSrc::adaptBlockSize()
+{
+    // Running dry without the queue ever filling up means the consumer is
+    // faster than the feed, larger blocks cut the per buffer overhead.
+    // Otherwise smaller blocks keep the latency after seeks low.
+    if (m_enoughSinceNeed.fetchAndStoreRelaxed(0))
+        m_blockSize = qMax(m_blockSize / 2, MinimumBlockSize);
+    else
+        m_blockSize = qMin(m_blockSize * 2, MaximumBlockSize);
+}
+
+// Called with m_feedMutex held from need-data, on the streaming thread.
+void QGstAppSrc::pushMemory()
+{
+#if GST_CHECK_VERSION(1,0,0)
+    while (!m_feedEnd && !m_feedEnough.load()) {
+        if (m_feedOffset >= m_memory->size) {
+            m_feedEnd = true;
+            gst_app_src_end_of_stream(m_appSrc);
+            break;
+        }
+
+        const qint64 length = qMin(m_blockSize, m_memory->size - m_feedOffset);
+        m_memory->ref.ref();
+        GstBuffer *buffer = gst_buffer_new_wrapped_full(GST_MEMORY_FLAG_READONLY,
+                                                        const_cast<uchar *>(m_memory->data),
+                                                        m_memory->size, m_feedOffset, length,
+                                                        m_memory, &QGstAppSrcMemory::release);
+        GST_BUFFER_OFFSET(buffer) = m_feedOffset;
+        GST_BUFFER_OFFSET_END(buffer) = m_feedOffset + length;
+
+        // A refused block is pushed again on the next need-data
+        if (gst_app_src_push_buffer(m_appSrc, buffer) != GST_FLOW_OK)
+            break;
+        m_feedOffset += length;
+    }
+#endif
+}
+
+// Called on the worker only; pool buffers are recycled once downstream is done.
+// Block sizes are powers of two, each one gets a pool of its own so changing
+// the size doesn't throw away the buffers of the others.
+GstBuffer *QGstAppSrc::allocateBuffer(qint64 size)
+{
+#if GST_CHECK_VERSION(1,0,0)
+    GstBufferPool *pool = m_pools.value(size);
+    if (!pool) {
+        pool = gst_buffer_pool_new();
+        GstStructure *config = gst_buffer_pool_get_config(pool);
+        gst_buffer_pool_config_set_params(config, NULL, size, 0, 0);
+        gst_buffer_pool_set_config(pool, config);
+        gst_buffer_pool_set_active(pool, TRUE);
+        m_pools.insert(size, pool);
+    }
+
+    GstBuffer *buffer = 0;
+    if (gst_buffer_pool_acquire_buffer(pool, &buffer, NULL) == GST_FLOW_OK) {
+        // The previous user may have trimmed it to what was read
+        gst_buffer_set_size(buffer, size);
+        return buffer;
+    }
+#endif
+    return gst_buffer_new_and_alloc(size);
+}
+
+void QGstAppSrc::feedFromWorker()
+{
+    QMutexLocker locker(&m_feedMutex);
+    while (!m_stopFeeding) {
+        if (m_seekPending) {
+            m_seekPending = false;
+            const qint64 offset = m_feedOffset;
+            locker.unlock();
+            m_stream->seek(offset);
+            locker.relock();
+            continue;
+        }
+
+        if (m_feedEnd || m_feedEnough.load()) {
+            m_feedCondition.wait(&m_feedMutex);
+            continue;
+        }
+
+        const quint64 generation = m_seekGeneration;
+        const qint64 offset = m_feedOffset;
+        const qint64 blockSize = m_blockSize;
+        locker.unlock();
+
+        GstBuffer *buffer = allocateBuffer(blockSize);
+#if GST_CHECK_VERSION(1,0,0)
+        GstMapInfo mapInfo;
+        gst_buffer_map(buffer, &mapInfo, GST_MAP_WRITE);
+        const qint64 bytesRead = m_stream->read(reinterpret_cast<char *>(mapInfo.data), blockSize);
+        gst_buffer_unmap(buffer, &mapInfo);
+#else
+        const qint64 bytesRead = m_stream->read(reinterpret_cast<char *>(GST_BUFFER_DATA(buffer)), blockSize);
+#endif
+        const bool atEnd = bytesRead <= 0 && m_stream->atEnd();
+
+        locker.relock();
+        if (generation != m_seekGeneration || m_stopFeeding || bytesRead <= 0) {
+            gst_buffer_unref(buffer);
+            if (generation != m_seekGeneration || m_stopFeeding)
+                continue;
+
+            if (bytesRead < 0 || atEnd) {
+                if (bytesRead < 0)
+                    qWarning() << "appsrc: stream read error" << m_stream->errorString();
+                m_feedEnd = true;
+                gst_app_src_end_of_stream(m_appSrc);
+            } else {
+                m_feedCondition.wait(&m_feedMutex, 10);
+            }
+            continue;
+        }
+
+#if GST_CHECK_VERSION(1,0,0)
+        gst_buffer_set_size(buffer, bytesRead);
+#else
+        GST_BUFFER_SIZE(buffer) = bytesRead;
+#endif
+        GST_BUFFER_OFFSET(buffer) = offset;
+        GST_BUFFER_OFFSET_END(buffer) = offset + bytesRead;
+        m_feedOffset = offset + bytesRead;
+
+        // Pushed with the lock held so a concurrent seek can't slip in
+        // between the generation check and the buffer reaching the queue.
+        const GstFlowReturn ret = gst_app_src_push_buffer(m_appSrc, buffer);
+        if (ret != GST_FLOW_OK) {
+            if (ret == GST_FLOW_ERROR)
+                qWarning() << "appsrc: push buffer error";
+            // Flushing or stopped, typically the tail of a seek which woke
+            // us before the element stopped flushing. The block was dropped,
+            // so read it again once the element asks for data.
+            m_feedOffset = offset;
+            m_seekPending = true;
+            m_feedEnough.store(1);
+        }
+    }
+}
+
+QT_END_NAMESPACE
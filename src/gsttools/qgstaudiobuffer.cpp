@@ -0,0 +1,88 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#include "qgstaudiobuffer_p.h"
+
+QT_BEGIN_NAMESPACE
+
+QGstAudioBuffer::QGstAudioBuffer(GstBuffer *buffer, const QAudioFormat &format, qint64 startTime)
+    : m_buffer(buffer)
+    , m_data(0)
+    , m_format(format)
+    , m_startTime(startTime)
+    , m_frameCount(0)
+{
+    gst_buffer_ref(m_buffer);
+
+#if GST_CHECK_VERSION(1,0,0)
+    if (gst_buffer_map(m_buffer, &m_mapInfo, GST_MAP_READ)) {
+        m_data = m_mapInfo.data;
+        m_frameCount = m_format.framesForBytes(m_mapInfo.size);
+    }
+#else
+    m_data = m_buffer->data;
+    m_frameCount = m_format.framesForBytes(m_buffer->size);
+#endif
+}
+
+QGstAudioBuffer::~QGstAudioBuffer()
+{
+#if GST_CHECK_VERSION(1,0,0)
+    if (m_data)
+        gst_buffer_unmap(m_buffer, &m_mapInfo);
+#endif
+
+    gst_buffer_unref(m_buffer);
+}
+
+void QGstAudioBuffer::release()
+{
+    delete this;
+}
+
+void *QGstAudioBuffer::writableData()
+{
+    // The buffer is only mapped for reading, and may still be referenced by
+    // the pipeline. Returning 0 makes QAudioBuffer::data() take a copy.
+    return 0;
+}
+
+QAbstractAudioBuffer *QGstAudioBuffer::clone() const
+{
+    // A clone is only requested to get a writable buffer, let QAudioBuffer
+    // fall back to a memory copy.
+    return 0;
+}
+
+QT_END_NAMESPACE
@@ -33,33 +33,172 @@
 
 #include "qgstcodecsinfo_p.h"
 #include "qgstutils_p.h"
-#include <QtCore/qset.h>
+#include <QtCore/qdatetime.h>
+#include <QtCore/qdir.h>
+#include <QtCore/qfile.h>
+#include <QtCore/qfileinfo.h>
+#include <QtCore/qglobalstatic.h>
+#include <QtCore/qjsonarray.h>
+#include <QtCore/qjsondocument.h>
+#include <QtCore/qjsonobject.h>
+#include <QtCore/qsavefile.h>
+#include <QtCore/qstandardpaths.h>
 
 #ifdef QMEDIA_GSTREAMER_CAMERABIN
 #include <gst/pbutils/pbutils.h>
 #include <gst/pbutils/encoding-profile.h>
 #endif
 
+static const char *elementTypeKeys[] = { "AudioEncoder", "VideoEncoder", "Muxer" };
 
-QGstCodecsInfo::QGstCodecsInfo(QGstCodecsInfo::ElementType elementType)
+Q_GLOBAL_STATIC(QGstCodecsInfoCache, codecsInfoCache)
+
+QGstCodecsInfoCache::QGstCodecsInfoCache()
+{
+    for (int i = 0; i < 3; ++i)
+        m_scanned[i] = false;
+
+    const QByteArray location = qgetenv("QT_GSTREAMER_CODECS_CACHE");
+    if (location == "0")
+        return;
+
+    m_stamp = registryStamp();
+    if (m_stamp.isEmpty())
+        return;
+
+    if (!location.isEmpty()) {
+        m_fileName = QFile::decodeName(location);
+    } else {
+        const QString cacheDir = QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation);
+        if (cacheDir.isEmpty())
+            return;
+        m_fileName = cacheDir + QLatin1String("/qtmultimedia/gstreamer-codecs.json");
+    }
+
+    QFile file(m_fileName);
+    if (!file.open(QIODevice::ReadOnly))
+        return;
+
+    const QJsonObject root = QJsonDocument::fromJson(file.readAll()).object();
+    if (root.value(QStringLiteral("stamp")).toString() != m_stamp)
+        return;
+
+    for (int i = 0; i < 3; ++i) {
+        const QJsonValue codecs = root.value(QLatin1String(elementTypeKeys[i]));
+        if (!codecs.isArray())
+            continue;
+
+        foreach (const QJsonValue &codec, codecs.toArray())
+            m_codecs[i].append(codec.toString());
+        m_codecSets[i] = m_codecs[i].toSet();
+        m_scanned[i] = true;
+    }
+}
+
+QStringList QGstCodecsInfoCache::codecs(QGstCodecsInfo::ElementType elementType)
+{
+    QMutexLocker locker(&m_mutex);
+
+    if (!m_scanned[elementType]) {
+        m_codecs[elementType] = scanCodecs(elementType);
+        m_codecSets[elementType] = m_codecs[elementType].toSet();
+        m_scanned[elementType] = true;
+        save();
+    }
+
+    return m_codecs[elementType];
+}
+
+// Returns an empty string for codecs not listed for elementType.
+QString QGstCodecsInfoCache::description(QGstCodecsInfo::ElementType elementType, const QString &codec)
 {
+    QMutexLocker locker(&m_mutex);
+
+    if (!m_codecSets[elementType].contains(codec))
+        return QString();
+
+#ifdef QMEDIA_GSTREAMER_CAMERABIN
+    QHash<QString, QString>::const_iterator it = m_descriptions.constFind(codec);
+    if (it != m_descriptions.constEnd())
+        return it.value();
+
+    QString result;
+    if (GstCaps *caps = gst_caps_from_string(codec.toLatin1().constData())) {
+        gchar *description = gst_pb_utils_get_codec_description(caps);
+        result = QString::fromUtf8(description);
+
+        if (description)
+            g_free(description);
+
+        gst_caps_unref(caps);
+    }
+
+    m_descriptions.insert(codec, result);
+    return result;
+#else
+    return codec;
+#endif
+}
+
+/*
+    Identifies the current state of the GStreamer registry by its file, which
+    GStreamer rewrites whenever plugins are added, removed or updated.
+    Returns an empty string if the registry file can't be found.
+*/
+QString QGstCodecsInfoCache::registryStamp()
+{
+#if GST_CHECK_VERSION(1,0,0)
+    QByteArray registry = qgetenv("GST_REGISTRY_1_0");
+    if (registry.isEmpty())
+        registry = qgetenv("GST_REGISTRY");
+    const QString registryDir = QFile::decodeName(g_get_user_cache_dir()) + QLatin1String("/gstreamer-1.0");
+#else
+    const QByteArray registry = qgetenv("GST_REGISTRY");
+    const QString registryDir = QFile::decodeName(g_get_home_dir()) + QLatin1String("/.gstreamer-0.10");
+#endif
+
+    QFileInfoList candidates;
+    if (!registry.isEmpty()) {
+        candidates << QFileInfo(QFile::decodeName(registry));
+    } else {
+        candidates = QDir(registryDir).entryInfoList(QStringList() << QStringLiteral("registry.*.bin"),
+                                                     QDir::Files, QDir::Time);
+    }
+
+    if (candidates.isEmpty() || !candidates.first().exists())
+        return QString();
+
+    guint major, minor, micro, nano;
+    gst_version(&major, &minor, &micro, &nano);
+
+    const QFileInfo info = candidates.first();
+    return QStringLiteral("%1.%2.%3.%4;%5;%6;%7")
+            .arg(major).arg(minor).arg(micro).arg(nano)
+            .arg(info.absoluteFilePath())
+            .arg(info.lastModified().toMSecsSinceEpoch())
+            .arg(info.size());
+}
+
+QStringList QGstCodecsInfoCache::scanCodecs(QGstCodecsInfo::ElementType elementType)
+{
+    QStringList codecs;
 
 #if GST_CHECK_VERSION(0,10,31)
 
     GstElementFactoryListType gstElementType = 0;
     switch (elementType) {
-    case AudioEncoder:
+    case QGstCodecsInfo::AudioEncoder:
         gstElementType = GST_ELEMENT_FACTORY_TYPE_AUDIO_ENCODER;
         break;
-    case VideoEncoder:
+    case QGstCodecsInfo::VideoEncoder:
         gstElementType = GST_ELEMENT_FACTORY_TYPE_VIDEO_ENCODER;
         break;
-    case Muxer:
+    case QGstCodecsInfo::Muxer:
         gstElementType = GST_ELEMENT_FACTORY_TYPE_MUXER;
         break;
     }
 
-    GstCaps *allCaps = supportedElementCaps(gstElementType);
+    GstCaps *allCaps = QGstCodecsInfo::supportedElementCaps(gstElementType);
     GstCaps *caps = gst_caps_new_empty();
 
     uint codecsCount = gst_caps_get_size(allCaps);
@@ -67,18 +206,7 @@ QGstCodecsInfo::QGstCodecsInfo(QGstCodecsInfo::ElementType elementType)
         gst_caps_append_structure(caps, gst_caps_steal_structure(allCaps, 0));
         gchar * capsString = gst_caps_to_string(caps);
 
-        QString codec = QLatin1String(capsString);
-        m_codecs.append(codec);
-
-#ifdef QMEDIA_GSTREAMER_CAMERABIN
-        gchar *description = gst_pb_utils_get_codec_description(caps);
-        m_codecDescriptions.insert(codec, QString::fromUtf8(description));
-
-        if (description)
-            g_free(description);
-#else
-        m_codecDescriptions.insert(codec, codec);
-#endif
+        codecs.append(QLatin1String(capsString));
 
         if (capsString)
             g_free(capsString);
@@ -91,6 +219,36 @@ QGstCodecsInfo::QGstCodecsInfo(QGstCodecsInfo::ElementType elementType)
 #else
     Q_UNUSED(elementType);
 #endif // GST_CHECK_VERSION(0,10,31)
+
+    return codecs;
+}
+
+void QGstCodecsInfoCache::save() const
+{
+    if (m_fileName.isEmpty())
+        return;
+
+    QJsonObject root;
+    root.insert(QStringLiteral("stamp"), m_stamp);
+    for (int i = 0; i < 3; ++i) {
+        if (m_scanned[i])
+            root.insert(QLatin1String(elementTypeKeys[i]), QJsonArray::fromStringList(m_codecs[i]));
+    }
+
+    QDir().mkpath(QFileInfo(m_fileName).absolutePath());
+
+    QSaveFile file(m_fileName);
+    if (file.open(QIODevice::WriteOnly)) {
+        file.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+        file.commit();
+    }
+}
+
+
+QGstCodecsInfo::QGstCodecsInfo(QGstCodecsInfo::ElementType elementType)
+    : m_elementType(elementType)
+    , m_codecs(codecsInfoCache()->codecs(elementType))
+{
 }
 
 QStringList QGstCodecsInfo::supportedCodecs() const
@@ -100,7 +258,7 @@ QStringList QGstCodecsInfo::supportedCodecs() const
 
 QString QGstCodecsInfo::codecDescription(const QString &codec) const
 {
-    return m_codecDescriptions.value(codec);
+    return codecsInfoCache()->description(m_elementType, codec);
 }
 
 #if GST_CHECK_VERSION(0,10,31)
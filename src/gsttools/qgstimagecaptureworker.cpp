@@ -0,0 +1,248 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qgstimagecaptureworker_p.h"
+#include "qgstutils_p.h"
+
+#include <QtCore/qrunnable.h>
+#include <QtCore/qsavefile.h>
+#include <QtCore/qthread.h>
+
+QT_BEGIN_NAMESPACE
+
+class QGstImageCaptureWorker::Job : public QRunnable
+{
+public:
+    enum Type { Convert, Save };
+
+    Job(QGstImageCaptureWorker *worker, Type type, int requestId, GstBuffer *buffer)
+        : worker(worker)
+        , buffer(buffer)
+        , sequence(0)
+        , requestId(requestId)
+        , type(type)
+    {
+        gst_buffer_ref(buffer);
+    }
+
+    ~Job()
+    {
+        gst_buffer_unref(buffer);
+    }
+
+    void run();
+
+    QGstImageCaptureWorker * const worker;
+    GstBuffer * const buffer;
+#if GST_CHECK_VERSION(1,0,0)
+    GstVideoInfo info;
+#endif
+    QSize maximumSize;
+    QString fileName;
+    quint64 sequence;
+    const int requestId;
+    const Type type;
+};
+
+void QGstImageCaptureWorker::Job::run()
+{
+    Result result;
+    result.requestId = requestId;
+
+    if (type == Convert) {
+#if GST_CHECK_VERSION(1,0,0)
+        result.image = QGstUtils::scaledBufferToImage(buffer, info, maximumSize);
+#else
+        result.image = QGstUtils::bufferToImage(buffer);
+#endif
+    } else {
+        result.saved = true;
+        result.fileName = fileName;
+
+        QSaveFile file(fileName);
+        if (file.open(QIODevice::WriteOnly)) {
+#if GST_CHECK_VERSION(1,0,0)
+            GstMapInfo mapInfo;
+            if (gst_buffer_map(buffer, &mapInfo, GST_MAP_READ)) {
+                file.write(reinterpret_cast<const char *>(mapInfo.data), mapInfo.size);
+                gst_buffer_unmap(buffer, &mapInfo);
+            }
+#else
+            file.write(reinterpret_cast<const char *>(GST_BUFFER_DATA(buffer)), GST_BUFFER_SIZE(buffer));
+#endif
+            if (!file.commit())
+                result.errorString = file.errorString();
+        } else {
+            result.errorString = file.errorString();
+        }
+    }
+
+    worker->finish(sequence, result);
+}
+
+QGstImageCaptureWorker::QGstImageCaptureWorker(QObject *parent)
+    : QObject(parent)
+    , m_nextSubmitted(0)
+    , m_nextDelivered(0)
+    , m_maximumPendingJobs(0)
+    , m_deliveryQueued(false)
+{
+    bool ok = false;
+    int threads = qgetenv("QT_GSTREAMER_CAPTURE_THREADS").toInt(&ok);
+    if (!ok || threads < 1)
+        threads = qBound(1, QThread::idealThreadCount(), 4);
+
+    int pending = qgetenv("QT_GSTREAMER_CAPTURE_QUEUE").toInt(&ok);
+    if (!ok || pending < 1)
+        pending = 2 * threads;
+
+    m_pool.setMaxThreadCount(threads);
+    m_maximumPendingJobs = pending;
+    m_jobSlots.release(pending);
+}
+
+QGstImageCaptureWorker::~QGstImageCaptureWorker()
+{
+    // Results still waiting for delivery are dropped with the worker.
+    m_pool.waitForDone();
+}
+
+/*!
+    Queues the conversion of \a buffer to an image, delivered with
+    imageConverted(). Returns false without taking the buffer if the queue
+    is full.
+*/
+#if GST_CHECK_VERSION(1,0,0)
+bool QGstImageCaptureWorker::convertImage(
+        int requestId, GstBuffer *buffer, const GstVideoInfo &info, const QSize &maximumSize)
+{
+    Job *job = new Job(this, Job::Convert, requestId, buffer);
+    job->info = info;
+    job->maximumSize = maximumSize;
+    return submit(job);
+}
+#else
+bool QGstImageCaptureWorker::convertImage(int requestId, GstBuffer *buffer)
+{
+    return submit(new Job(this, Job::Convert, requestId, buffer));
+}
+#endif
+
+/*!
+    Queues writing \a buffer to \a fileName, reported with imageSaved() or
+    saveFailed(). Returns false without taking the buffer if the queue is
+    full.
+*/
+bool QGstImageCaptureWorker::saveImage(int requestId, GstBuffer *buffer, const QString &fileName)
+{
+    Job *job = new Job(this, Job::Save, requestId, buffer);
+    job->fileName = fileName;
+    return submit(job);
+}
+
+/*!
+    Blocks until all submitted jobs have completed, and delivers their
+    results if called from the thread the worker lives in.
+*/
+void QGstImageCaptureWorker::waitForDone()
+{
+    m_pool.waitForDone();
+
+    if (QThread::currentThread() == thread())
+        deliverResults();
+}
+
+bool QGstImageCaptureWorker::submit(Job *job)
+{
+    // Slots are only released on delivery, in the worker's thread. The caller
+    // is usually a streaming thread, which must not wait for that: the
+    // worker's thread may be waiting for the streaming thread to stop.
+    if (!m_jobSlots.tryAcquire()) {
+        delete job;
+        return false;
+    }
+
+    {
+        QMutexLocker locker(&m_resultMutex);
+        job->sequence = m_nextSubmitted++;
+    }
+
+    m_pool.start(job);
+    return true;
+}
+
+void QGstImageCaptureWorker::finish(quint64 sequence, const Result &result)
+{
+    bool queueDelivery = false;
+    {
+        QMutexLocker locker(&m_resultMutex);
+        m_results.insert(sequence, result);
+        if (sequence == m_nextDelivered && !m_deliveryQueued)
+            queueDelivery = m_deliveryQueued = true;
+    }
+
+    if (queueDelivery)
+        QMetaObject::invokeMethod(this, "deliverResults", Qt::QueuedConnection);
+}
+
+void QGstImageCaptureWorker::deliverResults()
+{
+    forever {
+        Result result;
+        {
+            QMutexLocker locker(&m_resultMutex);
+            QMap<quint64, Result>::iterator it = m_results.find(m_nextDelivered);
+            if (it == m_results.end()) {
+                m_deliveryQueued = false;
+                return;
+            }
+            result = it.value();
+            m_results.erase(it);
+            ++m_nextDelivered;
+        }
+
+        if (!result.saved) {
+            if (!result.image.isNull())
+                emit imageConverted(result.requestId, result.image);
+        } else if (result.errorString.isEmpty()) {
+            emit imageSaved(result.requestId, result.fileName);
+        } else {
+            emit saveFailed(result.requestId, result.errorString);
+        }
+
+        // Only now is the result no longer held by the worker.
+        m_jobSlots.release();
+    }
+}
+
+QT_END_NAMESPACE
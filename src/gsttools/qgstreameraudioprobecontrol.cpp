@@ -33,6 +33,10 @@
 
 #include "qgstreameraudioprobecontrol_p.h"
 #include <private/qgstutils_p.h>
+#include <private/qgstaudiobuffer_p.h>
+#include <private/qaudioproberingbuffer_p.h>
+
+#include <QtCore/qmetaobject.h>
 
 QGstreamerAudioProbeControl::QGstreamerAudioProbeControl(QObject *parent)
     : QMediaAudioProbeControl(parent)
@@ -43,6 +47,24 @@ QGstreamerAudioProbeControl::~QGstreamerAudioProbeControl()
 {
 }
 
+/*!
+    \internal
+
+    Writes the probed samples into \a ringBuffer on the streaming thread.
+*/
+void QGstreamerAudioProbeControl::addRingBuffer(QAudioProbeRingBuffer *ringBuffer)
+{
+    QMutexLocker locker(&m_bufferMutex);
+    if (!m_ringBuffers.contains(ringBuffer))
+        m_ringBuffers.append(ringBuffer);
+}
+
+void QGstreamerAudioProbeControl::removeRingBuffer(QAudioProbeRingBuffer *ringBuffer)
+{
+    QMutexLocker locker(&m_bufferMutex);
+    m_ringBuffers.removeAll(ringBuffer);
+}
+
 void QGstreamerAudioProbeControl::probeCaps(GstCaps *caps)
 {
     QAudioFormat format = QGstUtils::audioFormatForCaps(caps);
@@ -58,24 +80,42 @@ bool QGstreamerAudioProbeControl::probeBuffer(GstBuffer *buffer)
             ? position / G_GINT64_CONSTANT(1000) // microseconds
             : -1;
 
-    QByteArray data;
-#if GST_CHECK_VERSION(1,0,0)
-    GstMapInfo info;
-    if (gst_buffer_map(buffer, &info, GST_MAP_READ)) {
-        data = QByteArray(reinterpret_cast<const char *>(info.data), info.size);
-        gst_buffer_unmap(buffer, &info);
-    } else {
+    QMutexLocker locker(&m_bufferMutex);
+    if (!m_format.isValid())
         return true;
-    }
+
+    if (!m_ringBuffers.isEmpty()) {
+#if GST_CHECK_VERSION(1,0,0)
+        GstMapInfo info;
+        if (gst_buffer_map(buffer, &info, GST_MAP_READ)) {
+            foreach (QAudioProbeRingBuffer *ringBuffer, m_ringBuffers) {
+                ringBuffer->write(m_format, reinterpret_cast<const char *>(info.data), info.size,
+                                  position);
+            }
+            gst_buffer_unmap(buffer, &info);
+        }
 #else
-    data = QByteArray(reinterpret_cast<const char *>(buffer->data), buffer->size);
+        foreach (QAudioProbeRingBuffer *ringBuffer, m_ringBuffers) {
+            ringBuffer->write(m_format, reinterpret_cast<const char *>(buffer->data), buffer->size,
+                              position);
+        }
 #endif
+    }
 
-    QMutexLocker locker(&m_bufferMutex);
-    if (m_format.isValid()) {
+    // Ring buffer consumers don't need a queued event per buffer.
+    static const QMetaMethod probedSignal
+            = QMetaMethod::fromSignal(&QMediaAudioProbeControl::audioBufferProbed);
+    if (isSignalConnected(probedSignal)) {
+        // The probed buffer is referenced rather than copied, so that listeners
+        // which only read the samples never pay for an allocation.
+        QGstAudioBuffer *provider = new QGstAudioBuffer(buffer, m_format, position);
+        if (!provider->isMapped()) {
+            provider->release();
+            return true;
+        }
         if (!m_pendingBuffer.isValid())
             QMetaObject::invokeMethod(this, "bufferProbed", Qt::QueuedConnection);
-        m_pendingBuffer = QAudioBuffer(data, m_format, position);
+        m_pendingBuffer = QAudioBuffer(provider);
     }
 
     return true;
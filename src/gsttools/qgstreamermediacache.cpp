@@ -0,0 +1,843 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qgstreamermediacache_p.h"
+
+#include <QtCore/qcryptographichash.h>
+#include <QtCore/qdatetime.h>
+#include <QtCore/qdir.h>
+#include <QtCore/qfile.h>
+#include <QtCore/qfileinfo.h>
+#include <QtCore/qglobalstatic.h>
+#include <QtCore/qjsonarray.h>
+#include <QtCore/qjsondocument.h>
+#include <QtCore/qjsonobject.h>
+#include <QtCore/qsavefile.h>
+#include <QtCore/qstandardpaths.h>
+#include <QtNetwork/qnetworkaccessmanager.h>
+#include <QtNetwork/qnetworkreply.h>
+
+QT_BEGIN_NAMESPACE
+
+static const qint64 defaultMaximumSize = 256; // MiB
+
+// A seek this close ahead of the running download waits for it rather
+// than starting a new request.
+static const qint64 seekWindow = 256 * 1024;
+
+// Progress of a download is reported each time it crosses a multiple of this.
+static const qint64 rangesNotifyInterval = 256 * 1024;
+
+static qint64 rangesSize(const QMediaTimeRange &ranges)
+{
+    qint64 size = 0;
+    foreach (const QMediaTimeInterval &interval, ranges.intervals())
+        size += interval.end() - interval.start() + 1;
+    return size;
+}
+
+class QGstreamerMediaCacheHolder
+{
+public:
+    QGstreamerMediaCacheHolder()
+        : cache(0)
+    {
+        QByteArray location = qgetenv("QT_GSTREAMER_MEDIA_CACHE");
+        if (location.isEmpty() || location == "0")
+            return;
+
+        QString directory;
+        if (location == "1") {
+            directory = QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation);
+            if (directory.isEmpty())
+                return;
+            directory += QLatin1String("/qtmultimedia/media");
+        } else {
+            directory = QFile::decodeName(location);
+        }
+
+        bool ok = false;
+        qint64 maximumSize = qgetenv("QT_GSTREAMER_MEDIA_CACHE_SIZE").toLongLong(&ok);
+        if (!ok || maximumSize <= 0)
+            maximumSize = defaultMaximumSize;
+
+        cache = new QGstreamerMediaCache(directory, maximumSize * 1024 * 1024);
+    }
+
+    ~QGstreamerMediaCacheHolder()
+    {
+        delete cache;
+    }
+
+    QGstreamerMediaCache *cache;
+};
+
+Q_GLOBAL_STATIC(QGstreamerMediaCacheHolder, mediaCacheHolder)
+
+/*
+    A persistent cache of progressively downloaded media.
+
+    Each URL is stored as a sparse data file plus an index recording the
+    ETag the data was downloaded with, the total size and the byte ranges
+    present in the data file. Entries are evicted least recently used first
+    once the cache grows beyond its maximum size; entries in use are never
+    evicted. Data that doesn't fit even so is refused rather than growing
+    the cache past its maximum size.
+
+    The player uses the cache only if QT_GSTREAMER_MEDIA_CACHE is set, either
+    to a directory or to 1 for the default location in the user's cache
+    directory. QT_GSTREAMER_MEDIA_CACHE_SIZE sets the maximum size in MiB.
+*/
+QGstreamerMediaCache::QGstreamerMediaCache(const QString &directory, qint64 maximumSize)
+    : m_directory(directory)
+    , m_maximumSize(maximumSize)
+    , m_size(0)
+{
+    QDir().mkpath(m_directory);
+    loadIndex();
+}
+
+QGstreamerMediaCache::~QGstreamerMediaCache()
+{
+    qDeleteAll(m_files);
+}
+
+QGstreamerMediaCache *QGstreamerMediaCache::instance()
+{
+    return mediaCacheHolder()->cache;
+}
+
+qint64 QGstreamerMediaCache::size() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_size;
+}
+
+/*
+    Returns the entry for \a url and prevents it from being evicted until
+    release() is called. Returns an empty entry if nothing is cached yet.
+*/
+QGstreamerMediaCache::Entry QGstreamerMediaCache::acquire(const QUrl &url)
+{
+    QMutexLocker locker(&m_mutex);
+
+    const QString key = keyForUrl(url);
+    ++m_users[key];
+
+    QHash<QString, Entry>::iterator it = m_entries.find(key);
+    if (it == m_entries.end()) {
+        Entry entry;
+        entry.url = url;
+        return entry;
+    }
+
+    it->lastAccess = QDateTime::currentMSecsSinceEpoch();
+    return it.value();
+}
+
+/*
+    Saves the index of \a url and lets the entry be evicted again.
+*/
+void QGstreamerMediaCache::release(const QUrl &url)
+{
+    QMutexLocker locker(&m_mutex);
+
+    const QString key = keyForUrl(url);
+    if (--m_users[key] > 0)
+        return;
+    m_users.remove(key);
+
+    QHash<QString, Entry>::const_iterator it = m_entries.constFind(key);
+    if (it == m_entries.constEnd())
+        return;
+
+    delete m_files.take(key);
+    saveEntry(key);
+    makeRoom(QString(), 0);
+}
+
+/*
+    Drops whatever is cached for \a url and starts a new entry for the
+    content identified by \a etag.
+*/
+void QGstreamerMediaCache::reset(const QUrl &url, const QByteArray &etag, qint64 totalSize)
+{
+    QMutexLocker locker(&m_mutex);
+
+    const QString key = keyForUrl(url);
+    removeEntry(key);
+
+    Entry entry;
+    entry.url = url;
+    entry.etag = etag;
+    entry.totalSize = totalSize;
+    entry.lastAccess = QDateTime::currentMSecsSinceEpoch();
+    m_entries.insert(key, entry);
+
+    saveEntry(key);
+}
+
+void QGstreamerMediaCache::setTotalSize(const QUrl &url, qint64 totalSize)
+{
+    QMutexLocker locker(&m_mutex);
+
+    const QString key = keyForUrl(url);
+    QHash<QString, Entry>::iterator it = m_entries.find(key);
+    if (it != m_entries.end() && it->totalSize != totalSize) {
+        it->totalSize = totalSize;
+        saveEntry(key);
+    }
+}
+
+/*
+    Stores \a length bytes of \a data at \a offset of the entry for \a url,
+    evicting other entries as needed. Returns false if the data can't be
+    written, or if it doesn't fit because the remaining entries are in use.
+    The index is only saved by sync() and release(), so it never refers to
+    data that hasn't been written.
+*/
+bool QGstreamerMediaCache::write(const QUrl &url, qint64 offset, const char *data, qint64 length)
+{
+    QMutexLocker locker(&m_mutex);
+
+    const QString key = keyForUrl(url);
+    QHash<QString, Entry>::iterator it = m_entries.find(key);
+    if (it == m_entries.end() || length <= 0)
+        return false;
+
+    QMediaTimeRange added(offset, offset + length - 1);
+    added -= it->ranges;
+    const qint64 addedSize = rangesSize(added);
+
+    makeRoom(key, addedSize);
+    if (m_size + addedSize > m_maximumSize)
+        return false;
+
+    QFile *file = dataFile(key);
+    if (!file || !file->seek(offset) || file->write(data, length) != length)
+        return false;
+
+    it = m_entries.find(key);
+    it->ranges.addInterval(offset, offset + length - 1);
+    m_size += addedSize;
+
+    return true;
+}
+
+/*
+    Reads up to \a maxLength cached bytes of \a url starting at \a offset.
+    Returns 0 if the byte at \a offset isn't cached.
+*/
+qint64 QGstreamerMediaCache::read(const QUrl &url, qint64 offset, char *data, qint64 maxLength) const
+{
+    QMutexLocker locker(&m_mutex);
+
+    const QString key = keyForUrl(url);
+    QHash<QString, Entry>::const_iterator it = m_entries.constFind(key);
+    if (it == m_entries.constEnd())
+        return 0;
+
+    foreach (const QMediaTimeInterval &interval, it->ranges.intervals()) {
+        if (!interval.contains(offset))
+            continue;
+
+        QFile *file = dataFile(key);
+        if (!file || !file->seek(offset))
+            return 0;
+
+        return qMax<qint64>(file->read(data, qMin(maxLength, interval.end() - offset + 1)), 0);
+    }
+
+    return 0;
+}
+
+void QGstreamerMediaCache::sync(const QUrl &url)
+{
+    QMutexLocker locker(&m_mutex);
+
+    const QString key = keyForUrl(url);
+    if (QFile *file = m_files.value(key))
+        file->flush();
+
+    if (m_entries.contains(key))
+        saveEntry(key);
+}
+
+void QGstreamerMediaCache::remove(const QUrl &url)
+{
+    QMutexLocker locker(&m_mutex);
+    removeEntry(keyForUrl(url));
+}
+
+QString QGstreamerMediaCache::keyForUrl(const QUrl &url)
+{
+    return QString::fromLatin1(QCryptographicHash::hash(url.toEncoded(), QCryptographicHash::Sha1).toHex());
+}
+
+QString QGstreamerMediaCache::dataFileName(const QString &key) const
+{
+    return m_directory + QLatin1Char('/') + key + QLatin1String(".data");
+}
+
+QString QGstreamerMediaCache::indexFileName(const QString &key) const
+{
+    return m_directory + QLatin1Char('/') + key + QLatin1String(".json");
+}
+
+QFile *QGstreamerMediaCache::dataFile(const QString &key) const
+{
+    QFile *file = m_files.value(key);
+    if (!file) {
+        file = new QFile(dataFileName(key));
+        if (!file->open(QIODevice::ReadWrite)) {
+            qWarning("QGstreamerMediaCache: can't open %s", qPrintable(file->fileName()));
+            delete file;
+            return 0;
+        }
+        m_files.insert(key, file);
+    }
+
+    return file;
+}
+
+void QGstreamerMediaCache::loadIndex()
+{
+    const QDir directory(m_directory);
+
+    foreach (const QFileInfo &info, directory.entryInfoList(QStringList() << QStringLiteral("*.json"), QDir::Files)) {
+        const QString key = info.completeBaseName();
+
+        QFile file(info.absoluteFilePath());
+        if (!file.open(QIODevice::ReadOnly))
+            continue;
+
+        const QJsonObject index = QJsonDocument::fromJson(file.readAll()).object();
+        file.close();
+
+        Entry entry;
+        entry.url = QUrl::fromEncoded(index.value(QStringLiteral("url")).toString().toUtf8());
+        entry.etag = index.value(QStringLiteral("etag")).toString().toUtf8();
+        entry.totalSize = index.value(QStringLiteral("size")).toDouble(-1);
+        entry.lastAccess = index.value(QStringLiteral("accessed")).toDouble();
+
+        foreach (const QJsonValue &value, index.value(QStringLiteral("ranges")).toArray()) {
+            const QJsonArray range = value.toArray();
+            entry.ranges.addInterval(range.at(0).toDouble(), range.at(1).toDouble());
+        }
+
+        if (keyForUrl(entry.url) != key || !QFile::exists(dataFileName(key))) {
+            QFile::remove(info.absoluteFilePath());
+            QFile::remove(dataFileName(key));
+            continue;
+        }
+
+        m_entries.insert(key, entry);
+        m_size += rangesSize(entry.ranges);
+    }
+
+    makeRoom(QString(), 0);
+}
+
+void QGstreamerMediaCache::saveEntry(const QString &key) const
+{
+    const Entry entry = m_entries.value(key);
+
+    QJsonArray ranges;
+    foreach (const QMediaTimeInterval &interval, entry.ranges.intervals()) {
+        QJsonArray range;
+        range.append(double(interval.start()));
+        range.append(double(interval.end()));
+        ranges.append(range);
+    }
+
+    QJsonObject index;
+    index.insert(QStringLiteral("url"), QString::fromUtf8(entry.url.toEncoded()));
+    index.insert(QStringLiteral("etag"), QString::fromUtf8(entry.etag));
+    index.insert(QStringLiteral("size"), double(entry.totalSize));
+    index.insert(QStringLiteral("accessed"), double(entry.lastAccess));
+    index.insert(QStringLiteral("ranges"), ranges);
+
+    QSaveFile file(indexFileName(key));
+    if (file.open(QIODevice::WriteOnly)) {
+        file.write(QJsonDocument(index).toJson(QJsonDocument::Compact));
+        file.commit();
+    }
+}
+
+void QGstreamerMediaCache::removeEntry(const QString &key)
+{
+    QHash<QString, Entry>::iterator it = m_entries.find(key);
+    if (it == m_entries.end())
+        return;
+
+    m_size -= rangesSize(it->ranges);
+    m_entries.erase(it);
+
+    delete m_files.take(key);
+    QFile::remove(indexFileName(key));
+    QFile::remove(dataFileName(key));
+}
+
+// Evicts least recently used entries not in use until \a length more bytes
+// fit; \a key is the entry about to grow.
+void QGstreamerMediaCache::makeRoom(const QString &key, qint64 length)
+{
+    while (m_size + length > m_maximumSize) {
+        QString oldest;
+        qint64 oldestAccess = 0;
+
+        for (QHash<QString, Entry>::const_iterator it = m_entries.constBegin(); it != m_entries.constEnd(); ++it) {
+            if (it.key() == key || m_users.contains(it.key()))
+                continue;
+
+            if (oldest.isEmpty() || it->lastAccess < oldestAccess) {
+                oldest = it.key();
+                oldestAccess = it->lastAccess;
+            }
+        }
+
+        if (oldest.isEmpty())
+            return;
+
+        removeEntry(oldest);
+    }
+}
+
+
+/*
+    A random access device reading a remote media file through
+    QGstreamerMediaCache.
+
+    Cached data is revalidated with the ETag it was downloaded with; missing
+    ranges are then downloaded with HTTP range requests, starting at the read
+    position and continuing until the whole file is cached. Seeking outside
+    the cached ranges restarts the download at the new position.
+
+    A response without a length, as a live stream, isn't cached, and neither
+    is the rest of a file once the cache refuses its data. The device then
+    plays from the network, keeping only the data not read yet.
+*/
+QGstreamerCachedMediaDevice::QGstreamerCachedMediaDevice(QNetworkAccessManager *manager,
+                                                         const QNetworkRequest &request,
+                                                         QGstreamerMediaCache *cache,
+                                                         QObject *parent)
+    : QIODevice(parent)
+    , m_manager(manager)
+    , m_request(request)
+    , m_cache(cache)
+    , m_url(request.url())
+    , m_reply(0)
+    , m_replyOffset(0)
+    , m_bytesDownloaded(0)
+    , m_validated(false)
+    , m_failed(false)
+    , m_uncached(false)
+{
+    m_request.setAttribute(QNetworkRequest::CacheSaveControlAttribute, false);
+
+    open(QIODevice::ReadOnly | QIODevice::Unbuffered);
+
+    m_entry = m_cache->acquire(m_url);
+
+    // Without an ETag cached data can't be revalidated
+    if (m_entry.etag.isEmpty() && !m_entry.ranges.isEmpty()) {
+        m_cache->remove(m_url);
+        m_entry.ranges = QMediaTimeRange();
+        m_entry.totalSize = -1;
+    }
+
+    if (m_entry.ranges.isEmpty())
+        fetch(0);
+    else if (nextGap(0) < 0)
+        validate();
+    else
+        fetch(nextGap(0));
+}
+
+QGstreamerCachedMediaDevice::~QGstreamerCachedMediaDevice()
+{
+    abortReply();
+    m_cache->release(m_url);
+}
+
+bool QGstreamerCachedMediaDevice::isSequential() const
+{
+    return false;
+}
+
+qint64 QGstreamerCachedMediaDevice::size() const
+{
+    return qMax<qint64>(m_entry.totalSize, 0);
+}
+
+bool QGstreamerCachedMediaDevice::seek(qint64 pos)
+{
+    if (!QIODevice::seek(pos))
+        return false;
+
+    if (!m_validated || m_failed || m_entry.ranges.contains(pos))
+        return true;
+
+    // Keep the running download if it is about to reach the new position
+    if (m_reply && m_replyOffset <= pos && pos <= m_replyOffset + seekWindow)
+        return true;
+
+    if (m_uncached && m_replyOffset - m_pending.size() <= pos && pos <= m_replyOffset)
+        return true;
+
+    fetch(pos);
+    return true;
+}
+
+bool QGstreamerCachedMediaDevice::atEnd() const
+{
+    if (m_uncached && (m_failed || !m_reply))
+        return bytesAvailable() == 0;
+
+    if (m_failed)
+        return !m_entry.ranges.contains(pos());
+
+    return m_entry.totalSize >= 0 && pos() >= m_entry.totalSize;
+}
+
+qint64 QGstreamerCachedMediaDevice::bytesAvailable() const
+{
+    if (!m_validated)
+        return 0;
+
+    const qint64 position = pos();
+    if (m_uncached) {
+        if (position < m_replyOffset - m_pending.size() || position >= m_replyOffset)
+            return 0;
+        return m_replyOffset - position;
+    }
+
+    foreach (const QMediaTimeInterval &interval, m_entry.ranges.intervals()) {
+        if (interval.contains(position))
+            return interval.end() - position + 1;
+    }
+
+    return 0;
+}
+
+QMediaTimeRange QGstreamerCachedMediaDevice::cachedRanges() const
+{
+    return m_entry.ranges;
+}
+
+qint64 QGstreamerCachedMediaDevice::readData(char *data, qint64 maxSize)
+{
+    if (!m_validated)
+        return 0;
+
+    if (m_uncached) {
+        const qint64 available = bytesAvailable();
+        if (available <= 0)
+            return 0;
+
+        // Data once read is dropped, seeking back downloads it again
+        const int skip = int(pos() - (m_replyOffset - m_pending.size()));
+        const int length = int(qMin(maxSize, available));
+        memcpy(data, m_pending.constData() + skip, length);
+        m_pending.remove(0, skip + length);
+        return length;
+    }
+
+    return m_cache->read(m_url, pos(), data, maxSize);
+}
+
+qint64 QGstreamerCachedMediaDevice::writeData(const char *data, qint64 maxSize)
+{
+    Q_UNUSED(data);
+    Q_UNUSED(maxSize);
+
+    return -1;
+}
+
+void QGstreamerCachedMediaDevice::replyMetaDataChanged()
+{
+    const int status = m_reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    const QByteArray etag = m_reply->rawHeader("ETag");
+
+    if (status == 304) {
+        m_validated = true;
+        emit readyRead();
+        return;
+    }
+
+    if (status == 206) {
+        // Content-Range: bytes <first>-<last>/<total or *>
+        const QByteArray contentRange = m_reply->rawHeader("Content-Range");
+        const int space = contentRange.indexOf(' ');
+        const int dash = contentRange.indexOf('-', space);
+        const int slash = contentRange.indexOf('/', dash);
+        if (space < 0 || dash < 0 || slash < 0)
+            return;
+
+        bool ok = false;
+        const qint64 total = contentRange.mid(slash + 1).toLongLong(&ok);
+
+        if (etag != m_entry.etag) {
+            if (!m_uncached)
+                m_cache->reset(m_url, etag, ok ? total : -1);
+            m_entry.etag = etag;
+            m_entry.ranges = QMediaTimeRange();
+            emit cachedRangesChanged();
+        }
+
+        if (ok && total != m_entry.totalSize) {
+            m_entry.totalSize = total;
+            m_cache->setTotalSize(m_url, total);
+        }
+
+        m_replyOffset = contentRange.mid(space + 1, dash - space - 1).toLongLong();
+        m_validated = true;
+    } else if (status == 200) {
+        // The whole file, because nothing was cached, the content changed or
+        // the server doesn't support ranges
+        bool ok = false;
+        const qint64 total = m_reply->header(QNetworkRequest::ContentLengthHeader).toLongLong(&ok);
+
+        // It may never end, so don't let it fill the cache
+        if (!ok)
+            stopCaching();
+
+        if (etag.isEmpty() || etag != m_entry.etag) {
+            if (!m_uncached)
+                m_cache->reset(m_url, etag, ok ? total : -1);
+            m_entry.etag = etag;
+            m_entry.ranges = QMediaTimeRange();
+            m_entry.totalSize = ok ? total : -1;
+            emit cachedRangesChanged();
+        }
+
+        m_replyOffset = 0;
+        m_validated = true;
+    }
+
+    if (m_validated && bytesAvailable() > 0)
+        emit readyRead();
+}
+
+void QGstreamerCachedMediaDevice::replyReadyRead()
+{
+    if (!m_validated)
+        return;
+
+    const QByteArray data = m_reply->readAll();
+    if (data.isEmpty())
+        return;
+
+    if (!m_uncached && !m_cache->write(m_url, m_replyOffset, data.constData(), data.size())) {
+        stopCaching();
+
+        // What was cached before the download position is gone as well
+        if (pos() < m_replyOffset) {
+            fetch(pos());
+            return;
+        }
+    }
+
+    if (m_uncached) {
+        m_pending += data;
+        m_replyOffset += data.size();
+        m_bytesDownloaded += data.size();
+
+        if (bytesAvailable() > 0)
+            emit readyRead();
+        return;
+    }
+
+    const bool newInterval = !m_entry.ranges.contains(m_replyOffset - 1);
+
+    m_entry.ranges.addInterval(m_replyOffset, m_replyOffset + data.size() - 1);
+    m_replyOffset += data.size();
+    m_bytesDownloaded += data.size();
+
+    if (newInterval || (m_replyOffset - data.size()) / rangesNotifyInterval != m_replyOffset / rangesNotifyInterval)
+        emit cachedRangesChanged();
+
+    if (m_entry.ranges.contains(pos()))
+        emit readyRead();
+}
+
+void QGstreamerCachedMediaDevice::replyFinished()
+{
+    QNetworkReply *reply = m_reply;
+    if (!reply)
+        return;
+
+    replyReadyRead();
+
+    // Reading it restarted the download
+    if (m_reply != reply)
+        return;
+
+    m_reply = 0;
+    reply->disconnect(this);
+    reply->deleteLater();
+
+    const int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    if (reply->error() != QNetworkReply::NoError || (status != 200 && status != 206 && status != 304)) {
+        // Play what is cached when the server can't be reached
+        if (!m_validated && !m_entry.ranges.isEmpty() && status == 0)
+            m_validated = true;
+
+        m_failed = true;
+        setErrorString(reply->errorString());
+        emit readyRead();
+        return;
+    }
+
+    if (status == 200 && m_entry.totalSize < 0) {
+        m_entry.totalSize = m_replyOffset;
+        m_cache->setTotalSize(m_url, m_entry.totalSize);
+    }
+
+    m_cache->sync(m_url);
+    emit cachedRangesChanged();
+
+    fetchNextGap();
+
+    // Let the reader notice the end of the media
+    if (bytesAvailable() > 0 || atEnd())
+        emit readyRead();
+}
+
+// Returns the first byte at or after \a from which isn't cached, or -1 if
+// the rest of the file is.
+qint64 QGstreamerCachedMediaDevice::nextGap(qint64 from) const
+{
+    qint64 gap = from;
+    foreach (const QMediaTimeInterval &interval, m_entry.ranges.intervals()) {
+        if (interval.contains(gap))
+            gap = interval.end() + 1;
+    }
+
+    if (m_entry.totalSize >= 0 && gap >= m_entry.totalSize)
+        return -1;
+
+    return gap;
+}
+
+// Asks the server whether the fully cached file is still current.
+void QGstreamerCachedMediaDevice::validate()
+{
+    QNetworkRequest request(m_request);
+    request.setRawHeader("If-None-Match", m_entry.etag);
+
+    startReply(request, 0);
+}
+
+void QGstreamerCachedMediaDevice::fetch(qint64 offset)
+{
+    QNetworkRequest request(m_request);
+
+    // Stop at the next cached range
+    qint64 last = -1;
+    foreach (const QMediaTimeInterval &interval, m_entry.ranges.intervals()) {
+        if (interval.start() > offset) {
+            last = interval.start() - 1;
+            break;
+        }
+    }
+
+    if (offset > 0 || last >= 0) {
+        QByteArray range = "bytes=" + QByteArray::number(offset) + '-';
+        if (last >= 0)
+            range += QByteArray::number(last);
+        request.setRawHeader("Range", range);
+
+        if (!m_entry.etag.isEmpty())
+            request.setRawHeader("If-Range", m_entry.etag);
+    }
+
+    startReply(request, offset);
+}
+
+void QGstreamerCachedMediaDevice::startReply(const QNetworkRequest &request, qint64 offset)
+{
+    abortReply();
+
+    m_replyOffset = offset;
+    m_pending.clear();
+    m_reply = m_manager->get(request);
+
+    connect(m_reply, SIGNAL(metaDataChanged()), this, SLOT(replyMetaDataChanged()));
+    connect(m_reply, SIGNAL(readyRead()), this, SLOT(replyReadyRead()));
+    connect(m_reply, SIGNAL(finished()), this, SLOT(replyFinished()));
+}
+
+// Continues the download with the first missing range after the read
+// position, then with those before it.
+void QGstreamerCachedMediaDevice::fetchNextGap()
+{
+    if (m_failed || m_uncached || m_entry.totalSize < 0)
+        return;
+
+    qint64 gap = nextGap(pos());
+    if (gap < 0)
+        gap = nextGap(0);
+
+    if (gap >= 0)
+        fetch(gap);
+}
+
+// Drops what is cached and plays the rest from the network.
+void QGstreamerCachedMediaDevice::stopCaching()
+{
+    if (m_uncached)
+        return;
+
+    m_uncached = true;
+    m_cache->remove(m_url);
+    m_entry.ranges = QMediaTimeRange();
+    emit cachedRangesChanged();
+}
+
+void QGstreamerCachedMediaDevice::abortReply()
+{
+    if (!m_reply)
+        return;
+
+    QNetworkReply *reply = m_reply;
+    m_reply = 0;
+
+    reply->disconnect(this);
+    reply->abort();
+    reply->deleteLater();
+
+    m_cache->sync(m_url);
+}
+
+QT_END_NAMESPACE
@@ -35,11 +35,13 @@
 
 #include "qgstutils_p.h"
 #include <private/qgstvideobuffer_p.h>
+#include <private/qvideobufferpool_p.h>
 
 QGstreamerVideoProbeControl::QGstreamerVideoProbeControl(QObject *parent)
     : QMediaVideoProbeControl(parent)
     , m_flushing(false)
     , m_frameProbed(false)
+    , m_copyFrames(qgetenv("QT_GSTREAMER_VIDEO_PROBE_COPY").toInt() > 0)
 {
 }
 
@@ -102,6 +104,14 @@ bool QGstreamerVideoProbeControl::probeBuffer(GstBuffer *buffer)
 
     QGstUtils::setFrameTimeStamps(&frame, buffer);
 
+    if (m_copyFrames) {
+        // Give the buffer back to the pipeline right away, slow probe consumers
+        // would otherwise starve the upstream buffer pool.
+        const QVideoFrame copy = QVideoBufferPool::instance()->copyFrame(frame);
+        if (copy.isValid())
+            frame = copy;
+    }
+
     m_frameProbed = true;
 
     if (!m_pendingFrame.isValid())
@@ -43,6 +43,7 @@
 #include <QtGui/qimage.h>
 #include <qaudioformat.h>
 #include <QtCore/qelapsedtimer.h>
+#include <QtCore/qvarlengtharray.h>
 #include <QtMultimedia/qvideosurfaceformat.h>
 #include <private/qmultimediautils_p.h>
 
@@ -914,6 +915,153 @@ QImage QGstUtils::bufferToImage(GstBuffer *buffer)
     return img;
 }
 
+#if GST_CHECK_VERSION(1,0,0)
+/*!
+    Converts a video \a buffer to an image no larger than \a maximumSize,
+    decimating by an integer factor while converting.
+
+    8-bit YUV formats are converted sample by sample at the output resolution,
+    so a reduced preview never pays for converting the full frame to RGB.
+    Other formats fall back to bufferToImage(). An empty \a maximumSize keeps
+    the full resolution.
+*/
+QImage QGstUtils::scaledBufferToImage(
+        GstBuffer *buffer, const GstVideoInfo &videoInfo, const QSize &maximumSize)
+{
+    const GstVideoFormatInfo * const finfo = videoInfo.finfo;
+    const int width = videoInfo.width;
+    const int height = videoInfo.height;
+
+    int factor = 1;
+    if (maximumSize.width() > 0 && maximumSize.height() > 0) {
+        while (width / factor > maximumSize.width() || height / factor > maximumSize.height())
+            ++factor;
+    }
+
+    const bool sampled = finfo
+            && GST_VIDEO_FORMAT_INFO_IS_YUV(finfo)
+            && GST_VIDEO_FORMAT_INFO_N_COMPONENTS(finfo) >= 3
+            && GST_VIDEO_FORMAT_INFO_DEPTH(finfo, 0) == 8
+            && GST_VIDEO_FORMAT_INFO_DEPTH(finfo, 1) == 8
+            && GST_VIDEO_FORMAT_INFO_DEPTH(finfo, 2) == 8
+#if GST_CHECK_VERSION(1,4,0)
+            && !(GST_VIDEO_FORMAT_INFO_FLAGS(finfo) & GST_VIDEO_FORMAT_FLAG_TILED)
+#endif
+            ;
+
+    if (!sampled) {
+        QImage image = bufferToImage(buffer, videoInfo);
+        if (factor > 1 && !image.isNull())
+            image = image.scaled(width / factor, height / factor, Qt::IgnoreAspectRatio, Qt::FastTransformation);
+        return image;
+    }
+
+    const int outputWidth = width / factor;
+    const int outputHeight = height / factor;
+    if (outputWidth <= 0 || outputHeight <= 0)
+        return QImage();
+
+    GstVideoInfo info = videoInfo;
+    GstVideoFrame frame;
+    if (!gst_video_frame_map(&frame, &info, buffer, GST_MAP_READ))
+        return QImage();
+
+    QImage image(outputWidth, outputHeight, QImage::Format_RGB32);
+
+    const uchar *data[3];
+    int stride[3];
+    int hSub[3];
+    QVarLengthArray<int, 1024> columns[3];
+    for (int c = 0; c < 3; ++c) {
+        data[c] = static_cast<const uchar *>(GST_VIDEO_FRAME_COMP_DATA(&frame, c));
+        stride[c] = GST_VIDEO_FRAME_COMP_STRIDE(&frame, c);
+        hSub[c] = GST_VIDEO_FORMAT_INFO_H_SUB(finfo, c);
+
+        const int wSub = GST_VIDEO_FORMAT_INFO_W_SUB(finfo, c);
+        const int pixelStride = GST_VIDEO_FRAME_COMP_PSTRIDE(&frame, c);
+        columns[c].resize(outputWidth);
+        for (int x = 0; x < outputWidth; ++x)
+            columns[c][x] = ((x * factor) >> wSub) * pixelStride;
+    }
+
+    for (int y = 0; y < outputHeight; ++y) {
+        const int sourceY = y * factor;
+        const uchar * const yLine = data[0] + (sourceY >> hSub[0]) * stride[0];
+        const uchar * const uLine = data[1] + (sourceY >> hSub[1]) * stride[1];
+        const uchar * const vLine = data[2] + (sourceY >> hSub[2]) * stride[2];
+        QRgb *out = reinterpret_cast<QRgb *>(image.scanLine(y));
+
+        for (int x = 0; x < outputWidth; ++x) {
+            // ITU-R BT.601, fixed point
+            const int Y = 298 * (yLine[columns[0][x]] - 16) + 128;
+            const int U = uLine[columns[1][x]] - 128;
+            const int V = vLine[columns[2][x]] - 128;
+
+            out[x] = qRgb(qBound(0, (Y + 409 * V) >> 8, 255),
+                          qBound(0, (Y - 100 * U - 208 * V) >> 8, 255),
+                          qBound(0, (Y + 516 * U) >> 8, 255));
+        }
+    }
+
+    gst_video_frame_unmap(&frame);
+
+    return image;
+}
+#endif
+
+/*!
+    Returns the dimensions of the JPEG image in \a data of \a size bytes,
+    read from its start of frame header without decoding the image.
+
+    Returns an empty size if \a data is not a JPEG image, or if no frame
+    header precedes the first scan.
+*/
+QSize QGstUtils::jpegResolution(const uchar *data, int size)
+{
+    if (!data || size < 4 || data[0] != 0xff || data[1] != 0xd8)
+        return QSize();
+
+    int pos = 2;
+    while (pos + 4 <= size) {
+        if (data[pos] != 0xff)
+            return QSize();
+
+        // Any number of fill bytes may precede a marker
+        while (pos + 1 < size && data[pos + 1] == 0xff)
+            ++pos;
+        if (pos + 4 > size)
+            break;
+
+        const uchar marker = data[pos + 1];
+        pos += 2;
+
+        // Markers without a segment
+        if (marker == 0x01 || (marker >= 0xd0 && marker <= 0xd8))
+            continue;
+        // End of image or start of scan, the frame header should have come first
+        if (marker == 0xd9 || marker == 0xda)
+            break;
+
+        const int length = (data[pos] << 8) | data[pos + 1];
+        if (length < 2)
+            break;
+
+        // SOF0 to SOF15, except DHT, JPG and DAC which share the range
+        if (marker >= 0xc0 && marker <= 0xcf
+                && marker != 0xc4 && marker != 0xc8 && marker != 0xcc) {
+            if (length < 7 || pos + 7 > size)
+                break;
+            const int height = (data[pos + 3] << 8) | data[pos + 4];
+            const int width = (data[pos + 5] << 8) | data[pos + 6];
+            return QSize(width, height);
+        }
+
+        pos += length;
+    }
+
+    return QSize();
+}
+
 
 namespace {
 
@@ -118,7 +118,22 @@ QVideoSurfaceGstDelegate::QVideoSurfaceGstDelegate(QAbstractVideoSurface *surfac
     , m_notified(false)
     , m_stop(false)
     , m_flush(false)
-{
+    , m_dropPolicy(DropOldestFrame)
+    , m_lastLatency(0)
+    , m_maximumLatency(0)
+    , m_totalLatency(0)
+{
+    m_clock.start();
+
+    // QT_GSTREAMER_VIDEO_FRAME_QUEUE=<depth> hands frames to the surface through a bounded
+    // queue instead of blocking the streaming thread until the surface has presented them.
+    bool ok = false;
+    const int queueDepth = qgetenv("QT_GSTREAMER_VIDEO_FRAME_QUEUE").toInt(&ok);
+    if (ok && queueDepth > 0) {
+        const QByteArray policy = qgetenv("QT_GSTREAMER_VIDEO_FRAME_QUEUE_POLICY");
+        setFrameQueue(queueDepth, policy == "drop-newest" ? DropNewestFrame : DropOldestFrame);
+    }
+
     foreach (QObject *instance, rendererLoader()->instances(QGstVideoRendererPluginKey)) {
         QGstVideoRendererInterface* plugin = qobject_cast<QGstVideoRendererInterface*>(instance);
         if (QGstVideoRenderer *renderer = plugin ? plugin->createRenderer() : 0)
@@ -132,6 +147,7 @@ QVideoSurfaceGstDelegate::QVideoSurfaceGstDelegate(QAbstractVideoSurface *surfac
 
 QVideoSurfaceGstDelegate::~QVideoSurfaceGstDelegate()
 {
+    clearFrameQueue();
     qDeleteAll(m_renderers);
 
     if (m_surfaceCaps)
@@ -140,6 +156,46 @@ QVideoSurfaceGstDelegate::~QVideoSurfaceGstDelegate()
         gst_caps_unref(m_startCaps);
 }
 
+/*
+    Sets the number of frames which may be pending presentation to \a depth.
+
+    With a depth of 0 (the default) render() blocks the streaming thread until the
+    surface has presented the frame. Otherwise render() returns immediately and the
+    frame is presented when the surface's thread gets to it; if \a depth frames are
+    already waiting the frame selected by \a policy is discarded.
+
+    This must not be called while the sink is streaming.
+*/
+void QVideoSurfaceGstDelegate::setFrameQueue(int depth, FrameDropPolicy policy)
+{
+    QMutexLocker locker(&m_mutex);
+
+    clearFrameQueue();
+
+    m_queue.fill(QueuedFrame(), qMax(0, depth));
+    m_dropPolicy = policy;
+    m_queueHead.store(0);
+    m_queueTail.store(0);
+}
+
+QVideoSurfaceGstDelegate::FrameQueueStatistics QVideoSurfaceGstDelegate::frameQueueStatistics() const
+{
+    FrameQueueStatistics statistics;
+    statistics.depth = m_queue.size();
+    statistics.queuedFrames = qMax(0, m_queueHead.loadAcquire() - m_queueTail.loadAcquire());
+    statistics.droppedOldestFrames = m_droppedOldestFrames.load();
+    statistics.droppedNewestFrames = m_droppedNewestFrames.load();
+
+    QMutexLocker locker(&m_mutex);
+    statistics.presentedFrames = m_presentedFrames.load();
+    statistics.lastLatency = m_lastLatency;
+    statistics.maximumLatency = m_maximumLatency;
+    if (statistics.presentedFrames > 0)
+        statistics.averageLatency = m_totalLatency / statistics.presentedFrames;
+
+    return statistics;
+}
+
 GstCaps *QVideoSurfaceGstDelegate::caps()
 {
     QMutexLocker locker(&m_mutex);
@@ -198,6 +254,8 @@ void QVideoSurfaceGstDelegate::stop()
         m_startCaps = 0;
     }
 
+    clearFrameQueue();
+
     waitForAsyncEvent(&locker, &m_setupCondition, 500);
 }
 
@@ -230,11 +288,16 @@ void QVideoSurfaceGstDelegate::flush()
     m_renderBuffer = 0;
     m_renderCondition.wakeAll();
 
+    clearFrameQueue();
+
     notify();
 }
 
 GstFlowReturn QVideoSurfaceGstDelegate::render(GstBuffer *buffer)
 {
+    if (!m_queue.isEmpty())
+        return queueFrame(buffer);
+
     QMutexLocker locker(&m_mutex);
 
     m_renderReturn = GST_FLOW_OK;
@@ -258,6 +321,10 @@ bool QVideoSurfaceGstDelegate::event(QEvent *event)
             while (handleEvent(&locker)) {}
             m_notified = false;
         }
+
+        if (!m_queue.isEmpty())
+            presentQueuedFrame(&locker);
+
         return true;
     } else {
         return QObject::event(event);
@@ -362,6 +429,114 @@ bool QVideoSurfaceGstDelegate::waitForAsyncEvent(
     }
 }
 
+GstFlowReturn QVideoSurfaceGstDelegate::queueFrame(GstBuffer *buffer)
+{
+    // Called on the streaming thread; never waits for the surface.
+    if (m_queueRenderFailed.fetchAndStoreRelaxed(0))
+        return GST_FLOW_ERROR;
+
+    const int depth = m_queue.size();
+    const int head = m_queueHead.load();
+
+    for (;;) {
+        const int tail = m_queueTail.loadAcquire();
+        if (head - tail < depth)
+            break;
+
+        if (m_dropPolicy == DropNewestFrame) {
+            m_droppedNewestFrames.ref();
+            return GST_FLOW_OK;
+        }
+
+        // Claim the oldest frame the same way the consumer would and discard it.
+        GstBuffer *oldest = m_queue.at(tail % depth).buffer;
+        if (m_queueTail.testAndSetOrdered(tail, tail + 1)) {
+            gst_buffer_unref(oldest);
+            m_droppedOldestFrames.ref();
+        }
+    }
+
+    QueuedFrame &slot = m_queue[head % depth];
+    slot.buffer = gst_buffer_ref(buffer);
+    slot.queuedAt = m_clock.nsecsElapsed();
+
+    m_queueHead.storeRelease(head + 1);
+
+    notifyFrameQueue();
+
+    return GST_FLOW_OK;
+}
+
+bool QVideoSurfaceGstDelegate::dequeueFrame(QueuedFrame *frame)
+{
+    const int depth = m_queue.size();
+
+    for (;;) {
+        const int tail = m_queueTail.loadAcquire();
+        if (tail == m_queueHead.loadAcquire())
+            return false;
+
+        // Copy the slot before claiming it, once the tail has moved on the streaming
+        // thread is free to reuse it.
+        *frame = m_queue.at(tail % depth);
+        if (m_queueTail.testAndSetOrdered(tail, tail + 1))
+            return true;
+    }
+}
+
+void QVideoSurfaceGstDelegate::clearFrameQueue()
+{
+    QueuedFrame frame;
+    while (!m_queue.isEmpty() && dequeueFrame(&frame))
+        gst_buffer_unref(frame.buffer);
+}
+
+void QVideoSurfaceGstDelegate::notifyFrameQueue()
+{
+    if (m_queueNotified.testAndSetOrdered(0, 1))
+        QCoreApplication::postEvent(this, new QEvent(QEvent::UpdateRequest));
+}
+
+void QVideoSurfaceGstDelegate::presentQueuedFrame(QMutexLocker *locker)
+{
+    m_queueNotified.storeRelease(0);
+
+    QueuedFrame frame;
+    if (!dequeueFrame(&frame))
+        return;
+
+    // Present one frame per event so the surface's thread can process other events
+    // in between, anything left over is picked up by the next event.
+    if (m_queueTail.loadAcquire() != m_queueHead.loadAcquire())
+        notifyFrameQueue();
+
+    if (m_activeRenderer && m_surface) {
+        QGstVideoRenderer * const renderer = m_activeRenderer;
+        locker->unlock();
+
+        const bool rendered = renderer->present(m_surface, frame.buffer);
+
+        locker->relock();
+
+        if (!rendered)
+            m_queueRenderFailed.store(1);
+    }
+
+    gst_buffer_unref(frame.buffer);
+
+    const qint64 latency = (m_clock.nsecsElapsed() - frame.queuedAt) / 1000;
+    m_lastLatency = latency;
+    m_maximumLatency = qMax(m_maximumLatency, latency);
+    m_totalLatency += latency;
+    m_presentedFrames.ref();
+
+#ifdef DEBUG_VIDEO_SURFACE_SINK
+    qDebug() << "Presented queued frame after" << latency << "us,"
+             << "dropped" << m_droppedOldestFrames.load() << "oldest and"
+             << m_droppedNewestFrames.load() << "newest frames";
+#endif
+}
+
 void QVideoSurfaceGstDelegate::updateSupportedFormats()
 {
     if (m_surfaceCaps) {
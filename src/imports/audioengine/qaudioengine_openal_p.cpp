@@ -33,6 +33,7 @@
 
 #include "qaudioengine_openal_p.h"
 
+#include <QtCore/QElapsedTimer>
 #include <QtCore/QMutex>
 #include <QtCore/QThread>
 #include <QtNetwork/QNetworkRequest>
@@ -188,12 +189,50 @@ void StaticSoundBufferAL::decoderError()
 
 
 /////////////////////////////////////////////////////////////////
+QAudioEngineUpdateThread::QAudioEngineUpdateThread(QAudioEnginePrivate *engine)
+    : m_engine(engine)
+{
+}
+
+/*
+    Applies the pending source and listener updates once per audio block.
+    Play, pause and stop requests wake the thread right away; parameter
+    changes are collected until the next block while sounds are playing.
+    The thread sleeps until woken when nothing is playing.
+*/
+void QAudioEngineUpdateThread::run()
+{
+    QAudioEnginePrivate *d = m_engine;
+    for (;;) {
+        {
+            QMutexLocker locker(&d->m_updateMutex);
+            if (d->m_quit)
+                return;
+            if (d->m_pendingSources.isEmpty() && !d->m_listenerDirty) {
+                if (d->m_playingSources.isEmpty()) {
+                    d->m_idle = true;
+                    d->m_updateCondition.wait(&d->m_updateMutex);
+                    d->m_idle = false;
+                } else {
+                    d->m_updateCondition.wait(&d->m_updateMutex, d->m_updateInterval);
+                }
+            }
+            if (d->m_quit)
+                return;
+        }
+        d->processUpdates();
+    }
+}
+
 QAudioEnginePrivate::QAudioEnginePrivate(QObject *parent)
     : QObject(parent)
+    , m_updateThread(0)
+    , m_updateInterval(20)
+    , m_listenerDirty(0)
+    , m_listenerGain(1)
+    , m_idle(false)
+    , m_quit(false)
 {
-    m_updateTimer.setInterval(200);
-    connect(&m_updateTimer, SIGNAL(timeout()), this, SLOT(updateSoundSources()));
-
     m_sampleLoader = new QSampleCache(this);
     m_sampleLoader->setCapacity(0);
     connect(m_sampleLoader, SIGNAL(isLoadingChanged()), this, SIGNAL(isLoadingChanged()));
@@ -228,6 +267,20 @@ QAudioEnginePrivate::QAudioEnginePrivate(QObject *parent)
     alcMakeContextCurrent(context);
     alDistanceModel(AL_NONE);
     alDopplerFactor(0);
+
+    // One audio block of the mixer, unless overridden
+    ALCint refresh = 0;
+    alcGetIntegerv(device, ALC_REFRESH, 1, &refresh);
+    if (refresh > 0)
+        m_updateInterval = qBound(5, 1000 / refresh, 100);
+
+    bool ok = false;
+    const int interval = qgetenv("QT_AUDIOENGINE_UPDATE_INTERVAL").toInt(&ok);
+    if (ok && interval > 0)
+        m_updateInterval = qMin(interval, 1000);
+
+    m_updateThread = new QAudioEngineUpdateThread(this);
+    m_updateThread->start();
 }
 
 QAudioEnginePrivate::~QAudioEnginePrivate()
@@ -235,6 +288,16 @@ QAudioEnginePrivate::~QAudioEnginePrivate()
 #ifdef DEBUG_AUDIOENGINE
     qDebug() << "QAudioEnginePrivate::dtor";
 #endif
+    stopUpdateThread();
+
+    if (!qEnvironmentVariableIsEmpty("QT_AUDIOENGINE_STATISTICS")) {
+        const UpdateStatistics stats = updateStatistics();
+        qDebug("QAudioEngine: %lld updates every %d ms, average %.3f ms, maximum %.3f ms",
+               stats.blocks, m_updateInterval,
+               stats.blocks ? stats.totalNsecs / 1e6 / stats.blocks : 0.0,
+               stats.maximumNsecs / 1e6);
+    }
+
     QObjectList children = this->children();
     foreach (QObject *child, children) {
         QSoundSourcePrivate* s = qobject_cast<QSoundSourcePrivate*>(child);
@@ -243,6 +306,12 @@ QAudioEnginePrivate::~QAudioEnginePrivate()
         s->release();
     }
 
+    if (!m_alSourcePool.isEmpty()) {
+        alDeleteSources(m_alSourcePool.count(), m_alSourcePool.constData());
+        checkNoError("delete pooled sources");
+        m_alSourcePool.clear();
+    }
+
     foreach (QSoundBufferPrivateAL *buffer, m_staticBufferPool) {
         delete buffer;
     }
@@ -259,6 +328,20 @@ QAudioEnginePrivate::~QAudioEnginePrivate()
 #endif
 }
 
+void QAudioEnginePrivate::stopUpdateThread()
+{
+    if (!m_updateThread)
+        return;
+    {
+        QMutexLocker locker(&m_updateMutex);
+        m_quit = true;
+        m_updateCondition.wakeAll();
+    }
+    m_updateThread->wait();
+    delete m_updateThread;
+    m_updateThread = 0;
+}
+
 bool QAudioEnginePrivate::isLoading() const
 {
     return m_sampleLoader->isLoading();
@@ -271,12 +354,11 @@ QSoundSource* QAudioEnginePrivate::createSoundSource()
 #endif
     QSoundSourcePrivate *instance = NULL;
     if (m_instancePool.count() == 0) {
-        instance = new QSoundSourcePrivate(this);
+        instance = new QSoundSourcePrivate(this, acquireAlSource());
     } else {
         instance = m_instancePool.front();
         m_instancePool.pop_front();
     }
-    connect(instance, SIGNAL(activate(QObject*)), this, SLOT(soundSourceActivate(QObject*)));
     return instance;
 }
 
@@ -287,8 +369,257 @@ void QAudioEnginePrivate::releaseSoundSource(QSoundSource *soundInstance)
     qDebug() << "recycle soundInstance" << privInstance;
 #endif
     privInstance->unbindBuffer();
+    privInstance->resetParameters();
     m_instancePool.push_front(privInstance);
-    m_activeInstances.removeOne(privInstance);
+}
+
+/*
+    OpenAL sources are generated in batches, so that starting many sounds
+    at once doesn't round trip to the implementation for each of them.
+*/
+ALuint QAudioEnginePrivate::acquireAlSource()
+{
+    static const int batchSize = 16;
+
+    QMutexLocker locker(&m_alMutex);
+    if (m_alSourcePool.isEmpty()) {
+        ALuint sources[batchSize];
+        alGetError(); // clear error
+        alGenSources(batchSize, sources);
+        if (checkNoError("create sources")) {
+            for (int i = batchSize - 1; i >= 0; --i)
+                m_alSourcePool.append(sources[i]);
+        } else {
+            // The implementation may have a lower source limit, try a single one
+            ALuint source = 0;
+            alGenSources(1, &source);
+            if (!checkNoError("create source"))
+                return 0;
+            return source;
+        }
+    }
+    const ALuint source = m_alSourcePool.last();
+    m_alSourcePool.removeLast();
+    return source;
+}
+
+// The update mutex must be held
+void QAudioEnginePrivate::scheduleUpdate(QSoundSourcePrivate *source, bool wake)
+{
+    if (!source->m_pending) {
+        source->m_pending = true;
+        m_pendingSources.append(source);
+    }
+    if (wake || m_idle)
+        m_updateCondition.wakeOne();
+}
+
+void QAudioEnginePrivate::cancelUpdate(QSoundSourcePrivate *source)
+{
+    QMutexLocker locker(&m_updateMutex);
+    if (source->m_pending) {
+        source->m_pending = false;
+        m_pendingSources.removeOne(source);
+    }
+    source->m_dirty = 0;
+    source->m_command = QSoundSourcePrivate::NoCommand;
+}
+
+// The update mutex must be held
+void QAudioEnginePrivate::scheduleListenerUpdate(uint flags)
+{
+    m_listenerDirty |= flags;
+    if (m_idle)
+        m_updateCondition.wakeOne();
+}
+
+static inline void reportSourceState(QSoundSourcePrivate *source, QSoundSource::State state, int generation)
+{
+    QMetaObject::invokeMethod(source, "updateState", Qt::QueuedConnection,
+                              Q_ARG(int, state), Q_ARG(int, generation));
+}
+
+/*
+    Runs on the engine thread. Takes the pending updates, applies them in a
+    single deferred batch and reports the sources whose state changed.
+*/
+void QAudioEnginePrivate::processUpdates()
+{
+    QVector<SourceUpdate> updates;
+    uint listenerDirty = 0;
+    QVector3D listenerPosition;
+    QVector3D listenerVelocity;
+    QVector3D listenerDirection;
+    QVector3D listenerUp;
+    qreal listenerGain = 1;
+
+    {
+        QMutexLocker locker(&m_updateMutex);
+        updates.reserve(m_pendingSources.count());
+        foreach (QSoundSourcePrivate *source, m_pendingSources) {
+            const SourceUpdate update = {
+                source, source->m_alSource, source->m_dirty, source->m_command,
+                source->m_parameters, source->m_generation
+            };
+            updates.append(update);
+            source->m_dirty = 0;
+            source->m_command = QSoundSourcePrivate::NoCommand;
+            source->m_pending = false;
+        }
+        m_pendingSources.clear();
+
+        listenerDirty = m_listenerDirty;
+        listenerPosition = m_listenerPosition;
+        listenerVelocity = m_listenerVelocity;
+        listenerDirection = m_listenerDirection;
+        listenerUp = m_listenerUp;
+        listenerGain = m_listenerGain;
+        m_listenerDirty = 0;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    {
+        QMutexLocker locker(&m_alMutex);
+
+        ALCcontext *context = alcGetCurrentContext();
+        alcSuspendContext(context);
+
+        if (listenerDirty & ListenerPositionDirty)
+            alListener3f(AL_POSITION, listenerPosition.x(), listenerPosition.y(), listenerPosition.z());
+        if (listenerDirty & ListenerVelocityDirty)
+            alListener3f(AL_VELOCITY, listenerVelocity.x(), listenerVelocity.y(), listenerVelocity.z());
+        if (listenerDirty & ListenerOrientationDirty) {
+            const ALfloat orientation[6] = {
+                listenerDirection.x(), listenerDirection.y(), listenerDirection.z(),
+                listenerUp.x(), listenerUp.y(), listenerUp.z()
+            };
+            alListenerfv(AL_ORIENTATION, orientation);
+        }
+        if (listenerDirty & ListenerGainDirty)
+            alListenerf(AL_GAIN, listenerGain);
+
+        foreach (const SourceUpdate &update, updates) {
+            const ALuint alSource = update.alSource;
+            const QSoundSourcePrivate::Parameters &p = update.parameters;
+            if (!alSource)
+                continue;
+
+            if (update.dirty & QSoundSourcePrivate::PositionDirty)
+                alSource3f(alSource, AL_POSITION, p.position.x(), p.position.y(), p.position.z());
+            if (update.dirty & QSoundSourcePrivate::VelocityDirty)
+                alSource3f(alSource, AL_VELOCITY, p.velocity.x(), p.velocity.y(), p.velocity.z());
+            if (update.dirty & QSoundSourcePrivate::DirectionDirty)
+                alSource3f(alSource, AL_DIRECTION, p.direction.x(), p.direction.y(), p.direction.z());
+            if (update.dirty & QSoundSourcePrivate::GainDirty)
+                alSourcef(alSource, AL_GAIN, p.gain);
+            if (update.dirty & QSoundSourcePrivate::PitchDirty)
+                alSourcef(alSource, AL_PITCH, p.pitch);
+            if (update.dirty & QSoundSourcePrivate::LoopingDirty)
+                alSourcei(alSource, AL_LOOPING, p.looping ? AL_TRUE : AL_FALSE);
+            if (update.dirty & QSoundSourcePrivate::ConeDirty) {
+                //make sure the setting order will always keep outerAngle >= innerAngle in openAL
+                ALfloat outerAngle = 360;
+                alGetSourcef(alSource, AL_CONE_OUTER_ANGLE, &outerAngle);
+                if (p.coneInnerAngle < outerAngle) {
+                    alSourcef(alSource, AL_CONE_INNER_ANGLE, p.coneInnerAngle);
+                    alSourcef(alSource, AL_CONE_OUTER_ANGLE, p.coneOuterAngle);
+                } else {
+                    alSourcef(alSource, AL_CONE_OUTER_ANGLE, p.coneOuterAngle);
+                    alSourcef(alSource, AL_CONE_INNER_ANGLE, p.coneInnerAngle);
+                }
+                alSourcef(alSource, AL_CONE_OUTER_GAIN, p.coneOuterGain);
+            }
+#ifdef DEBUG_AUDIOENGINE
+            if (update.dirty)
+                checkNoError("update source");
+#endif
+
+            if (update.command == QSoundSourcePrivate::NoCommand)
+                continue;
+
+            int index = -1;
+            for (int i = 0; i < m_playingSources.count(); ++i) {
+                if (m_playingSources.at(i).source == update.source) {
+                    index = i;
+                    break;
+                }
+            }
+
+            switch (update.command) {
+            case QSoundSourcePrivate::PlayCommand: {
+                alSourcePlay(alSource);
+                const PlayingSource playing = {
+                    update.source, update.generation, QSoundSource::PlayingState
+                };
+                if (index < 0)
+                    m_playingSources.append(playing);
+                else
+                    m_playingSources[index] = playing;
+                reportSourceState(update.source, QSoundSource::PlayingState, update.generation);
+                break;
+            }
+            case QSoundSourcePrivate::PauseCommand:
+                alSourcePause(alSource);
+                if (index >= 0 && m_playingSources.at(index).reportedState != QSoundSource::PausedState) {
+                    m_playingSources[index].reportedState = QSoundSource::PausedState;
+                    reportSourceState(update.source, QSoundSource::PausedState, update.generation);
+                }
+                break;
+            case QSoundSourcePrivate::StopCommand:
+                alSourceStop(alSource);
+                if (index >= 0) {
+                    m_playingSources.remove(index);
+                    reportSourceState(update.source, QSoundSource::StoppedState, update.generation);
+                }
+                break;
+            default:
+                break;
+            }
+        }
+
+        alcProcessContext(context);
+
+        // Sounds that reached their end, or were stopped behind our back
+        for (int i = m_playingSources.count() - 1; i >= 0; --i) {
+            PlayingSource &playing = m_playingSources[i];
+            ALint alState = AL_STOPPED;
+            alGetSourcei(playing.source->m_alSource, AL_SOURCE_STATE, &alState);
+
+            QSoundSource::State state = QSoundSource::StoppedState;
+            if (alState == AL_PLAYING)
+                state = QSoundSource::PlayingState;
+            else if (alState == AL_PAUSED)
+                state = QSoundSource::PausedState;
+
+            if (state != playing.reportedState) {
+                playing.reportedState = state;
+                reportSourceState(playing.source, state, playing.generation);
+            }
+            if (state == QSoundSource::StoppedState)
+                m_playingSources.remove(i);
+        }
+    }
+
+    const qint64 elapsed = timer.nsecsElapsed();
+
+    QMutexLocker locker(&m_updateMutex);
+    ++m_statistics.blocks;
+    m_statistics.totalNsecs += elapsed;
+    m_statistics.maximumNsecs = qMax(m_statistics.maximumNsecs, elapsed);
+    m_statistics.lastNsecs = elapsed;
+    m_statistics.lastSourceCount = updates.count() + m_playingSources.count();
+}
+
+/*
+    Returns how long the engine thread took to apply and poll each audio
+    block so far.
+*/
+QAudioEnginePrivate::UpdateStatistics QAudioEnginePrivate::updateStatistics() const
+{
+    QMutexLocker locker(&m_updateMutex);
+    return m_statistics;
 }
 
 QSoundBuffer* QAudioEnginePrivate::getStaticSoundBuffer(const QUrl& url)
@@ -333,95 +664,56 @@ bool QAudioEnginePrivate::checkNoError(const char *msg)
 
 QVector3D QAudioEnginePrivate::listenerPosition() const
 {
-    ALfloat x, y, z;
-    alGetListener3f(AL_POSITION, &x, &y, &z);
-    checkNoError("get listener position");
-    return QVector3D(x, y, z);
+    return m_listenerPosition;
 }
 
 QVector3D QAudioEnginePrivate::listenerVelocity() const
 {
-    ALfloat x, y, z;
-    alGetListener3f(AL_VELOCITY, &x, &y, &z);
-    checkNoError("get listener velocity");
-    return QVector3D(x, y, z);
+    return m_listenerVelocity;
 }
 
 qreal QAudioEnginePrivate::listenerGain() const
 {
-    ALfloat gain;
-    alGetListenerf(AL_GAIN, &gain);
-    checkNoError("get listener gain");
-    return gain;
+    return m_listenerGain;
 }
 
 void QAudioEnginePrivate::setListenerPosition(const QVector3D& position)
 {
-    alListener3f(AL_POSITION, position.x(), position.y(), position.z());
-    checkNoError("set listener position");
+    QMutexLocker locker(&m_updateMutex);
+    m_listenerPosition = position;
+    scheduleListenerUpdate(ListenerPositionDirty);
 }
 
 void QAudioEnginePrivate::setListenerOrientation(const QVector3D& direction, const QVector3D& up)
 {
-    ALfloat orientation[6];
-    orientation[0] = direction.x();
-    orientation[1] = direction.y();
-    orientation[2] = direction.z();
-    orientation[3] = up.x();
-    orientation[4] = up.y();
-    orientation[5] = up.z();
-    alListenerfv(AL_ORIENTATION, orientation);
-    checkNoError("set listener orientation");
+    QMutexLocker locker(&m_updateMutex);
+    m_listenerDirection = direction;
+    m_listenerUp = up;
+    scheduleListenerUpdate(ListenerOrientationDirty);
 }
 
 void QAudioEnginePrivate::setListenerVelocity(const QVector3D& velocity)
 {
-    alListener3f(AL_VELOCITY, velocity.x(), velocity.y(), velocity.z());
-    checkNoError("set listener velocity");
+    QMutexLocker locker(&m_updateMutex);
+    m_listenerVelocity = velocity;
+    scheduleListenerUpdate(ListenerVelocityDirty);
 }
 
 void QAudioEnginePrivate::setListenerGain(qreal gain)
 {
-    alListenerf(AL_GAIN, gain);
-    checkNoError("set listener gain");
+    QMutexLocker locker(&m_updateMutex);
+    m_listenerGain = gain;
+    scheduleListenerUpdate(ListenerGainDirty);
 }
 
 void QAudioEnginePrivate::setDopplerFactor(qreal dopplerFactor)
 {
+    QMutexLocker locker(&m_alMutex);
     alDopplerFactor(dopplerFactor);
 }
 
 void QAudioEnginePrivate::setSpeedOfSound(qreal speedOfSound)
 {
+    QMutexLocker locker(&m_alMutex);
     alSpeedOfSound(speedOfSound);
 }
-
-void QAudioEnginePrivate::soundSourceActivate(QObject *soundSource)
-{
-    QSoundSourcePrivate *ss = qobject_cast<QSoundSourcePrivate*>(soundSource);
-    ss->checkState();
-    if (ss->isLooping())
-        return;
-    if (!m_activeInstances.contains(ss))
-        m_activeInstances.push_back(ss);
-    if (!m_updateTimer.isActive())
-        m_updateTimer.start();
-}
-
-void QAudioEnginePrivate::updateSoundSources()
-{
-    for (QList<QSoundSourcePrivate*>::Iterator it = m_activeInstances.begin();
-         it != m_activeInstances.end();) {
-        QSoundSourcePrivate *instance = *it;
-        instance->checkState();
-        if (instance->state() == QSoundSource::StoppedState) {
-            it = m_activeInstances.erase(it);
-        } else {
-            ++it;
-        }
-    }
-
-    if (m_activeInstances.count() == 0) {
-        m_updateTimer.stop();
-    }
-}
@@ -48,8 +48,11 @@
 #include <QObject>
 #include <QList>
 #include <QMap>
-#include <QTimer>
+#include <QMutex>
+#include <QThread>
 #include <QUrl>
+#include <QVector>
+#include <QWaitCondition>
 
 #if defined(HEADER_OPENAL_PREFIX)
 #include <OpenAL/al.h>
@@ -66,6 +69,7 @@ QT_BEGIN_NAMESPACE
 
 class QSample;
 class QSampleCache;
+class QAudioEnginePrivate;
 
 class QSoundBufferPrivateAL : public QSoundBuffer
 {
@@ -114,7 +118,7 @@ class QSoundSourcePrivate : public QSoundSource
 {
     Q_OBJECT
 public:
-    QSoundSourcePrivate(QObject *parent);
+    QSoundSourcePrivate(QAudioEnginePrivate *engine, ALuint alSource);
     ~QSoundSourcePrivate();
 
     void play();
@@ -140,26 +144,73 @@ public:
     void bindBuffer(QSoundBuffer*);
     void unbindBuffer();
 
-    void checkState();
-
+    void resetParameters();
     void release();
 
-Q_SIGNALS:
-    void activate(QObject*);
+private Q_SLOTS:
+    void updateState(int state, int generation);
 
 private:
-    void sourcePlay();
-    void sourcePause();
-
+    friend class QAudioEnginePrivate;
+
+    // Source parameters not yet applied by the engine thread
+    enum DirtyFlag {
+        PositionDirty = 0x01,
+        VelocityDirty = 0x02,
+        DirectionDirty = 0x04,
+        GainDirty = 0x08,
+        PitchDirty = 0x10,
+        LoopingDirty = 0x20,
+        ConeDirty = 0x40
+    };
+
+    enum Command {
+        NoCommand,
+        PlayCommand,
+        PauseCommand,
+        StopCommand
+    };
+
+    struct Parameters {
+        QVector3D position;
+        QVector3D velocity;
+        QVector3D direction;
+        qreal gain;
+        qreal pitch;
+        bool looping;
+        qreal coneInnerAngle;
+        qreal coneOuterAngle;
+        qreal coneOuterGain;
+    };
+
+    void markDirty(uint flags);
+    void setCommand(Command command);
+
+    QAudioEnginePrivate *m_engine;
     ALuint  m_alSource;
     QSoundBufferPrivateAL *m_bindBuffer;
     bool                 m_isReady; //true if the sound source is already bound to some sound buffer
     QSoundSource::State  m_state;
-    qreal   m_gain;
-    qreal   m_pitch;
-    qreal   m_coneInnerAngle;
-    qreal   m_coneOuterAngle;
-    qreal   m_coneOuterGain;
+    int m_generation;
+
+    // Guarded by the engine's update mutex, read by the engine thread
+    Parameters m_parameters;
+    uint m_dirty;
+    Command m_command;
+    bool m_pending;
+};
+
+
+class QAudioEngineUpdateThread : public QThread
+{
+public:
+    QAudioEngineUpdateThread(QAudioEnginePrivate *engine);
+
+protected:
+    void run() Q_DECL_OVERRIDE;
+
+private:
+    QAudioEnginePrivate *m_engine;
 };
 
 
@@ -172,6 +223,15 @@ public:
 
     bool isLoading() const;
 
+    struct UpdateStatistics {
+        UpdateStatistics() : blocks(0), totalNsecs(0), maximumNsecs(0), lastNsecs(0), lastSourceCount(0) {}
+        qint64 blocks;
+        qint64 totalNsecs;
+        qint64 maximumNsecs;
+        qint64 lastNsecs;
+        int lastSourceCount;
+    };
+
     QSoundSource* createSoundSource();
     void releaseSoundSource(QSoundSource *soundInstance);
     QSoundBuffer* getStaticSoundBuffer(const QUrl& url);
@@ -187,22 +247,73 @@ public:
     void setDopplerFactor(qreal dopplerFactor);
     void setSpeedOfSound(qreal speedOfSound);
 
+    UpdateStatistics updateStatistics() const;
+    int updateInterval() const { return m_updateInterval; }
+
     static bool checkNoError(const char *msg);
 
 Q_SIGNALS:
     void isLoadingChanged();
 
-private Q_SLOTS:
-    void updateSoundSources();
-    void soundSourceActivate(QObject *soundSource);
-
 private:
-    QList<QSoundSourcePrivate*> m_activeInstances;
+    friend class QSoundSourcePrivate;
+    friend class QAudioEngineUpdateThread;
+
+    enum ListenerDirtyFlag {
+        ListenerPositionDirty = 0x1,
+        ListenerVelocityDirty = 0x2,
+        ListenerOrientationDirty = 0x4,
+        ListenerGainDirty = 0x8
+    };
+
+    struct SourceUpdate {
+        QSoundSourcePrivate *source;
+        ALuint alSource;
+        uint dirty;
+        QSoundSourcePrivate::Command command;
+        QSoundSourcePrivate::Parameters parameters;
+        int generation;
+    };
+
+    ALuint acquireAlSource();
+    void scheduleUpdate(QSoundSourcePrivate *source, bool wake);
+    void cancelUpdate(QSoundSourcePrivate *source);
+    void scheduleListenerUpdate(uint flags);
+    void processUpdates();
+    void stopUpdateThread();
+
     QList<QSoundSourcePrivate*> m_instancePool;
+    QVector<ALuint> m_alSourcePool;
     QMap<QUrl, QSoundBufferPrivateAL*> m_staticBufferPool;
 
     QSampleCache *m_sampleLoader;
-    QTimer m_updateTimer;
+    QAudioEngineUpdateThread *m_updateThread;
+    int m_updateInterval;
+
+    // Serializes the OpenAL source calls of the GUI and the engine threads
+    mutable QMutex m_alMutex;
+
+    // Guards everything below, and the pending state of each source
+    mutable QMutex m_updateMutex;
+    QWaitCondition m_updateCondition;
+    QVector<QSoundSourcePrivate*> m_pendingSources;
+    uint m_listenerDirty;
+    QVector3D m_listenerPosition;
+    QVector3D m_listenerVelocity;
+    QVector3D m_listenerDirection;
+    QVector3D m_listenerUp;
+    qreal m_listenerGain;
+    bool m_idle;
+    bool m_quit;
+    UpdateStatistics m_statistics;
+
+    // Only used by the engine thread
+    struct PlayingSource {
+        QSoundSourcePrivate *source;
+        int generation;
+        QSoundSource::State reportedState;
+    };
+    QVector<PlayingSource> m_playingSources;
 };
 
 QT_END_NAMESPACE
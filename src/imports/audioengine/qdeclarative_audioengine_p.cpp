@@ -116,6 +116,7 @@ QDeclarativeAudioEngine::QDeclarativeAudioEngine(QObject *parent)
     connect(m_audioEngine, SIGNAL(isLoadingChanged()), this, SIGNAL(isLoadingChanged()));
     connect(m_audioEngine, SIGNAL(isLoadingChanged()), this, SLOT(handleLoadingChanged()));
     m_listener = new QDeclarativeAudioListener(this);
+    connect(m_listener, SIGNAL(positionChanged()), this, SLOT(updateAttenuation()));
     m_updateTimer.setInterval(100);
     connect(&m_updateTimer, SIGNAL(timeout()), this, SLOT(updateSoundInstances()));
 }
@@ -167,6 +168,8 @@ QDeclarativeSoundInstance* QDeclarativeAudioEngine::newDeclarativeSoundInstance(
             instance->setEngine(this);
         }
         m_managedDeclSoundInstances.push_back(instance);
+        if (!m_updateTimer.isActive())
+            m_updateTimer.start();
     } else {
         instance = new QDeclarativeSoundInstance();
         instance->setEngine(this);
@@ -202,8 +205,6 @@ QSoundInstance* QDeclarativeAudioEngine::newSoundInstance(const QString &name)
     }
     instance->bindSoundDescription(qobject_cast<QDeclarativeSound*>(qvariant_cast<QObject*>(m_sounds.value(name))));
     m_activeSoundInstances.push_back(instance);
-    if (!m_updateTimer.isActive())
-        m_updateTimer.start();
     emit liveInstanceCountChanged();
     return instance;
 }
@@ -481,6 +482,11 @@ void QDeclarativeAudioEngine::componentComplete()
     emit ready();
 }
 
+/*
+    Moves the managed sound instances along their velocity and recycles the
+    ones which stopped. Only runs while there are managed instances, the
+    sound sources themselves are updated by the engine thread.
+*/
 void QDeclarativeAudioEngine::updateSoundInstances()
 {
     for (QList<QDeclarativeSoundInstance*>::Iterator it = m_managedDeclSoundInstances.begin();
@@ -498,6 +504,12 @@ void QDeclarativeAudioEngine::updateSoundInstances()
         }
     }
 
+    if (m_managedDeclSoundInstances.count() == 0)
+        m_updateTimer.stop();
+}
+
+void QDeclarativeAudioEngine::updateAttenuation()
+{
     QVector3D listenerPosition = this->listener()->position();
     foreach (QSoundInstance *instance, m_activeSoundInstances) {
         if (instance->state() == QSoundInstance::PlayingState
@@ -505,9 +517,6 @@ void QDeclarativeAudioEngine::updateSoundInstances()
             instance->update3DVolume(listenerPosition);
         }
     }
-
-    if (m_activeSoundInstances.count() == 0)
-        m_updateTimer.stop();
 }
 
 void QDeclarativeAudioEngine::appendFunction(QQmlListProperty<QObject> *property, QObject *value)
@@ -135,6 +135,7 @@ Q_SIGNALS:
 
 private Q_SLOTS:
     void updateSoundInstances();
+    void updateAttenuation();
     void handleLoadingChanged();
 
 private:
@@ -295,6 +295,8 @@ void QSoundInstance::setPosition(const QVector3D& position)
     if (!m_soundSource)
         return;
     m_soundSource->setPosition(position);
+    if (m_state == QSoundInstance::PlayingState && attenuationEnabled())
+        update3DVolume(m_engine->listener()->position());
 }
 
 void QSoundInstance::setDirection(const QVector3D& direction)
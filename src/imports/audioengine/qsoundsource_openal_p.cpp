@@ -38,26 +38,22 @@
 
 QT_USE_NAMESPACE
 
-QSoundSourcePrivate::QSoundSourcePrivate(QObject *parent)
-    : QSoundSource(parent)
-    , m_alSource(0)
+QSoundSourcePrivate::QSoundSourcePrivate(QAudioEnginePrivate *engine, ALuint alSource)
+    : QSoundSource(engine)
+    , m_engine(engine)
+    , m_alSource(alSource)
     , m_bindBuffer(0)
     , m_isReady(false)
     , m_state(QSoundSource::StoppedState)
-    , m_gain(0)
-    , m_pitch(0)
-    , m_coneInnerAngle(0)
-    , m_coneOuterAngle(0)
-    , m_coneOuterGain(1)
+    , m_generation(0)
+    , m_dirty(0)
+    , m_command(NoCommand)
+    , m_pending(false)
 {
 #ifdef DEBUG_AUDIOENGINE
     qDebug() << "creating new QSoundSourcePrivate";
 #endif
-    alGenSources(1, &m_alSource);
-    QAudioEnginePrivate::checkNoError("create source");
-    setGain(1);
-    setPitch(1);
-    setCone(360, 360, 0);
+    resetParameters();
 }
 
 QSoundSourcePrivate::~QSoundSourcePrivate()
@@ -74,26 +70,74 @@ void QSoundSourcePrivate::release()
 #ifdef DEBUG_AUDIOENGINE
     qDebug() << "QSoundSourcePrivate::release";
 #endif
-        stop();
         unbindBuffer();
+        m_engine->cancelUpdate(this);
+
+        QMutexLocker locker(&m_engine->m_alMutex);
+        alSourceStop(m_alSource);
         alDeleteSources(1, &m_alSource);
         QAudioEnginePrivate::checkNoError("delete source");
         m_alSource = 0;
     }
 }
 
+/*
+    Restores the default source parameters, so that a recycled source
+    doesn't keep the settings of its previous sound.
+*/
+void QSoundSourcePrivate::resetParameters()
+{
+    QMutexLocker locker(&m_engine->m_updateMutex);
+    m_parameters.position = QVector3D(0, 0, 0);
+    m_parameters.velocity = QVector3D(0, 0, 0);
+    m_parameters.direction = QVector3D(0, 0, 0);
+    m_parameters.gain = 1;
+    m_parameters.pitch = 1;
+    m_parameters.looping = false;
+    m_parameters.coneInnerAngle = 360;
+    m_parameters.coneOuterAngle = 360;
+    m_parameters.coneOuterGain = 0;
+    markDirty(PositionDirty | VelocityDirty | DirectionDirty | GainDirty
+              | PitchDirty | LoopingDirty | ConeDirty);
+}
+
+// The update mutex of the engine must be held
+void QSoundSourcePrivate::markDirty(uint flags)
+{
+    m_dirty |= flags;
+    m_engine->scheduleUpdate(this, false);
+}
+
+// The update mutex of the engine must be held
+void QSoundSourcePrivate::setCommand(Command command)
+{
+    m_command = command;
+    m_engine->scheduleUpdate(this, true);
+}
+
 void QSoundSourcePrivate::bindBuffer(QSoundBuffer* soundBuffer)
 {
     unbindBuffer();
     Q_ASSERT(soundBuffer->state() == QSoundBuffer::Ready);
     m_bindBuffer = qobject_cast<QSoundBufferPrivateAL*>(soundBuffer);
-    m_bindBuffer->bindToSource(m_alSource);
+    {
+        QMutexLocker locker(&m_engine->m_alMutex);
+        m_bindBuffer->bindToSource(m_alSource);
+    }
     m_isReady = true;
 }
 
 void QSoundSourcePrivate::unbindBuffer()
 {
+    {
+        // State changes reported for the previous buffer are stale from now on
+        QMutexLocker locker(&m_engine->m_updateMutex);
+        m_command = NoCommand;
+        ++m_generation;
+    }
     if (m_bindBuffer) {
+        QMutexLocker locker(&m_engine->m_alMutex);
+        alSourceStop(m_alSource);
         m_bindBuffer->unbindFromSource(m_alSource);
         m_bindBuffer = 0;
     }
@@ -108,40 +152,29 @@ void QSoundSourcePrivate::play()
 {
     if (!m_alSource || !m_isReady)
         return;
-    alSourcePlay(m_alSource);
-#ifdef DEBUG_AUDIOENGINE
-    QAudioEnginePrivate::checkNoError("play");
-#endif
-    emit activate(this);
+    QMutexLocker locker(&m_engine->m_updateMutex);
+    setCommand(PlayCommand);
 }
 
 bool QSoundSourcePrivate::isLooping() const
 {
-    if (!m_alSource)
-        return false;
-    ALint looping = 0;
-    alGetSourcei(m_alSource, AL_LOOPING, &looping);
-    return looping == AL_TRUE ? true : false;
+    return m_parameters.looping;
 }
 
 void QSoundSourcePrivate::pause()
 {
     if (!m_alSource || !m_isReady)
         return;
-    alSourcePause(m_alSource);
-#ifdef DEBUG_AUDIOENGINE
-    QAudioEnginePrivate::checkNoError("pause");
-#endif
+    QMutexLocker locker(&m_engine->m_updateMutex);
+    setCommand(PauseCommand);
 }
 
 void QSoundSourcePrivate::stop()
 {
     if (!m_alSource)
         return;
-    alSourceStop(m_alSource);
-#ifdef DEBUG_AUDIOENGINE
-    QAudioEnginePrivate::checkNoError("stop");
-#endif
+    QMutexLocker locker(&m_engine->m_updateMutex);
+    setCommand(StopCommand);
 }
 
 QSoundSource::State QSoundSourcePrivate::state() const
@@ -149,22 +182,15 @@ QSoundSource::State QSoundSourcePrivate::state() const
     return m_state;
 }
 
-void QSoundSourcePrivate::checkState()
+/*
+    Invoked by the engine thread whenever the OpenAL state of the source
+    differs from the one last reported.
+*/
+void QSoundSourcePrivate::updateState(int state, int generation)
 {
-    QSoundSource::State st;
-    st = QSoundSource::StoppedState;
-    if (m_alSource && m_isReady) {
-        ALint s;
-        alGetSourcei(m_alSource, AL_SOURCE_STATE, &s);
-        switch (s) {
-        case AL_PLAYING:
-            st = QSoundSource::PlayingState;
-            break;
-        case AL_PAUSED:
-            st = QSoundSource::PausedState;
-            break;
-        }
-    }
+    if (generation != m_generation || !m_isReady)
+        return;
+    const QSoundSource::State st = QSoundSource::State(state);
     if (st == m_state)
         return;
     m_state = st;
@@ -173,88 +199,65 @@ void QSoundSourcePrivate::checkState()
 
 void QSoundSourcePrivate::setLooping(bool looping)
 {
-    if (!m_alSource)
+    QMutexLocker locker(&m_engine->m_updateMutex);
+    if (m_parameters.looping == looping)
         return;
-    alSourcei(m_alSource, AL_LOOPING, looping ? AL_TRUE : AL_FALSE);
+    m_parameters.looping = looping;
+    markDirty(LoopingDirty);
 }
 
 void QSoundSourcePrivate::setPosition(const QVector3D& position)
 {
-    if (!m_alSource)
-        return;
-    alSource3f(m_alSource, AL_POSITION, position.x(), position.y(), position.z());
-#ifdef DEBUG_AUDIOENGINE
-    QAudioEnginePrivate::checkNoError("source set position");
-#endif
+    QMutexLocker locker(&m_engine->m_updateMutex);
+    m_parameters.position = position;
+    markDirty(PositionDirty);
 }
 
 void QSoundSourcePrivate::setDirection(const QVector3D& direction)
 {
-    if (!m_alSource)
-        return;
-    alSource3f(m_alSource, AL_DIRECTION, direction.x(), direction.y(), direction.z());
-#ifdef DEBUG_AUDIOENGINE
-    QAudioEnginePrivate::checkNoError("source set direction");
-#endif
+    QMutexLocker locker(&m_engine->m_updateMutex);
+    m_parameters.direction = direction;
+    markDirty(DirectionDirty);
 }
 
 void QSoundSourcePrivate::setVelocity(const QVector3D& velocity)
 {
-    if (!m_alSource)
-        return;
-    alSource3f(m_alSource, AL_VELOCITY, velocity.x(), velocity.y(), velocity.z());
-#ifdef DEBUG_AUDIOENGINE
-    QAudioEnginePrivate::checkNoError("source set velocity");
-#endif
+    QMutexLocker locker(&m_engine->m_updateMutex);
+    m_parameters.velocity = velocity;
+    markDirty(VelocityDirty);
 }
 
 QVector3D QSoundSourcePrivate::velocity() const
 {
-    if (!m_alSource)
-        return QVector3D(0, 0, 0);
-    ALfloat x, y, z;
-    alGetSource3f(m_alSource, AL_VELOCITY, &x, &y, &z);
-    return QVector3D(x, y, z);
+    return m_parameters.velocity;
 }
 
 QVector3D QSoundSourcePrivate::position() const
 {
-    if (!m_alSource)
-        return QVector3D(0, 0, 0);
-    ALfloat x, y, z;
-    alGetSource3f(m_alSource, AL_POSITION, &x, &y, &z);
-    return QVector3D(x, y, z);
+    return m_parameters.position;
 }
 
 QVector3D QSoundSourcePrivate::direction() const
 {
-    if (!m_alSource)
-        return QVector3D(0, 1, 0);
-    ALfloat x, y, z;
-    alGetSource3f(m_alSource, AL_DIRECTION, &x, &y, &z);
-    return QVector3D(x, y, z);
+    return m_parameters.direction;
 }
 
 void QSoundSourcePrivate::setGain(qreal gain)
 {
-    if (!m_alSource || gain == m_gain)
+    QMutexLocker locker(&m_engine->m_updateMutex);
+    if (gain == m_parameters.gain)
         return;
-    alSourcef(m_alSource, AL_GAIN, gain);
-#ifdef DEBUG_AUDIOENGINE
-    QAudioEnginePrivate::checkNoError("source set gain");
-#endif
-    m_gain = gain;
+    m_parameters.gain = gain;
+    markDirty(GainDirty);
 }
 
 void QSoundSourcePrivate::setPitch(qreal pitch)
 {
-    if (!m_alSource || m_pitch == pitch)
+    QMutexLocker locker(&m_engine->m_updateMutex);
+    if (pitch == m_parameters.pitch)
         return;
-    alSourcef(m_alSource, AL_PITCH, pitch);
-#ifdef DEBUG_AUDIOENGINE
-    QAudioEnginePrivate::checkNoError("source set pitch");
-#endif
-    m_pitch = pitch;
+    m_parameters.pitch = pitch;
+    markDirty(PitchDirty);
 }
 
 void QSoundSourcePrivate::setCone(qreal innerAngle, qreal outerAngle, qreal outerGain)
@@ -263,44 +266,14 @@ void QSoundSourcePrivate::setCone(qreal innerAngle, qreal outerAngle, qreal oute
         outerAngle = innerAngle;
     Q_ASSERT(outerAngle <= 360 && innerAngle >= 0);
 
-    //make sure the setting order will always keep outerAngle >= innerAngle in openAL
-    if (outerAngle >= m_coneInnerAngle) {
-        if (m_coneOuterAngle != outerAngle) {
-            alSourcef(m_alSource, AL_CONE_OUTER_ANGLE, outerAngle);
-#ifdef DEBUG_AUDIOENGINE
-            QAudioEnginePrivate::checkNoError("source set cone outerAngle");
-#endif
-            m_coneOuterAngle = outerAngle;
-        }
-        if (m_coneInnerAngle != innerAngle) {
-            alSourcef(m_alSource, AL_CONE_INNER_ANGLE, innerAngle);
-#ifdef DEBUG_AUDIOENGINE
-            QAudioEnginePrivate::checkNoError("source set cone innerAngle");
-#endif
-            m_coneInnerAngle = innerAngle;
-        }
-    } else {
-        if (m_coneInnerAngle != innerAngle) {
-            alSourcef(m_alSource, AL_CONE_INNER_ANGLE, innerAngle);
-#ifdef DEBUG_AUDIOENGINE
-            QAudioEnginePrivate::checkNoError("source set cone innerAngle");
-#endif
-            m_coneInnerAngle = innerAngle;
-        }
-        if (m_coneOuterAngle != outerAngle) {
-            alSourcef(m_alSource, AL_CONE_OUTER_ANGLE, outerAngle);
-#ifdef DEBUG_AUDIOENGINE
-            QAudioEnginePrivate::checkNoError("source set cone outerAngle");
-#endif
-            m_coneOuterAngle = outerAngle;
-        }
-    }
-
-    if (outerGain != m_coneOuterGain) {
-        alSourcef(m_alSource, AL_CONE_OUTER_GAIN, outerGain);
-#ifdef DEBUG_AUDIOENGINE
-        QAudioEnginePrivate::checkNoError("source set cone outerGain");
-#endif
-        m_coneOuterGain = outerGain;
+    QMutexLocker locker(&m_engine->m_updateMutex);
+    if (innerAngle == m_parameters.coneInnerAngle
+            && outerAngle == m_parameters.coneOuterAngle
+            && outerGain == m_parameters.coneOuterGain) {
+        return;
     }
+    m_parameters.coneInnerAngle = innerAngle;
+    m_parameters.coneOuterAngle = outerAngle;
+    m_parameters.coneOuterGain = outerGain;
+    markDirty(ConeDirty);
 }
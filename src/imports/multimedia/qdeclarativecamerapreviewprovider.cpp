@@ -32,20 +32,126 @@
 ****************************************************************************/
 
 #include "qdeclarativecamerapreviewprovider_p.h"
+#include <QtCore/qatomic.h>
 #include <QtCore/qmutex.h>
+#include <QtCore/qsharedpointer.h>
+#include <QtCore/qvector.h>
 #include <QtCore/qdebug.h>
 
 QT_BEGIN_NAMESPACE
 
-struct QDeclarativeCameraPreviewProviderPrivate
+/*
+    Recent previews are kept in a small cache, most recently registered
+    first, so galleries showing thumbnails of the last few captures do not
+    fall back to blank images.
+
+    Each preview is stored with a chain of mip levels, each half the size
+    of the previous one, built once with a 2x2 box filter when the preview
+    is registered. A request is served from the smallest level that is at
+    least the requested size, so repeated thumbnail requests either return
+    a stored level directly or scale down by less than a factor of two.
+
+    Entries are immutable once built; the mutex only guards swapping the
+    shared pointers, and all scaling happens without holding it.
+*/
+struct QDeclarativeCameraPreview
 {
     QString id;
-    QImage image;
-    QMutex mutex;
+    QVector<QImage> levels;
+};
+
+typedef QSharedPointer<const QDeclarativeCameraPreview> QDeclarativeCameraPreviewPointer;
+
+enum {
+    DefaultPreviewCacheSize = 8,
+    MaximumMipLevels = 5,
+    MinimumMipLevelSize = 32
+};
+
+struct QDeclarativeCameraPreviewProviderPrivate
+{
+    QDeclarativeCameraPreviewProviderPrivate()
+        : capacity(DefaultPreviewCacheSize)
+    {
+        bool ok = false;
+        const int size = qgetenv("QT_CAMERA_PREVIEW_CACHE_SIZE").toInt(&ok);
+        if (ok && size > 0)
+            capacity = size;
+    }
+
+    QDeclarativeCameraPreviewPointer find(const QString &id) const
+    {
+        QMutexLocker lock(&mutex);
+        foreach (const QDeclarativeCameraPreviewPointer &preview, previews) {
+            if (preview->id == id)
+                return preview;
+        }
+        return QDeclarativeCameraPreviewPointer();
+    }
+
+    QList<QDeclarativeCameraPreviewPointer> previews;
+    int capacity;
+    mutable QMutex mutex;
+
+    QAtomicInt requests;
+    QAtomicInt hits;
+    QAtomicInt exactHits;
 };
 
 Q_GLOBAL_STATIC(QDeclarativeCameraPreviewProviderPrivate, qDeclarativeCameraPreviewProviderPrivate)
 
+// Averages each 2x2 block of a 32 bit image, two channels at a time.
+static QImage qt_halfSizeBoxFiltered(const QImage &image)
+{
+    const int width = image.width() / 2;
+    const int height = image.height() / 2;
+    QImage result(width, height, image.format());
+
+    for (int y = 0; y < height; ++y) {
+        const quint32 *line0 = reinterpret_cast<const quint32 *>(image.constScanLine(2 * y));
+        const quint32 *line1 = reinterpret_cast<const quint32 *>(image.constScanLine(2 * y + 1));
+        quint32 *out = reinterpret_cast<quint32 *>(result.scanLine(y));
+
+        for (int x = 0; x < width; ++x) {
+            const quint32 p0 = line0[2 * x];
+            const quint32 p1 = line0[2 * x + 1];
+            const quint32 p2 = line1[2 * x];
+            const quint32 p3 = line1[2 * x + 1];
+
+            const quint32 rb = (p0 & 0x00ff00ff) + (p1 & 0x00ff00ff)
+                    + (p2 & 0x00ff00ff) + (p3 & 0x00ff00ff) + 0x00020002;
+            const quint32 ag = ((p0 >> 8) & 0x00ff00ff) + ((p1 >> 8) & 0x00ff00ff)
+                    + ((p2 >> 8) & 0x00ff00ff) + ((p3 >> 8) & 0x00ff00ff) + 0x00020002;
+
+            out[x] = ((rb >> 2) & 0x00ff00ff) | (((ag >> 2) & 0x00ff00ff) << 8);
+        }
+    }
+
+    return result;
+}
+
+static QDeclarativeCameraPreviewPointer qt_buildPreview(const QString &id, const QImage &image)
+{
+    QDeclarativeCameraPreview *preview = new QDeclarativeCameraPreview;
+    preview->id = id;
+    preview->levels.append(image);
+
+    if (!image.isNull()) {
+        // Averaging premultiplied pixels keeps the filter correct for translucent previews.
+        QImage level = image.convertToFormat(image.hasAlphaChannel()
+                                             ? QImage::Format_ARGB32_Premultiplied
+                                             : QImage::Format_RGB32);
+
+        while (preview->levels.size() < MaximumMipLevels
+               && qMin(level.width(), level.height()) / 2 >= MinimumMipLevelSize) {
+            level = qt_halfSizeBoxFiltered(level);
+            preview->levels.append(level);
+        }
+    }
+
+    return QDeclarativeCameraPreviewPointer(preview);
+}
+
 QDeclarativeCameraPreviewProvider::QDeclarativeCameraPreviewProvider()
 : QQuickImageProvider(QQuickImageProvider::Image)
 {
@@ -54,22 +160,50 @@ QDeclarativeCameraPreviewProvider::QDeclarativeCameraPreviewProvider()
 QDeclarativeCameraPreviewProvider::~QDeclarativeCameraPreviewProvider()
 {
     QDeclarativeCameraPreviewProviderPrivate *d = qDeclarativeCameraPreviewProviderPrivate();
+
+    if (qgetenv("QT_CAMERA_PREVIEW_CACHE_DEBUG").toInt() > 0) {
+        const Statistics stats = statistics();
+        qDebug() << "Camera preview cache:" << stats.requests << "requests,"
+                 << stats.hitRate() * 100 << "% hits," << stats.exactHits << "served without scaling";
+    }
+
+    QList<QDeclarativeCameraPreviewPointer> previews;
     QMutexLocker lock(&d->mutex);
-    d->id.clear();
-    d->image = QImage();
+    previews.swap(d->previews);
+    lock.unlock();
 }
 
 QImage QDeclarativeCameraPreviewProvider::requestImage(const QString &id, QSize *size, const QSize& requestedSize)
 {
     QDeclarativeCameraPreviewProviderPrivate *d = qDeclarativeCameraPreviewProviderPrivate();
-    QMutexLocker lock(&d->mutex);
+    d->requests.ref();
 
-    if (d->id != id)
+    const QDeclarativeCameraPreviewPointer preview = d->find(id);
+    if (!preview)
         return QImage();
 
-    QImage res = d->image;
-    if (!requestedSize.isEmpty())
-        res = res.scaled(requestedSize, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+    d->hits.ref();
+
+    QImage res = preview->levels.first();
+    if (!requestedSize.isEmpty() && !res.isNull()) {
+        const QSize targetSize = res.size().scaled(requestedSize, Qt::KeepAspectRatio);
+
+        // The smallest level that does not need to be scaled up
+        int level = 0;
+        while (level + 1 < preview->levels.size()
+               && preview->levels.at(level + 1).width() >= targetSize.width()
+               && preview->levels.at(level + 1).height() >= targetSize.height()) {
+            ++level;
+        }
+
+        res = preview->levels.at(level);
+        if (res.size() == targetSize)
+            d->exactHits.ref();
+        else
+            res = res.scaled(targetSize, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+    } else {
+        d->exactHits.ref();
+    }
 
     if (size)
         *size = res.size();
@@ -79,11 +213,43 @@ QImage QDeclarativeCameraPreviewProvider::requestImage(const QString &id, QSize
 
 void QDeclarativeCameraPreviewProvider::registerPreview(const QString &id, const QImage &preview)
 {
-    //only the last preview is kept
     QDeclarativeCameraPreviewProviderPrivate *d = qDeclarativeCameraPreviewProviderPrivate();
+
+    // Build the levels before taking the lock so readers are never blocked on it.
+    const QDeclarativeCameraPreviewPointer entry = qt_buildPreview(id, preview);
+
+    QList<QDeclarativeCameraPreviewPointer> evicted;
     QMutexLocker lock(&d->mutex);
-    d->id = id;
-    d->image = preview;
+    for (int i = d->previews.size() - 1; i >= 0; --i) {
+        if (d->previews.at(i)->id == id)
+            evicted.append(d->previews.takeAt(i));
+    }
+    d->previews.prepend(entry);
+    while (d->previews.size() > d->capacity)
+        evicted.append(d->previews.takeLast());
+    lock.unlock();
+}
+
+/*
+    Returns the request counters collected since the last resetStatistics().
+*/
+QDeclarativeCameraPreviewProvider::Statistics QDeclarativeCameraPreviewProvider::statistics()
+{
+    QDeclarativeCameraPreviewProviderPrivate *d = qDeclarativeCameraPreviewProviderPrivate();
+
+    Statistics stats;
+    stats.requests = d->requests.load();
+    stats.hits = d->hits.load();
+    stats.exactHits = d->exactHits.load();
+    return stats;
+}
+
+void QDeclarativeCameraPreviewProvider::resetStatistics()
+{
+    QDeclarativeCameraPreviewProviderPrivate *d = qDeclarativeCameraPreviewProviderPrivate();
+    d->requests.store(0);
+    d->hits.store(0);
+    d->exactHits.store(0);
 }
 
 QT_END_NAMESPACE
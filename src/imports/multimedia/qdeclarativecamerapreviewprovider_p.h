@@ -52,11 +52,25 @@ QT_BEGIN_NAMESPACE
 class QDeclarativeCameraPreviewProvider : public QQuickImageProvider
 {
 public:
+    struct Statistics
+    {
+        Statistics() : requests(0), hits(0), exactHits(0) {}
+
+        qreal hitRate() const { return requests > 0 ? qreal(hits) / requests : 0; }
+
+        int requests;   // all requests
+        int hits;       // requests for a preview still in the cache
+        int exactHits;  // hits served by a precomputed level without scaling
+    };
+
     QDeclarativeCameraPreviewProvider();
     ~QDeclarativeCameraPreviewProvider();
 
     virtual QImage requestImage(const QString &id, QSize *size, const QSize& requestedSize);
     static void registerPreview(const QString &id, const QImage &preview);
+
+    static Statistics statistics();
+    static void resetStatistics();
 };
 
 QT_END_NAMESPACE
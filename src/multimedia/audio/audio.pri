@@ -19,7 +19,10 @@ PRIVATE_HEADERS += \
            audio/qaudiodevicefactory_p.h \
            audio/qwavedecoder_p.h \
            audio/qsamplecache_p.h \
-           audio/qaudiohelpers_p.h
+           audio/qaudiohelpers_p.h \
+           audio/qaudioringbuffer_p.h \
+           audio/qaudioproberingbuffer_p.h \
+           audio/qsoundeffectmixer_p.h
 
 SOURCES += \
            audio/qaudio.cpp \
@@ -36,8 +39,13 @@ SOURCES += \
            audio/qsound.cpp \
            audio/qaudiobuffer.cpp \
            audio/qaudioprobe.cpp \
+           audio/qaudioproberingbuffer_p.cpp \
            audio/qaudiodecoder.cpp \
-           audio/qaudiohelpers.cpp
+           audio/qaudiohelpers.cpp \
+           audio/qsoundeffectmixer_p.cpp
+
+SSE2_SOURCES += audio/qsoundeffectmixer_sse2.cpp
+NEON_SOURCES += audio/qsoundeffectmixer_neon.cpp
 
 unix:!mac {
     config_pulseaudio {
@@ -32,6 +32,8 @@
 ****************************************************************************/
 
 #include <QtCore/qdebug.h>
+#include <QtCore/qrunnable.h>
+#include <QtCore/qthreadpool.h>
 
 #include "qaudiosystem.h"
 #include "qaudiosystemplugin.h"
@@ -114,61 +116,227 @@ public:
     QAudioFormat format() const { return QAudioFormat(); }
 };
 
-QList<QAudioDeviceInfo> QAudioDeviceFactory::availableDevices(QAudio::Mode mode)
+/*
+    The registry remembers the device handles of every audio plugin that
+    announces hotplug events through an availableDevicesChanged() signal, so
+    listing the devices of those backends does not query the audio system
+    again. When such a plugin signals a change, its handles are queried again
+    on a worker thread and availableDevicesChanged() is emitted for every mode
+    whose list differs. Plugins without the signal are queried on every call.
+*/
+
+Q_GLOBAL_STATIC(QAudioDeviceRegistry, audioDeviceRegistry)
+Q_GLOBAL_STATIC(QThreadPool, audioDeviceRefreshPool)
+
+class QAudioDeviceRefresh : public QRunnable
 {
-    QList<QAudioDeviceInfo> devices;
+public:
+    explicit QAudioDeviceRefresh(QAudioDeviceRegistry *registry)
+        : m_registry(registry)
+    {
+    }
+
+    void run()
+    {
+        m_registry->refresh();
+    }
+
+private:
+    QAudioDeviceRegistry *m_registry;
+};
+
+QAudioDeviceRegistry::QAudioDeviceRegistry()
+    : m_populated(false)
+    , m_refreshRunning(false)
+    , m_refreshPending(false)
+{
+}
+
+QAudioDeviceRegistry::~QAudioDeviceRegistry()
+{
+}
+
+QAudioDeviceRegistry *QAudioDeviceRegistry::instance()
+{
+    return audioDeviceRegistry();
+}
+
+void QAudioDeviceRegistry::populate()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_populated)
+            return;
+    }
+
+    // Plugins are instantiated on the calling thread and queried without
+    // holding the lock, backends may emit availableDevicesChanged() from
+    // their own threads while they are set up.
+    QList<Backend> backends;
 #if !defined (QT_NO_LIBRARY) && !defined(QT_NO_SETTINGS)
     QMediaPluginLoader* l = audioLoader();
     foreach (const QString& key, l->keys()) {
-        QAudioSystemFactoryInterface* plugin = qobject_cast<QAudioSystemFactoryInterface*>(l->instance(key));
-        if (plugin) {
-            foreach (QByteArray const& handle, plugin->availableDevices(mode))
-                devices << QAudioDeviceInfo(key, handle, mode);
+        QObject *object = l->instance(key);
+        QAudioSystemFactoryInterface* plugin = qobject_cast<QAudioSystemFactoryInterface*>(object);
+        if (!plugin)
+            continue;
+
+        Backend backend;
+        backend.realm = key;
+        backend.plugin = plugin;
+        backend.cached = object->metaObject()->indexOfSignal("availableDevicesChanged()") != -1;
+        if (backend.cached) {
+            connect(object, SIGNAL(availableDevicesChanged()), this, SLOT(invalidate()),
+                    Qt::ConnectionType(Qt::DirectConnection | Qt::UniqueConnection));
+            backend.handles[QAudio::AudioInput] = plugin->availableDevices(QAudio::AudioInput);
+            backend.handles[QAudio::AudioOutput] = plugin->availableDevices(QAudio::AudioOutput);
         }
+        backends.append(backend);
     }
 #endif
 
+    QMutexLocker locker(&m_mutex);
+    if (!m_populated) {
+        m_backends = backends;
+        m_populated = true;
+    }
+}
+
+QList<QByteArray> QAudioDeviceRegistry::handles(const Backend &backend, QAudio::Mode mode) const
+{
+    return backend.cached ? backend.handles[mode] : backend.plugin->availableDevices(mode);
+}
+
+QList<QAudioDeviceInfo> QAudioDeviceRegistry::availableDevices(QAudio::Mode mode)
+{
+    populate();
+
+    m_mutex.lock();
+    const QList<Backend> backends = m_backends;
+    m_mutex.unlock();
+
+    QList<QAudioDeviceInfo> devices;
+    foreach (const Backend &backend, backends) {
+        foreach (const QByteArray &handle, handles(backend, mode))
+            devices << QAudioDeviceInfo(backend.realm, handle, mode);
+    }
+
     return devices;
 }
 
-QAudioDeviceInfo QAudioDeviceFactory::defaultInputDevice()
+QAudioDeviceInfo QAudioDeviceRegistry::defaultDevice(QAudio::Mode mode)
 {
-#if !defined (QT_NO_LIBRARY) && !defined(QT_NO_SETTINGS)
-    QAudioSystemFactoryInterface* plugin = qobject_cast<QAudioSystemFactoryInterface*>(audioLoader()->instance(defaultKey()));
-    if (plugin) {
-        QList<QByteArray> list = plugin->availableDevices(QAudio::AudioInput);
-        if (list.size() > 0)
-            return QAudioDeviceInfo(defaultKey(), list.at(0), QAudio::AudioInput);
+    populate();
+
+    m_mutex.lock();
+    const QList<Backend> backends = m_backends;
+    m_mutex.unlock();
+
+    foreach (const Backend &backend, backends) {
+        if (backend.realm == defaultKey()) {
+            const QList<QByteArray> list = handles(backend, mode);
+            if (!list.isEmpty())
+                return QAudioDeviceInfo(backend.realm, list.first(), mode);
+        }
     }
 
-    // if no plugin is marked as default or if the default plugin doesn't have any input device,
-    // return the first input available from other plugins.
-    QList<QAudioDeviceInfo> inputDevices = availableDevices(QAudio::AudioInput);
-    if (!inputDevices.isEmpty())
-        return inputDevices.first();
-#endif
+    // if no plugin is marked as default or if the default plugin doesn't have any device,
+    // return the first device available from other plugins.
+    foreach (const Backend &backend, backends) {
+        const QList<QByteArray> list = handles(backend, mode);
+        if (!list.isEmpty())
+            return QAudioDeviceInfo(backend.realm, list.first(), mode);
+    }
 
     return QAudioDeviceInfo();
 }
 
-QAudioDeviceInfo QAudioDeviceFactory::defaultOutputDevice()
+/*!
+    \internal
+
+    Queries the devices of the plugins that report hotplug events again on a
+    worker thread. Calls made while a refresh is running are coalesced into
+    a single follow-up refresh.
+*/
+void QAudioDeviceRegistry::invalidate()
 {
-#if !defined (QT_NO_LIBRARY) && !defined(QT_NO_SETTINGS)
-    QAudioSystemFactoryInterface* plugin = qobject_cast<QAudioSystemFactoryInterface*>(audioLoader()->instance(defaultKey()));
-    if (plugin) {
-        QList<QByteArray> list = plugin->availableDevices(QAudio::AudioOutput);
-        if (list.size() > 0)
-            return QAudioDeviceInfo(defaultKey(), list.at(0), QAudio::AudioOutput);
+    QMutexLocker locker(&m_mutex);
+    if (!m_populated)
+        return;
+
+    if (m_refreshRunning) {
+        m_refreshPending = true;
+        return;
     }
 
-    // if no plugin is marked as default or if the default plugin doesn't have any output device,
-    // return the first output available from other plugins.
-    QList<QAudioDeviceInfo> outputDevices = availableDevices(QAudio::AudioOutput);
-    if (!outputDevices.isEmpty())
-        return outputDevices.first();
-#endif
+    m_refreshRunning = true;
+    audioDeviceRefreshPool()->start(new QAudioDeviceRefresh(this));
+}
 
-    return QAudioDeviceInfo();
+void QAudioDeviceRegistry::refresh()
+{
+    forever {
+        m_mutex.lock();
+        m_refreshPending = false;
+        QList<Backend> backends = m_backends;
+        m_mutex.unlock();
+
+        for (int i = 0; i < backends.size(); ++i) {
+            Backend &backend = backends[i];
+            if (backend.cached) {
+                backend.handles[QAudio::AudioInput] = backend.plugin->availableDevices(QAudio::AudioInput);
+                backend.handles[QAudio::AudioOutput] = backend.plugin->availableDevices(QAudio::AudioOutput);
+            }
+        }
+
+        bool inputChanged = false;
+        bool outputChanged = false;
+
+        // The backend list is fixed once populated and refreshes never run
+        // concurrently, so the entries still line up.
+        m_mutex.lock();
+        for (int i = 0; i < backends.size(); ++i) {
+            Backend &backend = m_backends[i];
+            if (backend.handles[QAudio::AudioInput] != backends.at(i).handles[QAudio::AudioInput]) {
+                backend.handles[QAudio::AudioInput] = backends.at(i).handles[QAudio::AudioInput];
+                inputChanged = true;
+            }
+            if (backend.handles[QAudio::AudioOutput] != backends.at(i).handles[QAudio::AudioOutput]) {
+                backend.handles[QAudio::AudioOutput] = backends.at(i).handles[QAudio::AudioOutput];
+                outputChanged = true;
+            }
+        }
+        const bool pending = m_refreshPending;
+        if (!pending)
+            m_refreshRunning = false;
+        m_mutex.unlock();
+
+        if (inputChanged)
+            emit availableDevicesChanged(QAudio::AudioInput);
+        if (outputChanged)
+            emit availableDevicesChanged(QAudio::AudioOutput);
+
+        if (!pending)
+            return;
+    }
+}
+
+QList<QAudioDeviceInfo> QAudioDeviceFactory::availableDevices(QAudio::Mode mode)
+{
+    QAudioDeviceRegistry *registry = audioDeviceRegistry();
+    return registry ? registry->availableDevices(mode) : QList<QAudioDeviceInfo>();
+}
+
+QAudioDeviceInfo QAudioDeviceFactory::defaultInputDevice()
+{
+    QAudioDeviceRegistry *registry = audioDeviceRegistry();
+    return registry ? registry->defaultDevice(QAudio::AudioInput) : QAudioDeviceInfo();
+}
+
+QAudioDeviceInfo QAudioDeviceFactory::defaultOutputDevice()
+{
+    QAudioDeviceRegistry *registry = audioDeviceRegistry();
+    return registry ? registry->defaultDevice(QAudio::AudioOutput) : QAudioDeviceInfo();
 }
 
 QAbstractAudioDeviceInfo* QAudioDeviceFactory::audioDeviceInfo(const QString &realm, const QByteArray &handle, QAudio::Mode mode)
@@ -236,3 +404,4 @@ QAbstractAudioOutput* QAudioDeviceFactory::createOutputDevice(QAudioDeviceInfo c
 
 QT_END_NAMESPACE
 
+#include "moc_qaudiodevicefactory_p.cpp"
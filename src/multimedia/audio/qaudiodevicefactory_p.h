@@ -47,6 +47,8 @@
 
 #include <QtCore/qbytearray.h>
 #include <QtCore/qlist.h>
+#include <QtCore/qmutex.h>
+#include <QtCore/qobject.h>
 
 #include <qtmultimediadefs.h>
 #include <qmultimedia.h>
@@ -59,6 +61,7 @@ QT_BEGIN_NAMESPACE
 class QAbstractAudioInput;
 class QAbstractAudioOutput;
 class QAbstractAudioDeviceInfo;
+struct QAudioSystemFactoryInterface;
 
 class QAudioDeviceFactory
 {
@@ -80,6 +83,46 @@ public:
     static QAbstractAudioOutput* createNullOutput();
 };
 
+class Q_MULTIMEDIA_EXPORT QAudioDeviceRegistry : public QObject
+{
+    Q_OBJECT
+public:
+    QAudioDeviceRegistry();
+    ~QAudioDeviceRegistry();
+
+    static QAudioDeviceRegistry *instance();
+
+    QList<QAudioDeviceInfo> availableDevices(QAudio::Mode mode);
+    QAudioDeviceInfo defaultDevice(QAudio::Mode mode);
+
+public Q_SLOTS:
+    void invalidate();
+
+Q_SIGNALS:
+    void availableDevicesChanged(QAudio::Mode mode);
+
+private:
+    friend class QAudioDeviceRefresh;
+
+    struct Backend
+    {
+        QString realm;
+        QAudioSystemFactoryInterface *plugin;
+        bool cached;
+        QList<QByteArray> handles[2];
+    };
+
+    void populate();
+    QList<QByteArray> handles(const Backend &backend, QAudio::Mode mode) const;
+    void refresh();
+
+    QMutex m_mutex;
+    QList<Backend> m_backends;
+    bool m_populated;
+    bool m_refreshRunning;
+    bool m_refreshPending;
+};
+
 QT_END_NAMESPACE
 
 #endif // QAUDIODEVICEFACTORY_P_H
@@ -0,0 +1,377 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#include "qaudioproberingbuffer_p.h"
+
+#include "qmediaaudioprobecontrol.h"
+#include "qmediaobject.h"
+#include "qmediarecorder.h"
+#include "qmediaservice.h"
+
+#include <QtCore/qmath.h>
+#include <QtCore/qsysinfo.h>
+
+QT_BEGIN_NAMESPACE
+
+/*!
+    \class QAudioProbeRingBuffer
+    \internal
+
+    \brief The QAudioProbeRingBuffer class collects probed audio into a
+    preallocated ring buffer.
+
+    Unlike QAudioProbe, which delivers every probed buffer to the thread of
+    the probe as a signal, the ring buffer is written on the thread that
+    probes the media and may be read from any one other thread without
+    locking. Media services which provide an \c addRingBuffer() and
+    \c removeRingBuffer() invokable on their QMediaAudioProbeControl write
+    the samples directly from their streaming thread; for other services the
+    ring buffer is filled when the control emits audioBufferProbed().
+
+    When the ring buffer is full the remainder of a probed buffer is dropped
+    and overflowCount() is incremented. Optionally, peak and RMS levels of
+    every channel are summarized over a fixed number of frames, these
+    summaries are computed on the probing thread and queued in a second
+    ring buffer.
+*/
+
+template <typename T> static inline float qLevelSample(T value);
+
+template <> inline float qLevelSample<quint8>(quint8 value)
+{
+    return (int(value) - 128) / 128.0f;
+}
+
+template <> inline float qLevelSample<qint16>(qint16 value)
+{
+    return value / 32768.0f;
+}
+
+template <> inline float qLevelSample<qint32>(qint32 value)
+{
+    return value / 2147483648.0f;
+}
+
+template <> inline float qLevelSample<float>(float value)
+{
+    return value;
+}
+
+template <typename T>
+static void qAccumulateLevels(const char *data, int frames, int stride, int channels,
+                              float *peak, double *sumOfSquares)
+{
+    const T *samples = reinterpret_cast<const T *>(data);
+    for (int i = 0; i < frames; ++i) {
+        for (int c = 0; c < channels; ++c) {
+            const float value = qAbs(qLevelSample<T>(samples[c]));
+            if (value > peak[c])
+                peak[c] = value;
+            sumOfSquares[c] += value * value;
+        }
+        samples += stride;
+    }
+}
+
+/*!
+    Constructs a ring buffer holding up to \a capacity bytes of samples,
+    with the given \a parent.
+*/
+QAudioProbeRingBuffer::QAudioProbeRingBuffer(int capacity, QObject *parent)
+    : QObject(parent)
+    , m_direct(false)
+    , m_samples(capacity)
+    , m_sampleLayout(NoLevels)
+    , m_summaryInterval(0)
+{
+    m_summary.frameCount = 0;
+}
+
+QAudioProbeRingBuffer::~QAudioProbeRingBuffer()
+{
+    detach();
+}
+
+/*!
+    Starts collecting the audio of \a source.
+
+    Returns false if the media object does not support probing audio. A null
+    \a source detaches the ring buffer and returns true.
+*/
+bool QAudioProbeRingBuffer::setSource(QMediaObject *source)
+{
+    if (source && source == m_source.data() && m_control)
+        return true;
+
+    detach();
+
+    if (!source)
+        return true;
+
+    QMediaService *service = source->service();
+    QMediaAudioProbeControl *control = service
+            ? service->requestControl<QMediaAudioProbeControl*>()
+            : 0;
+    if (!control)
+        return false;
+
+    m_source = source;
+    m_control = control;
+    m_direct = control->metaObject()->indexOfMethod("addRingBuffer(QAudioProbeRingBuffer*)") != -1;
+    if (m_direct) {
+        QMetaObject::invokeMethod(control, "addRingBuffer", Qt::DirectConnection,
+                                  Q_ARG(QAudioProbeRingBuffer*, this));
+    } else {
+        connect(control, SIGNAL(audioBufferProbed(QAudioBuffer)),
+                this, SLOT(writeBuffer(QAudioBuffer)), Qt::DirectConnection);
+    }
+
+    return true;
+}
+
+/*!
+    Starts collecting the audio recorded by \a source.
+*/
+bool QAudioProbeRingBuffer::setSource(QMediaRecorder *source)
+{
+    return setSource(source ? source->mediaObject() : 0);
+}
+
+bool QAudioProbeRingBuffer::isActive() const
+{
+    return m_control != 0;
+}
+
+void QAudioProbeRingBuffer::detach()
+{
+    if (m_control) {
+        if (m_direct) {
+            QMetaObject::invokeMethod(m_control.data(), "removeRingBuffer", Qt::DirectConnection,
+                                      Q_ARG(QAudioProbeRingBuffer*, this));
+        } else {
+            disconnect(m_control.data(), SIGNAL(audioBufferProbed(QAudioBuffer)),
+                       this, SLOT(writeBuffer(QAudioBuffer)));
+        }
+        if (m_source && m_source.data()->service())
+            m_source.data()->service()->releaseControl(m_control.data());
+    }
+
+    m_source.clear();
+    m_control.clear();
+    m_direct = false;
+}
+
+/*!
+    Summarizes the levels of every \a frames frames of probed audio, keeping
+    up to \a capacity summaries until they are read. An interval of 0, the
+    default, disables the summaries.
+
+    Summaries are only computed for unsigned 8 bit, signed 16 and 32 bit and
+    32 bit floating point samples in the host byte order, and for at most
+    MaximumSummaryChannels channels. This can only be changed while the ring
+    buffer is not attached to a source.
+*/
+void QAudioProbeRingBuffer::setSummaryInterval(int frames, int capacity)
+{
+    if (isActive()) {
+        qWarning("QAudioProbeRingBuffer: the summary interval can't be changed while probing");
+        return;
+    }
+
+    m_summaryInterval = qMax(0, frames);
+    m_summaries.reset(m_summaryInterval > 0 ? qMax(1, capacity) * int(sizeof(LevelSummary)) : 0);
+    m_summary.frameCount = 0;
+}
+
+/*!
+    Returns the format of the most recently probed audio.
+
+    Samples probed before a format change may still be queued.
+*/
+QAudioFormat QAudioProbeRingBuffer::format() const
+{
+    QMutexLocker locker(&m_formatMutex);
+    return m_format;
+}
+
+/*!
+    Reads up to \a maxBytes bytes of samples into \a data and returns the
+    number of bytes read. Only whole frames are ever written to the ring
+    buffer, reading multiples of the frame size keeps frames intact.
+*/
+int QAudioProbeRingBuffer::read(char *data, int maxBytes)
+{
+    return m_samples.read(data, maxBytes);
+}
+
+int QAudioProbeRingBuffer::summariesAvailable() const
+{
+    return m_summaries.bytesAvailable() / int(sizeof(LevelSummary));
+}
+
+/*!
+    Takes the oldest level summary and stores it in \a summary. Returns
+    false if no summary is queued.
+*/
+bool QAudioProbeRingBuffer::readSummary(LevelSummary *summary)
+{
+    if (summariesAvailable() == 0)
+        return false;
+
+    m_summaries.read(reinterpret_cast<char *>(summary), sizeof(LevelSummary));
+    return true;
+}
+
+/*!
+    Discards all queued samples and summaries. This is a consumer side
+    operation.
+*/
+void QAudioProbeRingBuffer::clear()
+{
+    m_samples.clear();
+    m_summaries.clear();
+}
+
+/*!
+    Appends \a bytes bytes of \a data in \a format starting at \a startTime
+    microseconds. This is called on the probing thread.
+*/
+void QAudioProbeRingBuffer::write(const QAudioFormat &format, const char *data, int bytes, qint64 startTime)
+{
+    if (format != m_producerFormat) {
+        m_producerFormat = format;
+
+        m_sampleLayout = NoLevels;
+        if (format.byteOrder() == QAudioFormat::Endian(QSysInfo::ByteOrder)) {
+            if (format.sampleType() == QAudioFormat::UnSignedInt && format.sampleSize() == 8)
+                m_sampleLayout = UnsignedInt8;
+            else if (format.sampleType() == QAudioFormat::SignedInt && format.sampleSize() == 16)
+                m_sampleLayout = SignedInt16;
+            else if (format.sampleType() == QAudioFormat::SignedInt && format.sampleSize() == 32)
+                m_sampleLayout = SignedInt32;
+            else if (format.sampleType() == QAudioFormat::Float && format.sampleSize() == 32)
+                m_sampleLayout = Float32;
+        }
+        // A partial summary of the previous format is discarded.
+        m_summary.frameCount = 0;
+
+        QMutexLocker locker(&m_formatMutex);
+        m_format = format;
+    }
+
+    const int bytesPerFrame = format.bytesPerFrame();
+    if (bytesPerFrame <= 0 || !data)
+        return;
+
+    const int frames = bytes / bytesPerFrame;
+    if (m_summaryInterval > 0 && m_sampleLayout != NoLevels)
+        summarize(data, frames, startTime);
+
+    const int length = frames * bytesPerFrame;
+    const int free = (m_samples.bytesFree() / bytesPerFrame) * bytesPerFrame;
+    if (m_samples.write(data, qMin(length, free)) < length)
+        m_overflows.ref();
+}
+
+/*!
+    Appends the samples of \a buffer, used for media services which only
+    deliver probed audio through audioBufferProbed().
+*/
+void QAudioProbeRingBuffer::writeBuffer(const QAudioBuffer &buffer)
+{
+    write(buffer.format(), buffer.constData<char>(), buffer.byteCount(), buffer.startTime());
+}
+
+void QAudioProbeRingBuffer::summarize(const char *data, int frames, qint64 startTime)
+{
+    const int bytesPerFrame = m_producerFormat.bytesPerFrame();
+    const int stride = m_producerFormat.channelCount();
+    const int channels = qMin(stride, int(MaximumSummaryChannels));
+
+    while (frames > 0) {
+        if (m_summary.frameCount == 0) {
+            m_summary.startTime = startTime;
+            m_summary.channelCount = channels;
+            for (int c = 0; c < MaximumSummaryChannels; ++c) {
+                m_summary.peak[c] = 0;
+                m_summary.rms[c] = 0;
+                m_sumOfSquares[c] = 0;
+            }
+        }
+
+        const int count = qMin(frames, m_summaryInterval - m_summary.frameCount);
+        switch (m_sampleLayout) {
+        case UnsignedInt8:
+            qAccumulateLevels<quint8>(data, count, stride, channels, m_summary.peak, m_sumOfSquares);
+            break;
+        case SignedInt16:
+            qAccumulateLevels<qint16>(data, count, stride, channels, m_summary.peak, m_sumOfSquares);
+            break;
+        case SignedInt32:
+            qAccumulateLevels<qint32>(data, count, stride, channels, m_summary.peak, m_sumOfSquares);
+            break;
+        case Float32:
+            qAccumulateLevels<float>(data, count, stride, channels, m_summary.peak, m_sumOfSquares);
+            break;
+        default:
+            return;
+        }
+
+        m_summary.frameCount += count;
+        data += count * bytesPerFrame;
+        frames -= count;
+        if (startTime >= 0)
+            startTime += m_producerFormat.durationForFrames(count);
+
+        if (m_summary.frameCount == m_summaryInterval)
+            finishSummary();
+    }
+}
+
+void QAudioProbeRingBuffer::finishSummary()
+{
+    for (int c = 0; c < m_summary.channelCount; ++c)
+        m_summary.rms[c] = float(qSqrt(m_sumOfSquares[c] / m_summary.frameCount));
+
+    if (m_summaries.bytesFree() >= int(sizeof(LevelSummary)))
+        m_summaries.write(reinterpret_cast<const char *>(&m_summary), sizeof(LevelSummary));
+    else
+        m_droppedSummaries.ref();
+
+    m_summary.frameCount = 0;
+}
+
+QT_END_NAMESPACE
+
+#include "moc_qaudioproberingbuffer_p.cpp"
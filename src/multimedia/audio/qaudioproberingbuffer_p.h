@@ -0,0 +1,139 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#ifndef QAUDIOPROBERINGBUFFER_P_H
+#define QAUDIOPROBERINGBUFFER_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include <QtCore/qobject.h>
+#include <QtCore/qmutex.h>
+#include <QtCore/qpointer.h>
+
+#include <qtmultimediadefs.h>
+#include <qaudiobuffer.h>
+#include <qaudioformat.h>
+
+#include "qaudioringbuffer_p.h"
+
+QT_BEGIN_NAMESPACE
+
+class QMediaObject;
+class QMediaRecorder;
+class QMediaAudioProbeControl;
+
+class Q_MULTIMEDIA_EXPORT QAudioProbeRingBuffer : public QObject
+{
+    Q_OBJECT
+public:
+    enum { MaximumSummaryChannels = 8 };
+
+    struct LevelSummary
+    {
+        qint64 startTime;
+        int frameCount;
+        int channelCount;
+        float peak[MaximumSummaryChannels];
+        float rms[MaximumSummaryChannels];
+    };
+
+    explicit QAudioProbeRingBuffer(int capacity, QObject *parent = Q_NULLPTR);
+    ~QAudioProbeRingBuffer();
+
+    bool setSource(QMediaObject *source);
+    bool setSource(QMediaRecorder *source);
+
+    bool isActive() const;
+
+    void setSummaryInterval(int frames, int capacity = 64);
+    int summaryInterval() const { return m_summaryInterval; }
+
+    // Consumer side, may be used from any one thread.
+    QAudioFormat format() const;
+    int bytesAvailable() const { return m_samples.bytesAvailable(); }
+    int read(char *data, int maxBytes);
+
+    int summariesAvailable() const;
+    bool readSummary(LevelSummary *summary);
+
+    int overflowCount() const { return m_overflows.load(); }
+    int droppedSummaryCount() const { return m_droppedSummaries.load(); }
+
+    void clear();
+
+    // Producer side, called by the media service on its probing thread.
+    void write(const QAudioFormat &format, const char *data, int bytes, qint64 startTime);
+
+public Q_SLOTS:
+    void writeBuffer(const QAudioBuffer &buffer);
+
+private:
+    enum SampleLayout { NoLevels, UnsignedInt8, SignedInt16, SignedInt32, Float32 };
+
+    void detach();
+    void summarize(const char *data, int frames, qint64 startTime);
+    void finishSummary();
+
+    QPointer<QMediaObject> m_source;
+    QPointer<QMediaAudioProbeControl> m_control;
+    bool m_direct;
+
+    mutable QMutex m_formatMutex;
+    QAudioFormat m_format;
+
+    QAudioRingBuffer m_samples;
+    QAudioRingBuffer m_summaries;
+    QAtomicInt m_overflows;
+    QAtomicInt m_droppedSummaries;
+
+    // Producer state, only touched by the probing thread while attached.
+    QAudioFormat m_producerFormat;
+    SampleLayout m_sampleLayout;
+    int m_summaryInterval;
+    LevelSummary m_summary;
+    double m_sumOfSquares[MaximumSummaryChannels];
+};
+
+QT_END_NAMESPACE
+
+#endif // QAUDIOPROBERINGBUFFER_P_H
@@ -0,0 +1,190 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QAUDIORINGBUFFER_P_H
+#define QAUDIORINGBUFFER_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include <QtCore/qatomic.h>
+#include <QtCore/qbytearray.h>
+
+#include <string.h>
+
+QT_BEGIN_NAMESPACE
+
+// Single producer, single consumer byte ring buffer.
+//
+// One thread may write (write(), writeRegion()/commitWrite()) while another
+// reads (read(), readRegion()/releaseRead()) without any locking. The read and
+// write positions run over [0, 2 * capacity) so a full buffer can be told apart
+// from an empty one without wasting a byte, and the capacity does not have to be
+// a power of two; callers storing whole audio frames should pick a multiple of
+// the frame size so a region never ends in the middle of a frame.
+class QAudioRingBuffer
+{
+public:
+    explicit QAudioRingBuffer(int capacity = 0)
+    {
+        reset(capacity);
+    }
+
+    // Not thread safe, neither side may be active.
+    void reset(int capacity)
+    {
+        m_data.resize(qMax(0, capacity));
+        m_buffer = m_data.data();
+        m_readPos.store(0);
+        m_writePos.store(0);
+    }
+
+    int capacity() const { return m_data.size(); }
+
+    int bytesAvailable() const
+    {
+        return used(m_readPos.loadAcquire(), m_writePos.loadAcquire());
+    }
+
+    int bytesFree() const
+    {
+        return capacity() - bytesAvailable();
+    }
+
+    // Producer side.
+    char *writeRegion(int *length)
+    {
+        const int writePos = m_writePos.load();
+        const int free = capacity() - used(m_readPos.loadAcquire(), writePos);
+        const int index = offset(writePos);
+
+        *length = qMin(free, capacity() - index);
+        return m_buffer + index;
+    }
+
+    void commitWrite(int length)
+    {
+        m_writePos.storeRelease(advance(m_writePos.load(), length));
+    }
+
+    int write(const char *data, int length)
+    {
+        int written = 0;
+        while (written < length) {
+            int region = 0;
+            char *dest = writeRegion(&region);
+            region = qMin(region, length - written);
+            if (region <= 0)
+                break;
+
+            memcpy(dest, data + written, region);
+            commitWrite(region);
+            written += region;
+        }
+        return written;
+    }
+
+    // Consumer side.
+    char *readRegion(int *length)
+    {
+        const int readPos = m_readPos.load();
+        const int available = used(readPos, m_writePos.loadAcquire());
+        const int index = offset(readPos);
+
+        *length = qMin(available, capacity() - index);
+        return m_buffer + index;
+    }
+
+    void releaseRead(int length)
+    {
+        m_readPos.storeRelease(advance(m_readPos.load(), length));
+    }
+
+    int read(char *data, int length)
+    {
+        int copied = 0;
+        while (copied < length) {
+            int region = 0;
+            const char *src = readRegion(&region);
+            region = qMin(region, length - copied);
+            if (region <= 0)
+                break;
+
+            memcpy(data + copied, src, region);
+            releaseRead(region);
+            copied += region;
+        }
+        return copied;
+    }
+
+    // Consumer side, discards everything written so far.
+    void clear()
+    {
+        m_readPos.storeRelease(m_writePos.loadAcquire());
+    }
+
+private:
+    int used(int readPos, int writePos) const
+    {
+        const int difference = writePos - readPos;
+        return difference < 0 ? difference + 2 * capacity() : difference;
+    }
+
+    int offset(int pos) const
+    {
+        return pos < capacity() ? pos : pos - capacity();
+    }
+
+    int advance(int pos, int length) const
+    {
+        pos += length;
+        return pos < 2 * capacity() ? pos : pos - 2 * capacity();
+    }
+
+    QByteArray m_data;
+    char *m_buffer;
+    QAtomicInt m_readPos;
+    QAtomicInt m_writePos;
+};
+
+QT_END_NAMESPACE
+
+#endif // QAUDIORINGBUFFER_P_H
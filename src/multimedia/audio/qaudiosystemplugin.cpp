@@ -62,6 +62,13 @@ QAudioSystemFactoryInterface::~QAudioSystemFactoryInterface()
     { "Keys": [ "default" ] }
     \endcode
 
+    A plugin that declares a signal with the signature
+    \c{availableDevicesChanged()} and emits it whenever devices are added,
+    removed or the default device changes has its device list cached by
+    QtMultimedia; availableDevices() is then only called again after the
+    signal has been emitted, and from a worker thread. Plugins without the
+    signal are queried every time the devices are listed.
+
     Unit tests are available to help in debugging new plugins.
 
     \sa QAbstractAudioDeviceInfo, QAbstractAudioOutput, QAbstractAudioInput
@@ -39,6 +39,9 @@
 #include <QtNetwork/QNetworkRequest>
 
 #include <QtCore/QDebug>
+#include <QtCore/QFile>
+
+#include <limits>
 //#define QT_SAMPLECACHE_DEBUG
 
 QT_BEGIN_NAMESPACE
@@ -87,36 +90,92 @@ QT_BEGIN_NAMESPACE
            m_sample = 0;
        }
     \endcode
+
+    Samples are loaded by a small pool of loading threads. Requests are queued by
+    priority and dispatched to the first idle loader, so a sample that is needed
+    right away can be requested with QSampleCache::HighPriority, or promoted with
+    setLoadPriority() while it is still waiting, to get ahead of a large batch of
+    background requests. The number of loading threads defaults to the ideal
+    thread count (at most 4) and can be changed with setLoadingThreadCount() or
+    the QT_SAMPLECACHE_LOADING_THREADS environment variable.
+
+    When a capacity is set, unreferenced samples stay cached and the least
+    recently used ones are unloaded first once the capacity is exceeded.
+
+    Local files at least mappingThreshold() bytes large are not read into the
+    heap: the file is memory mapped and the sample data refers directly to its
+    PCM data chunk. The mapping is shared and read only, so every process and
+    cache playing the same file uses the same pages of the page cache. The
+    threshold defaults to 256 KiB and can be changed with setMappingThreshold()
+    or the QT_SAMPLECACHE_MAP_THRESHOLD environment variable, a negative value
+    disables mapping.
 */
 
+static const int qSampleCacheMaxDefaultThreads = 4;
+static const int qSampleCachePriorityShift = 56;
+static const quint64 qSampleCacheSequenceMask = (Q_UINT64_C(1) << qSampleCachePriorityShift) - 1;
+
+static const qint64 qSampleCacheDefaultMapThreshold = 256 * 1024;
+
+static qint64 qSampleCacheDefaultMapThreshold_env()
+{
+    bool ok = false;
+    const qint64 threshold = qgetenv("QT_SAMPLECACHE_MAP_THRESHOLD").toLongLong(&ok);
+    return ok ? threshold : qSampleCacheDefaultMapThreshold;
+}
+
+static int qSampleCacheDefaultThreadCount()
+{
+    bool ok = false;
+    const int count = qgetenv("QT_SAMPLECACHE_LOADING_THREADS").toInt(&ok);
+    if (ok && count > 0)
+        return count;
+    return qBound(1, QThread::idealThreadCount(), qSampleCacheMaxDefaultThreads);
+}
+
+static inline quint64 qSampleCacheQueueKey(QSampleCache::LoadPriority priority, quint64 sequence)
+{
+    // Higher priorities sort first, requests of equal priority keep their order
+    return (quint64(QSampleCache::HighPriority - priority) << qSampleCachePriorityShift)
+            | (sequence & qSampleCacheSequenceMask);
+}
+
 QSampleCache::QSampleCache(QObject *parent)
     : QObject(parent)
-    , m_networkAccessManager(0)
+    , m_lruCounter(0)
     , m_mutex(QMutex::Recursive)
     , m_capacity(0)
     , m_usage(0)
+    , m_mappingThreshold(qSampleCacheDefaultMapThreshold_env())
+    , m_loadSequence(0)
+    , m_loadingThreadCount(qSampleCacheDefaultThreadCount())
     , m_loadingRefCount(0)
 {
-    m_loadingThread.setObjectName(QLatin1String("QSampleCache::LoadingThread"));
-    connect(&m_loadingThread, SIGNAL(finished()), this, SIGNAL(isLoadingChanged()));
-    connect(&m_loadingThread, SIGNAL(started()), this, SIGNAL(isLoadingChanged()));
 }
 
+// Called in loading threads, each of them gets its own manager which is
+// deleted when the thread finishes.
 QNetworkAccessManager& QSampleCache::networkAccessManager()
 {
-    if (!m_networkAccessManager)
-        m_networkAccessManager = new QNetworkAccessManager();
-    return *m_networkAccessManager;
+    if (!m_networkAccessManagers.hasLocalData())
+        m_networkAccessManagers.setLocalData(new QNetworkAccessManager());
+    return *m_networkAccessManagers.localData();
 }
 
 QSampleCache::~QSampleCache()
 {
-    QMutexLocker m(&m_mutex);
+    // Stop the loaders before locking, samples deleted while they finish
+    // need to remove themselves from m_staleSamples.
+    for (int i = 0; i < m_loaders.size(); ++i) {
+        if (QThread *thread = m_loaders.at(i).thread) {
+            thread->quit();
+            thread->wait();
+        }
+    }
 
-    m_loadingThread.quit();
-    m_loadingThread.wait();
+    QMutexLocker m(&m_mutex);
 
-    // Killing the loading thread means that no samples can be
+    // Killing the loading threads means that no samples can be
     // deleted using deleteLater.  And some samples that had deleteLater
     // already called won't have been processed (m_staleSamples)
     foreach (QSample* sample, m_samples)
@@ -125,22 +184,71 @@ QSampleCache::~QSampleCache()
     foreach (QSample* sample, m_staleSamples)
         delete sample; // deleting a sample does affect the m_staleSamples list, but foreach copies it
 
-    m_networkAccessManager->deleteLater();
+    for (int i = 0; i < m_loaders.size(); ++i)
+        delete m_loaders.at(i).thread;
+}
+
+qint64 QSampleCache::mappingThreshold() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_mappingThreshold;
+}
+
+// Only affects samples loaded afterwards
+void QSampleCache::setMappingThreshold(qint64 threshold)
+{
+    QMutexLocker locker(&m_mutex);
+    m_mappingThreshold = threshold;
+}
+
+int QSampleCache::loadingThreadCount() const
+{
+    QMutexLocker locker(&m_loadingMutex);
+    return m_loadingThreadCount;
+}
+
+// Called in application thread
+void QSampleCache::setLoadingThreadCount(int count)
+{
+    {
+        QMutexLocker locker(&m_loadingMutex);
+        count = qMax(1, count);
+        if (m_loadingThreadCount == count)
+            return;
+        m_loadingThreadCount = count;
+    }
+    dispatchLoads();
+}
+
+// Called in both threads
+void QSampleCache::loadingAcquire()
+{
+    QMutexLocker locker(&m_loadingMutex);
+    if (m_loadingRefCount++ == 0)
+        QMetaObject::invokeMethod(this, "isLoadingChanged", Qt::QueuedConnection);
 }
 
+// Called in both threads
 void QSampleCache::loadingRelease()
 {
     QMutexLocker locker(&m_loadingMutex);
     m_loadingRefCount--;
     if (m_loadingRefCount == 0) {
-        if (m_loadingThread.isRunning())
-            m_loadingThread.exit();
+        for (int i = 0; i < m_loaders.size(); ++i) {
+            Loader &loader = m_loaders[i];
+            if (loader.thread && loader.thread->isRunning()) {
+                loader.thread->exit();
+                loader.exiting = true;
+            }
+        }
+        QMetaObject::invokeMethod(this, "isLoadingChanged", Qt::QueuedConnection);
     }
 }
 
 bool QSampleCache::isLoading() const
 {
-    return m_loadingThread.isRunning();
+    QMutexLocker locker(&m_loadingMutex);
+    return m_loadingRefCount > 0;
 }
 
 bool QSampleCache::isCached(const QUrl &url) const
@@ -149,37 +257,159 @@ bool QSampleCache::isCached(const QUrl &url) const
     return m_samples.contains(url);
 }
 
-QSample* QSampleCache::requestSample(const QUrl& url)
+QSample* QSampleCache::requestSample(const QUrl& url, LoadPriority priority)
 {
-    //lock and add first to make sure live loadingThread will not be killed during this function call
-    m_loadingMutex.lock();
-    m_loadingRefCount++;
-    m_loadingMutex.unlock();
-
-    if (!m_loadingThread.isRunning())
-        m_loadingThread.start();
+    //lock and add first to make sure live loading threads will not be stopped during this function call
+    loadingAcquire();
 
 #ifdef QT_SAMPLECACHE_DEBUG
-    qDebug() << "QSampleCache: request sample [" << url << "]";
+    qDebug() << "QSampleCache: request sample [" << url << "]" << priority;
 #endif
     QMutexLocker locker(&m_mutex);
-    QMap<QUrl, QSample*>::iterator it = m_samples.find(url);
+    QHash<QUrl, QSample*>::iterator it = m_samples.find(url);
     QSample* sample;
     if (it == m_samples.end()) {
         sample = new QSample(url, this);
         m_samples.insert(url, sample);
-        sample->moveToThread(&m_loadingThread);
     } else {
         sample = *it;
     }
 
+    if (sample->m_lruKey) {
+        m_unusedSamples.remove(sample->m_lruKey);
+        sample->m_lruKey = 0;
+    }
+
     sample->addRef();
     locker.unlock();
 
-    sample->loadIfNecessary();
+    if (sample->loadIfNecessary())
+        enqueueLoad(sample, priority);
+    else
+        loadingRelease();
     return sample;
 }
 
+// Called in application thread
+void QSampleCache::setLoadPriority(QSample *sample, LoadPriority priority)
+{
+    QMutexLocker locker(&m_loadingMutex);
+    if (!sample->m_queueKey)
+        return; // already loading or loaded
+
+    const quint64 key = qSampleCacheQueueKey(priority, sample->m_queueKey);
+    if (key == sample->m_queueKey)
+        return;
+    m_pendingLoads.remove(sample->m_queueKey);
+    m_pendingLoads.insert(key, sample);
+    sample->m_queueKey = key;
+}
+
+// Called in application thread
+void QSampleCache::enqueueLoad(QSample *sample, LoadPriority priority)
+{
+    {
+        QMutexLocker locker(&m_loadingMutex);
+        sample->m_queueKey = qSampleCacheQueueKey(priority, ++m_loadSequence);
+        m_pendingLoads.insert(sample->m_queueKey, sample);
+    }
+    dispatchLoads();
+}
+
+// Called in application thread, samples can only be pushed to a loader from the
+// thread they live in.
+void QSampleCache::dispatchLoads()
+{
+    // Loaders asked to exit when loading went idle must finish before they are
+    // restarted. Wait unlocked, samples deleted on the way out lock m_mutex.
+    QList<QThread*> exitingThreads;
+    m_loadingMutex.lock();
+    for (int i = 0; i < m_loaders.size(); ++i) {
+        if (m_loaders.at(i).exiting) {
+            exitingThreads.append(m_loaders.at(i).thread);
+            m_loaders[i].exiting = false;
+        }
+    }
+    m_loadingMutex.unlock();
+    foreach (QThread *thread, exitingThreads)
+        thread->wait();
+
+    QMutexLocker locker(&m_loadingMutex);
+    if (m_loaders.size() < m_loadingThreadCount)
+        m_loaders.resize(m_loadingThreadCount);
+
+    while (!m_pendingLoads.isEmpty()) {
+        QSample *sample = m_pendingLoads.begin().value();
+
+        // A sample reloaded after an error already lives in its loader
+        int index = sample->m_loaderIndex;
+        if (index < 0) {
+            for (int i = 0; i < m_loadingThreadCount; ++i) {
+                if (m_loaders.at(i).activeLoads == 0) {
+                    index = i;
+                    break;
+                }
+            }
+            if (index < 0)
+                break; // all loaders are busy
+        }
+
+        m_pendingLoads.erase(m_pendingLoads.begin());
+        sample->m_queueKey = 0;
+        sample->m_dispatched = true;
+
+        Loader &loader = m_loaders[index];
+        if (!loader.thread) {
+            loader.thread = new QThread;
+            loader.thread->setObjectName(QLatin1String("QSampleCache::LoadingThread"));
+        }
+        if (!loader.thread->isRunning())
+            loader.thread->start();
+        if (sample->m_loaderIndex < 0) {
+            sample->m_loaderIndex = index;
+            sample->moveToThread(loader.thread);
+        }
+        ++loader.activeLoads;
+
+        QMetaObject::invokeMethod(sample, "load", Qt::QueuedConnection);
+    }
+}
+
+// Called in loading thread when a sample is done, successfully or not
+void QSampleCache::loadFinished(QSample *sample)
+{
+    {
+        QMutexLocker locker(&m_loadingMutex);
+        if (!sample->m_dispatched)
+            return;
+        sample->m_dispatched = false;
+        --m_loaders[sample->m_loaderIndex].activeLoads;
+        if (!m_pendingLoads.isEmpty())
+            QMetaObject::invokeMethod(this, "dispatchLoads", Qt::QueuedConnection);
+    }
+    loadingRelease();
+}
+
+// Called in both threads, when a sample that might still be queued or loading is deleted
+void QSampleCache::cancelLoad(QSample *sample)
+{
+    {
+        QMutexLocker locker(&m_loadingMutex);
+        if (sample->m_queueKey) {
+            m_pendingLoads.remove(sample->m_queueKey);
+            sample->m_queueKey = 0;
+        } else if (sample->m_dispatched) {
+            sample->m_dispatched = false;
+            --m_loaders[sample->m_loaderIndex].activeLoads;
+            if (!m_pendingLoads.isEmpty())
+                QMetaObject::invokeMethod(this, "dispatchLoads", Qt::QueuedConnection);
+        } else {
+            return;
+        }
+    }
+    loadingRelease();
+}
+
 void QSampleCache::setCapacity(qint64 capacity)
 {
     QMutexLocker locker(&m_mutex);
@@ -189,14 +419,12 @@ void QSampleCache::setCapacity(qint64 capacity)
     qDebug() << "QSampleCache: capacity changes from " << m_capacity << "to " << capacity;
 #endif
     if (m_capacity > 0 && capacity <= 0) { //memory management strategy changed
-        for (QMap<QUrl, QSample*>::iterator it = m_samples.begin(); it != m_samples.end();) {
-            QSample* sample = *it;
-            if (sample->m_ref == 0) {
-                unloadSample(sample);
-                it = m_samples.erase(it);
-            } else
-                it++;
+        foreach (QSample *sample, m_unusedSamples) {
+            sample->m_lruKey = 0;
+            m_samples.remove(sample->m_url);
+            unloadSample(sample);
         }
+        m_unusedSamples.clear();
     }
 
     m_capacity = capacity;
@@ -223,18 +451,17 @@ void QSampleCache::refresh(qint64 usageChange)
     qint64 recoveredSize = 0;
 #endif
 
-    //free unused samples to keep usage under capacity limit.
-    for (QMap<QUrl, QSample*>::iterator it = m_samples.begin(); it != m_samples.end();) {
+    //free least recently used samples to keep usage under capacity limit.
+    QMap<quint64, QSample*>::iterator it = m_unusedSamples.begin();
+    while (it != m_unusedSamples.end()) {
         QSample* sample = *it;
-        if (sample->m_ref > 0) {
-            ++it;
-            continue;
-        }
+        it = m_unusedSamples.erase(it);
+        sample->m_lruKey = 0;
 #ifdef QT_SAMPLECACHE_DEBUG
         recoveredSize += sample->m_soundData.size();
 #endif
+        m_samples.remove(sample->m_url);
         unloadSample(sample);
-        it = m_samples.erase(it);
         if (m_usage <= m_capacity)
             return;
     }
@@ -261,6 +488,7 @@ void QSampleCache::removeUnreferencedSample(QSample *sample)
 QSample::~QSample()
 {
     // Remove ourselves from our parent
+    m_parent->cancelLoad(this);
     m_parent->removeUnreferencedSample(this);
 
     QMutexLocker locker(&m_mutex);
@@ -268,26 +496,32 @@ QSample::~QSample()
     qDebug() << "~QSample" << this << ": deleted [" << m_url << "]" << QThread::currentThread();
 #endif
     cleanup();
+
+    // Drop the raw data before the mapping goes away
+    m_soundData.clear();
+    delete m_mappedFile;
 }
 
 // Called in application thread
-void QSample::loadIfNecessary()
+bool QSample::loadIfNecessary()
 {
     QMutexLocker locker(&m_mutex);
     if (m_state == QSample::Error || m_state == QSample::Creating) {
         m_state = QSample::Loading;
-        QMetaObject::invokeMethod(this, "load", Qt::QueuedConnection);
-    } else {
-        qobject_cast<QSampleCache*>(m_parent)->loadingRelease();
+        return true;
     }
+    return false;
 }
 
 // Called in both threads
 bool QSampleCache::notifyUnreferencedSample(QSample* sample)
 {
     QMutexLocker locker(&m_mutex);
-    if (m_capacity > 0)
+    if (m_capacity > 0) {
+        sample->m_lruKey = ++m_lruCounter;
+        m_unusedSamples.insert(sample->m_lruKey, sample);
         return false;
+    }
     m_samples.remove(sample->m_url);
     unloadSample(sample);
     return true;
@@ -311,7 +545,7 @@ void QSample::cleanup()
 {
     if (m_waveDecoder)
         m_waveDecoder->deleteLater();
-    if (m_stream)
+    if (m_stream && m_stream != m_mappedFile)
         m_stream->deleteLater();
 
     m_waveDecoder = 0;
@@ -353,6 +587,15 @@ void QSample::decoderReady()
 #endif
     m_parent->refresh(m_waveDecoder->size());
 
+    if (m_mappedFile) {
+        if (mapData()) {
+            onReady();
+            return;
+        }
+        // Could not map, read the file like any other stream
+        m_mappedFile = 0;
+    }
+
     m_soundData.resize(m_waveDecoder->size());
     m_sampleReadLength = 0;
     qint64 read = m_waveDecoder->read(m_soundData.data(), m_waveDecoder->size());
@@ -362,6 +605,31 @@ void QSample::decoderReady()
         onReady();
 }
 
+// Called in loading thread, locked.
+// Points the sample data at the PCM chunk of the mapped file instead of copying it.
+bool QSample::mapData()
+{
+    const qint64 offset = m_waveDecoder->dataOffset();
+    if (offset < 0)
+        return false;
+
+    // The data chunk of a truncated file claims more than there is
+    const qint64 size = qMin(m_waveDecoder->size(), m_mappedFile->size() - offset);
+    if (size <= 0 || size > std::numeric_limits<int>::max())
+        return false;
+
+    uchar *data = m_mappedFile->map(offset, size);
+    if (!data)
+        return false;
+
+    m_soundData = QByteArray::fromRawData(reinterpret_cast<const char *>(data), int(size));
+    m_sampleReadLength = size;
+
+    // The mapping outlives the file handle
+    m_mappedFile->close();
+    return true;
+}
+
 // Called in all threads
 QSample::State QSample::state() const
 {
@@ -377,8 +645,21 @@ void QSample::load()
 #ifdef QT_SAMPLECACHE_DEBUG
     qDebug() << "QSample: load [" << m_url << "]";
 #endif
-    m_stream = m_parent->networkAccessManager().get(QNetworkRequest(m_url));
-    connect(m_stream, SIGNAL(error(QNetworkReply::NetworkError)), SLOT(decoderError()));
+    const qint64 mappingThreshold = m_parent->mappingThreshold();
+    if (mappingThreshold >= 0 && m_url.isLocalFile()) {
+        QFile *file = new QFile(m_url.toLocalFile());
+        if (file->size() >= mappingThreshold && file->open(QIODevice::ReadOnly)) {
+            m_mappedFile = file;
+            m_stream = file;
+        } else {
+            delete file;
+        }
+    }
+
+    if (!m_stream) {
+        m_stream = m_parent->networkAccessManager().get(QNetworkRequest(m_url));
+        connect(m_stream, SIGNAL(error(QNetworkReply::NetworkError)), SLOT(decoderError()));
+    }
     m_waveDecoder = new QWaveDecoder(m_stream);
     connect(m_waveDecoder, SIGNAL(formatKnown()), SLOT(decoderReady()));
     connect(m_waveDecoder, SIGNAL(parsingError()), SLOT(decoderError()));
@@ -394,8 +675,12 @@ void QSample::decoderError()
     qDebug() << "QSample: decoder error";
 #endif
     cleanup();
+    if (m_mappedFile) {
+        m_mappedFile->deleteLater();
+        m_mappedFile = 0;
+    }
     m_state = QSample::Error;
-    qobject_cast<QSampleCache*>(m_parent)->loadingRelease();
+    m_parent->loadFinished(this);
     emit error();
 }
 
@@ -409,19 +694,24 @@ void QSample::onReady()
     m_audioFormat = m_waveDecoder->audioFormat();
     cleanup();
     m_state = QSample::Ready;
-    qobject_cast<QSampleCache*>(m_parent)->loadingRelease();
+    m_parent->loadFinished(this);
     emit ready();
 }
 
-// Called in application thread, then moved to loader thread
+// Called in application thread, then moved to a loader thread when its load is dispatched
 QSample::QSample(const QUrl& url, QSampleCache *parent)
     : m_parent(parent)
     , m_stream(0)
     , m_waveDecoder(0)
+    , m_mappedFile(0)
     , m_url(url)
     , m_sampleReadLength(0)
     , m_state(Creating)
     , m_ref(0)
+    , m_loaderIndex(-1)
+    , m_queueKey(0)
+    , m_lruKey(0)
+    , m_dispatched(false)
 {
 }
 
@@ -50,12 +50,16 @@
 #include <QtCore/qurl.h>
 #include <QtCore/qmutex.h>
 #include <QtCore/qmap.h>
+#include <QtCore/qhash.h>
 #include <QtCore/qset.h>
+#include <QtCore/qvector.h>
+#include <QtCore/qthreadstorage.h>
 #include <qaudioformat.h>
 
 
 QT_BEGIN_NAMESPACE
 
+class QFile;
 class QIODevice;
 class QNetworkAccessManager;
 class QSampleCache;
@@ -80,6 +84,8 @@ public:
     // variables are updated to their final states
     const QByteArray& data() const { Q_ASSERT(state() == Ready); return m_soundData; }
     const QAudioFormat& format() const { Q_ASSERT(state() == Ready); return m_audioFormat; }
+    // True when data() points straight into a memory mapped file
+    bool isMapped() const { Q_ASSERT(state() == Ready); return m_mappedFile != 0; }
     void release();
 
 Q_SIGNALS:
@@ -97,9 +103,10 @@ private Q_SLOTS:
 
 private:
     void onReady();
+    bool mapData();
     void cleanup();
     void addRef();
-    void loadIfNecessary();
+    bool loadIfNecessary();
     QSample();
     ~QSample();
 
@@ -109,10 +116,15 @@ private:
     QAudioFormat m_audioFormat;
     QIODevice    *m_stream;
     QWaveDecoder *m_waveDecoder;
+    QFile        *m_mappedFile;
     QUrl         m_url;
     qint64       m_sampleReadLength;
     State        m_state;
     int          m_ref;
+    int          m_loaderIndex;
+    quint64      m_queueKey;
+    quint64      m_lruKey;
+    bool         m_dispatched;
 };
 
 class Q_MULTIMEDIA_EXPORT QSampleCache : public QObject
@@ -121,26 +133,52 @@ class Q_MULTIMEDIA_EXPORT QSampleCache : public QObject
 public:
     friend class QSample;
 
+    enum LoadPriority
+    {
+        LowPriority,
+        NormalPriority,
+        HighPriority
+    };
+
     QSampleCache(QObject *parent = 0);
     ~QSampleCache();
 
-    QSample* requestSample(const QUrl& url);
+    QSample* requestSample(const QUrl& url, LoadPriority priority = NormalPriority);
+    void setLoadPriority(QSample *sample, LoadPriority priority);
     void setCapacity(qint64 capacity);
 
+    qint64 mappingThreshold() const;
+    void setMappingThreshold(qint64 threshold);
+
+    int loadingThreadCount() const;
+    void setLoadingThreadCount(int count);
+
     bool isLoading() const;
     bool isCached(const QUrl& url) const;
 
 Q_SIGNALS:
     void isLoadingChanged();
 
+private Q_SLOTS:
+    void dispatchLoads();
+
 private:
-    QMap<QUrl, QSample*> m_samples;
+    struct Loader
+    {
+        Loader() : thread(0), activeLoads(0), exiting(false) {}
+        QThread *thread;
+        int activeLoads;
+        bool exiting;
+    };
+
+    QHash<QUrl, QSample*> m_samples;
     QSet<QSample*> m_staleSamples;
-    QNetworkAccessManager *m_networkAccessManager;
+    QMap<quint64, QSample*> m_unusedSamples;   // unreferenced samples, least recently used first
+    quint64 m_lruCounter;
     mutable QMutex m_mutex;
     qint64 m_capacity;
     qint64 m_usage;
-    QThread m_loadingThread;
+    qint64 m_mappingThreshold;
 
     QNetworkAccessManager& networkAccessManager();
     void refresh(qint64 usageChange);
@@ -148,9 +186,18 @@ private:
     void removeUnreferencedSample(QSample* sample);
     void unloadSample(QSample* sample);
 
+    void enqueueLoad(QSample *sample, LoadPriority priority);
+    void loadFinished(QSample *sample);
+    void cancelLoad(QSample *sample);
+    void loadingAcquire();
     void loadingRelease();
+    QThreadStorage<QNetworkAccessManager*> m_networkAccessManagers;
+    QVector<Loader> m_loaders;
+    QMap<quint64, QSample*> m_pendingLoads;   // ordered by priority, then request order
+    quint64 m_loadSequence;
+    int m_loadingThreadCount;
     int m_loadingRefCount;
-    QMutex m_loadingMutex;
+    mutable QMutex m_loadingMutex;
 };
 
 QT_END_NAMESPACE
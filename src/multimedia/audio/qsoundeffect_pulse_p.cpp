@@ -573,6 +573,10 @@ void QSoundEffectPrivate::play()
     if (!m_resourcesAvailable)
         return;
 
+    // Waiting to be played, get ahead of samples that are only preloaded
+    if (m_sample && m_status == QSoundEffect::Loading)
+        sampleCache()->setLoadPriority(m_sample, QSampleCache::HighPriority);
+
     playAvailable();
 }
 
@@ -71,6 +71,9 @@ void QSoundEffectPrivate::release()
         d->m_audioOutput->stop();
         d->m_audioOutput->deleteLater();
         d->m_sample->release();
+    } else if (d->m_mixer) {
+        d->m_mixer->removeVoice(d);
+        d->m_sample->release();
     }
     delete d;
     this->deleteLater();
@@ -179,6 +182,8 @@ void QSoundEffectPrivate::setVolume(qreal volume)
 
     if (d->m_audioOutput && !d->m_muted)
         d->m_audioOutput->setVolume(volume);
+    else if (d->m_mixer && !d->m_muted)
+        d->m_mixer->setVoiceGain(d, QSoundEffectMixer::gainFromVolume(volume));
 
     emit volumeChanged();
 }
@@ -194,6 +199,8 @@ void QSoundEffectPrivate::setMuted(bool muted)
         d->m_audioOutput->setVolume(0);
     else if (!muted && d->m_audioOutput && d->m_muted)
         d->m_audioOutput->setVolume(d->m_volume);
+    else if (d->m_mixer)
+        d->m_mixer->setVoiceGain(d, muted ? 0 : QSoundEffectMixer::gainFromVolume(d->m_volume));
 
     d->m_muted = muted;
     emit mutedChanged();
@@ -227,8 +234,13 @@ void QSoundEffectPrivate::play()
         return;
     }
     setPlaying(true);
+    // Waiting to be played, get ahead of samples that are only preloaded
+    if (d->m_sample && !d->m_sampleReady)
+        sampleCache()->setLoadPriority(d->m_sample, QSampleCache::HighPriority);
     if (d->m_audioOutput && d->m_audioOutput->state() == QAudio::StoppedState && d->m_sampleReady)
         d->m_audioOutput->start(d);
+    else if (d->m_mixer && d->m_sampleReady)
+        d->m_mixer->addVoice(d, d->m_sample, QSoundEffectMixer::gainFromVolume(d->m_muted ? 0 : d->m_volume));
 }
 
 void QSoundEffectPrivate::stop()
@@ -244,6 +256,8 @@ void QSoundEffectPrivate::stop()
 
     if (d->m_audioOutput)
         d->m_audioOutput->stop();
+    else if (d->m_mixer)
+        d->m_mixer->removeVoice(d);
 }
 
 void QSoundEffectPrivate::setStatus(QSoundEffect::Status status)
@@ -303,6 +317,7 @@ PrivateSoundSource::PrivateSoundSource(QSoundEffectPrivate* s):
     m_playing(false),
     m_status(QSoundEffect::Null),
     m_audioOutput(0),
+    m_mixer(0),
     m_sample(0),
     m_muted(false),
     m_volume(1.0),
@@ -324,7 +339,10 @@ void PrivateSoundSource::sampleReady()
 #endif
     disconnect(m_sample, SIGNAL(error()), this, SLOT(decoderError()));
     disconnect(m_sample, SIGNAL(ready()), this, SLOT(sampleReady()));
-    if (!m_audioOutput) {
+    // Share one stream with the other effects at this sample rate when possible.
+    if (!m_audioOutput)
+        m_mixer = QSoundEffectMixer::instance(m_sample->format());
+    if (!m_audioOutput && !m_mixer) {
         m_audioOutput = new QAudioOutput(m_sample->format());
         connect(m_audioOutput,SIGNAL(stateChanged(QAudio::State)), this, SLOT(stateChanged(QAudio::State)));
         if (!m_muted)
@@ -335,7 +353,9 @@ void PrivateSoundSource::sampleReady()
     m_sampleReady = true;
     soundeffect->setStatus(QSoundEffect::Ready);
 
-    if (m_playing)
+    if (m_playing && m_mixer)
+        m_mixer->addVoice(this, m_sample, QSoundEffectMixer::gainFromVolume(m_muted ? 0 : m_volume));
+    else if (m_playing)
         m_audioOutput->start(this);
 }
 
@@ -432,6 +452,19 @@ qint64 PrivateSoundSource::readData( char* data, qint64 len)
     return 0;
 }
 
+bool PrivateSoundSource::voiceLooped()
+{
+    if (m_runningCount > 0 && m_runningCount != QSoundEffect::Infinite)
+        soundeffect->setLoopsRemaining(m_runningCount-1);
+
+    return m_playing && (m_runningCount > 0 || m_runningCount == QSoundEffect::Infinite);
+}
+
+void PrivateSoundSource::voiceFinished()
+{
+    emit soundeffect->stop();
+}
+
 qint64 PrivateSoundSource::writeData(const char* data, qint64 len)
 {
     Q_UNUSED(data)
@@ -50,12 +50,13 @@
 #include "qaudiooutput.h"
 #include "qsamplecache_p.h"
 #include "qsoundeffect.h"
+#include "qsoundeffectmixer_p.h"
 
 QT_BEGIN_NAMESPACE
 
 class QSoundEffectPrivate;
 
-class PrivateSoundSource : public QIODevice
+class PrivateSoundSource : public QIODevice, public QSoundEffectVoice
 {
     friend class QSoundEffectPrivate;
     Q_OBJECT
@@ -66,6 +67,9 @@ public:
     qint64 readData( char* data, qint64 len);
     qint64 writeData(const char* data, qint64 len);
 
+    bool voiceLooped();
+    void voiceFinished();
+
 private Q_SLOTS:
     void sampleReady();
     void decoderError();
@@ -78,6 +82,7 @@ private:
     bool           m_playing;
     QSoundEffect::Status  m_status;
     QAudioOutput   *m_audioOutput;
+    QSoundEffectMixer *m_mixer;
     QSample        *m_sample;
     bool           m_muted;
     qreal          m_volume;
@@ -0,0 +1,100 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qsoundeffectmixer_p.h"
+
+#ifdef QT_COMPILER_SUPPORTS_NEON
+
+#include <arm_neon.h>
+
+QT_BEGIN_NAMESPACE
+
+static inline int32x4_t qt_soundeffect_scale(int16x4_t samples, int16x4_t gain, bool unity)
+{
+    if (unity)
+        return vmovl_s16(samples);
+    return vshrq_n_s32(vmull_s16(samples, gain), 15);
+}
+
+void QT_FASTCALL qt_soundeffect_mix_s16_neon(qint32 *accumulator, const qint16 *samples, int count, int gain)
+{
+    const bool unity = gain >= QSoundEffectMixer::UnityGain;
+    const int16x4_t factor = vdup_n_s16(unity ? 0 : gain);
+
+    int i = 0;
+    for (; i < count - 3; i += 4) {
+        const int32x4_t value = qt_soundeffect_scale(vld1_s16(samples + i), factor, unity);
+        vst1q_s32(accumulator + i, vaddq_s32(vld1q_s32(accumulator + i), value));
+    }
+
+    // leftovers
+    for (; i < count; ++i)
+        accumulator[i] += unity ? samples[i] : (samples[i] * gain) >> 15;
+}
+
+void QT_FASTCALL qt_soundeffect_mix_s16_mono_to_stereo_neon(qint32 *accumulator, const qint16 *samples, int count, int gain)
+{
+    const bool unity = gain >= QSoundEffectMixer::UnityGain;
+    const int16x4_t factor = vdup_n_s16(unity ? 0 : gain);
+
+    int i = 0;
+    for (; i < count - 3; i += 4) {
+        const int32x4_t value = qt_soundeffect_scale(vld1_s16(samples + i), factor, unity);
+        const int32x4x2_t frames = vzipq_s32(value, value);
+        qint32 *acc = accumulator + 2 * i;
+        vst1q_s32(acc, vaddq_s32(vld1q_s32(acc), frames.val[0]));
+        vst1q_s32(acc + 4, vaddq_s32(vld1q_s32(acc + 4), frames.val[1]));
+    }
+
+    // leftovers
+    for (; i < count; ++i) {
+        const qint32 value = unity ? samples[i] : (samples[i] * gain) >> 15;
+        accumulator[2 * i] += value;
+        accumulator[2 * i + 1] += value;
+    }
+}
+
+void QT_FASTCALL qt_soundeffect_saturate_s16_neon(qint16 *output, const qint32 *accumulator, int count)
+{
+    int i = 0;
+    for (; i < count - 3; i += 4)
+        vst1_s16(output + i, vqmovn_s32(vld1q_s32(accumulator + i)));
+
+    // leftovers
+    for (; i < count; ++i)
+        output[i] = qBound<qint32>(-32768, accumulator[i], 32767);
+}
+
+QT_END_NAMESPACE
+
+#endif
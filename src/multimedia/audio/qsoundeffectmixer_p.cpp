@@ -0,0 +1,433 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// INTERNAL USE ONLY: Do NOT use for any other purpose.
+//
+
+#include "qsoundeffectmixer_p.h"
+#include "qsamplecache_p.h"
+#include "qaudiooutput.h"
+#include "qaudiodeviceinfo.h"
+
+#include <QtCore/qcoreapplication.h>
+#include <QtCore/qendian.h>
+#include <QtCore/qhash.h>
+#include <QtCore/qpointer.h>
+#include <QtCore/qthread.h>
+
+QT_BEGIN_NAMESPACE
+
+void QT_FASTCALL qt_soundeffect_mix_s16(qint32 *accumulator, const qint16 *samples, int count, int gain)
+{
+    if (gain >= QSoundEffectMixer::UnityGain) {
+        for (int i = 0; i < count; ++i)
+            accumulator[i] += samples[i];
+    } else {
+        for (int i = 0; i < count; ++i)
+            accumulator[i] += (samples[i] * gain) >> 15;
+    }
+}
+
+void QT_FASTCALL qt_soundeffect_mix_s16_mono_to_stereo(qint32 *accumulator, const qint16 *samples, int count, int gain)
+{
+    for (int i = 0; i < count; ++i) {
+        const qint32 value = gain >= QSoundEffectMixer::UnityGain
+                ? samples[i]
+                : (samples[i] * gain) >> 15;
+        accumulator[2 * i] += value;
+        accumulator[2 * i + 1] += value;
+    }
+}
+
+void QT_FASTCALL qt_soundeffect_saturate_s16(qint16 *output, const qint32 *accumulator, int count)
+{
+    for (int i = 0; i < count; ++i)
+        output[i] = qBound<qint32>(-32768, accumulator[i], 32767);
+}
+
+static QSoundEffectMixer::Kernels qInitSoundEffectKernels()
+{
+    QSoundEffectMixer::Kernels kernels = {
+        qt_soundeffect_mix_s16,
+        qt_soundeffect_mix_s16_mono_to_stereo,
+        qt_soundeffect_saturate_s16
+    };
+
+#ifdef QT_COMPILER_SUPPORTS_SSE2
+    extern void QT_FASTCALL qt_soundeffect_mix_s16_sse2(qint32*, const qint16*, int, int);
+    extern void QT_FASTCALL qt_soundeffect_mix_s16_mono_to_stereo_sse2(qint32*, const qint16*, int, int);
+    extern void QT_FASTCALL qt_soundeffect_saturate_s16_sse2(qint16*, const qint32*, int);
+    if (qCpuHasFeature(SSE2)) {
+        kernels.mix = qt_soundeffect_mix_s16_sse2;
+        kernels.mixMonoToStereo = qt_soundeffect_mix_s16_mono_to_stereo_sse2;
+        kernels.saturate = qt_soundeffect_saturate_s16_sse2;
+    }
+#endif
+#ifdef QT_COMPILER_SUPPORTS_NEON
+    extern void QT_FASTCALL qt_soundeffect_mix_s16_neon(qint32*, const qint16*, int, int);
+    extern void QT_FASTCALL qt_soundeffect_mix_s16_mono_to_stereo_neon(qint32*, const qint16*, int, int);
+    extern void QT_FASTCALL qt_soundeffect_saturate_s16_neon(qint16*, const qint32*, int);
+    if (qCpuHasFeature(NEON)) {
+        kernels.mix = qt_soundeffect_mix_s16_neon;
+        kernels.mixMonoToStereo = qt_soundeffect_mix_s16_mono_to_stereo_neon;
+        kernels.saturate = qt_soundeffect_saturate_s16_neon;
+    }
+#endif
+
+    return kernels;
+}
+
+static bool isNativeS16(const QAudioFormat &format)
+{
+    return format.sampleSize() == 16
+            && format.sampleType() == QAudioFormat::SignedInt
+            && format.byteOrder() == QAudioFormat::Endian(QSysInfo::ByteOrder);
+}
+
+static void convertToS16(const char *src, qint16 *dest, int count, const QAudioFormat &format)
+{
+    const uchar *in = reinterpret_cast<const uchar *>(src);
+    const bool littleEndian = format.byteOrder() == QAudioFormat::LittleEndian;
+
+    switch (format.sampleSize()) {
+    case 8:
+        for (int i = 0; i < count; ++i)
+            dest[i] = qint16((in[i] - 128) << 8);
+        break;
+    case 16:
+        for (int i = 0; i < count; ++i, in += 2)
+            dest[i] = littleEndian ? qFromLittleEndian<qint16>(in) : qFromBigEndian<qint16>(in);
+        break;
+    case 32:
+        for (int i = 0; i < count; ++i, in += 4)
+            dest[i] = qint16((littleEndian ? qFromLittleEndian<qint32>(in) : qFromBigEndian<qint32>(in)) >> 16);
+        break;
+    }
+}
+
+typedef QHash<int, QPointer<QSoundEffectMixer> > QSoundEffectMixerHash;
+Q_GLOBAL_STATIC(QSoundEffectMixerHash, soundEffectMixers)
+
+QSoundEffectMixer::QSoundEffectMixer(int sampleRate, QObject *parent)
+    : QIODevice(parent)
+    , m_output(0)
+    , m_mixing(false)
+{
+    m_format.setSampleRate(sampleRate);
+    m_format.setChannelCount(2);
+    m_format.setSampleSize(16);
+    m_format.setSampleType(QAudioFormat::SignedInt);
+    m_format.setByteOrder(QAudioFormat::Endian(QSysInfo::ByteOrder));
+    m_format.setCodec(QLatin1String("audio/pcm"));
+
+    open(QIODevice::ReadOnly);
+}
+
+QSoundEffectMixer::~QSoundEffectMixer()
+{
+    if (m_output)
+        m_output->stop();
+}
+
+/*
+    Returns the mixer shared by all sound effects with the sample rate of \a sampleFormat,
+    or 0 if those effects have to use their own audio output.
+*/
+QSoundEffectMixer *QSoundEffectMixer::instance(const QAudioFormat &sampleFormat)
+{
+    // Mixers live in the application thread and pull from the voices without locking.
+    QCoreApplication *application = QCoreApplication::instance();
+    if (!application || QThread::currentThread() != application->thread() || !canMix(sampleFormat))
+        return 0;
+
+    static const bool disabled = qEnvironmentVariableIsSet("QT_SOUNDEFFECT_NO_MIXER");
+    if (disabled)
+        return 0;
+
+    QPointer<QSoundEffectMixer> &mixer = (*soundEffectMixers())[sampleFormat.sampleRate()];
+    if (!mixer) {
+        QSoundEffectMixer *candidate = new QSoundEffectMixer(sampleFormat.sampleRate(), application);
+        if (!QAudioDeviceInfo::defaultOutputDevice().isFormatSupported(candidate->format())) {
+            delete candidate;
+            return 0;
+        }
+        candidate->createOutput();
+        mixer = candidate;
+    }
+    return mixer;
+}
+
+bool QSoundEffectMixer::canMix(const QAudioFormat &format)
+{
+    if (format.channelCount() != 1 && format.channelCount() != 2)
+        return false;
+
+    switch (format.sampleSize()) {
+    case 8:
+        return format.sampleType() == QAudioFormat::UnSignedInt;
+    case 16:
+    case 32:
+        return format.sampleType() == QAudioFormat::SignedInt;
+    default:
+        return false;
+    }
+}
+
+const QSoundEffectMixer::Kernels &QSoundEffectMixer::kernels()
+{
+    static const Kernels kernels = qInitSoundEffectKernels();
+    return kernels;
+}
+
+int QSoundEffectMixer::gainFromVolume(qreal volume)
+{
+    return qBound(0, qRound(volume * UnityGain), int(UnityGain));
+}
+
+void QSoundEffectMixer::addVoice(QSoundEffectVoice *owner, QSample *sample, int gain)
+{
+    addVoice(owner, sample->data().constData(), sample->data().size(), sample->format(), gain);
+}
+
+void QSoundEffectMixer::addVoice(QSoundEffectVoice *owner, const char *data, int size,
+                                 const QAudioFormat &format, int gain)
+{
+    removeVoice(owner);
+
+    Voice voice;
+    voice.owner = owner;
+    voice.data = data;
+    voice.format = format;
+    voice.frameBytes = format.bytesPerFrame();
+    voice.frameCount = voice.frameBytes > 0 ? size / voice.frameBytes : 0;
+    voice.offset = 0;
+    voice.gain = gain;
+
+    if (m_mixing)
+        m_pendingVoices.append(voice);
+    else
+        m_voices.append(voice);
+
+    startOutput();
+}
+
+void QSoundEffectMixer::removeVoice(QSoundEffectVoice *owner)
+{
+    for (int i = 0; i < m_voices.size(); ++i) {
+        if (m_voices.at(i).owner == owner) {
+            // Voices are only marked while mixing, the loop holds on to them.
+            if (m_mixing)
+                m_voices[i].owner = 0;
+            else
+                m_voices.remove(i);
+            return;
+        }
+    }
+    for (int i = 0; i < m_pendingVoices.size(); ++i) {
+        if (m_pendingVoices.at(i).owner == owner) {
+            m_pendingVoices.remove(i);
+            return;
+        }
+    }
+}
+
+void QSoundEffectMixer::setVoiceGain(QSoundEffectVoice *owner, int gain)
+{
+    for (int i = 0; i < m_voices.size(); ++i) {
+        if (m_voices.at(i).owner == owner)
+            m_voices[i].gain = gain;
+    }
+    for (int i = 0; i < m_pendingVoices.size(); ++i) {
+        if (m_pendingVoices.at(i).owner == owner)
+            m_pendingVoices[i].gain = gain;
+    }
+}
+
+bool QSoundEffectMixer::hasVoice(QSoundEffectVoice *owner) const
+{
+    for (int i = 0; i < m_voices.size(); ++i) {
+        if (m_voices.at(i).owner == owner)
+            return true;
+    }
+    for (int i = 0; i < m_pendingVoices.size(); ++i) {
+        if (m_pendingVoices.at(i).owner == owner)
+            return true;
+    }
+    return false;
+}
+
+int QSoundEffectMixer::voiceCount() const
+{
+    int count = m_pendingVoices.size();
+    for (int i = 0; i < m_voices.size(); ++i) {
+        if (m_voices.at(i).owner)
+            ++count;
+    }
+    return count;
+}
+
+int QSoundEffectMixer::mix(qint16 *output, int frames)
+{
+    const int samples = frames * 2;
+    if (m_accumulator.size() < samples)
+        m_accumulator.resize(samples);
+
+    qint32 *accumulator = m_accumulator.data();
+    memset(accumulator, 0, samples * sizeof(qint32));
+
+    QVector<QSoundEffectVoice *> finished;
+
+    m_mixing = true;
+    for (int i = 0; i < m_voices.size(); ++i) {
+        Voice &voice = m_voices[i];
+        if (voice.owner && !mixVoice(voice, accumulator, frames)) {
+            if (voice.owner)
+                finished.append(voice.owner);
+            voice.owner = 0;
+        }
+    }
+    m_mixing = false;
+
+    kernels().saturate(output, accumulator, samples);
+
+    purgeVoices();
+
+    for (int i = 0; i < finished.size(); ++i)
+        finished.at(i)->voiceFinished();
+
+    return frames;
+}
+
+bool QSoundEffectMixer::mixVoice(Voice &voice, qint32 *accumulator, int frames)
+{
+    int done = 0;
+    while (done < frames) {
+        const int chunk = qMin(frames - done, voice.frameCount - voice.offset);
+        if (chunk > 0) {
+            if (voice.gain > 0)
+                mixChunk(voice, accumulator + 2 * done, chunk);
+            voice.offset += chunk;
+            done += chunk;
+        }
+
+        if (voice.offset >= voice.frameCount) {
+            voice.offset = 0;
+            if (voice.frameCount == 0 || !voice.owner->voiceLooped() || !voice.owner)
+                return false;
+        }
+    }
+    return true;
+}
+
+void QSoundEffectMixer::mixChunk(const Voice &voice, qint32 *accumulator, int frames)
+{
+    const int channels = voice.format.channelCount();
+    const int count = frames * channels;
+    const char *src = voice.data + voice.offset * voice.frameBytes;
+
+    const qint16 *samples;
+    if (isNativeS16(voice.format)) {
+        samples = reinterpret_cast<const qint16 *>(src);
+    } else {
+        if (m_convertBuffer.size() < count)
+            m_convertBuffer.resize(count);
+        convertToS16(src, m_convertBuffer.data(), count, voice.format);
+        samples = m_convertBuffer.constData();
+    }
+
+    if (channels == 2)
+        kernels().mix(accumulator, samples, count, voice.gain);
+    else
+        kernels().mixMonoToStereo(accumulator, samples, count, voice.gain);
+}
+
+void QSoundEffectMixer::purgeVoices()
+{
+    for (int i = m_voices.size() - 1; i >= 0; --i) {
+        if (!m_voices.at(i).owner)
+            m_voices.remove(i);
+    }
+    m_voices += m_pendingVoices;
+    m_pendingVoices.clear();
+}
+
+void QSoundEffectMixer::createOutput()
+{
+    m_output = new QAudioOutput(m_format, this);
+    // Keep the stream short, new voices have to wait for whatever is queued.
+    m_output->setBufferSize(m_format.bytesForDuration(40000));
+}
+
+void QSoundEffectMixer::startOutput()
+{
+    if (m_output && m_output->state() == QAudio::StoppedState)
+        m_output->start(this);
+}
+
+qint64 QSoundEffectMixer::readData(char *data, qint64 len)
+{
+    if (m_voices.isEmpty() && m_pendingVoices.isEmpty())
+        return 0;
+
+    // Like a single sound effect, never queue more than three periods.
+    const int periodSize = m_output ? m_output->periodSize() : 0;
+    if (periodSize > 0)
+        len = qMin<qint64>(len, 3 * periodSize);
+
+    const int frames = int(len / m_format.bytesPerFrame());
+    if (frames <= 0)
+        return 0;
+
+    purgeVoices();
+
+    return qint64(mix(reinterpret_cast<qint16 *>(data), frames)) * m_format.bytesPerFrame();
+}
+
+qint64 QSoundEffectMixer::writeData(const char *data, qint64 len)
+{
+    Q_UNUSED(data)
+    Q_UNUSED(len)
+    return 0;
+}
+
+QT_END_NAMESPACE
+
+#include "moc_qsoundeffectmixer_p.cpp"
@@ -0,0 +1,142 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QSOUNDEFFECTMIXER_P_H
+#define QSOUNDEFFECTMIXER_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API. It exists purely as an
+// implementation detail. This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include <QtCore/qiodevice.h>
+#include <QtCore/qvector.h>
+#include <qaudioformat.h>
+#include <private/qsimd_p.h>
+
+QT_BEGIN_NAMESPACE
+
+class QAudioOutput;
+class QSample;
+
+// Implemented by the users of QSoundEffectMixer to follow the progress of their voice.
+class QSoundEffectVoice
+{
+public:
+    virtual ~QSoundEffectVoice() {}
+
+    // The voice reached the end of its sample, return true to play it again.
+    virtual bool voiceLooped() = 0;
+    // The voice has been removed from the mixer after its last loop.
+    virtual void voiceFinished() = 0;
+};
+
+typedef void (QT_FASTCALL *QSoundEffectMixFunc)(qint32 *accumulator, const qint16 *samples, int count, int gain);
+typedef void (QT_FASTCALL *QSoundEffectSaturateFunc)(qint16 *output, const qint32 *accumulator, int count);
+
+// Sums any number of sound effect voices into a single stereo 16 bit QAudioOutput
+// stream, there is one mixer for each sample rate in use. Mixers not created by
+// instance() have no output and are driven by calling mix().
+class Q_MULTIMEDIA_EXPORT QSoundEffectMixer : public QIODevice
+{
+    Q_OBJECT
+public:
+    enum { UnityGain = 0x8000 };
+
+    struct Kernels
+    {
+        QSoundEffectMixFunc mix;                // interleaved samples, channel counts match
+        QSoundEffectMixFunc mixMonoToStereo;    // count is the number of mono samples
+        QSoundEffectSaturateFunc saturate;
+    };
+
+    explicit QSoundEffectMixer(int sampleRate, QObject *parent = 0);
+    ~QSoundEffectMixer();
+
+    static QSoundEffectMixer *instance(const QAudioFormat &sampleFormat);
+    static bool canMix(const QAudioFormat &sampleFormat);
+    static const Kernels &kernels();
+    static int gainFromVolume(qreal volume);
+
+    QAudioFormat format() const { return m_format; }
+
+    void addVoice(QSoundEffectVoice *owner, QSample *sample, int gain);
+    void addVoice(QSoundEffectVoice *owner, const char *data, int size, const QAudioFormat &format, int gain);
+    void removeVoice(QSoundEffectVoice *owner);
+    void setVoiceGain(QSoundEffectVoice *owner, int gain);
+    bool hasVoice(QSoundEffectVoice *owner) const;
+    int voiceCount() const;
+
+    // Mixes the next frames of all voices into output, returns the number of frames written.
+    int mix(qint16 *output, int frames);
+
+protected:
+    qint64 readData(char *data, qint64 len);
+    qint64 writeData(const char *data, qint64 len);
+
+private:
+    struct Voice
+    {
+        QSoundEffectVoice *owner;
+        const char *data;
+        QAudioFormat format;
+        int frameCount;
+        int frameBytes;
+        int offset;
+        int gain;
+    };
+
+    bool mixVoice(Voice &voice, qint32 *accumulator, int frames);
+    void mixChunk(const Voice &voice, qint32 *accumulator, int frames);
+    void purgeVoices();
+    void createOutput();
+    void startOutput();
+
+    QAudioFormat m_format;
+    QAudioOutput *m_output;
+    QVector<Voice> m_voices;
+    QVector<Voice> m_pendingVoices;
+    QVector<qint32> m_accumulator;
+    QVector<qint16> m_convertBuffer;
+    bool m_mixing;
+};
+
+QT_END_NAMESPACE
+
+#endif // QSOUNDEFFECTMIXER_P_H
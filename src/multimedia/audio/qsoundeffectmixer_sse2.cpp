@@ -0,0 +1,113 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qsoundeffectmixer_p.h"
+
+#ifdef QT_COMPILER_SUPPORTS_SSE2
+
+QT_BEGIN_NAMESPACE
+
+static inline __m128i qt_soundeffect_scale_lo(__m128i samples, __m128i gain, bool unity)
+{
+    if (unity)
+        return _mm_srai_epi32(_mm_unpacklo_epi16(samples, samples), 16);
+    return _mm_srai_epi32(_mm_unpacklo_epi16(_mm_mullo_epi16(samples, gain), _mm_mulhi_epi16(samples, gain)), 15);
+}
+
+static inline __m128i qt_soundeffect_scale_hi(__m128i samples, __m128i gain, bool unity)
+{
+    if (unity)
+        return _mm_srai_epi32(_mm_unpackhi_epi16(samples, samples), 16);
+    return _mm_srai_epi32(_mm_unpackhi_epi16(_mm_mullo_epi16(samples, gain), _mm_mulhi_epi16(samples, gain)), 15);
+}
+
+void QT_FASTCALL qt_soundeffect_mix_s16_sse2(qint32 *accumulator, const qint16 *samples, int count, int gain)
+{
+    const bool unity = gain >= QSoundEffectMixer::UnityGain;
+    const __m128i factor = _mm_set1_epi16(unity ? 0 : gain);
+
+    int i = 0;
+    for (; i < count - 7; i += 8) {
+        const __m128i data = _mm_loadu_si128(reinterpret_cast<const __m128i *>(samples + i));
+        __m128i *acc = reinterpret_cast<__m128i *>(accumulator + i);
+
+        _mm_storeu_si128(acc, _mm_add_epi32(_mm_loadu_si128(acc), qt_soundeffect_scale_lo(data, factor, unity)));
+        _mm_storeu_si128(acc + 1, _mm_add_epi32(_mm_loadu_si128(acc + 1), qt_soundeffect_scale_hi(data, factor, unity)));
+    }
+
+    // leftovers
+    for (; i < count; ++i)
+        accumulator[i] += unity ? samples[i] : (samples[i] * gain) >> 15;
+}
+
+void QT_FASTCALL qt_soundeffect_mix_s16_mono_to_stereo_sse2(qint32 *accumulator, const qint16 *samples, int count, int gain)
+{
+    const bool unity = gain >= QSoundEffectMixer::UnityGain;
+    const __m128i factor = _mm_set1_epi16(unity ? 0 : gain);
+
+    int i = 0;
+    for (; i < count - 3; i += 4) {
+        // Duplicate four mono samples into four stereo frames.
+        __m128i data = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(samples + i));
+        data = _mm_unpacklo_epi16(data, data);
+        __m128i *acc = reinterpret_cast<__m128i *>(accumulator + 2 * i);
+
+        _mm_storeu_si128(acc, _mm_add_epi32(_mm_loadu_si128(acc), qt_soundeffect_scale_lo(data, factor, unity)));
+        _mm_storeu_si128(acc + 1, _mm_add_epi32(_mm_loadu_si128(acc + 1), qt_soundeffect_scale_hi(data, factor, unity)));
+    }
+
+    // leftovers
+    for (; i < count; ++i) {
+        const qint32 value = unity ? samples[i] : (samples[i] * gain) >> 15;
+        accumulator[2 * i] += value;
+        accumulator[2 * i + 1] += value;
+    }
+}
+
+void QT_FASTCALL qt_soundeffect_saturate_s16_sse2(qint16 *output, const qint32 *accumulator, int count)
+{
+    int i = 0;
+    for (; i < count - 7; i += 8) {
+        const __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i *>(accumulator + i));
+        const __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i *>(accumulator + i + 4));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(output + i), _mm_packs_epi32(lo, hi));
+    }
+
+    // leftovers
+    for (; i < count; ++i)
+        output[i] = qBound<qint32>(-32768, accumulator[i], 32767);
+}
+
+QT_END_NAMESPACE
+
+#endif
@@ -42,6 +42,7 @@ QWaveDecoder::QWaveDecoder(QIODevice *s, QObject *parent):
     QIODevice(parent),
     haveFormat(false),
     dataSize(0),
+    dataStart(-1),
     source(s),
     state(QWaveDecoder::InitialState),
     junkToSkip(0),
@@ -49,10 +50,13 @@ QWaveDecoder::QWaveDecoder(QIODevice *s, QObject *parent):
 {
     open(QIODevice::ReadOnly | QIODevice::Unbuffered);
 
-    if (enoughDataAvailable())
+    connect(source, SIGNAL(readyRead()), SLOT(handleData()));
+
+    // A random access source may already hold all the data it ever will, even
+    // when the RIFF size claims more, and then never signals readyRead(). Try
+    // once right away; sources still being filled are handled on readyRead().
+    if (!source->isSequential() || enoughDataAvailable())
         QTimer::singleShot(0, this, SLOT(handleData()));
-    else
-        connect(source, SIGNAL(readyRead()), SLOT(handleData()));
 }
 
 QWaveDecoder::~QWaveDecoder()
@@ -74,6 +78,13 @@ qint64 QWaveDecoder::size() const
     return haveFormat ? dataSize : 0;
 }
 
+// Position of the PCM data in a random access source, -1 if unknown.
+// Lets callers map the data chunk of a file instead of reading it.
+qint64 QWaveDecoder::dataOffset() const
+{
+    return haveFormat ? dataStart : -1;
+}
+
 bool QWaveDecoder::isSequential() const
 {
     return source->isSequential();
@@ -101,11 +112,16 @@ void QWaveDecoder::parsingFailed()
 {
     Q_ASSERT(source);
     source->disconnect(SIGNAL(readyRead()), this, SLOT(handleData()));
+    state = QWaveDecoder::FailedState;
     emit parsingError();
 }
 
 void QWaveDecoder::handleData()
 {
+    // The initial attempt may arrive after readyRead() already finished parsing
+    if (haveFormat || state == QWaveDecoder::FailedState)
+        return;
+
     // As a special "state", if we have junk to skip, we do
     if (junkToSkip > 0) {
         discardBytes(junkToSkip); // this also updates junkToSkip
@@ -205,6 +221,8 @@ void QWaveDecoder::handleData()
                 descriptor.size = qFromLittleEndian<quint32>(descriptor.size);
 
             dataSize = descriptor.size;
+            if (!source->isSequential())
+                dataStart = source->pos();
 
             haveFormat = true;
             connect(source, SIGNAL(readyRead()), SIGNAL(readyRead()));
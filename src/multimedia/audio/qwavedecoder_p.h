@@ -65,6 +65,7 @@ public:
     int duration() const;
 
     qint64 size() const;
+    qint64 dataOffset() const;
     bool isSequential() const;
     qint64 bytesAvailable() const;
 
@@ -87,7 +88,8 @@ private:
     enum State {
         InitialState,
         WaitingForFormatState,
-        WaitingForDataState
+        WaitingForDataState,
+        FailedState
     };
 
     struct chunk
@@ -115,6 +117,7 @@ private:
 
     bool haveFormat;
     qint64 dataSize;
+    qint64 dataStart;
     QAudioFormat format;
     QIODevice *source;
     State state;
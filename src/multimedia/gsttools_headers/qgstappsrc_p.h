@@ -47,6 +47,10 @@
 
 #include <QtCore/qobject.h>
 #include <QtCore/qiodevice.h>
+#include <QtCore/qmap.h>
+#include <QtCore/qatomic.h>
+#include <QtCore/qmutex.h>
+#include <QtCore/qwaitcondition.h>
 
 #include <gst/gst.h>
 #include <gst/app/gstappsrc.h>
@@ -57,10 +61,20 @@
 
 QT_BEGIN_NAMESPACE
 
+class QGstAppSrcMemory;
+class QGstAppSrcWorker;
+
 class QGstAppSrc  : public QObject
 {
     Q_OBJECT
 public:
+    // How the stream is fed to the element, chosen by setup().
+    enum FeedMode {
+        OwnerThreadFeed,    // read on this object's thread from its event loop
+        MemoryFeed,         // QBuffer or mappable QFile, wrapped without copying
+        WorkerFeed          // random access stream read ahead by a worker thread
+    };
+
     QGstAppSrc(QObject *parent = 0);
     ~QGstAppSrc();
 
@@ -69,6 +83,13 @@ public:
     void setStream(QIODevice *);
     QIODevice *stream() const;
 
+    // Streams which depend on their thread's event loop for data must be
+    // read on the owner thread; disable this before setup() for those.
+    void setWorkerEnabled(bool enabled);
+    bool isWorkerEnabled() const { return m_workerEnabled; }
+
+    FeedMode feedMode() const { return m_feedMode; }
+
     GstAppSrc *element();
 
     qint64 queueSize() const { return m_maxBytes; }
@@ -89,7 +110,10 @@ private slots:
     void onDataReady();
 
     void streamDestroyed();
+    void streamAboutToClose();
 private:
+    friend class QGstAppSrcWorker;
+
     static gboolean on_seek_data(GstAppSrc *element, guint64 arg0, gpointer userdata);
     static void on_enough_data(GstAppSrc *element, gpointer userdata);
     static void on_need_data(GstAppSrc *element, uint arg0, gpointer userdata);
@@ -97,6 +121,13 @@ private:
 
     void sendEOS();
 
+    void startFeeding();
+    void stopFeeding();
+    void adaptBlockSize();
+    void pushMemory();
+    void feedFromWorker();
+    GstBuffer *allocateBuffer(qint64 size);
+
     QIODevice *m_stream;
     GstAppSrc *m_appSrc;
     bool m_sequential;
@@ -107,6 +138,27 @@ private:
     bool m_dataRequested;
     bool m_enoughData;
     bool m_forceData;
+
+    bool m_workerEnabled;
+    FeedMode m_feedMode;
+    QGstAppSrcMemory *m_memory;
+    QGstAppSrcWorker *m_worker;
+#if GST_CHECK_VERSION(1,0,0)
+    QMap<qint64, GstBufferPool *> m_pools;
+#endif
+    // Guards the state below, shared with the streaming and worker threads.
+    // The element may call back synchronously from a push, so the callbacks
+    // which can only be reentered that way use atomics instead.
+    QMutex m_feedMutex;
+    QWaitCondition m_feedCondition;
+    qint64 m_feedOffset;
+    qint64 m_blockSize;
+    quint64 m_seekGeneration;
+    bool m_seekPending;
+    bool m_feedEnd;
+    bool m_stopFeeding;
+    QAtomicInt m_feedEnough;
+    QAtomicInt m_enoughSinceNeed;
 };
 
 QT_END_NAMESPACE
@@ -45,7 +45,10 @@
 // We mean it.
 //
 
+#include <QtCore/qhash.h>
 #include <QtCore/qmap.h>
+#include <QtCore/qmutex.h>
+#include <QtCore/qset.h>
 #include <QtCore/qstringlist.h>
 
 #include <gst/gst.h>
@@ -69,8 +72,44 @@ public:
 #endif
 
 private:
+    ElementType m_elementType;
     QStringList m_codecs;
-    QMap<QString,QString> m_codecDescriptions;
+};
+
+/*
+    Process wide codec lists, shared by every QGstCodecsInfo.
+
+    Listing the codecs means walking the whole element factory registry, so
+    the lists are also kept in a file in the user's cache directory, valid as
+    long as the GStreamer registry file is not rewritten. Set
+    QT_GSTREAMER_CODECS_CACHE to another file name to relocate it, or to 0 to
+    always scan the registry.
+
+    Codec descriptions are only looked up when asked for, and remembered for
+    the lifetime of the process.
+*/
+class QGstCodecsInfoCache
+{
+public:
+    QGstCodecsInfoCache();
+
+    QStringList codecs(QGstCodecsInfo::ElementType elementType);
+    QString description(QGstCodecsInfo::ElementType elementType, const QString &codec);
+
+    QString fileName() const { return m_fileName; }
+    static QString registryStamp();
+
+private:
+    static QStringList scanCodecs(QGstCodecsInfo::ElementType elementType);
+    void save() const;
+
+    QMutex m_mutex;
+    QString m_fileName;
+    QString m_stamp;
+    QStringList m_codecs[3];
+    QSet<QString> m_codecSets[3];
+    bool m_scanned[3];
+    QHash<QString, QString> m_descriptions;
 };
 
 
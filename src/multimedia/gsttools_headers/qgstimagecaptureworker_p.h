@@ -0,0 +1,130 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QGSTIMAGECAPTUREWORKER_P_H
+#define QGSTIMAGECAPTUREWORKER_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include <gst/gst.h>
+#if GST_CHECK_VERSION(1,0,0)
+#include <gst/video/video.h>
+#endif
+
+#include <QtCore/qobject.h>
+#include <QtCore/qmap.h>
+#include <QtCore/qmutex.h>
+#include <QtCore/qsemaphore.h>
+#include <QtCore/qthreadpool.h>
+#include <QtGui/qimage.h>
+
+QT_BEGIN_NAMESPACE
+
+/*
+    Converts and saves captured images on a small pool of threads, so the
+    streaming thread only pays for taking a reference on the buffer.
+
+    At most maximumPendingJobs() jobs are queued, running or waiting for
+    their result to be delivered. Submitting more is refused rather than
+    blocking the caller: streaming threads must not wait on the thread the
+    results are delivered in, which may itself be waiting for them to stop
+    the pipeline. Results are delivered in submission order in the thread
+    the worker lives in.
+*/
+class QGstImageCaptureWorker : public QObject
+{
+    Q_OBJECT
+public:
+    explicit QGstImageCaptureWorker(QObject *parent = 0);
+    ~QGstImageCaptureWorker();
+
+    int maximumPendingJobs() const { return m_maximumPendingJobs; }
+
+#if GST_CHECK_VERSION(1,0,0)
+    bool convertImage(int requestId, GstBuffer *buffer, const GstVideoInfo &info,
+                      const QSize &maximumSize = QSize());
+#else
+    bool convertImage(int requestId, GstBuffer *buffer);
+#endif
+    bool saveImage(int requestId, GstBuffer *buffer, const QString &fileName);
+
+    void waitForDone();
+
+Q_SIGNALS:
+    void imageConverted(int requestId, const QImage &image);
+    void imageSaved(int requestId, const QString &fileName);
+    void saveFailed(int requestId, const QString &errorString);
+
+private Q_SLOTS:
+    void deliverResults();
+
+private:
+    class Job;
+    friend class Job;
+
+    struct Result
+    {
+        Result() : requestId(-1), saved(false) {}
+
+        int requestId;
+        QImage image;
+        QString fileName;
+        QString errorString;
+        bool saved;
+    };
+
+    bool submit(Job *job);
+    void finish(quint64 sequence, const Result &result);
+
+    QThreadPool m_pool;
+    QSemaphore m_jobSlots;
+    QMutex m_resultMutex;
+    QMap<quint64, Result> m_results;
+    quint64 m_nextSubmitted;
+    quint64 m_nextDelivered;
+    int m_maximumPendingJobs;
+    bool m_deliveryQueued;
+};
+
+QT_END_NAMESPACE
+
+#endif // QGSTIMAGECAPTUREWORKER_P_H
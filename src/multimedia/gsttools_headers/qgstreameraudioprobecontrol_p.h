@@ -50,11 +50,14 @@
 #include <QtCore/qmutex.h>
 #include <qaudiobuffer.h>
 #include <qshareddata.h>
+#include <QtCore/qvector.h>
 
 #include <private/qgstreamerbufferprobe_p.h>
 
 QT_BEGIN_NAMESPACE
 
+class QAudioProbeRingBuffer;
+
 class QGstreamerAudioProbeControl
     : public QMediaAudioProbeControl
     , public QGstreamerBufferProbe
@@ -65,6 +68,9 @@ public:
     explicit QGstreamerAudioProbeControl(QObject *parent);
     virtual ~QGstreamerAudioProbeControl();
 
+    Q_INVOKABLE void addRingBuffer(QAudioProbeRingBuffer *ringBuffer);
+    Q_INVOKABLE void removeRingBuffer(QAudioProbeRingBuffer *ringBuffer);
+
 protected:
     void probeCaps(GstCaps *caps);
     bool probeBuffer(GstBuffer *buffer);
@@ -75,6 +81,7 @@ private slots:
 private:
     QAudioBuffer m_pendingBuffer;
     QAudioFormat m_format;
+    QVector<QAudioProbeRingBuffer *> m_ringBuffers;
     QMutex m_bufferMutex;
 };
 
@@ -0,0 +1,168 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QGSTREAMERMEDIACACHE_P_H
+#define QGSTREAMERMEDIACACHE_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include <QtCore/qiodevice.h>
+#include <QtCore/qhash.h>
+#include <QtCore/qmutex.h>
+#include <QtCore/qurl.h>
+#include <QtNetwork/qnetworkrequest.h>
+#include <qmediatimerange.h>
+
+QT_BEGIN_NAMESPACE
+
+class QFile;
+class QNetworkAccessManager;
+class QNetworkReply;
+
+class QGstreamerMediaCache
+{
+public:
+    struct Entry
+    {
+        Entry() : totalSize(-1), lastAccess(0) {}
+
+        QUrl url;
+        QByteArray etag;
+        qint64 totalSize;
+        QMediaTimeRange ranges;     // cached bytes, inclusive intervals
+        qint64 lastAccess;
+    };
+
+    QGstreamerMediaCache(const QString &directory, qint64 maximumSize);
+    ~QGstreamerMediaCache();
+
+    static QGstreamerMediaCache *instance();
+
+    QString directory() const { return m_directory; }
+    qint64 maximumSize() const { return m_maximumSize; }
+    qint64 size() const;
+
+    Entry acquire(const QUrl &url);
+    void release(const QUrl &url);
+
+    void reset(const QUrl &url, const QByteArray &etag, qint64 totalSize);
+    void setTotalSize(const QUrl &url, qint64 totalSize);
+    bool write(const QUrl &url, qint64 offset, const char *data, qint64 length);
+    qint64 read(const QUrl &url, qint64 offset, char *data, qint64 maxLength) const;
+    void sync(const QUrl &url);
+    void remove(const QUrl &url);
+
+private:
+    static QString keyForUrl(const QUrl &url);
+    QString dataFileName(const QString &key) const;
+    QString indexFileName(const QString &key) const;
+
+    void loadIndex();
+    void saveEntry(const QString &key) const;
+    void removeEntry(const QString &key);
+    void makeRoom(const QString &key, qint64 length);
+    QFile *dataFile(const QString &key) const;
+
+    mutable QMutex m_mutex;
+    QString m_directory;
+    qint64 m_maximumSize;
+    qint64 m_size;
+    QHash<QString, Entry> m_entries;
+    QHash<QString, int> m_users;
+    mutable QHash<QString, QFile *> m_files;
+};
+
+class QGstreamerCachedMediaDevice : public QIODevice
+{
+    Q_OBJECT
+public:
+    QGstreamerCachedMediaDevice(QNetworkAccessManager *manager, const QNetworkRequest &request,
+                                QGstreamerMediaCache *cache, QObject *parent = 0);
+    ~QGstreamerCachedMediaDevice();
+
+    bool isSequential() const;
+    qint64 size() const;
+    bool seek(qint64 pos);
+    bool atEnd() const;
+    qint64 bytesAvailable() const;
+
+    QMediaTimeRange cachedRanges() const;
+    qint64 bytesDownloaded() const { return m_bytesDownloaded; }
+
+Q_SIGNALS:
+    void cachedRangesChanged();
+
+protected:
+    qint64 readData(char *data, qint64 maxSize);
+    qint64 writeData(const char *data, qint64 maxSize);
+
+private Q_SLOTS:
+    void replyMetaDataChanged();
+    void replyReadyRead();
+    void replyFinished();
+
+private:
+    qint64 nextGap(qint64 from) const;
+    void validate();
+    void fetch(qint64 offset);
+    void startReply(const QNetworkRequest &request, qint64 offset);
+    void fetchNextGap();
+    void stopCaching();
+    void abortReply();
+
+    QNetworkAccessManager *m_manager;
+    QNetworkRequest m_request;
+    QGstreamerMediaCache *m_cache;
+    QUrl m_url;
+    QGstreamerMediaCache::Entry m_entry;
+    QNetworkReply *m_reply;
+    qint64 m_replyOffset;
+    qint64 m_bytesDownloaded;
+    bool m_validated;
+    bool m_failed;
+    bool m_uncached;
+    QByteArray m_pending;       // received and not read yet, when uncached
+};
+
+QT_END_NAMESPACE
+
+#endif
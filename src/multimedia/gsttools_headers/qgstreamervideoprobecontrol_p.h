@@ -86,6 +86,7 @@ private:
 #endif
     bool m_flushing;
     bool m_frameProbed; // true if at least one frame was probed
+    bool m_copyFrames; // hand out pooled copies instead of holding on to GstBuffers
 };
 
 QT_END_NAMESPACE
@@ -115,6 +115,7 @@ namespace QGstUtils {
 
 #if GST_CHECK_VERSION(1,0,0)
     QImage bufferToImage(GstBuffer *buffer, const GstVideoInfo &info);
+    QImage scaledBufferToImage(GstBuffer *buffer, const GstVideoInfo &info, const QSize &maximumSize);
     QVideoSurfaceFormat formatForCaps(
             GstCaps *caps,
             GstVideoInfo *info = 0,
@@ -127,6 +128,8 @@ namespace QGstUtils {
             QAbstractVideoBuffer::HandleType handleType = QAbstractVideoBuffer::NoHandle);
 #endif
 
+    QSize jpegResolution(const uchar *data, int size);
+
     GstCaps *capsForFormats(const QList<QVideoFrame::PixelFormat> &formats);
     void setFrameTimeStamps(QVideoFrame *frame, GstBuffer *buffer);
 
@@ -48,10 +48,13 @@
 #include <gst/video/gstvideosink.h>
 #include <gst/video/video.h>
 
+#include <QtCore/qatomic.h>
+#include <QtCore/qelapsedtimer.h>
 #include <QtCore/qlist.h>
 #include <QtCore/qmutex.h>
 #include <QtCore/qqueue.h>
 #include <QtCore/qpointer.h>
+#include <QtCore/qvector.h>
 #include <QtCore/qwaitcondition.h>
 #include <qvideosurfaceformat.h>
 #include <qvideoframe.h>
@@ -89,9 +92,36 @@ class QVideoSurfaceGstDelegate : public QObject
 {
     Q_OBJECT
 public:
+    enum FrameDropPolicy
+    {
+        DropOldestFrame,
+        DropNewestFrame
+    };
+
+    struct FrameQueueStatistics
+    {
+        FrameQueueStatistics()
+            : depth(0), queuedFrames(0), presentedFrames(0), droppedOldestFrames(0)
+            , droppedNewestFrames(0), lastLatency(0), maximumLatency(0), averageLatency(0) {}
+
+        int depth;
+        int queuedFrames;
+        int presentedFrames;
+        int droppedOldestFrames;
+        int droppedNewestFrames;
+        qint64 lastLatency;     // microseconds from render() to present()
+        qint64 maximumLatency;
+        qint64 averageLatency;
+    };
+
     QVideoSurfaceGstDelegate(QAbstractVideoSurface *surface);
     ~QVideoSurfaceGstDelegate();
 
+    void setFrameQueue(int depth, FrameDropPolicy policy = DropOldestFrame);
+    int frameQueueDepth() const { return m_queue.size(); }
+    FrameDropPolicy frameDropPolicy() const { return m_dropPolicy; }
+    FrameQueueStatistics frameQueueStatistics() const;
+
     GstCaps *caps();
 
     bool start(GstCaps *caps);
@@ -110,12 +140,26 @@ private slots:
     void updateSupportedFormats();
 
 private:
+    struct QueuedFrame
+    {
+        QueuedFrame() : buffer(0), queuedAt(0) {}
+
+        GstBuffer *buffer;
+        qint64 queuedAt;
+    };
+
     void notify();
     bool waitForAsyncEvent(QMutexLocker *locker, QWaitCondition *condition, unsigned long time);
 
+    GstFlowReturn queueFrame(GstBuffer *buffer);
+    bool dequeueFrame(QueuedFrame *frame);
+    void clearFrameQueue();
+    void notifyFrameQueue();
+    void presentQueuedFrame(QMutexLocker *locker);
+
     QPointer<QAbstractVideoSurface> m_surface;
 
-    QMutex m_mutex;
+    mutable QMutex m_mutex;
     QWaitCondition m_setupCondition;
     QWaitCondition m_renderCondition;
     GstFlowReturn m_renderReturn;
@@ -130,6 +174,23 @@ private:
     bool m_notified;
     bool m_stop;
     bool m_flush;
+
+    // Frame queue mode; the streaming thread is the only writer of m_queueHead,
+    // frames are claimed by advancing m_queueTail with a compare-and-swap so the
+    // streaming thread can also discard the oldest frame when the queue is full.
+    QVector<QueuedFrame> m_queue;
+    FrameDropPolicy m_dropPolicy;
+    QAtomicInt m_queueHead;
+    QAtomicInt m_queueTail;
+    QAtomicInt m_queueNotified;
+    QAtomicInt m_queueRenderFailed;
+    QAtomicInt m_presentedFrames;
+    QAtomicInt m_droppedOldestFrames;
+    QAtomicInt m_droppedNewestFrames;
+    QElapsedTimer m_clock;
+    qint64 m_lastLatency;
+    qint64 m_maximumLatency;
+    qint64 m_totalLatency;
 };
 
 class QGstVideoRendererSink
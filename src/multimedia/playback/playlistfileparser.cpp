@@ -30,29 +30,26 @@
 ** $QT_END_LICENSE$
 **
 ****************************************************************************/
-
 #include "playlistfileparser_p.h"
 #include <qfileinfo.h>
 #include <QtCore/QDebug>
+#include <QtCore/qatomic.h>
+#include <QtCore/qthread.h>
 #include <QtNetwork/QNetworkReply>
 #include <QtNetwork/QNetworkRequest>
 #include "qmediaobject_p.h"
 #include <private/qobject_p.h>
-#include "qmediametadata.h"
 
 QT_BEGIN_NAMESPACE
 
 namespace {
-class ParserBase : public QObject
+class ParserBase
 {
-    Q_OBJECT
 public:
-    ParserBase(QObject *parent)
-        : QObject(parent)
-    {
-    }
+    virtual ~ParserBase() {}
 
-    virtual void parseLine(int lineIndex, const QString& line, const QUrl& root) = 0;
+    // Returns the URL of the entry on the line, if there is one
+    virtual QUrl parseLine(int lineIndex, const QString& line, const QUrl& root) = 0;
 
 protected:
     QUrl expandToFullPath(const QUrl &root, const QString &line)
@@ -77,23 +74,11 @@ protected:
 
         return url;
     }
-
-Q_SIGNALS:
-    void newItem(const QVariant& content);
-    void finished();
-    void error(QPlaylistFileParser::ParserError err, const QString& errorMsg);
 };
 
 class M3UParser : public ParserBase
 {
 public:
-    M3UParser(QObject *parent)
-        : ParserBase(parent)
-        , m_extendedFormat(false)
-    {
-    }
-
-
     /*
      *
     Extended M3U directives
@@ -110,75 +95,20 @@ public:
     #EXTINF:321,Example Artist - Example title
     C:\Documents and Settings\I\My Music\Greatest Hits\Example.ogg
 
+    Directives and comments are skipped, playlist entries only carry the URL.
      */
-    void parseLine(int lineIndex, const QString& line, const QUrl& root)
+    QUrl parseLine(int, const QString& line, const QUrl& root)
     {
-        if (line[0] == '#' ) {
-            if (m_extendedFormat) {
-                if (line.startsWith(QLatin1String("#EXTINF:"))) {
-                    m_extraInfo.clear();
-                    int artistStart = line.indexOf(QLatin1String(","), 8);
-                    bool ok = false;
-                    int length = line.midRef(8, artistStart < 8 ? -1 : artistStart - 8).trimmed().toInt(&ok);
-                    if (ok && length > 0) {
-                        //convert from second to milisecond
-                        m_extraInfo[QMediaMetaData::Duration] = QVariant(length * 1000);
-                    }
-                    if (artistStart > 0) {
-                        int titleStart = getSplitIndex(line, artistStart);
-                        if (titleStart > artistStart) {
-                            m_extraInfo[QMediaMetaData::Author] = line.midRef(artistStart + 1,
-                                                             titleStart - artistStart - 1).trimmed().toString().
-                                                             replace(QLatin1String("--"), QLatin1String("-"));
-                            m_extraInfo[QMediaMetaData::Title] = line.midRef(titleStart + 1).trimmed().toString().
-                                                   replace(QLatin1String("--"), QLatin1String("-"));
-                        } else {
-                            m_extraInfo[QMediaMetaData::Title] = line.midRef(artistStart + 1).trimmed().toString().
-                                                   replace(QLatin1String("--"), QLatin1String("-"));
-                        }
-                    }
-                }
-            } else if (lineIndex == 0 && line.startsWith(QLatin1String("#EXTM3U"))) {
-                m_extendedFormat = true;
-            }
-        } else {
-            m_extraInfo[QLatin1String("url")] = expandToFullPath(root, line);
-            emit newItem(QVariant(m_extraInfo));
-            m_extraInfo.clear();
-        }
-    }
+        if (line[0] == '#')
+            return QUrl();
 
-    int getSplitIndex(const QString& line, int startPos)
-    {
-        if (startPos < 0)
-            startPos = 0;
-        const QChar* buf = line.data();
-        for (int i = startPos; i < line.length(); ++i) {
-            if (buf[i] == '-') {
-                if (i == line.length() - 1)
-                    return i;
-                ++i;
-                if (buf[i] != '-')
-                    return i - 1;
-            }
-        }
-        return -1;
+        return expandToFullPath(root, line);
     }
-
-private:
-    bool            m_extendedFormat;
-    QVariantMap     m_extraInfo;
 };
 
 class PLSParser : public ParserBase
 {
-    Q_OBJECT
 public:
-    PLSParser(QObject *parent)
-        : ParserBase(parent)
-    {
-    }
-
 /*
  *
 The format is essentially that of an INI file structured as follows:
@@ -217,17 +147,17 @@ NumberOfEntries=2
 
 Version=2
 */
-    void parseLine(int, const QString &line, const QUrl &root)
+    QUrl parseLine(int, const QString &line, const QUrl &root)
     {
         // We ignore everything but 'File' entries, since that's the only thing we care about.
         if (!line.startsWith(QLatin1String("File")))
-            return;
+            return QUrl();
 
         QString value = getValue(line);
         if (value.isEmpty())
-            return;
+            return QUrl();
 
-        emit newItem(expandToFullPath(root, value));
+        return expandToFullPath(root, value);
     }
 
     QString getValue(const QString& line) {
@@ -239,146 +169,228 @@ Version=2
 };
 }
 
+#define LINE_LIMIT  4096
+#define READ_LIMIT  64
+#define BATCH_SIZE  2048
+
 /////////////////////////////////////////////////////////////////////////////////////////////////
 
-class QPlaylistFileParserPrivate : public QObjectPrivate
+// Splits the playlist into lines and parses them on a thread of its own. The
+// data is handed over as it arrives, the entries come back in batches.
+class QPlaylistParserWorker : public QObject
 {
-    Q_DECLARE_PUBLIC(QPlaylistFileParser)
+    Q_OBJECT
 public:
-    QPlaylistFileParserPrivate()
-        : m_source(0)
-        , m_scanIndex(0)
-        , m_utf8(false)
+    QPlaylistParserWorker(const QUrl &root, bool utf8)
+        : m_root(root)
+        , m_utf8(utf8)
+        , m_received(0)
         , m_lineIndex(-1)
         , m_type(QPlaylistFileParser::UNKNOWN)
-        , m_currentParser(0)
+        , m_parser(0)
+        , m_done(false)
     {
     }
 
-    void _q_handleData();
-    void _q_handleError();
-    void _q_handleParserError(QPlaylistFileParser::ParserError err, const QString& errorMsg);
-    void _q_handleParserFinished();
+    ~QPlaylistParserWorker()
+    {
+        delete m_parser;
+    }
 
-    QNetworkReply  *m_source;
-    QByteArray      m_buffer;
-    int             m_scanIndex;
-    QUrl            m_root;
-    bool            m_utf8;
-    int             m_lineIndex;
-    QPlaylistFileParser::FileType m_type;
-    ParserBase     *m_currentParser;
-    QNetworkAccessManager m_mgr;
+    // Called from the parser's thread, makes the worker skip everything left
+    void cancel() { m_cancelled.store(1); }
+
+public Q_SLOTS:
+    void parse(const QByteArray &data, bool atEnd, const QString &mimeType);
+
+Q_SIGNALS:
+    void newItems(const QPlaylistFileParser::Batch &batch);
+    void finished();
+    void error(int err, const QString &errorMsg);
 
 private:
-    void processLine(int startIndex, int length);
+    bool processLine(const char *data, int length, qint64 lineEnd);
+    void flush();
+    void fail(QPlaylistFileParser::ParserError err, const QString &errorMsg);
+    void failLineTooLong();
+
+    QUrl m_root;
+    bool m_utf8;
+    QString m_mimeType;
+    QByteArray m_head;      // the start of the stream, to detect the playlist type
+    QByteArray m_pending;   // an incomplete line
+    qint64 m_received;
+    int m_lineIndex;
+    QPlaylistFileParser::FileType m_type;
+    ParserBase *m_parser;
+    QPlaylistFileParser::Batch m_batch;
+    QAtomicInt m_cancelled;
+    bool m_done;
 };
 
-#define LINE_LIMIT  4096
-#define READ_LIMIT  64
+void QPlaylistParserWorker::parse(const QByteArray &data, bool atEnd, const QString &mimeType)
+{
+    if (m_done || m_cancelled.load())
+        return;
+
+    if (m_mimeType.isEmpty())
+        m_mimeType = mimeType;
+    if (m_head.size() < LINE_LIMIT)
+        m_head.append(data.left(LINE_LIMIT - m_head.size()));
+
+    // Only the incomplete line from the last chunk is copied
+    const QByteArray buffer = m_pending.isEmpty() ? data : m_pending + data;
+    const qint64 bufferStart = m_received - m_pending.size();
+    m_received += data.size();
+    m_pending.clear();
+
+    const char *chars = buffer.constData();
+    const int size = buffer.size();
+    int lineStart = 0;
+    for (int i = 0; i < size; ++i) {
+        if (chars[i] != '\r' && chars[i] != '\n')
+            continue;
+
+        if (i - lineStart >= LINE_LIMIT) {
+            failLineTooLong();
+            return;
+        }
+        if (i > lineStart && !processLine(chars + lineStart, i - lineStart, bufferStart + i))
+            return;
+        lineStart = i + 1;
+
+        if (m_batch.count() >= BATCH_SIZE)
+            flush();
+        if (m_cancelled.load())
+            return;
+    }
+
+    if (size - lineStart >= LINE_LIMIT) {
+        failLineTooLong();
+        return;
+    }
+
+    if (!atEnd) {
+        m_pending = buffer.mid(lineStart);
+        flush();
+        return;
+    }
 
-void QPlaylistFileParserPrivate::processLine(int startIndex, int length)
+    // Last line
+    if (size > lineStart && !processLine(chars + lineStart, size - lineStart, bufferStart + size))
+        return;
+    flush();
+
+    m_done = true;
+    if (!m_parser)
+        emit error(QPlaylistFileParser::FormatNotSupportedError, QPlaylistFileParser::tr("Empty file provided"));
+    else
+        emit finished();
+}
+
+void QPlaylistParserWorker::failLineTooLong()
 {
-    Q_Q(QPlaylistFileParser);
-    m_lineIndex++;
+    qWarning() << "error parsing playlist["<< m_root << "] with line content >= 4096 bytes.";
+    fail(QPlaylistFileParser::FormatError, QPlaylistFileParser::tr("invalid line in playlist file"));
+}
 
-    if (!m_currentParser) {
-        Q_ASSERT(!m_currentParser);
+bool QPlaylistParserWorker::processLine(const char *data, int length, qint64 lineEnd)
+{
+    m_lineIndex++;
 
-        QString mimeType = m_source->header(QNetworkRequest::ContentTypeHeader).toString();
-        m_type = QPlaylistFileParser::findPlaylistType(m_root.toString(), mimeType, m_buffer.constData(), m_buffer.size());
+    if (!m_parser) {
+        // Detect the type from what used to be buffered when the first line was
+        // complete, the data was read READ_LIMIT bytes at a time.
+        const int headLength = int(qMin(qint64(m_head.size()), ((lineEnd + READ_LIMIT) / READ_LIMIT) * READ_LIMIT));
+        m_type = QPlaylistFileParser::findPlaylistType(m_root.toString(), m_mimeType, m_head.constData(), headLength);
 
         switch (m_type) {
         case QPlaylistFileParser::UNKNOWN:
-            emit q->error(QPlaylistFileParser::FormatError,
-                          QPlaylistFileParser::tr("%1 playlist type is unknown").arg(m_root.toString()));
-            q->stop();
-            return;
+            fail(QPlaylistFileParser::FormatError,
+                 QPlaylistFileParser::tr("%1 playlist type is unknown").arg(m_root.toString()));
+            return false;
         case QPlaylistFileParser::M3U:
-            m_currentParser = new M3UParser(q);
+            m_parser = new M3UParser;
             break;
         case QPlaylistFileParser::M3U8:
-            m_currentParser = new M3UParser(q);
+            m_parser = new M3UParser;
             m_utf8 = true;
             break;
         case QPlaylistFileParser::PLS:
-            m_currentParser = new PLSParser(q);
+            m_parser = new PLSParser;
             break;
         }
-        Q_ASSERT(m_currentParser);
-        QObject::connect(m_currentParser, SIGNAL(newItem(QVariant)), q, SIGNAL(newItem(QVariant)));
-        QObject::connect(m_currentParser, SIGNAL(finished()), q, SLOT(_q_handleParserFinished()));
-        QObject::connect(m_currentParser, SIGNAL(error(QPlaylistFileParser::ParserError,QString)),
-                         q, SLOT(_q_handleParserError(QPlaylistFileParser::ParserError,QString)));
     }
 
-    QString line;
+    const QString line = (m_utf8 ? QString::fromUtf8(data, length) : QString::fromLatin1(data, length)).trimmed();
+    if (line.isEmpty())
+        return true;
 
-    if (m_utf8) {
-        line = QString::fromUtf8(m_buffer.constData() + startIndex, length).trimmed();
-    } else {
-        line = QString::fromLatin1(m_buffer.constData() + startIndex, length).trimmed();
+    const QUrl url = m_parser->parseLine(m_lineIndex, line, m_root);
+    if (!url.isEmpty()) {
+        m_batch.urls.append(url.toEncoded());
+        m_batch.ends.append(m_batch.urls.size());
     }
-    if (line.isEmpty())
+    return true;
+}
+
+void QPlaylistParserWorker::flush()
+{
+    if (m_batch.count() == 0)
         return;
 
-    Q_ASSERT(m_currentParser);
-    m_currentParser->parseLine(m_lineIndex, line, m_root);
+    emit newItems(m_batch);
+    m_batch = QPlaylistFileParser::Batch();
 }
 
-void QPlaylistFileParserPrivate::_q_handleData()
+void QPlaylistParserWorker::fail(QPlaylistFileParser::ParserError err, const QString &errorMsg)
 {
-    Q_Q(QPlaylistFileParser);
-    while (m_source->bytesAvailable()) {
-        int expectedBytes = qMin(READ_LIMIT, int(qMin(m_source->bytesAvailable(),
-                                                      qint64(LINE_LIMIT - m_buffer.size()))));
-        m_buffer.push_back(m_source->read(expectedBytes));
-        int processedBytes = 0;
-        while (m_scanIndex < m_buffer.length()) {
-            char s = m_buffer[m_scanIndex];
-            if (s == '\r' || s == '\n') {
-                int l = m_scanIndex - processedBytes;
-                if (l > 0)
-                    processLine(processedBytes, l);
-                processedBytes = m_scanIndex + 1;
-                if (!m_source) {
-                    //some error happened, so exit parsing
-                    return;
-                }
-            }
-            m_scanIndex++;
-        }
+    m_done = true;
+    m_batch = QPlaylistFileParser::Batch();
+    emit error(err, errorMsg);
+}
 
-        if (m_buffer.length() - processedBytes >= LINE_LIMIT) {
-            qWarning() << "error parsing playlist["<< m_root << "] with line content >= 4096 bytes.";
-            emit q->error(QPlaylistFileParser::FormatError, QPlaylistFileParser::tr("invalid line in playlist file"));
-            q->stop();
-            return;
-        }
+/////////////////////////////////////////////////////////////////////////////////////////////////
 
-        if (m_source->isFinished() && !m_source->bytesAvailable()) {
-            //last line
-            processLine(processedBytes, -1);
-            break;
-        }
+class QPlaylistFileParserPrivate : public QObjectPrivate
+{
+    Q_DECLARE_PUBLIC(QPlaylistFileParser)
+public:
+    QPlaylistFileParserPrivate()
+        : m_source(0)
+        , m_utf8(false)
+        , m_atEnd(false)
+        , m_worker(0)
+    {
+    }
 
-        Q_ASSERT(m_buffer.length() == m_scanIndex);
-        if (processedBytes == 0)
-            continue;
+    void _q_handleData();
+    void _q_handleError();
+    void _q_handleParserItems(const QPlaylistFileParser::Batch &batch);
+    void _q_handleParserError(int err, const QString& errorMsg);
+    void _q_handleParserFinished();
 
-        int copyLength = m_buffer.length() - processedBytes;
-        if (copyLength > 0) {
-            Q_ASSERT(copyLength <= READ_LIMIT);
-            m_buffer = m_buffer.right(copyLength);
-        } else {
-            m_buffer.clear();
-        }
-        m_scanIndex = 0;
-    }
+    QNetworkReply  *m_source;
+    QUrl            m_root;
+    bool            m_utf8;
+    bool            m_atEnd;
+    QPlaylistParserWorker *m_worker;
+    QNetworkAccessManager m_mgr;
+};
 
-    if (m_source->isFinished()) {
-        _q_handleParserFinished();
-    }
+void QPlaylistFileParserPrivate::_q_handleData()
+{
+    if (!m_source || m_atEnd)
+        return;
+
+    const QByteArray data = m_source->readAll();
+    m_atEnd = m_source->isFinished() && !m_source->bytesAvailable();
+    if (data.isEmpty() && !m_atEnd)
+        return;
+
+    const QString mimeType = m_source->header(QNetworkRequest::ContentTypeHeader).toString();
+    QMetaObject::invokeMethod(m_worker, "parse", Qt::QueuedConnection,
+                              Q_ARG(QByteArray, data), Q_ARG(bool, m_atEnd), Q_ARG(QString, mimeType));
 }
 
 void QPlaylistFileParserPrivate::_q_handleError()
@@ -388,30 +400,46 @@ void QPlaylistFileParserPrivate::_q_handleError()
     q->stop();
 }
 
-void QPlaylistFileParserPrivate::_q_handleParserError(QPlaylistFileParser::ParserError err, const QString& errorMsg)
+// Signals still queued from a worker that has been stopped are dropped
+void QPlaylistFileParserPrivate::_q_handleParserItems(const QPlaylistFileParser::Batch &batch)
 {
     Q_Q(QPlaylistFileParser);
-    emit q->error(err, errorMsg);
+    if (!m_worker || q->sender() != m_worker)
+        return;
+
+    emit q->newItems(batch);
 }
 
-void QPlaylistFileParserPrivate::_q_handleParserFinished()
+void QPlaylistFileParserPrivate::_q_handleParserError(int err, const QString& errorMsg)
 {
     Q_Q(QPlaylistFileParser);
-    bool isParserValid = (m_currentParser != 0);
-    if (!isParserValid)
-        emit q->error(QPlaylistFileParser::FormatNotSupportedError, QPlaylistFileParser::tr("Empty file provided"));
+    if (!m_worker || q->sender() != m_worker)
+        return;
 
     q->stop();
+    emit q->error(QPlaylistFileParser::ParserError(err), errorMsg);
+}
+
+void QPlaylistFileParserPrivate::_q_handleParserFinished()
+{
+    Q_Q(QPlaylistFileParser);
+    if (!m_worker || q->sender() != m_worker)
+        return;
 
-    if (isParserValid)
-        emit q->finished();
+    q->stop();
+    emit q->finished();
 }
 
 
 QPlaylistFileParser::QPlaylistFileParser(QObject *parent)
     : QObject(*new QPlaylistFileParserPrivate, parent)
 {
+    qRegisterMetaType<QPlaylistFileParser::Batch>();
+}
 
+QPlaylistFileParser::~QPlaylistFileParser()
+{
+    stop();
 }
 
 QPlaylistFileParser::FileType QPlaylistFileParser::findPlaylistType(const QString& uri, const QString& mime, const void *data, quint32 size)
@@ -466,12 +494,12 @@ QPlaylistFileParser::FileType QPlaylistFileParser::findPlaylistType(const QStrin
     return UNKNOWN;
 }
 
+
 void QPlaylistFileParser::start(const QNetworkRequest& request, bool utf8)
 {
     Q_D(QPlaylistFileParser);
     stop();
 
-    d->m_type = UNKNOWN;
     d->m_utf8 = utf8;
     d->m_root = request.url();
 
@@ -480,6 +508,20 @@ void QPlaylistFileParser::start(const QNetworkRequest& request, bool utf8)
         return;
     }
 
+    // The thread and worker delete themselves once the thread has quit
+    QThread *thread = new QThread;
+    thread->setObjectName(QLatin1String("QPlaylistFileParser"));
+    d->m_worker = new QPlaylistParserWorker(d->m_root, utf8);
+    d->m_worker->moveToThread(thread);
+    connect(thread, SIGNAL(finished()), d->m_worker, SLOT(deleteLater()));
+    connect(thread, SIGNAL(finished()), thread, SLOT(deleteLater()));
+    connect(d->m_worker, SIGNAL(newItems(QPlaylistFileParser::Batch)),
+            this, SLOT(_q_handleParserItems(QPlaylistFileParser::Batch)));
+    connect(d->m_worker, SIGNAL(finished()), this, SLOT(_q_handleParserFinished()));
+    connect(d->m_worker, SIGNAL(error(int,QString)), this, SLOT(_q_handleParserError(int,QString)));
+    thread->start();
+
+    d->m_atEnd = false;
     d->m_source = d->m_mgr.get(request);
 
     connect(d->m_source, SIGNAL(readyRead()), this, SLOT(_q_handleData()));
@@ -492,18 +534,13 @@ void QPlaylistFileParser::start(const QNetworkRequest& request, bool utf8)
 void QPlaylistFileParser::stop()
 {
     Q_D(QPlaylistFileParser);
-    if (d->m_currentParser) {
-        disconnect(d->m_currentParser, SIGNAL(newItem(QVariant)), this, SIGNAL(newItem(QVariant)));
-        disconnect(d->m_currentParser, SIGNAL(finished()), this, SLOT(_q_handleParserFinished()));
-        disconnect(d->m_currentParser, SIGNAL(error(QPlaylistFileParser::ParserError,QString)),
-                   this, SLOT(_q_handleParserError(QPlaylistFileParser::ParserError,QString)));
-        d->m_currentParser->deleteLater();
-        d->m_currentParser = 0;
+    if (d->m_worker) {
+        disconnect(d->m_worker, 0, this, 0);
+        d->m_worker->cancel();
+        d->m_worker->thread()->quit();
+        d->m_worker = 0;
     }
 
-    d->m_buffer.clear();
-    d->m_scanIndex = 0;
-    d->m_lineIndex = -1;
     if (d->m_source) {
         disconnect(d->m_source, SIGNAL(readyRead()), this, SLOT(_q_handleData()));
         disconnect(d->m_source, SIGNAL(finished()), this, SLOT(_q_handleData()));
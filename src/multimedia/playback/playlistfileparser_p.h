@@ -46,6 +46,8 @@
 //
 
 #include "qtmultimediadefs.h"
+#include <QtCore/qmetatype.h>
+#include <QtCore/qvector.h>
 #include <QtNetwork/QNetworkRequest>
 
 QT_BEGIN_NAMESPACE
@@ -57,6 +59,7 @@ class Q_MULTIMEDIA_EXPORT QPlaylistFileParser : public QObject
     Q_OBJECT
 public:
     QPlaylistFileParser(QObject *parent = 0);
+    ~QPlaylistFileParser();
 
     enum FileType
     {
@@ -74,13 +77,26 @@ public:
         NetworkError
     };
 
+    // Entries are handed out in batches, with their encoded URLs packed one
+    // after the other.
+    struct Batch
+    {
+        QByteArray urls;
+        QVector<int> ends;
+
+        int count() const { return ends.size(); }
+        int offset(int i) const { return i > 0 ? ends.at(i - 1) : 0; }
+        int length(int i) const { return ends.at(i) - offset(i); }
+        QUrl url(int i) const { return QUrl::fromEncoded(urls.mid(offset(i), length(i))); }
+    };
+
     static FileType findPlaylistType(const QString& uri, const QString& mime, const void *data, quint32 size);
 
     void start(const QNetworkRequest &request, bool utf8 = false);
     void stop();
 
 Q_SIGNALS:
-    void newItem(const QVariant& content);
+    void newItems(const QPlaylistFileParser::Batch &batch);
     void finished();
     void error(QPlaylistFileParser::ParserError err, const QString& errorMsg);
 
@@ -89,10 +105,13 @@ private:
     Q_DECLARE_PRIVATE(QPlaylistFileParser)
     Q_PRIVATE_SLOT(d_func(), void _q_handleData())
     Q_PRIVATE_SLOT(d_func(), void _q_handleError())
-    Q_PRIVATE_SLOT(d_func(), void _q_handleParserError(QPlaylistFileParser::ParserError err, const QString& errorMsg))
+    Q_PRIVATE_SLOT(d_func(), void _q_handleParserItems(const QPlaylistFileParser::Batch &batch))
+    Q_PRIVATE_SLOT(d_func(), void _q_handleParserError(int err, const QString& errorMsg))
     Q_PRIVATE_SLOT(d_func(), void _q_handleParserFinished())
 };
 
 QT_END_NAMESPACE
 
+Q_DECLARE_METATYPE(QPlaylistFileParser::Batch)
+
 #endif // PLAYLISTFILEPARSER_P_H
@@ -39,17 +39,49 @@
 
 QT_BEGIN_NAMESPACE
 
+// An entry refers to its encoded URL in one of the arena chunks, or for media
+// that a URL alone doesn't describe, to a QMediaContent.
+struct QPlaylistEntry
+{
+    int chunk;      // -1 for entries in contents
+    int offset;     // or the index in contents
+    int length;
+};
+Q_DECLARE_TYPEINFO(QPlaylistEntry, Q_PRIMITIVE_TYPE);
+
 class QMediaNetworkPlaylistProviderPrivate: public QMediaPlaylistProviderPrivate
 {
     Q_DECLARE_NON_CONST_PUBLIC(QMediaNetworkPlaylistProvider)
 public:
+    QMediaNetworkPlaylistProviderPrivate()
+        : editChunk(-1)
+        , arenaBytes(0)
+        , liveBytes(0)
+        , deadContents(0)
+    {
+    }
+
     bool load(const QNetworkRequest &request);
 
+    QPlaylistEntry createEntry(const QMediaContent &content);
+    QMediaContent content(const QPlaylistEntry &entry) const;
+    void release(int from, int to);
+    void compact();
+    void reset();
+
     QPlaylistFileParser parser;
-    QList<QMediaContent> resources;
+
+    // QMediaContent is only constructed when media() asks for it
+    QVector<QByteArray> chunks;
+    QVector<QPlaylistEntry> entries;
+    QVector<QMediaContent> contents;
+    int editChunk;
+    qint64 arenaBytes;
+    qint64 liveBytes;
+    int deadContents;
 
     void _q_handleParserError(QPlaylistFileParser::ParserError err, const QString &);
-    void _q_handleNewItem(const QVariant& content);
+    void _q_handleNewItems(const QPlaylistFileParser::Batch &batch);
 
     QMediaNetworkPlaylistProvider *q_ptr;
 };
@@ -62,6 +94,103 @@ bool QMediaNetworkPlaylistProviderPrivate::load(const QNetworkRequest &request)
     return true;
 }
 
+QPlaylistEntry QMediaNetworkPlaylistProviderPrivate::createEntry(const QMediaContent &content)
+{
+    QPlaylistEntry entry;
+
+    const QByteArray encoded = content.canonicalUrl().toEncoded();
+    if (!encoded.isEmpty() && content == QMediaContent(QUrl::fromEncoded(encoded))) {
+        if (editChunk < 0) {
+            editChunk = chunks.size();
+            chunks.append(QByteArray());
+        }
+        QByteArray &chunk = chunks[editChunk];
+        entry.chunk = editChunk;
+        entry.offset = chunk.size();
+        entry.length = encoded.size();
+        chunk.append(encoded);
+        arenaBytes += encoded.size();
+        liveBytes += encoded.size();
+    } else {
+        entry.chunk = -1;
+        entry.offset = contents.size();
+        entry.length = 0;
+        contents.append(content);
+    }
+
+    return entry;
+}
+
+QMediaContent QMediaNetworkPlaylistProviderPrivate::content(const QPlaylistEntry &entry) const
+{
+    if (entry.chunk < 0)
+        return contents.at(entry.offset);
+
+    const QByteArray &chunk = chunks.at(entry.chunk);
+    return QMediaContent(QUrl::fromEncoded(QByteArray::fromRawData(chunk.constData() + entry.offset, entry.length)));
+}
+
+// Forgets the entries in [from, to] before they are removed
+void QMediaNetworkPlaylistProviderPrivate::release(int from, int to)
+{
+    for (int i = from; i <= to; ++i) {
+        const QPlaylistEntry &entry = entries.at(i);
+        if (entry.chunk < 0) {
+            contents[entry.offset] = QMediaContent();
+            ++deadContents;
+        } else {
+            liveBytes -= entry.length;
+        }
+    }
+}
+
+// Rebuilds the arena once most of it belongs to removed entries
+void QMediaNetworkPlaylistProviderPrivate::compact()
+{
+    if (entries.isEmpty()) {
+        reset();
+        return;
+    }
+
+    if (arenaBytes <= 2 * liveBytes + 65536 && deadContents <= contents.size() / 2)
+        return;
+
+    QByteArray arena;
+    arena.reserve(int(liveBytes));
+    QVector<QMediaContent> liveContents;
+    liveContents.reserve(contents.size() - deadContents);
+
+    for (int i = 0; i < entries.size(); ++i) {
+        QPlaylistEntry &entry = entries[i];
+        if (entry.chunk < 0) {
+            liveContents.append(contents.at(entry.offset));
+            entry.offset = liveContents.size() - 1;
+        } else {
+            const int offset = arena.size();
+            arena.append(chunks.at(entry.chunk).constData() + entry.offset, entry.length);
+            entry.chunk = 0;
+            entry.offset = offset;
+        }
+    }
+
+    chunks.clear();
+    chunks.append(arena);
+    editChunk = 0;
+    arenaBytes = liveBytes = arena.size();
+    contents = liveContents;
+    deadContents = 0;
+}
+
+void QMediaNetworkPlaylistProviderPrivate::reset()
+{
+    chunks.clear();
+    entries.clear();
+    contents.clear();
+    editChunk = -1;
+    arenaBytes = liveBytes = 0;
+    deadContents = 0;
+}
+
 void QMediaNetworkPlaylistProviderPrivate::_q_handleParserError(QPlaylistFileParser::ParserError err, const QString &errorMessage)
 {
     Q_Q(QMediaNetworkPlaylistProvider);
@@ -87,28 +216,40 @@ void QMediaNetworkPlaylistProviderPrivate::_q_handleParserError(QPlaylistFilePar
     emit q->loadFailed(playlistError, errorMessage);
 }
 
-void QMediaNetworkPlaylistProviderPrivate::_q_handleNewItem(const QVariant& content)
+// The parsed URLs are kept as they are, the batch becomes an arena chunk
+void QMediaNetworkPlaylistProviderPrivate::_q_handleNewItems(const QPlaylistFileParser::Batch &batch)
 {
     Q_Q(QMediaNetworkPlaylistProvider);
 
-    QUrl url;
-    if (content.type() == QVariant::Url) {
-        url = content.toUrl();
-    } else if (content.type() == QVariant::Map) {
-        url = content.toMap()[QLatin1String("url")].toUrl();
-    } else {
+    const int count = batch.count();
+    if (count == 0)
         return;
-    }
 
-    q->addMedia(QMediaContent(url));
+    const int chunk = chunks.size();
+    chunks.append(batch.urls);
+    arenaBytes += batch.urls.size();
+    liveBytes += batch.urls.size();
+    // Keep edits out of a chunk that is shared with the parser's batch
+    editChunk = -1;
+
+    const int pos = entries.size();
+    emit q->mediaAboutToBeInserted(pos, pos + count - 1);
+    entries.resize(pos + count);
+    for (int i = 0; i < count; ++i) {
+        QPlaylistEntry &entry = entries[pos + i];
+        entry.chunk = chunk;
+        entry.offset = batch.offset(i);
+        entry.length = batch.length(i);
+    }
+    emit q->mediaInserted(pos, pos + count - 1);
 }
 
 QMediaNetworkPlaylistProvider::QMediaNetworkPlaylistProvider(QObject *parent)
     :QMediaPlaylistProvider(*new QMediaNetworkPlaylistProviderPrivate, parent)
 {
     d_func()->q_ptr = this;
-    connect(&d_func()->parser, SIGNAL(newItem(QVariant)),
-            this, SLOT(_q_handleNewItem(QVariant)));
+    connect(&d_func()->parser, SIGNAL(newItems(QPlaylistFileParser::Batch)),
+            this, SLOT(_q_handleNewItems(QPlaylistFileParser::Batch)));
     connect(&d_func()->parser, SIGNAL(finished()), this, SIGNAL(loaded()));
     connect(&d_func()->parser, SIGNAL(error(QPlaylistFileParser::ParserError,QString)),
             this, SLOT(_q_handleParserError(QPlaylistFileParser::ParserError,QString)));
@@ -131,22 +272,26 @@ bool QMediaNetworkPlaylistProvider::load(const QNetworkRequest &request, const c
 
 int QMediaNetworkPlaylistProvider::mediaCount() const
 {
-    return d_func()->resources.size();
+    return d_func()->entries.size();
 }
 
 QMediaContent QMediaNetworkPlaylistProvider::media(int pos) const
 {
-    return d_func()->resources.value(pos);
+    Q_D(const QMediaNetworkPlaylistProvider);
+    if (pos < 0 || pos >= d->entries.size())
+        return QMediaContent();
+
+    return d->content(d->entries.at(pos));
 }
 
 bool QMediaNetworkPlaylistProvider::addMedia(const QMediaContent &content)
 {
     Q_D(QMediaNetworkPlaylistProvider);
 
-    int pos = d->resources.count();
+    int pos = d->entries.count();
 
     emit mediaAboutToBeInserted(pos, pos);
-    d->resources.append(content);
+    d->entries.append(d->createEntry(content));
     emit mediaInserted(pos, pos);
 
     return true;
@@ -159,11 +304,13 @@ bool QMediaNetworkPlaylistProvider::addMedia(const QList<QMediaContent> &items)
     if (items.isEmpty())
         return true;
 
-    int pos = d->resources.count();
+    int pos = d->entries.count();
     int end = pos+items.count()-1;
 
     emit mediaAboutToBeInserted(pos, end);
-    d->resources.append(items);
+    d->entries.reserve(end + 1);
+    for (int i=0; i<items.count(); i++)
+        d->entries.append(d->createEntry(items.at(i)));
     emit mediaInserted(pos, end);
 
     return true;
@@ -175,7 +322,7 @@ bool QMediaNetworkPlaylistProvider::insertMedia(int pos, const QMediaContent &co
     Q_D(QMediaNetworkPlaylistProvider);
 
     emit mediaAboutToBeInserted(pos, pos);
-    d->resources.insert(pos, content);
+    d->entries.insert(pos, d->createEntry(content));
     emit mediaInserted(pos,pos);
 
     return true;
@@ -191,8 +338,9 @@ bool QMediaNetworkPlaylistProvider::insertMedia(int pos, const QList<QMediaConte
     const int last = pos+items.count()-1;
 
     emit mediaAboutToBeInserted(pos, last);
+    d->entries.insert(pos, items.count(), QPlaylistEntry());
     for (int i=0; i<items.count(); i++)
-        d->resources.insert(pos+i, items.at(i));
+        d->entries[pos+i] = d->createEntry(items.at(i));
     emit mediaInserted(pos, last);
 
     return true;
@@ -207,7 +355,9 @@ bool QMediaNetworkPlaylistProvider::removeMedia(int fromPos, int toPos)
     Q_ASSERT(toPos < mediaCount());
 
     emit mediaAboutToBeRemoved(fromPos, toPos);
-    d->resources.erase(d->resources.begin()+fromPos, d->resources.begin()+toPos+1);
+    d->release(fromPos, toPos);
+    d->entries.erase(d->entries.begin()+fromPos, d->entries.begin()+toPos+1);
+    d->compact();
     emit mediaRemoved(fromPos, toPos);
 
     return true;
@@ -218,7 +368,9 @@ bool QMediaNetworkPlaylistProvider::removeMedia(int pos)
     Q_D(QMediaNetworkPlaylistProvider);
 
     emit mediaAboutToBeRemoved(pos, pos);
-    d->resources.removeAt(pos);
+    d->release(pos, pos);
+    d->entries.remove(pos);
+    d->compact();
     emit mediaRemoved(pos, pos);
 
     return true;
@@ -227,10 +379,10 @@ bool QMediaNetworkPlaylistProvider::removeMedia(int pos)
 bool QMediaNetworkPlaylistProvider::clear()
 {
     Q_D(QMediaNetworkPlaylistProvider);
-    if (!d->resources.isEmpty()) {
+    if (!d->entries.isEmpty()) {
         int lastPos = mediaCount()-1;
         emit mediaAboutToBeRemoved(0, lastPos);
-        d->resources.clear();
+        d->reset();
         emit mediaRemoved(0, lastPos);
     }
 
@@ -240,14 +392,10 @@ bool QMediaNetworkPlaylistProvider::clear()
 void QMediaNetworkPlaylistProvider::shuffle()
 {
     Q_D(QMediaNetworkPlaylistProvider);
-    if (!d->resources.isEmpty()) {
-        QList<QMediaContent> resources;
-
-        while (!d->resources.isEmpty()) {
-            resources.append(d->resources.takeAt(qrand() % d->resources.size()));
-        }
+    if (!d->entries.isEmpty()) {
+        for (int i = d->entries.size() - 1; i > 0; --i)
+            qSwap(d->entries[i], d->entries[qrand() % (i + 1)]);
 
-        d->resources = resources;
         emit mediaChanged(0, mediaCount()-1);
     }
 
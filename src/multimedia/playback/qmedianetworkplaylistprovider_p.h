@@ -80,7 +80,7 @@ private:
     Q_DISABLE_COPY(QMediaNetworkPlaylistProvider)
     Q_DECLARE_PRIVATE(QMediaNetworkPlaylistProvider)
     Q_PRIVATE_SLOT(d_func(), void _q_handleParserError(QPlaylistFileParser::ParserError err, const QString &))
-    Q_PRIVATE_SLOT(d_func(), void _q_handleNewItem(const QVariant& content))
+    Q_PRIVATE_SLOT(d_func(), void _q_handleNewItems(const QPlaylistFileParser::Batch &batch))
 };
 
 QT_END_NAMESPACE
@@ -37,6 +37,7 @@
 #include "qmediaobject_p.h"
 
 #include <QtCore/qdebug.h>
+#include <QtCore/qvector.h>
 
 QT_BEGIN_NAMESPACE
 
@@ -51,6 +52,413 @@ public:
 
 Q_GLOBAL_STATIC(QMediaPlaylistNullProvider, _q_nullMediaPlaylist)
 
+/*
+    Random playback order.
+
+    The order is an endless sequence of laps; every lap visits each item of
+    the playlist exactly once. A lap is a keyed pseudo random permutation of
+    [0, count): a balanced Feistel network over the smallest even number of
+    bits covering the count, restricted to the range by cycle walking. Both
+    directions are cheap to evaluate, so the item at any step, and the step
+    of any item, is found in constant time and memory without materialising
+    the order.
+
+    Each lap uses its own key derived from the seed, so consecutive laps are
+    shuffled differently. If a lap would start with the item the previous lap
+    ended with, its first two steps are swapped to avoid playing the same
+    item twice in a row.
+
+    When items are inserted or removed, the lap in progress keeps its order:
+    the remaining items keep their steps and inserted items are folded in
+    among the steps not played yet. The lap stays the permutation it started
+    with and the changes are recorded on top of it, one entry per change to
+    remap item indexes and one per inserted or removed item to remap steps.
+    Lookups walk these entries, so there are at most MaximumEdits of them; a
+    change that does not fit reshuffles the rest of the lap over the new
+    count instead. The entries are dropped once playback leaves the lap.
+    Other laps are evaluated over the new count.
+*/
+class QMediaPlaylistShuffle
+{
+public:
+    QMediaPlaylistShuffle()
+        : m_seed(0)
+        , m_count(0)
+        , m_halfBits(0)
+        , m_editedLap(0)
+        , m_baseCount(0)
+        , m_baseHalfBits(0)
+        , m_baseSwapped(false)
+        , m_nextId(0)
+    {
+    }
+
+    void setSeed(quint64 seed) { m_seed = seed; }
+
+    int count() const { return m_count; }
+
+    // Starts over with every lap shuffled over \a count items.
+    void setCount(int count)
+    {
+        dropEdits();
+        setDomain(count);
+    }
+
+    // Forgets the changes recorded for a lap once \a step is outside of it.
+    void releaseEdits(qint64 step)
+    {
+        if (!m_indexEdits.isEmpty() && (m_count == 0 || lapOf(step) != m_editedLap))
+            dropEdits();
+    }
+
+    // Items [start, end] were inserted while at \a step; returns the step
+    // the same item is at afterwards.
+    qint64 insertItems(qint64 step, int start, int end)
+    {
+        const int inserted = end - start + 1;
+        const qint64 lap = lapOf(step);
+        const int index = int(step - lap * m_count);
+
+        if (editCount(lap) + inserted + 1 > MaximumEdits) {
+            int item = itemAt(step);
+            if (item >= start)
+                item += inserted;
+            setCount(m_count + inserted);
+            return stepOf(lap, item);
+        }
+
+        beginEdits(lap);
+
+        const IndexEdit edit = { start, inserted, m_nextId };
+        m_indexEdits.append(edit);
+        m_nextId += inserted;
+
+        for (int i = 0; i < inserted; ++i) {
+            const int id = edit.firstId + i;
+            const quint64 choices = quint64(m_count + i - index);
+            const quint64 hash = mix(lapKey(lap) ^ (quint64(id) << 32) ^ quint64(m_count + i));
+            const StepEdit stepEdit = { index + 1 + int(hash % choices), id };
+            m_stepEdits.append(stepEdit);
+        }
+
+        setDomain(m_count + inserted);
+        return lap * m_count + index;
+    }
+
+    // Items [start, end] were removed while at \a step; returns the step of
+    // the last remaining item played up to it, in the same lap.
+    qint64 removeItems(qint64 step, int start, int end)
+    {
+        const int removed = end - start + 1;
+        if (removed >= m_count) {
+            setCount(0);
+            return -1;
+        }
+
+        const qint64 lap = lapOf(step);
+        int index = int(step - lap * m_count);
+
+        if (editCount(lap) + removed + 1 > MaximumEdits) {
+            const int item = itemAt(step);
+            setCount(m_count - removed);
+            if (item > end)
+                return stepOf(lap, item - removed);
+            if (item < start)
+                return stepOf(lap, item);
+            return lap * m_count + qMin(index, m_count - 1);
+        }
+
+        beginEdits(lap);
+
+        // The indexes are remapped last, the items are looked up as they were
+        for (int item = start; item <= end; ++item) {
+            const StepEdit stepEdit = { stepOfId(idOfIndex(item)), -1 };
+            m_stepEdits.append(stepEdit);
+            if (stepEdit.step <= index)
+                --index;
+        }
+
+        const IndexEdit edit = { start, -removed, -1 };
+        m_indexEdits.append(edit);
+
+        setDomain(m_count - removed);
+        return lap * m_count + index;
+    }
+
+    qint64 lapOf(qint64 step) const
+    {
+        return step >= 0 ? step / m_count : -((-step - 1) / m_count) - 1;
+    }
+
+    int itemAt(qint64 step) const
+    {
+        const qint64 lap = lapOf(step);
+        int index = int(step - lap * m_count);
+        if (isEdited(lap))
+            return indexOfId(idAtStep(index));
+        if (index <= 1 && startsWithRepeat(lap))
+            index = 1 - index;
+        return permute(lapKey(lap), index, m_count, m_halfBits);
+    }
+
+    qint64 stepOf(qint64 lap, int item) const
+    {
+        if (isEdited(lap))
+            return lap * m_count + stepOfId(idOfIndex(item));
+
+        int index = unpermute(lapKey(lap), item, m_count, m_halfBits);
+        if (index <= 1 && startsWithRepeat(lap))
+            index = 1 - index;
+        return lap * m_count + index;
+    }
+
+private:
+    enum { Rounds = 4, MaximumEdits = 256 };
+
+    // Items [start, start + count) were inserted, with ids from firstId on,
+    // or removed when count is negative.
+    struct IndexEdit
+    {
+        int start;
+        int count;
+        int firstId;
+    };
+
+    // The item with the given id was inserted at step, or the item at step
+    // was removed when id is -1.
+    struct StepEdit
+    {
+        int step;
+        int id;
+    };
+
+    static int halfBitsFor(int count)
+    {
+        int bits = 0;
+        while (bits < 32 && (quint64(1) << bits) < quint64(count))
+            ++bits;
+        return (bits + 1) / 2;
+    }
+
+    void setDomain(int count)
+    {
+        m_count = qMax(count, 0);
+        m_halfBits = halfBitsFor(m_count);
+    }
+
+    bool isEdited(qint64 lap) const
+    {
+        return lap == m_editedLap && !m_indexEdits.isEmpty();
+    }
+
+    int editCount(qint64 lap) const
+    {
+        return isEdited(lap) ? m_indexEdits.size() + m_stepEdits.size() : 0;
+    }
+
+    // Items of the lap are identified by their index when its first change
+    // was recorded; inserted items get the ids following them.
+    void beginEdits(qint64 lap)
+    {
+        if (isEdited(lap))
+            return;
+
+        const bool swapped = startsWithRepeat(lap);
+        dropEdits();
+        m_editedLap = lap;
+        m_baseCount = m_count;
+        m_baseHalfBits = m_halfBits;
+        m_baseSwapped = swapped;
+        m_nextId = m_count;
+    }
+
+    void dropEdits()
+    {
+        m_indexEdits = QVector<IndexEdit>();
+        m_stepEdits = QVector<StepEdit>();
+        m_nextId = 0;
+    }
+
+    int idOfIndex(int index) const
+    {
+        for (int i = m_indexEdits.size() - 1; i >= 0; --i) {
+            const IndexEdit &edit = m_indexEdits.at(i);
+            if (edit.count > 0) {
+                if (index >= edit.start + edit.count)
+                    index -= edit.count;
+                else if (index >= edit.start)
+                    return edit.firstId + index - edit.start;
+            } else if (index >= edit.start) {
+                index -= edit.count;
+            }
+        }
+        return index;
+    }
+
+    // Returns -1 if the item was removed since.
+    int indexOfId(int id) const
+    {
+        int index = id;
+        int i = 0;
+        if (id >= m_baseCount) {
+            while (m_indexEdits.at(i).count < 0 || id >= m_indexEdits.at(i).firstId + m_indexEdits.at(i).count)
+                ++i;
+            index = m_indexEdits.at(i).start + id - m_indexEdits.at(i).firstId;
+            ++i;
+        }
+
+        for (; i < m_indexEdits.size(); ++i) {
+            const IndexEdit &edit = m_indexEdits.at(i);
+            if (edit.count > 0) {
+                if (index >= edit.start)
+                    index += edit.count;
+            } else if (index >= edit.start - edit.count) {
+                index += edit.count;
+            } else if (index >= edit.start) {
+                return -1;
+            }
+        }
+        return index;
+    }
+
+    int idAtStep(int index) const
+    {
+        for (int i = m_stepEdits.size() - 1; i >= 0; --i) {
+            const StepEdit &edit = m_stepEdits.at(i);
+            if (edit.id >= 0) {
+                if (index == edit.step)
+                    return edit.id;
+                if (index > edit.step)
+                    --index;
+            } else if (index >= edit.step) {
+                ++index;
+            }
+        }
+
+        if (index <= 1 && m_baseSwapped)
+            index = 1 - index;
+        return permute(lapKey(m_editedLap), index, m_baseCount, m_baseHalfBits);
+    }
+
+    // Returns -1 if the item was removed since.
+    int stepOfId(int id) const
+    {
+        int index;
+        int i = 0;
+        if (id < m_baseCount) {
+            index = unpermute(lapKey(m_editedLap), id, m_baseCount, m_baseHalfBits);
+            if (index <= 1 && m_baseSwapped)
+                index = 1 - index;
+        } else {
+            while (m_stepEdits.at(i).id != id)
+                ++i;
+            index = m_stepEdits.at(i).step;
+            ++i;
+        }
+
+        for (; i < m_stepEdits.size(); ++i) {
+            const StepEdit &edit = m_stepEdits.at(i);
+            if (edit.id >= 0) {
+                if (index >= edit.step)
+                    ++index;
+            } else if (index == edit.step) {
+                return -1;
+            } else if (index > edit.step) {
+                --index;
+            }
+        }
+        return index;
+    }
+
+    int lastItemOf(qint64 lap) const
+    {
+        return itemAt(lap * m_count + m_count - 1);
+    }
+
+    static quint64 mix(quint64 x)
+    {
+        x ^= x >> 30;
+        x *= Q_UINT64_C(0xbf58476d1ce4e5b9);
+        x ^= x >> 27;
+        x *= Q_UINT64_C(0x94d049bb133111eb);
+        x ^= x >> 31;
+        return x;
+    }
+
+    quint64 lapKey(qint64 lap) const
+    {
+        return mix(m_seed + quint64(lap) * Q_UINT64_C(0x9e3779b97f4a7c15));
+    }
+
+    static quint64 round(quint64 key, int round, quint64 half, int halfBits)
+    {
+        return mix(key ^ (quint64(round + 1) << 56) ^ half) & ((quint64(1) << halfBits) - 1);
+    }
+
+    static int permute(quint64 key, int index, int count, int halfBits)
+    {
+        if (count < 2)
+            return index;
+
+        const quint64 mask = (quint64(1) << halfBits) - 1;
+        quint64 value = quint64(index);
+        do {
+            quint64 left = value >> halfBits;
+            quint64 right = value & mask;
+            for (int i = 0; i < Rounds; ++i) {
+                const quint64 next = left ^ round(key, i, right, halfBits);
+                left = right;
+                right = next;
+            }
+            value = (left << halfBits) | right;
+        } while (value >= quint64(count));
+
+        return int(value);
+    }
+
+    static int unpermute(quint64 key, int item, int count, int halfBits)
+    {
+        if (count < 2)
+            return item;
+
+        const quint64 mask = (quint64(1) << halfBits) - 1;
+        quint64 value = quint64(item);
+        do {
+            quint64 left = value >> halfBits;
+            quint64 right = value & mask;
+            for (int i = Rounds - 1; i >= 0; --i) {
+                const quint64 previous = right ^ round(key, i, left, halfBits);
+                right = left;
+                left = previous;
+            }
+            value = (left << halfBits) | right;
+        } while (value >= quint64(count));
+
+        return int(value);
+    }
+
+    // The last step of a lap is never swapped, so this does not recurse.
+    bool startsWithRepeat(qint64 lap) const
+    {
+        return m_count > 2
+                && permute(lapKey(lap), 0, m_count, m_halfBits) == lastItemOf(lap - 1);
+    }
+
+    quint64 m_seed;
+    int m_count;
+    int m_halfBits;
+
+    // The changes recorded for the lap in progress, over the permutation of
+    // m_baseCount items it started with
+    qint64 m_editedLap;
+    int m_baseCount;
+    int m_baseHalfBits;
+    bool m_baseSwapped;
+    int m_nextId;
+    QVector<IndexEdit> m_indexEdits;
+    QVector<StepEdit> m_stepEdits;
+};
+
 class QMediaPlaylistNavigatorPrivate
 {
     Q_DECLARE_NON_CONST_PUBLIC(QMediaPlaylistNavigator)
@@ -60,7 +468,7 @@ public:
         currentPos(-1),
         lastValidPos(-1),
         playbackMode(QMediaPlaylist::Sequential),
-        randomPositionsOffset(-1)
+        randomStep(-1)
     {
     }
 
@@ -70,12 +478,15 @@ public:
     QMediaPlaylist::PlaybackMode playbackMode;
     QMediaContent currentItem;
 
-    mutable QList<int> randomModePositions;
-    mutable int randomPositionsOffset;
+    mutable QMediaPlaylistShuffle shuffle;
+    mutable qint64 randomStep;
 
     int nextItemPos(int steps = 1) const;
     int previousItemPos(int steps = 1) const;
 
+    void resetShuffle();
+    void syncShuffle() const;
+
     void _q_mediaInserted(int start, int end);
     void _q_mediaRemoved(int start, int end);
     void _q_mediaChanged(int start, int end);
@@ -83,6 +494,55 @@ public:
     QMediaPlaylistNavigator *q_ptr;
 };
 
+/*
+    Starts a new random order, positioned on the current item.
+*/
+void QMediaPlaylistNavigatorPrivate::resetShuffle()
+{
+    shuffle.setSeed((quint64(quint32(qrand())) << 32) ^ quint64(quint32(qrand())) ^ quint64(quintptr(this)));
+    shuffle.setCount(0);
+    randomStep = -1;
+    syncShuffle();
+}
+
+/*
+    Adapts the random order to the current size of the playlist when it
+    changed without the navigator folding the change in, as insertions and
+    removals while nothing is current. The current item stays current, but
+    the lap in progress is reshuffled over the new count. Changes recorded
+    for a lap playback has left are dropped first.
+*/
+void QMediaPlaylistNavigatorPrivate::syncShuffle() const
+{
+    shuffle.releaseEdits(randomStep);
+
+    const int count = playlist->mediaCount();
+    if (count == shuffle.count()) {
+        if (currentPos >= 0 && currentPos < count && shuffle.itemAt(randomStep) != currentPos)
+            randomStep = shuffle.stepOf(shuffle.lapOf(randomStep), currentPos);
+        return;
+    }
+
+    if (count == 0) {
+        shuffle.setCount(0);
+        randomStep = -1;
+        return;
+    }
+
+    qint64 lap = 0;
+    int index = -1;
+    if (shuffle.count() > 0) {
+        lap = shuffle.lapOf(randomStep);
+        index = int(randomStep - lap * shuffle.count());
+    }
+
+    shuffle.setCount(count);
+
+    if (currentPos >= 0 && currentPos < count)
+        randomStep = shuffle.stepOf(lap, currentPos);
+    else
+        randomStep = lap * count + qMin(index, count - 1);
+}
 
 int QMediaPlaylistNavigatorPrivate::nextItemPos(int steps) const
 {
@@ -105,25 +565,8 @@ int QMediaPlaylistNavigatorPrivate::nextItemPos(int steps) const
         case QMediaPlaylist::Loop:
             return (currentPos+steps) % playlist->mediaCount();
         case QMediaPlaylist::Random:
-            {
-                //TODO: limit the history size
-
-                if (randomPositionsOffset == -1) {
-                    randomModePositions.clear();
-                    randomModePositions.append(currentPos);
-                    randomPositionsOffset = 0;
-                }
-
-                while (randomModePositions.size() < randomPositionsOffset+steps+1)
-                    randomModePositions.append(-1);
-                int res = randomModePositions[randomPositionsOffset+steps];
-                if (res<0 || res >= playlist->mediaCount()) {
-                    res = qrand() % playlist->mediaCount();
-                    randomModePositions[randomPositionsOffset+steps] = res;
-                }
-
-                return res;
-            }
+            syncShuffle();
+            return shuffle.itemAt(randomStep + steps);
     }
 
     return -1;
@@ -155,28 +598,8 @@ int QMediaPlaylistNavigatorPrivate::previousItemPos(int steps) const
                 return prevPos;
             }
         case QMediaPlaylist::Random:
-            {
-                //TODO: limit the history size
-
-                if (randomPositionsOffset == -1) {
-                    randomModePositions.clear();
-                    randomModePositions.append(currentPos);
-                    randomPositionsOffset = 0;
-                }
-
-                while (randomPositionsOffset-steps < 0) {
-                    randomModePositions.prepend(-1);
-                    randomPositionsOffset++;
-                }
-
-                int res = randomModePositions[randomPositionsOffset-steps];
-                if (res<0 || res >= playlist->mediaCount()) {
-                    res = qrand() % playlist->mediaCount();
-                    randomModePositions[randomPositionsOffset-steps] = res;
-                }
-
-                return res;
-            }
+            syncShuffle();
+            return shuffle.itemAt(randomStep - steps);
     }
 
     return -1;
@@ -236,16 +659,11 @@ void QMediaPlaylistNavigator::setPlaybackMode(QMediaPlaylist::PlaybackMode mode)
     if (d->playbackMode == mode)
         return;
 
-    if (mode == QMediaPlaylist::Random) {
-        d->randomPositionsOffset = 0;
-        d->randomModePositions.append(d->currentPos);
-    } else if (d->playbackMode == QMediaPlaylist::Random) {
-        d->randomPositionsOffset = -1;
-        d->randomModePositions.clear();
-    }
-
     d->playbackMode = mode;
 
+    if (mode == QMediaPlaylist::Random)
+        d->resetShuffle();
+
     emit playbackModeChanged(mode);
     emit surroundingItemsChanged();
 }
@@ -284,9 +702,6 @@ void QMediaPlaylistNavigator::setPlaylist(QMediaPlaylistProvider *playlist)
     connect(d->playlist, SIGNAL(mediaRemoved(int,int)), SLOT(_q_mediaRemoved(int,int)));
     connect(d->playlist, SIGNAL(mediaChanged(int,int)), SLOT(_q_mediaChanged(int,int)));
 
-    d->randomPositionsOffset = -1;
-    d->randomModePositions.clear();
-
     if (d->currentPos != -1) {
         d->currentPos = -1;
         emit currentIndexChanged(-1);
@@ -296,6 +711,8 @@ void QMediaPlaylistNavigator::setPlaylist(QMediaPlaylistProvider *playlist)
         d->currentItem = QMediaContent();
         emit activated(d->currentItem); //stop playback
     }
+
+    d->resetShuffle();
 }
 
 /*! \property QMediaPlaylistNavigator::currentItem
@@ -397,7 +814,7 @@ void QMediaPlaylistNavigator::next()
     int nextPos = d->nextItemPos();
 
     if ( playbackMode() == QMediaPlaylist::Random )
-            d->randomPositionsOffset++;
+        d->randomStep++;
 
     jump(nextPos);
 }
@@ -413,7 +830,7 @@ void QMediaPlaylistNavigator::previous()
 
     int prevPos = d->previousItemPos();
     if ( playbackMode() == QMediaPlaylist::Random )
-        d->randomPositionsOffset--;
+        d->randomStep--;
 
     jump(prevPos);
 }
@@ -431,12 +848,13 @@ void QMediaPlaylistNavigator::jump(int position)
     if (position != -1)
         d->lastValidPos = position;
 
-    if (playbackMode() == QMediaPlaylist::Random) {
-        if (d->randomModePositions[d->randomPositionsOffset] != position) {
-            d->randomModePositions.clear();
-            d->randomModePositions.append(position);
-            d->randomPositionsOffset = 0;
-        }
+    if (playbackMode() == QMediaPlaylist::Random && position != -1) {
+        // Move within the current lap rather than starting a new order,
+        // so the items played before the jump are not repeated right away.
+        if (d->shuffle.count() != d->playlist->mediaCount())
+            d->syncShuffle();
+        if (d->shuffle.itemAt(d->randomStep) != position)
+            d->randomStep = d->shuffle.stepOf(d->shuffle.lapOf(d->randomStep), position);
     }
 
     if (position != -1)
@@ -460,8 +878,13 @@ void QMediaPlaylistNavigatorPrivate::_q_mediaInserted(int start, int end)
 {
     Q_Q(QMediaPlaylistNavigator);
 
+    if (playbackMode == QMediaPlaylist::Random && currentPos != -1
+            && shuffle.count() == playlist->mediaCount() - (end - start + 1)) {
+        randomStep = shuffle.insertItems(randomStep, start, end);
+    }
+
     if (currentPos >= start) {
-        currentPos = end-start+1;
+        currentPos += end-start+1;
         q->jump(currentPos);
     }
 
@@ -476,8 +899,13 @@ void QMediaPlaylistNavigatorPrivate::_q_mediaRemoved(int start, int end)
 {
     Q_Q(QMediaPlaylistNavigator);
 
+    if (playbackMode == QMediaPlaylist::Random && currentPos != -1
+            && shuffle.count() == playlist->mediaCount() + (end - start + 1)) {
+        randomStep = shuffle.removeItems(randomStep, start, end);
+    }
+
     if (currentPos > end) {
-        currentPos = currentPos - end-start+1;
+        currentPos -= end-start+1;
         q->jump(currentPos);
     } else if (currentPos >= start) {
         //current item was removed
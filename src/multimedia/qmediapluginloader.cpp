@@ -91,6 +91,22 @@ QList<QObject*> QMediaPluginLoader::instances(QString const &key)
     return objects;
 }
 
+// Returns the metadata of every plugin providing \a key, in load order, without
+// loading any of them; each entry can be passed to instance() later on.
+QList<QJsonObject> QMediaPluginLoader::metaData(QString const &key) const
+{
+    return m_metadata.value(key);
+}
+
+QObject* QMediaPluginLoader::instance(QJsonObject const &metaData)
+{
+    int idx = metaData.value(QStringLiteral("index")).toDouble(-1);
+    if (idx < 0)
+        return 0;
+
+    return m_factoryLoader->instance(idx);
+}
+
 void QMediaPluginLoader::loadMetadata()
 {
 #if !defined QT_NO_DEBUG
@@ -114,6 +130,7 @@ void QMediaPluginLoader::loadMetadata()
     for (int i = 0; i < meta.size(); i++) {
         QJsonObject jsonobj = meta.at(i).value(QStringLiteral("MetaData")).toObject();
         jsonobj.insert(QStringLiteral("index"), i);
+        jsonobj.insert(QStringLiteral("className"), meta.at(i).value(QStringLiteral("className")));
 #if !defined QT_NO_DEBUG
         if (showDebug)
             qDebug() << "QMediaPluginLoader: Inserted index " << i << " into metadata: " << jsonobj;
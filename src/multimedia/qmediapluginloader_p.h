@@ -70,6 +70,9 @@ public:
     QObject* instance(QString const &key);
     QList<QObject*> instances(QString const &key);
 
+    QList<QJsonObject> metaData(QString const &key) const;
+    QObject* instance(QJsonObject const &metaData);
+
 private:
     void loadMetadata();
 
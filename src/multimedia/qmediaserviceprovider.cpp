@@ -32,7 +32,15 @@
 ****************************************************************************/
 
 #include <QtCore/qdebug.h>
+#include <QtCore/qdir.h>
+#include <QtCore/qfile.h>
+#include <QtCore/qfileinfo.h>
+#include <QtCore/qjsonarray.h>
+#include <QtCore/qjsondocument.h>
 #include <QtCore/qmap.h>
+#include <QtCore/qmutex.h>
+#include <QtCore/qsavefile.h>
+#include <QtCore/qstandardpaths.h>
 
 #include "qmediaservice.h"
 #include "qmediaserviceprovider_p.h"
@@ -297,6 +305,136 @@ Q_GLOBAL_STATIC_WITH_ARGS(QMediaPluginLoader, loader,
         (QMediaServiceProviderFactoryInterface_iid, QLatin1String("mediaservice"), Qt::CaseInsensitive))
 
 
+static QMediaServiceProviderHint::Features featuresFromMetaData(const QJsonArray &names)
+{
+    static const struct {
+        const char *name;
+        QMediaServiceProviderHint::Feature feature;
+    } featureNames[] = {
+        { "LowLatencyPlayback", QMediaServiceProviderHint::LowLatencyPlayback },
+        { "RecordingSupport", QMediaServiceProviderHint::RecordingSupport },
+        { "StreamPlayback", QMediaServiceProviderHint::StreamPlayback },
+        { "VideoSurface", QMediaServiceProviderHint::VideoSurface }
+    };
+
+    QMediaServiceProviderHint::Features features;
+    foreach (const QJsonValue &value, names) {
+        const QString name = value.toString();
+        for (uint i = 0; i < sizeof(featureNames) / sizeof(featureNames[0]); ++i) {
+            if (name == QLatin1String(featureNames[i].name))
+                features |= featureNames[i].feature;
+        }
+    }
+
+    return features;
+}
+
+/*
+    Remembers which devices, and for cameras which positions, each plugin
+    reported the last time it was probed, so that Device and CameraPosition
+    hints can be resolved on the next run without loading every plugin and
+    probing the hardware.
+
+    The snapshot is stored in the user's cache directory; set
+    QT_MEDIASERVICE_DEVICE_CACHE to another file name to relocate it, or to 0
+    to keep it in memory only.
+*/
+class QMediaDeviceSnapshot
+{
+public:
+    QMediaDeviceSnapshot()
+    {
+        const QByteArray location = qgetenv("QT_MEDIASERVICE_DEVICE_CACHE");
+        if (location == "0")
+            return;
+
+        if (!location.isEmpty()) {
+            m_fileName = QFile::decodeName(location);
+        } else {
+            const QString cacheDir = QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation);
+            if (!cacheDir.isEmpty())
+                m_fileName = cacheDir + QLatin1String("/qtmultimedia/mediaservice-devices.json");
+        }
+
+        QFile file(m_fileName);
+        if (!m_fileName.isEmpty() && file.open(QIODevice::ReadOnly)) {
+            const QJsonObject root = QJsonDocument::fromJson(file.readAll()).object();
+            if (root.value(QStringLiteral("version")).toInt() == Version)
+                m_root = root;
+        }
+    }
+
+    // The snapshot is keyed by class name; callers walk the plugins in load
+    // order so that the first plugin listing a device still wins.
+    bool hasDevice(const QByteArray &type, const QString &className, const QByteArray &device) const
+    {
+        return entry(type, className).value(QStringLiteral("devices")).toArray()
+                .contains(QJsonValue(QString::fromUtf8(device)));
+    }
+
+    bool hasCameraPosition(const QByteArray &type, const QString &className, QCamera::Position position) const
+    {
+        return entry(type, className).value(QStringLiteral("positions")).toArray()
+                .contains(QJsonValue(int(position)));
+    }
+
+    void update(const QByteArray &type, const QString &className,
+                const QList<QByteArray> &devices, const QList<QCamera::Position> &positions)
+    {
+        if (className.isEmpty())
+            return;
+
+        QJsonArray deviceArray;
+        foreach (const QByteArray &device, devices)
+            deviceArray.append(QString::fromUtf8(device));
+
+        QJsonArray positionArray;
+        foreach (QCamera::Position position, positions)
+            positionArray.append(int(position));
+
+        QJsonObject entry;
+        entry.insert(QStringLiteral("devices"), deviceArray);
+        entry.insert(QStringLiteral("positions"), positionArray);
+
+        QJsonObject plugins = m_root.value(QLatin1String(type)).toObject();
+        if (plugins.value(className) == entry)
+            return;
+
+        plugins.insert(className, entry);
+        m_root.insert(QLatin1String(type), plugins);
+        m_root.insert(QStringLiteral("version"), int(Version));
+        save();
+    }
+
+private:
+    enum { Version = 1 };
+
+    QJsonObject entry(const QByteArray &type, const QString &className) const
+    {
+        if (className.isEmpty())
+            return QJsonObject();
+        return m_root.value(QLatin1String(type)).toObject().value(className).toObject();
+    }
+
+    void save() const
+    {
+        if (m_fileName.isEmpty())
+            return;
+
+        QDir().mkpath(QFileInfo(m_fileName).absolutePath());
+
+        QSaveFile file(m_fileName);
+        if (file.open(QIODevice::WriteOnly)) {
+            file.write(QJsonDocument(m_root).toJson(QJsonDocument::Compact));
+            file.commit();
+        }
+    }
+
+    QString m_fileName;
+    QJsonObject m_root;
+};
+
+
 class QPluginServiceProvider : public QMediaServiceProvider
 {
     struct MediaServiceData {
@@ -306,88 +444,218 @@ class QPluginServiceProvider : public QMediaServiceProvider
         MediaServiceData() : plugin(0) { }
     };
 
+    // A plugin offering a service type, as described by its metadata. The
+    // plugin itself is only loaded once it has to be queried or is selected.
+    struct PluginEntry {
+        QJsonObject metaData;
+        QString className;
+        QMediaServiceProviderPlugin *plugin;
+        bool loaded;
+        bool featuresDeclared;
+        QMediaServiceProviderHint::Features features;
+
+        PluginEntry() : plugin(0), loaded(false), featuresDeclared(false) { }
+    };
+
     QMap<const QMediaService*, MediaServiceData> mediaServiceData;
 
+    mutable QMutex mutex;
+    mutable QMap<QByteArray, QList<PluginEntry> > pluginIndex;
+    mutable QMediaDeviceSnapshot deviceSnapshot;
+
+    QList<PluginEntry> &entries(const QByteArray &type) const
+    {
+        QMap<QByteArray, QList<PluginEntry> >::iterator it = pluginIndex.find(type);
+        if (it != pluginIndex.end())
+            return it.value();
+
+        QList<PluginEntry> list;
+        QList<int> indexes;
+        foreach (const QJsonObject &metaData, loader()->metaData(QLatin1String(type))) {
+            const int index = metaData.value(QStringLiteral("index")).toDouble(-1);
+            if (index < 0 || indexes.contains(index))
+                continue;
+            indexes.append(index);
+
+            PluginEntry entry;
+            entry.metaData = metaData;
+            entry.className = metaData.value(QStringLiteral("className")).toString();
+
+            // Plugins implementing QMediaServiceFeaturesInterface may declare the
+            // features of each service in their metadata, e.g.
+            // "Features": { "org.qt-project.qt.mediaplayer": [ "StreamPlayback" ] }
+            const QJsonValue features = metaData.value(QStringLiteral("Features"));
+            if (features.isObject()) {
+                entry.featuresDeclared = true;
+                entry.features = featuresFromMetaData(features.toObject().value(QLatin1String(type)).toArray());
+            }
+
+            list.append(entry);
+        }
+
+        return pluginIndex.insert(type, list).value();
+    }
+
+    static QMediaServiceProviderPlugin *load(PluginEntry &entry)
+    {
+        if (!entry.loaded) {
+            entry.loaded = true;
+            entry.plugin = qobject_cast<QMediaServiceProviderPlugin*>(loader()->instance(entry.metaData));
+        }
+
+        return entry.plugin;
+    }
+
+    static QMediaServiceProviderPlugin *firstPlugin(QList<PluginEntry> &plugins)
+    {
+        for (int i = 0; i < plugins.count(); ++i) {
+            if (QMediaServiceProviderPlugin *plugin = load(plugins[i]))
+                return plugin;
+        }
+
+        return 0;
+    }
+
+    static bool supportedFeatures(PluginEntry &entry, const QByteArray &type,
+                                  QMediaServiceProviderHint::Features *features)
+    {
+        if (entry.featuresDeclared) {
+            *features = entry.features;
+            return true;
+        }
+
+        QMediaServiceFeaturesInterface *iface =
+                qobject_cast<QMediaServiceFeaturesInterface*>(load(entry));
+        if (!iface)
+            return false;
+
+        *features = iface->supportedFeatures(type);
+        return true;
+    }
+
+    // Returns true if a service requested with \a flags can't be provided by
+    // the plugin, judging by the features it supports.
+    static bool skipForFlags(PluginEntry &entry, const QByteArray &type, int flags)
+    {
+        QMediaServiceProviderHint::Features features;
+        if (!flags || !supportedFeatures(entry, type, &features))
+            return false;
+
+        //if low latency playback was asked, skip services known
+        //not to provide low latency playback
+        if ((flags & QMediaPlayer::LowLatency) &&
+            !(features & QMediaServiceProviderHint::LowLatencyPlayback))
+            return true;
+
+        //the same for QIODevice based streams support
+        if ((flags & QMediaPlayer::StreamPlayback) &&
+            !(features & QMediaServiceProviderHint::StreamPlayback))
+            return true;
+
+        //the same for QAbstractVideoSurface support
+        if ((flags & QMediaPlayer::VideoSurface) &&
+            !(features & QMediaServiceProviderHint::VideoSurface))
+            return true;
+
+        return false;
+    }
+
+    // Queries the devices of a loaded plugin and refreshes its device snapshot.
+    QList<QByteArray> probeDevices(const PluginEntry &entry, const QByteArray &type) const
+    {
+        const QMediaServiceSupportedDevicesInterface *deviceIface =
+                qobject_cast<QMediaServiceSupportedDevicesInterface*>(entry.plugin);
+        if (!deviceIface)
+            return QList<QByteArray>();
+
+        const QList<QByteArray> devices = deviceIface->devices(type);
+
+        QList<QCamera::Position> positions;
+        const QMediaServiceCameraInfoInterface *cameraIface =
+                qobject_cast<QMediaServiceCameraInfoInterface*>(entry.plugin);
+        if (cameraIface && type == QByteArray(Q_MEDIASERVICE_CAMERA)) {
+            foreach (const QByteArray &device, devices)
+                positions.append(cameraIface->cameraPosition(device));
+        }
+
+        deviceSnapshot.update(type, entry.className, devices, positions);
+
+        return devices;
+    }
+
 public:
+    QPluginServiceProvider()
+        : mutex(QMutex::Recursive)
+    {
+    }
+
     QMediaService* requestService(const QByteArray &type, const QMediaServiceProviderHint &hint)
     {
+        QMutexLocker locker(&mutex);
+
         QString key(QLatin1String(type.constData()));
 
-        QList<QMediaServiceProviderPlugin *>plugins;
-        foreach (QObject *obj, loader()->instances(key)) {
-            QMediaServiceProviderPlugin *plugin =
-                qobject_cast<QMediaServiceProviderPlugin*>(obj);
-            if (plugin)
-                plugins << plugin;
-        }
+        QList<PluginEntry> &plugins = entries(type);
 
         if (!plugins.isEmpty()) {
             QMediaServiceProviderPlugin *plugin = 0;
 
             switch (hint.type()) {
             case QMediaServiceProviderHint::Null:
-                plugin = plugins[0];
                 //special case for media player, if low latency was not asked,
                 //prefer services not offering it, since they are likely to support
                 //more formats
                 if (type == QByteArray(Q_MEDIASERVICE_MEDIAPLAYER)) {
-                    foreach (QMediaServiceProviderPlugin *currentPlugin, plugins) {
-                        QMediaServiceFeaturesInterface *iface =
-                                qobject_cast<QMediaServiceFeaturesInterface*>(currentPlugin);
-
-                        if (!iface || !(iface->supportedFeatures(type) &
-                                        QMediaServiceProviderHint::LowLatencyPlayback)) {
-                            plugin = currentPlugin;
-                            break;
+                    for (int i = 0; i < plugins.count() && !plugin; ++i) {
+                        QMediaServiceProviderHint::Features features;
+                        if (!supportedFeatures(plugins[i], type, &features)
+                                || !(features & QMediaServiceProviderHint::LowLatencyPlayback)) {
+                            plugin = load(plugins[i]);
                         }
-
                     }
                 }
                 break;
             case QMediaServiceProviderHint::SupportedFeatures:
-                plugin = plugins[0];
-                foreach (QMediaServiceProviderPlugin *currentPlugin, plugins) {
-                    QMediaServiceFeaturesInterface *iface =
-                            qobject_cast<QMediaServiceFeaturesInterface*>(currentPlugin);
-
-                    if (iface) {
-                        if ((iface->supportedFeatures(type) & hint.features()) == hint.features()) {
-                            plugin = currentPlugin;
-                            break;
-                        }
+                for (int i = 0; i < plugins.count() && !plugin; ++i) {
+                    QMediaServiceProviderHint::Features features;
+                    if (supportedFeatures(plugins[i], type, &features)
+                            && (features & hint.features()) == hint.features()) {
+                        plugin = load(plugins[i]);
                     }
                 }
                 break;
             case QMediaServiceProviderHint::Device: {
-                    plugin = plugins[0];
-                    foreach (QMediaServiceProviderPlugin *currentPlugin, plugins) {
-                        QMediaServiceSupportedDevicesInterface *iface =
-                                qobject_cast<QMediaServiceSupportedDevicesInterface*>(currentPlugin);
+                    for (int i = 0; i < plugins.count() && !plugin; ++i) {
+                        if (deviceSnapshot.hasDevice(type, plugins[i].className, hint.device()))
+                            plugin = load(plugins[i]);
+                    }
 
-                        if (iface && iface->devices(type).contains(hint.device())) {
-                            plugin = currentPlugin;
-                            break;
-                        }
+                    for (int i = 0; i < plugins.count() && !plugin; ++i) {
+                        if (load(plugins[i]) && probeDevices(plugins[i], type).contains(hint.device()))
+                            plugin = plugins[i].plugin;
                     }
                 }
                 break;
             case QMediaServiceProviderHint::CameraPosition: {
-                    plugin = plugins[0];
                     if (type == QByteArray(Q_MEDIASERVICE_CAMERA)
                             && hint.cameraPosition() != QCamera::UnspecifiedPosition) {
-                        foreach (QMediaServiceProviderPlugin *currentPlugin, plugins) {
-                            const QMediaServiceSupportedDevicesInterface *deviceIface =
-                                    qobject_cast<QMediaServiceSupportedDevicesInterface*>(currentPlugin);
+                        for (int i = 0; i < plugins.count() && !plugin; ++i) {
+                            if (deviceSnapshot.hasCameraPosition(type, plugins[i].className,
+                                                                 hint.cameraPosition())) {
+                                plugin = load(plugins[i]);
+                            }
+                        }
+
+                        for (int i = 0; i < plugins.count() && !plugin; ++i) {
                             const QMediaServiceCameraInfoInterface *cameraIface =
-                                    qobject_cast<QMediaServiceCameraInfoInterface*>(currentPlugin);
-
-                            if (deviceIface && cameraIface) {
-                                const QList<QByteArray> cameras = deviceIface->devices(type);
-                                foreach (const QByteArray &camera, cameras) {
-                                    if (cameraIface->cameraPosition(camera) == hint.cameraPosition()) {
-                                        plugin = currentPlugin;
-                                        break;
-                                    }
+                                    qobject_cast<QMediaServiceCameraInfoInterface*>(load(plugins[i]));
+                            if (!cameraIface)
+                                continue;
+
+                            foreach (const QByteArray &camera, probeDevices(plugins[i], type)) {
+                                if (cameraIface->cameraPosition(camera) == hint.cameraPosition()) {
+                                    plugin = plugins[i].plugin;
+                                    break;
                                 }
                             }
                         }
@@ -396,7 +664,11 @@ public:
                 break;
             case QMediaServiceProviderHint::ContentType: {
                     QMultimedia::SupportEstimate estimate = QMultimedia::NotSupported;
-                    foreach (QMediaServiceProviderPlugin *currentPlugin, plugins) {
+                    for (int i = 0; i < plugins.count(); ++i) {
+                        QMediaServiceProviderPlugin *currentPlugin = load(plugins[i]);
+                        if (!currentPlugin)
+                            continue;
+
                         QMultimedia::SupportEstimate currentEstimate = QMultimedia::MaybeSupported;
                         QMediaServiceSupportedFormatsInterface *iface =
                                 qobject_cast<QMediaServiceSupportedFormatsInterface*>(currentPlugin);
@@ -416,6 +688,9 @@ public:
                 break;
             }
 
+            if (plugin == 0 && hint.type() != QMediaServiceProviderHint::ContentType)
+                plugin = firstPlugin(plugins);
+
             if (plugin != 0) {
                 QMediaService *service = plugin->create(key);
                 if (service != 0) {
@@ -435,6 +710,8 @@ public:
 
     void releaseService(QMediaService *service)
     {
+        QMutexLocker locker(&mutex);
+
         if (service != 0) {
             MediaServiceData d = mediaServiceData.take(service);
 
@@ -445,6 +722,8 @@ public:
 
     QMediaServiceProviderHint::Features supportedFeatures(const QMediaService *service) const
     {
+        QMutexLocker locker(&mutex);
+
         if (service) {
             MediaServiceData d = mediaServiceData.value(service);
 
@@ -465,38 +744,24 @@ public:
                                      const QStringList& codecs,
                                      int flags) const
     {
-        QList<QObject*> instances = loader()->instances(QLatin1String(serviceType));
+        QMutexLocker locker(&mutex);
+
+        QList<PluginEntry> &plugins = entries(serviceType);
 
-        if (instances.isEmpty())
+        if (plugins.isEmpty())
             return QMultimedia::NotSupported;
 
         bool allServicesProvideInterface = true;
         QMultimedia::SupportEstimate supportEstimate = QMultimedia::NotSupported;
 
-        foreach(QObject *obj, instances) {
-            QMediaServiceSupportedFormatsInterface *iface =
-                    qobject_cast<QMediaServiceSupportedFormatsInterface*>(obj);
-
-
-            if (flags) {
-                QMediaServiceFeaturesInterface *iface =
-                        qobject_cast<QMediaServiceFeaturesInterface*>(obj);
-
-                if (iface) {
-                    QMediaServiceProviderHint::Features features = iface->supportedFeatures(serviceType);
+        for (int i = 0; i < plugins.count(); ++i) {
+            // Plugins declaring their features in the metadata are skipped
+            // without being loaded
+            if (skipForFlags(plugins[i], serviceType, flags))
+                continue;
 
-                    //if low latency playback was asked, skip services known
-                    //not to provide low latency playback
-                    if ((flags & QMediaPlayer::LowLatency) &&
-                        !(features & QMediaServiceProviderHint::LowLatencyPlayback))
-                            continue;
-
-                    //the same for QIODevice based streams support
-                    if ((flags & QMediaPlayer::StreamPlayback) &&
-                        !(features & QMediaServiceProviderHint::StreamPlayback))
-                            continue;
-                }
-            }
+            QMediaServiceSupportedFormatsInterface *iface =
+                    qobject_cast<QMediaServiceSupportedFormatsInterface*>(load(plugins[i]));
 
             if (iface)
                 supportEstimate = qMax(supportEstimate, iface->hasSupport(mimeType, codecs));
@@ -517,39 +782,18 @@ public:
 
     QStringList supportedMimeTypes(const QByteArray &serviceType, int flags) const
     {
-        QList<QObject*> instances = loader()->instances(QLatin1String(serviceType));
-
-        QStringList supportedTypes;
-
-        foreach(QObject *obj, instances) {
-            QMediaServiceSupportedFormatsInterface *iface =
-                    qobject_cast<QMediaServiceSupportedFormatsInterface*>(obj);
-
+        QMutexLocker locker(&mutex);
 
-            if (flags) {
-                QMediaServiceFeaturesInterface *iface =
-                        qobject_cast<QMediaServiceFeaturesInterface*>(obj);
+        QList<PluginEntry> &plugins = entries(serviceType);
 
-                if (iface) {
-                    QMediaServiceProviderHint::Features features = iface->supportedFeatures(serviceType);
+        QStringList supportedTypes;
 
-                    // If low latency playback was asked for, skip MIME types from services known
-                    // not to provide low latency playback
-                    if ((flags & QMediaPlayer::LowLatency) &&
-                        !(features & QMediaServiceProviderHint::LowLatencyPlayback))
-                        continue;
+        for (int i = 0; i < plugins.count(); ++i) {
+            if (skipForFlags(plugins[i], serviceType, flags))
+                continue;
 
-                    //the same for QIODevice based streams support
-                    if ((flags & QMediaPlayer::StreamPlayback) &&
-                        !(features & QMediaServiceProviderHint::StreamPlayback))
-                            continue;
-
-                    //the same for QAbstractVideoSurface support
-                    if ((flags & QMediaPlayer::VideoSurface) &&
-                        !(features & QMediaServiceProviderHint::VideoSurface))
-                            continue;
-                }
-            }
+            QMediaServiceSupportedFormatsInterface *iface =
+                    qobject_cast<QMediaServiceSupportedFormatsInterface*>(load(plugins[i]));
 
             if (iface) {
                 supportedTypes << iface->supportedMimeTypes();
@@ -564,9 +808,13 @@ public:
 
     QByteArray defaultDevice(const QByteArray &serviceType) const
     {
-        foreach (QObject *obj, loader()->instances(QLatin1String(serviceType))) {
+        QMutexLocker locker(&mutex);
+
+        QList<PluginEntry> &plugins = entries(serviceType);
+
+        for (int i = 0; i < plugins.count(); ++i) {
             const QMediaServiceDefaultDeviceInterface *iface =
-                    qobject_cast<QMediaServiceDefaultDeviceInterface*>(obj);
+                    qobject_cast<QMediaServiceDefaultDeviceInterface*>(load(plugins[i]));
 
             if (iface)
                 return iface->defaultDevice(serviceType);
@@ -583,15 +831,15 @@ public:
 
     QList<QByteArray> devices(const QByteArray &serviceType) const
     {
-        QList<QByteArray> res;
+        QMutexLocker locker(&mutex);
 
-        foreach (QObject *obj, loader()->instances(QLatin1String(serviceType))) {
-            QMediaServiceSupportedDevicesInterface *iface =
-                    qobject_cast<QMediaServiceSupportedDevicesInterface*>(obj);
+        QList<PluginEntry> &plugins = entries(serviceType);
 
-            if (iface) {
-                res.append(iface->devices(serviceType));
-            }
+        QList<QByteArray> res;
+
+        for (int i = 0; i < plugins.count(); ++i) {
+            if (load(plugins[i]))
+                res.append(probeDevices(plugins[i], serviceType));
         }
 
         return res;
@@ -599,9 +847,13 @@ public:
 
     QString deviceDescription(const QByteArray &serviceType, const QByteArray &device)
     {
-        foreach (QObject *obj, loader()->instances(QLatin1String(serviceType))) {
+        QMutexLocker locker(&mutex);
+
+        QList<PluginEntry> &plugins = entries(serviceType);
+
+        for (int i = 0; i < plugins.count(); ++i) {
             QMediaServiceSupportedDevicesInterface *iface =
-                    qobject_cast<QMediaServiceSupportedDevicesInterface*>(obj);
+                    qobject_cast<QMediaServiceSupportedDevicesInterface*>(load(plugins[i]));
 
             if (iface) {
                 if (iface->devices(serviceType).contains(device))
@@ -614,8 +866,13 @@ public:
 
     QCamera::Position cameraPosition(const QByteArray &device) const
     {
+        QMutexLocker locker(&mutex);
+
         const QByteArray serviceType(Q_MEDIASERVICE_CAMERA);
-        foreach (QObject *obj, loader()->instances(QString::fromLatin1(serviceType))) {
+        QList<PluginEntry> &plugins = entries(serviceType);
+
+        for (int i = 0; i < plugins.count(); ++i) {
+            QObject *obj = load(plugins[i]);
             const QMediaServiceSupportedDevicesInterface *deviceIface =
                     qobject_cast<QMediaServiceSupportedDevicesInterface*>(obj);
             const QMediaServiceCameraInfoInterface *cameraIface =
@@ -633,8 +890,13 @@ public:
 
     int cameraOrientation(const QByteArray &device) const
     {
+        QMutexLocker locker(&mutex);
+
         const QByteArray serviceType(Q_MEDIASERVICE_CAMERA);
-        foreach (QObject *obj, loader()->instances(QString::fromLatin1(serviceType))) {
+        QList<PluginEntry> &plugins = entries(serviceType);
+
+        for (int i = 0; i < plugins.count(); ++i) {
+            QObject *obj = load(plugins[i]);
             const QMediaServiceSupportedDevicesInterface *deviceIface =
                     qobject_cast<QMediaServiceSupportedDevicesInterface*>(obj);
             const QMediaServiceCameraInfoInterface *cameraIface =
@@ -874,6 +1136,11 @@ QMediaServiceProvider *QMediaServiceProvider::defaultServiceProvider()
     identifies the devices supported by a media service plug-in.
 
     A QMediaServiceProviderPlugin may implement this interface.
+
+    The devices each plug-in reports are remembered between runs, so that a
+    service requested for a given device only loads the plug-in that listed
+    it last time. The plug-ins are only loaded and asked for their devices
+    when none of them listed it.
 */
 
 /*!
@@ -953,6 +1220,23 @@ QMediaServiceProvider *QMediaServiceProvider::defaultServiceProvider()
     features supported by a media service plug-in.
 
     A QMediaServiceProviderPlugin may implement this interface.
+
+    A plug-in implementing it should also list the features of each of its
+    services in the "Features" object of its metadata, so the plug-in does
+    not have to be loaded to find out whether it is suitable:
+
+    \code
+    {
+        "Services": [ "org.qt-project.qt.mediaplayer", "org.qt-project.qt.camera" ],
+        "Features": {
+            "org.qt-project.qt.mediaplayer": [ "StreamPlayback", "VideoSurface" ]
+        }
+    }
+    \endcode
+
+    The names are those of QMediaServiceProviderHint::Feature. When the
+    metadata has no "Features" object, the plug-in is loaded and
+    supportedFeatures() is called instead.
 */
 
 /*!
@@ -207,10 +207,18 @@ public:
     QMediaTimeRangePrivate(const QMediaTimeRangePrivate &other);
     QMediaTimeRangePrivate(const QMediaTimeInterval &interval);
 
+    // Sorted by start, disjoint and not adjacent, so also sorted by end
     QList<QMediaTimeInterval> intervals;
 
+    int firstEndingAtOrAfter(qint64 time) const;
+    int firstStartingAfter(qint64 time) const;
+
     void addInterval(const QMediaTimeInterval &interval);
     void removeInterval(const QMediaTimeInterval &interval);
+
+    void unite(const QList<QMediaTimeInterval> &other);
+    void subtract(const QList<QMediaTimeInterval> &other);
+    void intersect(const QList<QMediaTimeInterval> &other);
 };
 
 QMediaTimeRangePrivate::QMediaTimeRangePrivate()
@@ -233,36 +241,55 @@ QMediaTimeRangePrivate::QMediaTimeRangePrivate(const QMediaTimeInterval &interva
         intervals << interval;
 }
 
+int QMediaTimeRangePrivate::firstEndingAtOrAfter(qint64 time) const
+{
+    int low = 0;
+    int high = intervals.count();
+    while (low < high) {
+        const int middle = low + (high - low) / 2;
+        if (intervals.at(middle).e < time)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+    return low;
+}
+
+int QMediaTimeRangePrivate::firstStartingAfter(qint64 time) const
+{
+    int low = 0;
+    int high = intervals.count();
+    while (low < high) {
+        const int middle = low + (high - low) / 2;
+        if (intervals.at(middle).s <= time)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+    return low;
+}
+
 void QMediaTimeRangePrivate::addInterval(const QMediaTimeInterval &interval)
 {
     // Handle normalized intervals only
     if(!interval.isNormal())
         return;
 
-    // Find a place to insert the interval
-    int i;
-    for (i = 0; i < intervals.count(); i++) {
-        // Insert before this element
-        if(interval.s < intervals[i].s) {
-            intervals.insert(i, interval);
-            break;
-        }
-    }
-
-    // Interval needs to be added to the end of the list
-    if (i == intervals.count())
-        intervals.append(interval);
+    // Intervals [first, last) overlap or touch the new one
+    const int first = firstEndingAtOrAfter(interval.s - 1);
+    const int last = firstStartingAfter(interval.e + 1);
 
-    // Do we need to correct the element before us?
-    if(i > 0 && intervals[i - 1].e >= interval.s - 1)
-        i--;
-
-    // Merge trailing ranges
-    while (i < intervals.count() - 1
-          && intervals[i].e >= intervals[i + 1].s - 1) {
-        intervals[i].e = qMax(intervals[i].e, intervals[i + 1].e);
-        intervals.removeAt(i + 1);
+    if (first == last) {
+        intervals.insert(first, interval);
+        return;
     }
+
+    // Merge them into the first one
+    QMediaTimeInterval &merged = intervals[first];
+    merged.s = qMin(merged.s, interval.s);
+    merged.e = qMax(intervals.at(last - 1).e, interval.e);
+    if (last - first > 1)
+        intervals.erase(intervals.begin() + first + 1, intervals.begin() + last);
 }
 
 void QMediaTimeRangePrivate::removeInterval(const QMediaTimeInterval &interval)
@@ -271,33 +298,133 @@ void QMediaTimeRangePrivate::removeInterval(const QMediaTimeInterval &interval)
     if(!interval.isNormal())
         return;
 
-    for (int i = 0; i < intervals.count(); i++) {
-        QMediaTimeInterval r = intervals[i];
-
-        if (r.e < interval.s) {
-            // Before the removal interval
-            continue;
-        } else if (interval.e < r.s) {
-            // After the removal interval - stop here
-            break;
-        } else if (r.s < interval.s && interval.e < r.e) {
-            // Split case - a single range has a chunk removed
-            intervals[i].e = interval.s -1;
-            addInterval(QMediaTimeInterval(interval.e + 1, r.e));
-            break;
-        } else if (r.s < interval.s) {
-            // Trimming Tail Case
-            intervals[i].e = interval.s - 1;
-        } else if (interval.e < r.e) {
-            // Trimming Head Case - we can stop after this
-            intervals[i].s = interval.e + 1;
-            break;
-        } else {
-            // Complete coverage case
-            intervals.removeAt(i);
-            --i;
+    // Intervals [first, last) overlap the removed one
+    const int first = firstEndingAtOrAfter(interval.s);
+    const int last = firstStartingAfter(interval.e);
+    if (first == last)
+        return;
+
+    const QMediaTimeInterval head = intervals.at(first);
+    const QMediaTimeInterval tail = intervals.at(last - 1);
+    int next = first;
+
+    // Trimming head case
+    if (head.s < interval.s)
+        intervals[next++] = QMediaTimeInterval(head.s, interval.s - 1);
+
+    // Trimming tail case, possibly splitting a single interval
+    if (interval.e < tail.e) {
+        if (next < last)
+            intervals[next] = QMediaTimeInterval(interval.e + 1, tail.e);
+        else
+            intervals.insert(next, QMediaTimeInterval(interval.e + 1, tail.e));
+        ++next;
+    }
+
+    // Complete coverage case
+    if (next < last)
+        intervals.erase(intervals.begin() + next, intervals.begin() + last);
+}
+
+// Merges two sorted lists in linear time
+void QMediaTimeRangePrivate::unite(const QList<QMediaTimeInterval> &other)
+{
+    if (other.isEmpty())
+        return;
+
+    if (intervals.isEmpty()) {
+        intervals = other;
+        return;
+    }
+
+    if (other.count() == 1) {
+        addInterval(QMediaTimeInterval(other.first()));
+        return;
+    }
+
+    QList<QMediaTimeInterval> result;
+    result.reserve(intervals.count() + other.count());
+
+    int i = 0;
+    int j = 0;
+    while (i < intervals.count() || j < other.count()) {
+        const QMediaTimeInterval &next = j == other.count()
+                || (i < intervals.count() && intervals.at(i).s <= other.at(j).s)
+                ? intervals.at(i++) : other.at(j++);
+
+        if (!result.isEmpty() && result.last().e >= next.s - 1)
+            result.last().e = qMax(result.last().e, next.e);
+        else
+            result.append(next);
+    }
+
+    intervals = result;
+}
+
+// Removes a sorted list in linear time
+void QMediaTimeRangePrivate::subtract(const QList<QMediaTimeInterval> &other)
+{
+    if (other.isEmpty() || intervals.isEmpty())
+        return;
+
+    if (other.count() == 1) {
+        removeInterval(QMediaTimeInterval(other.first()));
+        return;
+    }
+
+    QList<QMediaTimeInterval> result;
+    result.reserve(intervals.count() + other.count());
+
+    int j = 0;
+    for (int i = 0; i < intervals.count(); ++i) {
+        qint64 s = intervals.at(i).s;
+        const qint64 e = intervals.at(i).e;
+
+        while (j < other.count() && other.at(j).e < s)
+            ++j;
+
+        bool covered = false;
+        for (int k = j; k < other.count() && other.at(k).s <= e; ++k) {
+            const QMediaTimeInterval &cut = other.at(k);
+            if (s < cut.s)
+                result.append(QMediaTimeInterval(s, cut.s - 1));
+            if (cut.e >= e) {
+                covered = true;
+                break;
+            }
+            s = cut.e + 1;
         }
+
+        if (!covered)
+            result.append(QMediaTimeInterval(s, e));
     }
+
+    intervals = result;
+}
+
+// Intersects with a sorted list in linear time
+void QMediaTimeRangePrivate::intersect(const QList<QMediaTimeInterval> &other)
+{
+    QList<QMediaTimeInterval> result;
+
+    int i = 0;
+    int j = 0;
+    while (i < intervals.count() && j < other.count()) {
+        const QMediaTimeInterval &a = intervals.at(i);
+        const QMediaTimeInterval &b = other.at(j);
+
+        const qint64 s = qMax(a.s, b.s);
+        const qint64 e = qMin(a.e, b.e);
+        if (s <= e)
+            result.append(QMediaTimeInterval(s, e));
+
+        if (a.e < b.e)
+            ++i;
+        else
+            ++j;
+    }
+
+    intervals = result;
 }
 
 /*!
@@ -470,7 +597,7 @@ void QMediaTimeRange::addInterval(qint64 start, qint64 end)
     If the specified interval is adjacent to, or overlaps existing
     intervals within the time range, these intervals will be merged.
 
-    This operation takes linear time.
+    The intervals affected are found in logarithmic time.
 
     \sa removeInterval()
 */
@@ -484,13 +611,12 @@ void QMediaTimeRange::addInterval(const QMediaTimeInterval &interval)
 
     Adds each of the intervals in \a range to this time range.
 
-    Equivalent to calling addInterval() for each interval in \a range.
+    Equivalent to calling addInterval() for each interval in \a range, but
+    takes time linear in the number of intervals of both time ranges.
 */
 void QMediaTimeRange::addTimeRange(const QMediaTimeRange &range)
 {
-    foreach(const QMediaTimeInterval &i, range.intervals()) {
-        d->addInterval(i);
-    }
+    d->unite(range.d->intervals);
 }
 
 /*!
@@ -519,7 +645,7 @@ void QMediaTimeRange::removeInterval(qint64 start, qint64 end)
     such that no intervals within the time range include any part of the
     target interval.
 
-    This operation takes linear time.
+    The intervals affected are found in logarithmic time.
 
     \sa addInterval()
 */
@@ -533,13 +659,27 @@ void QMediaTimeRange::removeInterval(const QMediaTimeInterval &interval)
 
     Removes each of the intervals in \a range from this time range.
 
-    Equivalent to calling removeInterval() for each interval in \a range.
+    Equivalent to calling removeInterval() for each interval in \a range, but
+    takes time linear in the number of intervals of both time ranges.
 */
 void QMediaTimeRange::removeTimeRange(const QMediaTimeRange &range)
 {
-    foreach(const QMediaTimeInterval &i, range.intervals()) {
-        d->removeInterval(i);
-    }
+    d->subtract(range.d->intervals);
+}
+
+/*!
+    \fn QMediaTimeRange::intersected(const QMediaTimeRange &range) const
+    \since 5.9
+
+    Returns the times contained in both this time range and \a range.
+
+    This takes time linear in the number of intervals of both time ranges.
+*/
+QMediaTimeRange QMediaTimeRange::intersected(const QMediaTimeRange &range) const
+{
+    QMediaTimeRange result(*this);
+    result.d->intersect(range.d->intervals);
+    return result;
 }
 
 /*!
@@ -635,18 +775,13 @@ bool QMediaTimeRange::isContinuous() const
     \fn QMediaTimeRange::contains(qint64 time) const
 
     Returns true if the specified \a time lies within the time range.
+
+    This takes logarithmic time.
 */
 bool QMediaTimeRange::contains(qint64 time) const
 {
-    for (int i = 0; i < d->intervals.count(); i++) {
-        if (d->intervals[i].contains(time))
-            return true;
-
-        if (time < d->intervals[i].s)
-            break;
-    }
-
-    return false;
+    const int i = d->firstEndingAtOrAfter(time);
+    return i < d->intervals.count() && d->intervals.at(i).s <= time;
 }
 
 /*!
@@ -100,6 +100,8 @@ public:
     void removeInterval(const QMediaTimeInterval &interval);
     void removeTimeRange(const QMediaTimeRange&);
 
+    QMediaTimeRange intersected(const QMediaTimeRange&) const;
+
     QMediaTimeRange& operator+=(const QMediaTimeRange&);
     QMediaTimeRange& operator+=(const QMediaTimeInterval&);
     QMediaTimeRange& operator-=(const QMediaTimeRange&);
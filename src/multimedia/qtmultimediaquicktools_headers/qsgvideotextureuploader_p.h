@@ -0,0 +1,118 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#ifndef QSGVIDEOTEXTUREUPLOADER_P_H
+#define QSGVIDEOTEXTUREUPLOADER_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include <private/qtmultimediaquickdefs_p.h>
+
+#include <QtCore/qelapsedtimer.h>
+#include <QtCore/qsize.h>
+#include <QtGui/qopenglbuffer.h>
+#include <QtGui/qopenglfunctions.h>
+
+QT_BEGIN_NAMESPACE
+
+class Q_MULTIMEDIAQUICK_EXPORT QSGVideoTextureUploader
+{
+public:
+    enum UploadMode {
+        DirectUpload,
+        PixelBufferUpload
+    };
+
+    enum { MaxPlaneCount = 3 };
+
+    QSGVideoTextureUploader();
+    ~QSGVideoTextureUploader();
+
+    static UploadMode defaultUploadMode();
+    static bool isPixelBufferUploadSupported(QOpenGLContext *context);
+
+    UploadMode uploadMode() const { return m_uploadMode; }
+    void setUploadMode(UploadMode mode);
+
+    GLuint textureId(int plane) const { return m_planes[plane].textureId; }
+
+    void beginFrame();
+    void uploadPlane(int plane, int width, int height, GLenum format, GLenum type, const uchar *bits);
+    void endFrame();
+
+    int frameCount() const { return m_frameCount; }
+    qint64 lastUploadTime() const { return m_lastUploadTime; }
+    qint64 averageUploadTime() const;
+
+    void releaseResources();
+
+private:
+    struct Plane
+    {
+        Plane() : textureId(0), format(0), type(0) {}
+
+        GLuint textureId;
+        QSize size;
+        GLenum format;
+        GLenum type;
+        QOpenGLBuffer pixelBuffers[2];
+    };
+
+    void allocateTexture(QOpenGLFunctions *functions, Plane &plane,
+                         int width, int height, GLenum format, GLenum type);
+    bool uploadThroughPixelBuffer(QOpenGLFunctions *functions, Plane &plane,
+                                  int width, int height, const uchar *bits);
+
+    Plane m_planes[MaxPlaneCount];
+    UploadMode m_uploadMode;
+    bool m_pixelBuffersChecked;
+    bool m_reportTimes;
+    int m_frameCount;
+    qint64 m_lastUploadTime;
+    qint64 m_totalUploadTime;
+    QElapsedTimer m_timer;
+};
+
+QT_END_NAMESPACE
+
+#endif
@@ -0,0 +1,160 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#ifndef QVIDEOFILTERPIPELINE_P_H
+#define QVIDEOFILTERPIPELINE_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include <private/qtmultimediaquickdefs_p.h>
+
+#include <QtCore/qmutex.h>
+#include <QtCore/qqueue.h>
+#include <QtCore/qthreadpool.h>
+#include <QtCore/qvector.h>
+#include <QtCore/qwaitcondition.h>
+#include <QtCore/qelapsedtimer.h>
+#include <QtMultimedia/qabstractvideofilter.h>
+
+QT_BEGIN_NAMESPACE
+
+class Q_MULTIMEDIAQUICK_EXPORT QVideoFilterPipeline
+{
+public:
+    struct Stage
+    {
+        Stage() : runnable(0), renderThread(true), flags(0) { }
+        Stage(QVideoFilterRunnable *runnable, bool renderThread, QVideoFilterRunnable::RunFlags flags = 0)
+            : runnable(runnable), renderThread(renderThread), flags(flags) { }
+
+        bool operator==(const Stage &other) const
+        {
+            return runnable == other.runnable && renderThread == other.renderThread && flags == other.flags;
+        }
+        bool operator!=(const Stage &other) const { return !operator==(other); }
+
+        QVideoFilterRunnable *runnable;
+        bool renderThread;
+        QVideoFilterRunnable::RunFlags flags;
+    };
+
+    explicit QVideoFilterPipeline(QObject *updateTarget = 0);
+    ~QVideoFilterPipeline();
+
+    static int defaultMaxFramesInFlight();
+    static bool defaultCopiesFrames();
+
+    int maxFramesInFlight() const;
+    void setMaxFramesInFlight(int count);
+
+    bool copiesFrames() const;
+    void setCopiesFrames(bool copy);
+
+    QVector<Stage> stages() const;
+    void setStages(const QVector<Stage> &stages);
+
+    bool submit(const QVideoFrame &frame, const QVideoSurfaceFormat &surfaceFormat);
+    void runRenderThreadStages();
+    bool takeFinishedFrame(QVideoFrame *frame, bool *modified = 0);
+    void clear();
+
+    int framesInFlight() const;
+    int finishedFrameCount() const;
+    int droppedFrameCount() const;
+
+    // In microseconds
+    qint64 lastStageLatency(int stage) const;
+    qint64 averageStageLatency(int stage) const;
+    qint64 averageFrameLatency() const;
+
+private:
+    Q_DISABLE_COPY(QVideoFilterPipeline)
+
+    class StageWorker;
+    friend class StageWorker;
+
+    struct Job
+    {
+        Job() : stage(0), modified(false) { }
+        QVideoFrame frame;
+        QVideoSurfaceFormat surfaceFormat;
+        int stage;
+        bool modified;
+        QElapsedTimer timer;
+    };
+
+    struct StageState
+    {
+        StageState() : busy(false), frames(0), lastTime(0), totalTime(0) { }
+        Stage stage;
+        QQueue<Job *> queue;
+        bool busy;
+        int frames;
+        qint64 lastTime;
+        qint64 totalTime;
+    };
+
+    bool advance(Job *job);
+    void runStage(int index, QMutexLocker *locker);
+    void drainStage(int index);
+    void requestUpdate();
+    void discardJobs();
+
+    QObject *m_updateTarget;
+    mutable QMutex m_mutex;
+    QWaitCondition m_idle;
+    QVector<StageState> m_stages;
+    QQueue<Job *> m_finished;
+    QThreadPool m_threadPool;
+    int m_maxFramesInFlight;
+    int m_framesInFlight;
+    int m_finishedFrames;
+    int m_droppedFrames;
+    qint64 m_totalFrameLatency;
+    bool m_clearing;
+    bool m_copyFrames;
+};
+
+QT_END_NAMESPACE
+
+#endif
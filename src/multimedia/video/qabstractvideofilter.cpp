@@ -245,10 +245,12 @@ class QAbstractVideoFilterPrivate
 {
 public:
     QAbstractVideoFilterPrivate() :
-        active(true)
+        active(true),
+        requiresRenderThread(true)
     { }
 
     bool active;
+    bool requiresRenderThread;
 };
 
 /*!
@@ -299,6 +301,44 @@ void QAbstractVideoFilter::setActive(bool v)
     }
 }
 
+/*!
+    \property QAbstractVideoFilter::requiresRenderThread
+    \brief whether the filter's runnable must run on the render thread.
+    \since 5.9
+
+    By default this is true and QVideoFilterRunnable::run() is always called on
+    the render thread with the OpenGL context bound.
+
+    Filters that only work on mapped frame data in system memory can set this
+    to \c false. When the VideoOutput runs its filters asynchronously, which is
+    enabled by setting the \c QT_QUICK_VIDEO_ASYNC_FILTERS environment variable
+    to the maximum number of frames in flight, run() is then called on a worker
+    thread, without an OpenGL context, while the render thread continues
+    rendering. The gui thread is not blocked in that case, so properties of the
+    filter that can change must be accessed in a thread safe way.
+ */
+bool QAbstractVideoFilter::requiresRenderThread() const
+{
+    Q_D(const QAbstractVideoFilter);
+    return d->requiresRenderThread;
+}
+
+void QAbstractVideoFilter::setRequiresRenderThread(bool required)
+{
+    Q_D(QAbstractVideoFilter);
+    if (d->requiresRenderThread != required) {
+        d->requiresRenderThread = required;
+        emit requiresRenderThreadChanged();
+    }
+}
+
+/*!
+    \fn void QAbstractVideoFilter::requiresRenderThreadChanged()
+    \since 5.9
+
+    Signals that the \l requiresRenderThread property has changed.
+*/
+
 /*!
   \fn QVideoFilterRunnable *QAbstractVideoFilter::createFilterRunnable()
 
@@ -60,6 +60,7 @@ class Q_MULTIMEDIA_EXPORT QAbstractVideoFilter : public QObject
 {
     Q_OBJECT
     Q_PROPERTY(bool active READ isActive WRITE setActive NOTIFY activeChanged)
+    Q_PROPERTY(bool requiresRenderThread READ requiresRenderThread WRITE setRequiresRenderThread NOTIFY requiresRenderThreadChanged)
 
 public:
     explicit QAbstractVideoFilter(QObject *parent = Q_NULLPTR);
@@ -68,10 +69,14 @@ public:
     bool isActive() const;
     void setActive(bool v);
 
+    bool requiresRenderThread() const;
+    void setRequiresRenderThread(bool required);
+
     virtual QVideoFilterRunnable *createFilterRunnable() = 0;
 
 Q_SIGNALS:
     void activeChanged();
+    void requiresRenderThreadChanged();
 
 private:
     Q_DECLARE_PRIVATE(QAbstractVideoFilter)
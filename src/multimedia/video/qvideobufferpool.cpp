@@ -0,0 +1,532 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#include "qvideobufferpool_p.h"
+
+#include <qabstractvideobuffer.h>
+
+#include <QtCore/qelapsedtimer.h>
+#include <QtCore/qhash.h>
+#include <QtCore/qmutex.h>
+#include <QtCore/qvariant.h>
+
+#include <string.h>
+
+QT_BEGIN_NAMESPACE
+
+/*!
+    \class QVideoBufferPool
+    \internal
+
+    QVideoBufferPool hands out system memory video buffers and takes their
+    memory back when the last QVideoFrame referring to one of them is destroyed,
+    so that producers of frames of the same format and size do not allocate a
+    new buffer for every frame.
+
+    Buffers are kept in buckets keyed by pixel format and frame size, each
+    bucket holding up to maxBuffersPerBucket() idle buffers. The data of a
+    buffer and every line of its planes are aligned to QVideoBufferPool::Alignment
+    bytes, which suits the SIMD frame converters.
+
+    Frames can be returned from any thread. Buffers still in use when the pool is
+    destroyed simply release their memory.
+
+    \code
+        QVideoFrame frame = QVideoBufferPool::instance()->allocateFrame(format, size);
+        if (frame.map(QAbstractVideoBuffer::WriteOnly)) {
+            ...
+            frame.unmap();
+        }
+    \endcode
+*/
+
+struct QVideoBufferPoolKey
+{
+    QVideoBufferPoolKey(QVideoFrame::PixelFormat format, const QSize &size)
+        : format(format), width(size.width()), height(size.height()) { }
+
+    bool operator==(const QVideoBufferPoolKey &other) const
+    {
+        return format == other.format && width == other.width && height == other.height;
+    }
+
+    QVideoFrame::PixelFormat format;
+    int width;
+    int height;
+};
+
+static inline uint qHash(const QVideoBufferPoolKey &key, uint seed = 0)
+{
+    return qHash((uint(key.format) << 24) ^ (uint(key.width) << 12) ^ uint(key.height), seed);
+}
+
+class QVideoBufferPoolPrivate : public QSharedData
+{
+public:
+    QVideoBufferPoolPrivate(int maxBuffersPerBucket)
+        : maxBuffersPerBucket(maxBuffersPerBucket)
+        , closed(false)
+        , allocations(0)
+        , reuses(0)
+        , pooledBuffers(0)
+        , pooledBytes(0)
+        , rateWindowStart(0)
+        , allocationRate(0)
+    {
+    }
+
+    QByteArray take(const QVideoBufferPoolKey &key, int bytes);
+    void recycle(const QVideoBufferPoolKey &key, QByteArray &storage);
+    void clear();
+    void updateRate();
+
+    QMutex mutex;
+    QHash<QVideoBufferPoolKey, QList<QByteArray> > buckets;
+    int maxBuffersPerBucket;
+    bool closed;
+
+    int allocations;
+    int reuses;
+    int pooledBuffers;
+    qint64 pooledBytes;
+
+    QElapsedTimer rateTimer;
+    int rateWindowStart;
+    qreal allocationRate;
+};
+
+QByteArray QVideoBufferPoolPrivate::take(const QVideoBufferPoolKey &key, int bytes)
+{
+    QMutexLocker locker(&mutex);
+    updateRate();
+
+    QHash<QVideoBufferPoolKey, QList<QByteArray> >::iterator it = buckets.find(key);
+    if (it != buckets.end() && !it->isEmpty()) {
+        QByteArray storage = it->takeLast();
+        --pooledBuffers;
+        pooledBytes -= storage.size();
+        ++reuses;
+        return storage;
+    }
+    locker.unlock();
+
+    // Room to align the start of the data
+    QByteArray storage;
+    storage.resize(bytes + QVideoBufferPool::Alignment - 1);
+    if (storage.isEmpty())
+        return storage;
+
+    locker.relock();
+    ++allocations;
+    return storage;
+}
+
+// Called when the last frame referring to a pooled buffer goes away, from any thread
+void QVideoBufferPoolPrivate::recycle(const QVideoBufferPoolKey &key, QByteArray &storage)
+{
+    // Someone kept a reference to the data, it can't be handed out again
+    if (!storage.isDetached())
+        return;
+
+    QMutexLocker locker(&mutex);
+    if (closed)
+        return;
+
+    QList<QByteArray> &bucket = buckets[key];
+    if (bucket.size() >= maxBuffersPerBucket)
+        return;
+
+    bucket.append(storage);
+    ++pooledBuffers;
+    pooledBytes += storage.size();
+}
+
+// Called locked
+void QVideoBufferPoolPrivate::clear()
+{
+    buckets.clear();
+    pooledBuffers = 0;
+    pooledBytes = 0;
+}
+
+// Called locked. Keeps the rate of the last complete window of at least a second.
+void QVideoBufferPoolPrivate::updateRate()
+{
+    if (!rateTimer.isValid()) {
+        rateTimer.start();
+        rateWindowStart = allocations;
+        return;
+    }
+
+    const qint64 elapsed = rateTimer.elapsed();
+    if (elapsed < 1000)
+        return;
+
+    allocationRate = qreal(allocations - rateWindowStart) * 1000 / elapsed;
+    rateWindowStart = allocations;
+    rateTimer.restart();
+}
+
+class QPooledVideoBuffer : public QAbstractVideoBuffer
+{
+public:
+    QPooledVideoBuffer(QVideoBufferPoolPrivate *pool, const QVideoBufferPoolKey &key,
+                       const QByteArray &storage, int bytes, int bytesPerLine)
+        : QAbstractVideoBuffer(NoHandle)
+        , m_pool(pool)
+        , m_key(key)
+        , m_storage(storage)
+        , m_bytes(bytes)
+        , m_bytesPerLine(bytesPerLine)
+        , m_mapMode(NotMapped)
+    {
+        const quintptr address = quintptr(m_storage.constData());
+        const quintptr aligned = (address + QVideoBufferPool::Alignment - 1)
+                & ~quintptr(QVideoBufferPool::Alignment - 1);
+        m_offset = int(aligned - address);
+    }
+
+    ~QPooledVideoBuffer()
+    {
+        m_pool->recycle(m_key, m_storage);
+    }
+
+    MapMode mapMode() const Q_DECL_OVERRIDE
+    {
+        return m_mapMode;
+    }
+
+    uchar *map(MapMode mode, int *numBytes, int *bytesPerLine) Q_DECL_OVERRIDE
+    {
+        if (m_mapMode != NotMapped || mode == NotMapped)
+            return 0;
+
+        m_mapMode = mode;
+        if (numBytes)
+            *numBytes = m_bytes;
+        if (bytesPerLine)
+            *bytesPerLine = m_bytesPerLine;
+        return reinterpret_cast<uchar *>(m_storage.data()) + m_offset;
+    }
+
+    void unmap() Q_DECL_OVERRIDE
+    {
+        m_mapMode = NotMapped;
+    }
+
+private:
+    QExplicitlySharedDataPointer<QVideoBufferPoolPrivate> m_pool;
+    QVideoBufferPoolKey m_key;
+    QByteArray m_storage;
+    int m_offset;
+    int m_bytes;
+    int m_bytesPerLine;
+    MapMode m_mapMode;
+};
+
+static int qPooledBytesPerPixel(QVideoFrame::PixelFormat format)
+{
+    switch (format) {
+    case QVideoFrame::Format_ARGB32:
+    case QVideoFrame::Format_ARGB32_Premultiplied:
+    case QVideoFrame::Format_RGB32:
+    case QVideoFrame::Format_BGRA32:
+    case QVideoFrame::Format_BGRA32_Premultiplied:
+    case QVideoFrame::Format_BGR32:
+    case QVideoFrame::Format_AYUV444:
+    case QVideoFrame::Format_AYUV444_Premultiplied:
+        return 4;
+    case QVideoFrame::Format_RGB24:
+    case QVideoFrame::Format_BGR24:
+    case QVideoFrame::Format_YUV444:
+    case QVideoFrame::Format_ARGB8565_Premultiplied:
+    case QVideoFrame::Format_BGRA5658_Premultiplied:
+        return 3;
+    case QVideoFrame::Format_RGB565:
+    case QVideoFrame::Format_RGB555:
+    case QVideoFrame::Format_BGR565:
+    case QVideoFrame::Format_BGR555:
+    case QVideoFrame::Format_UYVY:
+    case QVideoFrame::Format_YUYV:
+    case QVideoFrame::Format_Y16:
+        return 2;
+    case QVideoFrame::Format_Y8:
+    case QVideoFrame::Format_YUV420P:
+    case QVideoFrame::Format_YV12:
+    case QVideoFrame::Format_NV12:
+    case QVideoFrame::Format_NV21:
+    case QVideoFrame::Format_IMC1:
+    case QVideoFrame::Format_IMC2:
+    case QVideoFrame::Format_IMC3:
+    case QVideoFrame::Format_IMC4:
+        return 1;
+    default:
+        // Compressed or opaque formats
+        return 0;
+    }
+}
+
+static inline int qAlignBytes(int bytes, int alignment)
+{
+    return (bytes + alignment - 1) & ~(alignment - 1);
+}
+
+Q_GLOBAL_STATIC(QVideoBufferPool, qVideoBufferPool)
+
+/*!
+    Constructs a pool keeping up to \a maxBuffersPerBucket idle buffers of each
+    format and size.
+*/
+QVideoBufferPool::QVideoBufferPool(int maxBuffersPerBucket)
+    : d(new QVideoBufferPoolPrivate(qMax(0, maxBuffersPerBucket)))
+{
+}
+
+QVideoBufferPool::~QVideoBufferPool()
+{
+    QMutexLocker locker(&d->mutex);
+    d->closed = true;
+    d->clear();
+}
+
+/*!
+    Returns the pool shared by the producers that opt in to buffer recycling.
+*/
+QVideoBufferPool *QVideoBufferPool::instance()
+{
+    return qVideoBufferPool();
+}
+
+/*!
+    Returns the stride of the first plane of a pooled \a format frame \a width
+    pixels wide, or 0 if the format can't be pooled.
+*/
+int QVideoBufferPool::alignedBytesPerLine(QVideoFrame::PixelFormat format, int width)
+{
+    const int bytesPerPixel = qPooledBytesPerPixel(format);
+    if (bytesPerPixel == 0 || width <= 0)
+        return 0;
+
+    switch (format) {
+    case QVideoFrame::Format_YUV420P:
+    case QVideoFrame::Format_YV12:
+        // QVideoFrame derives the chroma stride as half the luma stride
+        return qAlignBytes(width, 2 * Alignment);
+    default:
+        return qAlignBytes(width * bytesPerPixel, Alignment);
+    }
+}
+
+/*!
+    Returns the number of bytes QVideoFrame expects for all planes of a \a format
+    frame of \a size with a first plane stride of \a bytesPerLine.
+*/
+int QVideoBufferPool::frameBytes(QVideoFrame::PixelFormat format, const QSize &size, int bytesPerLine)
+{
+    const int height = size.height();
+    switch (format) {
+    case QVideoFrame::Format_YUV420P:
+    case QVideoFrame::Format_YV12:
+        return bytesPerLine * height + bytesPerLine / 2 * height;
+    case QVideoFrame::Format_NV12:
+    case QVideoFrame::Format_NV21:
+    case QVideoFrame::Format_IMC2:
+    case QVideoFrame::Format_IMC4:
+        return bytesPerLine * height + bytesPerLine * ((height + 1) / 2);
+    case QVideoFrame::Format_IMC1:
+    case QVideoFrame::Format_IMC3:
+        return 2 * bytesPerLine * height;
+    default:
+        return bytesPerLine * height;
+    }
+}
+
+/*!
+    Returns a system memory buffer for a \a format frame of \a size, reusing an
+    idle one when there is one. Returns 0 if the format is not supported.
+
+    The contents of the buffer are undefined. Ownership is transferred to the
+    caller, usually by constructing a QVideoFrame from it.
+*/
+QAbstractVideoBuffer *QVideoBufferPool::allocateBuffer(QVideoFrame::PixelFormat format, const QSize &size)
+{
+    const int bytesPerLine = alignedBytesPerLine(format, size.width());
+    if (bytesPerLine == 0 || size.height() <= 0)
+        return 0;
+
+    const QVideoBufferPoolKey key(format, size);
+    const int bytes = frameBytes(format, size, bytesPerLine);
+    // A spare line, QVideoFrame starts the last chroma plane of 4:2:0 frames
+    // with an odd height half a line early.
+    const QByteArray storage = d->take(key, bytes + bytesPerLine);
+    if (storage.isEmpty())
+        return 0;
+
+    return new QPooledVideoBuffer(d.data(), key, storage, bytes, bytesPerLine);
+}
+
+/*!
+    Returns a frame backed by a pooled buffer, or an invalid frame if the
+    \a format can't be pooled.
+*/
+QVideoFrame QVideoBufferPool::allocateFrame(QVideoFrame::PixelFormat format, const QSize &size)
+{
+    QAbstractVideoBuffer *buffer = allocateBuffer(format, size);
+    return buffer ? QVideoFrame(buffer, size, format) : QVideoFrame();
+}
+
+/*!
+    Returns a copy of \a frame in a pooled buffer, including its time stamps and
+    meta-data. This releases whatever resources held the original frame data,
+    for example a decoder's buffer. Returns an invalid frame if the frame can't
+    be mapped or its format can't be pooled.
+*/
+QVideoFrame QVideoBufferPool::copyFrame(const QVideoFrame &frame)
+{
+    QVideoFrame source(frame);
+    if (!source.map(QAbstractVideoBuffer::ReadOnly))
+        return QVideoFrame();
+
+    QVideoFrame copy = allocateFrame(source.pixelFormat(), source.size());
+    if (!copy.isValid() || !copy.map(QAbstractVideoBuffer::WriteOnly)) {
+        source.unmap();
+        return QVideoFrame();
+    }
+
+    const int height = source.height();
+    const int planeCount = qMin(source.planeCount(), copy.planeCount());
+    for (int plane = 0; plane < planeCount; ++plane) {
+        // Planes after the first one are vertically subsampled in all poolable formats
+        const int rows = plane == 0 ? height : (height + 1) / 2;
+        const int sourceStride = source.bytesPerLine(plane);
+        const int copyStride = copy.bytesPerLine(plane);
+        const int rowBytes = qMin(sourceStride, copyStride);
+        const uchar *src = source.bits(plane);
+        uchar *dst = copy.bits(plane);
+        if (sourceStride == copyStride) {
+            memcpy(dst, src, size_t(rows) * copyStride);
+        } else {
+            for (int y = 0; y < rows; ++y)
+                memcpy(dst + y * copyStride, src + y * sourceStride, rowBytes);
+        }
+    }
+
+    copy.unmap();
+    source.unmap();
+
+    copy.setStartTime(frame.startTime());
+    copy.setEndTime(frame.endTime());
+    copy.setFieldType(frame.fieldType());
+    const QVariantMap metaData = frame.availableMetaData();
+    for (QVariantMap::const_iterator it = metaData.constBegin(); it != metaData.constEnd(); ++it)
+        copy.setMetaData(it.key(), it.value());
+
+    return copy;
+}
+
+int QVideoBufferPool::maxBuffersPerBucket() const
+{
+    QMutexLocker locker(&d->mutex);
+    return d->maxBuffersPerBucket;
+}
+
+/*!
+    Sets the number of idle buffers kept per format and size to \a count. Idle
+    buffers above the new limit are released.
+*/
+void QVideoBufferPool::setMaxBuffersPerBucket(int count)
+{
+    QMutexLocker locker(&d->mutex);
+    d->maxBuffersPerBucket = qMax(0, count);
+
+    QHash<QVideoBufferPoolKey, QList<QByteArray> >::iterator it = d->buckets.begin();
+    for (; it != d->buckets.end(); ++it) {
+        while (it->size() > d->maxBuffersPerBucket) {
+            --d->pooledBuffers;
+            d->pooledBytes -= it->takeLast().size();
+        }
+    }
+}
+
+/*!
+    Releases all idle buffers.
+*/
+void QVideoBufferPool::clear()
+{
+    QMutexLocker locker(&d->mutex);
+    d->clear();
+}
+
+/*!
+    Returns the number of buffers that had to be allocated.
+*/
+int QVideoBufferPool::allocationCount() const
+{
+    QMutexLocker locker(&d->mutex);
+    return d->allocations;
+}
+
+/*!
+    Returns the number of buffers that were served from the pool.
+*/
+int QVideoBufferPool::reuseCount() const
+{
+    QMutexLocker locker(&d->mutex);
+    return d->reuses;
+}
+
+int QVideoBufferPool::pooledBufferCount() const
+{
+    QMutexLocker locker(&d->mutex);
+    return d->pooledBuffers;
+}
+
+qint64 QVideoBufferPool::pooledBytes() const
+{
+    QMutexLocker locker(&d->mutex);
+    return d->pooledBytes;
+}
+
+/*!
+    Returns how many buffers per second had to be allocated, measured over the
+    last period of at least a second.
+*/
+qreal QVideoBufferPool::allocationsPerSecond() const
+{
+    QMutexLocker locker(&d->mutex);
+    d->updateRate();
+    return d->allocationRate;
+}
+
+QT_END_NAMESPACE
@@ -0,0 +1,93 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#ifndef QVIDEOBUFFERPOOL_P_H
+#define QVIDEOBUFFERPOOL_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include <qvideoframe.h>
+
+#include <QtCore/qshareddata.h>
+
+QT_BEGIN_NAMESPACE
+
+class QAbstractVideoBuffer;
+class QVideoBufferPoolPrivate;
+
+class Q_MULTIMEDIA_EXPORT QVideoBufferPool
+{
+public:
+    enum { Alignment = 64 };
+
+    explicit QVideoBufferPool(int maxBuffersPerBucket = 4);
+    ~QVideoBufferPool();
+
+    static QVideoBufferPool *instance();
+
+    static int alignedBytesPerLine(QVideoFrame::PixelFormat format, int width);
+    static int frameBytes(QVideoFrame::PixelFormat format, const QSize &size, int bytesPerLine);
+
+    QAbstractVideoBuffer *allocateBuffer(QVideoFrame::PixelFormat format, const QSize &size);
+    QVideoFrame allocateFrame(QVideoFrame::PixelFormat format, const QSize &size);
+    QVideoFrame copyFrame(const QVideoFrame &frame);
+
+    int maxBuffersPerBucket() const;
+    void setMaxBuffersPerBucket(int count);
+    void clear();
+
+    int allocationCount() const;
+    int reuseCount() const;
+    int pooledBufferCount() const;
+    qint64 pooledBytes() const;
+    qreal allocationsPerSecond() const;
+
+private:
+    Q_DISABLE_COPY(QVideoBufferPool)
+
+    QExplicitlySharedDataPointer<QVideoBufferPoolPrivate> d;
+};
+
+QT_END_NAMESPACE
+
+#endif
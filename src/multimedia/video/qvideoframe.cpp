@@ -44,6 +44,10 @@
 #include <qvariant.h>
 #include <qvector.h>
 #include <qmutex.h>
+#include <qrunnable.h>
+#include <qsemaphore.h>
+#include <qthreadpool.h>
+#include <qvarlengtharray.h>
 
 #include <QDebug>
 
@@ -1017,6 +1021,7 @@ extern void QT_FASTCALL qt_convert_UYVY_to_ARGB32(const QVideoFrame&, uchar*);
 extern void QT_FASTCALL qt_convert_YUYV_to_ARGB32(const QVideoFrame&, uchar*);
 extern void QT_FASTCALL qt_convert_NV12_to_ARGB32(const QVideoFrame&, uchar*);
 extern void QT_FASTCALL qt_convert_NV21_to_ARGB32(const QVideoFrame&, uchar*);
+extern void QT_FASTCALL qt_convert_YUVRow_to_ARGB32(const uchar*, const uchar*, const uchar*, quint32*, int);
 
 static VideoFrameConvertFunc qConvertFuncs[QVideoFrame::NPixelFormats] = {
     /* Format_Invalid */                Q_NULLPTR, // Not needed
@@ -1054,34 +1059,238 @@ static VideoFrameConvertFunc qConvertFuncs[QVideoFrame::NPixelFormats] = {
     /* Format_AdobeDng */               Q_NULLPTR
 };
 
+static VideoRowConvertFunc qConvertRowFunc = qt_convert_YUVRow_to_ARGB32;
+
 static void qInitConvertFuncsAsm()
 {
 #ifdef QT_COMPILER_SUPPORTS_SSE2
     extern void QT_FASTCALL qt_convert_BGRA32_to_ARGB32_sse2(const QVideoFrame&, uchar*);
+    extern void QT_FASTCALL qt_convert_AYUV444_to_ARGB32_sse2(const QVideoFrame&, uchar*);
+    extern void QT_FASTCALL qt_convert_YUV420P_to_ARGB32_sse2(const QVideoFrame&, uchar*);
+    extern void QT_FASTCALL qt_convert_YV12_to_ARGB32_sse2(const QVideoFrame&, uchar*);
+    extern void QT_FASTCALL qt_convert_UYVY_to_ARGB32_sse2(const QVideoFrame&, uchar*);
+    extern void QT_FASTCALL qt_convert_YUYV_to_ARGB32_sse2(const QVideoFrame&, uchar*);
+    extern void QT_FASTCALL qt_convert_NV12_to_ARGB32_sse2(const QVideoFrame&, uchar*);
+    extern void QT_FASTCALL qt_convert_NV21_to_ARGB32_sse2(const QVideoFrame&, uchar*);
+    extern void QT_FASTCALL qt_convert_YUVRow_to_ARGB32_sse2(const uchar*, const uchar*, const uchar*, quint32*, int);
     if (qCpuHasFeature(SSE2)){
         qConvertFuncs[QVideoFrame::Format_BGRA32] = qt_convert_BGRA32_to_ARGB32_sse2;
         qConvertFuncs[QVideoFrame::Format_BGRA32_Premultiplied] = qt_convert_BGRA32_to_ARGB32_sse2;
         qConvertFuncs[QVideoFrame::Format_BGR32] = qt_convert_BGRA32_to_ARGB32_sse2;
+        qConvertFuncs[QVideoFrame::Format_AYUV444] = qt_convert_AYUV444_to_ARGB32_sse2;
+        qConvertFuncs[QVideoFrame::Format_YUV420P] = qt_convert_YUV420P_to_ARGB32_sse2;
+        qConvertFuncs[QVideoFrame::Format_YV12] = qt_convert_YV12_to_ARGB32_sse2;
+        qConvertFuncs[QVideoFrame::Format_UYVY] = qt_convert_UYVY_to_ARGB32_sse2;
+        qConvertFuncs[QVideoFrame::Format_YUYV] = qt_convert_YUYV_to_ARGB32_sse2;
+        qConvertFuncs[QVideoFrame::Format_NV12] = qt_convert_NV12_to_ARGB32_sse2;
+        qConvertFuncs[QVideoFrame::Format_NV21] = qt_convert_NV21_to_ARGB32_sse2;
+        qConvertRowFunc = qt_convert_YUVRow_to_ARGB32_sse2;
     }
 #endif
 #ifdef QT_COMPILER_SUPPORTS_SSSE3
     extern void QT_FASTCALL qt_convert_BGRA32_to_ARGB32_ssse3(const QVideoFrame&, uchar*);
+    extern void QT_FASTCALL qt_convert_YUV444_to_ARGB32_ssse3(const QVideoFrame&, uchar*);
     if (qCpuHasFeature(SSSE3)){
         qConvertFuncs[QVideoFrame::Format_BGRA32] = qt_convert_BGRA32_to_ARGB32_ssse3;
         qConvertFuncs[QVideoFrame::Format_BGRA32_Premultiplied] = qt_convert_BGRA32_to_ARGB32_ssse3;
         qConvertFuncs[QVideoFrame::Format_BGR32] = qt_convert_BGRA32_to_ARGB32_ssse3;
+        qConvertFuncs[QVideoFrame::Format_YUV444] = qt_convert_YUV444_to_ARGB32_ssse3;
     }
 #endif
 #ifdef QT_COMPILER_SUPPORTS_AVX2
     extern void QT_FASTCALL qt_convert_BGRA32_to_ARGB32_avx2(const QVideoFrame&, uchar*);
+    extern void QT_FASTCALL qt_convert_YUV420P_to_ARGB32_avx2(const QVideoFrame&, uchar*);
+    extern void QT_FASTCALL qt_convert_YV12_to_ARGB32_avx2(const QVideoFrame&, uchar*);
+    extern void QT_FASTCALL qt_convert_UYVY_to_ARGB32_avx2(const QVideoFrame&, uchar*);
+    extern void QT_FASTCALL qt_convert_YUYV_to_ARGB32_avx2(const QVideoFrame&, uchar*);
+    extern void QT_FASTCALL qt_convert_NV12_to_ARGB32_avx2(const QVideoFrame&, uchar*);
+    extern void QT_FASTCALL qt_convert_NV21_to_ARGB32_avx2(const QVideoFrame&, uchar*);
     if (qCpuHasFeature(AVX2)){
         qConvertFuncs[QVideoFrame::Format_BGRA32] = qt_convert_BGRA32_to_ARGB32_avx2;
         qConvertFuncs[QVideoFrame::Format_BGRA32_Premultiplied] = qt_convert_BGRA32_to_ARGB32_avx2;
         qConvertFuncs[QVideoFrame::Format_BGR32] = qt_convert_BGRA32_to_ARGB32_avx2;
+        qConvertFuncs[QVideoFrame::Format_YUV420P] = qt_convert_YUV420P_to_ARGB32_avx2;
+        qConvertFuncs[QVideoFrame::Format_YV12] = qt_convert_YV12_to_ARGB32_avx2;
+        qConvertFuncs[QVideoFrame::Format_UYVY] = qt_convert_UYVY_to_ARGB32_avx2;
+        qConvertFuncs[QVideoFrame::Format_YUYV] = qt_convert_YUYV_to_ARGB32_avx2;
+        qConvertFuncs[QVideoFrame::Format_NV12] = qt_convert_NV12_to_ARGB32_avx2;
+        qConvertFuncs[QVideoFrame::Format_NV21] = qt_convert_NV21_to_ARGB32_avx2;
+    }
+#endif
+#ifdef QT_COMPILER_SUPPORTS_NEON
+    extern void QT_FASTCALL qt_convert_AYUV444_to_ARGB32_neon(const QVideoFrame&, uchar*);
+    extern void QT_FASTCALL qt_convert_YUV444_to_ARGB32_neon(const QVideoFrame&, uchar*);
+    extern void QT_FASTCALL qt_convert_YUV420P_to_ARGB32_neon(const QVideoFrame&, uchar*);
+    extern void QT_FASTCALL qt_convert_YV12_to_ARGB32_neon(const QVideoFrame&, uchar*);
+    extern void QT_FASTCALL qt_convert_UYVY_to_ARGB32_neon(const QVideoFrame&, uchar*);
+    extern void QT_FASTCALL qt_convert_YUYV_to_ARGB32_neon(const QVideoFrame&, uchar*);
+    extern void QT_FASTCALL qt_convert_NV12_to_ARGB32_neon(const QVideoFrame&, uchar*);
+    extern void QT_FASTCALL qt_convert_NV21_to_ARGB32_neon(const QVideoFrame&, uchar*);
+    if (qCpuHasFeature(NEON)){
+        qConvertFuncs[QVideoFrame::Format_AYUV444] = qt_convert_AYUV444_to_ARGB32_neon;
+        qConvertFuncs[QVideoFrame::Format_YUV444] = qt_convert_YUV444_to_ARGB32_neon;
+        qConvertFuncs[QVideoFrame::Format_YUV420P] = qt_convert_YUV420P_to_ARGB32_neon;
+        qConvertFuncs[QVideoFrame::Format_YV12] = qt_convert_YV12_to_ARGB32_neon;
+        qConvertFuncs[QVideoFrame::Format_UYVY] = qt_convert_UYVY_to_ARGB32_neon;
+        qConvertFuncs[QVideoFrame::Format_YUYV] = qt_convert_YUYV_to_ARGB32_neon;
+        qConvertFuncs[QVideoFrame::Format_NV12] = qt_convert_NV12_to_ARGB32_neon;
+        qConvertFuncs[QVideoFrame::Format_NV21] = qt_convert_NV21_to_ARGB32_neon;
     }
 #endif
 }
 
+static void qInitConvertFuncs()
+{
+    static bool initAsmFuncsDone = false;
+    if (!initAsmFuncsDone) {
+        qInitConvertFuncsAsm();
+        initAsmFuncsDone = true;
+    }
+}
+
+/*
+    Maps a horizontal band of rows of an already mapped frame, so that the
+    whole-frame converters can be run on each band independently.
+*/
+class QVideoFrameBandBuffer : public QAbstractPlanarVideoBuffer
+{
+public:
+    QVideoFrameBandBuffer(const QVideoFrame &frame, int firstRow, int rowCount)
+        : QAbstractPlanarVideoBuffer(NoHandle)
+        , m_planeCount(frame.planeCount())
+        , m_mappedBytes(0)
+    {
+        // Chroma planes of 4:2:0 formats are vertically subsampled.
+        const bool subsampled = m_planeCount > 1;
+
+        for (int i = 0; i < m_planeCount; ++i) {
+            const int row = i > 0 && subsampled ? firstRow / 2 : firstRow;
+            const int rows = i > 0 && subsampled ? (rowCount + 1) / 2 : rowCount;
+            m_bytesPerLine[i] = frame.bytesPerLine(i);
+            m_data[i] = const_cast<uchar *>(frame.bits(i)) + row * m_bytesPerLine[i];
+            m_mappedBytes += rows * m_bytesPerLine[i];
+        }
+    }
+
+    MapMode mapMode() const { return ReadOnly; }
+
+    int map(MapMode, int *numBytes, int bytesPerLine[4], uchar *data[4])
+    {
+        if (numBytes)
+            *numBytes = m_mappedBytes;
+        for (int i = 0; i < m_planeCount; ++i) {
+            bytesPerLine[i] = m_bytesPerLine[i];
+            data[i] = m_data[i];
+        }
+        return m_planeCount;
+    }
+
+    void unmap() {}
+
+private:
+    int m_planeCount;
+    int m_mappedBytes;
+    int m_bytesPerLine[4];
+    uchar *m_data[4];
+};
+
+class QVideoFrameBandConverter : public QRunnable
+{
+public:
+    QVideoFrameBandConverter(VideoFrameConvertFunc convert, const QVideoFrame &frame, uchar *output,
+                             int firstRow, int rowCount, QSemaphore *done)
+        : m_convert(convert)
+        , m_frame(new QVideoFrameBandBuffer(frame, firstRow, rowCount),
+                  QSize(frame.width(), rowCount), frame.pixelFormat())
+        , m_output(output + firstRow * frame.width() * 4)
+        , m_done(done)
+    {
+    }
+
+    void run()
+    {
+        if (m_frame.map(QAbstractVideoBuffer::ReadOnly)) {
+            m_convert(m_frame, m_output);
+            m_frame.unmap();
+        }
+        if (m_done)
+            m_done->release();
+    }
+
+private:
+    VideoFrameConvertFunc m_convert;
+    QVideoFrame m_frame;
+    uchar *m_output;
+    QSemaphore *m_done;
+};
+
+// Frames smaller than this are converted on the calling thread.
+static const int qConvertBandMinimumPixels = 1280 * 720;
+// Minimum height of a band, band heights are also kept even so that
+// 4:2:0 chroma rows are never shared between two bands.
+static const int qConvertBandMinimumRows = 64;
+
+static QBasicAtomicInt qConvertThreads = Q_BASIC_ATOMIC_INITIALIZER(0);
+
+static int qConvertThreadCount()
+{
+    int threadCount = qConvertThreads.load();
+    if (threadCount == 0) {
+        bool ok = false;
+        const int value = qgetenv("QT_VIDEOFRAME_CONVERSION_THREADS").toInt(&ok);
+        threadCount = ok ? qBound(1, value, 32) : 1;
+        qConvertThreads.testAndSetOrdered(0, threadCount);
+        threadCount = qConvertThreads.load();
+    }
+    return threadCount;
+}
+
+Q_GLOBAL_STATIC(QThreadPool, qConvertThreadPool)
+
+/*!
+    \internal
+
+    Sets the number of threads used to convert frames of at least 1280x720
+    pixels to ARGB32. The frame is split into horizontal bands of rows, one
+    of which is always converted on the calling thread. A \a count of 1
+    disables the split, this is the default unless the
+    QT_VIDEOFRAME_CONVERSION_THREADS environment variable is set.
+*/
+void qt_setVideoFrameConversionThreadCount(int count)
+{
+    qConvertThreads.store(qBound(1, count, 32));
+}
+
+static void qConvertFrame(VideoFrameConvertFunc convert, const QVideoFrame &frame, uchar *output)
+{
+    const int height = frame.height();
+    int bandCount = qConvertThreadCount();
+    if (bandCount > 1 && frame.width() * height >= qConvertBandMinimumPixels)
+        bandCount = qMin(bandCount, height / qConvertBandMinimumRows);
+    else
+        bandCount = 1;
+
+    if (bandCount <= 1) {
+        convert(frame, output);
+        return;
+    }
+
+    QThreadPool *pool = qConvertThreadPool();
+    if (pool->maxThreadCount() < bandCount - 1)
+        pool->setMaxThreadCount(bandCount - 1);
+
+    const int bandRows = (height / bandCount) & ~1;
+    QSemaphore done;
+    for (int i = 1; i < bandCount; ++i) {
+        const int firstRow = i * bandRows;
+        const int rowCount = i == bandCount - 1 ? height - firstRow : bandRows;
+        pool->start(new QVideoFrameBandConverter(convert, frame, output, firstRow, rowCount, &done));
+    }
+
+    QVideoFrameBandConverter(convert, frame, output, 0, bandRows, Q_NULLPTR).run();
+    done.acquire(bandCount - 1);
+}
+
 /*!
     \internal
 */
@@ -1106,17 +1315,13 @@ QImage qt_imageFromVideoFrame(const QVideoFrame &f)
 
     // Need conversion
     else {
-        static bool initAsmFuncsDone = false;
-        if (!initAsmFuncsDone) {
-            qInitConvertFuncsAsm();
-            initAsmFuncsDone = true;
-        }
+        qInitConvertFuncs();
         VideoFrameConvertFunc convert = qConvertFuncs[frame.pixelFormat()];
         if (!convert) {
             qWarning() << Q_FUNC_INFO << ": unsupported pixel format" << frame.pixelFormat();
         } else {
             result = QImage(frame.width(), frame.height(), QImage::Format_ARGB32);
-            convert(frame, result.bits());
+            qConvertFrame(convert, frame, result.bits());
         }
     }
 
@@ -1125,6 +1330,146 @@ QImage qt_imageFromVideoFrame(const QVideoFrame &f)
     return result;
 }
 
+/*
+    Where the Y, U and V samples of each pixel live in a mapped frame. Chroma
+    samples are shared by 1 << chromaShiftX columns and 1 << chromaShiftY rows.
+*/
+struct QVideoFrameSampleLayout
+{
+    const uchar *data[3];
+    int bytesPerLine[3];
+    int pixelStride[3];
+    int chromaShiftX;
+    int chromaShiftY;
+};
+
+static bool qSampleLayout(const QVideoFrame &frame, QVideoFrameSampleLayout *layout)
+{
+    const uchar *bits = frame.bits();
+    const int bytesPerLine = frame.bytesPerLine();
+
+    switch (frame.pixelFormat()) {
+    case QVideoFrame::Format_YUV420P:
+    case QVideoFrame::Format_YV12: {
+        const int u = frame.pixelFormat() == QVideoFrame::Format_YUV420P ? 1 : 2;
+        const int v = 3 - u;
+        const QVideoFrameSampleLayout planar = {
+            { frame.bits(0), frame.bits(u), frame.bits(v) },
+            { frame.bytesPerLine(0), frame.bytesPerLine(u), frame.bytesPerLine(v) },
+            { 1, 1, 1 }, 1, 1
+        };
+        *layout = planar;
+        return frame.planeCount() == 3;
+    }
+    case QVideoFrame::Format_NV12:
+    case QVideoFrame::Format_NV21: {
+        const int u = frame.pixelFormat() == QVideoFrame::Format_NV12 ? 0 : 1;
+        const QVideoFrameSampleLayout semiPlanar = {
+            { frame.bits(0), frame.bits(1) + u, frame.bits(1) + 1 - u },
+            { frame.bytesPerLine(0), frame.bytesPerLine(1), frame.bytesPerLine(1) },
+            { 1, 2, 2 }, 1, 1
+        };
+        *layout = semiPlanar;
+        return frame.planeCount() == 2;
+    }
+    case QVideoFrame::Format_UYVY: {
+        const QVideoFrameSampleLayout packed = {
+            { bits + 1, bits, bits + 2 },
+            { bytesPerLine, bytesPerLine, bytesPerLine },
+            { 2, 4, 4 }, 1, 0
+        };
+        *layout = packed;
+        return true;
+    }
+    case QVideoFrame::Format_YUYV: {
+        const QVideoFrameSampleLayout packed = {
+            { bits, bits + 1, bits + 3 },
+            { bytesPerLine, bytesPerLine, bytesPerLine },
+            { 2, 4, 4 }, 1, 0
+        };
+        *layout = packed;
+        return true;
+    }
+    case QVideoFrame::Format_YUV444: {
+        const QVideoFrameSampleLayout packed = {
+            { bits, bits + 1, bits + 2 },
+            { bytesPerLine, bytesPerLine, bytesPerLine },
+            { 3, 3, 3 }, 0, 0
+        };
+        *layout = packed;
+        return true;
+    }
+    default:
+        return false;
+    }
+}
+
+/*!
+    \internal
+
+    Converts the \a source rectangle of a mapped YUV \a frame to RGB32,
+    scaling it to the size of \a target with nearest neighbor sampling. The
+    samples of each output row are gathered and converted in a single pass, so
+    the frame is never converted at its full resolution. The output is flipped
+    in the directions given by \a mirrored.
+
+    \a target must be an RGB32 or ARGB32 image. Returns false if the pixel
+    format of \a frame is not supported.
+*/
+bool qt_convertVideoFrameScaled(const QVideoFrame &frame, const QRect &source, QImage *target,
+                                Qt::Orientations mirrored)
+{
+    QVideoFrameSampleLayout layout;
+    if (!frame.isMapped() || !qSampleLayout(frame, &layout))
+        return false;
+
+    const QRect sourceRect = source & QRect(QPoint(0, 0), frame.size());
+    const int width = target->width();
+    const int height = target->height();
+    if (sourceRect.isEmpty() || width <= 0 || height <= 0)
+        return true;
+
+    qInitConvertFuncs();
+    const VideoRowConvertFunc convertRow = qConvertRowFunc;
+
+    // Byte offsets of the sample taken for each output column, shared by all rows
+    QVarLengthArray<int, 2048> lumaOffsets(width);
+    QVarLengthArray<int, 2048> chromaOffsets(width);
+    for (int x = 0; x < width; ++x) {
+        const int column = mirrored & Qt::Horizontal ? width - 1 - x : x;
+        const int sourceX = sourceRect.x()
+                + int((2 * qint64(column) + 1) * sourceRect.width() / (2 * qint64(width)));
+        lumaOffsets[x] = sourceX * layout.pixelStride[0];
+        chromaOffsets[x] = (sourceX >> layout.chromaShiftX) * layout.pixelStride[1];
+    }
+
+    QVarLengthArray<uchar, 3 * 2048> samples(3 * width);
+    uchar *y = samples.data();
+    uchar *u = y + width;
+    uchar *v = u + width;
+
+    for (int row = 0; row < height; ++row) {
+        const int line = mirrored & Qt::Vertical ? height - 1 - row : row;
+        const int sourceY = sourceRect.y()
+                + int((2 * qint64(line) + 1) * sourceRect.height() / (2 * qint64(height)));
+        const int chromaY = sourceY >> layout.chromaShiftY;
+
+        const uchar *lineY = layout.data[0] + sourceY * layout.bytesPerLine[0];
+        const uchar *lineU = layout.data[1] + chromaY * layout.bytesPerLine[1];
+        const uchar *lineV = layout.data[2] + chromaY * layout.bytesPerLine[2];
+
+        for (int x = 0; x < width; ++x) {
+            y[x] = lineY[lumaOffsets[x]];
+            u[x] = lineU[chromaOffsets[x]];
+            v[x] = lineV[chromaOffsets[x]];
+        }
+
+        convertRow(y, u, v, reinterpret_cast<quint32 *>(target->scanLine(row)), width);
+    }
+
+    return true;
+}
+
 #ifndef QT_NO_DEBUG_STREAM
 QDebug operator<<(QDebug dbg, QVideoFrame::PixelFormat pf)
 {
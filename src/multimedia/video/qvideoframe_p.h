@@ -50,6 +50,9 @@
 QT_BEGIN_NAMESPACE
 
 Q_MULTIMEDIA_EXPORT QImage qt_imageFromVideoFrame(const QVideoFrame &frame);
+Q_MULTIMEDIA_EXPORT void qt_setVideoFrameConversionThreadCount(int count);
+Q_MULTIMEDIA_EXPORT bool qt_convertVideoFrameScaled(const QVideoFrame &frame, const QRect &source,
+                                                    QImage *target, Qt::Orientations mirrored = 0);
 
 QT_END_NAMESPACE
 
@@ -35,24 +35,6 @@
 
 QT_BEGIN_NAMESPACE
 
-#define CLAMP(n) (n > 255 ? 255 : (n < 0 ? 0 : n))
-
-#define EXPAND_UV(u, v) \
-    int uu = u - 128; \
-    int vv = v - 128; \
-    int rv = 409 * vv + 128; \
-    int guv = 100 * uu + 208 * vv + 128; \
-    int bu = 516 * uu + 128; \
-
-static inline quint32 qYUVToARGB32(int y, int rv, int guv, int bu, int a = 0xff)
-{
-    int yy = (y - 16) * 298;
-    return (a << 24)
-            | CLAMP((yy + rv) >> 8) << 16
-            | CLAMP((yy - guv) >> 8) << 8
-            | CLAMP((yy + bu) >> 8);
-}
-
 static inline void planarYUV420_to_ARGB32(const uchar *y, int yStride,
                                           const uchar *u, int uStride,
                                           const uchar *v, int vStride,
@@ -235,6 +217,15 @@ void QT_FASTCALL qt_convert_NV21_to_ARGB32(const QVideoFrame &frame, uchar *outp
                            width, height);
 }
 
+void QT_FASTCALL qt_convert_YUVRow_to_ARGB32(const uchar *y, const uchar *u, const uchar *v,
+                                             quint32 *rgb, int width)
+{
+    for (int x = 0; x < width; ++x) {
+        EXPAND_UV(u[x], v[x]);
+        rgb[x] = qYUVToARGB32(y[x], rv, guv, bu);
+    }
+}
+
 void QT_FASTCALL qt_convert_BGRA32_to_ARGB32(const QVideoFrame &frame, uchar *output)
 {
     FETCH_INFO_PACKED(frame)
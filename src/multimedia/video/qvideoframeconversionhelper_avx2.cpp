@@ -78,6 +78,210 @@ void QT_FASTCALL qt_convert_BGRA32_to_ARGB32_avx2(const QVideoFrame &frame, ucha
     }
 }
 
+// Converts sixteen pixels, see qYUVToARGB32_sse2()
+static inline void qYUVToARGB32_avx2(__m256i y, __m256i u, __m256i v, __m256i a, quint32 *rgb)
+{
+    const __m256i yOffset = _mm256_set1_epi16(16);
+    const __m256i uvOffset = _mm256_set1_epi16(128);
+    const __m256i one = _mm256_set1_epi16(1);
+    const __m256i round = _mm256_set1_epi32(128);
+    const __m256i rFactors = _mm256_set1_epi32((409 << 16) | 298);
+    const __m256i gFactors = _mm256_set1_epi32(int(0xff9c0000) | 298); // (298, -100)
+    const __m256i gvFactors = _mm256_set1_epi32(int(0xff80ff30)); // (-208, -128)
+    const __m256i bFactors = _mm256_set1_epi32((516 << 16) | 298);
+
+    y = _mm256_sub_epi16(y, yOffset);
+    u = _mm256_sub_epi16(u, uvOffset);
+    v = _mm256_sub_epi16(v, uvOffset);
+
+    // The unpacks and packs work within 128-bit lanes, so the pixel order
+    // is only restored by the final permutation.
+    const __m256i yvLo = _mm256_unpacklo_epi16(y, v);
+    const __m256i yvHi = _mm256_unpackhi_epi16(y, v);
+    const __m256i yuLo = _mm256_unpacklo_epi16(y, u);
+    const __m256i yuHi = _mm256_unpackhi_epi16(y, u);
+    const __m256i v1Lo = _mm256_unpacklo_epi16(v, one);
+    const __m256i v1Hi = _mm256_unpackhi_epi16(v, one);
+
+    const __m256i r = _mm256_packs_epi32(
+                _mm256_srai_epi32(_mm256_add_epi32(_mm256_madd_epi16(yvLo, rFactors), round), 8),
+                _mm256_srai_epi32(_mm256_add_epi32(_mm256_madd_epi16(yvHi, rFactors), round), 8));
+    const __m256i g = _mm256_packs_epi32(
+                _mm256_srai_epi32(_mm256_add_epi32(_mm256_madd_epi16(yuLo, gFactors), _mm256_madd_epi16(v1Lo, gvFactors)), 8),
+                _mm256_srai_epi32(_mm256_add_epi32(_mm256_madd_epi16(yuHi, gFactors), _mm256_madd_epi16(v1Hi, gvFactors)), 8));
+    const __m256i b = _mm256_packs_epi32(
+                _mm256_srai_epi32(_mm256_add_epi32(_mm256_madd_epi16(yuLo, bFactors), round), 8),
+                _mm256_srai_epi32(_mm256_add_epi32(_mm256_madd_epi16(yuHi, bFactors), round), 8));
+
+    const __m256i br = _mm256_packus_epi16(b, r);
+    const __m256i ga = _mm256_packus_epi16(g, a);
+    const __m256i bg = _mm256_unpacklo_epi8(br, ga);
+    const __m256i ra = _mm256_unpackhi_epi8(br, ga);
+    const __m256i lo = _mm256_unpacklo_epi16(bg, ra);
+    const __m256i hi = _mm256_unpackhi_epi16(bg, ra);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(rgb), _mm256_permute2x128_si256(lo, hi, 0x20));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(rgb + 8), _mm256_permute2x128_si256(lo, hi, 0x31));
+}
+
+static inline void qExpandInterleavedUV_avx2(__m256i uv, __m256i *c0, __m256i *c1)
+{
+    const __m256i lowMask = _mm256_set1_epi32(0x0000ffff);
+    const __m256i first = _mm256_and_si256(uv, lowMask);
+    const __m256i second = _mm256_srli_epi32(uv, 16);
+    *c0 = _mm256_or_si256(first, _mm256_slli_epi32(first, 16));
+    *c1 = _mm256_or_si256(second, _mm256_slli_epi32(second, 16));
+}
+
+static inline void planarYUV420Row_to_ARGB32_avx2(const uchar *y, const uchar *u, const uchar *v,
+                                                  int uvPixelStride, quint32 *rgb, int width)
+{
+    const __m256i alpha = _mm256_set1_epi16(0xff);
+
+    int x = 0;
+    if (uvPixelStride == 1) {
+        for (; x < width - 15; x += 16) {
+            const __m256i yy = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(y + x)));
+            const __m128i u8 = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(u + x / 2));
+            const __m128i v8 = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(v + x / 2));
+            const __m256i uu = _mm256_cvtepu8_epi16(_mm_unpacklo_epi8(u8, u8));
+            const __m256i vv = _mm256_cvtepu8_epi16(_mm_unpacklo_epi8(v8, v8));
+            qYUVToARGB32_avx2(yy, uu, vv, alpha, rgb + x);
+        }
+    } else {
+        // Semi planar, U and V are interleaved in the same plane
+        const uchar *uv = qMin(u, v);
+        const bool uFirst = u < v;
+        for (; x < width - 15; x += 16) {
+            const __m256i yy = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(y + x)));
+            const __m256i chroma = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(uv + x)));
+            __m256i c0, c1;
+            qExpandInterleavedUV_avx2(chroma, &c0, &c1);
+            qYUVToARGB32_avx2(yy, uFirst ? c0 : c1, uFirst ? c1 : c0, alpha, rgb + x);
+        }
+    }
+
+    // leftovers
+    for (; x < width; x += 2) {
+        EXPAND_UV(u[x / 2 * uvPixelStride], v[x / 2 * uvPixelStride]);
+        rgb[x] = qYUVToARGB32(y[x], rv, guv, bu);
+        if (x + 1 < width)
+            rgb[x + 1] = qYUVToARGB32(y[x + 1], rv, guv, bu);
+    }
+}
+
+static inline void planarYUV420_to_ARGB32_avx2(const uchar *y, int yStride,
+                                               const uchar *u, int uStride,
+                                               const uchar *v, int vStride,
+                                               int uvPixelStride,
+                                               quint32 *rgb,
+                                               int width, int height)
+{
+    for (int j = 0; j < height; ++j) {
+        planarYUV420Row_to_ARGB32_avx2(y, u, v, uvPixelStride, rgb, width);
+        y += yStride;
+        if (j & 1) {
+            u += uStride;
+            v += vStride;
+        }
+        rgb += width;
+    }
+}
+
+static inline void packedYUV422_to_ARGB32_avx2(const QVideoFrame &frame, uchar *output, bool lumaFirst)
+{
+    FETCH_INFO_PACKED(frame)
+    MERGE_LOOPS(width, height, stride, 2)
+
+    quint32 *rgb = reinterpret_cast<quint32*>(output);
+
+    const __m256i lowMask = _mm256_set1_epi16(0xff);
+
+    for (int i = 0; i < height; ++i) {
+        const uchar *lineSrc = src;
+
+        int x = 0;
+        for (; x < width - 15; x += 16) {
+            const __m256i pixelData = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(lineSrc));
+            lineSrc += 32;
+            const __m256i low = _mm256_and_si256(pixelData, lowMask);
+            const __m256i high = _mm256_srli_epi16(pixelData, 8);
+            __m256i u, v;
+            qExpandInterleavedUV_avx2(lumaFirst ? high : low, &u, &v);
+            qYUVToARGB32_avx2(lumaFirst ? low : high, u, v, lowMask, rgb);
+            rgb += 16;
+        }
+
+        // leftovers
+        for (; x < width; x += 2) {
+            const int y0 = lumaFirst ? lineSrc[0] : lineSrc[1];
+            const int u = lumaFirst ? lineSrc[1] : lineSrc[0];
+            const int y1 = lumaFirst ? lineSrc[2] : lineSrc[3];
+            const int v = lumaFirst ? lineSrc[3] : lineSrc[2];
+            EXPAND_UV(u, v);
+            lineSrc += 4;
+
+            *rgb++ = qYUVToARGB32(y0, rv, guv, bu);
+            *rgb++ = qYUVToARGB32(y1, rv, guv, bu);
+        }
+
+        src += stride;
+    }
+}
+
+void QT_FASTCALL qt_convert_YUV420P_to_ARGB32_avx2(const QVideoFrame &frame, uchar *output)
+{
+    FETCH_INFO_TRIPLANAR(frame)
+    planarYUV420_to_ARGB32_avx2(plane1, plane1Stride,
+                                plane2, plane2Stride,
+                                plane3, plane3Stride,
+                                1,
+                                reinterpret_cast<quint32*>(output),
+                                width, height);
+}
+
+void QT_FASTCALL qt_convert_YV12_to_ARGB32_avx2(const QVideoFrame &frame, uchar *output)
+{
+    FETCH_INFO_TRIPLANAR(frame)
+    planarYUV420_to_ARGB32_avx2(plane1, plane1Stride,
+                                plane3, plane3Stride,
+                                plane2, plane2Stride,
+                                1,
+                                reinterpret_cast<quint32*>(output),
+                                width, height);
+}
+
+void QT_FASTCALL qt_convert_NV12_to_ARGB32_avx2(const QVideoFrame &frame, uchar *output)
+{
+    FETCH_INFO_BIPLANAR(frame)
+    planarYUV420_to_ARGB32_avx2(plane1, plane1Stride,
+                                plane2, plane2Stride,
+                                plane2 + 1, plane2Stride,
+                                2,
+                                reinterpret_cast<quint32*>(output),
+                                width, height);
+}
+
+void QT_FASTCALL qt_convert_NV21_to_ARGB32_avx2(const QVideoFrame &frame, uchar *output)
+{
+    FETCH_INFO_BIPLANAR(frame)
+    planarYUV420_to_ARGB32_avx2(plane1, plane1Stride,
+                                plane2 + 1, plane2Stride,
+                                plane2, plane2Stride,
+                                2,
+                                reinterpret_cast<quint32*>(output),
+                                width, height);
+}
+
+void QT_FASTCALL qt_convert_UYVY_to_ARGB32_avx2(const QVideoFrame &frame, uchar *output)
+{
+    packedYUV422_to_ARGB32_avx2(frame, output, false);
+}
+
+void QT_FASTCALL qt_convert_YUYV_to_ARGB32_avx2(const QVideoFrame &frame, uchar *output)
+{
+    packedYUV422_to_ARGB32_avx2(frame, output, true);
+}
+
 QT_END_NAMESPACE
 
 #endif
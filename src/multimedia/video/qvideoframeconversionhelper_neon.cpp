@@ -0,0 +1,294 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#include "qvideoframeconversionhelper_p.h"
+
+#ifdef QT_COMPILER_SUPPORTS_NEON
+
+#include <arm_neon.h>
+
+QT_BEGIN_NAMESPACE
+
+// Converts eight pixels with the same arithmetic as qYUVToARGB32()
+static inline void qYUVToARGB32_neon(uint8x8_t y, uint8x8_t u, uint8x8_t v, uint8x8_t a, quint32 *rgb)
+{
+    const int16x8_t yy = vreinterpretq_s16_u16(vsubl_u8(y, vdup_n_u8(16)));
+    const int16x8_t uu = vreinterpretq_s16_u16(vsubl_u8(u, vdup_n_u8(128)));
+    const int16x8_t vv = vreinterpretq_s16_u16(vsubl_u8(v, vdup_n_u8(128)));
+    const int32x4_t round = vdupq_n_s32(128);
+
+    const int32x4_t yLo = vmull_n_s16(vget_low_s16(yy), 298);
+    const int32x4_t yHi = vmull_n_s16(vget_high_s16(yy), 298);
+
+    // (yy + rv) >> 8 and (yy + bu) >> 8 are rounding shifts of yy + 409 * vv and yy + 516 * uu
+    const int16x8_t r = vcombine_s16(vrshrn_n_s32(vmlal_n_s16(yLo, vget_low_s16(vv), 409), 8),
+                                     vrshrn_n_s32(vmlal_n_s16(yHi, vget_high_s16(vv), 409), 8));
+    const int16x8_t g = vcombine_s16(vshrn_n_s32(vsubq_s32(vmlsl_n_s16(vmlsl_n_s16(yLo, vget_low_s16(uu), 100),
+                                                                       vget_low_s16(vv), 208), round), 8),
+                                     vshrn_n_s32(vsubq_s32(vmlsl_n_s16(vmlsl_n_s16(yHi, vget_high_s16(uu), 100),
+                                                                       vget_high_s16(vv), 208), round), 8));
+    const int16x8_t b = vcombine_s16(vrshrn_n_s32(vmlal_n_s16(yLo, vget_low_s16(uu), 516), 8),
+                                     vrshrn_n_s32(vmlal_n_s16(yHi, vget_high_s16(uu), 516), 8));
+
+    uint8x8x4_t pixels;
+    pixels.val[0] = vqmovun_s16(b);
+    pixels.val[1] = vqmovun_s16(g);
+    pixels.val[2] = vqmovun_s16(r);
+    pixels.val[3] = a;
+    vst4_u8(reinterpret_cast<uint8_t*>(rgb), pixels);
+}
+
+static inline void planarYUV420Row_to_ARGB32_neon(const uchar *y, const uchar *u, const uchar *v,
+                                                  int uvPixelStride, quint32 *rgb, int width)
+{
+    const uint8x8_t alpha = vdup_n_u8(0xff);
+
+    int x = 0;
+    if (uvPixelStride == 1) {
+        for (; x < width - 15; x += 16) {
+            const uint8x16_t yy = vld1q_u8(y + x);
+            const uint8x8_t uu = vld1_u8(u + x / 2);
+            const uint8x8_t vv = vld1_u8(v + x / 2);
+            const uint8x8x2_t u2 = vzip_u8(uu, uu);
+            const uint8x8x2_t v2 = vzip_u8(vv, vv);
+            qYUVToARGB32_neon(vget_low_u8(yy), u2.val[0], v2.val[0], alpha, rgb + x);
+            qYUVToARGB32_neon(vget_high_u8(yy), u2.val[1], v2.val[1], alpha, rgb + x + 8);
+        }
+    } else {
+        // Semi planar, U and V are interleaved in the same plane
+        const uchar *uv = qMin(u, v);
+        const int uIndex = u < v ? 0 : 1;
+        for (; x < width - 15; x += 16) {
+            const uint8x16_t yy = vld1q_u8(y + x);
+            const uint8x8x2_t chroma = vld2_u8(uv + x);
+            const uint8x8x2_t u2 = vzip_u8(chroma.val[uIndex], chroma.val[uIndex]);
+            const uint8x8x2_t v2 = vzip_u8(chroma.val[1 - uIndex], chroma.val[1 - uIndex]);
+            qYUVToARGB32_neon(vget_low_u8(yy), u2.val[0], v2.val[0], alpha, rgb + x);
+            qYUVToARGB32_neon(vget_high_u8(yy), u2.val[1], v2.val[1], alpha, rgb + x + 8);
+        }
+    }
+
+    // leftovers
+    for (; x < width; x += 2) {
+        EXPAND_UV(u[x / 2 * uvPixelStride], v[x / 2 * uvPixelStride]);
+        rgb[x] = qYUVToARGB32(y[x], rv, guv, bu);
+        if (x + 1 < width)
+            rgb[x + 1] = qYUVToARGB32(y[x + 1], rv, guv, bu);
+    }
+}
+
+static inline void planarYUV420_to_ARGB32_neon(const uchar *y, int yStride,
+                                               const uchar *u, int uStride,
+                                               const uchar *v, int vStride,
+                                               int uvPixelStride,
+                                               quint32 *rgb,
+                                               int width, int height)
+{
+    for (int j = 0; j < height; ++j) {
+        planarYUV420Row_to_ARGB32_neon(y, u, v, uvPixelStride, rgb, width);
+        y += yStride;
+        if (j & 1) {
+            u += uStride;
+            v += vStride;
+        }
+        rgb += width;
+    }
+}
+
+static inline void packedYUV422_to_ARGB32_neon(const QVideoFrame &frame, uchar *output, bool lumaFirst)
+{
+    FETCH_INFO_PACKED(frame)
+    MERGE_LOOPS(width, height, stride, 2)
+
+    quint32 *rgb = reinterpret_cast<quint32*>(output);
+
+    const uint8x8_t alpha = vdup_n_u8(0xff);
+    const int lumaIndex = lumaFirst ? 0 : 1;
+
+    for (int i = 0; i < height; ++i) {
+        const uchar *lineSrc = src;
+
+        int x = 0;
+        for (; x < width - 7; x += 8) {
+            const uint8x8x2_t pixelData = vld2_u8(lineSrc);
+            lineSrc += 16;
+            const uint8x8_t chroma = pixelData.val[1 - lumaIndex];
+            const uint8x8x2_t uv = vtrn_u8(chroma, chroma);
+            qYUVToARGB32_neon(pixelData.val[lumaIndex], uv.val[0], uv.val[1], alpha, rgb);
+            rgb += 8;
+        }
+
+        // leftovers
+        for (; x < width; x += 2) {
+            const int y0 = lumaFirst ? lineSrc[0] : lineSrc[1];
+            const int u = lumaFirst ? lineSrc[1] : lineSrc[0];
+            const int y1 = lumaFirst ? lineSrc[2] : lineSrc[3];
+            const int v = lumaFirst ? lineSrc[3] : lineSrc[2];
+            EXPAND_UV(u, v);
+            lineSrc += 4;
+
+            *rgb++ = qYUVToARGB32(y0, rv, guv, bu);
+            *rgb++ = qYUVToARGB32(y1, rv, guv, bu);
+        }
+
+        src += stride;
+    }
+}
+
+void QT_FASTCALL qt_convert_YUV420P_to_ARGB32_neon(const QVideoFrame &frame, uchar *output)
+{
+    FETCH_INFO_TRIPLANAR(frame)
+    planarYUV420_to_ARGB32_neon(plane1, plane1Stride,
+                                plane2, plane2Stride,
+                                plane3, plane3Stride,
+                                1,
+                                reinterpret_cast<quint32*>(output),
+                                width, height);
+}
+
+void QT_FASTCALL qt_convert_YV12_to_ARGB32_neon(const QVideoFrame &frame, uchar *output)
+{
+    FETCH_INFO_TRIPLANAR(frame)
+    planarYUV420_to_ARGB32_neon(plane1, plane1Stride,
+                                plane3, plane3Stride,
+                                plane2, plane2Stride,
+                                1,
+                                reinterpret_cast<quint32*>(output),
+                                width, height);
+}
+
+void QT_FASTCALL qt_convert_NV12_to_ARGB32_neon(const QVideoFrame &frame, uchar *output)
+{
+    FETCH_INFO_BIPLANAR(frame)
+    planarYUV420_to_ARGB32_neon(plane1, plane1Stride,
+                                plane2, plane2Stride,
+                                plane2 + 1, plane2Stride,
+                                2,
+                                reinterpret_cast<quint32*>(output),
+                                width, height);
+}
+
+void QT_FASTCALL qt_convert_NV21_to_ARGB32_neon(const QVideoFrame &frame, uchar *output)
+{
+    FETCH_INFO_BIPLANAR(frame)
+    planarYUV420_to_ARGB32_neon(plane1, plane1Stride,
+                                plane2 + 1, plane2Stride,
+                                plane2, plane2Stride,
+                                2,
+                                reinterpret_cast<quint32*>(output),
+                                width, height);
+}
+
+void QT_FASTCALL qt_convert_UYVY_to_ARGB32_neon(const QVideoFrame &frame, uchar *output)
+{
+    packedYUV422_to_ARGB32_neon(frame, output, false);
+}
+
+void QT_FASTCALL qt_convert_YUYV_to_ARGB32_neon(const QVideoFrame &frame, uchar *output)
+{
+    packedYUV422_to_ARGB32_neon(frame, output, true);
+}
+
+void QT_FASTCALL qt_convert_AYUV444_to_ARGB32_neon(const QVideoFrame &frame, uchar *output)
+{
+    FETCH_INFO_PACKED(frame)
+    MERGE_LOOPS(width, height, stride, 4)
+
+    quint32 *rgb = reinterpret_cast<quint32*>(output);
+
+    for (int i = 0; i < height; ++i) {
+        const uchar *lineSrc = src;
+
+        int x = 0;
+        for (; x < width - 7; x += 8) {
+            const uint8x8x4_t pixelData = vld4_u8(lineSrc);
+            lineSrc += 32;
+            qYUVToARGB32_neon(pixelData.val[1], pixelData.val[2], pixelData.val[3], pixelData.val[0], rgb);
+            rgb += 8;
+        }
+
+        // leftovers
+        for (; x < width; ++x) {
+            int a = *lineSrc++;
+            int y = *lineSrc++;
+            int u = *lineSrc++;
+            int v = *lineSrc++;
+
+            EXPAND_UV(u, v);
+
+            *rgb++ = qYUVToARGB32(y, rv, guv, bu, a);
+        }
+
+        src += stride;
+    }
+}
+
+void QT_FASTCALL qt_convert_YUV444_to_ARGB32_neon(const QVideoFrame &frame, uchar *output)
+{
+    FETCH_INFO_PACKED(frame)
+    MERGE_LOOPS(width, height, stride, 3)
+
+    quint32 *rgb = reinterpret_cast<quint32*>(output);
+
+    const uint8x8_t alpha = vdup_n_u8(0xff);
+
+    for (int i = 0; i < height; ++i) {
+        const uchar *lineSrc = src;
+
+        int x = 0;
+        for (; x < width - 7; x += 8) {
+            const uint8x8x3_t pixelData = vld3_u8(lineSrc);
+            lineSrc += 24;
+            qYUVToARGB32_neon(pixelData.val[0], pixelData.val[1], pixelData.val[2], alpha, rgb);
+            rgb += 8;
+        }
+
+        // leftovers
+        for (; x < width; ++x) {
+            int y = *lineSrc++;
+            int u = *lineSrc++;
+            int v = *lineSrc++;
+
+            EXPAND_UV(u, v);
+
+            *rgb++ = qYUVToARGB32(y, rv, guv, bu);
+        }
+
+        src += stride;
+    }
+}
+
+QT_END_NAMESPACE
+
+#endif
@@ -49,6 +49,27 @@
 #include <private/qsimd_p.h>
 
 typedef void (QT_FASTCALL *VideoFrameConvertFunc)(const QVideoFrame &frame, uchar *output);
+// Converts a row of fully sampled Y, U and V values, as gathered by the scaling converter.
+typedef void (QT_FASTCALL *VideoRowConvertFunc)(const uchar *y, const uchar *u, const uchar *v,
+                                                quint32 *rgb, int width);
+
+#define CLAMP(n) (n > 255 ? 255 : (n < 0 ? 0 : n))
+
+#define EXPAND_UV(u, v) \
+    int uu = u - 128; \
+    int vv = v - 128; \
+    int rv = 409 * vv + 128; \
+    int guv = 100 * uu + 208 * vv + 128; \
+    int bu = 516 * uu + 128; \
+
+inline quint32 qYUVToARGB32(int y, int rv, int guv, int bu, int a = 0xff)
+{
+    int yy = (y - 16) * 298;
+    return (a << 24)
+            | CLAMP((yy + rv) >> 8) << 16
+            | CLAMP((yy - guv) >> 8) << 8
+            | CLAMP((yy + bu) >> 8);
+}
 
 inline quint32 qConvertBGRA32ToARGB32(quint32 bgra)
 {
@@ -113,5 +134,64 @@ inline quint32 qConvertBGR555ToARGB32(quint16 bgr)
 #define ALIGN(boundary, ptr, x, length) \
     for (; ((reinterpret_cast<qintptr>(ptr) & (boundary - 1)) != 0) && x < length; ++x)
 
+#if defined(QT_COMPILER_SUPPORTS_SSE2) && defined(__SSE2__)
+
+// Converts eight pixels. y, u, v and a hold eight 16-bit values in the 0-255 range.
+// The arithmetic is the same as qYUVToARGB32(), so the results are bit exact.
+static inline void qYUVToARGB32_sse2(__m128i y, __m128i u, __m128i v, __m128i a, quint32 *rgb)
+{
+    const __m128i yOffset = _mm_set1_epi16(16);
+    const __m128i uvOffset = _mm_set1_epi16(128);
+    const __m128i one = _mm_set1_epi16(1);
+    const __m128i round = _mm_set1_epi32(128);
+    // Factors for _mm_madd_epi16(), each pair multiplies (y, v), (y, u) or (v, 1)
+    const __m128i rFactors = _mm_set_epi16(409, 298, 409, 298, 409, 298, 409, 298);
+    const __m128i gFactors = _mm_set_epi16(-100, 298, -100, 298, -100, 298, -100, 298);
+    const __m128i gvFactors = _mm_set_epi16(-128, -208, -128, -208, -128, -208, -128, -208);
+    const __m128i bFactors = _mm_set_epi16(516, 298, 516, 298, 516, 298, 516, 298);
+
+    y = _mm_sub_epi16(y, yOffset);
+    u = _mm_sub_epi16(u, uvOffset);
+    v = _mm_sub_epi16(v, uvOffset);
+
+    const __m128i yvLo = _mm_unpacklo_epi16(y, v);
+    const __m128i yvHi = _mm_unpackhi_epi16(y, v);
+    const __m128i yuLo = _mm_unpacklo_epi16(y, u);
+    const __m128i yuHi = _mm_unpackhi_epi16(y, u);
+    const __m128i v1Lo = _mm_unpacklo_epi16(v, one);
+    const __m128i v1Hi = _mm_unpackhi_epi16(v, one);
+
+    const __m128i r = _mm_packs_epi32(
+                _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(yvLo, rFactors), round), 8),
+                _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(yvHi, rFactors), round), 8));
+    const __m128i g = _mm_packs_epi32(
+                _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(yuLo, gFactors), _mm_madd_epi16(v1Lo, gvFactors)), 8),
+                _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(yuHi, gFactors), _mm_madd_epi16(v1Hi, gvFactors)), 8));
+    const __m128i b = _mm_packs_epi32(
+                _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(yuLo, bFactors), round), 8),
+                _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(yuHi, bFactors), round), 8));
+
+    // Saturate to 0-255 and interleave to B, G, R, A bytes (ARGB32 in memory)
+    const __m128i br = _mm_packus_epi16(b, r);
+    const __m128i ga = _mm_packus_epi16(g, a);
+    const __m128i bg = _mm_unpacklo_epi8(br, ga);
+    const __m128i ra = _mm_unpackhi_epi8(br, ga);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(rgb), _mm_unpacklo_epi16(bg, ra));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(rgb + 4), _mm_unpackhi_epi16(bg, ra));
+}
+
+// Splits eight interleaved 16-bit chroma values (c0, c1, c0, c1, ...) into
+// two vectors holding each value twice, one per pixel of a 4:2:x pair.
+static inline void qExpandInterleavedUV_sse2(__m128i uv, __m128i *c0, __m128i *c1)
+{
+    const __m128i lowMask = _mm_set1_epi32(0x0000ffff);
+    const __m128i first = _mm_and_si128(uv, lowMask);
+    const __m128i second = _mm_srli_epi32(uv, 16);
+    *c0 = _mm_or_si128(first, _mm_slli_epi32(first, 16));
+    *c1 = _mm_or_si128(second, _mm_slli_epi32(second, 16));
+}
+
+#endif
+
 #endif // QVIDEOFRAMECONVERSIONHELPER_P_H
 
@@ -35,6 +35,8 @@
 
 #ifdef QT_COMPILER_SUPPORTS_SSE2
 
+#include <string.h>
+
 QT_BEGIN_NAMESPACE
 
 void QT_FASTCALL qt_convert_BGRA32_to_ARGB32_sse2(const QVideoFrame &frame, uchar *output)
@@ -78,6 +80,230 @@ void QT_FASTCALL qt_convert_BGRA32_to_ARGB32_sse2(const QVideoFrame &frame, ucha
     }
 }
 
+static inline __m128i qLoadUnaligned32_sse2(const uchar *src)
+{
+    int value;
+    memcpy(&value, src, sizeof(value));
+    return _mm_cvtsi32_si128(value);
+}
+
+static inline void planarYUV420Row_to_ARGB32_sse2(const uchar *y, const uchar *u, const uchar *v,
+                                                  int uvPixelStride, quint32 *rgb, int width)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i alpha = _mm_set1_epi16(0xff);
+
+    int x = 0;
+    if (uvPixelStride == 1) {
+        for (; x < width - 7; x += 8) {
+            const __m128i yy = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(y + x)), zero);
+            __m128i uu = _mm_unpacklo_epi8(qLoadUnaligned32_sse2(u + x / 2), zero);
+            __m128i vv = _mm_unpacklo_epi8(qLoadUnaligned32_sse2(v + x / 2), zero);
+            uu = _mm_unpacklo_epi16(uu, uu);
+            vv = _mm_unpacklo_epi16(vv, vv);
+            qYUVToARGB32_sse2(yy, uu, vv, alpha, rgb + x);
+        }
+    } else {
+        // Semi planar, U and V are interleaved in the same plane
+        const uchar *uv = qMin(u, v);
+        const bool uFirst = u < v;
+        for (; x < width - 7; x += 8) {
+            const __m128i yy = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(y + x)), zero);
+            const __m128i chroma = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(uv + x)), zero);
+            __m128i c0, c1;
+            qExpandInterleavedUV_sse2(chroma, &c0, &c1);
+            qYUVToARGB32_sse2(yy, uFirst ? c0 : c1, uFirst ? c1 : c0, alpha, rgb + x);
+        }
+    }
+
+    // leftovers
+    for (; x < width; x += 2) {
+        EXPAND_UV(u[x / 2 * uvPixelStride], v[x / 2 * uvPixelStride]);
+        rgb[x] = qYUVToARGB32(y[x], rv, guv, bu);
+        if (x + 1 < width)
+            rgb[x + 1] = qYUVToARGB32(y[x + 1], rv, guv, bu);
+    }
+}
+
+static inline void planarYUV420_to_ARGB32_sse2(const uchar *y, int yStride,
+                                               const uchar *u, int uStride,
+                                               const uchar *v, int vStride,
+                                               int uvPixelStride,
+                                               quint32 *rgb,
+                                               int width, int height)
+{
+    for (int j = 0; j < height; ++j) {
+        planarYUV420Row_to_ARGB32_sse2(y, u, v, uvPixelStride, rgb, width);
+        y += yStride;
+        if (j & 1) {
+            u += uStride;
+            v += vStride;
+        }
+        rgb += width;
+    }
+}
+
+static inline void packedYUV422_to_ARGB32_sse2(const QVideoFrame &frame, uchar *output, bool lumaFirst)
+{
+    FETCH_INFO_PACKED(frame)
+    MERGE_LOOPS(width, height, stride, 2)
+
+    quint32 *rgb = reinterpret_cast<quint32*>(output);
+
+    const __m128i lowMask = _mm_set1_epi16(0xff);
+
+    for (int i = 0; i < height; ++i) {
+        const uchar *lineSrc = src;
+
+        int x = 0;
+        for (; x < width - 7; x += 8) {
+            const __m128i pixelData = _mm_loadu_si128(reinterpret_cast<const __m128i*>(lineSrc));
+            lineSrc += 16;
+            const __m128i low = _mm_and_si128(pixelData, lowMask);
+            const __m128i high = _mm_srli_epi16(pixelData, 8);
+            __m128i u, v;
+            qExpandInterleavedUV_sse2(lumaFirst ? high : low, &u, &v);
+            qYUVToARGB32_sse2(lumaFirst ? low : high, u, v, lowMask, rgb);
+            rgb += 8;
+        }
+
+        // leftovers
+        for (; x < width; x += 2) {
+            const int y0 = lumaFirst ? lineSrc[0] : lineSrc[1];
+            const int u = lumaFirst ? lineSrc[1] : lineSrc[0];
+            const int y1 = lumaFirst ? lineSrc[2] : lineSrc[3];
+            const int v = lumaFirst ? lineSrc[3] : lineSrc[2];
+            EXPAND_UV(u, v);
+            lineSrc += 4;
+
+            *rgb++ = qYUVToARGB32(y0, rv, guv, bu);
+            *rgb++ = qYUVToARGB32(y1, rv, guv, bu);
+        }
+
+        src += stride;
+    }
+}
+
+void QT_FASTCALL qt_convert_YUV420P_to_ARGB32_sse2(const QVideoFrame &frame, uchar *output)
+{
+    FETCH_INFO_TRIPLANAR(frame)
+    planarYUV420_to_ARGB32_sse2(plane1, plane1Stride,
+                                plane2, plane2Stride,
+                                plane3, plane3Stride,
+                                1,
+                                reinterpret_cast<quint32*>(output),
+                                width, height);
+}
+
+void QT_FASTCALL qt_convert_YV12_to_ARGB32_sse2(const QVideoFrame &frame, uchar *output)
+{
+    FETCH_INFO_TRIPLANAR(frame)
+    planarYUV420_to_ARGB32_sse2(plane1, plane1Stride,
+                                plane3, plane3Stride,
+                                plane2, plane2Stride,
+                                1,
+                                reinterpret_cast<quint32*>(output),
+                                width, height);
+}
+
+void QT_FASTCALL qt_convert_NV12_to_ARGB32_sse2(const QVideoFrame &frame, uchar *output)
+{
+    FETCH_INFO_BIPLANAR(frame)
+    planarYUV420_to_ARGB32_sse2(plane1, plane1Stride,
+                                plane2, plane2Stride,
+                                plane2 + 1, plane2Stride,
+                                2,
+                                reinterpret_cast<quint32*>(output),
+                                width, height);
+}
+
+void QT_FASTCALL qt_convert_NV21_to_ARGB32_sse2(const QVideoFrame &frame, uchar *output)
+{
+    FETCH_INFO_BIPLANAR(frame)
+    planarYUV420_to_ARGB32_sse2(plane1, plane1Stride,
+                                plane2 + 1, plane2Stride,
+                                plane2, plane2Stride,
+                                2,
+                                reinterpret_cast<quint32*>(output),
+                                width, height);
+}
+
+void QT_FASTCALL qt_convert_UYVY_to_ARGB32_sse2(const QVideoFrame &frame, uchar *output)
+{
+    packedYUV422_to_ARGB32_sse2(frame, output, false);
+}
+
+void QT_FASTCALL qt_convert_YUYV_to_ARGB32_sse2(const QVideoFrame &frame, uchar *output)
+{
+    packedYUV422_to_ARGB32_sse2(frame, output, true);
+}
+
+void QT_FASTCALL qt_convert_AYUV444_to_ARGB32_sse2(const QVideoFrame &frame, uchar *output)
+{
+    FETCH_INFO_PACKED(frame)
+    MERGE_LOOPS(width, height, stride, 4)
+
+    quint32 *rgb = reinterpret_cast<quint32*>(output);
+
+    const __m128i mask = _mm_set1_epi32(0xff);
+
+    for (int i = 0; i < height; ++i) {
+        const uchar *lineSrc = src;
+
+        int x = 0;
+        for (; x < width - 7; x += 8) {
+            const __m128i pixelData = _mm_loadu_si128(reinterpret_cast<const __m128i*>(lineSrc));
+            const __m128i pixelData2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(lineSrc + 16));
+            lineSrc += 32;
+            const __m128i a = _mm_packs_epi32(_mm_and_si128(pixelData, mask),
+                                              _mm_and_si128(pixelData2, mask));
+            const __m128i y = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(pixelData, 8), mask),
+                                              _mm_and_si128(_mm_srli_epi32(pixelData2, 8), mask));
+            const __m128i u = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(pixelData, 16), mask),
+                                              _mm_and_si128(_mm_srli_epi32(pixelData2, 16), mask));
+            const __m128i v = _mm_packs_epi32(_mm_srli_epi32(pixelData, 24),
+                                              _mm_srli_epi32(pixelData2, 24));
+            qYUVToARGB32_sse2(y, u, v, a, rgb);
+            rgb += 8;
+        }
+
+        // leftovers
+        for (; x < width; ++x) {
+            int a = *lineSrc++;
+            int y = *lineSrc++;
+            int u = *lineSrc++;
+            int v = *lineSrc++;
+
+            EXPAND_UV(u, v);
+
+            *rgb++ = qYUVToARGB32(y, rv, guv, bu, a);
+        }
+
+        src += stride;
+    }
+}
+
+void QT_FASTCALL qt_convert_YUVRow_to_ARGB32_sse2(const uchar *y, const uchar *u, const uchar *v,
+                                                  quint32 *rgb, int width)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i alpha = _mm_set1_epi16(0xff);
+
+    int x = 0;
+    for (; x < width - 7; x += 8) {
+        const __m128i yy = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(y + x)), zero);
+        const __m128i uu = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(u + x)), zero);
+        const __m128i vv = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(v + x)), zero);
+        qYUVToARGB32_sse2(yy, uu, vv, alpha, rgb + x);
+    }
+
+    // leftovers
+    for (; x < width; ++x) {
+        EXPAND_UV(u[x], v[x]);
+        rgb[x] = qYUVToARGB32(y[x], rv, guv, bu);
+    }
+}
+
 QT_END_NAMESPACE
 
 #endif
@@ -77,6 +77,53 @@ void QT_FASTCALL qt_convert_BGRA32_to_ARGB32_ssse3(const QVideoFrame &frame, uch
     }
 }
 
+void QT_FASTCALL qt_convert_YUV444_to_ARGB32_ssse3(const QVideoFrame &frame, uchar *output)
+{
+    FETCH_INFO_PACKED(frame)
+    MERGE_LOOPS(width, height, stride, 3)
+
+    quint32 *rgb = reinterpret_cast<quint32*>(output);
+
+    // Eight pixels span 24 bytes, the first five are taken from the load at
+    // offset 0 and the last three from the load at offset 8.
+    const __m128i yMask = _mm_setr_epi8(0, -1, 3, -1, 6, -1, 9, -1, 12, -1, -1, -1, -1, -1, -1, -1);
+    const __m128i yMask2 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 7, -1, 10, -1, 13, -1);
+    const __m128i uMask = _mm_setr_epi8(1, -1, 4, -1, 7, -1, 10, -1, 13, -1, -1, -1, -1, -1, -1, -1);
+    const __m128i uMask2 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 8, -1, 11, -1, 14, -1);
+    const __m128i vMask = _mm_setr_epi8(2, -1, 5, -1, 8, -1, 11, -1, 14, -1, -1, -1, -1, -1, -1, -1);
+    const __m128i vMask2 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 9, -1, 12, -1, 15, -1);
+    const __m128i alpha = _mm_set1_epi16(0xff);
+
+    for (int i = 0; i < height; ++i) {
+        const uchar *lineSrc = src;
+
+        int x = 0;
+        for (; x < width - 7; x += 8) {
+            const __m128i pixelData = _mm_loadu_si128(reinterpret_cast<const __m128i*>(lineSrc));
+            const __m128i pixelData2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(lineSrc + 8));
+            lineSrc += 24;
+            const __m128i y = _mm_or_si128(_mm_shuffle_epi8(pixelData, yMask), _mm_shuffle_epi8(pixelData2, yMask2));
+            const __m128i u = _mm_or_si128(_mm_shuffle_epi8(pixelData, uMask), _mm_shuffle_epi8(pixelData2, uMask2));
+            const __m128i v = _mm_or_si128(_mm_shuffle_epi8(pixelData, vMask), _mm_shuffle_epi8(pixelData2, vMask2));
+            qYUVToARGB32_sse2(y, u, v, alpha, rgb);
+            rgb += 8;
+        }
+
+        // leftovers
+        for (; x < width; ++x) {
+            int y = *lineSrc++;
+            int u = *lineSrc++;
+            int v = *lineSrc++;
+
+            EXPAND_UV(u, v);
+
+            *rgb++ = qYUVToARGB32(y, rv, guv, bu);
+        }
+
+        src += stride;
+    }
+}
+
 QT_END_NAMESPACE
 
 #endif
@@ -16,7 +16,8 @@ PRIVATE_HEADERS += \
     video/qvideooutputorientationhandler_p.h \
     video/qvideosurfaceoutput_p.h \
     video/qvideoframe_p.h \
-    video/qvideoframeconversionhelper_p.h
+    video/qvideoframeconversionhelper_p.h \
+    video/qvideobufferpool_p.h
 
 SOURCES += \
     video/qabstractvideobuffer.cpp \
@@ -29,8 +30,10 @@ SOURCES += \
     video/qvideosurfaceoutput.cpp \
     video/qvideoprobe.cpp \
     video/qabstractvideofilter.cpp \
-    video/qvideoframeconversionhelper.cpp
+    video/qvideoframeconversionhelper.cpp \
+    video/qvideobufferpool.cpp
 
 SSE2_SOURCES += video/qvideoframeconversionhelper_sse2.cpp
 SSSE3_SOURCES += video/qvideoframeconversionhelper_ssse3.cpp
 AVX2_SOURCES += video/qvideoframeconversionhelper_avx2.cpp
+NEON_SOURCES += video/qvideoframeconversionhelper_neon.cpp
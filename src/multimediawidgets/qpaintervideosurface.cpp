@@ -39,6 +39,7 @@
 #include <qvariant.h>
 #include <qvideosurfaceformat.h>
 #include <private/qmediaopenglhelper_p.h>
+#include <private/qvideoframe_p.h>
 
 #if !defined(QT_NO_OPENGL) && !defined(QT_OPENGL_ES_1_CL) && !defined(QT_OPENGL_ES_1)
 #include <qglshaderprogram.h>
@@ -81,23 +82,39 @@ public:
     void updateColors(int brightness, int contrast, int hue, int saturation);
 
 private:
+    void paintYuv(const QRectF &target, QPainter *painter, const QRectF &source);
+
     QList<QVideoFrame::PixelFormat> m_imagePixelFormats;
+    QList<QVideoFrame::PixelFormat> m_yuvPixelFormats;
     QVideoFrame m_frame;
     QSize m_imageSize;
     QImage::Format m_imageFormat;
+    QImage m_convertedImage;
     QVideoSurfaceFormat::Direction m_scanLineDirection;
     bool m_mirrored;
+    bool m_yuv;
 };
 
 QVideoSurfaceGenericPainter::QVideoSurfaceGenericPainter()
     : m_imageFormat(QImage::Format_Invalid)
     , m_scanLineDirection(QVideoSurfaceFormat::TopToBottom)
     , m_mirrored(false)
+    , m_yuv(false)
 {
+    // YUV frames are converted to RGB32 at the size they are painted at, see paintYuv().
+    m_yuvPixelFormats << QVideoFrame::Format_YUV420P
+                      << QVideoFrame::Format_YV12
+                      << QVideoFrame::Format_NV12
+                      << QVideoFrame::Format_NV21
+                      << QVideoFrame::Format_UYVY
+                      << QVideoFrame::Format_YUYV
+                      << QVideoFrame::Format_YUV444;
+
     m_imagePixelFormats << QVideoFrame::Format_RGB32
                         << QVideoFrame::Format_ARGB32
                         << QVideoFrame::Format_RGB24
-                        << QVideoFrame::Format_RGB565;
+                        << QVideoFrame::Format_RGB565
+                        << m_yuvPixelFormats;
 }
 
 QList<QVideoFrame::PixelFormat> QVideoSurfaceGenericPainter::supportedPixelFormats(
@@ -134,10 +151,12 @@ QAbstractVideoSurface::Error QVideoSurfaceGenericPainter::start(const QVideoSurf
     m_imageSize = format.frameSize();
     m_scanLineDirection = format.scanLineDirection();
     m_mirrored = format.property("mirrored").toBool();
+    m_yuv = m_yuvPixelFormats.contains(format.pixelFormat());
+    m_convertedImage = QImage();
 
     const QAbstractVideoBuffer::HandleType t = format.handleType();
     if (t == QAbstractVideoBuffer::NoHandle) {
-        bool ok = m_imageFormat != QImage::Format_Invalid && !m_imageSize.isEmpty() && format.pixelFormat() != QVideoFrame::Format_RGB24;
+        bool ok = (m_imageFormat != QImage::Format_Invalid || m_yuv) && !m_imageSize.isEmpty() && format.pixelFormat() != QVideoFrame::Format_RGB24;
         if (ok)
             return QAbstractVideoSurface::NoError;
     } else if (t == QAbstractVideoBuffer::QPixmapHandle) {
@@ -149,6 +168,7 @@ QAbstractVideoSurface::Error QVideoSurfaceGenericPainter::start(const QVideoSurf
 void QVideoSurfaceGenericPainter::stop()
 {
     m_frame = QVideoFrame();
+    m_convertedImage = QImage();
 }
 
 QAbstractVideoSurface::Error QVideoSurfaceGenericPainter::setCurrentFrame(const QVideoFrame &frame)
@@ -168,6 +188,10 @@ QAbstractVideoSurface::Error QVideoSurfaceGenericPainter::paint(
 
     if (m_frame.handleType() == QAbstractVideoBuffer::QPixmapHandle) {
         painter->drawPixmap(target, m_frame.handle().value<QPixmap>(), source);
+    } else if (m_yuv && m_frame.map(QAbstractVideoBuffer::ReadOnly)) {
+        paintYuv(target, painter, source);
+
+        m_frame.unmap();
     } else if (m_frame.map(QAbstractVideoBuffer::ReadOnly)) {
         QImage image(
                 m_frame.bits(),
@@ -202,6 +226,38 @@ QAbstractVideoSurface::Error QVideoSurfaceGenericPainter::paint(
     return QAbstractVideoSurface::NoError;
 }
 
+/*
+    Converts the source rectangle of a mapped YUV frame straight to the size
+    it covers on the paint device, so the raster engine only has to blit the
+    result. Under rotations and shears the frame is converted at its own size
+    and drawn with the painter's transform instead.
+*/
+void QVideoSurfaceGenericPainter::paintYuv(
+        const QRectF &target, QPainter *painter, const QRectF &source)
+{
+    const QTransform transform = painter->transform();
+    const QSize size = transform.type() <= QTransform::TxScale
+            ? transform.mapRect(target).toAlignedRect().size()
+            : source.toAlignedRect().size();
+
+    if (size.isEmpty())
+        return;
+
+    if (m_convertedImage.size() != size)
+        m_convertedImage = QImage(size, QImage::Format_RGB32);
+
+    Qt::Orientations mirrored = 0;
+    if (m_mirrored)
+        mirrored |= Qt::Horizontal;
+    if (m_scanLineDirection == QVideoSurfaceFormat::BottomToTop)
+        mirrored |= Qt::Vertical;
+
+    if (qt_convertVideoFrameScaled(m_frame, source.toAlignedRect(), &m_convertedImage, mirrored))
+        painter->drawImage(target, m_convertedImage);
+    else
+        painter->fillRect(target, Qt::black);
+}
+
 void QVideoSurfaceGenericPainter::updateColors(int, int, int, int)
 {
 }
@@ -254,6 +310,8 @@ protected:
     void initRgbTextureInfo(GLenum internalFormat, GLuint format, GLenum type, const QSize &size);
     void initYuv420PTextureInfo(const QSize &size);
     void initYv12TextureInfo(const QSize &size);
+    void initNv12TextureInfo(const QSize &size);
+    void initYuv422TextureInfo(const QSize &size);
 
     bool needsSwizzling(const QVideoSurfaceFormat &format) const {
         return !QMediaOpenGLHelper::isANGLE()
@@ -276,12 +334,12 @@ protected:
     QVideoSurfaceFormat::Direction m_scanLineDirection;
     bool m_mirrored;
     QVideoSurfaceFormat::YCbCrColorSpace m_colorSpace;
-    GLenum m_textureFormat;
-    GLuint m_textureInternalFormat;
     GLenum m_textureType;
     int m_textureCount;
 
     static const uint Max_Textures = 3;
+    GLenum m_textureFormats[Max_Textures];
+    GLuint m_textureInternalFormats[Max_Textures];
     GLuint m_textureIds[Max_Textures];
     int m_textureWidths[Max_Textures];
     int m_textureHeights[Max_Textures];
@@ -295,8 +353,6 @@ QVideoSurfaceGLPainter::QVideoSurfaceGLPainter(QGLContext *context)
     , m_scanLineDirection(QVideoSurfaceFormat::TopToBottom)
     , m_mirrored(false)
     , m_colorSpace(QVideoSurfaceFormat::YCbCr_BT601)
-    , m_textureFormat(0)
-    , m_textureInternalFormat(0)
     , m_textureType(0)
     , m_textureCount(0)
     , m_yuv(false)
@@ -305,6 +361,8 @@ QVideoSurfaceGLPainter::QVideoSurfaceGLPainter(QGLContext *context)
     glActiveTexture = (_glActiveTexture)m_context->getProcAddress(QLatin1String("glActiveTexture"));
 #endif
 
+    memset(m_textureFormats, 0, sizeof(m_textureFormats));
+    memset(m_textureInternalFormats, 0, sizeof(m_textureInternalFormats));
     memset(m_textureIds, 0, sizeof(m_textureIds));
     memset(m_textureWidths, 0, sizeof(m_textureWidths));
     memset(m_textureHeights, 0, sizeof(m_textureHeights));
@@ -380,11 +438,11 @@ QAbstractVideoSurface::Error QVideoSurfaceGLPainter::setCurrentFrame(const QVide
             glTexImage2D(
                     GL_TEXTURE_2D,
                     0,
-                    m_textureInternalFormat,
+                    m_textureInternalFormats[i],
                     m_textureWidths[i],
                     m_textureHeights[i],
                     0,
-                    m_textureFormat,
+                    m_textureFormats[i],
                     m_textureType,
                     m_frame.bits() + m_textureOffsets[i]);
             glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
@@ -505,8 +563,8 @@ void QVideoSurfaceGLPainter::initRgbTextureInfo(
         GLenum internalFormat, GLuint format, GLenum type, const QSize &size)
 {
     m_yuv = false;
-    m_textureInternalFormat = internalFormat;
-    m_textureFormat = format;
+    m_textureInternalFormats[0] = internalFormat;
+    m_textureFormats[0] = format;
     m_textureType = type;
     m_textureCount = 1; // Note: ensure this is always <= Max_Textures
     m_textureWidths[0] = size.width();
@@ -520,10 +578,12 @@ void QVideoSurfaceGLPainter::initYuv420PTextureInfo(const QSize &size)
     int bytesPerLine2 = (size.width() / 2 + 3) & ~3;
 
     m_yuv = true;
-    m_textureInternalFormat = GL_LUMINANCE;
-    m_textureFormat = GL_LUMINANCE;
     m_textureType = GL_UNSIGNED_BYTE;
     m_textureCount = 3; // Note: ensure this is always <= Max_Textures
+    for (int i = 0; i < m_textureCount; ++i) {
+        m_textureInternalFormats[i] = GL_LUMINANCE;
+        m_textureFormats[i] = GL_LUMINANCE;
+    }
     m_textureWidths[0] = bytesPerLine;
     m_textureHeights[0] = size.height();
     m_textureOffsets[0] = 0;
@@ -541,10 +601,12 @@ void QVideoSurfaceGLPainter::initYv12TextureInfo(const QSize &size)
     int bytesPerLine2 = (size.width() / 2 + 3) & ~3;
 
     m_yuv = true;
-    m_textureInternalFormat = GL_LUMINANCE;
-    m_textureFormat = GL_LUMINANCE;
     m_textureType = GL_UNSIGNED_BYTE;
     m_textureCount = 3; // Note: ensure this is always <= Max_Textures
+    for (int i = 0; i < m_textureCount; ++i) {
+        m_textureInternalFormats[i] = GL_LUMINANCE;
+        m_textureFormats[i] = GL_LUMINANCE;
+    }
     m_textureWidths[0] = bytesPerLine;
     m_textureHeights[0] = size.height();
     m_textureOffsets[0] = 0;
@@ -556,6 +618,49 @@ void QVideoSurfaceGLPainter::initYv12TextureInfo(const QSize &size)
     m_textureOffsets[2] = bytesPerLine * size.height();
 }
 
+void QVideoSurfaceGLPainter::initNv12TextureInfo(const QSize &size)
+{
+    int bytesPerLine = (size.width() + 3) & ~3;
+
+    // The interleaved chroma plane is uploaded as two byte luminance-alpha
+    // texels, so each texel holds the U and V samples of a 2x2 block.
+    m_yuv = true;
+    m_textureType = GL_UNSIGNED_BYTE;
+    m_textureCount = 2; // Note: ensure this is always <= Max_Textures
+    m_textureInternalFormats[0] = GL_LUMINANCE;
+    m_textureFormats[0] = GL_LUMINANCE;
+    m_textureWidths[0] = bytesPerLine;
+    m_textureHeights[0] = size.height();
+    m_textureOffsets[0] = 0;
+    m_textureInternalFormats[1] = GL_LUMINANCE_ALPHA;
+    m_textureFormats[1] = GL_LUMINANCE_ALPHA;
+    m_textureWidths[1] = bytesPerLine / 2;
+    m_textureHeights[1] = size.height() / 2;
+    m_textureOffsets[1] = bytesPerLine * size.height();
+}
+
+void QVideoSurfaceGLPainter::initYuv422TextureInfo(const QSize &size)
+{
+    int bytesPerLine = (size.width() * 2 + 3) & ~3;
+
+    // The same packed data is uploaded twice: as luminance-alpha texels, one
+    // per pixel, to sample luma at full resolution, and as RGBA texels, one
+    // per pixel pair, to sample the shared chroma.
+    m_yuv = true;
+    m_textureType = GL_UNSIGNED_BYTE;
+    m_textureCount = 2; // Note: ensure this is always <= Max_Textures
+    m_textureInternalFormats[0] = GL_LUMINANCE_ALPHA;
+    m_textureFormats[0] = GL_LUMINANCE_ALPHA;
+    m_textureWidths[0] = bytesPerLine / 2;
+    m_textureHeights[0] = size.height();
+    m_textureOffsets[0] = 0;
+    m_textureInternalFormats[1] = GL_RGBA;
+    m_textureFormats[1] = GL_RGBA;
+    m_textureWidths[1] = bytesPerLine / 4;
+    m_textureHeights[1] = size.height();
+    m_textureOffsets[1] = 0;
+}
+
 #if !defined(QT_OPENGL_ES) && !defined(QT_OPENGL_DYNAMIC)
 
 # ifndef GL_FRAGMENT_PROGRAM_ARB
@@ -1022,6 +1127,66 @@ static const char *qt_glsl_yuvPlanarShaderProgram =
         "    gl_FragColor = colorMatrix * color;\n"
         "}\n";
 
+// Paints a NV12 frame.
+static const char *qt_glsl_nv12ShaderProgram =
+        "uniform sampler2D texY;\n"
+        "uniform sampler2D texC;\n"
+        "uniform mediump mat4 colorMatrix;\n"
+        "varying highp vec2 textureCoord;\n"
+        "void main(void)\n"
+        "{\n"
+        "    highp vec4 color = vec4(\n"
+        "           texture2D(texY, textureCoord.st).r,\n"
+        "           texture2D(texC, textureCoord.st).ra,\n"
+        "           1.0);\n"
+        "    gl_FragColor = colorMatrix * color;\n"
+        "}\n";
+
+// Paints a NV21 frame.
+static const char *qt_glsl_nv21ShaderProgram =
+        "uniform sampler2D texY;\n"
+        "uniform sampler2D texC;\n"
+        "uniform mediump mat4 colorMatrix;\n"
+        "varying highp vec2 textureCoord;\n"
+        "void main(void)\n"
+        "{\n"
+        "    highp vec4 color = vec4(\n"
+        "           texture2D(texY, textureCoord.st).r,\n"
+        "           texture2D(texC, textureCoord.st).ar,\n"
+        "           1.0);\n"
+        "    gl_FragColor = colorMatrix * color;\n"
+        "}\n";
+
+// Paints a UYVY frame.
+static const char *qt_glsl_uyvyShaderProgram =
+        "uniform sampler2D texY;\n"
+        "uniform sampler2D texC;\n"
+        "uniform mediump mat4 colorMatrix;\n"
+        "varying highp vec2 textureCoord;\n"
+        "void main(void)\n"
+        "{\n"
+        "    highp vec4 color = vec4(\n"
+        "           texture2D(texY, textureCoord.st).a,\n"
+        "           texture2D(texC, textureCoord.st).rb,\n"
+        "           1.0);\n"
+        "    gl_FragColor = colorMatrix * color;\n"
+        "}\n";
+
+// Paints a YUYV frame.
+static const char *qt_glsl_yuyvShaderProgram =
+        "uniform sampler2D texY;\n"
+        "uniform sampler2D texC;\n"
+        "uniform mediump mat4 colorMatrix;\n"
+        "varying highp vec2 textureCoord;\n"
+        "void main(void)\n"
+        "{\n"
+        "    highp vec4 color = vec4(\n"
+        "           texture2D(texY, textureCoord.st).r,\n"
+        "           texture2D(texC, textureCoord.st).ga,\n"
+        "           1.0);\n"
+        "    gl_FragColor = colorMatrix * color;\n"
+        "}\n";
+
 // Paints a YUV444 frame.
 static const char *qt_glsl_xyuvShaderProgram =
         "uniform sampler2D texRgb;\n"
@@ -1076,7 +1241,11 @@ QVideoSurfaceGlslPainter::QVideoSurfaceGlslPainter(QGLContext *context)
             << QVideoFrame::Format_YUV444
             << QVideoFrame::Format_AYUV444
             << QVideoFrame::Format_YV12
-            << QVideoFrame::Format_YUV420P;
+            << QVideoFrame::Format_YUV420P
+            << QVideoFrame::Format_NV12
+            << QVideoFrame::Format_NV21
+            << QVideoFrame::Format_UYVY
+            << QVideoFrame::Format_YUYV;
     m_glPixelFormats
             << QVideoFrame::Format_RGB32
             << QVideoFrame::Format_ARGB32
@@ -1138,6 +1307,22 @@ QAbstractVideoSurface::Error QVideoSurfaceGlslPainter::start(const QVideoSurface
             initYuv420PTextureInfo(format.frameSize());
             fragmentProgram = qt_glsl_yuvPlanarShaderProgram;
             break;
+        case QVideoFrame::Format_NV12:
+            initNv12TextureInfo(format.frameSize());
+            fragmentProgram = qt_glsl_nv12ShaderProgram;
+            break;
+        case QVideoFrame::Format_NV21:
+            initNv12TextureInfo(format.frameSize());
+            fragmentProgram = qt_glsl_nv21ShaderProgram;
+            break;
+        case QVideoFrame::Format_UYVY:
+            initYuv422TextureInfo(format.frameSize());
+            fragmentProgram = qt_glsl_uyvyShaderProgram;
+            break;
+        case QVideoFrame::Format_YUYV:
+            initYuv422TextureInfo(format.frameSize());
+            fragmentProgram = qt_glsl_yuyvShaderProgram;
+            break;
         default:
             break;
         }
@@ -1307,6 +1492,15 @@ QAbstractVideoSurface::Error QVideoSurfaceGlslPainter::paint(
             m_program.setUniformValue("texY", 0);
             m_program.setUniformValue("texU", 1);
             m_program.setUniformValue("texV", 2);
+        } else if (m_textureCount == 2) {
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_2D, m_textureIds[0]);
+            glActiveTexture(GL_TEXTURE1);
+            glBindTexture(GL_TEXTURE_2D, m_textureIds[1]);
+            glActiveTexture(GL_TEXTURE0);
+
+            m_program.setUniformValue("texY", 0);
+            m_program.setUniformValue("texC", 1);
         } else {
             glActiveTexture(GL_TEXTURE0);
             glBindTexture(GL_TEXTURE_2D, m_textureIds[0]);
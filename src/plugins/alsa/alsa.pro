@@ -7,13 +7,15 @@ HEADERS += \
     qalsaplugin.h \
     qalsaaudiodeviceinfo.h \
     qalsaaudioinput.h \
-    qalsaaudiooutput.h
+    qalsaaudiooutput.h \
+    qalsaaudiofeeder.h
 
 SOURCES += \
     qalsaplugin.cpp \
     qalsaaudiodeviceinfo.cpp \
     qalsaaudioinput.cpp \
-    qalsaaudiooutput.cpp
+    qalsaaudiooutput.cpp \
+    qalsaaudiofeeder.cpp
 
 OTHER_FILES += \
     alsa.json
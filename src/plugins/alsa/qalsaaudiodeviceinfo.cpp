@@ -46,6 +46,8 @@
 
 #include <alsa/version.h>
 
+#include <QtCore/qmutex.h>
+
 QT_BEGIN_NAMESPACE
 
 QAlsaAudioDeviceInfo::QAlsaAudioDeviceInfo(QByteArray dev, QAudio::Mode mode)
@@ -374,44 +376,99 @@ QByteArray QAlsaAudioDeviceInfo::defaultOutputDevice()
     return devices.first();
 }
 
+// The surround layouts are found with a full snd_device_name_hint() scan,
+// which every output device info would otherwise repeat. While the plugin
+// watches for hotplug events the result is shared until the next event.
+struct QAlsaSurroundHints
+{
+    QAlsaSurroundHints()
+        : cached(false)
+        , valid(false)
+        , surround40(false)
+        , surround51(false)
+        , surround71(false)
+    {
+    }
+
+    QMutex mutex;
+    bool cached;
+    bool valid;
+    bool surround40;
+    bool surround51;
+    bool surround71;
+};
+
+Q_GLOBAL_STATIC(QAlsaSurroundHints, surroundHints)
+
+void QAlsaAudioDeviceInfo::setSurroundHintsCached(bool cached)
+{
+    QAlsaSurroundHints *hints = surroundHints();
+    QMutexLocker locker(&hints->mutex);
+    hints->cached = cached;
+    hints->valid = false;
+}
+
+void QAlsaAudioDeviceInfo::invalidateSurroundHints()
+{
+    QAlsaSurroundHints *hints = surroundHints();
+    QMutexLocker locker(&hints->mutex);
+    hints->valid = false;
+}
+
 void QAlsaAudioDeviceInfo::checkSurround()
 {
     surround40 = false;
     surround51 = false;
     surround71 = false;
 
-    void **hints, **n;
-    char *name, *descr, *io;
-
-    if(snd_device_name_hint(-1, "pcm", &hints) < 0)
+    // Only output devices use the surround layouts
+    if (mode != QAudio::AudioOutput)
         return;
 
-    n = hints;
+    QAlsaSurroundHints *cache = surroundHints();
+    QMutexLocker locker(&cache->mutex);
 
-    while (*n != NULL) {
-        name = snd_device_name_get_hint(*n, "NAME");
-        descr = snd_device_name_get_hint(*n, "DESC");
-        io = snd_device_name_get_hint(*n, "IOID");
-        if((name != NULL) && (descr != NULL)) {
-            QString deviceName = QLatin1String(name);
-            if (mode == QAudio::AudioOutput) {
+    if (!cache->cached || !cache->valid) {
+        cache->surround40 = false;
+        cache->surround51 = false;
+        cache->surround71 = false;
+        cache->valid = true;
+
+        void **hints, **n;
+        char *name, *descr, *io;
+
+        if(snd_device_name_hint(-1, "pcm", &hints) < 0)
+            return;
+
+        n = hints;
+
+        while (*n != NULL) {
+            name = snd_device_name_get_hint(*n, "NAME");
+            descr = snd_device_name_get_hint(*n, "DESC");
+            io = snd_device_name_get_hint(*n, "IOID");
+            if((name != NULL) && (descr != NULL)) {
+                QString deviceName = QLatin1String(name);
                 if(deviceName.contains(QLatin1String("surround40")))
-                    surround40 = true;
+                    cache->surround40 = true;
                 if(deviceName.contains(QLatin1String("surround51")))
-                    surround51 = true;
+                    cache->surround51 = true;
                 if(deviceName.contains(QLatin1String("surround71")))
-                    surround71 = true;
+                    cache->surround71 = true;
             }
+            if(name != NULL)
+                free(name);
+            if(descr != NULL)
+                free(descr);
+            if(io != NULL)
+                free(io);
+            ++n;
         }
-        if(name != NULL)
-            free(name);
-        if(descr != NULL)
-            free(descr);
-        if(io != NULL)
-            free(io);
-        ++n;
+        snd_device_name_free_hint(hints);
     }
-    snd_device_name_free_hint(hints);
+
+    surround40 = cache->surround40;
+    surround51 = cache->surround51;
+    surround71 = cache->surround71;
 }
 
 QString QAlsaAudioDeviceInfo::deviceFromCardName(const QString &card)
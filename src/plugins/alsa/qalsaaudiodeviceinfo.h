@@ -86,6 +86,8 @@ public:
     static QByteArray defaultOutputDevice();
     static QList<QByteArray> availableDevices(QAudio::Mode);
     static QString deviceFromCardName(const QString &card);
+    static void setSurroundHintsCached(bool cached);
+    static void invalidateSurroundHints();
 
 private:
     bool open();
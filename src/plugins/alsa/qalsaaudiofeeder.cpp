@@ -0,0 +1,276 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists for the convenience
+// of other Qt classes.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// INTERNAL USE ONLY: Do NOT use for any other purpose.
+//
+
+#include <QtCore/qdebug.h>
+#include <QtCore/qelapsedtimer.h>
+#include <QtMultimedia/private/qaudiohelpers_p.h>
+#include "qalsaaudiofeeder.h"
+
+#include <pthread.h>
+#include <sched.h>
+
+QT_BEGIN_NAMESPACE
+
+//#define DEBUG_AUDIO 1
+
+QAlsaAudioFeeder::QAlsaAudioFeeder(snd_pcm_t *handle, const QAudioFormat &format,
+                                   snd_pcm_uframes_t periodFrames, unsigned int periodTime,
+                                   int bufferSize, QObject *parent)
+    : QThread(parent)
+    , m_handle(handle)
+    , m_format(format)
+    , m_capture(snd_pcm_stream(handle) == SND_PCM_STREAM_CAPTURE)
+    , m_frameBytes(snd_pcm_frames_to_bytes(handle, 1))
+    , m_periodFrames(periodFrames)
+    , m_periodTime(periodTime)
+    , m_volume(0x10000)
+    , m_framesWritten(0)
+{
+    // Keep whole frames in the ring buffer so regions never split a frame.
+    m_buffer.reset(qMax(1, bufferSize / m_frameBytes) * m_frameBytes);
+    m_scratch.resize(snd_pcm_frames_to_bytes(handle, periodFrames));
+}
+
+QAlsaAudioFeeder::~QAlsaAudioFeeder()
+{
+    stop();
+}
+
+bool QAlsaAudioFeeder::isEnabled()
+{
+    // QT_ALSA_FEEDER_THREAD=1 moves pcm reads and writes off the owner's event loop.
+    static const bool enabled = qgetenv("QT_ALSA_FEEDER_THREAD").toInt() > 0;
+    return enabled;
+}
+
+void QAlsaAudioFeeder::setVolume(qreal volume)
+{
+    m_volume.store(qBound(0, qRound(volume * 0x10000), 0x10000));
+}
+
+QAlsaAudioFeeder::Statistics QAlsaAudioFeeder::statistics() const
+{
+    Statistics statistics;
+    statistics.xruns = m_xruns.load();
+    statistics.starvedPeriods = m_starvedPeriods.load();
+    statistics.overflowedPeriods = m_overflowedPeriods.load();
+    statistics.wakeups = m_wakeups.load();
+    statistics.lastJitter = m_lastJitter.load();
+    statistics.maximumJitter = m_maximumJitter.load();
+    return statistics;
+}
+
+// Lets a running playback feeder write out what is left in the ring buffer,
+// giving up after a little more than the time it takes to play all of it.
+void QAlsaAudioFeeder::drain()
+{
+    if (m_capture || !isRunning())
+        return;
+
+    const qint64 bufferTime = qint64(m_buffer.capacity() / m_frameBytes) * m_periodTime / m_periodFrames;
+    QElapsedTimer timer;
+    timer.start();
+    while (m_buffer.bytesAvailable() >= m_frameBytes && isRunning()
+           && timer.nsecsElapsed() / 1000 < bufferTime + 2 * m_periodTime) {
+        QThread::usleep(qMax(1000u, m_periodTime / 2));
+    }
+}
+
+void QAlsaAudioFeeder::stop()
+{
+    if (!isRunning())
+        return;
+
+    m_quit.store(1);
+    wait();
+    m_quit.store(0);
+
+#ifdef DEBUG_AUDIO
+    const Statistics s = statistics();
+    qDebug() << "QAlsaAudioFeeder: xruns" << s.xruns << "starved" << s.starvedPeriods
+             << "overflowed" << s.overflowedPeriods << "wakeups" << s.wakeups
+             << "max jitter" << s.maximumJitter << "us";
+#endif
+}
+
+void QAlsaAudioFeeder::run()
+{
+    // QThread::TimeCriticalPriority has no effect under SCHED_OTHER, ask for a
+    // real-time policy and carry on with what we have if that is not permitted.
+    struct sched_param param;
+    param.sched_priority = qMin(sched_get_priority_min(SCHED_FIFO) + 10,
+                                sched_get_priority_max(SCHED_FIFO));
+    pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+
+    const int timeout = qMax(1, int(m_periodTime * 2 / 1000));
+
+    QElapsedTimer clock;
+    clock.start();
+    qint64 lastWakeup = -1;
+
+    while (!m_quit.load()) {
+        const int err = snd_pcm_wait(m_handle, timeout);
+
+        const qint64 now = clock.nsecsElapsed() / 1000;
+        if (lastWakeup >= 0) {
+            const int jitter = int(qAbs(now - lastWakeup - qint64(m_periodTime)));
+            m_lastJitter.store(jitter);
+            if (jitter > m_maximumJitter.load())
+                m_maximumJitter.store(jitter);
+        }
+        lastWakeup = now;
+        m_wakeups.ref();
+
+        if (err < 0) {
+            recover(err);
+            continue;
+        } else if (err == 0) {
+            continue;
+        }
+
+        const snd_pcm_sframes_t frames = snd_pcm_avail_update(m_handle);
+        if (frames < 0) {
+            recover(frames);
+            continue;
+        }
+
+        if (m_capture)
+            capture(frames);
+        else
+            playback(frames);
+    }
+}
+
+void QAlsaAudioFeeder::recover(int err)
+{
+    if (err == -EPIPE) {
+        m_xruns.ref();
+        emit xrun();
+    }
+
+    if (snd_pcm_recover(m_handle, err, 1) >= 0 && m_capture)
+        snd_pcm_start(m_handle);
+}
+
+void QAlsaAudioFeeder::playback(snd_pcm_sframes_t frames)
+{
+    while (frames > 0) {
+        int length = 0;
+        const char *data = m_buffer.readRegion(&length);
+
+        snd_pcm_sframes_t chunk = qMin<snd_pcm_sframes_t>(frames, length / m_frameBytes);
+        if (chunk <= 0) {
+            m_starvedPeriods.ref();
+            return;
+        }
+
+        if (m_volume.load() < 0x10000) {
+            chunk = qMin<snd_pcm_sframes_t>(chunk, m_periodFrames);
+            applyVolume(data, m_scratch.data(), chunk * m_frameBytes);
+            data = m_scratch.constData();
+        }
+
+        const snd_pcm_sframes_t written = snd_pcm_writei(m_handle, data, chunk);
+        if (written < 0) {
+            recover(written);
+            return;
+        }
+
+        m_buffer.releaseRead(written * m_frameBytes);
+        m_framesWritten.fetchAndAddRelaxed(written);
+        frames -= written;
+
+        if (written < chunk)
+            return;
+    }
+}
+
+void QAlsaAudioFeeder::capture(snd_pcm_sframes_t frames)
+{
+    while (frames > 0) {
+        int length = 0;
+        char *data = m_buffer.writeRegion(&length);
+
+        snd_pcm_sframes_t chunk = qMin<snd_pcm_sframes_t>(frames, length / m_frameBytes);
+        if (chunk <= 0) {
+            // Nobody is reading, drop the period so the pcm does not overrun as well.
+            m_overflowedPeriods.ref();
+            data = m_scratch.data();
+            chunk = qMin<snd_pcm_sframes_t>(frames, m_periodFrames);
+
+            const snd_pcm_sframes_t dropped = snd_pcm_readi(m_handle, data, chunk);
+            if (dropped <= 0) {
+                if (dropped < 0)
+                    recover(dropped);
+                return;
+            }
+            frames -= dropped;
+            continue;
+        }
+
+        const snd_pcm_sframes_t read = snd_pcm_readi(m_handle, data, chunk);
+        if (read < 0) {
+            recover(read);
+            return;
+        }
+
+        if (m_volume.load() < 0x10000)
+            applyVolume(data, data, read * m_frameBytes);
+
+        m_buffer.commitWrite(read * m_frameBytes);
+        frames -= read;
+
+        if (read < chunk)
+            return;
+    }
+}
+
+void QAlsaAudioFeeder::applyVolume(const char *src, char *dest, int length)
+{
+    QAudioHelperInternal::qMultiplySamples(m_volume.load() / qreal(0x10000), m_format, src, dest, length);
+}
+
+QT_END_NAMESPACE
+
+#include "moc_qalsaaudiofeeder.cpp"
@@ -0,0 +1,134 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists for the convenience
+// of other Qt classes.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#ifndef QALSAAUDIOFEEDER_H
+#define QALSAAUDIOFEEDER_H
+
+#include <alsa/asoundlib.h>
+
+#include <QtCore/qatomic.h>
+#include <QtCore/qbytearray.h>
+#include <QtCore/qthread.h>
+
+#include <QtMultimedia/qaudioformat.h>
+#include <QtMultimedia/private/qaudioringbuffer_p.h>
+
+QT_BEGIN_NAMESPACE
+
+// Moves audio between an ALSA pcm and a lock-free ring buffer on a dedicated,
+// high priority thread which sleeps in snd_pcm_wait() between periods. The
+// owner only ever touches the ring buffer while the feeder is running.
+class QAlsaAudioFeeder : public QThread
+{
+    Q_OBJECT
+public:
+    struct Statistics
+    {
+        Statistics()
+            : xruns(0), starvedPeriods(0), overflowedPeriods(0), wakeups(0)
+            , lastJitter(0), maximumJitter(0) {}
+
+        int xruns;              // underruns (playback) or overruns (capture) of the pcm
+        int starvedPeriods;     // playback wakeups that found the ring buffer empty
+        int overflowedPeriods;  // capture wakeups that found the ring buffer full
+        int wakeups;
+        int lastJitter;         // deviation of the wakeup interval from the period, usecs
+        int maximumJitter;
+    };
+
+    QAlsaAudioFeeder(snd_pcm_t *handle, const QAudioFormat &format,
+                     snd_pcm_uframes_t periodFrames, unsigned int periodTime,
+                     int bufferSize, QObject *parent = 0);
+    ~QAlsaAudioFeeder();
+
+    static bool isEnabled();
+
+    QAudioRingBuffer *buffer() { return &m_buffer; }
+
+    void setVolume(qreal volume);
+    Statistics statistics() const;
+
+    // Frames handed to snd_pcm_writei() so far, playback only.
+    qint64 framesWritten() const { return m_framesWritten.load(); }
+
+    void drain();
+    void stop();
+
+signals:
+    void xrun();
+
+protected:
+    void run();
+
+private:
+    void recover(int err);
+    void playback(snd_pcm_sframes_t frames);
+    void capture(snd_pcm_sframes_t frames);
+    void applyVolume(const char *src, char *dest, int length);
+
+    snd_pcm_t *m_handle;
+    QAudioFormat m_format;
+    bool m_capture;
+    int m_frameBytes;
+    snd_pcm_uframes_t m_periodFrames;
+    unsigned int m_periodTime;
+    QAudioRingBuffer m_buffer;
+    QByteArray m_scratch;
+
+    QAtomicInt m_quit;
+    QAtomicInt m_volume;    // 1/65536 units
+
+    QAtomicInteger<qint64> m_framesWritten;
+
+    QAtomicInt m_xruns;
+    QAtomicInt m_starvedPeriods;
+    QAtomicInt m_overflowedPeriods;
+    QAtomicInt m_wakeups;
+    QAtomicInt m_lastJitter;
+    QAtomicInt m_maximumJitter;
+};
+
+QT_END_NAMESPACE
+
+#endif
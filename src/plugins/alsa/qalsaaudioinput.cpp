@@ -46,6 +46,7 @@
 #include <QtMultimedia/private/qaudiohelpers_p.h>
 #include "qalsaaudioinput.h"
 #include "qalsaaudiodeviceinfo.h"
+#include "qalsaaudiofeeder.h"
 
 QT_BEGIN_NAMESPACE
 
@@ -70,6 +71,7 @@ QAlsaAudioInput::QAlsaAudioInput(const QByteArray &device)
     resuming = false;
 
     m_volume = 1.0f;
+    m_feeder = 0;
 
     m_device = device;
 
@@ -88,6 +90,8 @@ QAlsaAudioInput::~QAlsaAudioInput()
 void QAlsaAudioInput::setVolume(qreal vol)
 {
     m_volume = vol;
+    if (m_feeder)
+        m_feeder->setVolume(vol);
 }
 
 qreal QAlsaAudioInput::volume() const
@@ -433,6 +437,13 @@ bool QAlsaAudioInput::open()
     snd_pcm_prepare( handle );
     snd_pcm_start(handle);
 
+    if (QAlsaAudioFeeder::isEnabled()) {
+        m_feeder = new QAlsaAudioFeeder(handle, settings, period_frames, period_time, 4 * buffer_size, this);
+        m_feeder->setVolume(m_volume);
+        connect(m_feeder, SIGNAL(xrun()), SLOT(feederXrun()));
+        m_feeder->start(QThread::TimeCriticalPriority);
+    }
+
     // Step 5: Setup timer
     bytesAvailable = checkBytesReady();
 
@@ -454,6 +465,12 @@ void QAlsaAudioInput::close()
 {
     timer->stop();
 
+    if (m_feeder) {
+        m_feeder->stop();
+        delete m_feeder;
+        m_feeder = 0;
+    }
+
     if ( handle ) {
         snd_pcm_drop( handle );
         snd_pcm_close( handle );
@@ -468,6 +485,8 @@ int QAlsaAudioInput::checkBytesReady()
     else if(deviceState != QAudio::ActiveState
             && deviceState != QAudio::IdleState)
         bytesAvailable = 0;
+    else if (m_feeder)
+        bytesAvailable = m_feeder->buffer()->bytesAvailable();
     else {
         int frames = snd_pcm_avail_update(handle);
         if (frames < 0) {
@@ -495,7 +514,9 @@ qint64 QAlsaAudioInput::read(char* data, qint64 len)
     int bytesRead = 0;
     int bytesInRingbufferBeforeRead = ringBuffer.bytesOfDataInBuffer();
 
-    if (ringBuffer.bytesOfDataInBuffer() < len) {
+    if (m_feeder) {
+        bytesRead = readFromFeeder(qMin<qint64>(len - bytesInRingbufferBeforeRead, ringBuffer.freeBytes()));
+    } else if (ringBuffer.bytesOfDataInBuffer() < len) {
 
         // bytesAvaiable is saved as a side effect of checkBytesReady().
         int bytesToRead = checkBytesReady();
@@ -647,6 +668,8 @@ void QAlsaAudioInput::resume()
         }
         resuming = true;
         deviceState = QAudio::ActiveState;
+        if (m_feeder)
+            m_feeder->start(QThread::TimeCriticalPriority);
         int chunks = buffer_size/period_size;
         timer->start(period_time*chunks/2000);
         emit stateChanged(deviceState);
@@ -690,6 +713,8 @@ qint64 QAlsaAudioInput::processedUSecs() const
 void QAlsaAudioInput::suspend()
 {
     if(deviceState == QAudio::ActiveState||resuming) {
+        if (m_feeder)
+            m_feeder->stop();
         snd_pcm_drain(handle);
         timer->stop();
         deviceState = QAudio::SuspendedState;
@@ -745,6 +770,35 @@ bool QAlsaAudioInput::deviceReady()
     return true;
 }
 
+int QAlsaAudioInput::readFromFeeder(int maxBytes)
+{
+    // The feeder thread has already read the pcm and applied the volume.
+    QAudioRingBuffer *buffer = m_feeder->buffer();
+
+    int bytesRead = 0;
+    while (bytesRead < maxBytes) {
+        int length = 0;
+        char *data = buffer->readRegion(&length);
+        length = qMin(length, maxBytes - bytesRead);
+        if (length <= 0)
+            break;
+
+        ringBuffer.write(data, length);
+        buffer->releaseRead(length);
+        bytesRead += length;
+    }
+    return bytesRead;
+}
+
+void QAlsaAudioInput::feederXrun()
+{
+    if (deviceState != QAudio::ActiveState && deviceState != QAudio::IdleState)
+        return;
+
+    errorState = QAudio::UnderrunError;
+    emit errorChanged(errorState);
+}
+
 qint64 QAlsaAudioInput::elapsedUSecs() const
 {
     if (deviceState == QAudio::StoppedState)
@@ -64,6 +64,7 @@ QT_BEGIN_NAMESPACE
 
 
 class AlsaInputPrivate;
+class QAlsaAudioFeeder;
 
 class RingBuffer
 {
@@ -117,6 +118,7 @@ public:
     QAudioFormat format() const;
     void setVolume(qreal);
     qreal volume() const;
+    QAlsaAudioFeeder *feeder() const { return m_feeder; }
     bool resuming;
     snd_pcm_t* handle;
     qint64 totalTimeValue;
@@ -128,9 +130,11 @@ public:
 private slots:
     void userFeed();
     bool deviceReady();
+    void feederXrun();
 
 private:
     int checkBytesReady();
+    int readFromFeeder(int maxBytes);
     int xrun_recovery(int err);
     int setFormat();
     bool open();
@@ -156,6 +160,7 @@ private:
     snd_pcm_format_t pcmformat;
     snd_pcm_hw_params_t *hwparams;
     qreal m_volume;
+    QAlsaAudioFeeder *m_feeder;
 };
 
 class AlsaInputPrivate : public QIODevice
@@ -46,6 +46,7 @@
 #include <QtMultimedia/private/qaudiohelpers_p.h>
 #include "qalsaaudiooutput.h"
 #include "qalsaaudiodeviceinfo.h"
+#include "qalsaaudiofeeder.h"
 
 QT_BEGIN_NAMESPACE
 
@@ -74,6 +75,7 @@ QAlsaAudioOutput::QAlsaAudioOutput(const QByteArray &device)
     opened = false;
 
     m_volume = 1.0f;
+    m_feeder = 0;
 
     m_device = device;
 
@@ -92,6 +94,8 @@ QAlsaAudioOutput::~QAlsaAudioOutput()
 void QAlsaAudioOutput::setVolume(qreal vol)
 {
     m_volume = vol;
+    if (m_feeder)
+        m_feeder->setVolume(vol);
 }
 
 qreal QAlsaAudioOutput::volume() const
@@ -480,7 +484,14 @@ bool QAlsaAudioOutput::open()
     snd_pcm_prepare( handle );
     snd_pcm_start(handle);
 
-    // Step 5: Setup timer
+    // Step 5: Setup timer, or the feeder thread which takes over the pcm and
+    // leaves the timer to fill its ring buffer.
+    if (QAlsaAudioFeeder::isEnabled()) {
+        m_feeder = new QAlsaAudioFeeder(handle, settings, period_frames, period_time, 4 * buffer_size, this);
+        m_feeder->setVolume(m_volume);
+        connect(m_feeder, SIGNAL(xrun()), SLOT(feederXrun()));
+        m_feeder->start(QThread::TimeCriticalPriority);
+    }
     bytesAvailable = bytesFree();
 
     // Step 6: Start audio processing
@@ -500,6 +511,15 @@ void QAlsaAudioOutput::close()
 {
     timer->stop();
 
+    if (m_feeder) {
+        // Play what is still queued in the ring buffer before draining the pcm
+        m_feeder->drain();
+        m_feeder->stop();
+        totalTimeValue = m_feeder->framesWritten();
+        delete m_feeder;
+        m_feeder = 0;
+    }
+
     if ( handle ) {
         snd_pcm_drain( handle );
         snd_pcm_close( handle );
@@ -522,6 +542,9 @@ int QAlsaAudioOutput::bytesFree() const
     if(deviceState != QAudio::ActiveState && deviceState != QAudio::IdleState)
         return 0;
 
+    if (m_feeder)
+        return m_feeder->buffer()->bytesFree();
+
     int frames = snd_pcm_avail_update(handle);
     if (frames == -EPIPE) {
         // Try and handle buffer underrun
@@ -560,7 +583,11 @@ qint64 QAlsaAudioOutput::write( const char *data, qint64 len )
 
     frames = snd_pcm_bytes_to_frames(handle, space);
 
-    if (m_volume < 1.0f) {
+    if (m_feeder) {
+        // The feeder thread applies the volume when it hands the data to the pcm.
+        err = snd_pcm_bytes_to_frames(handle,
+                m_feeder->buffer()->write(data, snd_pcm_frames_to_bytes(handle, frames)));
+    } else if (m_volume < 1.0f) {
         char out[space];
         QAudioHelperInternal::qMultiplySamples(m_volume, settings, data, out, space);
         err = snd_pcm_writei(handle, out, frames);
@@ -569,7 +596,9 @@ qint64 QAlsaAudioOutput::write( const char *data, qint64 len )
     }
 
     if(err > 0) {
-        totalTimeValue += err;
+        // With a feeder the frames are only counted once they reach the pcm
+        if (!m_feeder)
+            totalTimeValue += err;
         resuming = false;
         errorState = QAudio::NoError;
         if (deviceState != QAudio::ActiveState) {
@@ -618,7 +647,8 @@ int QAlsaAudioOutput::notifyInterval() const
 
 qint64 QAlsaAudioOutput::processedUSecs() const
 {
-    return qint64(1000000) * totalTimeValue / settings.sampleRate();
+    const qint64 frames = m_feeder ? m_feeder->framesWritten() : totalTimeValue;
+    return qint64(1000000) * frames / settings.sampleRate();
 }
 
 void QAlsaAudioOutput::resume()
@@ -642,6 +672,8 @@ void QAlsaAudioOutput::resume()
         deviceState = pullMode ? QAudio::ActiveState : QAudio::IdleState;
 
         errorState = QAudio::NoError;
+        if (m_feeder)
+            m_feeder->start(QThread::TimeCriticalPriority);
         timer->start(period_time/1000);
         emit stateChanged(deviceState);
     }
@@ -661,6 +693,8 @@ QAudioFormat QAlsaAudioOutput::format() const
 void QAlsaAudioOutput::suspend()
 {
     if(deviceState == QAudio::ActiveState || deviceState == QAudio::IdleState || resuming) {
+        if (m_feeder)
+            m_feeder->stop();
         snd_pcm_drain(handle);
         timer->stop();
         deviceState = QAudio::SuspendedState;
@@ -717,7 +751,7 @@ bool QAlsaAudioOutput::deviceReady()
         } else if(l == 0) {
             // Did not get any data to output
             bytesAvailable = bytesFree();
-            if(bytesAvailable > snd_pcm_frames_to_bytes(handle, buffer_frames-period_frames)) {
+            if(bytesAvailable > underrunThreshold()) {
                 // Underrun
                 if (deviceState != QAudio::IdleState) {
                     errorState = QAudio::UnderrunError;
@@ -736,7 +770,7 @@ bool QAlsaAudioOutput::deviceReady()
         }
     } else {
         bytesAvailable = bytesFree();
-        if(bytesAvailable > snd_pcm_frames_to_bytes(handle, buffer_frames-period_frames)) {
+        if(bytesAvailable > underrunThreshold()) {
             // Underrun
             if (deviceState != QAudio::IdleState) {
                 errorState = QAudio::UnderrunError;
@@ -758,6 +792,23 @@ bool QAlsaAudioOutput::deviceReady()
     return true;
 }
 
+int QAlsaAudioOutput::underrunThreshold() const
+{
+    if (m_feeder)
+        return m_feeder->buffer()->capacity() - period_size;
+
+    return snd_pcm_frames_to_bytes(handle, buffer_frames-period_frames);
+}
+
+void QAlsaAudioOutput::feederXrun()
+{
+    if (deviceState != QAudio::ActiveState && deviceState != QAudio::IdleState)
+        return;
+
+    errorState = QAudio::UnderrunError;
+    emit errorChanged(errorState);
+}
+
 qint64 QAlsaAudioOutput::elapsedUSecs() const
 {
     if (deviceState == QAudio::StoppedState)
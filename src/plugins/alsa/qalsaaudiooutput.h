@@ -61,6 +61,8 @@
 
 QT_BEGIN_NAMESPACE
 
+class QAlsaAudioFeeder;
+
 class QAlsaAudioOutput : public QAbstractAudioOutput
 {
     friend class AlsaOutputPrivate;
@@ -92,6 +94,7 @@ public:
     void setVolume(qreal);
     qreal volume() const;
 
+    QAlsaAudioFeeder *feeder() const { return m_feeder; }
 
     QIODevice* audioSource;
     QAudioFormat settings;
@@ -101,6 +104,7 @@ public:
 private slots:
     void userFeed();
     bool deviceReady();
+    void feederXrun();
 
 signals:
     void processMore();
@@ -118,6 +122,7 @@ private:
     snd_pcm_uframes_t buffer_frames;
     snd_pcm_uframes_t period_frames;
     int xrun_recovery(int err);
+    int underrunThreshold() const;
 
     int setFormat();
     bool open();
@@ -135,6 +140,7 @@ private:
     snd_pcm_format_t pcmformat;
     snd_pcm_hw_params_t *hwparams;
     qreal m_volume;
+    QAlsaAudioFeeder *m_feeder;
 };
 
 class AlsaOutputPrivate : public QIODevice
@@ -36,11 +36,36 @@
 #include "qalsaaudioinput.h"
 #include "qalsaaudiooutput.h"
 
+#include <QtCore/qfilesystemwatcher.h>
+
 QT_BEGIN_NAMESPACE
 
 QAlsaPlugin::QAlsaPlugin(QObject *parent)
     : QAudioSystemPlugin(parent)
+    , m_deviceWatcher(0)
+{
+    // Sound cards come and go together with their nodes in /dev/snd, watching
+    // the directory catches the same hotplug events udev reports.
+    m_deviceWatcher = new QFileSystemWatcher(this);
+    if (m_deviceWatcher->addPath(QStringLiteral("/dev/snd"))) {
+        connect(m_deviceWatcher, SIGNAL(directoryChanged(QString)), this, SLOT(devicesChanged()));
+        QAlsaAudioDeviceInfo::setSurroundHintsCached(true);
+    } else {
+        delete m_deviceWatcher;
+        m_deviceWatcher = 0;
+    }
+}
+
+QAlsaPlugin::~QAlsaPlugin()
+{
+    if (m_deviceWatcher)
+        QAlsaAudioDeviceInfo::setSurroundHintsCached(false);
+}
+
+void QAlsaPlugin::devicesChanged()
 {
+    QAlsaAudioDeviceInfo::invalidateSurroundHints();
+    emit availableDevicesChanged();
 }
 
 QList<QByteArray> QAlsaPlugin::availableDevices(QAudio::Mode mode) const
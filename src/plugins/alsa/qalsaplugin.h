@@ -38,6 +38,8 @@
 
 QT_BEGIN_NAMESPACE
 
+class QFileSystemWatcher;
+
 class QAlsaPlugin : public QAudioSystemPlugin
 {
     Q_OBJECT
@@ -46,12 +48,21 @@ class QAlsaPlugin : public QAudioSystemPlugin
 
 public:
     QAlsaPlugin(QObject *parent = 0);
-    ~QAlsaPlugin() {}
+    ~QAlsaPlugin();
 
     QList<QByteArray> availableDevices(QAudio::Mode mode) const Q_DECL_OVERRIDE;
     QAbstractAudioInput *createInput(const QByteArray &device) Q_DECL_OVERRIDE;
     QAbstractAudioOutput *createOutput(const QByteArray &device) Q_DECL_OVERRIDE;
     QAbstractAudioDeviceInfo *createDeviceInfo(const QByteArray &device, QAudio::Mode mode) Q_DECL_OVERRIDE;
+
+Q_SIGNALS:
+    void availableDevicesChanged();
+
+private Q_SLOTS:
+    void devicesChanged();
+
+private:
+    QFileSystemWatcher *m_deviceWatcher;
 };
 
 QT_END_NAMESPACE
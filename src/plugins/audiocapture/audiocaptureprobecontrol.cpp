@@ -49,7 +49,9 @@ void AudioCaptureProbeControl::bufferProbed(const char *data, quint32 size, cons
     if (!format.isValid())
         return;
 
-    QAudioBuffer audioBuffer = QAudioBuffer(QByteArray::fromRawData(data, size), format);
+    // The data belongs to the writer's ring buffer, which is reused as soon
+    // as this returns.
+    QAudioBuffer audioBuffer = QAudioBuffer(QByteArray(data, size), format);
     QMetaObject::invokeMethod(this, "audioBufferProbed", Qt::QueuedConnection, Q_ARG(QAudioBuffer, audioBuffer));
 }
 
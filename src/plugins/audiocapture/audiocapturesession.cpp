@@ -43,44 +43,6 @@
 
 QT_BEGIN_NAMESPACE
 
-void FileProbeProxy::startProbes(const QAudioFormat &format)
-{
-    m_format = format;
-}
-
-void FileProbeProxy::stopProbes()
-{
-    m_format = QAudioFormat();
-}
-
-void FileProbeProxy::addProbe(AudioCaptureProbeControl *probe)
-{
-    QMutexLocker locker(&m_probeMutex);
-
-    if (m_probes.contains(probe))
-        return;
-
-    m_probes.append(probe);
-}
-
-void FileProbeProxy::removeProbe(AudioCaptureProbeControl *probe)
-{
-    QMutexLocker locker(&m_probeMutex);
-    m_probes.removeOne(probe);
-}
-
-qint64 FileProbeProxy::writeData(const char *data, qint64 len)
-{
-    if (m_format.isValid()) {
-        QMutexLocker locker(&m_probeMutex);
-
-        foreach (AudioCaptureProbeControl* probe, m_probes)
-            probe->bufferProbed(data, len, m_format);
-    }
-
-    return QFile::writeData(data, len);
-}
-
 AudioCaptureSession::AudioCaptureSession(QObject *parent)
     : QObject(parent)
     , m_state(QMediaRecorder::StoppedState)
@@ -92,6 +54,8 @@ AudioCaptureSession::AudioCaptureSession(QObject *parent)
     , m_muted(false)
 {
     m_format = m_deviceInfo.preferredFormat();
+
+    connect(&m_writer, SIGNAL(writeError(QString)), this, SLOT(writeError(QString)));
 }
 
 AudioCaptureSession::~AudioCaptureSession()
@@ -290,34 +254,13 @@ void AudioCaptureSession::record()
         if (m_actualOutputLocation != m_requestedOutputLocation)
             emit actualLocationChanged(m_actualOutputLocation);
 
-        file.setFileName(filePath);
-
         setStatus(QMediaRecorder::LoadedStatus);
         setStatus(QMediaRecorder::StartingStatus);
 
-        if (file.open(QIODevice::WriteOnly)) {
-            if (m_wavFile) {
-                memset(&header,0,sizeof(CombinedHeader));
-                memcpy(header.riff.descriptor.id,"RIFF",4);
-                header.riff.descriptor.size = 0xFFFFFFFF; // This should be updated on stop(), filesize-8
-                memcpy(header.riff.type,"WAVE",4);
-                memcpy(header.wave.descriptor.id,"fmt ",4);
-                header.wave.descriptor.size = 16;
-                header.wave.audioFormat = 1; // for PCM data
-                header.wave.numChannels = m_format.channelCount();
-                header.wave.sampleRate = m_format.sampleRate();
-                header.wave.byteRate = m_format.sampleRate()*m_format.channelCount()*m_format.sampleSize()/8;
-                header.wave.blockAlign = m_format.channelCount()*m_format.sampleSize()/8;
-                header.wave.bitsPerSample = m_format.sampleSize();
-                memcpy(header.data.descriptor.id,"data",4);
-                header.data.descriptor.size = 0xFFFFFFFF; // This should be updated on stop(),samples*channels*sampleSize/8
-                file.write((char*)&header,sizeof(CombinedHeader));
-            }
-
+        if (m_writer.start(filePath, m_format, m_wavFile)) {
             setVolumeHelper(m_muted ? 0 : m_volume);
 
-            file.startProbes(m_format);
-            m_audioInput->start(qobject_cast<QIODevice*>(&file));
+            m_audioInput->start(&m_writer);
         } else {
             delete m_audioInput;
             m_audioInput = 0;
@@ -339,19 +282,8 @@ void AudioCaptureSession::stop()
 {
     if(m_audioInput) {
         m_audioInput->stop();
-        file.stopProbes();
-        file.close();
-        if (m_wavFile) {
-            qint32 fileSize = file.size();
-            file.open(QIODevice::ReadWrite | QIODevice::Unbuffered);
-            file.read((char*)&header,sizeof(CombinedHeader));
-            header.riff.descriptor.size = fileSize - 8; // The RIFF chunk size is the file size minus
-                                                        // the first two RIFF fields (8 bytes)
-            header.data.descriptor.size = fileSize - 44; // dataSize = fileSize - headerSize (44 bytes)
-            file.seek(0);
-            file.write((char*)&header,sizeof(CombinedHeader));
-            file.close();
-        }
+        // Drains the ring buffer and finalizes the WAV header
+        m_writer.stop();
         delete m_audioInput;
         m_audioInput = 0;
         setStatus(QMediaRecorder::UnloadedStatus);
@@ -360,12 +292,12 @@ void AudioCaptureSession::stop()
 
 void AudioCaptureSession::addProbe(AudioCaptureProbeControl *probe)
 {
-    file.addProbe(probe);
+    m_writer.addProbe(probe);
 }
 
 void AudioCaptureSession::removeProbe(AudioCaptureProbeControl *probe)
 {
-    file.removeProbe(probe);
+    m_writer.removeProbe(probe);
 }
 
 void AudioCaptureSession::audioInputStateChanged(QAudio::State state)
@@ -390,6 +322,11 @@ void AudioCaptureSession::notify()
     emit positionChanged(position());
 }
 
+void AudioCaptureSession::writeError(const QString &errorString)
+{
+    emit error(QMediaRecorder::ResourceError, errorString);
+}
+
 void AudioCaptureSession::setCaptureDevice(const QString &deviceName)
 {
     m_captureDevice = deviceName;
@@ -442,6 +379,11 @@ void AudioCaptureSession::setMuted(bool muted)
     emit mutedChanged(m_muted);
 }
 
+qint64 AudioCaptureSession::droppedFrames() const
+{
+    return m_writer.droppedFrames();
+}
+
 void AudioCaptureSession::setVolumeHelper(qreal volume)
 {
     if (!m_audioInput)
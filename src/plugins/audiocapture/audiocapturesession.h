@@ -34,14 +34,13 @@
 #ifndef AUDIOCAPTURESESSION_H
 #define AUDIOCAPTURESESSION_H
 
-#include <QFile>
 #include <QUrl>
 #include <QDir>
-#include <QMutex>
 
 #include "audioencodercontrol.h"
 #include "audioinputselector.h"
 #include "audiomediarecordercontrol.h"
+#include "audiocapturewriter.h"
 
 #include <qaudioformat.h>
 #include <qaudioinput.h>
@@ -51,23 +50,6 @@ QT_BEGIN_NAMESPACE
 
 class AudioCaptureProbeControl;
 
-class FileProbeProxy: public QFile {
-public:
-    void startProbes(const QAudioFormat& format);
-    void stopProbes();
-    void addProbe(AudioCaptureProbeControl *probe);
-    void removeProbe(AudioCaptureProbeControl *probe);
-
-protected:
-    virtual qint64 writeData(const char *data, qint64 len);
-
-private:
-    QAudioFormat m_format;
-    QList<AudioCaptureProbeControl*> m_probes;
-    QMutex m_probeMutex;
-};
-
-
 class AudioCaptureSession : public QObject
 {
     Q_OBJECT
@@ -102,6 +84,8 @@ public:
     void setMuted(bool muted);
     bool isMuted() const;
 
+    qint64 droppedFrames() const;
+
 signals:
     void stateChanged(QMediaRecorder::State state);
     void statusChanged(QMediaRecorder::Status status);
@@ -114,6 +98,7 @@ signals:
 private slots:
     void audioInputStateChanged(QAudio::State state);
     void notify();
+    void writeError(const QString &errorString);
 
 private:
     void record();
@@ -129,7 +114,7 @@ private:
                              const QString &extension) const;
     QString generateFileName(const QDir &dir, const QString &extension) const;
 
-    FileProbeProxy file;
+    AudioCaptureWriter m_writer;
     QString m_captureDevice;
     QUrl m_requestedOutputLocation;
     QUrl m_actualOutputLocation;
@@ -141,46 +126,6 @@ private:
     bool m_wavFile;
     qreal m_volume;
     bool m_muted;
-
-    // WAV header stuff
-
-    struct chunk
-    {
-        char        id[4];
-        quint32     size;
-    };
-
-    struct RIFFHeader
-    {
-        chunk       descriptor;
-        char        type[4];
-    };
-
-    struct WAVEHeader
-    {
-        chunk       descriptor;
-        quint16     audioFormat;        // PCM = 1
-        quint16     numChannels;
-        quint32     sampleRate;
-        quint32     byteRate;
-        quint16     blockAlign;
-        quint16     bitsPerSample;
-    };
-
-    struct DATAHeader
-    {
-        chunk       descriptor;
-//        quint8      data[];
-    };
-
-    struct CombinedHeader
-    {
-        RIFFHeader  riff;
-        WAVEHeader  wave;
-        DATAHeader  data;
-    };
-
-    CombinedHeader      header;
 };
 
 QT_END_NAMESPACE
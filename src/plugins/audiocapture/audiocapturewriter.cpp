@@ -0,0 +1,327 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <QtCore/qdebug.h>
+
+#include "audiocapturewriter.h"
+#include "audiocaptureprobecontrol.h"
+
+#include <string.h>
+
+#if defined(Q_OS_UNIX)
+#include <unistd.h>
+#endif
+
+QT_BEGIN_NAMESPACE
+
+// Captured audio is written in blocks ending on multiples of this size in the
+// file, the tail is written when recording stops.
+static const int defaultBlockSize = 64 * 1024;
+// Amount of audio the ring buffer can hold while the disk is stalled.
+static const int defaultBufferDuration = 4000; // ms
+static const int maximumBufferSize = 256 * 1024 * 1024;
+
+static int envValue(const char *name, int defaultValue)
+{
+    bool ok = false;
+    const int value = qgetenv(name).toInt(&ok);
+    return ok && value >= 0 ? value : defaultValue;
+}
+
+void AudioCaptureWriterThread::run()
+{
+    m_writer->writeLoop();
+}
+
+AudioCaptureWriter::AudioCaptureWriter(QObject *parent)
+    : QIODevice(parent)
+    , m_wavFile(true)
+    , m_thread(this)
+    , m_stopping(false)
+    , m_blockSize(defaultBlockSize)
+    , m_syncInterval(0)
+    , m_filePosition(0)
+    , m_failed(false)
+{
+    // Rounded to whole pages so that the blocks stay aligned for the page cache.
+    const int blockSize = envValue("QT_AUDIOCAPTURE_BLOCK_SIZE", defaultBlockSize);
+    m_blockSize = qBound(4096, (blockSize + 4095) & ~4095, 16 * 1024 * 1024);
+    m_syncInterval = envValue("QT_AUDIOCAPTURE_SYNC_INTERVAL", 0);
+}
+
+AudioCaptureWriter::~AudioCaptureWriter()
+{
+    stop();
+}
+
+bool AudioCaptureWriter::start(const QString &fileName, const QAudioFormat &format, bool wavFile)
+{
+    stop();
+
+    m_file.setFileName(fileName);
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Unbuffered)) {
+        setErrorString(m_file.errorString());
+        return false;
+    }
+
+    m_format = format;
+    m_wavFile = wavFile;
+    m_filePosition = 0;
+    m_failed = false;
+    m_stopping = false;
+    m_droppedFrames.store(0);
+
+    if (m_wavFile) {
+        writeWavHeader(-1);
+        m_filePosition = sizeof(CombinedHeader);
+    }
+
+    const int bytesPerFrame = qMax(1, m_format.bytesPerFrame());
+    const qint64 duration = envValue("QT_AUDIOCAPTURE_BUFFER_DURATION", defaultBufferDuration);
+    qint64 capacity = m_format.bytesForDuration(duration * 1000);
+    capacity = qBound(qint64(4 * m_blockSize), capacity, qint64(maximumBufferSize));
+    m_ringBuffer.reset(int(capacity - capacity % bytesPerFrame));
+
+    QIODevice::open(QIODevice::WriteOnly | QIODevice::Unbuffered);
+
+    m_syncTimer.start();
+    m_thread.start();
+
+    return true;
+}
+
+void AudioCaptureWriter::stop()
+{
+    if (!m_file.isOpen())
+        return;
+
+    m_mutex.lock();
+    m_stopping = true;
+    m_dataAvailable.wakeOne();
+    m_mutex.unlock();
+
+    m_thread.wait();
+    close();
+
+    if (m_wavFile)
+        writeWavHeader(m_filePosition - qint64(sizeof(CombinedHeader)));
+    if (m_syncInterval > 0)
+        syncFile();
+    m_file.close();
+
+    const qint64 dropped = m_droppedFrames.load();
+    if (dropped > 0)
+        qWarning() << "AudioCaptureSession: dropped" << dropped << "frames while writing" << m_file.fileName();
+}
+
+/*!
+    Returns the number of captured frames which didn't fit into the ring
+    buffer since recording started.
+*/
+qint64 AudioCaptureWriter::droppedFrames() const
+{
+    return m_droppedFrames.load();
+}
+
+void AudioCaptureWriter::addProbe(AudioCaptureProbeControl *probe)
+{
+    QMutexLocker locker(&m_probeMutex);
+
+    if (m_probes.contains(probe))
+        return;
+
+    m_probes.append(probe);
+}
+
+void AudioCaptureWriter::removeProbe(AudioCaptureProbeControl *probe)
+{
+    QMutexLocker locker(&m_probeMutex);
+    m_probes.removeOne(probe);
+}
+
+qint64 AudioCaptureWriter::readData(char *data, qint64 maxlen)
+{
+    Q_UNUSED(data);
+    Q_UNUSED(maxlen);
+    return -1;
+}
+
+qint64 AudioCaptureWriter::writeData(const char *data, qint64 len)
+{
+    // Never block the capture, audio that doesn't fit is dropped in whole frames.
+    const int bytesPerFrame = qMax(1, m_format.bytesPerFrame());
+    const qint64 free = m_ringBuffer.bytesFree() - m_ringBuffer.bytesFree() % bytesPerFrame;
+    const qint64 written = m_ringBuffer.write(data, int(qMin(len, free)));
+    if (written < len)
+        m_droppedFrames.fetchAndAddRelaxed((len - written) / bytesPerFrame);
+
+    if (m_ringBuffer.bytesAvailable() >= m_blockSize) {
+        QMutexLocker locker(&m_mutex);
+        m_dataAvailable.wakeOne();
+    }
+
+    return len;
+}
+
+void AudioCaptureWriter::writeLoop()
+{
+    forever {
+        bool stopping;
+        {
+            QMutexLocker locker(&m_mutex);
+            // The timeout keeps the sync cadence going while the input is paused.
+            if (!m_stopping && m_ringBuffer.bytesAvailable() < m_blockSize)
+                m_dataAvailable.wait(&m_mutex, 100);
+            stopping = m_stopping;
+        }
+
+        // Coalesce the audio into blocks ending on the last whole frame before
+        // a block aligned file offset, so that every probed buffer starts on a
+        // frame. Only the tail left when stopping is written unaligned.
+        const int bytesPerFrame = qMax(1, m_format.bytesPerFrame());
+        const int available = m_ringBuffer.bytesAvailable();
+        qint64 length = available;
+        if (!stopping) {
+            length = (m_filePosition + available) / m_blockSize * m_blockSize - m_filePosition;
+            length -= length % bytesPerFrame;
+        }
+
+        while (length > 0) {
+            int region = 0;
+            const char *data = m_ringBuffer.readRegion(&region);
+            region = int(qMin(qint64(region), length));
+            // A frame split by the end of the ring is left for the next pass
+            if (!stopping)
+                region -= region % bytesPerFrame;
+            if (region <= 0)
+                break;
+
+            {
+                QMutexLocker locker(&m_probeMutex);
+                foreach (AudioCaptureProbeControl* probe, m_probes)
+                    probe->bufferProbed(data, region, m_format);
+            }
+
+            if (!m_failed && !writeBlock(data, region)) {
+                m_failed = true;
+                emit writeError(m_file.errorString());
+            }
+
+            m_ringBuffer.releaseRead(region);
+            length -= region;
+        }
+
+        if (m_syncInterval > 0 && !m_failed && m_syncTimer.elapsed() >= m_syncInterval) {
+            syncFile();
+            m_syncTimer.restart();
+        }
+
+        if (stopping)
+            return;
+    }
+}
+
+bool AudioCaptureWriter::writeBlock(const char *data, int length)
+{
+    while (length > 0) {
+        const qint64 written = m_file.write(data, length);
+        if (written <= 0)
+            return false;
+        data += written;
+        length -= written;
+        m_filePosition += written;
+    }
+    return true;
+}
+
+void AudioCaptureWriter::syncFile()
+{
+#if defined(Q_OS_LINUX)
+    ::fdatasync(m_file.handle());
+#elif defined(Q_OS_UNIX)
+    ::fsync(m_file.handle());
+#endif
+}
+
+void AudioCaptureWriter::writeWavHeader(qint64 dataSize)
+{
+    const QByteArray header = wavHeader(m_format, dataSize);
+    m_file.seek(0);
+    m_file.write(header);
+}
+
+// Returns the WAV header for \a dataSize bytes of samples, or with placeholder
+// sizes while recording if \a dataSize is negative. Files whose sizes don't
+// fit into 32 bits are turned into RF64 files (EBU Tech 3306), the reserved
+// JUNK chunk becoming the ds64 chunk.
+QByteArray AudioCaptureWriter::wavHeader(const QAudioFormat &format, qint64 dataSize)
+{
+    CombinedHeader header;
+    memset(&header, 0, sizeof(CombinedHeader));
+
+    const qint64 riffSize = dataSize + qint64(sizeof(CombinedHeader)) - 8;
+    const bool rf64 = riffSize > qint64(0xFFFFFFFFu);
+
+    memcpy(header.riff.descriptor.id, rf64 ? "RF64" : "RIFF", 4);
+    header.riff.descriptor.size = dataSize < 0 || rf64 ? 0xFFFFFFFF : quint32(riffSize);
+    memcpy(header.riff.type, "WAVE", 4);
+
+    memcpy(header.ds64.descriptor.id, rf64 ? "ds64" : "JUNK", 4);
+    header.ds64.descriptor.size = sizeof(DS64Header) - sizeof(chunk);
+    if (rf64) {
+        const int blockAlign = qMax(1, format.bytesPerFrame());
+        const quint64 sampleCount = quint64(dataSize) / blockAlign;
+        header.ds64.riffSizeLow = quint32(quint64(riffSize));
+        header.ds64.riffSizeHigh = quint32(quint64(riffSize) >> 32);
+        header.ds64.dataSizeLow = quint32(quint64(dataSize));
+        header.ds64.dataSizeHigh = quint32(quint64(dataSize) >> 32);
+        header.ds64.sampleCountLow = quint32(sampleCount);
+        header.ds64.sampleCountHigh = quint32(sampleCount >> 32);
+    }
+
+    memcpy(header.wave.descriptor.id, "fmt ", 4);
+    header.wave.descriptor.size = 16;
+    header.wave.audioFormat = 1; // for PCM data
+    header.wave.numChannels = format.channelCount();
+    header.wave.sampleRate = format.sampleRate();
+    header.wave.byteRate = format.sampleRate()*format.channelCount()*format.sampleSize()/8;
+    header.wave.blockAlign = format.channelCount()*format.sampleSize()/8;
+    header.wave.bitsPerSample = format.sampleSize();
+
+    memcpy(header.data.descriptor.id, "data", 4);
+    header.data.descriptor.size = dataSize < 0 || rf64 ? 0xFFFFFFFF : quint32(dataSize);
+
+    return QByteArray(reinterpret_cast<const char *>(&header), sizeof(CombinedHeader));
+}
+
+QT_END_NAMESPACE
@@ -0,0 +1,183 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef AUDIOCAPTUREWRITER_H
+#define AUDIOCAPTUREWRITER_H
+
+#include <QtCore/qatomic.h>
+#include <QtCore/qelapsedtimer.h>
+#include <QtCore/qfile.h>
+#include <QtCore/qiodevice.h>
+#include <QtCore/qmutex.h>
+#include <QtCore/qthread.h>
+#include <QtCore/qwaitcondition.h>
+
+#include <qaudioformat.h>
+#include <private/qaudioringbuffer_p.h>
+
+QT_BEGIN_NAMESPACE
+
+class AudioCaptureProbeControl;
+class AudioCaptureWriter;
+
+class AudioCaptureWriterThread : public QThread
+{
+public:
+    explicit AudioCaptureWriterThread(AudioCaptureWriter *writer)
+        : m_writer(writer)
+    {
+    }
+
+protected:
+    void run();
+
+private:
+    AudioCaptureWriter *m_writer;
+};
+
+// The device QAudioInput pushes the captured audio into. Samples are copied
+// into a preallocated ring buffer and written to disk by a dedicated thread,
+// so disk stalls never block the capture. Audio which doesn't fit into the
+// ring buffer is dropped and counted instead.
+class AudioCaptureWriter : public QIODevice
+{
+    Q_OBJECT
+public:
+    AudioCaptureWriter(QObject *parent = 0);
+    ~AudioCaptureWriter();
+
+    bool start(const QString &fileName, const QAudioFormat &format, bool wavFile);
+    void stop();
+
+    qint64 droppedFrames() const;
+
+    static QByteArray wavHeader(const QAudioFormat &format, qint64 dataSize);
+
+    void addProbe(AudioCaptureProbeControl *probe);
+    void removeProbe(AudioCaptureProbeControl *probe);
+
+    bool isSequential() const { return true; }
+
+Q_SIGNALS:
+    void writeError(const QString &errorString);
+
+protected:
+    qint64 readData(char *data, qint64 maxlen);
+    qint64 writeData(const char *data, qint64 len);
+
+private:
+    friend class AudioCaptureWriterThread;
+
+    void writeLoop();
+    bool writeBlock(const char *data, int length);
+    void syncFile();
+    void writeWavHeader(qint64 dataSize);
+
+    // WAV header stuff
+
+    struct chunk
+    {
+        char        id[4];
+        quint32     size;
+    };
+
+    struct RIFFHeader
+    {
+        chunk       descriptor;
+        char        type[4];
+    };
+
+    // Reserved as a JUNK chunk while recording, turned into a ds64 chunk
+    // holding the 64 bit sizes when the data outgrows the RIFF limits.
+    struct DS64Header
+    {
+        chunk       descriptor;
+        quint32     riffSizeLow;
+        quint32     riffSizeHigh;
+        quint32     dataSizeLow;
+        quint32     dataSizeHigh;
+        quint32     sampleCountLow;
+        quint32     sampleCountHigh;
+        quint32     tableLength;
+    };
+
+    struct WAVEHeader
+    {
+        chunk       descriptor;
+        quint16     audioFormat;        // PCM = 1
+        quint16     numChannels;
+        quint32     sampleRate;
+        quint32     byteRate;
+        quint16     blockAlign;
+        quint16     bitsPerSample;
+    };
+
+    struct DATAHeader
+    {
+        chunk       descriptor;
+//        quint8      data[];
+    };
+
+    struct CombinedHeader
+    {
+        RIFFHeader  riff;
+        DS64Header  ds64;
+        WAVEHeader  wave;
+        DATAHeader  data;
+    };
+
+    QFile m_file;
+    QAudioFormat m_format;
+    bool m_wavFile;
+
+    QAudioRingBuffer m_ringBuffer;
+    AudioCaptureWriterThread m_thread;
+    QMutex m_mutex;
+    QWaitCondition m_dataAvailable;
+    bool m_stopping;
+
+    int m_blockSize;
+    int m_syncInterval;
+    qint64 m_filePosition;
+    QElapsedTimer m_syncTimer;
+    bool m_failed;
+
+    QAtomicInteger<qint64> m_droppedFrames;
+
+    QList<AudioCaptureProbeControl*> m_probes;
+    QMutex m_probeMutex;
+};
+
+QT_END_NAMESPACE
+
+#endif
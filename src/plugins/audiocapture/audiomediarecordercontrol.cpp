@@ -87,6 +87,13 @@ qint64 AudioMediaRecorderControl::duration() const
     return m_session->position();
 }
 
+// Frames lost because the disk couldn't keep up with the capture, exposed as
+// the "droppedFrames" property of the control.
+qint64 AudioMediaRecorderControl::droppedFrames() const
+{
+    return m_session->droppedFrames();
+}
+
 bool AudioMediaRecorderControl::isMuted() const
 {
     return m_session->isMuted();
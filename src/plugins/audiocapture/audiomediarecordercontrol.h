@@ -46,6 +46,7 @@ class AudioCaptureSession;
 class AudioMediaRecorderControl : public QMediaRecorderControl
 {
     Q_OBJECT
+    Q_PROPERTY(qint64 droppedFrames READ droppedFrames)
 public:
     AudioMediaRecorderControl(QObject *parent = 0);
     ~AudioMediaRecorderControl();
@@ -58,6 +59,8 @@ public:
 
     qint64 duration() const;
 
+    qint64 droppedFrames() const;
+
     bool isMuted() const;
     qreal volume() const;
 
@@ -36,6 +36,7 @@
 #include <private/qgstreamerbushelper_p.h>
 
 #include <private/qgstutils_p.h>
+#include <private/qgstaudiobuffer_p.h>
 
 #include <gst/gstvalue.h>
 #include <gst/base/gstbasesrc.h>
@@ -442,29 +443,23 @@ QAudioBuffer QGstreamerAudioDecoderSession::read()
         if (buffersAvailable == 1)
             emit bufferAvailableChanged(false);
 
-        const char* bufferData = 0;
-        int bufferSize = 0;
-
 #if GST_CHECK_VERSION(1,0,0)
         GstSample *sample = gst_app_sink_pull_sample(m_appSink);
         GstBuffer *buffer = gst_sample_get_buffer(sample);
-        GstMapInfo mapInfo;
-        gst_buffer_map(buffer, &mapInfo, GST_MAP_READ);
-        bufferData = (const char*)mapInfo.data;
-        bufferSize = mapInfo.size;
         QAudioFormat format = QGstUtils::audioFormatForSample(sample);
 #else
         GstBuffer *buffer = gst_app_sink_pull_buffer(m_appSink);
-        bufferData = (const char*)buffer->data;
-        bufferSize = buffer->size;
         QAudioFormat format = QGstUtils::audioFormatForBuffer(buffer);
 #endif
 
         if (format.isValid()) {
-            // XXX At the moment we have to copy data from GstBuffer into QAudioBuffer.
-            // We could improve performance by implementing QAbstractAudioBuffer for GstBuffer.
             qint64 position = getPositionFromBuffer(buffer);
-            audioBuffer = QAudioBuffer(QByteArray((const char*)bufferData, bufferSize), format, position);
+            // The QAudioBuffer keeps a reference to the GstBuffer instead of copying it
+            QGstAudioBuffer *provider = new QGstAudioBuffer(buffer, format, position);
+            if (provider->isMapped())
+                audioBuffer = QAudioBuffer(provider);
+            else
+                provider->release();
             position /= 1000; // convert to milliseconds
             if (position != m_position) {
                 m_position = position;
@@ -42,8 +42,6 @@
 #include <private/qgstutils_p.h>
 #include <QtMultimedia/qmediametadata.h>
 #include <QtCore/qdebug.h>
-#include <QtCore/qbuffer.h>
-#include <QtGui/qimagereader.h>
 
 //#define DEBUG_CAPTURE
 
@@ -64,6 +62,7 @@ CameraBinImageCapture::CameraBinImageCapture(CameraBinSession *session)
     connect(m_session, SIGNAL(statusChanged(QCamera::Status)), SLOT(updateState()));
     connect(m_session, SIGNAL(imageExposed(int)), this, SIGNAL(imageExposed(int)));
     connect(m_session, SIGNAL(imageCaptured(int,QImage)), this, SIGNAL(imageCaptured(int,QImage)));
+    connect(m_session, SIGNAL(imageCaptureError(int,int,QString)), this, SIGNAL(error(int,int,QString)));
     connect(m_session->cameraControl()->resourcePolicy(), SIGNAL(canCaptureChanged()), this, SLOT(updateState()));
 
     m_session->bus()->installMessageFilter(this);
@@ -233,16 +232,11 @@ bool CameraBinImageCapture::MuxerProbe::probeBuffer(GstBuffer *buffer)
          session->captureBufferFormatControl()->bufferFormat() == QVideoFrame::Format_Jpeg) {
 
         QSize resolution = capture->m_jpegResolution;
-        //if resolution is not presented in caps, try to find it from encoded jpeg data:
+        //if resolution is not presented in caps, read it from the jpeg frame header:
 #if GST_CHECK_VERSION(1,0,0)
         GstMapInfo mapInfo;
         if (resolution.isEmpty() && gst_buffer_map(buffer, &mapInfo, GST_MAP_READ)) {
-            QBuffer data;
-            data.setData(reinterpret_cast<const char*>(mapInfo.data), mapInfo.size);
-
-            QImageReader reader(&data, "JPEG");
-            resolution = reader.size();
-
+            resolution = QGstUtils::jpegResolution(mapInfo.data, mapInfo.size);
             gst_buffer_unmap(buffer, &mapInfo);
         }
 
@@ -251,12 +245,8 @@ bool CameraBinImageCapture::MuxerProbe::probeBuffer(GstBuffer *buffer)
                     &info, GST_VIDEO_FORMAT_ENCODED, resolution.width(), resolution.height());
         QGstVideoBuffer *videoBuffer = new QGstVideoBuffer(buffer, info);
 #else
-        if (resolution.isEmpty()) {
-            QBuffer data;
-            data.setData(reinterpret_cast<const char*>(GST_BUFFER_DATA(buffer)), GST_BUFFER_SIZE(buffer));
-            QImageReader reader(&data, "JPEG");
-            resolution = reader.size();
-        }
+        if (resolution.isEmpty())
+            resolution = QGstUtils::jpegResolution(GST_BUFFER_DATA(buffer), GST_BUFFER_SIZE(buffer));
 
         QGstVideoBuffer *videoBuffer = new QGstVideoBuffer(buffer,
                                                            -1); //bytesPerLine is not available for jpegs
@@ -54,6 +54,8 @@
 #include <private/qgstreamerbushelper_p.h>
 #include <private/qgstreamervideorendererinterface_p.h>
 #include <private/qgstutils_p.h>
+#include <private/qgstimagecaptureworker_p.h>
+#include <qcameraimagecapture.h>
 #include <qmediarecorder.h>
 #include <qvideosurfaceformat.h>
 
@@ -141,7 +143,8 @@ CameraBinSession::CameraBinSession(GstElementFactory *sourceFactory, QObject *pa
      m_fileSink(0),
      m_audioEncoder(0),
      m_videoEncoder(0),
-     m_muxer(0)
+     m_muxer(0),
+     m_imageCaptureWorker(0)
 {
     if (m_sourceFactory)
         gst_object_ref(GST_OBJECT(m_sourceFactory));
@@ -168,6 +171,9 @@ CameraBinSession::CameraBinSession(GstElementFactory *sourceFactory, QObject *pa
     m_captureDestinationControl = new CameraBinCaptureDestination(this);
     m_captureBufferFormatControl = new CameraBinCaptureBufferFormat(this);
 
+    m_imageCaptureWorker = new QGstImageCaptureWorker(this);
+    connect(m_imageCaptureWorker, SIGNAL(imageConverted(int,QImage)), SIGNAL(imageCaptured(int,QImage)));
+
     QByteArray envFlags = qgetenv("QT_GSTREAMER_CAMERABIN_FLAGS");
     if (!envFlags.isEmpty())
         g_object_set(G_OBJECT(m_camerabin), "flags", envFlags.toInt(), NULL);
@@ -920,27 +926,35 @@ bool CameraBinSession::processSyncMessage(const QGstreamerMessage &message)
             GstBuffer * const buffer = gst_value_get_buffer(sampleValue);
 #endif
 
-            QImage image;
+            // The preview is converted off the streaming thread, camerabin
+            // already scaled it to the preview caps. This is a sync handler,
+            // so the conversion fails rather than waiting for a full queue.
+            bool queued = false;
 #if GST_CHECK_VERSION(1,0,0)
             GstVideoInfo previewInfo;
-            if (gst_video_info_from_caps(&previewInfo, previewCaps))
-                image = QGstUtils::bufferToImage(buffer, previewInfo);
+            const bool valid = gst_video_info_from_caps(&previewInfo, previewCaps);
+            if (valid)
+                queued = m_imageCaptureWorker->convertImage(m_requestId, buffer, previewInfo);
             gst_sample_unref(sample);
 #else
-            image = QGstUtils::bufferToImage(buffer);
+            const bool valid = buffer != 0;
+            if (valid)
+                queued = m_imageCaptureWorker->convertImage(m_requestId, buffer);
             gst_buffer_unref(buffer);
 #endif
-            if (!image.isNull()) {
+            if (valid) {
                 static QMetaMethod exposedSignal = QMetaMethod::fromSignal(&CameraBinSession::imageExposed);
                 exposedSignal.invoke(this,
                                      Qt::QueuedConnection,
                                      Q_ARG(int,m_requestId));
-
-                static QMetaMethod capturedSignal = QMetaMethod::fromSignal(&CameraBinSession::imageCaptured);
-                capturedSignal.invoke(this,
-                                      Qt::QueuedConnection,
-                                      Q_ARG(int,m_requestId),
-                                      Q_ARG(QImage,image));
+            }
+            if (valid && !queued) {
+                static QMetaMethod errorSignal = QMetaMethod::fromSignal(&CameraBinSession::imageCaptureError);
+                errorSignal.invoke(this,
+                                   Qt::QueuedConnection,
+                                   Q_ARG(int,m_requestId),
+                                   Q_ARG(int,QCameraImageCapture::NotReadyError),
+                                   Q_ARG(QString,tr("Image capture queue is full")));
             }
             return true;
         }
@@ -69,6 +69,7 @@ class CameraBinCaptureDestination;
 class CameraBinCaptureBufferFormat;
 class QGstreamerVideoRendererInterface;
 class CameraBinViewfinderSettings;
+class QGstImageCaptureWorker;
 
 class QGstreamerElementFactory
 {
@@ -165,6 +166,7 @@ signals:
     void error(int error, const QString &errorString);
     void imageExposed(int requestId);
     void imageCaptured(int requestId, const QImage &img);
+    void imageCaptureError(int requestId, int error, const QString &errorString);
     void mutedChanged(bool);
     void viewfinderChanged();
     void readyChanged(bool);
@@ -273,6 +275,8 @@ private:
     GstElement *m_videoEncoder;
     GstElement *m_muxer;
 
+    QGstImageCaptureWorker *m_imageCaptureWorker;
+
 public:
     QString m_imageFileName;
     int m_requestId;
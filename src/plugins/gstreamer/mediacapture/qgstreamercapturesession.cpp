@@ -42,6 +42,7 @@
 #include <private/qgstreameraudioprobecontrol_p.h>
 #include <private/qgstreamerbushelper_p.h>
 #include <private/qgstutils_p.h>
+#include <private/qgstimagecaptureworker_p.h>
 
 #include <gst/gsttagsetter.h>
 #include <gst/gstversion.h>
@@ -52,8 +53,8 @@
 #include <QtCore/qset.h>
 #include <QCoreApplication>
 #include <QtCore/qmetaobject.h>
-#include <QtCore/qfile.h>
 #include <QtGui/qimage.h>
+#include <qcameraimagecapture.h>
 
 QT_BEGIN_NAMESPACE
 
@@ -83,7 +84,7 @@ QGstreamerCaptureSession::QGstreamerCaptureSession(QGstreamerCaptureSession::Cap
      m_videoPreview(0),
      m_imageCaptureBin(0),
      m_encodeBin(0),
-     m_passImage(false),
+     m_imageCaptureWorker(0),
      m_passPrerollImage(false)
 {
     m_pipeline = gst_pipeline_new("media-capture-pipeline");
@@ -99,6 +100,16 @@ QGstreamerCaptureSession::QGstreamerCaptureSession(QGstreamerCaptureSession::Cap
     m_recorderControl = new QGstreamerRecorderControl(this);
     m_mediaContainerControl = new QGstreamerMediaContainerControl(this);
 
+    // Previews are half the frame size unless QT_GSTREAMER_CAPTURE_PREVIEW_SIZE=<w>x<h> is set.
+    const QList<QByteArray> previewSize = qgetenv("QT_GSTREAMER_CAPTURE_PREVIEW_SIZE").split('x');
+    if (previewSize.size() == 2)
+        m_imagePreviewSize = QSize(previewSize.at(0).toInt(), previewSize.at(1).toInt());
+
+    m_imageCaptureWorker = new QGstImageCaptureWorker(this);
+    connect(m_imageCaptureWorker, SIGNAL(imageConverted(int,QImage)), SIGNAL(imageCaptured(int,QImage)));
+    connect(m_imageCaptureWorker, SIGNAL(imageSaved(int,QString)), SIGNAL(imageSaved(int,QString)));
+    connect(m_imageCaptureWorker, SIGNAL(saveFailed(int,QString)), SLOT(imageSaveFailed(int,QString)));
+
     setState(StoppedState);
 }
 
@@ -360,40 +371,84 @@ void QGstreamerCaptureSession::probeCaps(GstCaps *caps)
 
 bool QGstreamerCaptureSession::probeBuffer(GstBuffer *buffer)
 {
-    if (m_passPrerollImage) {
-        m_passImage = false;
-        m_passPrerollImage = false;
+    PendingImage image;
+    {
+        QMutexLocker locker(&m_imageCaptureMutex);
+
+        if (m_passPrerollImage) {
+            m_passPrerollImage = false;
+            // The preroll frame is encoded but never saved.
+            m_encodingImages.enqueue(PendingImage());
+
+            return true;
+        } else if (m_requestedImages.isEmpty()) {
+            return false;
+        }
 
-        return true;
-    } else  if (!m_passImage) {
-        return false;
+        image = m_requestedImages.dequeue();
     }
 
-    m_passImage = false;
+    static QMetaMethod exposedSignal = QMetaMethod::fromSignal(&QGstreamerCaptureSession::imageExposed);
+    exposedSignal.invoke(this,
+                         Qt::QueuedConnection,
+                         Q_ARG(int,image.requestId));
 
+    // The preview is converted off the streaming thread. If conversions and
+    // saves have fallen behind the capture fails instead of stalling here.
 #if GST_CHECK_VERSION(1,0,0)
-    QImage img = QGstUtils::bufferToImage(buffer, m_previewInfo);
+    const QSize previewSize = m_imagePreviewSize.isValid()
+            ? m_imagePreviewSize
+            : QSize(m_previewInfo.width / 2, m_previewInfo.height / 2);
+    const bool queued = m_imageCaptureWorker->convertImage(image.requestId, buffer, m_previewInfo, previewSize);
 #else
-    QImage img = QGstUtils::bufferToImage(buffer);
+    const bool queued = m_imageCaptureWorker->convertImage(image.requestId, buffer);
 #endif
 
-    if (img.isNull())
-        return true;
-
-    static QMetaMethod exposedSignal = QMetaMethod::fromSignal(&QGstreamerCaptureSession::imageExposed);
-    exposedSignal.invoke(this,
-                         Qt::QueuedConnection,
-                         Q_ARG(int,m_imageRequestId));
+    if (!queued) {
+        imageQueueFull(image.requestId);
+        // The frame is still encoded, keep the queue in step but don't save it.
+        image.fileName.clear();
+    }
 
-    static QMetaMethod capturedSignal = QMetaMethod::fromSignal(&QGstreamerCaptureSession::imageCaptured);
-    capturedSignal.invoke(this,
-                          Qt::QueuedConnection,
-                          Q_ARG(int,m_imageRequestId),
-                          Q_ARG(QImage,img));
+    {
+        QMutexLocker locker(&m_imageCaptureMutex);
+        m_encodingImages.enqueue(image);
+    }
 
     return true;
 }
 
+void QGstreamerCaptureSession::saveImage(GstBuffer *buffer)
+{
+    PendingImage image;
+    {
+        QMutexLocker locker(&m_imageCaptureMutex);
+        if (m_encodingImages.isEmpty())
+            return;
+        image = m_encodingImages.dequeue();
+    }
+
+    if (!image.fileName.isEmpty()
+            && !m_imageCaptureWorker->saveImage(image.requestId, buffer, image.fileName)) {
+        imageQueueFull(image.requestId);
+    }
+}
+
+void QGstreamerCaptureSession::imageQueueFull(int requestId)
+{
+    static QMetaMethod errorSignal = QMetaMethod::fromSignal(&QGstreamerCaptureSession::imageCaptureError);
+    errorSignal.invoke(this,
+                       Qt::QueuedConnection,
+                       Q_ARG(int,requestId),
+                       Q_ARG(int,QCameraImageCapture::NotReadyError),
+                       Q_ARG(QString,tr("Image capture queue is full")));
+}
+
+void QGstreamerCaptureSession::imageSaveFailed(int requestId, const QString &errorString)
+{
+    emit imageCaptureError(requestId, QCameraImageCapture::ResourceError, errorString);
+}
+
 static gboolean saveImageFilter(GstElement *element,
                                 GstBuffer *buffer,
                                 GstPad *pad,
@@ -403,29 +458,7 @@ static gboolean saveImageFilter(GstElement *element,
     Q_UNUSED(pad);
     QGstreamerCaptureSession *session = (QGstreamerCaptureSession *)appdata;
 
-    QString fileName = session->m_imageFileName;
-
-    if (!fileName.isEmpty()) {
-        QFile f(fileName);
-        if (f.open(QFile::WriteOnly)) {
-#if GST_CHECK_VERSION(1,0,0)
-            GstMapInfo info;
-            if (gst_buffer_map(buffer, &info, GST_MAP_READ)) {
-                f.write(reinterpret_cast<const char *>(info.data), info.size);
-                gst_buffer_unmap(buffer, &info);
-            }
-#else
-            f.write(reinterpret_cast<const char *>(buffer->data), buffer->size);
-#endif
-            f.close();
-
-            static QMetaMethod savedSignal = QMetaMethod::fromSignal(&QGstreamerCaptureSession::imageSaved);
-            savedSignal.invoke(session,
-                               Qt::QueuedConnection,
-                               Q_ARG(int,session->m_imageRequestId),
-                               Q_ARG(QString,fileName));
-        }
-    }
+    session->saveImage(buffer);
 
     return TRUE;
 }
@@ -457,18 +490,18 @@ GstElement *QGstreamerCaptureSession::buildImageCapture()
     gst_element_add_pad(GST_ELEMENT(bin), gst_ghost_pad_new("imagesink", pad));
     gst_object_unref(GST_OBJECT(pad));
 
-    m_passImage = false;
+    QMutexLocker locker(&m_imageCaptureMutex);
     m_passPrerollImage = true;
-    m_imageFileName = QString();
+    m_requestedImages.clear();
+    m_encodingImages.clear();
 
     return bin;
 }
 
 void QGstreamerCaptureSession::captureImage(int requestId, const QString &fileName)
 {
-    m_imageRequestId = requestId;
-    m_imageFileName = fileName;
-    m_passImage = true;
+    QMutexLocker locker(&m_imageCaptureMutex);
+    m_requestedImages.enqueue(PendingImage(requestId, fileName));
 }
 
 
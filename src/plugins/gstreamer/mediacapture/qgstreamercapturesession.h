@@ -38,6 +38,7 @@
 #include <qmediarecorder.h>
 
 #include <QtCore/qmutex.h>
+#include <QtCore/qqueue.h>
 #include <QtCore/qurl.h>
 
 #include <gst/gst.h>
@@ -57,6 +58,7 @@ class QGstreamerRecorderControl;
 class QGstreamerMediaContainerControl;
 class QGstreamerVideoRendererInterface;
 class QGstreamerAudioProbeControl;
+class QGstImageCaptureWorker;
 
 class QGstreamerElementFactory
 {
@@ -122,6 +124,7 @@ public:
     void setVideoPreview(QObject *viewfinder);
 
     void captureImage(int requestId, const QString &fileName);
+    void saveImage(GstBuffer *buffer);
 
     State state() const;
     State pendingState() const;
@@ -144,6 +147,7 @@ signals:
     void imageExposed(int requestId);
     void imageCaptured(int requestId, const QImage &img);
     void imageSaved(int requestId, const QString &path);
+    void imageCaptureError(int requestId, int error, const QString &errorString);
     void mutedChanged(bool);
     void volumeChanged(qreal);
     void readyChanged(bool);
@@ -159,9 +163,13 @@ public slots:
     void setMuted(bool);
     void setVolume(qreal volume);
 
+private slots:
+    void imageSaveFailed(int requestId, const QString &errorString);
+
 private:
     void probeCaps(GstCaps *caps);
     bool probeBuffer(GstBuffer *buffer);
+    void imageQueueFull(int requestId);
 
     enum PipelineMode { EmptyPipeline, PreviewPipeline, RecordingPipeline, PreviewAndRecordingPipeline };
 
@@ -226,11 +234,24 @@ private:
     GstVideoInfo m_previewInfo;
 #endif
 
-public:
-    bool m_passImage;
+    struct PendingImage
+    {
+        PendingImage() : requestId(-1) {}
+        PendingImage(int requestId, const QString &fileName)
+            : fileName(fileName), requestId(requestId) {}
+
+        QString fileName;
+        int requestId;
+    };
+
+    // Requests waiting for a frame, and frames on their way to the encoder,
+    // so a burst of captures keeps each frame paired with its request.
+    QMutex m_imageCaptureMutex;
+    QQueue<PendingImage> m_requestedImages;
+    QQueue<PendingImage> m_encodingImages;
+    QGstImageCaptureWorker *m_imageCaptureWorker;
+    QSize m_imagePreviewSize;
     bool m_passPrerollImage;
-    QString m_imageFileName;
-    int m_imageRequestId;
 };
 
 QT_END_NAMESPACE
@@ -42,6 +42,7 @@ QGstreamerImageCaptureControl::QGstreamerImageCaptureControl(QGstreamerCaptureSe
     connect(m_session, SIGNAL(imageExposed(int)), this, SIGNAL(imageExposed(int)));
     connect(m_session, SIGNAL(imageCaptured(int,QImage)), this, SIGNAL(imageCaptured(int,QImage)));
     connect(m_session, SIGNAL(imageSaved(int,QString)), this, SIGNAL(imageSaved(int,QString)));
+    connect(m_session, SIGNAL(imageCaptureError(int,int,QString)), this, SIGNAL(error(int,int,QString)));
 }
 
 QGstreamerImageCaptureControl::~QGstreamerImageCaptureControl()
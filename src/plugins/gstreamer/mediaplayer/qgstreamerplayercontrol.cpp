@@ -78,6 +78,8 @@ QGstreamerPlayerControl::QGstreamerPlayerControl(QGstreamerPlayerSession *sessio
             this, SLOT(updateSessionState(QMediaPlayer::State)));
     connect(m_session,SIGNAL(bufferingProgressChanged(int)),
             this, SLOT(setBufferProgress(int)));
+    connect(m_session, SIGNAL(availablePlaybackRangesChanged()),
+            this, SLOT(updateAvailablePlaybackRanges()));
     connect(m_session, SIGNAL(playbackFinished()),
             this, SLOT(processEOS()));
     connect(m_session, SIGNAL(audioAvailableChanged(bool)),
@@ -540,6 +542,11 @@ void QGstreamerPlayerControl::setBufferProgress(int progress)
     emit bufferStatusChanged(m_bufferProgress);
 }
 
+void QGstreamerPlayerControl::updateAvailablePlaybackRanges()
+{
+    emit availablePlaybackRangesChanged(m_session->availablePlaybackRanges());
+}
+
 void QGstreamerPlayerControl::handleInvalidMedia()
 {
     pushState();
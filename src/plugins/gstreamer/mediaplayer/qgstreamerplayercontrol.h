@@ -103,6 +103,7 @@ private Q_SLOTS:
     void updateMediaStatus();
     void processEOS();
     void setBufferProgress(int progress);
+    void updateAvailablePlaybackRanges();
 
     void handleInvalidMedia();
 
@@ -125,6 +125,8 @@ QGstreamerPlayerSession::QGstreamerPlayerSession(QObject *parent)
      m_renderer(0),
 #if defined(HAVE_GST_APPSRC)
      m_appSrc(0),
+     m_cachedMedia(0),
+     m_networkManager(0),
 #endif
      m_videoProbe(0),
      m_audioProbe(0),
@@ -327,8 +329,13 @@ void QGstreamerPlayerSession::loadFromStream(const QNetworkRequest &request, QIO
     m_lastPosition = 0;
     m_isPlaylist = false;
 
+    if (appSrcStream != m_cachedMedia)
+        releaseCachedMedia();
+
     if (!m_appSrc)
         m_appSrc = new QGstAppSrc(this);
+    // The cache device waits on network replies handled by this thread
+    m_appSrc->setWorkerEnabled(appSrcStream != m_cachedMedia);
     m_appSrc->setStream(appSrcStream);
 
     if (m_playbin) {
@@ -364,9 +371,31 @@ void QGstreamerPlayerSession::loadFromUri(const QNetworkRequest &request)
         m_appSrc->deleteLater();
         m_appSrc = 0;
     }
+
+    releaseCachedMedia();
 #endif
 
     auto _kobo_nam = parent()->property("_kobo_nam");
+
+#if defined(HAVE_GST_APPSRC)
+    // Remote media is read through the persistent media cache when enabled
+    const QString scheme = request.url().scheme();
+    QGstreamerMediaCache *cache = QGstreamerMediaCache::instance();
+    if (cache && (scheme == QLatin1String("http") || scheme == QLatin1String("https"))) {
+        QNetworkAccessManager *nam = _kobo_nam.value<QNetworkAccessManager *>();
+        if (!nam) {
+            if (!m_networkManager)
+                m_networkManager = new QNetworkAccessManager(this);
+            nam = m_networkManager;
+        }
+
+        m_cachedMedia = new QGstreamerCachedMediaDevice(nam, request, cache, this);
+        connect(m_cachedMedia, SIGNAL(cachedRangesChanged()), this, SIGNAL(availablePlaybackRangesChanged()));
+        loadFromStream(request, m_cachedMedia);
+        return;
+    }
+#endif
+
     if (!_kobo_nam.isNull()) {
         auto nam = _kobo_nam.value<QNetworkAccessManager *>();
         QNetworkReply *reply = nam->get(request);
@@ -389,6 +418,18 @@ void QGstreamerPlayerSession::loadFromUri(const QNetworkRequest &request)
     }
 }
 
+#if defined(HAVE_GST_APPSRC)
+void QGstreamerPlayerSession::releaseCachedMedia()
+{
+    if (m_cachedMedia) {
+        m_cachedMedia->disconnect(this);
+        m_cachedMedia->deleteLater();
+        m_cachedMedia = 0;
+        emit availablePlaybackRangesChanged();
+    }
+}
+#endif
+
 qint64 QGstreamerPlayerSession::duration() const
 {
     return m_duration;
@@ -454,6 +495,18 @@ QMediaTimeRange QGstreamerPlayerSession::availablePlaybackRanges() const
     gst_query_unref(query);
 #endif
 
+#if defined(HAVE_GST_APPSRC)
+    // Media in the persistent cache is as available as buffered data; like
+    // the buffering query, assume a constant bitrate to map bytes to time
+    if (m_cachedMedia && m_cachedMedia->size() > 0) {
+        const qint64 size = m_cachedMedia->size();
+        foreach (const QMediaTimeInterval &interval, m_cachedMedia->cachedRanges().intervals()) {
+            ranges.addInterval(interval.start() * duration() / size,
+                               (interval.end() + 1) * duration() / size);
+        }
+    }
+#endif
+
     if (ranges.isEmpty() && !isLiveSource() && isSeekable())
         ranges.addInterval(0, duration());
 
@@ -45,6 +45,7 @@
 
 #if defined(HAVE_GST_APPSRC)
 #include <private/qgstappsrc_p.h>
+#include <private/qgstreamermediacache_p.h>
 #endif
 
 #include <gst/gst.h>
@@ -149,6 +150,7 @@ signals:
     void audioAvailableChanged(bool audioAvailable);
     void videoAvailableChanged(bool videoAvailable);
     void bufferingProgressChanged(int percentFilled);
+    void availablePlaybackRangesChanged();
     void playbackFinished();
     void tagsChanged();
     void streamsChanged();
@@ -179,6 +181,9 @@ private:
     static GstAutoplugSelectResult handleAutoplugSelect(GstBin *bin, GstPad *pad, GstCaps *caps, GstElementFactory *factory, QGstreamerPlayerSession *session);
 
     void processInvalidMedia(QMediaPlayer::Error errorCode, const QString& errorString);
+#if defined(HAVE_GST_APPSRC)
+    void releaseCachedMedia();
+#endif
 
     void removeVideoBufferProbe();
     void addVideoBufferProbe();
@@ -215,6 +220,8 @@ private:
 
 #if defined(HAVE_GST_APPSRC)
     QGstAppSrc *m_appSrc;
+    QGstreamerCachedMediaDevice *m_cachedMedia;
+    QNetworkAccessManager *m_networkManager;
 #endif
 
     QMap<QByteArray, QVariant> m_tags;
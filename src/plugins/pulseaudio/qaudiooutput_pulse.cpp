@@ -42,20 +42,24 @@
 #include "qpulsehelpers.h"
 #include <sys/types.h>
 #include <unistd.h>
+#include <string.h>
 
 QT_BEGIN_NAMESPACE
 
 const int PeriodTimeMs = 20;
 const int LowLatencyPeriodTimeMs = 10;
 const int LowLatencyBufferSizeMs = 40;
+const int MinimumCallbackLatencyMs = 10;
 
 #define LOW_LATENCY_CATEGORY_NAME "game"
 
 static void  outputStreamWriteCallback(pa_stream *stream, size_t length, void *userdata)
 {
     Q_UNUSED(stream);
-    Q_UNUSED(length);
-    Q_UNUSED(userdata);
+    QPulseAudioOutput *output = static_cast<QPulseAudioOutput *>(userdata);
+    if (output->isCallbackDriven())
+        output->streamWriteCallback(length);
+
     QPulseAudioEngine *pulseEngine = QPulseAudioEngine::instance();
     pa_threaded_mainloop_signal(pulseEngine->mainloop(), 0);
 }
@@ -163,6 +167,9 @@ QPulseAudioOutput::QPulseAudioOutput(const QByteArray &device)
     , m_audioBuffer(0)
     , m_resuming(false)
     , m_volume(1.0)
+    , m_callbackMode(false)
+    , m_frameSize(0)
+    , m_callbackVolume(0x10000)
 {
     connect(m_tickTimer, SIGNAL(timeout()), SLOT(userFeed()));
 }
@@ -202,8 +209,133 @@ QAudio::State QPulseAudioOutput::state() const
     return m_deviceState;
 }
 
+// QT_PULSEAUDIO_CALLBACK_LATENCY=<ms> makes the stream's write callback pull
+// audio from a lock-free ring buffer on the PulseAudio mainloop thread, leaving
+// only the filling of the ring buffer to the application thread. Returns the
+// target latency in milliseconds, or 0 when the tick timer feeds the stream.
+// QT_PULSEAUDIO_CALLBACK_DEBUG=1 prints the callbackStatistics() of each
+// stream when it is closed.
+int QPulseAudioOutput::callbackLatency()
+{
+    static const int latency = qgetenv("QT_PULSEAUDIO_CALLBACK_LATENCY").toInt();
+    return latency > 0 ? qMax(latency, MinimumCallbackLatencyMs) : 0;
+}
+
+QPulseAudioOutput::CallbackStatistics QPulseAudioOutput::callbackStatistics() const
+{
+    CallbackStatistics statistics;
+    statistics.callbacks = m_callbacks.load();
+    statistics.starvedCallbacks = m_starvedCallbacks.load();
+    statistics.underflows = m_underflows.load();
+    statistics.lastInterval = m_lastCallbackInterval.load();
+    statistics.maximumInterval = m_maximumCallbackInterval.load();
+    return statistics;
+}
+
+// Called on the PulseAudio mainloop thread with the mainloop locked
+void QPulseAudioOutput::streamWriteCallback(size_t length)
+{
+    m_callbacks.ref();
+    if (m_callbackTimer.isValid()) {
+        const int interval = int(m_callbackTimer.nsecsElapsed() / 1000);
+        m_lastCallbackInterval.store(interval);
+        if (interval > m_maximumCallbackInterval.load())
+            m_maximumCallbackInterval.store(interval);
+    }
+    m_callbackTimer.start();
+
+    if (size_t(m_ringBuffer.bytesAvailable()) < length)
+        m_starvedCallbacks.ref();
+
+    fillStream(length);
+}
+
+// Moves up to length bytes from the ring buffer straight into the stream's
+// memory, applying the volume on the way. Called with the mainloop locked.
+void QPulseAudioOutput::fillStream(size_t length)
+{
+    if (!m_stream || m_frameSize <= 0)
+        return;
+
+    const int wanted = int(qMin(length, size_t(m_ringBuffer.capacity())));
+    int bytes = qMin(m_ringBuffer.bytesAvailable(), wanted);
+    bytes -= bytes % m_frameSize;
+
+    // Nothing asks for data again until what was requested is written, so the
+    // next write to the ring buffer has to fill the stream itself.
+    if (bytes < wanted)
+        m_streamStarved.store(1);
+    if (bytes <= 0)
+        return;
+
+    void *dest = 0;
+    size_t nbytes = bytes;
+    if (pa_stream_begin_write(m_stream, &dest, &nbytes) < 0) {
+        qWarning("QAudioOutput(pulseaudio): pa_stream_begin_write, error = %s",
+                 pa_strerror(pa_context_errno(QPulseAudioEngine::instance()->context())));
+        return;
+    }
+    bytes = qMin(bytes, int(nbytes));
+    bytes -= bytes % m_frameSize;
+
+    const int volume = m_callbackVolume.load();
+    char *out = static_cast<char *>(dest);
+    int copied = 0;
+    while (copied < bytes) {
+        int region = 0;
+        const char *src = m_ringBuffer.readRegion(&region);
+        region = qMin(region, bytes - copied);
+        if (region <= 0)
+            break;
+
+        if (volume < 0x10000)
+            QAudioHelperInternal::qMultiplySamples(volume / qreal(0x10000), m_format, src, out + copied, region);
+        else
+            memcpy(out + copied, src, region);
+        m_ringBuffer.releaseRead(region);
+        copied += region;
+    }
+
+    if (copied <= 0) {
+        pa_stream_cancel_write(m_stream);
+        return;
+    }
+
+    if (pa_stream_write(m_stream, dest, copied, NULL, 0, PA_SEEK_RELATIVE) < 0) {
+        qWarning("QAudioOutput(pulseaudio): pa_stream_write, error = %s",
+                 pa_strerror(pa_context_errno(QPulseAudioEngine::instance()->context())));
+        return;
+    }
+
+    // Audio still queued in the ring buffer has not been processed yet
+    m_totalTimeValue.fetchAndAddRelaxed(copied);
+}
+
+qint64 QPulseAudioOutput::writeToRingBuffer(const char *data, qint64 len)
+{
+    len = qMin(len, qint64(m_ringBuffer.bytesFree()));
+    len -= len % m_frameSize;
+
+    const int written = m_ringBuffer.write(data, int(len));
+    if (written <= 0)
+        return 0;
+
+    if (m_streamStarved.testAndSetOrdered(1, 0)) {
+        QPulseAudioEngine *pulseEngine = QPulseAudioEngine::instance();
+        pulseEngine->lock();
+        fillStream(pa_stream_writable_size(m_stream));
+        pulseEngine->unlock();
+    }
+
+    setError(QAudio::NoError);
+    setState(QAudio::ActiveState);
+
+    return written;
+}
+
 void QPulseAudioOutput::streamUnderflowCallback()
 {
+    m_underflows.ref();
     if (m_deviceState != QAudio::IdleState && !m_resuming) {
         setError(QAudio::UnderrunError);
         setState(QAudio::IdleState);
@@ -282,7 +414,7 @@ bool QPulseAudioOutput::open()
     }
 
     m_spec = spec;
-    m_totalTimeValue = 0;
+    m_totalTimeValue.store(0);
 
     if (m_streamName.isNull())
         m_streamName = QString(QLatin1String("QtmPulseStream-%1-%2")).arg(::getpid()).arg(quintptr(this)).toUtf8();
@@ -312,6 +444,21 @@ bool QPulseAudioOutput::open()
     pa_stream_set_overflow_callback(m_stream, outputStreamOverflowCallback, this);
     pa_stream_set_latency_update_callback(m_stream, outputStreamLatencyCallback, this);
 
+    // The write callback may run as soon as the stream is connected
+    m_callbackMode = callbackLatency() > 0;
+    m_frameSize = pa_frame_size(&m_spec);
+    m_ringBuffer.reset(0);
+    m_streamStarved.store(0);
+    m_callbackTimer.invalidate();
+    m_callbacks.store(0);
+    m_starvedCallbacks.store(0);
+    m_underflows.store(0);
+    m_lastCallbackInterval.store(0);
+    m_maximumCallbackInterval.store(0);
+
+    if (m_bufferSize <= 0 && m_callbackMode)
+        m_bufferSize = pa_usec_to_bytes(callbackLatency() * 1000, &m_spec);
+
     if (m_bufferSize <= 0 && m_category == LOW_LATENCY_CATEGORY_NAME) {
         m_bufferSize = bytesPerSecond * LowLatencyBufferSizeMs / qint64(1000);
     }
@@ -323,7 +470,15 @@ bool QPulseAudioOutput::open()
     requestedBuffer.prebuf = (uint32_t)-1;
     requestedBuffer.tlength = m_bufferSize;
 
-    if (pa_stream_connect_playback(m_stream, m_device.data(), (m_bufferSize > 0) ? &requestedBuffer : NULL, (pa_stream_flags_t)0, NULL, NULL) < 0) {
+    // In the callback driven mode tlength is the latency of the whole chain
+    // and requests come in quarters of it.
+    int flags = 0;
+    if (m_callbackMode) {
+        requestedBuffer.minreq = m_bufferSize / 4;
+        flags = PA_STREAM_ADJUST_LATENCY | PA_STREAM_AUTO_TIMING_UPDATE;
+    }
+
+    if (pa_stream_connect_playback(m_stream, m_device.data(), (m_bufferSize > 0) ? &requestedBuffer : NULL, (pa_stream_flags_t)flags, NULL, NULL) < 0) {
         qWarning() << "pa_stream_connect_playback() failed!";
         pa_stream_unref(m_stream);
         m_stream = 0;
@@ -343,6 +498,18 @@ bool QPulseAudioOutput::open()
     m_maxBufferSize = buffer->maxlength;
     m_audioBuffer = new char[m_maxBufferSize];
 
+    if (m_callbackMode) {
+        // The tick timer only tops up the ring buffer, which holds the target
+        // latency plus two ticks. The mainloop is locked, so the write callback
+        // can't be using the ring buffer while it is resized.
+        m_periodTime = qMax(1, callbackLatency() / 2);
+        m_periodSize = pa_usec_to_bytes(m_periodTime * 1000, &m_spec);
+        int capacity = m_bufferSize + 2 * m_periodSize;
+        capacity -= capacity % m_frameSize;
+        m_ringBuffer.reset(capacity);
+        m_streamStarved.store(1);
+    }
+
     const qint64 streamSize = m_audioSource ? m_audioSource->size() : 0;
     if (m_pullMode && streamSize > 0 && static_cast<qint64>(buffer->prebuf) > streamSize) {
         pa_buffer_attr newBufferAttr;
@@ -368,6 +535,7 @@ bool QPulseAudioOutput::open()
 
     m_opened = true;
 
+    m_tickTimer->setTimerType(m_callbackMode ? Qt::PreciseTimer : Qt::CoarseTimer);
     m_tickTimer->start(m_periodTime);
 
     m_elapsedTimeOffset = 0;
@@ -395,6 +563,18 @@ void QPulseAudioOutput::close()
         pa_stream_set_overflow_callback(m_stream, 0, 0);
         pa_stream_set_latency_update_callback(m_stream, 0, 0);
 
+        if (m_callbackMode) {
+            // Hand over what is still queued before draining
+            fillStream(pa_stream_writable_size(m_stream));
+            if (qgetenv("QT_PULSEAUDIO_CALLBACK_DEBUG").toInt() > 0) {
+                const CallbackStatistics statistics = callbackStatistics();
+                qDebug() << "Write callbacks:" << statistics.callbacks
+                         << "starved:" << statistics.starvedCallbacks
+                         << "underflows:" << statistics.underflows
+                         << "maximum interval:" << statistics.maximumInterval << "usecs";
+            }
+        }
+
         pa_operation *o = pa_stream_drain(m_stream, outputStreamDrainComplete, NULL);
         if (o)
             pa_operation_unref(o);
@@ -426,7 +606,38 @@ void QPulseAudioOutput::userFeed()
 
     m_resuming = false;
 
-    if (m_pullMode) {
+    if (m_pullMode && m_callbackMode) {
+        // Read straight into the ring buffer, the write callback takes it from there
+        qint64 pulled = 0;
+        forever {
+            int length = 0;
+            char *region = m_ringBuffer.writeRegion(&length);
+            length -= length % m_frameSize;
+            if (length <= 0)
+                break;
+
+            qint64 bytes = m_audioSource->read(region, length);
+            bytes -= bytes % m_frameSize;
+            if (bytes <= 0)
+                break;
+
+            m_ringBuffer.commitWrite(int(bytes));
+            pulled += bytes;
+            if (bytes < length)
+                break;
+        }
+
+        if (pulled > 0) {
+            if (m_streamStarved.testAndSetOrdered(1, 0)) {
+                QPulseAudioEngine *pulseEngine = QPulseAudioEngine::instance();
+                pulseEngine->lock();
+                fillStream(pa_stream_writable_size(m_stream));
+                pulseEngine->unlock();
+            }
+            setError(QAudio::NoError);
+            setState(QAudio::ActiveState);
+        }
+    } else if (m_pullMode) {
         int writableSize = bytesFree();
         int chunks = writableSize / m_periodSize;
         if (chunks == 0)
@@ -467,6 +678,9 @@ void QPulseAudioOutput::userFeed()
 
 qint64 QPulseAudioOutput::write(const char *data, qint64 len)
 {
+    if (m_callbackMode)
+        return writeToRingBuffer(data, len);
+
     QPulseAudioEngine *pulseEngine = QPulseAudioEngine::instance();
 
     pulseEngine->lock();
@@ -498,7 +712,7 @@ qint64 QPulseAudioOutput::write(const char *data, qint64 len)
     }
 
     pulseEngine->unlock();
-    m_totalTimeValue += len;
+    m_totalTimeValue.fetchAndAddRelaxed(len);
 
     setError(QAudio::NoError);
     setState(QAudio::ActiveState);
@@ -522,6 +736,11 @@ int QPulseAudioOutput::bytesFree() const
     if (m_deviceState != QAudio::ActiveState && m_deviceState != QAudio::IdleState)
         return 0;
 
+    if (m_callbackMode) {
+        const int free = m_ringBuffer.bytesFree();
+        return free - free % m_frameSize;
+    }
+
     QPulseAudioEngine *pulseEngine = QPulseAudioEngine::instance();
     pulseEngine->lock();
     int writableSize = pa_stream_writable_size(m_stream);
@@ -556,7 +775,7 @@ int QPulseAudioOutput::notifyInterval() const
 
 qint64 QPulseAudioOutput::processedUSecs() const
 {
-    qint64 result = qint64(1000000) * m_totalTimeValue /
+    qint64 result = qint64(1000000) * m_totalTimeValue.load() /
         (m_format.channelCount() * (m_format.sampleSize() / 8)) /
         m_format.sampleRate();
 
@@ -582,6 +801,9 @@ void QPulseAudioOutput::resume()
 
         pulseEngine->unlock();
 
+        // Let the next write to the ring buffer restart the stream
+        if (m_callbackMode)
+            m_streamStarved.store(1);
         m_tickTimer->start(m_periodTime);
 
         setState(m_pullMode ? QAudio::ActiveState : QAudio::IdleState);
@@ -672,6 +894,7 @@ void QPulseAudioOutput::setVolume(qreal vol)
         return;
 
     m_volume = qBound(qreal(0), vol, qreal(1));
+    m_callbackVolume.store(qRound(m_volume * 0x10000));
 }
 
 qreal QPulseAudioOutput::volume() const
@@ -45,6 +45,8 @@
 // We mean it.
 //
 
+#include <QtCore/qatomic.h>
+#include <QtCore/qelapsedtimer.h>
 #include <QtCore/qfile.h>
 #include <QtCore/qtimer.h>
 #include <QtCore/qstring.h>
@@ -56,6 +58,8 @@
 #include "qaudiodeviceinfo.h"
 #include "qaudiosystem.h"
 
+#include <QtMultimedia/private/qaudioringbuffer_p.h>
+
 #include <pulse/pulseaudio.h>
 
 QT_BEGIN_NAMESPACE
@@ -94,8 +98,27 @@ public:
     void setCategory(const QString &category);
     QString category() const;
 
+    // Counters of the callback driven mode
+    struct CallbackStatistics
+    {
+        CallbackStatistics()
+            : callbacks(0), starvedCallbacks(0), underflows(0)
+            , lastInterval(0), maximumInterval(0) {}
+
+        int callbacks;
+        int starvedCallbacks;   // write requests that found the ring buffer short
+        int underflows;         // underflows reported by the server
+        int lastInterval;       // time between write requests, usecs
+        int maximumInterval;
+    };
+
+    static int callbackLatency();
+    bool isCallbackDriven() const { return m_callbackMode; }
+    CallbackStatistics callbackStatistics() const;
+
 public:
     void streamUnderflowCallback();
+    void streamWriteCallback(size_t length);
 
 private:
     void setState(QAudio::State state);
@@ -104,6 +127,8 @@ private:
     bool open();
     void close();
     qint64 write(const char *data, qint64 len);
+    qint64 writeToRingBuffer(const char *data, qint64 len);
+    void fillStream(size_t length);
 
 private Q_SLOTS:
     void userFeed();
@@ -126,7 +151,7 @@ private:
     int m_bufferSize;
     int m_maxBufferSize;
     QTime m_clockStamp;
-    qint64 m_totalTimeValue;
+    QAtomicInteger<qint64> m_totalTimeValue;   // bytes handed to the stream
     QTimer *m_tickTimer;
     char *m_audioBuffer;
     QTime m_timeStamp;
@@ -136,6 +161,20 @@ private:
 
     qreal m_volume;
     pa_sample_spec m_spec;
+
+    // Callback driven mode: the stream's write callback pulls from the ring
+    // buffer on the PulseAudio mainloop thread, the tick timer fills it.
+    bool m_callbackMode;
+    int m_frameSize;
+    QAudioRingBuffer m_ringBuffer;
+    QElapsedTimer m_callbackTimer;
+    QAtomicInt m_callbackVolume;    // 1/65536 units
+    QAtomicInt m_streamStarved;     // the last write request was not fully served
+    QAtomicInt m_callbacks;
+    QAtomicInt m_starvedCallbacks;
+    QAtomicInt m_underflows;
+    QAtomicInt m_lastCallbackInterval;
+    QAtomicInt m_maximumCallbackInterval;
 };
 
 class PulseOutputPrivate : public QIODevice
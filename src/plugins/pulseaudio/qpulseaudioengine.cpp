@@ -76,10 +76,15 @@ static void serverInfoCallback(pa_context *context, const pa_server_info *info,
 
     QPulseAudioEngine *pulseEngine = static_cast<QPulseAudioEngine*>(userdata);
     pulseEngine->m_serverLock.lockForWrite();
+    const bool changed = pulseEngine->m_defaultSink != info->default_sink_name
+            || pulseEngine->m_defaultSource != info->default_source_name;
     pulseEngine->m_defaultSink = info->default_sink_name;
     pulseEngine->m_defaultSource = info->default_source_name;
     pulseEngine->m_serverLock.unlock();
 
+    if (changed)
+        emit pulseEngine->availableDevicesChanged();
+
     pa_threaded_mainloop_signal(pulseEngine->mainloop(), 0);
 }
 
@@ -118,9 +123,14 @@ static void sinkInfoCallback(pa_context *context, const pa_sink_info *info, int
 
     QAudioFormat format = QPulseAudioInternal::sampleSpecToAudioFormat(info->sample_spec);
 
-    QWriteLocker locker(&pulseEngine->m_sinkLock);
+    pulseEngine->m_sinkLock.lockForWrite();
+    const bool added = pulseEngine->m_sinks.value(info->index) != info->name;
     pulseEngine->m_preferredFormats.insert(info->name, format);
     pulseEngine->m_sinks.insert(info->index, info->name);
+    pulseEngine->m_sinkLock.unlock();
+
+    if (added)
+        emit pulseEngine->availableDevicesChanged();
 }
 
 static void sourceInfoCallback(pa_context *context, const pa_source_info *info, int isLast, void *userdata)
@@ -154,9 +164,14 @@ static void sourceInfoCallback(pa_context *context, const pa_source_info *info,
 
     QAudioFormat format = QPulseAudioInternal::sampleSpecToAudioFormat(info->sample_spec);
 
-    QWriteLocker locker(&pulseEngine->m_sourceLock);
+    pulseEngine->m_sourceLock.lockForWrite();
+    const bool added = pulseEngine->m_sources.value(info->index) != info->name;
     pulseEngine->m_preferredFormats.insert(info->name, format);
     pulseEngine->m_sources.insert(info->index, info->name);
+    pulseEngine->m_sourceLock.unlock();
+
+    if (added)
+        emit pulseEngine->availableDevicesChanged();
 }
 
 static void event_cb(pa_context* context, pa_subscription_event_type_t t, uint32_t index, void* userdata)
@@ -200,18 +215,24 @@ static void event_cb(pa_context* context, pa_subscription_event_type_t t, uint32
         break;
     case PA_SUBSCRIPTION_EVENT_REMOVE:
         switch (facility) {
-        case PA_SUBSCRIPTION_EVENT_SINK:
+        case PA_SUBSCRIPTION_EVENT_SINK: {
             pulseEngine->m_sinkLock.lockForWrite();
             pulseEngine->m_preferredFormats.remove(pulseEngine->m_sinks.value(index));
-            pulseEngine->m_sinks.remove(index);
+            const bool removed = pulseEngine->m_sinks.remove(index) > 0;
             pulseEngine->m_sinkLock.unlock();
+            if (removed)
+                emit pulseEngine->availableDevicesChanged();
             break;
-        case PA_SUBSCRIPTION_EVENT_SOURCE:
+        }
+        case PA_SUBSCRIPTION_EVENT_SOURCE: {
             pulseEngine->m_sourceLock.lockForWrite();
             pulseEngine->m_preferredFormats.remove(pulseEngine->m_sources.value(index));
-            pulseEngine->m_sources.remove(index);
+            const bool removed = pulseEngine->m_sources.remove(index) > 0;
             pulseEngine->m_sourceLock.unlock();
+            if (removed)
+                emit pulseEngine->availableDevicesChanged();
             break;
+        }
         default:
             break;
         }
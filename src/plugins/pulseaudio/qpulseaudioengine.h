@@ -89,6 +89,9 @@ public:
 
 Q_SIGNALS:
     void contextFailed();
+    // Emitted from the PulseAudio main loop thread whenever a sink or
+    // source appears or disappears or the default devices change.
+    void availableDevicesChanged();
 
 private Q_SLOTS:
     void prepare();
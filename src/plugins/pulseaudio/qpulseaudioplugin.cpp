@@ -45,6 +45,8 @@ QPulseAudioPlugin::QPulseAudioPlugin(QObject *parent)
     : QAudioSystemPlugin(parent)
     , m_pulseEngine(QPulseAudioEngine::instance())
 {
+    connect(m_pulseEngine, &QPulseAudioEngine::availableDevicesChanged,
+            this, &QPulseAudioPlugin::availableDevicesChanged, Qt::DirectConnection);
 }
 
 QList<QByteArray> QPulseAudioPlugin::availableDevices(QAudio::Mode mode) const
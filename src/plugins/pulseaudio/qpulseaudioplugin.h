@@ -55,6 +55,9 @@ public:
     QAbstractAudioOutput *createOutput(const QByteArray &device);
     QAbstractAudioDeviceInfo *createDeviceInfo(const QByteArray &device, QAudio::Mode mode);
 
+Q_SIGNALS:
+    void availableDevicesChanged();
+
 private:
     QPulseAudioEngine *m_pulseEngine;
 };
@@ -55,7 +55,8 @@ Q_GLOBAL_STATIC_WITH_ARGS(QMediaPluginLoader, videoNodeFactoryLoader,
 QDeclarativeVideoRendererBackend::QDeclarativeVideoRendererBackend(QDeclarativeVideoOutput *parent)
     : QDeclarativeVideoBackend(parent),
       m_glContext(0),
-      m_frameChanged(false)
+      m_frameChanged(false),
+      m_filterPipeline(parent)
 {
     m_surface = new QSGVideoItemSurface(this);
     QObject::connect(m_surface, SIGNAL(surfaceFormatChanged(QVideoSurfaceFormat)),
@@ -133,6 +134,9 @@ private:
 
 void QDeclarativeVideoRendererBackend::scheduleDeleteFilterResources()
 {
+    // Make sure no worker thread is still running one of the runnables
+    m_filterPipeline.setStages(QVector<QVideoFilterPipeline::Stage>());
+
     if (!q->window())
         return;
 
@@ -163,6 +167,7 @@ void QDeclarativeVideoRendererBackend::invalidateSceneGraph()
 {
     // Called on the render thread, e.g. when the context is lost.
     QMutexLocker lock(&m_frameMutex);
+    m_filterPipeline.setStages(QVector<QVideoFilterPipeline::Stage>());
     for (int i = 0; i < m_filters.count(); ++i) {
         if (m_filters[i].runnable) {
             delete m_filters[i].runnable;
@@ -263,6 +268,30 @@ void QDeclarativeVideoRendererBackend::updateGeometry()
     }
 }
 
+// Called on the render thread, with the gui thread blocked
+void QDeclarativeVideoRendererBackend::updateFilterPipeline()
+{
+    QVector<QVideoFilterPipeline::Stage> stages;
+    for (int i = 0; i < m_filters.count(); ++i) {
+        QAbstractVideoFilter *filter = m_filters[i].filter;
+        QVideoFilterRunnable *&runnable = m_filters[i].runnable;
+        if (!filter || !filter->isActive())
+            continue;
+        if (!runnable)
+            runnable = filter->createFilterRunnable();
+        if (!runnable)
+            continue;
+
+        QVideoFilterRunnable::RunFlags flags = 0;
+        if (i == m_filters.count() - 1)
+            flags |= QVideoFilterRunnable::LastInChain;
+        stages.append(QVideoFilterPipeline::Stage(runnable, filter->requiresRenderThread(), flags));
+    }
+
+    if (stages != m_filterPipeline.stages())
+        m_filterPipeline.setStages(stages);
+}
+
 QSGNode *QDeclarativeVideoRendererBackend::updatePaintNode(QSGNode *oldNode,
                                                            QQuickItem::UpdatePaintNodeData *data)
 {
@@ -284,9 +313,48 @@ QSGNode *QDeclarativeVideoRendererBackend::updatePaintNode(QSGNode *oldNode,
     }
 
     bool isFrameModified = false;
+    bool isFramePipelined = false;
+    if (m_filterPipeline.maxFramesInFlight() > 0 && !m_filters.isEmpty()) {
+        // Filters run asynchronously, frames are rendered once they went through all of them.
+        isFramePipelined = true;
+        updateFilterPipeline();
+
+        if (m_frameChanged) {
+            if (!m_frame.isValid()) {
+                m_filterPipeline.clear();
+            } else if (!m_filterPipeline.stages().isEmpty()) {
+                m_filterPipeline.submit(m_frame, videoSurface()->surfaceFormat());
+                m_frameChanged = false;
+                m_frame = QVideoFrame();
+            }
+        }
+
+        m_filterPipeline.runRenderThreadStages();
+
+        QVideoFrame filteredFrame;
+        if (m_filterPipeline.takeFinishedFrame(&filteredFrame, &isFrameModified)) {
+            m_frame = filteredFrame;
+            m_frameChanged = true;
+
+            const int finished = m_filterPipeline.finishedFrameCount();
+            if (finished % 100 == 0 && qLcVideo().isDebugEnabled()) {
+                const QVector<QVideoFilterPipeline::Stage> stages = m_filterPipeline.stages();
+                for (int i = 0; i < stages.count(); ++i) {
+                    qCDebug(qLcVideo) << "filter stage" << i
+                                      << (stages.at(i).renderThread ? "(render thread)" : "(worker thread)")
+                                      << "average run time" << m_filterPipeline.averageStageLatency(i) << "us"
+                                      << "last" << m_filterPipeline.lastStageLatency(i) << "us";
+                }
+                qCDebug(qLcVideo) << "filter pipeline: frames" << finished
+                                  << "dropped" << m_filterPipeline.droppedFrameCount()
+                                  << "average latency" << m_filterPipeline.averageFrameLatency() << "us";
+            }
+        }
+    }
+
     if (m_frameChanged) {
         // Run the VideoFilter if there is one. This must be done before potentially changing the videonode below.
-        if (m_frame.isValid() && !m_filters.isEmpty()) {
+        if (!isFramePipelined && m_frame.isValid() && !m_filters.isEmpty()) {
             const QVideoSurfaceFormat surfaceFormat = videoSurface()->surfaceFormat();
             for (int i = 0; i < m_filters.count(); ++i) {
                 QAbstractVideoFilter *filter = m_filters[i].filter;
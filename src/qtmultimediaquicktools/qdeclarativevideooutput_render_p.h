@@ -50,6 +50,7 @@
 #include <private/qsgvideonode_yuv_p.h>
 #include <private/qsgvideonode_rgb_p.h>
 #include <private/qsgvideonode_texture_p.h>
+#include <private/qvideofilterpipeline_p.h>
 
 #include <QtCore/qmutex.h>
 #include <QtMultimedia/qabstractvideosurface.h>
@@ -90,6 +91,7 @@ public:
 
 private:
     void scheduleDeleteFilterResources();
+    void updateFilterPipeline();
 
     QPointer<QVideoRendererControl> m_rendererControl;
     QList<QSGVideoNodeFactoryInterface*> m_videoNodeFactories;
@@ -111,6 +113,7 @@ private:
         QVideoFilterRunnable *runnable;
     };
     QList<Filter> m_filters;
+    QVideoFilterPipeline m_filterPipeline;
 };
 
 class QSGVideoItemSurface : public QAbstractVideoSurface
@@ -31,6 +31,7 @@
 **
 ****************************************************************************/
 #include "qsgvideonode_rgb_p.h"
+#include <private/qsgvideotextureuploader_p.h>
 #include <QtQuick/qsgtexturematerial.h>
 #include <QtQuick/qsgmaterial.h>
 #include <QtCore/qmutex.h>
@@ -120,19 +121,12 @@ class QSGVideoMaterial_RGB : public QSGMaterial
 public:
     QSGVideoMaterial_RGB(const QVideoSurfaceFormat &format) :
         m_format(format),
-        m_textureId(0),
         m_opacity(1.0),
         m_width(1.0)
     {
         setFlag(Blending, false);
     }
 
-    ~QSGVideoMaterial_RGB()
-    {
-        if (m_textureId)
-            QOpenGLContext::currentContext()->functions()->glDeleteTextures(1, &m_textureId);
-    }
-
     virtual QSGMaterialType *type() const {
         static QSGMaterialType normalType, swizzleType;
         return needsSwizzling() ? &swizzleType : &normalType;
@@ -146,10 +140,10 @@ public:
     virtual int compare(const QSGMaterial *other) const {
         const QSGVideoMaterial_RGB *m = static_cast<const QSGVideoMaterial_RGB *>(other);
 
-        if (!m_textureId)
+        if (!m_uploader.textureId(0))
             return 1;
 
-        return m_textureId - m->m_textureId;
+        return m_uploader.textureId(0) - m->m_uploader.textureId(0);
     }
 
     void updateBlending() {
@@ -182,15 +176,8 @@ public:
                 m_width = qreal(m_frame.width()) / stride;
                 textureSize.setWidth(stride);
 
-                if (m_textureSize != textureSize) {
-                    if (!m_textureSize.isEmpty())
-                        functions->glDeleteTextures(1, &m_textureId);
-                    functions->glGenTextures(1, &m_textureId);
-                    m_textureSize = textureSize;
-                }
-
-                GLint dataType = GL_UNSIGNED_BYTE;
-                GLint dataFormat = GL_RGBA;
+                GLenum dataType = GL_UNSIGNED_BYTE;
+                GLenum dataFormat = GL_RGBA;
 
                 if (m_frame.pixelFormat() == QVideoFrame::Format_RGB565) {
                     dataType = GL_UNSIGNED_SHORT_5_6_5;
@@ -202,32 +189,26 @@ public:
                 functions->glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
 
                 functions->glActiveTexture(GL_TEXTURE0);
-                functions->glBindTexture(GL_TEXTURE_2D, m_textureId);
-                functions->glTexImage2D(GL_TEXTURE_2D, 0, dataFormat,
-                                        m_textureSize.width(), m_textureSize.height(),
-                                        0, dataFormat, dataType, m_frame.bits());
+                m_uploader.beginFrame();
+                m_uploader.uploadPlane(0, textureSize.width(), textureSize.height(),
+                                       dataFormat, dataType, m_frame.bits());
+                m_uploader.endFrame();
 
                 functions->glPixelStorei(GL_UNPACK_ALIGNMENT, previousAlignment);
 
-                functions->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-                functions->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-                functions->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-                functions->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-
                 m_frame.unmap();
             }
             m_frame = QVideoFrame();
         } else {
             functions->glActiveTexture(GL_TEXTURE0);
-            functions->glBindTexture(GL_TEXTURE_2D, m_textureId);
+            functions->glBindTexture(GL_TEXTURE_2D, m_uploader.textureId(0));
         }
     }
 
     QVideoFrame m_frame;
     QMutex m_frameMutex;
-    QSize m_textureSize;
     QVideoSurfaceFormat m_format;
-    GLuint m_textureId;
+    QSGVideoTextureUploader m_uploader;
     qreal m_opacity;
     GLfloat m_width;
 
@@ -31,6 +31,7 @@
 **
 ****************************************************************************/
 #include "qsgvideonode_yuv_p.h"
+#include <private/qsgvideotextureuploader_p.h>
 #include <QtCore/qmutex.h>
 #include <QtQuick/qsgtexturematerial.h>
 #include <QtQuick/qsgmaterial.h>
@@ -171,16 +172,16 @@ public:
 
     virtual int compare(const QSGMaterial *other) const {
         const QSGVideoMaterial_YUV *m = static_cast<const QSGVideoMaterial_YUV *>(other);
-        if (!m_textureIds[0])
+        if (!m_uploader.textureId(0))
             return 1;
 
-        int d = m_textureIds[0] - m->m_textureIds[0];
+        int d = m_uploader.textureId(0) - m->m_uploader.textureId(0);
         if (d)
             return d;
-        else if ((d = m_textureIds[1] - m->m_textureIds[1]) != 0)
+        else if ((d = m_uploader.textureId(1) - m->m_uploader.textureId(1)) != 0)
             return d;
         else
-            return m_textureIds[2] - m->m_textureIds[2];
+            return m_uploader.textureId(2) - m->m_uploader.textureId(2);
     }
 
     void updateBlending() {
@@ -193,13 +194,11 @@ public:
     }
 
     void bind();
-    void bindTexture(int id, int w, int h, const uchar *bits, GLenum format);
 
     QVideoSurfaceFormat m_format;
-    QSize m_textureSize;
     int m_planeCount;
 
-    GLuint m_textureIds[3];
+    QSGVideoTextureUploader m_uploader;
     GLfloat m_planeWidth[3];
 
     qreal m_opacity;
@@ -213,8 +212,6 @@ QSGVideoMaterial_YUV::QSGVideoMaterial_YUV(const QVideoSurfaceFormat &format) :
     m_format(format),
     m_opacity(1.0)
 {
-    memset(m_textureIds, 0, sizeof(m_textureIds));
-
     switch (format.pixelFormat()) {
     case QVideoFrame::Format_NV12:
     case QVideoFrame::Format_NV21:
@@ -258,12 +255,6 @@ QSGVideoMaterial_YUV::QSGVideoMaterial_YUV(const QVideoSurfaceFormat &format) :
 
 QSGVideoMaterial_YUV::~QSGVideoMaterial_YUV()
 {
-    if (!m_textureSize.isEmpty()) {
-        if (QOpenGLContext *current = QOpenGLContext::currentContext())
-            current->functions()->glDeleteTextures(m_planeCount, m_textureIds);
-        else
-            qWarning() << "QSGVideoMaterial_YUV: Cannot obtain GL context, unable to delete textures";
-    }
 }
 
 void QSGVideoMaterial_YUV::bind()
@@ -275,13 +266,7 @@ void QSGVideoMaterial_YUV::bind()
             int fw = m_frame.width();
             int fh = m_frame.height();
 
-            // Frame has changed size, recreate textures...
-            if (m_textureSize != m_frame.size()) {
-                if (!m_textureSize.isEmpty())
-                    functions->glDeleteTextures(m_planeCount, m_textureIds);
-                functions->glGenTextures(m_planeCount, m_textureIds);
-                m_textureSize = m_frame.size();
-            }
+            m_uploader.beginFrame();
 
             GLint previousAlignment;
             functions->glGetIntegerv(GL_UNPACK_ALIGNMENT, &previousAlignment);
@@ -295,9 +280,9 @@ void QSGVideoMaterial_YUV::bind()
                 m_planeWidth[0] = m_planeWidth[1] = qreal(fw) / m_frame.bytesPerLine(y);
 
                 functions->glActiveTexture(GL_TEXTURE1);
-                bindTexture(m_textureIds[1], m_frame.bytesPerLine(uv) / 2, fh / 2, m_frame.bits(uv), GL_LUMINANCE_ALPHA);
+                m_uploader.uploadPlane(1, m_frame.bytesPerLine(uv) / 2, fh / 2, GL_LUMINANCE_ALPHA, GL_UNSIGNED_BYTE, m_frame.bits(uv));
                 functions->glActiveTexture(GL_TEXTURE0); // Finish with 0 as default texture unit
-                bindTexture(m_textureIds[0], m_frame.bytesPerLine(y), fh, m_frame.bits(y), GL_LUMINANCE);
+                m_uploader.uploadPlane(0, m_frame.bytesPerLine(y), fh, GL_LUMINANCE, GL_UNSIGNED_BYTE, m_frame.bits(y));
 
             } else { // YUV420P || YV12
                 const int y = 0;
@@ -308,14 +293,15 @@ void QSGVideoMaterial_YUV::bind()
                 m_planeWidth[1] = m_planeWidth[2] = qreal(fw) / (2 * m_frame.bytesPerLine(u));
 
                 functions->glActiveTexture(GL_TEXTURE1);
-                bindTexture(m_textureIds[1], m_frame.bytesPerLine(u), fh / 2, m_frame.bits(u), GL_LUMINANCE);
+                m_uploader.uploadPlane(1, m_frame.bytesPerLine(u), fh / 2, GL_LUMINANCE, GL_UNSIGNED_BYTE, m_frame.bits(u));
                 functions->glActiveTexture(GL_TEXTURE2);
-                bindTexture(m_textureIds[2], m_frame.bytesPerLine(v), fh / 2, m_frame.bits(v), GL_LUMINANCE);
+                m_uploader.uploadPlane(2, m_frame.bytesPerLine(v), fh / 2, GL_LUMINANCE, GL_UNSIGNED_BYTE, m_frame.bits(v));
                 functions->glActiveTexture(GL_TEXTURE0); // Finish with 0 as default texture unit
-                bindTexture(m_textureIds[0], m_frame.bytesPerLine(y), fh, m_frame.bits(y), GL_LUMINANCE);
+                m_uploader.uploadPlane(0, m_frame.bytesPerLine(y), fh, GL_LUMINANCE, GL_UNSIGNED_BYTE, m_frame.bits(y));
             }
 
             functions->glPixelStorei(GL_UNPACK_ALIGNMENT, previousAlignment);
+            m_uploader.endFrame();
             m_frame.unmap();
         }
 
@@ -324,23 +310,11 @@ void QSGVideoMaterial_YUV::bind()
         // Go backwards to finish with GL_TEXTURE0
         for (int i = m_planeCount - 1; i >= 0; --i) {
             functions->glActiveTexture(GL_TEXTURE0 + i);
-            functions->glBindTexture(GL_TEXTURE_2D, m_textureIds[i]);
+            functions->glBindTexture(GL_TEXTURE_2D, m_uploader.textureId(i));
         }
     }
 }
 
-void QSGVideoMaterial_YUV::bindTexture(int id, int w, int h, const uchar *bits, GLenum format)
-{
-    QOpenGLFunctions *functions = QOpenGLContext::currentContext()->functions();
-
-    functions->glBindTexture(GL_TEXTURE_2D, id);
-    functions->glTexImage2D(GL_TEXTURE_2D, 0, format, w, h, 0, format, GL_UNSIGNED_BYTE, bits);
-    functions->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    functions->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    functions->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    functions->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-}
-
 QSGVideoNode_YUV::QSGVideoNode_YUV(const QVideoSurfaceFormat &format) :
     m_format(format)
 {
@@ -0,0 +1,252 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#include "qsgvideotextureuploader_p.h"
+
+#include <QtCore/qdebug.h>
+#include <QtGui/qopenglcontext.h>
+
+#include <string.h>
+
+QT_BEGIN_NAMESPACE
+
+static int bytesPerPixel(GLenum format, GLenum type)
+{
+    if (type == GL_UNSIGNED_SHORT_5_6_5)
+        return 2;
+
+    switch (format) {
+    case GL_LUMINANCE:
+    case GL_ALPHA:
+        return 1;
+    case GL_LUMINANCE_ALPHA:
+        return 2;
+    case GL_RGB:
+        return 3;
+    default:
+        return 4;
+    }
+}
+
+/*!
+    \class QSGVideoTextureUploader
+    \internal
+
+    Streams video frame planes into textures. Texture storage is only
+    (re)allocated when the size or format of a plane changes, every other
+    frame is uploaded with glTexSubImage2D().
+
+    In PixelBufferUpload mode the data is first copied into one of two
+    alternating pixel unpack buffers, so that the copy does not have to wait
+    for the transfer of the previous frame. The mode falls back to
+    DirectUpload on contexts without pixel buffer objects, such as OpenGL ES 2.
+*/
+
+QSGVideoTextureUploader::QSGVideoTextureUploader()
+    : m_uploadMode(defaultUploadMode())
+    , m_pixelBuffersChecked(false)
+    , m_reportTimes(qEnvironmentVariableIsSet("QT_QUICK_VIDEO_UPLOAD_TIMES"))
+    , m_frameCount(0)
+    , m_lastUploadTime(0)
+    , m_totalUploadTime(0)
+{
+    for (int i = 0; i < MaxPlaneCount; ++i) {
+        m_planes[i].pixelBuffers[0] = QOpenGLBuffer(QOpenGLBuffer::PixelUnpackBuffer);
+        m_planes[i].pixelBuffers[1] = QOpenGLBuffer(QOpenGLBuffer::PixelUnpackBuffer);
+    }
+}
+
+QSGVideoTextureUploader::~QSGVideoTextureUploader()
+{
+    if (QOpenGLContext::currentContext())
+        releaseResources();
+    else if (m_planes[0].textureId)
+        qWarning() << "QSGVideoTextureUploader: Cannot obtain GL context, unable to delete textures";
+}
+
+/*!
+    Returns PixelBufferUpload if the QT_QUICK_VIDEO_PBO environment variable
+    is set to a non-zero value, and DirectUpload otherwise.
+*/
+QSGVideoTextureUploader::UploadMode QSGVideoTextureUploader::defaultUploadMode()
+{
+    static const int usePixelBuffers = qgetenv("QT_QUICK_VIDEO_PBO").toInt();
+    return usePixelBuffers ? PixelBufferUpload : DirectUpload;
+}
+
+bool QSGVideoTextureUploader::isPixelBufferUploadSupported(QOpenGLContext *context)
+{
+    if (!context)
+        return false;
+
+    const QSurfaceFormat format = context->format();
+    if (format.renderableType() == QSurfaceFormat::OpenGLES)
+        return format.majorVersion() >= 3;
+
+    return format.version() >= qMakePair(2, 1)
+            || context->hasExtension("GL_ARB_pixel_buffer_object");
+}
+
+void QSGVideoTextureUploader::setUploadMode(UploadMode mode)
+{
+    if (m_uploadMode == mode)
+        return;
+
+    m_uploadMode = mode;
+    m_pixelBuffersChecked = false;
+}
+
+void QSGVideoTextureUploader::beginFrame()
+{
+    if (m_uploadMode == PixelBufferUpload && !m_pixelBuffersChecked) {
+        m_pixelBuffersChecked = true;
+        if (!isPixelBufferUploadSupported(QOpenGLContext::currentContext())) {
+            qWarning() << "QSGVideoTextureUploader: Pixel buffer objects are not supported, using direct texture uploads";
+            m_uploadMode = DirectUpload;
+        }
+    }
+
+    m_timer.start();
+}
+
+/*!
+    Uploads \a width x \a height tightly packed pixels of \a bits to the
+    texture of \a plane, which is left bound to the active texture unit.
+*/
+void QSGVideoTextureUploader::uploadPlane(int plane, int width, int height,
+                                          GLenum format, GLenum type, const uchar *bits)
+{
+    Q_ASSERT(plane >= 0 && plane < MaxPlaneCount);
+
+    QOpenGLFunctions *functions = QOpenGLContext::currentContext()->functions();
+    Plane &p = m_planes[plane];
+
+    if (!p.textureId)
+        functions->glGenTextures(1, &p.textureId);
+    functions->glBindTexture(GL_TEXTURE_2D, p.textureId);
+
+    if (p.size != QSize(width, height) || p.format != format || p.type != type)
+        allocateTexture(functions, p, width, height, format, type);
+
+    if (m_uploadMode == PixelBufferUpload && uploadThroughPixelBuffer(functions, p, width, height, bits))
+        return;
+
+    functions->glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, format, type, bits);
+}
+
+void QSGVideoTextureUploader::endFrame()
+{
+    m_lastUploadTime = m_timer.nsecsElapsed();
+    m_totalUploadTime += m_lastUploadTime;
+    ++m_frameCount;
+
+    if (m_reportTimes) {
+        qDebug("QSGVideoTextureUploader: frame %d uploaded in %lld us (average %lld us, %s)",
+               m_frameCount, m_lastUploadTime / 1000, averageUploadTime() / 1000,
+               m_uploadMode == PixelBufferUpload ? "pixel buffers" : "direct");
+    }
+}
+
+/*!
+    Returns the average time in nanoseconds spent uploading a frame.
+    This is the time spent on the CPU, the transfers themselves may
+    complete asynchronously.
+*/
+qint64 QSGVideoTextureUploader::averageUploadTime() const
+{
+    return m_frameCount > 0 ? m_totalUploadTime / m_frameCount : 0;
+}
+
+/*!
+    Deletes the textures and pixel buffers, the context they were created
+    in must be current.
+*/
+void QSGVideoTextureUploader::releaseResources()
+{
+    QOpenGLFunctions *functions = QOpenGLContext::currentContext()->functions();
+
+    for (int i = 0; i < MaxPlaneCount; ++i) {
+        Plane &p = m_planes[i];
+        if (p.textureId)
+            functions->glDeleteTextures(1, &p.textureId);
+        p.textureId = 0;
+        p.size = QSize();
+        p.pixelBuffers[0].destroy();
+        p.pixelBuffers[1].destroy();
+    }
+}
+
+void QSGVideoTextureUploader::allocateTexture(QOpenGLFunctions *functions, Plane &plane,
+                                              int width, int height, GLenum format, GLenum type)
+{
+    functions->glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, type, 0);
+    functions->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    functions->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    functions->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    functions->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    plane.size = QSize(width, height);
+    plane.format = format;
+    plane.type = type;
+}
+
+bool QSGVideoTextureUploader::uploadThroughPixelBuffer(QOpenGLFunctions *functions, Plane &plane,
+                                                       int width, int height, const uchar *bits)
+{
+    QOpenGLBuffer &buffer = plane.pixelBuffers[m_frameCount & 1];
+    if (!buffer.isCreated() && !buffer.create())
+        return false;
+
+    const int size = width * height * bytesPerPixel(plane.format, plane.type);
+
+    buffer.bind();
+    // Orphan the previous storage rather than waiting for it to be consumed
+    buffer.setUsagePattern(QOpenGLBuffer::StreamDraw);
+    buffer.allocate(size);
+
+    if (void *data = buffer.map(QOpenGLBuffer::WriteOnly)) {
+        memcpy(data, bits, size);
+        buffer.unmap();
+    } else {
+        // glMapBuffer() is not available on OpenGL ES 3
+        buffer.write(0, bits, size);
+    }
+
+    functions->glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, plane.format, plane.type, 0);
+    buffer.release();
+
+    return true;
+}
+
+QT_END_NAMESPACE
@@ -12,7 +12,9 @@ PRIVATE_HEADERS += \
     qdeclarativevideooutput_p.h \
     qdeclarativevideooutput_backend_p.h \
     qsgvideonode_p.h \
-    qtmultimediaquickdefs_p.h
+    qsgvideotextureuploader_p.h \
+    qtmultimediaquickdefs_p.h \
+    qvideofilterpipeline_p.h
 
 HEADERS += \
     $$PRIVATE_HEADERS \
@@ -24,6 +26,8 @@ HEADERS += \
 
 SOURCES += \
     qsgvideonode_p.cpp \
+    qsgvideotextureuploader.cpp \
+    qvideofilterpipeline.cpp \
     qdeclarativevideooutput.cpp \
     qdeclarativevideooutput_render.cpp \
     qdeclarativevideooutput_window.cpp \
@@ -0,0 +1,411 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#include "qvideofilterpipeline_p.h"
+
+#include <private/qvideobufferpool_p.h>
+
+#include <QtCore/qrunnable.h>
+
+QT_BEGIN_NAMESPACE
+
+/*!
+    \class QVideoFilterPipeline
+    \internal
+
+    Runs the filter runnables of a VideoOutput as a pipeline. Each runnable is
+    one stage, and a frame passes through the stages in order. Stages whose
+    filter does not require the render thread run on worker threads, the others
+    run when the render thread calls runRenderThreadStages(). Every stage handles
+    one frame at a time in submission order, so frames leave the pipeline in the
+    order they were presented while different stages work on different frames
+    concurrently.
+
+    At most maxFramesInFlight() frames are in the pipeline at once, frames
+    submitted beyond that are dropped. The update target is asked to update()
+    whenever a frame is waiting for the render thread.
+
+    When copiesFrames() is set, system memory frames are copied into buffers
+    from QVideoBufferPool on submission, so that frames in flight don't hold
+    on to the buffers of the media backend.
+*/
+
+class QVideoFilterPipeline::StageWorker : public QRunnable
+{
+public:
+    StageWorker(QVideoFilterPipeline *pipeline, int stage)
+        : m_pipeline(pipeline), m_stage(stage) { }
+
+    void run() Q_DECL_OVERRIDE
+    {
+        m_pipeline->drainStage(m_stage);
+    }
+
+private:
+    QVideoFilterPipeline *m_pipeline;
+    int m_stage;
+};
+
+QVideoFilterPipeline::QVideoFilterPipeline(QObject *updateTarget)
+    : m_updateTarget(updateTarget)
+    , m_maxFramesInFlight(defaultMaxFramesInFlight())
+    , m_framesInFlight(0)
+    , m_finishedFrames(0)
+    , m_droppedFrames(0)
+    , m_totalFrameLatency(0)
+    , m_clearing(false)
+    , m_copyFrames(defaultCopiesFrames())
+{
+    m_threadPool.setExpiryTimeout(-1);
+}
+
+QVideoFilterPipeline::~QVideoFilterPipeline()
+{
+    clear();
+    m_threadPool.waitForDone();
+}
+
+/*!
+    Returns the pipeline depth requested with the QT_QUICK_VIDEO_ASYNC_FILTERS
+    environment variable, 0 when filters run synchronously.
+*/
+int QVideoFilterPipeline::defaultMaxFramesInFlight()
+{
+    static int frames = -1;
+    if (frames < 0)
+        frames = qMax(0, qgetenv("QT_QUICK_VIDEO_ASYNC_FILTERS").toInt());
+    return frames;
+}
+
+/*!
+    Returns whether frames are copied into pooled buffers on submission, as
+    requested with the QT_QUICK_VIDEO_ASYNC_FILTERS_COPY environment variable.
+*/
+bool QVideoFilterPipeline::defaultCopiesFrames()
+{
+    static int copy = -1;
+    if (copy < 0)
+        copy = qgetenv("QT_QUICK_VIDEO_ASYNC_FILTERS_COPY").toInt() > 0 ? 1 : 0;
+    return copy;
+}
+
+int QVideoFilterPipeline::maxFramesInFlight() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_maxFramesInFlight;
+}
+
+void QVideoFilterPipeline::setMaxFramesInFlight(int count)
+{
+    QMutexLocker locker(&m_mutex);
+    m_maxFramesInFlight = qMax(0, count);
+}
+
+bool QVideoFilterPipeline::copiesFrames() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_copyFrames;
+}
+
+void QVideoFilterPipeline::setCopiesFrames(bool copy)
+{
+    QMutexLocker locker(&m_mutex);
+    m_copyFrames = copy;
+}
+
+QVector<QVideoFilterPipeline::Stage> QVideoFilterPipeline::stages() const
+{
+    QMutexLocker locker(&m_mutex);
+    QVector<Stage> stages;
+    stages.reserve(m_stages.size());
+    for (int i = 0; i < m_stages.size(); ++i)
+        stages.append(m_stages.at(i).stage);
+    return stages;
+}
+
+/*!
+    Replaces the stages, dropping the frames in flight. Returns once no
+    worker thread uses the previous runnables anymore.
+*/
+void QVideoFilterPipeline::setStages(const QVector<Stage> &stages)
+{
+    clear();
+
+    QMutexLocker locker(&m_mutex);
+    m_stages.clear();
+    m_stages.resize(stages.size());
+    int workerStages = 0;
+    for (int i = 0; i < stages.size(); ++i) {
+        m_stages[i].stage = stages.at(i);
+        if (!stages.at(i).renderThread)
+            ++workerStages;
+    }
+    // Stages are serial, so one thread per worker stage is all that can be used
+    m_threadPool.setMaxThreadCount(qMax(1, workerStages));
+}
+
+/*!
+    Queues \a frame for the first stage. Returns false when the frame is
+    dropped because the pipeline is full or has no stages.
+*/
+bool QVideoFilterPipeline::submit(const QVideoFrame &frame, const QVideoSurfaceFormat &surfaceFormat)
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_stages.isEmpty())
+        return false;
+
+    if (m_framesInFlight >= m_maxFramesInFlight) {
+        ++m_droppedFrames;
+        return false;
+    }
+
+    QVideoFrame input(frame);
+    if (m_copyFrames && frame.handleType() == QAbstractVideoBuffer::NoHandle) {
+        // Copy without blocking the workers, then check again for room
+        locker.unlock();
+        const QVideoFrame copy = QVideoBufferPool::instance()->copyFrame(frame);
+        if (copy.isValid())
+            input = copy;
+        locker.relock();
+
+        if (m_stages.isEmpty())
+            return false;
+        if (m_framesInFlight >= m_maxFramesInFlight) {
+            ++m_droppedFrames;
+            return false;
+        }
+    }
+
+    Job *job = new Job;
+    job->frame = input;
+    job->surfaceFormat = surfaceFormat;
+    job->timer.start();
+    ++m_framesInFlight;
+    advance(job);
+    return true;
+}
+
+/*!
+    Runs the stages that need the render thread on all frames waiting for them.
+    Must be called on the render thread with the OpenGL context bound.
+*/
+void QVideoFilterPipeline::runRenderThreadStages()
+{
+    QMutexLocker locker(&m_mutex);
+    bool ran = true;
+    while (ran) {
+        ran = false;
+        for (int i = 0; i < m_stages.size(); ++i) {
+            if (!m_stages.at(i).stage.renderThread)
+                continue;
+            while (!m_stages.at(i).queue.isEmpty()) {
+                runStage(i, &locker);
+                ran = true;
+            }
+        }
+    }
+}
+
+/*!
+    Takes the newest frame that went through all stages. Older finished frames
+    are superseded by it and released.
+*/
+bool QVideoFilterPipeline::takeFinishedFrame(QVideoFrame *frame, bool *modified)
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_finished.isEmpty())
+        return false;
+
+    while (m_finished.size() > 1) {
+        delete m_finished.dequeue();
+        --m_framesInFlight;
+    }
+
+    Job *job = m_finished.dequeue();
+    --m_framesInFlight;
+    *frame = job->frame;
+    if (modified)
+        *modified = job->modified;
+    delete job;
+    return true;
+}
+
+/*!
+    Drops all frames in flight and waits for the worker stages to go idle.
+*/
+void QVideoFilterPipeline::clear()
+{
+    QMutexLocker locker(&m_mutex);
+    m_clearing = true;
+    for (;;) {
+        discardJobs();
+
+        bool busy = false;
+        for (int i = 0; i < m_stages.size() && !busy; ++i)
+            busy = m_stages.at(i).busy;
+        if (!busy)
+            break;
+        m_idle.wait(&m_mutex);
+    }
+    m_clearing = false;
+}
+
+int QVideoFilterPipeline::framesInFlight() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_framesInFlight;
+}
+
+int QVideoFilterPipeline::finishedFrameCount() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_finishedFrames;
+}
+
+int QVideoFilterPipeline::droppedFrameCount() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_droppedFrames;
+}
+
+qint64 QVideoFilterPipeline::lastStageLatency(int stage) const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_stages.value(stage).lastTime;
+}
+
+qint64 QVideoFilterPipeline::averageStageLatency(int stage) const
+{
+    QMutexLocker locker(&m_mutex);
+    const StageState state = m_stages.value(stage);
+    return state.frames > 0 ? state.totalTime / state.frames : 0;
+}
+
+/*!
+    Returns the average time from submit() until a frame left the last stage.
+*/
+qint64 QVideoFilterPipeline::averageFrameLatency() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_finishedFrames > 0 ? m_totalFrameLatency / m_finishedFrames : 0;
+}
+
+// Called locked. Queues the job for its next stage, returns true when it is
+// now waiting for the render thread.
+bool QVideoFilterPipeline::advance(Job *job)
+{
+    if (m_clearing) {
+        delete job;
+        --m_framesInFlight;
+        return false;
+    }
+
+    if (job->stage >= m_stages.size()) {
+        ++m_finishedFrames;
+        m_totalFrameLatency += job->timer.nsecsElapsed() / 1000;
+        m_finished.enqueue(job);
+        return true;
+    }
+
+    StageState &state = m_stages[job->stage];
+    state.queue.enqueue(job);
+    if (state.stage.renderThread)
+        return true;
+
+    if (!state.busy) {
+        state.busy = true;
+        m_threadPool.start(new StageWorker(this, job->stage));
+    }
+    return false;
+}
+
+// Called locked, runs the stage on its oldest queued frame with the lock released
+void QVideoFilterPipeline::runStage(int index, QMutexLocker *locker)
+{
+    Job *job = m_stages[index].queue.dequeue();
+    const Stage stage = m_stages.at(index).stage;
+
+    locker->unlock();
+    QElapsedTimer timer;
+    timer.start();
+    QVideoFrame output = stage.runnable->run(&job->frame, job->surfaceFormat, stage.flags);
+    const qint64 elapsed = timer.nsecsElapsed() / 1000;
+    if (output.isValid() && output != job->frame) {
+        job->modified = true;
+        job->frame = output;
+    }
+    locker->relock();
+
+    StageState &state = m_stages[index];
+    ++state.frames;
+    state.lastTime = elapsed;
+    state.totalTime += elapsed;
+
+    ++job->stage;
+    if (advance(job) && !state.stage.renderThread)
+        requestUpdate();
+}
+
+// Called in a worker thread, runs the stage until its queue is empty
+void QVideoFilterPipeline::drainStage(int index)
+{
+    QMutexLocker locker(&m_mutex);
+    while (!m_stages.at(index).queue.isEmpty())
+        runStage(index, &locker);
+
+    m_stages[index].busy = false;
+    m_idle.wakeAll();
+}
+
+void QVideoFilterPipeline::requestUpdate()
+{
+    if (m_updateTarget)
+        QMetaObject::invokeMethod(m_updateTarget, "update", Qt::QueuedConnection);
+}
+
+// Called locked
+void QVideoFilterPipeline::discardJobs()
+{
+    for (int i = 0; i < m_stages.size(); ++i) {
+        QQueue<Job *> &queue = m_stages[i].queue;
+        m_framesInFlight -= queue.size();
+        qDeleteAll(queue);
+        queue.clear();
+    }
+    m_framesInFlight -= m_finished.size();
+    qDeleteAll(m_finished);
+    m_finished.clear();
+}
+
+QT_END_NAMESPACE
@@ -13,7 +13,13 @@ SUBDIRS += \
 qtHaveModule(quick) {
     SUBDIRS += \
         qdeclarativevideooutput \
-        qdeclarativevideooutput_window
+        qdeclarativevideooutput_window \
+        qsgvideotextureuploader \
+        qvideofilterpipeline
 }
 
+config_pulseaudio: SUBDIRS += qaudiooutput_callback
+config_gstreamer: SUBDIRS += qgstreamercodecsinfo qgstreamerimagecapture qgstreamermediacache qgstreamervideorenderersink
+config_gstreamer_appsrc: SUBDIRS += qgstreamerappsrc
+
 !qtHaveModule(widgets): SUBDIRS -= qcamerabackend
@@ -203,6 +203,13 @@ void tst_QAudioOutput::generate_audiofile_testrows()
 
 void tst_QAudioOutput::initTestCase()
 {
+#ifdef TST_QAUDIOOUTPUT_CALLBACK
+    // Run every test with PulseAudio feeding the stream from its write
+    // callback, other backends ignore these.
+    qputenv("QT_PULSEAUDIO_CALLBACK_LATENCY", "20");
+    qputenv("QT_PULSEAUDIO_CALLBACK_DEBUG", "1");
+#endif
+
     qRegisterMetaType<QAudioFormat>();
 
     // Only perform tests if audio output device exists
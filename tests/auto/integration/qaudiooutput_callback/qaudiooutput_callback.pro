@@ -0,0 +1,14 @@
+TARGET = tst_qaudiooutput_callback
+
+QT += core multimedia-private testlib
+
+# Runs the qaudiooutput tests with the callback driven PulseAudio output
+CONFIG += testcase
+
+DEFINES += TST_QAUDIOOUTPUT_CALLBACK
+
+INCLUDEPATH += ../qaudiooutput
+HEADERS += ../qaudiooutput/wavheader.h
+SOURCES += ../qaudiooutput/wavheader.cpp ../qaudiooutput/tst_qaudiooutput.cpp
+
+DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0
@@ -0,0 +1,14 @@
+TARGET = tst_qgstreamerappsrc
+
+QT += multimedia-private testlib
+CONFIG += testcase
+
+CONFIG += link_pkgconfig
+PKGCONFIG += \
+    gstreamer-$$GST_VERSION \
+    gstreamer-app-$$GST_VERSION
+
+LIBS += -lqgsttools_p
+
+SOURCES += \
+        tst_qgstreamerappsrc.cpp
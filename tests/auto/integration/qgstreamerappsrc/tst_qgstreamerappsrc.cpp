@@ -0,0 +1,528 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the test suite of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+//TESTED_COMPONENT=src/gsttools
+
+#include <QtTest/QtTest>
+#include <QtCore/QBuffer>
+#include <QtCore/QTemporaryFile>
+#include <QDebug>
+
+#include <private/qgstappsrc_p.h>
+
+#include <gst/gst.h>
+#include <gst/app/gstappsink.h>
+
+QT_USE_NAMESPACE
+
+// Stands in for a decrypting device: random access, with every byte
+// available synchronously but produced by readData().
+class XorDevice : public QIODevice
+{
+public:
+    XorDevice(const QByteArray &content, bool sequential = false)
+        : m_data(content)
+        , m_offset(0)
+        , m_sequential(sequential)
+    {
+        for (int i = 0; i < m_data.size(); ++i)
+            m_data[i] = m_data.at(i) ^ Key;
+        open(QIODevice::ReadOnly | QIODevice::Unbuffered);
+    }
+
+    bool isSequential() const { return m_sequential; }
+    qint64 size() const { return m_data.size(); }
+
+    qint64 bytesAvailable() const
+    {
+        return m_data.size() - m_offset + QIODevice::bytesAvailable();
+    }
+
+    bool seek(qint64 pos)
+    {
+        if (!QIODevice::seek(pos))
+            return false;
+        m_offset = pos;
+        return true;
+    }
+
+protected:
+    qint64 readData(char *data, qint64 maxSize)
+    {
+        const qint64 length = qMin(maxSize, m_data.size() - m_offset);
+        const char *source = m_data.constData() + m_offset;
+        for (qint64 i = 0; i < length; ++i)
+            data[i] = source[i] ^ Key;
+        m_offset += length;
+        return length;
+    }
+
+    qint64 writeData(const char *, qint64) { return -1; }
+
+private:
+    enum { Key = 0x5a };
+
+    QByteArray m_data;
+    qint64 m_offset;
+    const bool m_sequential;
+};
+
+class tst_QGstreamerAppSrc : public QObject
+{
+    Q_OBJECT
+public slots:
+    void initTestCase();
+
+private slots:
+    void feedMode_data();
+    void feedMode();
+    void streamContent_data();
+    void streamContent();
+    void seek_data();
+    void seek();
+    void seekWhileFeeding_data();
+    void seekWhileFeeding();
+    void throughput_data();
+    void throughput();
+
+private:
+    QIODevice *createStream(const QString &kind) const;
+
+    QByteArray m_content;
+    QTemporaryFile m_file;
+};
+
+#if GST_CHECK_VERSION(1,0,0)
+struct SinkData
+{
+    SinkData() : delay(0) {}
+
+    int size()
+    {
+        QMutexLocker locker(&mutex);
+        return data.size();
+    }
+
+    QMutex mutex;
+    QByteArray data;
+    QAtomicInt delay;
+};
+
+static GstFlowReturn newSample(GstAppSink *sink, gpointer userData)
+{
+    SinkData *sinkData = static_cast<SinkData *>(userData);
+
+    GstSample *sample = gst_app_sink_pull_sample(sink);
+    if (!sample)
+        return GST_FLOW_ERROR;
+
+    GstBuffer *buffer = gst_sample_get_buffer(sample);
+    GstMapInfo mapInfo;
+    if (gst_buffer_map(buffer, &mapInfo, GST_MAP_READ)) {
+        QMutexLocker locker(&sinkData->mutex);
+        sinkData->data.append(reinterpret_cast<const char *>(mapInfo.data), mapInfo.size);
+        gst_buffer_unmap(buffer, &mapInfo);
+    }
+    gst_sample_unref(sample);
+
+    // A slow consumer keeps the stream going while the test seeks
+    if (const int delay = sinkData->delay.load())
+        QTest::qSleep(delay);
+
+    return GST_FLOW_OK;
+}
+
+static bool waitForData(SinkData *sinkData)
+{
+    QElapsedTimer timer;
+    timer.start();
+    while (sinkData->size() == 0 && timer.elapsed() < 10000)
+        QTest::qWait(10);
+    return sinkData->size() > 0;
+}
+
+static GstElement *createAppSink(SinkData *sinkData)
+{
+    GstElement *sink = gst_element_factory_make("appsink", NULL);
+    if (!sink)
+        return 0;
+
+    g_object_set(G_OBJECT(sink), "sync", FALSE, NULL);
+
+    GstAppSinkCallbacks callbacks;
+    memset(&callbacks, 0, sizeof(callbacks));
+    callbacks.new_sample = &newSample;
+    gst_app_sink_set_callbacks(GST_APP_SINK(sink), &callbacks, sinkData, NULL);
+
+    return sink;
+}
+#endif
+
+static GstElement *createPipeline(GstElement *source, GstElement *sink)
+{
+    GstElement *pipeline = gst_pipeline_new(NULL);
+    gst_bin_add_many(GST_BIN(pipeline), source, sink, NULL);
+    gst_element_link(source, sink);
+    return pipeline;
+}
+
+static bool runToEos(GstElement *pipeline)
+{
+    GstBus *bus = gst_element_get_bus(pipeline);
+    QElapsedTimer timer;
+    timer.start();
+
+    bool eos = false;
+    while (timer.elapsed() < 60000) {
+        // The owner thread feed is driven from this thread's event loop
+        QCoreApplication::processEvents();
+
+        GstMessage *message = gst_bus_timed_pop_filtered(
+                    bus, 100 * GST_USECOND, GstMessageType(GST_MESSAGE_EOS | GST_MESSAGE_ERROR));
+        if (message) {
+            eos = GST_MESSAGE_TYPE(message) == GST_MESSAGE_EOS;
+            gst_message_unref(message);
+            break;
+        }
+    }
+
+    gst_object_unref(bus);
+    return eos;
+}
+
+void tst_QGstreamerAppSrc::initTestCase()
+{
+    gst_init(NULL, NULL);
+
+    m_content.resize(16 * 1024 * 1024);
+    for (int i = 0; i < m_content.size(); ++i)
+        m_content[i] = char((quint32(i) * 2654435761u) >> 24);
+
+    QVERIFY(m_file.open());
+    QCOMPARE(m_file.write(m_content), qint64(m_content.size()));
+    QVERIFY(m_file.flush());
+}
+
+QIODevice *tst_QGstreamerAppSrc::createStream(const QString &kind) const
+{
+    QIODevice *stream = 0;
+    if (kind == QLatin1String("buffer")) {
+        QBuffer *buffer = new QBuffer;
+        buffer->setData(m_content);
+        stream = buffer;
+    } else if (kind == QLatin1String("file")) {
+        stream = new QFile(m_file.fileName());
+    } else if (kind == QLatin1String("sequential")) {
+        return new XorDevice(m_content, true);
+    } else {
+        return new XorDevice(m_content);
+    }
+
+    stream->open(QIODevice::ReadOnly);
+    return stream;
+}
+
+void tst_QGstreamerAppSrc::feedMode_data()
+{
+    QTest::addColumn<QString>("kind");
+    QTest::addColumn<bool>("workerEnabled");
+    QTest::addColumn<int>("feedMode");
+
+#if GST_CHECK_VERSION(1,0,0)
+    QTest::newRow("buffer") << "buffer" << true << int(QGstAppSrc::MemoryFeed);
+    QTest::newRow("file") << "file" << true << int(QGstAppSrc::MemoryFeed);
+#else
+    QTest::newRow("buffer") << "buffer" << true << int(QGstAppSrc::WorkerFeed);
+    QTest::newRow("file") << "file" << true << int(QGstAppSrc::WorkerFeed);
+#endif
+    QTest::newRow("random access") << "device" << true << int(QGstAppSrc::WorkerFeed);
+    QTest::newRow("sequential") << "sequential" << true << int(QGstAppSrc::OwnerThreadFeed);
+    QTest::newRow("worker disabled") << "device" << false << int(QGstAppSrc::OwnerThreadFeed);
+}
+
+void tst_QGstreamerAppSrc::feedMode()
+{
+    QFETCH(QString, kind);
+    QFETCH(bool, workerEnabled);
+    QFETCH(int, feedMode);
+
+    QScopedPointer<QIODevice> stream(createStream(kind));
+    QGstAppSrc appSrc;
+    appSrc.setWorkerEnabled(workerEnabled);
+    appSrc.setStream(stream.data());
+
+    GstElement *source = gst_element_factory_make("appsrc", NULL);
+    QVERIFY(source);
+    gst_object_ref_sink(source);
+
+    QVERIFY(appSrc.setup(source));
+    QCOMPARE(int(appSrc.feedMode()), feedMode);
+
+    appSrc.setStream(0);
+    QCOMPARE(int(appSrc.feedMode()), int(QGstAppSrc::OwnerThreadFeed));
+    gst_object_unref(source);
+}
+
+void tst_QGstreamerAppSrc::streamContent_data()
+{
+    QTest::addColumn<QString>("kind");
+    QTest::addColumn<bool>("workerEnabled");
+
+    QTest::newRow("buffer") << "buffer" << true;
+    QTest::newRow("file") << "file" << true;
+    QTest::newRow("worker") << "device" << true;
+    QTest::newRow("owner thread") << "device" << false;
+}
+
+void tst_QGstreamerAppSrc::streamContent()
+{
+#if GST_CHECK_VERSION(1,0,0)
+    QFETCH(QString, kind);
+    QFETCH(bool, workerEnabled);
+
+    QScopedPointer<QIODevice> stream(createStream(kind));
+    QGstAppSrc appSrc;
+    appSrc.setWorkerEnabled(workerEnabled);
+    appSrc.setStream(stream.data());
+
+    SinkData sinkData;
+    GstElement *source = gst_element_factory_make("appsrc", NULL);
+    GstElement *sink = createAppSink(&sinkData);
+    QVERIFY(source && sink);
+
+    GstElement *pipeline = createPipeline(source, sink);
+    QVERIFY(appSrc.setup(source));
+
+    gst_element_set_state(pipeline, GST_STATE_PLAYING);
+    const bool eos = runToEos(pipeline);
+    gst_element_set_state(pipeline, GST_STATE_NULL);
+    gst_object_unref(pipeline);
+
+    QVERIFY(eos);
+    QCOMPARE(sinkData.data.size(), m_content.size());
+    QVERIFY(sinkData.data == m_content);
+#else
+    QSKIP("Requires GStreamer 1.0");
+#endif
+}
+
+void tst_QGstreamerAppSrc::seek_data()
+{
+    QTest::addColumn<QString>("kind");
+    QTest::addColumn<qint64>("offset");
+
+    QTest::newRow("buffer") << "buffer" << qint64(5 * 1024 * 1024 + 17);
+    QTest::newRow("file") << "file" << qint64(1234567);
+    QTest::newRow("worker") << "device" << qint64(9 * 1024 * 1024 + 3);
+}
+
+void tst_QGstreamerAppSrc::seek()
+{
+#if GST_CHECK_VERSION(1,0,0)
+    QFETCH(QString, kind);
+    QFETCH(qint64, offset);
+
+    QScopedPointer<QIODevice> stream(createStream(kind));
+    QGstAppSrc appSrc;
+    appSrc.setStream(stream.data());
+
+    SinkData sinkData;
+    GstElement *source = gst_element_factory_make("appsrc", NULL);
+    GstElement *sink = createAppSink(&sinkData);
+    QVERIFY(source && sink);
+
+    GstElement *pipeline = createPipeline(source, sink);
+    QVERIFY(appSrc.setup(source));
+
+    gst_element_set_state(pipeline, GST_STATE_PLAYING);
+    bool eos = runToEos(pipeline);
+
+    bool seeked = false;
+    if (eos) {
+        sinkData.mutex.lock();
+        sinkData.data.clear();
+        sinkData.mutex.unlock();
+
+        seeked = gst_element_seek_simple(pipeline, GST_FORMAT_BYTES, GST_SEEK_FLAG_FLUSH, offset);
+        eos = seeked && runToEos(pipeline);
+    }
+    gst_element_set_state(pipeline, GST_STATE_NULL);
+    gst_object_unref(pipeline);
+
+    QVERIFY(seeked);
+    QVERIFY(eos);
+    const QByteArray expected = m_content.mid(offset);
+    QCOMPARE(sinkData.data.size(), expected.size());
+    QVERIFY(sinkData.data == expected);
+#else
+    QSKIP("Requires GStreamer 1.0");
+#endif
+}
+
+void tst_QGstreamerAppSrc::seekWhileFeeding_data()
+{
+    QTest::addColumn<QString>("kind");
+
+    QTest::newRow("buffer") << "buffer";
+    QTest::newRow("file") << "file";
+    QTest::newRow("worker") << "device";
+}
+
+/*
+    Seeks back and forth while the stream is being fed. The read-ahead is
+    larger than the stream so the element's queue never fills up, and the
+    feed is busy or has just finished when each seek arrives; whatever is
+    received after a seek must start at the requested offset.
+*/
+void tst_QGstreamerAppSrc::seekWhileFeeding()
+{
+#if GST_CHECK_VERSION(1,0,0)
+    QFETCH(QString, kind);
+
+    qputenv("QT_GSTREAMER_APPSRC_READAHEAD", QByteArray::number(2 * m_content.size() / 1024));
+
+    QScopedPointer<QIODevice> stream(createStream(kind));
+    QGstAppSrc appSrc;
+    appSrc.setStream(stream.data());
+
+    SinkData sinkData;
+    sinkData.delay.store(20);
+    GstElement *source = gst_element_factory_make("appsrc", NULL);
+    GstElement *sink = createAppSink(&sinkData);
+    QVERIFY(source && sink);
+
+    GstElement *pipeline = createPipeline(source, sink);
+    QVERIFY(appSrc.setup(source));
+    qunsetenv("QT_GSTREAMER_APPSRC_READAHEAD");
+
+    gst_element_set_state(pipeline, GST_STATE_PLAYING);
+
+    const qint64 offsets[] = { 3 * 1024 * 1024 + 5, 11 * 1024 * 1024 + 1, 7 * 1024 * 1024 + 9, 123 };
+    const int seekCount = int(sizeof(offsets) / sizeof(offsets[0]));
+    bool seeked = true;
+    bool received = true;
+    bool matched = true;
+    for (int i = 0; i < seekCount && seeked && received && matched; ++i) {
+        received = waitForData(&sinkData);
+        if (!received)
+            break;
+
+        seeked = gst_element_seek_simple(pipeline, GST_FORMAT_BYTES, GST_SEEK_FLAG_FLUSH, offsets[i]);
+
+        // The flushing seek returns once the streaming thread has restarted,
+        // everything received from here on was read after the seek.
+        sinkData.mutex.lock();
+        sinkData.data.clear();
+        sinkData.mutex.unlock();
+
+        if (!seeked)
+            break;
+
+        received = waitForData(&sinkData);
+
+        sinkData.mutex.lock();
+        matched = sinkData.data == m_content.mid(offsets[i], sinkData.data.size());
+        sinkData.mutex.unlock();
+    }
+
+    sinkData.delay.store(0);
+    const bool eos = seeked && received && matched && runToEos(pipeline);
+    gst_element_set_state(pipeline, GST_STATE_NULL);
+    gst_object_unref(pipeline);
+
+    QVERIFY(seeked);
+    QVERIFY(received);
+    QVERIFY(matched);
+    QVERIFY(eos);
+    const QByteArray expected = m_content.mid(offsets[seekCount - 1]);
+    QCOMPARE(sinkData.data.size(), expected.size());
+    QVERIFY(sinkData.data == expected);
+#else
+    QSKIP("Requires GStreamer 1.0");
+#endif
+}
+
+void tst_QGstreamerAppSrc::throughput_data()
+{
+    QTest::addColumn<QString>("kind");
+    QTest::addColumn<bool>("workerEnabled");
+
+    QTest::newRow("filesrc") << "filesrc" << false;
+    QTest::newRow("buffer") << "buffer" << true;
+    QTest::newRow("file") << "file" << true;
+    QTest::newRow("worker") << "device" << true;
+    QTest::newRow("owner thread") << "device" << false;
+}
+
+void tst_QGstreamerAppSrc::throughput()
+{
+    QFETCH(QString, kind);
+    QFETCH(bool, workerEnabled);
+
+    QGstAppSrc appSrc;
+    appSrc.setWorkerEnabled(workerEnabled);
+    QScopedPointer<QIODevice> stream;
+
+    bool eos = true;
+    QBENCHMARK {
+        GstElement *source = 0;
+        if (kind == QLatin1String("filesrc")) {
+            source = gst_element_factory_make("filesrc", NULL);
+            g_object_set(G_OBJECT(source), "location", QFile::encodeName(m_file.fileName()).constData(), NULL);
+        } else {
+            stream.reset(createStream(kind));
+            appSrc.setStream(stream.data());
+            source = gst_element_factory_make("appsrc", NULL);
+        }
+
+        GstElement *sink = gst_element_factory_make("fakesink", NULL);
+        g_object_set(G_OBJECT(sink), "sync", FALSE, NULL);
+
+        GstElement *pipeline = createPipeline(source, sink);
+        if (stream)
+            appSrc.setup(source);
+
+        gst_element_set_state(pipeline, GST_STATE_PLAYING);
+        eos = runToEos(pipeline) && eos;
+        gst_element_set_state(pipeline, GST_STATE_NULL);
+        gst_object_unref(pipeline);
+
+        appSrc.setStream(0);
+    }
+
+    QVERIFY(eos);
+}
+
+QTEST_MAIN(tst_QGstreamerAppSrc)
+
+#include "tst_qgstreamerappsrc.moc"
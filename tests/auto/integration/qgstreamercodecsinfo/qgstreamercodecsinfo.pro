@@ -0,0 +1,13 @@
+TARGET = tst_qgstreamercodecsinfo
+
+QT += multimedia-private testlib
+CONFIG += testcase
+
+CONFIG += link_pkgconfig
+PKGCONFIG += \
+    gstreamer-$$GST_VERSION
+
+LIBS += -lqgsttools_p
+
+SOURCES += \
+        tst_qgstreamercodecsinfo.cpp
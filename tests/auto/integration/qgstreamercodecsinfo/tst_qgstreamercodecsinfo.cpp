@@ -0,0 +1,183 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the test suite of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+//TESTED_COMPONENT=src/gsttools
+
+#include <QtTest/QtTest>
+
+#include <private/qgstcodecsinfo_p.h>
+
+#include <gst/gst.h>
+
+QT_USE_NAMESPACE
+
+class tst_QGstreamerCodecsInfo : public QObject
+{
+    Q_OBJECT
+public slots:
+    void initTestCase();
+    void cleanup();
+
+private slots:
+    void reuseMatchingStamp();
+    void rebuildOnStampMismatch();
+    void descriptionOfUnlistedCodec();
+    void cacheDisabled();
+
+private:
+    static QStringList scannedCodecs(QGstCodecsInfo::ElementType elementType);
+    void writeCacheFile(const QString &stamp, const QStringList &audioEncoders);
+    QJsonObject readCacheFile() const;
+
+    QTemporaryDir m_dir;
+    QString m_cacheFile;
+};
+
+void tst_QGstreamerCodecsInfo::initTestCase()
+{
+    QVERIFY(m_dir.isValid());
+    m_cacheFile = m_dir.path() + QLatin1String("/codecs.json");
+
+    // A registry of our own, so its stamp is known not to change under us
+    const QByteArray registry = QFile::encodeName(m_dir.path() + QLatin1String("/registry.bin"));
+    qputenv("GST_REGISTRY_1_0", registry);
+    qputenv("GST_REGISTRY", registry);
+    gst_init(NULL, NULL);
+
+    if (QGstCodecsInfoCache::registryStamp().isEmpty())
+        QSKIP("The GStreamer registry was not written");
+}
+
+void tst_QGstreamerCodecsInfo::cleanup()
+{
+    QFile::remove(m_cacheFile);
+    qunsetenv("QT_GSTREAMER_CODECS_CACHE");
+}
+
+QStringList tst_QGstreamerCodecsInfo::scannedCodecs(QGstCodecsInfo::ElementType elementType)
+{
+    qputenv("QT_GSTREAMER_CODECS_CACHE", "0");
+    QGstCodecsInfoCache cache;
+    return cache.codecs(elementType);
+}
+
+void tst_QGstreamerCodecsInfo::writeCacheFile(const QString &stamp, const QStringList &audioEncoders)
+{
+    QJsonObject root;
+    root.insert(QStringLiteral("stamp"), stamp);
+    root.insert(QStringLiteral("AudioEncoder"), QJsonArray::fromStringList(audioEncoders));
+
+    QFile file(m_cacheFile);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write(QJsonDocument(root).toJson());
+}
+
+QJsonObject tst_QGstreamerCodecsInfo::readCacheFile() const
+{
+    QFile file(m_cacheFile);
+    if (!file.open(QIODevice::ReadOnly))
+        return QJsonObject();
+    return QJsonDocument::fromJson(file.readAll()).object();
+}
+
+void tst_QGstreamerCodecsInfo::reuseMatchingStamp()
+{
+    const QStringList fakeCodecs = QStringList() << QStringLiteral("audio/x-qt-test-codec");
+    writeCacheFile(QGstCodecsInfoCache::registryStamp(), fakeCodecs);
+    const QDateTime written = QFileInfo(m_cacheFile).lastModified();
+
+    qputenv("QT_GSTREAMER_CODECS_CACHE", QFile::encodeName(m_cacheFile));
+    QGstCodecsInfoCache cache;
+    QCOMPARE(cache.fileName(), m_cacheFile);
+
+    // The list is taken from the file as is, without scanning the registry
+    QCOMPARE(cache.codecs(QGstCodecsInfo::AudioEncoder), fakeCodecs);
+    QCOMPARE(QFileInfo(m_cacheFile).lastModified(), written);
+
+    // Lists missing from the file are scanned and added to it
+    const QStringList muxers = cache.codecs(QGstCodecsInfo::Muxer);
+    QCOMPARE(muxers, scannedCodecs(QGstCodecsInfo::Muxer));
+
+    const QJsonObject root = readCacheFile();
+    QCOMPARE(root.value(QStringLiteral("stamp")).toString(), QGstCodecsInfoCache::registryStamp());
+    QCOMPARE(root.value(QStringLiteral("AudioEncoder")).toArray(), QJsonArray::fromStringList(fakeCodecs));
+    QCOMPARE(root.value(QStringLiteral("Muxer")).toArray(), QJsonArray::fromStringList(muxers));
+    QVERIFY(!root.contains(QStringLiteral("VideoEncoder")));
+}
+
+void tst_QGstreamerCodecsInfo::rebuildOnStampMismatch()
+{
+    const QStringList fakeCodecs = QStringList() << QStringLiteral("audio/x-qt-test-codec");
+    writeCacheFile(QStringLiteral("0.10.0.0;/nonexistent/registry.bin;0;0"), fakeCodecs);
+
+    qputenv("QT_GSTREAMER_CODECS_CACHE", QFile::encodeName(m_cacheFile));
+    QGstCodecsInfoCache cache;
+
+    // The stale file is ignored and replaced with a fresh scan
+    const QStringList audioEncoders = cache.codecs(QGstCodecsInfo::AudioEncoder);
+    QVERIFY(!audioEncoders.contains(fakeCodecs.first()));
+    QCOMPARE(audioEncoders, scannedCodecs(QGstCodecsInfo::AudioEncoder));
+
+    const QJsonObject root = readCacheFile();
+    QCOMPARE(root.value(QStringLiteral("stamp")).toString(), QGstCodecsInfoCache::registryStamp());
+    QCOMPARE(root.value(QStringLiteral("AudioEncoder")).toArray(), QJsonArray::fromStringList(audioEncoders));
+}
+
+void tst_QGstreamerCodecsInfo::descriptionOfUnlistedCodec()
+{
+    const QStringList fakeCodecs = QStringList() << QStringLiteral("audio/x-qt-test-codec");
+    writeCacheFile(QGstCodecsInfoCache::registryStamp(), fakeCodecs);
+
+    qputenv("QT_GSTREAMER_CODECS_CACHE", QFile::encodeName(m_cacheFile));
+    QGstCodecsInfoCache cache;
+    cache.codecs(QGstCodecsInfo::AudioEncoder);
+    cache.codecs(QGstCodecsInfo::VideoEncoder);
+
+    // Codecs are only described for the type they are listed under
+    QCOMPARE(cache.description(QGstCodecsInfo::VideoEncoder, fakeCodecs.first()), QString());
+    QCOMPARE(cache.description(QGstCodecsInfo::AudioEncoder, QStringLiteral("audio/x-unknown")), QString());
+}
+
+void tst_QGstreamerCodecsInfo::cacheDisabled()
+{
+    qputenv("QT_GSTREAMER_CODECS_CACHE", "0");
+    QGstCodecsInfoCache cache;
+    QVERIFY(cache.fileName().isEmpty());
+
+    cache.codecs(QGstCodecsInfo::AudioEncoder);
+    QVERIFY(!QFile::exists(m_cacheFile));
+}
+
+QTEST_MAIN(tst_QGstreamerCodecsInfo)
+
+#include "tst_qgstreamercodecsinfo.moc"
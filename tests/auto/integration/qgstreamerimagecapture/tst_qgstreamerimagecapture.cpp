@@ -0,0 +1,463 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the test suite of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+//TESTED_COMPONENT=src/gsttools
+
+#include <QtTest/QtTest>
+#include <QtGui/QImageWriter>
+#include <QDebug>
+
+#include <private/qgstutils_p.h>
+#include <private/qgstimagecaptureworker_p.h>
+
+#include <gst/gst.h>
+#include <gst/video/video.h>
+
+QT_USE_NAMESPACE
+
+class tst_QGstreamerImageCapture : public QObject
+{
+    Q_OBJECT
+public slots:
+    void initTestCase();
+
+private slots:
+    void jpegResolution();
+    void scaledBufferToImage_data();
+    void scaledBufferToImage();
+    void orderedDelivery();
+    void saveFailure();
+    void fullQueueRejects();
+    void fullQueueDoesNotBlock();
+    void sustainedCapture_data();
+    void sustainedCapture();
+};
+
+#if GST_CHECK_VERSION(1,0,0)
+static GstBuffer *createFrame(
+        GstVideoFormat format, int width, int height, const int values[3], GstVideoInfo *info)
+{
+    gst_video_info_set_format(info, format, width, height);
+
+    GstBuffer *buffer = gst_buffer_new_allocate(0, GST_VIDEO_INFO_SIZE(info), 0);
+    GstVideoFrame frame;
+    if (!gst_video_frame_map(&frame, info, buffer, GST_MAP_WRITE)) {
+        gst_buffer_unref(buffer);
+        return 0;
+    }
+
+    for (int c = 0; c < 3; ++c) {
+        uchar *data = static_cast<uchar *>(GST_VIDEO_FRAME_COMP_DATA(&frame, c));
+        const int stride = GST_VIDEO_FRAME_COMP_STRIDE(&frame, c);
+        const int pixelStride = GST_VIDEO_FRAME_COMP_PSTRIDE(&frame, c);
+        for (int y = 0; y < GST_VIDEO_FRAME_COMP_HEIGHT(&frame, c); ++y) {
+            for (int x = 0; x < GST_VIDEO_FRAME_COMP_WIDTH(&frame, c); ++x)
+                data[y * stride + x * pixelStride] = values[c];
+        }
+    }
+
+    gst_video_frame_unmap(&frame);
+
+    return buffer;
+}
+#endif
+
+void tst_QGstreamerImageCapture::initTestCase()
+{
+    gst_init(NULL, NULL);
+}
+
+void tst_QGstreamerImageCapture::jpegResolution()
+{
+    QCOMPARE(QGstUtils::jpegResolution(0, 0), QSize());
+
+    const QByteArray garbage("not a jpeg image at all");
+    QCOMPARE(QGstUtils::jpegResolution(reinterpret_cast<const uchar *>(garbage.constData()), garbage.size()),
+             QSize());
+
+    if (!QImageWriter::supportedImageFormats().contains("jpeg"))
+        QSKIP("No JPEG image writer available");
+
+    QImage image(321, 123, QImage::Format_RGB32);
+    image.fill(Qt::red);
+
+    QByteArray data;
+    QBuffer buffer(&data);
+    buffer.open(QIODevice::WriteOnly);
+    QVERIFY(image.save(&buffer, "JPEG"));
+
+    const uchar *bytes = reinterpret_cast<const uchar *>(data.constData());
+    QCOMPARE(QGstUtils::jpegResolution(bytes, data.size()), QSize(321, 123));
+
+    // The frame header comes before the scan, the image data is never needed.
+    QCOMPARE(QGstUtils::jpegResolution(bytes, data.indexOf("\xff\xda")), QSize(321, 123));
+
+    // Truncated within the headers
+    QCOMPARE(QGstUtils::jpegResolution(bytes, 20), QSize());
+}
+
+void tst_QGstreamerImageCapture::scaledBufferToImage_data()
+{
+#if GST_CHECK_VERSION(1,0,0)
+    QTest::addColumn<int>("format");
+    QTest::addColumn<QSize>("maximumSize");
+    QTest::addColumn<QSize>("expectedSize");
+
+    const int formats[] = {
+        GST_VIDEO_FORMAT_I420, GST_VIDEO_FORMAT_YV12, GST_VIDEO_FORMAT_NV12,
+        GST_VIDEO_FORMAT_NV21, GST_VIDEO_FORMAT_YUY2, GST_VIDEO_FORMAT_UYVY,
+        GST_VIDEO_FORMAT_RGBx
+    };
+
+    for (int i = 0; i < int(sizeof(formats) / sizeof(formats[0])); ++i) {
+        const QByteArray name = gst_video_format_to_string(GstVideoFormat(formats[i]));
+        QTest::newRow((name + " full").constData()) << formats[i] << QSize() << QSize(64, 48);
+        QTest::newRow((name + " half").constData()) << formats[i] << QSize(32, 24) << QSize(32, 24);
+        QTest::newRow((name + " bounded").constData()) << formats[i] << QSize(20, 100) << QSize(16, 12);
+    }
+#endif
+}
+
+void tst_QGstreamerImageCapture::scaledBufferToImage()
+{
+#if GST_CHECK_VERSION(1,0,0)
+    QFETCH(int, format);
+    QFETCH(QSize, maximumSize);
+    QFETCH(QSize, expectedSize);
+
+    // Pure red, in BT.601 YUV for the YUV formats.
+    const int red[] = { 255, 0, 0 };
+    const int yuvRed[] = { 81, 90, 240 };
+
+    GstVideoInfo info;
+    const GstVideoFormat videoFormat = GstVideoFormat(format);
+    const bool rgb = videoFormat == GST_VIDEO_FORMAT_RGBx;
+    GstBuffer *buffer = createFrame(videoFormat, 64, 48, rgb ? red : yuvRed, &info);
+    QVERIFY(buffer);
+
+    const QImage image = QGstUtils::scaledBufferToImage(buffer, info, maximumSize);
+    gst_buffer_unref(buffer);
+
+    QCOMPARE(image.size(), expectedSize);
+
+    const QRgb pixel = image.pixel(image.width() - 1, image.height() - 1);
+    QVERIFY2(qRed(pixel) > 240 && qGreen(pixel) < 16 && qBlue(pixel) < 16,
+             qPrintable(QString::number(pixel, 16)));
+#else
+    QSKIP("Requires GStreamer 1.0");
+#endif
+}
+
+void tst_QGstreamerImageCapture::orderedDelivery()
+{
+#if GST_CHECK_VERSION(1,0,0)
+    qputenv("QT_GSTREAMER_CAPTURE_THREADS", "4");
+    qputenv("QT_GSTREAMER_CAPTURE_QUEUE", "80");
+
+    QGstImageCaptureWorker worker;
+    QSignalSpy convertedSpy(&worker, SIGNAL(imageConverted(int,QImage)));
+    QSignalSpy savedSpy(&worker, SIGNAL(imageSaved(int,QString)));
+
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    const int yuvRed[] = { 81, 90, 240 };
+    const int count = 40;
+    for (int i = 0; i < count; ++i) {
+        // Alternate large and small frames so later jobs tend to finish first.
+        GstVideoInfo info;
+        const int size = i % 2 ? 32 : 640;
+        GstBuffer *buffer = createFrame(GST_VIDEO_FORMAT_I420, size, size, yuvRed, &info);
+        QVERIFY(worker.convertImage(i, buffer, info));
+        QVERIFY(worker.saveImage(i, buffer, dir.path() + QString::fromLatin1("/%1.raw").arg(i)));
+        gst_buffer_unref(buffer);
+    }
+
+    QTRY_COMPARE(savedSpy.count(), count);
+    QCOMPARE(convertedSpy.count(), count);
+
+    for (int i = 0; i < count; ++i) {
+        QCOMPARE(convertedSpy.at(i).at(0).toInt(), i);
+        QCOMPARE(savedSpy.at(i).at(0).toInt(), i);
+
+        const int size = i % 2 ? 32 : 640;
+        QFile file(savedSpy.at(i).at(1).toString());
+        QVERIFY(file.open(QIODevice::ReadOnly));
+        QCOMPARE(file.size(), qint64(size * size * 3 / 2));
+    }
+
+    qunsetenv("QT_GSTREAMER_CAPTURE_THREADS");
+    qunsetenv("QT_GSTREAMER_CAPTURE_QUEUE");
+#else
+    QSKIP("Requires GStreamer 1.0");
+#endif
+}
+
+void tst_QGstreamerImageCapture::saveFailure()
+{
+    QGstImageCaptureWorker worker;
+    QSignalSpy savedSpy(&worker, SIGNAL(imageSaved(int,QString)));
+    QSignalSpy failedSpy(&worker, SIGNAL(saveFailed(int,QString)));
+
+    GstBuffer *buffer = gst_buffer_new();
+    QVERIFY(worker.saveImage(7, buffer, QString::fromLatin1("/nonexistent/directory/image.jpg")));
+    gst_buffer_unref(buffer);
+
+    QTRY_COMPARE(failedSpy.count(), 1);
+    QCOMPARE(failedSpy.at(0).at(0).toInt(), 7);
+    QVERIFY(!failedSpy.at(0).at(1).toString().isEmpty());
+    QCOMPARE(savedSpy.count(), 0);
+}
+
+void tst_QGstreamerImageCapture::fullQueueRejects()
+{
+    qputenv("QT_GSTREAMER_CAPTURE_THREADS", "1");
+    qputenv("QT_GSTREAMER_CAPTURE_QUEUE", "2");
+
+    QGstImageCaptureWorker worker;
+    QCOMPARE(worker.maximumPendingJobs(), 2);
+    QSignalSpy savedSpy(&worker, SIGNAL(imageSaved(int,QString)));
+
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString fileName = dir.path() + QLatin1String("/%1.raw");
+
+    GstBuffer *buffer = gst_buffer_new();
+    QVERIFY(worker.saveImage(0, buffer, fileName.arg(0)));
+    QVERIFY(worker.saveImage(1, buffer, fileName.arg(1)));
+
+    // Jobs completed but not delivered keep their slots, so without the
+    // event loop running the queue stays full.
+    QVERIFY(!worker.saveImage(2, buffer, fileName.arg(2)));
+    QTest::qSleep(100);
+    QVERIFY(!worker.saveImage(3, buffer, fileName.arg(3)));
+    QCOMPARE(savedSpy.count(), 0);
+
+    QTRY_COMPARE(savedSpy.count(), 2);
+    QVERIFY(worker.saveImage(4, buffer, fileName.arg(4)));
+    gst_buffer_unref(buffer);
+
+    QTRY_COMPARE(savedSpy.count(), 3);
+    QCOMPARE(savedSpy.at(0).at(0).toInt(), 0);
+    QCOMPARE(savedSpy.at(1).at(0).toInt(), 1);
+    QCOMPARE(savedSpy.at(2).at(0).toInt(), 4);
+    QVERIFY(!QFile::exists(fileName.arg(2)));
+    QVERIFY(!QFile::exists(fileName.arg(3)));
+
+    qunsetenv("QT_GSTREAMER_CAPTURE_THREADS");
+    qunsetenv("QT_GSTREAMER_CAPTURE_QUEUE");
+}
+
+class SaveSubmitter : public QThread
+{
+public:
+    SaveSubmitter(QGstImageCaptureWorker *worker, const QString &path, int count)
+        : worker(worker), path(path), count(count) {}
+
+    void run()
+    {
+        for (int i = 0; i < count; ++i) {
+            GstBuffer *buffer = gst_buffer_new();
+            if (worker->saveImage(i, buffer, path + QString::fromLatin1("/%1.raw").arg(i)))
+                accepted.ref();
+            gst_buffer_unref(buffer);
+        }
+    }
+
+    QGstImageCaptureWorker * const worker;
+    const QString path;
+    const int count;
+    QAtomicInt accepted;
+};
+
+/*
+    A streaming thread submitting to a full queue while the worker's thread
+    waits for it, as when the pipeline is stopped, must not deadlock.
+*/
+void tst_QGstreamerImageCapture::fullQueueDoesNotBlock()
+{
+    qputenv("QT_GSTREAMER_CAPTURE_THREADS", "1");
+    qputenv("QT_GSTREAMER_CAPTURE_QUEUE", "2");
+
+    QGstImageCaptureWorker worker;
+    QSignalSpy savedSpy(&worker, SIGNAL(imageSaved(int,QString)));
+
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    SaveSubmitter submitter(&worker, dir.path(), 6);
+    submitter.start();
+    QVERIFY(submitter.wait(5000));
+    QCOMPARE(submitter.accepted.load(), 2);
+
+    QTRY_COMPARE(savedSpy.count(), 2);
+
+    qunsetenv("QT_GSTREAMER_CAPTURE_THREADS");
+    qunsetenv("QT_GSTREAMER_CAPTURE_QUEUE");
+}
+
+#if GST_CHECK_VERSION(1,0,0)
+struct CaptureContext
+{
+    QGstImageCaptureWorker *worker;
+    GstVideoInfo info;
+    QSize previewSize;
+    QString path;
+    QAtomicInt frames;
+    QAtomicInt encoded;
+    QAtomicInt rejectedPreviews;
+    QAtomicInt rejectedSaves;
+};
+
+static void rawFrameHandoff(GstElement *, GstBuffer *buffer, GstPad *, gpointer userData)
+{
+    CaptureContext * const context = static_cast<CaptureContext *>(userData);
+    if (!context->worker->convertImage(context->frames.fetchAndAddRelaxed(1), buffer, context->info,
+                                       context->previewSize)) {
+        context->rejectedPreviews.ref();
+    }
+}
+
+static void jpegHandoff(GstElement *, GstBuffer *buffer, GstPad *, gpointer userData)
+{
+    CaptureContext * const context = static_cast<CaptureContext *>(userData);
+    const int id = context->encoded.fetchAndAddRelaxed(1);
+    if (!context->worker->saveImage(id, buffer, context->path + QString::fromLatin1("/img_%1.jpg").arg(id)))
+        context->rejectedSaves.ref();
+}
+#endif
+
+void tst_QGstreamerImageCapture::sustainedCapture_data()
+{
+    QTest::addColumn<QSize>("resolution");
+    QTest::addColumn<int>("shots");
+
+    QTest::newRow("640x480") << QSize(640, 480) << 100;
+    QTest::newRow("1280x720") << QSize(1280, 720) << 60;
+    QTest::newRow("1920x1080") << QSize(1920, 1080) << 30;
+}
+
+/*
+    Feeds a burst of videotestsrc frames through the capture worker the way
+    the capture sessions do: a preview is converted for every raw frame and
+    every encoded JPEG is saved, and the sustained shots per second are
+    reported as the benchmark result. Shots refused because the queue was
+    full are not counted.
+*/
+void tst_QGstreamerImageCapture::sustainedCapture()
+{
+#if GST_CHECK_VERSION(1,0,0)
+    QFETCH(QSize, resolution);
+    QFETCH(int, shots);
+
+    GstElementFactory *source = gst_element_factory_find("videotestsrc");
+    GstElementFactory *encoder = gst_element_factory_find("jpegenc");
+    if (source)
+        gst_object_unref(source);
+    if (encoder)
+        gst_object_unref(encoder);
+    if (!source || !encoder)
+        QSKIP("videotestsrc or jpegenc is not available");
+
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    QGstImageCaptureWorker worker;
+    QSignalSpy convertedSpy(&worker, SIGNAL(imageConverted(int,QImage)));
+    QSignalSpy savedSpy(&worker, SIGNAL(imageSaved(int,QString)));
+
+    CaptureContext context;
+    context.worker = &worker;
+    gst_video_info_set_format(&context.info, GST_VIDEO_FORMAT_I420, resolution.width(), resolution.height());
+    context.previewSize = resolution / 4;
+    context.path = dir.path();
+
+    const QByteArray description = QString::fromLatin1(
+                "videotestsrc num-buffers=%1 pattern=smpte "
+                "! video/x-raw,format=I420,width=%2,height=%3 "
+                "! tee name=t "
+                "t. ! queue ! fakesink name=raw signal-handoffs=true sync=false "
+                "t. ! queue ! jpegenc ! fakesink name=jpeg signal-handoffs=true sync=false")
+            .arg(shots).arg(resolution.width()).arg(resolution.height()).toLatin1();
+
+    GError *error = 0;
+    GstElement *pipeline = gst_parse_launch(description.constData(), &error);
+    if (error) {
+        const QString message = QString::fromUtf8(error->message);
+        g_error_free(error);
+        if (pipeline)
+            gst_object_unref(pipeline);
+        QFAIL(qPrintable(message));
+    }
+
+    GstElement *rawSink = gst_bin_get_by_name(GST_BIN(pipeline), "raw");
+    GstElement *jpegSink = gst_bin_get_by_name(GST_BIN(pipeline), "jpeg");
+    g_signal_connect(rawSink, "handoff", G_CALLBACK(rawFrameHandoff), &context);
+    g_signal_connect(jpegSink, "handoff", G_CALLBACK(jpegHandoff), &context);
+    gst_object_unref(rawSink);
+    gst_object_unref(jpegSink);
+
+    QElapsedTimer timer;
+    timer.start();
+    QVERIFY(gst_element_set_state(pipeline, GST_STATE_PLAYING) != GST_STATE_CHANGE_FAILURE);
+
+    QTRY_COMPARE_WITH_TIMEOUT(savedSpy.count() + context.rejectedSaves.load(), shots, 120000);
+    QTRY_COMPARE(convertedSpy.count() + context.rejectedPreviews.load(), shots);
+    QVERIFY(!savedSpy.isEmpty());
+    QVERIFY(!convertedSpy.isEmpty());
+    const qint64 elapsed = qMax<qint64>(timer.elapsed(), 1);
+
+    gst_element_set_state(pipeline, GST_STATE_NULL);
+    gst_object_unref(pipeline);
+    worker.waitForDone();
+
+    const QImage preview = convertedSpy.last().at(1).value<QImage>();
+    QCOMPARE(preview.size(), resolution / 4);
+
+    QFile file(savedSpy.last().at(1).toString());
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    const QByteArray jpeg = file.readAll();
+    QCOMPARE(QGstUtils::jpegResolution(reinterpret_cast<const uchar *>(jpeg.constData()), jpeg.size()),
+             resolution);
+
+    const qreal shotsPerSecond = savedSpy.count() * 1000.0 / elapsed;
+    qDebug() << resolution << "sustained" << shotsPerSecond << "shots per second";
+    QTest::setBenchmarkResult(shotsPerSecond, QTest::FramesPerSecond);
+#else
+    QSKIP("Requires GStreamer 1.0");
+#endif
+}
+
+QTEST_MAIN(tst_QGstreamerImageCapture)
+
+#include "tst_qgstreamerimagecapture.moc"
@@ -0,0 +1,9 @@
+TARGET = tst_qgstreamermediacache
+
+QT += multimedia-private network testlib
+CONFIG += testcase
+
+LIBS += -lqgsttools_p
+
+SOURCES += \
+        tst_qgstreamermediacache.cpp
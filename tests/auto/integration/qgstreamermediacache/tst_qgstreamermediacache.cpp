@@ -0,0 +1,456 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the test suite of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+//TESTED_COMPONENT=src/gsttools
+
+#include <QtTest/QtTest>
+#include <QtCore/QTemporaryDir>
+#include <QtNetwork/QNetworkAccessManager>
+#include <QtNetwork/QTcpServer>
+#include <QtNetwork/QTcpSocket>
+
+#include <private/qgstreamermediacache_p.h>
+
+QT_USE_NAMESPACE
+
+// Serves in-memory files over HTTP/1.1, with ETag validation and byte range
+// support, one request per connection.
+class HttpStandIn : public QTcpServer
+{
+    Q_OBJECT
+public:
+    struct Resource
+    {
+        QByteArray content;
+        QByteArray etag;
+    };
+
+    HttpStandIn()
+        : rangeSupport(true)
+        , contentLength(true)
+        , requestCount(0)
+        , bodyBytes(0)
+    {
+        connect(this, SIGNAL(newConnection()), this, SLOT(acceptConnections()));
+        listen(QHostAddress::LocalHost);
+    }
+
+    QUrl url(const QString &path) const
+    {
+        return QUrl(QStringLiteral("http://127.0.0.1:%1%2").arg(serverPort()).arg(path));
+    }
+
+    void resetCounters()
+    {
+        requestCount = 0;
+        bodyBytes = 0;
+        statusCodes.clear();
+        requestHeaders.clear();
+    }
+
+    QHash<QByteArray, Resource> resources;
+    bool rangeSupport;
+    bool contentLength;
+
+    int requestCount;
+    qint64 bodyBytes;
+    QList<int> statusCodes;
+    QList<QHash<QByteArray, QByteArray> > requestHeaders;
+
+private Q_SLOTS:
+    void acceptConnections()
+    {
+        while (QTcpSocket *socket = nextPendingConnection()) {
+            connect(socket, SIGNAL(readyRead()), this, SLOT(readRequest()));
+            connect(socket, SIGNAL(disconnected()), socket, SLOT(deleteLater()));
+        }
+    }
+
+    void readRequest()
+    {
+        QTcpSocket *socket = qobject_cast<QTcpSocket *>(sender());
+        QByteArray &buffer = m_buffers[socket];
+        buffer += socket->readAll();
+
+        const int end = buffer.indexOf("\r\n\r\n");
+        if (end < 0)
+            return;
+
+        const QList<QByteArray> lines = buffer.left(end).split('\n');
+        m_buffers.remove(socket);
+
+        const QByteArray path = lines.value(0).split(' ').value(1);
+        QHash<QByteArray, QByteArray> headers;
+        for (int i = 1; i < lines.count(); ++i) {
+            const int colon = lines.at(i).indexOf(':');
+            if (colon > 0)
+                headers.insert(lines.at(i).left(colon).trimmed().toLower(), lines.at(i).mid(colon + 1).trimmed());
+        }
+
+        ++requestCount;
+        requestHeaders.append(headers);
+
+        QByteArray status;
+        QByteArray body;
+        QByteArray extraHeaders;
+
+        const Resource resource = resources.value(path);
+        const qint64 size = resource.content.size();
+
+        if (!resources.contains(path)) {
+            status = "404 Not Found";
+        } else if (!resource.etag.isEmpty() && headers.value("if-none-match") == resource.etag) {
+            status = "304 Not Modified";
+        } else if (rangeSupport && headers.contains("range")
+                   && (!headers.contains("if-range") || headers.value("if-range") == resource.etag)) {
+            // bytes=<first>-[<last>]
+            const QByteArray range = headers.value("range").mid(6);
+            const int dash = range.indexOf('-');
+            const qint64 first = range.left(dash).toLongLong();
+            const qint64 last = dash + 1 < range.size() ? qMin(range.mid(dash + 1).toLongLong(), size - 1) : size - 1;
+
+            status = "206 Partial Content";
+            body = resource.content.mid(first, last - first + 1);
+            extraHeaders = "Content-Range: bytes " + QByteArray::number(first) + '-'
+                    + QByteArray::number(last) + '/' + QByteArray::number(size) + "\r\n";
+        } else {
+            status = "200 OK";
+            body = resource.content;
+        }
+
+        statusCodes.append(status.left(3).toInt());
+        bodyBytes += body.size();
+
+        QByteArray response = "HTTP/1.1 " + status + "\r\n";
+        if (!resource.etag.isEmpty())
+            response += "ETag: " + resource.etag + "\r\n";
+        if (rangeSupport)
+            response += "Accept-Ranges: bytes\r\n";
+        response += extraHeaders;
+        if (contentLength)
+            response += "Content-Length: " + QByteArray::number(body.size()) + "\r\n";
+        response += "Connection: close\r\n\r\n";
+
+        socket->write(response + body);
+        socket->disconnectFromHost();
+    }
+
+private:
+    QHash<QTcpSocket *, QByteArray> m_buffers;
+};
+
+class tst_QGstreamerMediaCache : public QObject
+{
+    Q_OBJECT
+public slots:
+    void init();
+    void cleanup();
+
+private slots:
+    void downloadAndReplay();
+    void resumePartialEntry();
+    void seek();
+    void contentChanged();
+    void serverWithoutRanges();
+    void eviction();
+    void entryLargerThanCache();
+    void responseWithoutLength();
+    void indexPersists();
+
+private:
+    static QByteArray makeContent(int size, int seed);
+    static QByteArray readAll(QIODevice *device, qint64 maxSize = -1);
+    void download(QGstreamerMediaCache *cache, const QUrl &url);
+
+    QTemporaryDir *m_directory;
+    HttpStandIn *m_server;
+    QNetworkAccessManager *m_manager;
+};
+
+void tst_QGstreamerMediaCache::init()
+{
+    m_directory = new QTemporaryDir;
+    QVERIFY(m_directory->isValid());
+
+    m_server = new HttpStandIn;
+    QVERIFY(m_server->isListening());
+
+    HttpStandIn::Resource resource;
+    resource.content = makeContent(1024 * 1024, 1);
+    resource.etag = "\"v1\"";
+    m_server->resources.insert("/clip", resource);
+
+    m_manager = new QNetworkAccessManager;
+}
+
+void tst_QGstreamerMediaCache::cleanup()
+{
+    delete m_manager;
+    delete m_server;
+    delete m_directory;
+}
+
+QByteArray tst_QGstreamerMediaCache::makeContent(int size, int seed)
+{
+    QByteArray content(size, Qt::Uninitialized);
+    quint32 value = seed;
+    for (int i = 0; i < size; ++i) {
+        value = value * 1103515245 + 12345;
+        content[i] = char(value >> 16);
+    }
+    return content;
+}
+
+QByteArray tst_QGstreamerMediaCache::readAll(QIODevice *device, qint64 maxSize)
+{
+    QByteArray result;
+    QSignalSpy readyRead(device, SIGNAL(readyRead()));
+
+    while (!device->atEnd() && (maxSize < 0 || result.size() < maxSize)) {
+        if (device->bytesAvailable() > 0) {
+            const qint64 wanted = maxSize < 0 ? device->bytesAvailable()
+                                              : qMin(device->bytesAvailable(), maxSize - result.size());
+            result += device->read(wanted);
+        } else if (!readyRead.wait(5000)) {
+            break;
+        }
+    }
+
+    return result;
+}
+
+void tst_QGstreamerMediaCache::download(QGstreamerMediaCache *cache, const QUrl &url)
+{
+    QGstreamerCachedMediaDevice device(m_manager, QNetworkRequest(url), cache);
+    readAll(&device);
+    QTRY_COMPARE(device.cachedRanges(), QMediaTimeRange(0, device.size() - 1));
+}
+
+void tst_QGstreamerMediaCache::downloadAndReplay()
+{
+    QGstreamerMediaCache cache(m_directory->path(), 16 * 1024 * 1024);
+    const QByteArray content = m_server->resources.value("/clip").content;
+
+    {
+        QGstreamerCachedMediaDevice device(m_manager, QNetworkRequest(m_server->url("/clip")), &cache);
+        QCOMPARE(readAll(&device), content);
+        QCOMPARE(device.size(), qint64(content.size()));
+        QCOMPARE(device.bytesDownloaded(), qint64(content.size()));
+    }
+
+    QCOMPARE(cache.size(), qint64(content.size()));
+
+    // The replay only revalidates the cached file
+    m_server->resetCounters();
+    {
+        QGstreamerCachedMediaDevice device(m_manager, QNetworkRequest(m_server->url("/clip")), &cache);
+        QCOMPARE(readAll(&device), content);
+        QCOMPARE(device.bytesDownloaded(), qint64(0));
+    }
+
+    QCOMPARE(m_server->requestCount, 1);
+    QCOMPARE(m_server->statusCodes.value(0), 304);
+    QCOMPARE(m_server->bodyBytes, qint64(0));
+}
+
+void tst_QGstreamerMediaCache::resumePartialEntry()
+{
+    QGstreamerMediaCache cache(m_directory->path(), 16 * 1024 * 1024);
+    const QUrl url = m_server->url("/clip");
+    const QByteArray content = m_server->resources.value("/clip").content;
+
+    cache.acquire(url);
+    cache.reset(url, "\"v1\"", content.size());
+    QVERIFY(cache.write(url, 0, content.constData(), 1000));
+    QVERIFY(cache.write(url, 500000, content.constData() + 500000, 1000));
+    cache.release(url);
+
+    m_server->resetCounters();
+
+    QGstreamerCachedMediaDevice device(m_manager, QNetworkRequest(url), &cache);
+    QCOMPARE(readAll(&device), content);
+
+    // Only the missing ranges are downloaded, validated against the ETag
+    QCOMPARE(m_server->bodyBytes, qint64(content.size() - 2000));
+    QCOMPARE(m_server->statusCodes.value(0), 206);
+    QCOMPARE(m_server->requestHeaders.value(0).value("range"), QByteArray("bytes=1000-499999"));
+    QCOMPARE(m_server->requestHeaders.value(0).value("if-range"), QByteArray("\"v1\""));
+}
+
+void tst_QGstreamerMediaCache::seek()
+{
+    QGstreamerMediaCache cache(m_directory->path(), 16 * 1024 * 1024);
+    const QByteArray content = m_server->resources.value("/clip").content;
+
+    QGstreamerCachedMediaDevice device(m_manager, QNetworkRequest(m_server->url("/clip")), &cache);
+    QCOMPARE(readAll(&device, 1000), content.left(1000));
+
+    QVERIFY(device.seek(700000));
+    QCOMPARE(readAll(&device, 1000), content.mid(700000, 1000));
+
+    QVERIFY(device.seek(100));
+    QCOMPARE(readAll(&device, 1000), content.mid(100, 1000));
+
+    QTRY_COMPARE(device.cachedRanges(), QMediaTimeRange(0, content.size() - 1));
+}
+
+void tst_QGstreamerMediaCache::contentChanged()
+{
+    QGstreamerMediaCache cache(m_directory->path(), 16 * 1024 * 1024);
+    const QUrl url = m_server->url("/clip");
+
+    download(&cache, url);
+
+    HttpStandIn::Resource resource;
+    resource.content = makeContent(300000, 2);
+    resource.etag = "\"v2\"";
+    m_server->resources.insert("/clip", resource);
+
+    QGstreamerCachedMediaDevice device(m_manager, QNetworkRequest(url), &cache);
+    QCOMPARE(readAll(&device), resource.content);
+    QCOMPARE(device.size(), qint64(resource.content.size()));
+
+    QCOMPARE(cache.acquire(url).etag, QByteArray("\"v2\""));
+    cache.release(url);
+}
+
+void tst_QGstreamerMediaCache::serverWithoutRanges()
+{
+    QGstreamerMediaCache cache(m_directory->path(), 16 * 1024 * 1024);
+    const QUrl url = m_server->url("/clip");
+    const QByteArray content = m_server->resources.value("/clip").content;
+
+    cache.acquire(url);
+    cache.reset(url, "\"v1\"", content.size());
+    QVERIFY(cache.write(url, 0, content.constData(), 1000));
+    cache.release(url);
+
+    m_server->rangeSupport = false;
+
+    QGstreamerCachedMediaDevice device(m_manager, QNetworkRequest(url), &cache);
+    QCOMPARE(readAll(&device), content);
+    QCOMPARE(m_server->statusCodes.last(), 200);
+}
+
+void tst_QGstreamerMediaCache::eviction()
+{
+    HttpStandIn::Resource resource;
+    resource.content = makeContent(1024 * 1024, 3);
+    resource.etag = "\"other\"";
+    m_server->resources.insert("/other", resource);
+
+    QGstreamerMediaCache cache(m_directory->path(), 1536 * 1024);
+
+    download(&cache, m_server->url("/clip"));
+    QCOMPARE(cache.size(), qint64(1024 * 1024));
+
+    QTest::qWait(10);
+
+    // Caching the second file evicts the least recently used one
+    download(&cache, m_server->url("/other"));
+    QCOMPARE(cache.size(), qint64(1024 * 1024));
+
+    QVERIFY(cache.acquire(m_server->url("/clip")).ranges.isEmpty());
+    cache.release(m_server->url("/clip"));
+    QCOMPARE(cache.acquire(m_server->url("/other")).ranges, QMediaTimeRange(0, 1024 * 1024 - 1));
+    cache.release(m_server->url("/other"));
+}
+
+void tst_QGstreamerMediaCache::entryLargerThanCache()
+{
+    QGstreamerMediaCache cache(m_directory->path(), 512 * 1024);
+    const QUrl url = m_server->url("/clip");
+    const QByteArray content = m_server->resources.value("/clip").content;
+
+    // The entry in use can't be evicted, so the cache refuses what doesn't fit
+    cache.acquire(url);
+    cache.reset(url, "\"v1\"", content.size());
+    QVERIFY(cache.write(url, 0, content.constData(), 512 * 1024));
+    QVERIFY(!cache.write(url, 512 * 1024, content.constData() + 512 * 1024, 1000));
+    QCOMPARE(cache.size(), qint64(512 * 1024));
+    cache.remove(url);
+    cache.release(url);
+
+    // The device stops caching and plays the rest from the network
+    {
+        QGstreamerCachedMediaDevice device(m_manager, QNetworkRequest(url), &cache);
+        QCOMPARE(readAll(&device), content);
+        QVERIFY(device.cachedRanges().isEmpty());
+        QVERIFY(cache.size() <= cache.maximumSize());
+    }
+
+    QCOMPARE(cache.size(), qint64(0));
+}
+
+void tst_QGstreamerMediaCache::responseWithoutLength()
+{
+    QGstreamerMediaCache cache(m_directory->path(), 16 * 1024 * 1024);
+    const QUrl url = m_server->url("/clip");
+    const QByteArray content = m_server->resources.value("/clip").content;
+
+    m_server->rangeSupport = false;
+    m_server->contentLength = false;
+
+    QGstreamerCachedMediaDevice device(m_manager, QNetworkRequest(url), &cache);
+    QCOMPARE(readAll(&device), content);
+    QVERIFY(device.cachedRanges().isEmpty());
+    QCOMPARE(cache.size(), qint64(0));
+}
+
+void tst_QGstreamerMediaCache::indexPersists()
+{
+    const QUrl url = m_server->url("/clip");
+    const QByteArray content = m_server->resources.value("/clip").content;
+
+    {
+        QGstreamerMediaCache cache(m_directory->path(), 16 * 1024 * 1024);
+        download(&cache, url);
+    }
+
+    QGstreamerMediaCache cache(m_directory->path(), 16 * 1024 * 1024);
+    QCOMPARE(cache.size(), qint64(content.size()));
+
+    const QGstreamerMediaCache::Entry entry = cache.acquire(url);
+    QCOMPARE(entry.etag, QByteArray("\"v1\""));
+    QCOMPARE(entry.totalSize, qint64(content.size()));
+    QCOMPARE(entry.ranges, QMediaTimeRange(0, content.size() - 1));
+
+    QByteArray data(content.size(), Qt::Uninitialized);
+    QCOMPARE(cache.read(url, 0, data.data(), data.size()), qint64(content.size()));
+    QCOMPARE(data, content);
+    cache.release(url);
+}
+
+QTEST_MAIN(tst_QGstreamerMediaCache)
+
+#include "tst_qgstreamermediacache.moc"
@@ -0,0 +1,15 @@
+TARGET = tst_qgstreamervideorenderersink
+
+QT += multimedia-private testlib
+CONFIG += testcase
+
+CONFIG += link_pkgconfig
+PKGCONFIG += \
+    gstreamer-$$GST_VERSION \
+    gstreamer-base-$$GST_VERSION \
+    gstreamer-video-$$GST_VERSION
+
+LIBS += -lqgsttools_p
+
+SOURCES += \
+        tst_qgstreamervideorenderersink.cpp
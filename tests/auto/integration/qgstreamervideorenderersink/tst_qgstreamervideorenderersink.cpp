@@ -0,0 +1,349 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the test suite of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+//TESTED_COMPONENT=src/gsttools
+
+#include <QtTest/QtTest>
+#include <QtMultimedia/qabstractvideosurface.h>
+
+#include <gst/gst.h>
+
+#if GST_CHECK_VERSION(1,0,0)
+#include <private/qgstvideorenderersink_p.h>
+#endif
+
+QT_USE_NAMESPACE
+
+/*
+    Accepts RGB32 frames and records the frames presented, identified by
+    their start time in milliseconds. Presenting can be made slow.
+*/
+class SlowVideoSurface : public QAbstractVideoSurface
+{
+    Q_OBJECT
+public:
+    SlowVideoSurface() : presentDelay(0), presentResult(true) {}
+
+    QList<QVideoFrame::PixelFormat> supportedPixelFormats(
+            QAbstractVideoBuffer::HandleType handleType) const
+    {
+        QList<QVideoFrame::PixelFormat> formats;
+        if (handleType == QAbstractVideoBuffer::NoHandle)
+            formats << QVideoFrame::Format_RGB32;
+        return formats;
+    }
+
+    bool present(const QVideoFrame &frame)
+    {
+        if (!frame.isValid())
+            return true;
+        if (presentDelay > 0)
+            QTest::qSleep(presentDelay);
+        presentedFrames.append(int(frame.startTime() / 1000));
+        return presentResult;
+    }
+
+    QList<int> presentedFrames;
+    int presentDelay;
+    bool presentResult;
+};
+
+class tst_QGstreamerVideoRendererSink : public QObject
+{
+    Q_OBJECT
+public slots:
+    void initTestCase();
+
+private slots:
+    void blockingByDefault();
+    void dropFrames_data();
+    void dropFrames();
+    void presentFailure();
+    void flushClearsQueue();
+    void slowSurface_data();
+    void slowSurface();
+};
+
+#if GST_CHECK_VERSION(1,0,0)
+static GstBuffer *createFrame(int number)
+{
+    GstBuffer *buffer = gst_buffer_new_allocate(0, 16 * 16 * 4, 0);
+    GST_BUFFER_PTS(buffer) = number * GST_MSECOND;
+    GST_BUFFER_DURATION(buffer) = GST_MSECOND;
+    return buffer;
+}
+
+static void renderFrame(QVideoSurfaceGstDelegate *delegate, int number,
+                        GstFlowReturn expected = GST_FLOW_OK)
+{
+    GstBuffer *buffer = createFrame(number);
+    QCOMPARE(delegate->render(buffer), expected);
+    gst_buffer_unref(buffer);
+}
+
+static bool startDelegate(QVideoSurfaceGstDelegate *delegate)
+{
+    GstCaps *caps = gst_caps_from_string(
+                "video/x-raw, format=(string)BGRx, width=(int)16, height=(int)16, framerate=(fraction)30/1");
+    // Started on the surface's thread, this completes synchronously
+    const bool started = delegate->start(caps);
+    gst_caps_unref(caps);
+    return started;
+}
+
+class FrameProducer : public QThread
+{
+public:
+    FrameProducer(QVideoSurfaceGstDelegate *delegate, int count, int interval)
+        : delegate(delegate), count(count), interval(interval) {}
+
+    void run()
+    {
+        for (int i = 0; i < count; ++i) {
+            GstBuffer *buffer = createFrame(i);
+            delegate->render(buffer);
+            gst_buffer_unref(buffer);
+            msleep(interval);
+        }
+    }
+
+    QVideoSurfaceGstDelegate * const delegate;
+    const int count;
+    const int interval;
+};
+
+Q_DECLARE_METATYPE(QVideoSurfaceGstDelegate::FrameDropPolicy)
+#endif
+
+void tst_QGstreamerVideoRendererSink::initTestCase()
+{
+    qunsetenv("QT_GSTREAMER_VIDEO_FRAME_QUEUE");
+    gst_init(NULL, NULL);
+}
+
+void tst_QGstreamerVideoRendererSink::blockingByDefault()
+{
+#if GST_CHECK_VERSION(1,0,0)
+    SlowVideoSurface surface;
+    QVideoSurfaceGstDelegate delegate(&surface);
+    QCOMPARE(delegate.frameQueueDepth(), 0);
+    QVERIFY(startDelegate(&delegate));
+    QVERIFY(surface.isActive());
+
+    // Without a queue each frame is presented before render() returns
+    renderFrame(&delegate, 1);
+    renderFrame(&delegate, 2);
+    QCOMPARE(surface.presentedFrames, QList<int>() << 1 << 2);
+    QCOMPARE(delegate.frameQueueStatistics().presentedFrames, 0);
+
+    delegate.stop();
+    QVERIFY(!surface.isActive());
+#else
+    QSKIP("Requires GStreamer 1.0");
+#endif
+}
+
+void tst_QGstreamerVideoRendererSink::dropFrames_data()
+{
+#if GST_CHECK_VERSION(1,0,0)
+    QTest::addColumn<QVideoSurfaceGstDelegate::FrameDropPolicy>("policy");
+    QTest::addColumn<QList<int> >("expectedFrames");
+    QTest::addColumn<int>("droppedOldest");
+    QTest::addColumn<int>("droppedNewest");
+
+    QTest::newRow("drop oldest") << QVideoSurfaceGstDelegate::DropOldestFrame
+                                 << (QList<int>() << 7 << 8 << 9) << 7 << 0;
+    QTest::newRow("drop newest") << QVideoSurfaceGstDelegate::DropNewestFrame
+                                 << (QList<int>() << 0 << 1 << 2) << 0 << 7;
+#endif
+}
+
+void tst_QGstreamerVideoRendererSink::dropFrames()
+{
+#if GST_CHECK_VERSION(1,0,0)
+    QFETCH(QVideoSurfaceGstDelegate::FrameDropPolicy, policy);
+    QFETCH(QList<int>, expectedFrames);
+    QFETCH(int, droppedOldest);
+    QFETCH(int, droppedNewest);
+
+    SlowVideoSurface surface;
+    QVideoSurfaceGstDelegate delegate(&surface);
+    delegate.setFrameQueue(3, policy);
+    QCOMPARE(delegate.frameQueueDepth(), 3);
+    QCOMPARE(delegate.frameDropPolicy(), policy);
+    QVERIFY(startDelegate(&delegate));
+
+    // The surface's thread doesn't get to present anything while these arrive
+    for (int i = 0; i < 10; ++i)
+        renderFrame(&delegate, i);
+    QVERIFY(surface.presentedFrames.isEmpty());
+
+    QVideoSurfaceGstDelegate::FrameQueueStatistics stats = delegate.frameQueueStatistics();
+    QCOMPARE(stats.depth, 3);
+    QCOMPARE(stats.queuedFrames, 3);
+    QCOMPARE(stats.presentedFrames, 0);
+    QCOMPARE(stats.droppedOldestFrames, droppedOldest);
+    QCOMPARE(stats.droppedNewestFrames, droppedNewest);
+
+    QTRY_COMPARE(surface.presentedFrames.count(), 3);
+    QCOMPARE(surface.presentedFrames, expectedFrames);
+
+    stats = delegate.frameQueueStatistics();
+    QCOMPARE(stats.queuedFrames, 0);
+    QCOMPARE(stats.presentedFrames, 3);
+    QCOMPARE(stats.droppedOldestFrames, droppedOldest);
+    QCOMPARE(stats.droppedNewestFrames, droppedNewest);
+    QVERIFY(stats.maximumLatency >= stats.lastLatency);
+    QVERIFY(stats.maximumLatency >= stats.averageLatency);
+
+    delegate.stop();
+#else
+    QSKIP("Requires GStreamer 1.0");
+#endif
+}
+
+void tst_QGstreamerVideoRendererSink::presentFailure()
+{
+#if GST_CHECK_VERSION(1,0,0)
+    SlowVideoSurface surface;
+    surface.presentResult = false;
+    QVideoSurfaceGstDelegate delegate(&surface);
+    delegate.setFrameQueue(2);
+    QVERIFY(startDelegate(&delegate));
+
+    renderFrame(&delegate, 0);
+    QTRY_COMPARE(surface.presentedFrames.count(), 1);
+
+    // The failure is reported by the next frame, and only once
+    renderFrame(&delegate, 1, GST_FLOW_ERROR);
+    renderFrame(&delegate, 2);
+    QTRY_COMPARE(surface.presentedFrames, QList<int>() << 0 << 2);
+
+    delegate.stop();
+#else
+    QSKIP("Requires GStreamer 1.0");
+#endif
+}
+
+void tst_QGstreamerVideoRendererSink::flushClearsQueue()
+{
+#if GST_CHECK_VERSION(1,0,0)
+    SlowVideoSurface surface;
+    QVideoSurfaceGstDelegate delegate(&surface);
+    delegate.setFrameQueue(4);
+    QVERIFY(startDelegate(&delegate));
+
+    for (int i = 0; i < 3; ++i)
+        renderFrame(&delegate, i);
+    QCOMPARE(delegate.frameQueueStatistics().queuedFrames, 3);
+
+    delegate.flush();
+    QCOMPARE(delegate.frameQueueStatistics().queuedFrames, 0);
+
+    renderFrame(&delegate, 10);
+    QTRY_COMPARE(delegate.frameQueueStatistics().presentedFrames, 1);
+    QCOMPARE(surface.presentedFrames, QList<int>() << 10);
+
+    const QVideoSurfaceGstDelegate::FrameQueueStatistics stats = delegate.frameQueueStatistics();
+    QCOMPARE(stats.droppedOldestFrames, 0);
+    QCOMPARE(stats.droppedNewestFrames, 0);
+
+    delegate.stop();
+#else
+    QSKIP("Requires GStreamer 1.0");
+#endif
+}
+
+void tst_QGstreamerVideoRendererSink::slowSurface_data()
+{
+#if GST_CHECK_VERSION(1,0,0)
+    QTest::addColumn<QVideoSurfaceGstDelegate::FrameDropPolicy>("policy");
+
+    QTest::newRow("drop oldest") << QVideoSurfaceGstDelegate::DropOldestFrame;
+    QTest::newRow("drop newest") << QVideoSurfaceGstDelegate::DropNewestFrame;
+#endif
+}
+
+/*
+    Frames arrive from a streaming thread four times as fast as the surface
+    presents them. Every frame is either presented or counted as dropped.
+*/
+void tst_QGstreamerVideoRendererSink::slowSurface()
+{
+#if GST_CHECK_VERSION(1,0,0)
+    QFETCH(QVideoSurfaceGstDelegate::FrameDropPolicy, policy);
+
+    SlowVideoSurface surface;
+    surface.presentDelay = 20;
+    QVideoSurfaceGstDelegate delegate(&surface);
+    delegate.setFrameQueue(3, policy);
+    QVERIFY(startDelegate(&delegate));
+
+    const int count = 60;
+    FrameProducer producer(&delegate, count, 5);
+    producer.start();
+    QTRY_VERIFY(producer.isFinished());
+    QTRY_COMPARE(delegate.frameQueueStatistics().queuedFrames, 0);
+
+    const QVideoSurfaceGstDelegate::FrameQueueStatistics stats = delegate.frameQueueStatistics();
+    QCOMPARE(stats.presentedFrames, surface.presentedFrames.count());
+    QCOMPARE(stats.presentedFrames + stats.droppedOldestFrames + stats.droppedNewestFrames, count);
+    QVERIFY(stats.presentedFrames < count);
+
+    if (policy == QVideoSurfaceGstDelegate::DropOldestFrame) {
+        QCOMPARE(stats.droppedNewestFrames, 0);
+        QVERIFY(stats.droppedOldestFrames > 0);
+        // The most recent frame always makes it to the surface
+        QCOMPARE(surface.presentedFrames.last(), count - 1);
+    } else {
+        QCOMPARE(stats.droppedOldestFrames, 0);
+        QVERIFY(stats.droppedNewestFrames > 0);
+        QCOMPARE(surface.presentedFrames.first(), 0);
+    }
+
+    // Frames are presented in order, none of them twice
+    for (int i = 1; i < surface.presentedFrames.count(); ++i)
+        QVERIFY(surface.presentedFrames.at(i - 1) < surface.presentedFrames.at(i));
+
+    // Presenting waits for the surface, so frames queue up for a while
+    QVERIFY(stats.maximumLatency >= 10000);
+
+    delegate.stop();
+#else
+    QSKIP("Requires GStreamer 1.0");
+#endif
+}
+
+QTEST_MAIN(tst_QGstreamerVideoRendererSink)
+
+#include "tst_qgstreamervideorenderersink.moc"
@@ -0,0 +1,7 @@
+TARGET = tst_qsgvideotextureuploader
+
+QT += gui multimedia-private qtmultimediaquicktools-private testlib
+CONFIG += testcase
+
+SOURCES += \
+        tst_qsgvideotextureuploader.cpp
@@ -0,0 +1,239 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+//TESTED_COMPONENT=src/qtmultimediaquicktools
+
+#include <QtTest/QtTest>
+
+#include <QtGui/qoffscreensurface.h>
+#include <QtGui/qopenglcontext.h>
+#include <QtGui/qopenglfunctions.h>
+
+#include <private/qsgvideotextureuploader_p.h>
+
+Q_DECLARE_METATYPE(QSGVideoTextureUploader::UploadMode)
+
+// Runs against whatever OpenGL implementation is available, a software
+// rasterizer such as Mesa llvmpipe (LIBGL_ALWAYS_SOFTWARE=1) is enough.
+class tst_QSGVideoTextureUploader : public QObject
+{
+    Q_OBJECT
+public:
+    tst_QSGVideoTextureUploader()
+        : m_context(0)
+        , m_surface(0)
+    {
+    }
+
+public slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+private slots:
+    void upload_data();
+    void upload();
+    void reallocate();
+    void uploadTime_data();
+    void uploadTime();
+
+private:
+    static QByteArray pattern(int width, int height, int bytesPerPixel, int seed);
+    QByteArray readTexture(GLuint texture, int width, int height);
+
+    QOpenGLContext *m_context;
+    QOffscreenSurface *m_surface;
+};
+
+void tst_QSGVideoTextureUploader::initTestCase()
+{
+    m_surface = new QOffscreenSurface;
+    m_surface->create();
+
+    m_context = new QOpenGLContext;
+    if (!m_context->create() || !m_context->makeCurrent(m_surface))
+        QSKIP("No OpenGL context available");
+
+    qDebug() << "OpenGL" << reinterpret_cast<const char *>(m_context->functions()->glGetString(GL_RENDERER))
+             << "pixel buffers" << QSGVideoTextureUploader::isPixelBufferUploadSupported(m_context);
+}
+
+void tst_QSGVideoTextureUploader::cleanupTestCase()
+{
+    if (m_context)
+        m_context->doneCurrent();
+    delete m_context;
+    delete m_surface;
+}
+
+QByteArray tst_QSGVideoTextureUploader::pattern(int width, int height, int bytesPerPixel, int seed)
+{
+    QByteArray data(width * height * bytesPerPixel, Qt::Uninitialized);
+    for (int i = 0; i < data.size(); ++i)
+        data[i] = char((i * 7 + seed * 13) & 0xff);
+    return data;
+}
+
+QByteArray tst_QSGVideoTextureUploader::readTexture(GLuint texture, int width, int height)
+{
+    QOpenGLFunctions *functions = m_context->functions();
+
+    GLuint fbo = 0;
+    functions->glGenFramebuffers(1, &fbo);
+    functions->glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    functions->glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
+
+    QByteArray data(width * height * 4, Qt::Uninitialized);
+    functions->glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    functions->glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, data.data());
+
+    functions->glBindFramebuffer(GL_FRAMEBUFFER, m_context->defaultFramebufferObject());
+    functions->glDeleteFramebuffers(1, &fbo);
+    return data;
+}
+
+void tst_QSGVideoTextureUploader::upload_data()
+{
+    QTest::addColumn<QSGVideoTextureUploader::UploadMode>("mode");
+
+    QTest::newRow("direct") << QSGVideoTextureUploader::DirectUpload;
+    QTest::newRow("pixel buffers") << QSGVideoTextureUploader::PixelBufferUpload;
+}
+
+void tst_QSGVideoTextureUploader::upload()
+{
+    QFETCH(QSGVideoTextureUploader::UploadMode, mode);
+
+    const int width = 64;
+    const int height = 48;
+
+    QSGVideoTextureUploader uploader;
+    uploader.setUploadMode(mode);
+    m_context->functions()->glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    // Several frames, so that both pixel buffers are cycled through
+    for (int frame = 0; frame < 4; ++frame) {
+        const QByteArray data = pattern(width, height, 4, frame);
+
+        uploader.beginFrame();
+        uploader.uploadPlane(0, width, height, GL_RGBA, GL_UNSIGNED_BYTE,
+                             reinterpret_cast<const uchar *>(data.constData()));
+        uploader.endFrame();
+
+        QVERIFY(uploader.textureId(0) != 0);
+        QCOMPARE(readTexture(uploader.textureId(0), width, height), data);
+    }
+
+    QCOMPARE(uploader.frameCount(), 4);
+    QVERIFY(uploader.averageUploadTime() > 0);
+}
+
+void tst_QSGVideoTextureUploader::reallocate()
+{
+    QSGVideoTextureUploader uploader;
+    m_context->functions()->glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    const QByteArray large = pattern(64, 64, 4, 1);
+    uploader.beginFrame();
+    uploader.uploadPlane(0, 64, 64, GL_RGBA, GL_UNSIGNED_BYTE,
+                         reinterpret_cast<const uchar *>(large.constData()));
+    uploader.endFrame();
+
+    const GLuint texture = uploader.textureId(0);
+
+    // A size change reallocates the storage of the same texture
+    const QByteArray small = pattern(32, 16, 4, 2);
+    uploader.beginFrame();
+    uploader.uploadPlane(0, 32, 16, GL_RGBA, GL_UNSIGNED_BYTE,
+                         reinterpret_cast<const uchar *>(small.constData()));
+    uploader.endFrame();
+
+    QCOMPARE(uploader.textureId(0), texture);
+    QCOMPARE(readTexture(texture, 32, 16), small);
+
+    uploader.releaseResources();
+    QCOMPARE(uploader.textureId(0), GLuint(0));
+}
+
+void tst_QSGVideoTextureUploader::uploadTime_data()
+{
+    QTest::addColumn<QSGVideoTextureUploader::UploadMode>("mode");
+    QTest::addColumn<QSize>("size");
+    QTest::addColumn<bool>("planar");
+
+    QTest::newRow("RGBA 1080p direct") << QSGVideoTextureUploader::DirectUpload << QSize(1920, 1080) << false;
+    QTest::newRow("RGBA 1080p pixel buffers") << QSGVideoTextureUploader::PixelBufferUpload << QSize(1920, 1080) << false;
+    QTest::newRow("YUV420P 1080p direct") << QSGVideoTextureUploader::DirectUpload << QSize(1920, 1080) << true;
+    QTest::newRow("YUV420P 1080p pixel buffers") << QSGVideoTextureUploader::PixelBufferUpload << QSize(1920, 1080) << true;
+}
+
+void tst_QSGVideoTextureUploader::uploadTime()
+{
+    QFETCH(QSGVideoTextureUploader::UploadMode, mode);
+    QFETCH(QSize, size);
+    QFETCH(bool, planar);
+
+    const int width = size.width();
+    const int height = size.height();
+    const QByteArray luma = pattern(width, height, planar ? 1 : 4, 0);
+    const QByteArray chroma = pattern(width / 2, height / 2, 1, 1);
+
+    QSGVideoTextureUploader uploader;
+    uploader.setUploadMode(mode);
+    QOpenGLFunctions *functions = m_context->functions();
+    functions->glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    QBENCHMARK {
+        uploader.beginFrame();
+        if (planar) {
+            const uchar *c = reinterpret_cast<const uchar *>(chroma.constData());
+            uploader.uploadPlane(1, width / 2, height / 2, GL_LUMINANCE, GL_UNSIGNED_BYTE, c);
+            uploader.uploadPlane(2, width / 2, height / 2, GL_LUMINANCE, GL_UNSIGNED_BYTE, c);
+            uploader.uploadPlane(0, width, height, GL_LUMINANCE, GL_UNSIGNED_BYTE,
+                                 reinterpret_cast<const uchar *>(luma.constData()));
+        } else {
+            uploader.uploadPlane(0, width, height, GL_RGBA, GL_UNSIGNED_BYTE,
+                                 reinterpret_cast<const uchar *>(luma.constData()));
+        }
+        uploader.endFrame();
+        // Include the transfer itself, not only the time to queue it
+        functions->glFinish();
+    }
+
+    qDebug("%d frames, average upload time %lld us", uploader.frameCount(),
+           uploader.averageUploadTime() / 1000);
+}
+
+QTEST_MAIN(tst_QSGVideoTextureUploader)
+
+#include "tst_qsgvideotextureuploader.moc"
@@ -0,0 +1,7 @@
+TARGET = tst_qvideofilterpipeline
+
+QT += multimedia-private qtmultimediaquicktools-private testlib
+CONFIG += testcase
+
+SOURCES += \
+        tst_qvideofilterpipeline.cpp
@@ -0,0 +1,294 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+//TESTED_COMPONENT=src/qtmultimediaquicktools
+
+#include <QtTest/QtTest>
+
+#include <private/qvideofilterpipeline_p.h>
+
+class RecordingRunnable : public QVideoFilterRunnable
+{
+public:
+    explicit RecordingRunnable(int delay = 0, bool replace = false)
+        : m_delay(delay), m_replace(replace), m_lastFlags(0) { }
+
+    QVideoFrame run(QVideoFrame *input, const QVideoSurfaceFormat &surfaceFormat, RunFlags flags) Q_DECL_OVERRIDE
+    {
+        Q_UNUSED(surfaceFormat);
+        {
+            QMutexLocker locker(&m_mutex);
+            m_order.append(input->startTime());
+            m_threads.insert(QThread::currentThread());
+            m_lastFlags = flags;
+        }
+        if (m_delay > 0)
+            QThread::msleep(m_delay);
+        if (!m_replace)
+            return *input;
+
+        QVideoFrame frame(QImage(16, 16, QImage::Format_ARGB32));
+        frame.setStartTime(input->startTime());
+        return frame;
+    }
+
+    QList<qint64> order() const { QMutexLocker locker(&m_mutex); return m_order; }
+    QSet<QThread *> threads() const { QMutexLocker locker(&m_mutex); return m_threads; }
+    RunFlags lastFlags() const { QMutexLocker locker(&m_mutex); return m_lastFlags; }
+
+private:
+    int m_delay;
+    bool m_replace;
+    mutable QMutex m_mutex;
+    QList<qint64> m_order;
+    QSet<QThread *> m_threads;
+    RunFlags m_lastFlags;
+};
+
+class UpdateCounter : public QObject
+{
+    Q_OBJECT
+public:
+    UpdateCounter() : updates(0) { }
+    int updates;
+
+public slots:
+    void update() { ++updates; }
+};
+
+class tst_QVideoFilterPipeline : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void stagesKeepOrder();
+    void boundedFramesInFlight();
+    void modifiedFrames();
+    void latency();
+    void clear();
+    void updateRequests();
+
+private:
+    QList<qint64> drain(QVideoFilterPipeline *pipeline, int frames);
+};
+
+static QVideoFrame frameAt(int index)
+{
+    QVideoFrame frame(QImage(16, 16, QImage::Format_ARGB32));
+    frame.setStartTime(index);
+    return frame;
+}
+
+// Plays the render thread until \a frames frames went through the pipeline,
+// returns the start times of the finished frames that were taken.
+QList<qint64> tst_QVideoFilterPipeline::drain(QVideoFilterPipeline *pipeline, int frames)
+{
+    QList<qint64> finished;
+    QElapsedTimer timer;
+    timer.start();
+    while (timer.elapsed() < 10000) {
+        pipeline->runRenderThreadStages();
+        QVideoFrame frame;
+        if (pipeline->takeFinishedFrame(&frame))
+            finished.append(frame.startTime());
+        if (pipeline->finishedFrameCount() >= frames && pipeline->framesInFlight() == 0)
+            break;
+        QTest::qWait(1);
+    }
+    return finished;
+}
+
+void tst_QVideoFilterPipeline::stagesKeepOrder()
+{
+    RecordingRunnable first(2);
+    RecordingRunnable second;
+    RecordingRunnable third(5);
+
+    QVideoFilterPipeline pipeline;
+    pipeline.setMaxFramesInFlight(64);
+    pipeline.setStages(QVector<QVideoFilterPipeline::Stage>()
+                       << QVideoFilterPipeline::Stage(&first, false)
+                       << QVideoFilterPipeline::Stage(&second, true)
+                       << QVideoFilterPipeline::Stage(&third, false, QVideoFilterRunnable::LastInChain));
+
+    const int count = 20;
+    QList<qint64> expected;
+    for (int i = 0; i < count; ++i) {
+        QVERIFY(pipeline.submit(frameAt(i), QVideoSurfaceFormat()));
+        expected.append(i);
+    }
+
+    const QList<qint64> finished = drain(&pipeline, count);
+    QCOMPARE(pipeline.finishedFrameCount(), count);
+    QCOMPARE(pipeline.framesInFlight(), 0);
+
+    QCOMPARE(first.order(), expected);
+    QCOMPARE(second.order(), expected);
+    QCOMPARE(third.order(), expected);
+
+    QVERIFY(!finished.isEmpty());
+    QCOMPARE(finished.last(), qint64(count - 1));
+    for (int i = 1; i < finished.count(); ++i)
+        QVERIFY(finished.at(i - 1) < finished.at(i));
+
+    QCOMPARE(second.threads(), QSet<QThread *>() << QThread::currentThread());
+    QVERIFY(!first.threads().contains(QThread::currentThread()));
+    QVERIFY(!third.threads().contains(QThread::currentThread()));
+    QCOMPARE(third.lastFlags(), QVideoFilterRunnable::RunFlags(QVideoFilterRunnable::LastInChain));
+}
+
+void tst_QVideoFilterPipeline::boundedFramesInFlight()
+{
+    RecordingRunnable slow(100);
+
+    QVideoFilterPipeline pipeline;
+    pipeline.setMaxFramesInFlight(2);
+    pipeline.setStages(QVector<QVideoFilterPipeline::Stage>()
+                       << QVideoFilterPipeline::Stage(&slow, false));
+
+    QVERIFY(pipeline.submit(frameAt(0), QVideoSurfaceFormat()));
+    QVERIFY(pipeline.submit(frameAt(1), QVideoSurfaceFormat()));
+    QVERIFY(!pipeline.submit(frameAt(2), QVideoSurfaceFormat()));
+    QVERIFY(!pipeline.submit(frameAt(3), QVideoSurfaceFormat()));
+    QCOMPARE(pipeline.framesInFlight(), 2);
+    QCOMPARE(pipeline.droppedFrameCount(), 2);
+
+    drain(&pipeline, 2);
+    QCOMPARE(slow.order(), QList<qint64>() << 0 << 1);
+    QVERIFY(pipeline.submit(frameAt(4), QVideoSurfaceFormat()));
+    drain(&pipeline, 3);
+}
+
+void tst_QVideoFilterPipeline::modifiedFrames()
+{
+    RecordingRunnable passThrough;
+    RecordingRunnable replacing(0, true);
+
+    QVideoFilterPipeline pipeline;
+    pipeline.setMaxFramesInFlight(4);
+    pipeline.setStages(QVector<QVideoFilterPipeline::Stage>()
+                       << QVideoFilterPipeline::Stage(&passThrough, false));
+
+    const QVideoFrame input = frameAt(0);
+    QVERIFY(pipeline.submit(input, QVideoSurfaceFormat()));
+    QVideoFrame output;
+    bool modified = true;
+    QTRY_VERIFY(pipeline.takeFinishedFrame(&output, &modified));
+    QVERIFY(!modified);
+    QVERIFY(output == input);
+
+    pipeline.setStages(QVector<QVideoFilterPipeline::Stage>()
+                       << QVideoFilterPipeline::Stage(&passThrough, false)
+                       << QVideoFilterPipeline::Stage(&replacing, false));
+    QVERIFY(pipeline.submit(input, QVideoSurfaceFormat()));
+    QTRY_VERIFY(pipeline.takeFinishedFrame(&output, &modified));
+    QVERIFY(modified);
+    QVERIFY(output != input);
+    QCOMPARE(output.startTime(), input.startTime());
+}
+
+void tst_QVideoFilterPipeline::latency()
+{
+    RecordingRunnable fast;
+    RecordingRunnable slow(20);
+
+    QVideoFilterPipeline pipeline;
+    pipeline.setMaxFramesInFlight(4);
+    pipeline.setStages(QVector<QVideoFilterPipeline::Stage>()
+                       << QVideoFilterPipeline::Stage(&fast, true)
+                       << QVideoFilterPipeline::Stage(&slow, false));
+
+    for (int i = 0; i < 3; ++i)
+        QVERIFY(pipeline.submit(frameAt(i), QVideoSurfaceFormat()));
+    drain(&pipeline, 3);
+
+    QVERIFY(pipeline.lastStageLatency(1) >= 15000);
+    QVERIFY(pipeline.averageStageLatency(1) >= 15000);
+    QVERIFY(pipeline.averageStageLatency(0) < pipeline.averageStageLatency(1));
+    QVERIFY(pipeline.averageFrameLatency() >= pipeline.averageStageLatency(1));
+    QCOMPARE(pipeline.averageStageLatency(2), qint64(0));
+}
+
+void tst_QVideoFilterPipeline::clear()
+{
+    RecordingRunnable slow(50);
+
+    QVideoFilterPipeline pipeline;
+    pipeline.setMaxFramesInFlight(8);
+    pipeline.setStages(QVector<QVideoFilterPipeline::Stage>()
+                       << QVideoFilterPipeline::Stage(&slow, false));
+
+    for (int i = 0; i < 4; ++i)
+        QVERIFY(pipeline.submit(frameAt(i), QVideoSurfaceFormat()));
+    pipeline.clear();
+
+    QCOMPARE(pipeline.framesInFlight(), 0);
+    QVideoFrame frame;
+    QVERIFY(!pipeline.takeFinishedFrame(&frame));
+    // The frame being filtered when clearing is finished, the queued ones are not
+    QVERIFY(slow.order().count() <= 1);
+
+    // Without stages nothing is accepted
+    pipeline.setStages(QVector<QVideoFilterPipeline::Stage>());
+    QVERIFY(!pipeline.submit(frameAt(0), QVideoSurfaceFormat()));
+    QCOMPARE(pipeline.droppedFrameCount(), 0);
+}
+
+void tst_QVideoFilterPipeline::updateRequests()
+{
+    RecordingRunnable worker;
+    RecordingRunnable render;
+    UpdateCounter counter;
+
+    QVideoFilterPipeline pipeline(&counter);
+    pipeline.setMaxFramesInFlight(2);
+    pipeline.setStages(QVector<QVideoFilterPipeline::Stage>()
+                       << QVideoFilterPipeline::Stage(&worker, false)
+                       << QVideoFilterPipeline::Stage(&render, true));
+
+    QVERIFY(pipeline.submit(frameAt(0), QVideoSurfaceFormat()));
+    // The worker stage asks for the render thread once the frame reaches the next stage
+    QTRY_VERIFY(counter.updates > 0);
+    QVERIFY(render.order().isEmpty());
+    pipeline.runRenderThreadStages();
+    QCOMPARE(render.order(), QList<qint64>() << 0);
+
+    QVideoFrame frame;
+    QVERIFY(pipeline.takeFinishedFrame(&frame));
+    QCOMPARE(frame.startTime(), qint64(0));
+}
+
+QTEST_MAIN(tst_QVideoFilterPipeline)
+
+#include "tst_qvideofilterpipeline.moc"
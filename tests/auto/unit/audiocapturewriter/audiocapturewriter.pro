@@ -0,0 +1,15 @@
+CONFIG += testcase
+TARGET = tst_audiocapturewriter
+
+QT += multimedia-private testlib
+
+HEADERS += \
+    ../../../../src/plugins/audiocapture/audiocapturewriter.h \
+    ../../../../src/plugins/audiocapture/audiocaptureprobecontrol.h
+
+SOURCES += \
+    tst_audiocapturewriter.cpp \
+    ../../../../src/plugins/audiocapture/audiocapturewriter.cpp \
+    ../../../../src/plugins/audiocapture/audiocaptureprobecontrol.cpp
+
+INCLUDEPATH += ../../../../src/plugins/audiocapture
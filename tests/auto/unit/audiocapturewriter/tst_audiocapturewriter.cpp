@@ -0,0 +1,301 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the test suite of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+//TESTED_COMPONENT=src/plugins/audiocapture
+
+#include <QtTest/QtTest>
+#include <QtCore/QTemporaryDir>
+#include <QtCore/qendian.h>
+
+#include <qaudiobuffer.h>
+
+#include "audiocapturewriter.h"
+#include "audiocaptureprobecontrol.h"
+
+QT_USE_NAMESPACE
+
+static const int headerSize = 80;
+
+class ProbeCollector : public QObject
+{
+    Q_OBJECT
+public slots:
+    void audioBufferProbed(const QAudioBuffer &buffer)
+    {
+        buffers.append(buffer);
+    }
+
+public:
+    QList<QAudioBuffer> buffers;
+};
+
+class tst_AudioCaptureWriter : public QObject
+{
+    Q_OBJECT
+public slots:
+    void initTestCase();
+    void init();
+
+private slots:
+    void wavHeader_data();
+    void wavHeader();
+    void rf64Header();
+    void placeholderHeader();
+    void frameAlignedProbes_data();
+    void frameAlignedProbes();
+    void droppedFrames();
+
+private:
+    QTemporaryDir m_dir;
+};
+
+static QAudioFormat pcmFormat(int sampleRate, int channelCount, int sampleSize)
+{
+    QAudioFormat format;
+    format.setSampleRate(sampleRate);
+    format.setChannelCount(channelCount);
+    format.setSampleSize(sampleSize);
+    format.setSampleType(QAudioFormat::SignedInt);
+    format.setByteOrder(QAudioFormat::LittleEndian);
+    format.setCodec(QStringLiteral("audio/pcm"));
+    return format;
+}
+
+static quint16 read16(const QByteArray &header, int offset)
+{
+    return qFromLittleEndian<quint16>(reinterpret_cast<const uchar *>(header.constData() + offset));
+}
+
+static quint32 read32(const QByteArray &header, int offset)
+{
+    return qFromLittleEndian<quint32>(reinterpret_cast<const uchar *>(header.constData() + offset));
+}
+
+static quint64 read64(const QByteArray &header, int offset)
+{
+    return quint64(read32(header, offset)) | quint64(read32(header, offset + 4)) << 32;
+}
+
+static QByteArray sampleData(int size)
+{
+    QByteArray data(size, Qt::Uninitialized);
+    for (int i = 0; i < size; ++i)
+        data[i] = char((quint32(i) * 2654435761u) >> 24);
+    return data;
+}
+
+void tst_AudioCaptureWriter::initTestCase()
+{
+    qRegisterMetaType<QAudioBuffer>();
+    QVERIFY(m_dir.isValid());
+
+    // Small blocks so that a few hundred kilobytes span many of them
+    qputenv("QT_AUDIOCAPTURE_BLOCK_SIZE", "4096");
+}
+
+void tst_AudioCaptureWriter::init()
+{
+    qunsetenv("QT_AUDIOCAPTURE_BUFFER_DURATION");
+}
+
+void tst_AudioCaptureWriter::wavHeader_data()
+{
+    QTest::addColumn<int>("sampleRate");
+    QTest::addColumn<int>("channelCount");
+    QTest::addColumn<int>("sampleSize");
+    QTest::addColumn<qint64>("dataSize");
+
+    QTest::newRow("stereo 16 bit") << 44100 << 2 << 16 << qint64(176400);
+    QTest::newRow("5.1 16 bit") << 48000 << 6 << 16 << qint64(12 * 48000);
+    QTest::newRow("mono 24 bit") << 96000 << 1 << 24 << qint64(3 * 96000);
+    QTest::newRow("empty") << 8000 << 1 << 8 << qint64(0);
+    QTest::newRow("largest RIFF") << 48000 << 2 << 16 << qint64(0xFFFFFFFFu) - (headerSize - 8);
+}
+
+void tst_AudioCaptureWriter::wavHeader()
+{
+    QFETCH(int, sampleRate);
+    QFETCH(int, channelCount);
+    QFETCH(int, sampleSize);
+    QFETCH(qint64, dataSize);
+
+    const QByteArray header = AudioCaptureWriter::wavHeader(
+                pcmFormat(sampleRate, channelCount, sampleSize), dataSize);
+    QCOMPARE(header.size(), headerSize);
+
+    QCOMPARE(header.mid(0, 4), QByteArray("RIFF"));
+    QCOMPARE(read32(header, 4), quint32(dataSize + headerSize - 8));
+    QCOMPARE(header.mid(8, 4), QByteArray("WAVE"));
+
+    // Space reserved for a ds64 chunk, skipped by readers
+    QCOMPARE(header.mid(12, 4), QByteArray("JUNK"));
+    QCOMPARE(read32(header, 16), quint32(28));
+
+    QCOMPARE(header.mid(48, 4), QByteArray("fmt "));
+    QCOMPARE(read32(header, 52), quint32(16));
+    QCOMPARE(read16(header, 56), quint16(1));
+    QCOMPARE(int(read16(header, 58)), channelCount);
+    QCOMPARE(int(read32(header, 60)), sampleRate);
+    QCOMPARE(int(read32(header, 64)), sampleRate * channelCount * sampleSize / 8);
+    QCOMPARE(int(read16(header, 68)), channelCount * sampleSize / 8);
+    QCOMPARE(int(read16(header, 70)), sampleSize);
+
+    QCOMPARE(header.mid(72, 4), QByteArray("data"));
+    QCOMPARE(read32(header, 76), quint32(dataSize));
+}
+
+void tst_AudioCaptureWriter::rf64Header()
+{
+    const QAudioFormat format = pcmFormat(48000, 6, 24);
+    const qint64 dataSize = Q_INT64_C(5000000000) / 18 * 18;
+
+    const QByteArray header = AudioCaptureWriter::wavHeader(format, dataSize);
+    QCOMPARE(header.size(), headerSize);
+
+    QCOMPARE(header.mid(0, 4), QByteArray("RF64"));
+    QCOMPARE(read32(header, 4), quint32(0xFFFFFFFF));
+    QCOMPARE(header.mid(8, 4), QByteArray("WAVE"));
+
+    QCOMPARE(header.mid(12, 4), QByteArray("ds64"));
+    QCOMPARE(read32(header, 16), quint32(28));
+    QCOMPARE(read64(header, 20), quint64(dataSize + headerSize - 8));
+    QCOMPARE(read64(header, 28), quint64(dataSize));
+    QCOMPARE(read64(header, 36), quint64(dataSize / 18));
+    QCOMPARE(read32(header, 44), quint32(0));
+
+    QCOMPARE(header.mid(48, 4), QByteArray("fmt "));
+    QCOMPARE(read16(header, 68), quint16(18));
+
+    QCOMPARE(header.mid(72, 4), QByteArray("data"));
+    QCOMPARE(read32(header, 76), quint32(0xFFFFFFFF));
+}
+
+void tst_AudioCaptureWriter::placeholderHeader()
+{
+    const QByteArray header = AudioCaptureWriter::wavHeader(pcmFormat(44100, 2, 16), -1);
+
+    QCOMPARE(header.mid(0, 4), QByteArray("RIFF"));
+    QCOMPARE(read32(header, 4), quint32(0xFFFFFFFF));
+    QCOMPARE(header.mid(12, 4), QByteArray("JUNK"));
+    QCOMPARE(read32(header, 76), quint32(0xFFFFFFFF));
+}
+
+void tst_AudioCaptureWriter::frameAlignedProbes_data()
+{
+    QTest::addColumn<int>("channelCount");
+    QTest::addColumn<int>("sampleSize");
+
+    QTest::newRow("stereo 16 bit") << 2 << 16;
+    QTest::newRow("5.1 16 bit") << 6 << 16;
+    QTest::newRow("stereo 24 bit") << 2 << 24;
+    QTest::newRow("mono 24 bit") << 1 << 24;
+}
+
+void tst_AudioCaptureWriter::frameAlignedProbes()
+{
+    QFETCH(int, channelCount);
+    QFETCH(int, sampleSize);
+
+    const QAudioFormat format = pcmFormat(48000, channelCount, sampleSize);
+    const int bytesPerFrame = format.bytesPerFrame();
+    const QByteArray samples = sampleData(bytesPerFrame * 20000);
+    const QString fileName = m_dir.filePath(QStringLiteral("aligned.wav"));
+
+    AudioCaptureProbeControl probe(0);
+    ProbeCollector collector;
+    connect(&probe, SIGNAL(audioBufferProbed(QAudioBuffer)),
+            &collector, SLOT(audioBufferProbed(QAudioBuffer)));
+
+    AudioCaptureWriter writer;
+    writer.addProbe(&probe);
+    QVERIFY(writer.start(fileName, format, true));
+
+    // Written the way QAudioInput does, in periods of whole frames
+    const int period = bytesPerFrame * 100;
+    for (int offset = 0; offset < samples.size(); offset += period)
+        QCOMPARE(writer.write(samples.constData() + offset, period), qint64(period));
+    writer.stop();
+    writer.removeProbe(&probe);
+
+    QCOMPARE(writer.droppedFrames(), qint64(0));
+
+    QTRY_VERIFY(!collector.buffers.isEmpty());
+    QCoreApplication::processEvents();
+
+    QByteArray probed;
+    for (int i = 0; i < collector.buffers.size(); ++i) {
+        const QAudioBuffer &buffer = collector.buffers.at(i);
+        QCOMPARE(buffer.byteCount() % bytesPerFrame, 0);
+        probed.append(buffer.constData<char>(), buffer.byteCount());
+    }
+    QCOMPARE(probed.size(), samples.size());
+    QVERIFY(probed == samples);
+
+    QFile file(fileName);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    const QByteArray contents = file.readAll();
+    QCOMPARE(contents.size(), headerSize + samples.size());
+    QVERIFY(contents.mid(headerSize) == samples);
+    QCOMPARE(read32(contents, 76), quint32(samples.size()));
+}
+
+void tst_AudioCaptureWriter::droppedFrames()
+{
+    // The ring buffer falls back to its minimum of four blocks
+    qputenv("QT_AUDIOCAPTURE_BUFFER_DURATION", "0");
+    const int capacity = 4 * 4096;
+
+    const QAudioFormat format = pcmFormat(44100, 2, 16);
+    const QString fileName = m_dir.filePath(QStringLiteral("dropped.wav"));
+
+    AudioCaptureWriter writer;
+    QVERIFY(writer.start(fileName, format, true));
+
+    // Much more than fits at once, the writer must not block
+    const QByteArray samples = sampleData(1024 * 1024);
+    QCOMPARE(writer.write(samples), qint64(samples.size()));
+    QCOMPARE(writer.droppedFrames(), qint64((samples.size() - capacity) / 4));
+
+    writer.stop();
+    QCOMPARE(writer.droppedFrames(), qint64((samples.size() - capacity) / 4));
+
+    QFile file(fileName);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    const QByteArray contents = file.readAll();
+    QCOMPARE(contents.size(), headerSize + capacity);
+    QVERIFY(contents.mid(headerSize) == samples.left(capacity));
+}
+
+QTEST_MAIN(tst_AudioCaptureWriter)
+
+#include "tst_audiocapturewriter.moc"
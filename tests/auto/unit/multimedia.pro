@@ -34,4 +34,12 @@ SUBDIRS += \
     qaudiodecoder \
     qaudioprobe \
     qvideoprobe \
-    qsamplecache
+    qsamplecache \
+    qsoundeffectmixer \
+    qvideoframeconversion \
+    qvideobufferpool \
+    audiocapturewriter \
+    qaudioringbuffer \
+    qaudiodeviceregistry
+
+config_openal: SUBDIRS += qaudioengine
@@ -0,0 +1,11 @@
+CONFIG += testcase
+TARGET = tst_qaudiodeviceregistry
+
+QT += multimedia-private testlib
+
+# The mock audio plugin is linked into the test
+DEFINES += QT_STATICPLUGIN
+
+SOURCES += tst_qaudiodeviceregistry.cpp
+
+OTHER_FILES += mockaudioplugin.json
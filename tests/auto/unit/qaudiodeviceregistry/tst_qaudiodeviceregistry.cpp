@@ -0,0 +1,242 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the test suite of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+//TESTED_COMPONENT=src/multimedia
+
+#include <QtTest/QtTest>
+#include <QtCore/qmutex.h>
+#include <QtCore/qpluginloader.h>
+
+#include <qaudiodeviceinfo.h>
+#include <qaudiosystemplugin.h>
+#include <private/qaudiodevicefactory_p.h>
+
+QT_USE_NAMESPACE
+
+class MockAudioDeviceInfo : public QAbstractAudioDeviceInfo
+{
+public:
+    explicit MockAudioDeviceInfo(const QByteArray &handle)
+        : m_handle(handle)
+    {
+    }
+
+    QAudioFormat preferredFormat() const { return QAudioFormat(); }
+    bool isFormatSupported(const QAudioFormat &) const { return false; }
+    QString deviceName() const { return QString::fromLatin1(m_handle); }
+    QStringList supportedCodecs() { return QStringList(); }
+    QList<int> supportedSampleRates() { return QList<int>(); }
+    QList<int> supportedChannelCounts() { return QList<int>(); }
+    QList<int> supportedSampleSizes() { return QList<int>(); }
+    QList<QAudioFormat::Endian> supportedByteOrders() { return QList<QAudioFormat::Endian>(); }
+    QList<QAudioFormat::SampleType> supportedSampleTypes() { return QList<QAudioFormat::SampleType>(); }
+
+private:
+    QByteArray m_handle;
+};
+
+/*
+    An audio plugin whose device lists are set by the test. It announces
+    changes through availableDevicesChanged(), so the registry caches its
+    lists and only queries them again from a worker thread.
+*/
+class MockAudioPlugin : public QAudioSystemPlugin
+{
+    Q_OBJECT
+    Q_PLUGIN_METADATA(IID "org.qt-project.qt.audiosystemfactory/5.0" FILE "mockaudioplugin.json")
+
+public:
+    MockAudioPlugin()
+        : m_queryCount(0)
+    {
+        m_devices[QAudio::AudioInput] << "mock-in";
+        m_devices[QAudio::AudioOutput] << "mock-out";
+    }
+
+    QList<QByteArray> availableDevices(QAudio::Mode mode) const
+    {
+        QMutexLocker locker(&m_mutex);
+        ++m_queryCount;
+        return m_devices[mode];
+    }
+
+    QAbstractAudioInput *createInput(const QByteArray &) { return 0; }
+    QAbstractAudioOutput *createOutput(const QByteArray &) { return 0; }
+    QAbstractAudioDeviceInfo *createDeviceInfo(const QByteArray &device, QAudio::Mode)
+    {
+        return new MockAudioDeviceInfo(device);
+    }
+
+    void setDevices(QAudio::Mode mode, const QList<QByteArray> &devices)
+    {
+        m_mutex.lock();
+        m_devices[mode] = devices;
+        m_mutex.unlock();
+
+        emit availableDevicesChanged();
+    }
+
+    int queryCount() const
+    {
+        QMutexLocker locker(&m_mutex);
+        return m_queryCount;
+    }
+
+signals:
+    void availableDevicesChanged();
+
+private:
+    mutable QMutex m_mutex;
+    QList<QByteArray> m_devices[2];
+    mutable int m_queryCount;
+};
+
+Q_IMPORT_PLUGIN(MockAudioPlugin)
+
+class tst_QAudioDeviceRegistry : public QObject
+{
+    Q_OBJECT
+
+public slots:
+    void initTestCase();
+
+private slots:
+    void cachedDevices();
+    void hotplug();
+    void unchangedDevices();
+    void coalescedChanges();
+
+private:
+    static QList<QByteArray> mockDevices(QAudio::Mode mode);
+
+    MockAudioPlugin *m_plugin;
+};
+
+void tst_QAudioDeviceRegistry::initTestCase()
+{
+    qRegisterMetaType<QAudio::Mode>();
+
+    m_plugin = 0;
+    foreach (QObject *instance, QPluginLoader::staticInstances()) {
+        if ((m_plugin = qobject_cast<MockAudioPlugin *>(instance)))
+            break;
+    }
+    QVERIFY(m_plugin);
+    QVERIFY(QAudioDeviceRegistry::instance());
+}
+
+QList<QByteArray> tst_QAudioDeviceRegistry::mockDevices(QAudio::Mode mode)
+{
+    QList<QByteArray> handles;
+    foreach (const QAudioDeviceInfo &info, QAudioDeviceInfo::availableDevices(mode)) {
+        const QString name = info.deviceName();
+        if (name.startsWith(QLatin1String("mock-")))
+            handles << name.toLatin1();
+    }
+    return handles;
+}
+
+void tst_QAudioDeviceRegistry::cachedDevices()
+{
+    QCOMPARE(mockDevices(QAudio::AudioInput), QList<QByteArray>() << "mock-in");
+    QCOMPARE(mockDevices(QAudio::AudioOutput), QList<QByteArray>() << "mock-out");
+
+    // Listing again is served from the registry
+    const int queries = m_plugin->queryCount();
+    QCOMPARE(mockDevices(QAudio::AudioInput), QList<QByteArray>() << "mock-in");
+    QCOMPARE(mockDevices(QAudio::AudioOutput), QList<QByteArray>() << "mock-out");
+    QCOMPARE(m_plugin->queryCount(), queries);
+}
+
+void tst_QAudioDeviceRegistry::hotplug()
+{
+    QSignalSpy spy(QAudioDeviceRegistry::instance(), SIGNAL(availableDevicesChanged(QAudio::Mode)));
+
+    const QList<QByteArray> outputs = QList<QByteArray>() << "mock-out" << "mock-usb-out";
+    m_plugin->setDevices(QAudio::AudioOutput, outputs);
+
+    QTRY_COMPARE(spy.count(), 1);
+    QCOMPARE(spy.at(0).at(0).value<QAudio::Mode>(), QAudio::AudioOutput);
+    QCOMPARE(mockDevices(QAudio::AudioOutput), outputs);
+    QCOMPARE(mockDevices(QAudio::AudioInput), QList<QByteArray>() << "mock-in");
+
+    const QList<QByteArray> inputs = QList<QByteArray>() << "mock-in" << "mock-usb-in";
+    m_plugin->setDevices(QAudio::AudioInput, inputs);
+
+    QTRY_COMPARE(spy.count(), 2);
+    QCOMPARE(spy.at(1).at(0).value<QAudio::Mode>(), QAudio::AudioInput);
+    QCOMPARE(mockDevices(QAudio::AudioInput), inputs);
+    QCOMPARE(mockDevices(QAudio::AudioOutput), outputs);
+}
+
+void tst_QAudioDeviceRegistry::unchangedDevices()
+{
+    QSignalSpy spy(QAudioDeviceRegistry::instance(), SIGNAL(availableDevicesChanged(QAudio::Mode)));
+    const QList<QByteArray> inputs = mockDevices(QAudio::AudioInput);
+    const QList<QByteArray> outputs = mockDevices(QAudio::AudioOutput);
+
+    // A refresh which finds the same devices reports nothing; the change
+    // made afterwards is refreshed after it, so its signal must come first.
+    const int queries = m_plugin->queryCount();
+    m_plugin->setDevices(QAudio::AudioOutput, outputs);
+    QTRY_VERIFY(m_plugin->queryCount() >= queries + 2);
+
+    const QList<QByteArray> changedInputs = QList<QByteArray>() << "mock-in";
+    QVERIFY(changedInputs != inputs);
+    m_plugin->setDevices(QAudio::AudioInput, changedInputs);
+
+    QTRY_COMPARE(spy.count(), 1);
+    QCOMPARE(spy.at(0).at(0).value<QAudio::Mode>(), QAudio::AudioInput);
+    QCOMPARE(mockDevices(QAudio::AudioInput), changedInputs);
+    QCOMPARE(mockDevices(QAudio::AudioOutput), outputs);
+}
+
+void tst_QAudioDeviceRegistry::coalescedChanges()
+{
+    QSignalSpy spy(QAudioDeviceRegistry::instance(), SIGNAL(availableDevicesChanged(QAudio::Mode)));
+
+    // Back to back changes in both modes report each mode once
+    const QList<QByteArray> inputs = QList<QByteArray>() << "mock-dock-in";
+    const QList<QByteArray> outputs = QList<QByteArray>() << "mock-dock-out";
+    m_plugin->setDevices(QAudio::AudioInput, inputs);
+    m_plugin->setDevices(QAudio::AudioOutput, outputs);
+
+    QTRY_COMPARE(spy.count(), 2);
+    QVERIFY(spy.at(0).at(0).value<QAudio::Mode>() != spy.at(1).at(0).value<QAudio::Mode>());
+    QCOMPARE(mockDevices(QAudio::AudioInput), inputs);
+    QCOMPARE(mockDevices(QAudio::AudioOutput), outputs);
+}
+
+QTEST_MAIN(tst_QAudioDeviceRegistry)
+
+#include "tst_qaudiodeviceregistry.moc"
@@ -0,0 +1,26 @@
+CONFIG += testcase
+TARGET = tst_qaudioengine
+
+QT += multimedia-private network testlib
+
+win32: LIBS += -lOpenAL32
+unix:!mac:!blackberry: LIBS += -lopenal
+blackberry: LIBS += -lOpenAL
+mac: LIBS += -framework OpenAL
+mac: DEFINES += HEADER_OPENAL_PREFIX
+
+INCLUDEPATH += \
+        ../../../../src/imports/audioengine \
+        ../../../../src/multimedia/audio
+
+HEADERS += \
+        ../../../../src/imports/audioengine/qaudioengine_p.h \
+        ../../../../src/imports/audioengine/qsoundsource_p.h \
+        ../../../../src/imports/audioengine/qsoundbuffer_p.h \
+        ../../../../src/imports/audioengine/qaudioengine_openal_p.h
+
+SOURCES += \
+        tst_qaudioengine.cpp \
+        ../../../../src/imports/audioengine/qaudioengine_p.cpp \
+        ../../../../src/imports/audioengine/qsoundsource_openal_p.cpp \
+        ../../../../src/imports/audioengine/qaudioengine_openal_p.cpp
@@ -0,0 +1,319 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the test suite of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+//TESTED_COMPONENT=src/imports/audioengine
+
+#include <QtTest/QtTest>
+
+#include "qaudioengine_openal_p.h"
+
+QT_USE_NAMESPACE
+
+Q_DECLARE_METATYPE(QSoundSource::State)
+
+/*
+    A buffer of silence created directly, without going through the sample
+    cache, which remembers the OpenAL source it was last bound to.
+*/
+class SilentSoundBuffer : public QSoundBufferPrivateAL
+{
+public:
+    SilentSoundBuffer(int msecs, QObject *parent = 0)
+        : QSoundBufferPrivateAL(parent)
+        , m_alBuffer(0)
+        , m_boundSource(0)
+    {
+        const int sampleRate = 22050;
+        const QByteArray data(sampleRate * msecs / 1000 * 2, 0);
+        alGetError();
+        alGenBuffers(1, &m_alBuffer);
+        alBufferData(m_alBuffer, AL_FORMAT_MONO16, data.constData(), data.size(), sampleRate);
+    }
+
+    ~SilentSoundBuffer()
+    {
+        alDeleteBuffers(1, &m_alBuffer);
+    }
+
+    State state() const Q_DECL_OVERRIDE { return m_alBuffer ? Ready : Error; }
+    void load() Q_DECL_OVERRIDE {}
+
+    void bindToSource(ALuint alSource) Q_DECL_OVERRIDE
+    {
+        alSourcei(alSource, AL_BUFFER, m_alBuffer);
+        m_boundSource = alSource;
+    }
+
+    void unbindFromSource(ALuint alSource) Q_DECL_OVERRIDE
+    {
+        alSourcei(alSource, AL_BUFFER, 0);
+    }
+
+    ALuint boundSource() const { return m_boundSource; }
+
+private:
+    ALuint m_alBuffer;
+    ALuint m_boundSource;
+};
+
+static ALint alSourceInt(ALuint alSource, ALenum parameter)
+{
+    ALint value = 0;
+    alGetSourcei(alSource, parameter, &value);
+    return value;
+}
+
+static ALfloat alSourceFloat(ALuint alSource, ALenum parameter)
+{
+    ALfloat value = 0;
+    alGetSourcef(alSource, parameter, &value);
+    return value;
+}
+
+class tst_QAudioEngine : public QObject
+{
+    Q_OBJECT
+public slots:
+    void initTestCase();
+    void init();
+    void cleanup();
+
+private slots:
+    void batchedParameterUpdates();
+    void stateReporting();
+    void playToEnd();
+    void staleGenerationIgnored();
+    void pooledSourceReuse();
+
+private:
+    QAudioEnginePrivate *m_engine;
+};
+
+void tst_QAudioEngine::initTestCase()
+{
+    qRegisterMetaType<QSoundSource::State>();
+
+    // Mix without any audio hardware, in real time
+    qputenv("ALSOFT_DRIVERS", "null");
+    qputenv("QT_AUDIOENGINE_UPDATE_INTERVAL", "50");
+}
+
+void tst_QAudioEngine::init()
+{
+    m_engine = new QAudioEnginePrivate(0);
+    if (!alcGetCurrentContext()) {
+        delete m_engine;
+        m_engine = 0;
+        QSKIP("No OpenAL device available");
+    }
+    QCOMPARE(m_engine->updateInterval(), 50);
+}
+
+void tst_QAudioEngine::cleanup()
+{
+    delete m_engine;
+    m_engine = 0;
+}
+
+void tst_QAudioEngine::batchedParameterUpdates()
+{
+    SilentSoundBuffer buffer(200);
+    QSoundSource *source = m_engine->createSoundSource();
+    source->bindBuffer(&buffer);
+    const ALuint alSource = buffer.boundSource();
+    QVERIFY(alSource != 0);
+
+    // A playing source keeps the engine thread running once per block,
+    // parameter changes don't wake it up in between.
+    source->setLooping(true);
+    source->play();
+    QTRY_COMPARE(source->state(), QSoundSource::PlayingState);
+
+    const qint64 blocks = m_engine->updateStatistics().blocks;
+    for (int i = 1; i <= 100; ++i) {
+        source->setGain(i / qreal(200));
+        source->setPitch(1 + i / qreal(100));
+        source->setPosition(QVector3D(i, 0, 0));
+    }
+
+    QTRY_COMPARE(alSourceFloat(alSource, AL_GAIN), ALfloat(0.5));
+    QTRY_COMPARE(alSourceFloat(alSource, AL_PITCH), ALfloat(2));
+    ALfloat position[3] = { 0, 0, 0 };
+    alGetSourcefv(alSource, AL_POSITION, position);
+    QCOMPARE(position[0], ALfloat(100));
+
+    // All 300 changes were applied by a couple of blocks at most
+    QVERIFY2(m_engine->updateStatistics().blocks - blocks <= 3,
+             qPrintable(QString::number(m_engine->updateStatistics().blocks - blocks)));
+    QCOMPARE(source->position(), QVector3D(100, 0, 0));
+
+    source->stop();
+    QTRY_COMPARE(source->state(), QSoundSource::StoppedState);
+    m_engine->releaseSoundSource(source);
+}
+
+void tst_QAudioEngine::stateReporting()
+{
+    SilentSoundBuffer buffer(2000);
+    QSoundSource *source = m_engine->createSoundSource();
+    QSignalSpy stateSpy(source, SIGNAL(stateChanged(QSoundSource::State)));
+    source->bindBuffer(&buffer);
+    const ALuint alSource = buffer.boundSource();
+
+    // Binding a buffer alone does not start anything
+    QCOMPARE(source->state(), QSoundSource::StoppedState);
+
+    source->play();
+    QTRY_COMPARE(source->state(), QSoundSource::PlayingState);
+    QCOMPARE(alSourceInt(alSource, AL_SOURCE_STATE), ALint(AL_PLAYING));
+
+    source->pause();
+    QTRY_COMPARE(source->state(), QSoundSource::PausedState);
+    QCOMPARE(alSourceInt(alSource, AL_SOURCE_STATE), ALint(AL_PAUSED));
+
+    source->play();
+    QTRY_COMPARE(source->state(), QSoundSource::PlayingState);
+
+    source->stop();
+    QTRY_COMPARE(source->state(), QSoundSource::StoppedState);
+    QCOMPARE(alSourceInt(alSource, AL_SOURCE_STATE), ALint(AL_STOPPED));
+
+    // Each state is reported once
+    QCOMPARE(stateSpy.count(), 4);
+    QCOMPARE(stateSpy.at(0).at(0).value<QSoundSource::State>(), QSoundSource::PlayingState);
+    QCOMPARE(stateSpy.at(1).at(0).value<QSoundSource::State>(), QSoundSource::PausedState);
+    QCOMPARE(stateSpy.at(2).at(0).value<QSoundSource::State>(), QSoundSource::PlayingState);
+    QCOMPARE(stateSpy.at(3).at(0).value<QSoundSource::State>(), QSoundSource::StoppedState);
+
+    m_engine->releaseSoundSource(source);
+}
+
+void tst_QAudioEngine::playToEnd()
+{
+    SilentSoundBuffer buffer(100);
+    QSoundSource *source = m_engine->createSoundSource();
+    QSignalSpy stateSpy(source, SIGNAL(stateChanged(QSoundSource::State)));
+    source->bindBuffer(&buffer);
+
+    // The engine thread notices the end of the sound while polling
+    source->play();
+    QTRY_COMPARE(stateSpy.count(), 2);
+    QCOMPARE(stateSpy.at(0).at(0).value<QSoundSource::State>(), QSoundSource::PlayingState);
+    QCOMPARE(stateSpy.at(1).at(0).value<QSoundSource::State>(), QSoundSource::StoppedState);
+    QCOMPARE(source->state(), QSoundSource::StoppedState);
+
+    m_engine->releaseSoundSource(source);
+}
+
+void tst_QAudioEngine::staleGenerationIgnored()
+{
+    SilentSoundBuffer first(2000);
+    SilentSoundBuffer second(2000);
+    QSoundSource *source = m_engine->createSoundSource();
+    QSignalSpy stateSpy(source, SIGNAL(stateChanged(QSoundSource::State)));
+    source->bindBuffer(&first);
+    const ALuint alSource = first.boundSource();
+
+    // Let the engine thread start the sound without delivering its report
+    source->play();
+    for (int i = 0; i < 200 && alSourceInt(alSource, AL_SOURCE_STATE) != AL_PLAYING; ++i)
+        QTest::qSleep(10);
+    QCOMPARE(alSourceInt(alSource, AL_SOURCE_STATE), ALint(AL_PLAYING));
+    QCOMPARE(source->state(), QSoundSource::StoppedState);
+
+    // Rebinding makes the queued reports of the first buffer stale
+    source->unbindBuffer();
+    source->bindBuffer(&second);
+    QCOMPARE(second.boundSource(), alSource);
+
+    QTest::qWait(4 * m_engine->updateInterval());
+    QCOMPARE(stateSpy.count(), 0);
+    QCOMPARE(source->state(), QSoundSource::StoppedState);
+
+    // Reports for the new buffer still come through
+    source->play();
+    QTRY_COMPARE(source->state(), QSoundSource::PlayingState);
+    QCOMPARE(stateSpy.count(), 1);
+
+    m_engine->releaseSoundSource(source);
+}
+
+void tst_QAudioEngine::pooledSourceReuse()
+{
+    SilentSoundBuffer buffer(2000);
+    QSoundSource *source = m_engine->createSoundSource();
+    source->bindBuffer(&buffer);
+    const ALuint alSource = buffer.boundSource();
+
+    source->setGain(0.25);
+    source->setPosition(QVector3D(1, 2, 3));
+    source->setLooping(true);
+    source->play();
+    QTRY_COMPARE(source->state(), QSoundSource::PlayingState);
+    QTRY_COMPARE(alSourceFloat(alSource, AL_GAIN), ALfloat(0.25));
+
+    QSignalSpy stateSpy(source, SIGNAL(stateChanged(QSoundSource::State)));
+    m_engine->releaseSoundSource(source);
+
+    // Releasing stops the sound at once and restores the defaults
+    QCOMPARE(stateSpy.count(), 1);
+    QCOMPARE(source->state(), QSoundSource::StoppedState);
+    QCOMPARE(alSourceInt(alSource, AL_SOURCE_STATE), ALint(AL_STOPPED));
+    QCOMPARE(source->position(), QVector3D(0, 0, 0));
+    QTRY_COMPARE(alSourceFloat(alSource, AL_GAIN), ALfloat(1));
+    QCOMPARE(alSourceInt(alSource, AL_LOOPING), ALint(AL_FALSE));
+
+    // The most recently released source is handed out again
+    QSoundSource *other = m_engine->createSoundSource();
+    QCOMPARE(other, source);
+
+    // A new one takes another OpenAL source from the pool
+    QSoundSource *third = m_engine->createSoundSource();
+    QVERIFY(third != source);
+    SilentSoundBuffer thirdBuffer(100);
+    third->bindBuffer(&thirdBuffer);
+    QVERIFY(thirdBuffer.boundSource() != 0);
+    QVERIFY(thirdBuffer.boundSource() != alSource);
+
+    // Late reports for the released sound don't reach the reused source
+    stateSpy.clear();
+    QTest::qWait(4 * m_engine->updateInterval());
+    QCOMPARE(stateSpy.count(), 0);
+
+    m_engine->releaseSoundSource(other);
+    m_engine->releaseSoundSource(third);
+}
+
+QTEST_MAIN(tst_QAudioEngine)
+
+#include "tst_qaudioengine.moc"
@@ -36,6 +36,7 @@
 
 #include <qaudioprobe.h>
 #include <qaudiorecorder.h>
+#include <private/qaudioproberingbuffer_p.h>
 
 //TESTED_COMPONENT=src/multimedia
 
@@ -60,6 +61,9 @@ private slots:
     void testRecorderDeleteRecorder();
     void testRecorderDeleteProbe();
     void testMediaObject();
+    void testRingBufferRecorder();
+    void testRingBufferOverflow();
+    void testRingBufferSummaries();
 
 private:
     QAudioRecorder *recorder;
@@ -183,6 +187,111 @@ void tst_QAudioProbe::testMediaObject()
     delete object;
 }
 
+static QAudioFormat stereoFormat()
+{
+    QAudioFormat format;
+    format.setSampleRate(8000);
+    format.setChannelCount(2);
+    format.setSampleSize(16);
+    format.setSampleType(QAudioFormat::SignedInt);
+    format.setByteOrder(QAudioFormat::Endian(QSysInfo::ByteOrder));
+    format.setCodec(QLatin1String("audio/pcm"));
+    return format;
+}
+
+void tst_QAudioProbe::testRingBufferRecorder()
+{
+    recorder = new QAudioRecorder;
+    QVERIFY(recorder->isAvailable());
+
+    QAudioProbeRingBuffer ringBuffer(1024);
+    QVERIFY(!ringBuffer.isActive());
+    QVERIFY(ringBuffer.setSource(recorder));
+    QVERIFY(ringBuffer.isActive());
+
+    // The mock control only emits audioBufferProbed(), which is written
+    // to the ring buffer as it is emitted.
+    QAudioBuffer buffer(64, stereoFormat());
+    emit mockMediaRecorderService->mockAudioProbeControl->audioBufferProbed(buffer);
+    QCOMPARE(ringBuffer.bytesAvailable(), buffer.byteCount());
+    QCOMPARE(ringBuffer.format(), stereoFormat());
+
+    ringBuffer.setSource((QMediaRecorder*)0);
+    QVERIFY(!ringBuffer.isActive());
+
+    emit mockMediaRecorderService->mockAudioProbeControl->audioBufferProbed(buffer);
+    QCOMPARE(ringBuffer.bytesAvailable(), buffer.byteCount());
+}
+
+void tst_QAudioProbe::testRingBufferOverflow()
+{
+    const QAudioFormat format = stereoFormat();
+
+    // Not a multiple of the frame size, only whole frames are written
+    QAudioProbeRingBuffer ringBuffer(1026);
+    QVector<qint16> samples(2 * 200);
+    for (int i = 0; i < samples.size(); ++i)
+        samples[i] = i;
+
+    ringBuffer.write(format, reinterpret_cast<const char *>(samples.constData()), 800, -1);
+    QCOMPARE(ringBuffer.bytesAvailable(), 800);
+    QCOMPARE(ringBuffer.overflowCount(), 0);
+
+    ringBuffer.write(format, reinterpret_cast<const char *>(samples.constData()), 800, -1);
+    QCOMPARE(ringBuffer.bytesAvailable(), 1024);
+    QCOMPARE(ringBuffer.overflowCount(), 1);
+
+    QVector<qint16> read(2 * 256);
+    QCOMPARE(ringBuffer.read(reinterpret_cast<char *>(read.data()), 1024), 1024);
+    QCOMPARE(read.at(0), qint16(0));
+    QCOMPARE(read.at(399), qint16(399));
+    QCOMPARE(read.at(400), qint16(0));
+    QCOMPARE(read.at(511), qint16(111));
+    QCOMPARE(ringBuffer.bytesAvailable(), 0);
+}
+
+void tst_QAudioProbe::testRingBufferSummaries()
+{
+    const QAudioFormat format = stereoFormat();
+
+    QAudioProbeRingBuffer ringBuffer(4096);
+    ringBuffer.setSummaryInterval(100, 2);
+    QCOMPARE(ringBuffer.summaryInterval(), 100);
+
+    // Left channel at full scale, right channel a square wave of half scale
+    QVector<qint16> samples(2 * 250);
+    for (int i = 0; i < 250; ++i) {
+        samples[2 * i] = -32768;
+        samples[2 * i + 1] = i % 2 ? 16384 : -16384;
+    }
+
+    ringBuffer.write(format, reinterpret_cast<const char *>(samples.constData()), 250 * 4, 1000);
+    QCOMPARE(ringBuffer.summariesAvailable(), 2);
+
+    QAudioProbeRingBuffer::LevelSummary summary;
+    QVERIFY(ringBuffer.readSummary(&summary));
+    QCOMPARE(summary.startTime, qint64(1000));
+    QCOMPARE(summary.frameCount, 100);
+    QCOMPARE(summary.channelCount, 2);
+    QCOMPARE(summary.peak[0], 1.0f);
+    QCOMPARE(summary.rms[0], 1.0f);
+    QCOMPARE(summary.peak[1], 0.5f);
+    QCOMPARE(summary.rms[1], 0.5f);
+
+    QVERIFY(ringBuffer.readSummary(&summary));
+    QCOMPARE(summary.startTime, qint64(1000 + 12500));
+
+    // The remaining 50 frames complete a summary with the next write, the
+    // one after it doesn't fit in the queue any more.
+    ringBuffer.write(format, reinterpret_cast<const char *>(samples.constData()), 250 * 4, -1);
+    QCOMPARE(ringBuffer.summariesAvailable(), 2);
+    QCOMPARE(ringBuffer.droppedSummaryCount(), 1);
+    QVERIFY(ringBuffer.readSummary(&summary));
+    QCOMPARE(summary.startTime, qint64(1000 + 25000));
+    QVERIFY(ringBuffer.readSummary(&summary));
+    QVERIFY(!ringBuffer.readSummary(&summary));
+}
+
 QTEST_GUILESS_MAIN(tst_QAudioProbe)
 
 #include "tst_qaudioprobe.moc"
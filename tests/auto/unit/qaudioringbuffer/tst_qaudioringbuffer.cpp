@@ -0,0 +1,381 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the test suite of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+//TESTED_COMPONENT=src/multimedia
+
+#include <QtTest/QtTest>
+
+#include <private/qaudioringbuffer_p.h>
+
+QT_USE_NAMESPACE
+
+class tst_QAudioRingBuffer : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void emptyAndFull_data();
+    void emptyAndFull();
+    void zeroCapacity();
+    void regionWraparound();
+    void partialRelease();
+    void readWriteWraparound_data();
+    void readWriteWraparound();
+    void clearFromConsumer();
+    void reset();
+    void threadedStress_data();
+    void threadedStress();
+};
+
+static QByteArray pattern(int length, int start = 0)
+{
+    QByteArray data(length, Qt::Uninitialized);
+    for (int i = 0; i < length; ++i)
+        data[i] = char((start + i) * 7 + 1);
+    return data;
+}
+
+void tst_QAudioRingBuffer::emptyAndFull_data()
+{
+    QTest::addColumn<int>("capacity");
+
+    QTest::newRow("1") << 1;
+    QTest::newRow("3") << 3;
+    QTest::newRow("10") << 10;
+    QTest::newRow("1023") << 1023;
+    QTest::newRow("1024") << 1024;
+    QTest::newRow("4410") << 4410;
+}
+
+void tst_QAudioRingBuffer::emptyAndFull()
+{
+    QFETCH(int, capacity);
+
+    QAudioRingBuffer buffer(capacity);
+    QCOMPARE(buffer.capacity(), capacity);
+
+    // Several laps, so that the positions run through both halves of
+    // [0, 2 * capacity) where full and empty are told apart.
+    for (int lap = 0; lap < 5; ++lap) {
+        QCOMPARE(buffer.bytesAvailable(), 0);
+        QCOMPARE(buffer.bytesFree(), capacity);
+
+        int length = -1;
+        buffer.readRegion(&length);
+        QCOMPARE(length, 0);
+
+        const QByteArray data = pattern(capacity + 1, lap);
+        QCOMPARE(buffer.write(data.constData(), data.size()), capacity);
+        QCOMPARE(buffer.bytesAvailable(), capacity);
+        QCOMPARE(buffer.bytesFree(), 0);
+
+        buffer.writeRegion(&length);
+        QCOMPARE(length, 0);
+        QCOMPARE(buffer.write(data.constData(), 1), 0);
+
+        QByteArray out(capacity + 1, 0);
+        QCOMPARE(buffer.read(out.data(), out.size()), capacity);
+        QCOMPARE(out.left(capacity), data.left(capacity));
+    }
+
+    // Leave the buffer off the start before filling it again
+    const QByteArray data = pattern(capacity);
+    QCOMPARE(buffer.write(data.constData(), (capacity + 1) / 2), (capacity + 1) / 2);
+    QByteArray out(capacity, 0);
+    QCOMPARE(buffer.read(out.data(), capacity), (capacity + 1) / 2);
+    QCOMPARE(buffer.write(data.constData(), capacity), capacity);
+    QCOMPARE(buffer.bytesFree(), 0);
+    QCOMPARE(buffer.read(out.data(), capacity), capacity);
+    QCOMPARE(out, data);
+    QCOMPARE(buffer.bytesAvailable(), 0);
+}
+
+void tst_QAudioRingBuffer::zeroCapacity()
+{
+    QAudioRingBuffer buffer;
+    QCOMPARE(buffer.capacity(), 0);
+    QCOMPARE(buffer.bytesAvailable(), 0);
+    QCOMPARE(buffer.bytesFree(), 0);
+
+    char data[4] = { 1, 2, 3, 4 };
+    QCOMPARE(buffer.write(data, 4), 0);
+    QCOMPARE(buffer.read(data, 4), 0);
+
+    int length = -1;
+    buffer.writeRegion(&length);
+    QCOMPARE(length, 0);
+    buffer.readRegion(&length);
+    QCOMPARE(length, 0);
+}
+
+void tst_QAudioRingBuffer::regionWraparound()
+{
+    QAudioRingBuffer buffer(10);
+    const QByteArray data = pattern(13);
+
+    QCOMPARE(buffer.write(data.constData(), 7), 7);
+    QByteArray out(7, 0);
+    QCOMPARE(buffer.read(out.data(), 7), 7);
+
+    // The write region stops at the end of the storage
+    int length = 0;
+    char *region = buffer.writeRegion(&length);
+    QCOMPARE(length, 3);
+    memcpy(region, data.constData() + 7, 3);
+    buffer.commitWrite(3);
+
+    char *start = buffer.writeRegion(&length);
+    QCOMPARE(length, 7);
+    QCOMPARE(start, region - 7);
+    memcpy(start, data.constData() + 10, 3);
+    buffer.commitWrite(3);
+    QCOMPARE(buffer.bytesAvailable(), 6);
+    QCOMPARE(buffer.bytesFree(), 4);
+
+    // So does the read region, the rest follows from the start
+    const char *tail = buffer.readRegion(&length);
+    QCOMPARE(length, 3);
+    QCOMPARE(tail, static_cast<const char *>(region));
+    QCOMPARE(QByteArray(tail, length), data.mid(7, 3));
+    buffer.releaseRead(3);
+
+    const char *head = buffer.readRegion(&length);
+    QCOMPARE(length, 3);
+    QCOMPARE(head, static_cast<const char *>(start));
+    QCOMPARE(QByteArray(head, length), data.mid(10, 3));
+    buffer.releaseRead(3);
+
+    QCOMPARE(buffer.bytesAvailable(), 0);
+    buffer.readRegion(&length);
+    QCOMPARE(length, 0);
+
+    // The write region is only limited by the end of the storage now
+    buffer.writeRegion(&length);
+    QCOMPARE(length, 7);
+}
+
+void tst_QAudioRingBuffer::partialRelease()
+{
+    QAudioRingBuffer buffer(8);
+    const QByteArray data = pattern(8);
+    QCOMPARE(buffer.write(data.constData(), 8), 8);
+
+    int length = 0;
+    const char *region = buffer.readRegion(&length);
+    QCOMPARE(length, 8);
+
+    // Releasing part of a region leaves the rest to the next one
+    buffer.releaseRead(3);
+    QCOMPARE(buffer.bytesAvailable(), 5);
+    QCOMPARE(buffer.bytesFree(), 3);
+
+    const char *rest = buffer.readRegion(&length);
+    QCOMPARE(length, 5);
+    QCOMPARE(rest, region + 3);
+    QCOMPARE(QByteArray(rest, length), data.mid(3));
+
+    // The freed space is at the start of the storage
+    char *free = buffer.writeRegion(&length);
+    QCOMPARE(length, 3);
+    QCOMPARE(static_cast<const char *>(free), region);
+}
+
+void tst_QAudioRingBuffer::readWriteWraparound_data()
+{
+    QTest::addColumn<int>("capacity");
+    QTest::addColumn<int>("chunk");
+
+    QTest::newRow("10 by 3") << 10 << 3;
+    QTest::newRow("10 by 7") << 10 << 7;
+    QTest::newRow("1023 by 100") << 1023 << 100;
+    QTest::newRow("4410 by 4409") << 4410 << 4409;
+}
+
+void tst_QAudioRingBuffer::readWriteWraparound()
+{
+    QFETCH(int, capacity);
+    QFETCH(int, chunk);
+
+    QAudioRingBuffer buffer(capacity);
+    const QByteArray data = pattern(chunk * 50);
+    QByteArray out(data.size(), 0);
+
+    // Chunks that don't divide the capacity end up straddling its end
+    int written = 0;
+    int read = 0;
+    while (read < data.size()) {
+        written += buffer.write(data.constData() + written, qMin(chunk, data.size() - written));
+        QCOMPARE(buffer.bytesAvailable() + buffer.bytesFree(), capacity);
+        read += buffer.read(out.data() + read, chunk / 2 + 1);
+        QCOMPARE(buffer.bytesAvailable(), written - read);
+    }
+    QCOMPARE(out, data);
+}
+
+void tst_QAudioRingBuffer::clearFromConsumer()
+{
+    QAudioRingBuffer buffer(10);
+    const QByteArray data = pattern(10);
+
+    QCOMPARE(buffer.write(data.constData(), 6), 6);
+    buffer.clear();
+    QCOMPARE(buffer.bytesAvailable(), 0);
+    QCOMPARE(buffer.bytesFree(), 10);
+
+    // Writing continues where it left off
+    int length = 0;
+    buffer.writeRegion(&length);
+    QCOMPARE(length, 4);
+    QCOMPARE(buffer.write(data.constData(), 10), 10);
+
+    // Clearing a full buffer
+    QCOMPARE(buffer.bytesFree(), 0);
+    buffer.clear();
+    QCOMPARE(buffer.bytesAvailable(), 0);
+    QCOMPARE(buffer.bytesFree(), 10);
+
+    QCOMPARE(buffer.write(data.constData(), 4), 4);
+    QByteArray out(4, 0);
+    QCOMPARE(buffer.read(out.data(), 10), 4);
+    QCOMPARE(out, data.left(4));
+}
+
+void tst_QAudioRingBuffer::reset()
+{
+    QAudioRingBuffer buffer(10);
+    const QByteArray data = pattern(10);
+    QCOMPARE(buffer.write(data.constData(), 8), 8);
+
+    buffer.reset(6);
+    QCOMPARE(buffer.capacity(), 6);
+    QCOMPARE(buffer.bytesAvailable(), 0);
+    QCOMPARE(buffer.bytesFree(), 6);
+
+    int length = 0;
+    buffer.writeRegion(&length);
+    QCOMPARE(length, 6);
+
+    buffer.reset(-1);
+    QCOMPARE(buffer.capacity(), 0);
+}
+
+class RingBufferProducer : public QThread
+{
+public:
+    RingBufferProducer(QAudioRingBuffer *buffer, int total)
+        : buffer(buffer), total(total) {}
+
+    void run()
+    {
+        int written = 0;
+        int step = 0;
+        while (written < total) {
+            const int chunk = qMin(1 + (step++ * 37) % 509, total - written);
+            int copied = 0;
+            if (step % 2) {
+                const QByteArray data = pattern(chunk, written);
+                copied = buffer->write(data.constData(), chunk);
+            } else {
+                int length = 0;
+                char *region = buffer->writeRegion(&length);
+                copied = qMin(length, chunk);
+                const QByteArray data = pattern(copied, written);
+                memcpy(region, data.constData(), copied);
+                buffer->commitWrite(copied);
+            }
+            written += copied;
+            if (copied == 0)
+                yieldCurrentThread();
+        }
+    }
+
+    QAudioRingBuffer * const buffer;
+    const int total;
+};
+
+void tst_QAudioRingBuffer::threadedStress_data()
+{
+    QTest::addColumn<int>("capacity");
+
+    QTest::newRow("1023") << 1023;
+    QTest::newRow("4096") << 4096;
+    QTest::newRow("4410") << 4410;
+}
+
+/*
+    A producer thread writes a known byte sequence in chunks of varying
+    size while this thread consumes it through regions, partly released.
+*/
+void tst_QAudioRingBuffer::threadedStress()
+{
+    QFETCH(int, capacity);
+
+    const int total = 8 * 1024 * 1024;
+    QAudioRingBuffer buffer(capacity);
+    RingBufferProducer producer(&buffer, total);
+    producer.start();
+
+    int read = 0;
+    int step = 0;
+    int mismatch = -1;
+    while (read < total) {
+        const int available = buffer.bytesAvailable();
+        QVERIFY(available >= 0 && available <= capacity);
+
+        int length = 0;
+        const char *region = buffer.readRegion(&length);
+        if (length == 0) {
+            QThread::yieldCurrentThread();
+            continue;
+        }
+
+        const int consumed = qMin(length, 1 + (step++ * 53) % 701);
+        for (int i = 0; i < consumed && mismatch < 0; ++i) {
+            if (region[i] != char((read + i) * 7 + 1))
+                mismatch = read + i;
+        }
+        if (mismatch >= 0)
+            break;
+        buffer.releaseRead(consumed);
+        read += consumed;
+    }
+
+    QVERIFY(producer.wait(10000));
+    QCOMPARE(mismatch, -1);
+    QCOMPARE(read, total);
+    QCOMPARE(buffer.bytesAvailable(), 0);
+}
+
+QTEST_MAIN(tst_QAudioRingBuffer)
+
+#include "tst_qaudioringbuffer.moc"
@@ -0,0 +1,13 @@
+CONFIG += testcase
+TARGET = tst_qdeclarativecamerapreviewprovider
+
+QT += quick testlib
+
+HEADERS += \
+        ../../../../src/imports/multimedia/qdeclarativecamerapreviewprovider_p.h
+
+SOURCES += \
+        tst_qdeclarativecamerapreviewprovider.cpp \
+        ../../../../src/imports/multimedia/qdeclarativecamerapreviewprovider.cpp
+
+INCLUDEPATH += ../../../../src/imports/multimedia
@@ -0,0 +1,274 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the test suite of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+//TESTED_COMPONENT=plugins/declarative/multimedia
+
+#include <QtTest/QtTest>
+
+#include "qdeclarativecamerapreviewprovider_p.h"
+
+#include <QtGui/qimage.h>
+
+typedef QDeclarativeCameraPreviewProvider::Statistics PreviewStatistics;
+
+class tst_QDeclarativeCameraPreviewProvider : public QObject
+{
+    Q_OBJECT
+public slots:
+    void initTestCase();
+    void init();
+
+private slots:
+    void boxFilter();
+    void boxFilterTranslucent();
+    void levelSelection_data();
+    void levelSelection();
+    void fullSize();
+    void eviction();
+    void replacePreview();
+    void statistics();
+
+private:
+    static QImage checkerboard(const QSize &size, QRgb a, QRgb b, QImage::Format format);
+};
+
+enum { CacheSize = 4 };
+
+QImage tst_QDeclarativeCameraPreviewProvider::checkerboard(const QSize &size, QRgb a, QRgb b,
+                                                           QImage::Format format)
+{
+    QImage image(size, format);
+    for (int y = 0; y < size.height(); ++y) {
+        for (int x = 0; x < size.width(); ++x)
+            image.setPixel(x, y, (x + y) % 2 ? b : a);
+    }
+    return image;
+}
+
+void tst_QDeclarativeCameraPreviewProvider::initTestCase()
+{
+    // Read once, when the cache is first used
+    qputenv("QT_CAMERA_PREVIEW_CACHE_SIZE", QByteArray::number(int(CacheSize)));
+}
+
+void tst_QDeclarativeCameraPreviewProvider::init()
+{
+    // Flush the previews left over by the previous test
+    for (int i = 0; i < CacheSize; ++i)
+        QDeclarativeCameraPreviewProvider::registerPreview(QString::fromLatin1("flush%1").arg(i), QImage());
+    QDeclarativeCameraPreviewProvider::resetStatistics();
+}
+
+void tst_QDeclarativeCameraPreviewProvider::boxFilter()
+{
+    QDeclarativeCameraPreviewProvider provider;
+    QDeclarativeCameraPreviewProvider::registerPreview(QLatin1String("checker"),
+            checkerboard(QSize(256, 128), qRgb(0, 0, 0), qRgb(255, 101, 3), QImage::Format_RGB32));
+
+    // Each level averages two pixels of each color, rounding to nearest
+    const QRgb average = qRgb(128, 51, 2);
+
+    QSize size;
+    QImage level = provider.requestImage(QLatin1String("checker"), &size, QSize(128, 64));
+    QCOMPARE(size, QSize(128, 64));
+    QCOMPARE(level.size(), QSize(128, 64));
+    for (int y = 0; y < level.height(); ++y) {
+        for (int x = 0; x < level.width(); ++x)
+            QCOMPARE(level.pixel(x, y), average);
+    }
+
+    level = provider.requestImage(QLatin1String("checker"), &size, QSize(64, 32));
+    QCOMPARE(size, QSize(64, 32));
+    QCOMPARE(level.pixel(0, 0), average);
+    QCOMPARE(level.pixel(63, 31), average);
+
+    QCOMPARE(QDeclarativeCameraPreviewProvider::statistics().exactHits, 2);
+}
+
+void tst_QDeclarativeCameraPreviewProvider::boxFilterTranslucent()
+{
+    QDeclarativeCameraPreviewProvider provider;
+    QDeclarativeCameraPreviewProvider::registerPreview(QLatin1String("translucent"),
+            checkerboard(QSize(128, 128), qRgba(0, 0, 0, 0), qRgba(255, 0, 0, 255), QImage::Format_ARGB32));
+
+    const QImage level = provider.requestImage(QLatin1String("translucent"), 0, QSize(64, 64))
+            .convertToFormat(QImage::Format_ARGB32);
+    QCOMPARE(level.size(), QSize(64, 64));
+
+    // Transparent pixels must not darken the opaque ones they are averaged with
+    const QRgb pixel = level.pixel(10, 10);
+    QCOMPARE(qAlpha(pixel), 128);
+    QVERIFY(qRed(pixel) >= 254);
+    QCOMPARE(qGreen(pixel), 0);
+    QCOMPARE(qBlue(pixel), 0);
+}
+
+void tst_QDeclarativeCameraPreviewProvider::levelSelection_data()
+{
+    QTest::addColumn<QSize>("previewSize");
+    QTest::addColumn<QSize>("requestedSize");
+    QTest::addColumn<QSize>("expectedSize");
+    QTest::addColumn<bool>("exact");
+
+    // A 512x512 preview is stored at 512, 256, 128, 64 and 32
+    QTest::newRow("level 1") << QSize(512, 512) << QSize(256, 256) << QSize(256, 256) << true;
+    QTest::newRow("level 3") << QSize(512, 512) << QSize(64, 64) << QSize(64, 64) << true;
+    QTest::newRow("smallest level") << QSize(512, 512) << QSize(32, 32) << QSize(32, 32) << true;
+    QTest::newRow("between levels") << QSize(512, 512) << QSize(100, 100) << QSize(100, 100) << false;
+    QTest::newRow("below smallest level") << QSize(512, 512) << QSize(20, 20) << QSize(20, 20) << false;
+    QTest::newRow("above full size") << QSize(512, 512) << QSize(600, 600) << QSize(600, 600) << false;
+    QTest::newRow("keeps aspect ratio") << QSize(512, 256) << QSize(64, 100) << QSize(64, 32) << true;
+    // Levels stop before either side drops below 32
+    QTest::newRow("narrow preview") << QSize(512, 64) << QSize(128, 16) << QSize(128, 16) << false;
+}
+
+void tst_QDeclarativeCameraPreviewProvider::levelSelection()
+{
+    QFETCH(QSize, previewSize);
+    QFETCH(QSize, requestedSize);
+    QFETCH(QSize, expectedSize);
+    QFETCH(bool, exact);
+
+    QImage image(previewSize, QImage::Format_RGB32);
+    image.fill(Qt::darkCyan);
+
+    QDeclarativeCameraPreviewProvider provider;
+    QDeclarativeCameraPreviewProvider::registerPreview(QLatin1String("preview"), image);
+
+    QSize size;
+    const QImage result = provider.requestImage(QLatin1String("preview"), &size, requestedSize);
+    QCOMPARE(size, expectedSize);
+    QCOMPARE(result.size(), expectedSize);
+
+    const PreviewStatistics stats = QDeclarativeCameraPreviewProvider::statistics();
+    QCOMPARE(stats.requests, 1);
+    QCOMPARE(stats.hits, 1);
+    QCOMPARE(stats.exactHits, exact ? 1 : 0);
+}
+
+void tst_QDeclarativeCameraPreviewProvider::fullSize()
+{
+    QImage image(300, 200, QImage::Format_ARGB32);
+    image.fill(qRgba(10, 20, 30, 40));
+
+    QDeclarativeCameraPreviewProvider provider;
+    QDeclarativeCameraPreviewProvider::registerPreview(QLatin1String("full"), image);
+
+    // Without a requested size the registered image is returned untouched
+    QSize size;
+    const QImage result = provider.requestImage(QLatin1String("full"), &size, QSize());
+    QCOMPARE(size, image.size());
+    QCOMPARE(result, image);
+    QCOMPARE(result.format(), QImage::Format_ARGB32);
+    QCOMPARE(QDeclarativeCameraPreviewProvider::statistics().exactHits, 1);
+}
+
+void tst_QDeclarativeCameraPreviewProvider::eviction()
+{
+    QImage image(64, 64, QImage::Format_RGB32);
+    image.fill(Qt::red);
+
+    QDeclarativeCameraPreviewProvider provider;
+    for (int i = 0; i <= CacheSize; ++i)
+        QDeclarativeCameraPreviewProvider::registerPreview(QString::number(i), image);
+
+    // The oldest preview is dropped once the cache is full
+    QVERIFY(provider.requestImage(QLatin1String("0"), 0, QSize()).isNull());
+    for (int i = 1; i <= CacheSize; ++i)
+        QVERIFY(!provider.requestImage(QString::number(i), 0, QSize()).isNull());
+
+    // Registering an id again makes it the most recent one
+    QDeclarativeCameraPreviewProvider::registerPreview(QLatin1String("1"), image);
+    QDeclarativeCameraPreviewProvider::registerPreview(QLatin1String("new"), image);
+    QVERIFY(!provider.requestImage(QLatin1String("1"), 0, QSize()).isNull());
+    QVERIFY(provider.requestImage(QLatin1String("2"), 0, QSize()).isNull());
+    QVERIFY(!provider.requestImage(QLatin1String("new"), 0, QSize()).isNull());
+}
+
+void tst_QDeclarativeCameraPreviewProvider::replacePreview()
+{
+    QImage first(64, 64, QImage::Format_RGB32);
+    first.fill(Qt::red);
+    QImage second(128, 64, QImage::Format_RGB32);
+    second.fill(Qt::blue);
+
+    QDeclarativeCameraPreviewProvider provider;
+    QDeclarativeCameraPreviewProvider::registerPreview(QLatin1String("capture"), first);
+    QDeclarativeCameraPreviewProvider::registerPreview(QLatin1String("capture"), second);
+
+    QSize size;
+    const QImage result = provider.requestImage(QLatin1String("capture"), &size, QSize());
+    QCOMPARE(size, second.size());
+    QCOMPARE(result.pixel(0, 0), qRgb(0, 0, 255));
+
+    // The replaced preview does not take a second slot
+    for (int i = 0; i < CacheSize - 1; ++i)
+        QDeclarativeCameraPreviewProvider::registerPreview(QString::number(i), first);
+    QVERIFY(!provider.requestImage(QLatin1String("capture"), 0, QSize()).isNull());
+}
+
+void tst_QDeclarativeCameraPreviewProvider::statistics()
+{
+    QImage image(256, 256, QImage::Format_RGB32);
+    image.fill(Qt::green);
+
+    QDeclarativeCameraPreviewProvider provider;
+    QDeclarativeCameraPreviewProvider::registerPreview(QLatin1String("stats"), image);
+
+    PreviewStatistics stats = QDeclarativeCameraPreviewProvider::statistics();
+    QCOMPARE(stats.requests, 0);
+    QCOMPARE(stats.hitRate(), qreal(0));
+
+    QSize size(1, 1);
+    QVERIFY(provider.requestImage(QLatin1String("missing"), &size, QSize(64, 64)).isNull());
+    QCOMPARE(size, QSize(1, 1));
+    provider.requestImage(QLatin1String("stats"), 0, QSize(128, 128));
+    provider.requestImage(QLatin1String("stats"), 0, QSize(100, 100));
+    provider.requestImage(QLatin1String("stats"), 0, QSize());
+
+    stats = QDeclarativeCameraPreviewProvider::statistics();
+    QCOMPARE(stats.requests, 4);
+    QCOMPARE(stats.hits, 3);
+    QCOMPARE(stats.exactHits, 2);
+    QCOMPARE(stats.hitRate(), qreal(0.75));
+
+    QDeclarativeCameraPreviewProvider::resetStatistics();
+    stats = QDeclarativeCameraPreviewProvider::statistics();
+    QCOMPARE(stats.requests, 0);
+    QCOMPARE(stats.hits, 0);
+    QCOMPARE(stats.exactHits, 0);
+}
+
+QTEST_MAIN(tst_QDeclarativeCameraPreviewProvider)
+
+#include "tst_qdeclarativecamerapreviewprovider.moc"
@@ -99,6 +99,15 @@ private slots:
     void mediaPlayListControl();
     void mediaPlayListSourceControl();
 
+    void compactStorage();
+    void loadInBatches();
+    void loadLargePlaylist_data();
+    void loadLargePlaylist();
+    void loadLargePlaylistMemory_data();
+    void loadLargePlaylistMemory();
+    void loadLongLine_data();
+    void loadLongLine();
+
 
 private:
     QMediaContent content1;
@@ -1242,6 +1251,217 @@ void tst_QMediaPlaylist::mediaPlayListProvider()
     MockReadOnlyPlaylistProvider provider(&parent);
 }
 
+// Entries are stored as encoded URLs, anything a URL can't describe is kept
+// as it is. Removing most entries compacts the storage.
+void tst_QMediaPlaylist::compactStorage()
+{
+    QMediaPlaylist playlist;
+
+    QNetworkRequest request(QUrl(QLatin1String("http://test.host/request")));
+    request.setRawHeader("User-Agent", "test");
+    const QMediaContent requestContent(request);
+
+    QList<QMediaContent> items;
+    for (int i = 0; i < 5000; ++i) {
+        if (i % 1000 == 0)
+            items.append(requestContent);
+        else
+            items.append(QMediaContent(QUrl(QString::fromLatin1("http://test.host/%1 item.mp3").arg(i))));
+    }
+    QVERIFY(playlist.addMedia(items));
+    QCOMPARE(playlist.mediaCount(), 5000);
+    QCOMPARE(playlist.media(1), items.at(1));
+    QCOMPARE(playlist.media(1000), requestContent);
+
+    QVERIFY(playlist.removeMedia(0, 3989));
+    QCOMPARE(playlist.mediaCount(), 1010);
+    for (int i = 0; i < playlist.mediaCount(); ++i)
+        QCOMPARE(playlist.media(i), items.at(3990 + i));
+    QCOMPARE(playlist.media(10), requestContent);
+
+    QVERIFY(playlist.insertMedia(1, QMediaContent(QUrl(QLatin1String("file:///inserted")))));
+    QCOMPARE(playlist.media(0), items.at(3990));
+    QCOMPARE(playlist.media(1), QMediaContent(QUrl(QLatin1String("file:///inserted"))));
+    QCOMPARE(playlist.media(2), items.at(3991));
+    QCOMPARE(playlist.media(playlist.mediaCount()), QMediaContent());
+}
+
+static QString writeM3u(const QString &dir, int count)
+{
+    QFile file(dir + QString::fromLatin1("/large_%1.m3u").arg(count));
+    if (!file.open(QIODevice::WriteOnly))
+        return QString();
+
+    QByteArray data("#EXTM3U\n");
+    for (int i = 0; i < count; ++i) {
+        data += "#EXTINF:" + QByteArray::number(i % 600) + ",Artist - Title " + QByteArray::number(i) + '\n';
+        if (i % 2)
+            data += "http://test.host/music/" + QByteArray::number(i) + ".mp3\n";
+        else
+            data += "music/album " + QByteArray::number(i / 10) + '/' + QByteArray::number(i) + ".ogg\n";
+    }
+    file.write(data);
+    return file.fileName();
+}
+
+void tst_QMediaPlaylist::loadInBatches()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString fileName = writeM3u(dir.path(), 10000);
+    QVERIFY(!fileName.isEmpty());
+
+    QMediaPlaylist playlist;
+    QSignalSpy loadSpy(&playlist, SIGNAL(loaded()));
+    QSignalSpy insertedSpy(&playlist, SIGNAL(mediaInserted(int,int)));
+
+    playlist.load(QUrl::fromLocalFile(fileName));
+    QTRY_VERIFY(!loadSpy.isEmpty());
+    QCOMPARE(playlist.error(), QMediaPlaylist::NoError);
+    QCOMPARE(playlist.mediaCount(), 10000);
+
+    // Entries arrive a batch at a time, in order
+    QVERIFY(insertedSpy.count() < 100);
+    int next = 0;
+    for (int i = 0; i < insertedSpy.count(); ++i) {
+        QCOMPARE(insertedSpy.at(i).at(0).toInt(), next);
+        next = insertedSpy.at(i).at(1).toInt() + 1;
+    }
+    QCOMPARE(next, 10000);
+
+    QCOMPARE(playlist.media(1).canonicalUrl(), QUrl(QLatin1String("http://test.host/music/1.mp3")));
+    QCOMPARE(playlist.media(9998).canonicalUrl(),
+             QUrl::fromLocalFile(dir.path() + QLatin1String("/music/album 999/9998.ogg")));
+
+    // Restarting a load drops whatever the previous one still had queued
+    playlist.clear();
+    playlist.load(QUrl::fromLocalFile(fileName));
+    loadSpy.clear();
+    playlist.load(QUrl::fromLocalFile(fileName));
+    QTRY_VERIFY(!loadSpy.isEmpty());
+    QCOMPARE(playlist.mediaCount(), 10000);
+}
+
+#ifdef Q_OS_LINUX
+static qint64 residentMemory()
+{
+    QFile statm(QLatin1String("/proc/self/statm"));
+    if (!statm.open(QIODevice::ReadOnly))
+        return 0;
+    const QList<QByteArray> fields = statm.readAll().split(' ');
+    return fields.size() > 1 ? fields.at(1).toLongLong() * 4096 : 0;
+}
+#endif
+
+void tst_QMediaPlaylist::loadLargePlaylist_data()
+{
+    QTest::addColumn<int>("count");
+
+    QTest::newRow("20000") << 20000;
+    QTest::newRow("200000") << 200000;
+}
+
+// Time to load an M3U file
+void tst_QMediaPlaylist::loadLargePlaylist()
+{
+    QFETCH(int, count);
+
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString fileName = writeM3u(dir.path(), count);
+    QVERIFY(!fileName.isEmpty());
+
+    QMediaPlaylist playlist;
+    QSignalSpy loadSpy(&playlist, SIGNAL(loaded()));
+
+    QBENCHMARK_ONCE {
+        playlist.load(QUrl::fromLocalFile(fileName));
+        QTRY_VERIFY_WITH_TIMEOUT(!loadSpy.isEmpty(), 60000);
+    }
+
+    QCOMPARE(playlist.error(), QMediaPlaylist::NoError);
+    QCOMPARE(playlist.mediaCount(), count);
+    QCOMPARE(playlist.media(count - 1).canonicalUrl(),
+             QUrl(QString::fromLatin1("http://test.host/music/%1.mp3").arg(count - 1)));
+}
+
+void tst_QMediaPlaylist::loadLargePlaylistMemory_data()
+{
+    loadLargePlaylist_data();
+}
+
+// Resident memory per loaded entry, reported as the benchmark result
+void tst_QMediaPlaylist::loadLargePlaylistMemory()
+{
+#ifdef Q_OS_LINUX
+    QFETCH(int, count);
+
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString fileName = writeM3u(dir.path(), count);
+    QVERIFY(!fileName.isEmpty());
+
+    const qint64 before = residentMemory();
+    if (before <= 0)
+        QSKIP("Resident memory is not available");
+
+    QMediaPlaylist playlist;
+    QSignalSpy loadSpy(&playlist, SIGNAL(loaded()));
+    playlist.load(QUrl::fromLocalFile(fileName));
+    QTRY_VERIFY_WITH_TIMEOUT(!loadSpy.isEmpty(), 60000);
+    QCOMPARE(playlist.mediaCount(), count);
+
+    QTest::setBenchmarkResult(qreal(residentMemory() - before) / count, QTest::BytesAllocated);
+#else
+    QSKIP("Resident memory is only measured on Linux");
+#endif
+}
+
+void tst_QMediaPlaylist::loadLongLine_data()
+{
+    QTest::addColumn<int>("prefix");
+    QTest::addColumn<int>("length");
+    QTest::addColumn<bool>("valid");
+
+    // Lines ending inside one read chunk as well as ones spanning several
+    QTest::newRow("short line") << 0 << 4000 << true;
+    QTest::newRow("at limit") << 0 << 4096 << false;
+    QTest::newRow("within chunk") << 20000 << 5000 << false;
+    QTest::newRow("across chunks") << 0 << 100000 << false;
+}
+
+void tst_QMediaPlaylist::loadLongLine()
+{
+    QFETCH(int, prefix);
+    QFETCH(int, length);
+    QFETCH(bool, valid);
+
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QFile file(dir.path() + QLatin1String("/long.m3u"));
+    QVERIFY(file.open(QIODevice::WriteOnly));
+
+    QByteArray data("#EXTM3U\n");
+    for (int i = 0; data.size() < prefix; ++i)
+        data += "http://test.host/music/" + QByteArray::number(i) + ".mp3\n";
+    const QByteArray url = "http://test.host/";
+    data += url + QByteArray(length - url.size(), 'a') + '\n';
+    data += "http://test.host/last.mp3\n";
+    file.write(data);
+    file.close();
+
+    QMediaPlaylist playlist;
+    QSignalSpy loadSpy(&playlist, SIGNAL(loaded()));
+    QSignalSpy loadFailedSpy(&playlist, SIGNAL(loadFailed()));
+    if (!valid)
+        QTest::ignoreMessage(QtWarningMsg, QRegularExpression(QStringLiteral("line content >= 4096 bytes")));
+    playlist.load(QUrl::fromLocalFile(file.fileName()));
+    QTRY_VERIFY(!loadSpy.isEmpty() || !loadFailedSpy.isEmpty());
+
+    QCOMPARE(loadSpy.isEmpty(), !valid);
+    QCOMPARE(playlist.error() == QMediaPlaylist::NoError, valid);
+}
+
 QTEST_MAIN(tst_QMediaPlaylist)
 #include "tst_qmediaplaylist.moc"
 
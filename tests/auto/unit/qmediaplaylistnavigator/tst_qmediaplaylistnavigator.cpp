@@ -39,6 +39,38 @@
 #include <private/qmediaplaylistnavigator_p.h>
 
 QT_USE_NAMESPACE
+
+class CountingPlaylistProvider : public QMediaPlaylistProvider
+{
+public:
+    CountingPlaylistProvider(int count = 0) : m_count(count) {}
+
+    int mediaCount() const { return m_count; }
+    QMediaContent media(int pos) const
+    {
+        return pos >= 0 && pos < m_count
+                ? QMediaContent(QUrl(QString::fromLatin1("file:///%1").arg(pos)))
+                : QMediaContent();
+    }
+
+    void insert(int start, int count)
+    {
+        emit mediaAboutToBeInserted(start, start + count - 1);
+        m_count += count;
+        emit mediaInserted(start, start + count - 1);
+    }
+
+    void remove(int start, int count)
+    {
+        emit mediaAboutToBeRemoved(start, start + count - 1);
+        m_count -= count;
+        emit mediaRemoved(start, start + count - 1);
+    }
+
+private:
+    int m_count;
+};
+
 class tst_QMediaPlaylistNavigator : public QObject
 {
     Q_OBJECT
@@ -54,6 +86,14 @@ private slots:
     void currentItemOnce();
     void currentItemInLoop();
     void randomPlayback();
+    void randomPlaybackVisitsEachItemOnce_data();
+    void randomPlaybackVisitsEachItemOnce();
+    void randomPlaybackJump();
+    void randomPlaybackInsertRemove();
+    void randomPlaybackChangeMidLap();
+    void randomPlaybackManyChangesMidLap();
+    void randomPlaybackLargePlaylist_data();
+    void randomPlaybackLargePlaylist();
 
     void testItemAt();
     void testNextIndex();
@@ -314,6 +354,255 @@ void tst_QMediaPlaylistNavigator::randomPlayback()
 
 }
 
+void tst_QMediaPlaylistNavigator::randomPlaybackVisitsEachItemOnce_data()
+{
+    QTest::addColumn<int>("count");
+
+    QTest::newRow("1") << 1;
+    QTest::newRow("2") << 2;
+    QTest::newRow("3") << 3;
+    QTest::newRow("17") << 17;
+    QTest::newRow("1000") << 1000;
+}
+
+void tst_QMediaPlaylistNavigator::randomPlaybackVisitsEachItemOnce()
+{
+    QFETCH(int, count);
+
+    CountingPlaylistProvider playlist(count);
+    QMediaPlaylistNavigator navigator(&playlist);
+    navigator.setPlaybackMode(QMediaPlaylist::Random);
+
+    for (int lap = 0; lap < 3; ++lap) {
+        QVector<int> visits(count, 0);
+        for (int i = 0; i < count; ++i) {
+            const int previous = navigator.currentIndex();
+            const int expected = navigator.nextIndex();
+            navigator.next();
+
+            const int pos = navigator.currentIndex();
+            QCOMPARE(pos, expected);
+            QVERIFY(pos >= 0 && pos < count);
+            if (count > 2)
+                QVERIFY(pos != previous);
+            if (i > 0 || lap > 0)
+                QCOMPARE(navigator.previousIndex(), previous);
+            ++visits[pos];
+        }
+        QCOMPARE(visits.count(1), count);
+    }
+
+    // The order can be walked back through the laps
+    const int pos = navigator.currentIndex();
+    for (int i = 0; i < 2 * count; ++i)
+        navigator.previous();
+    for (int i = 0; i < 2 * count; ++i)
+        navigator.next();
+    QCOMPARE(navigator.currentIndex(), pos);
+}
+
+void tst_QMediaPlaylistNavigator::randomPlaybackJump()
+{
+    CountingPlaylistProvider playlist(10);
+    QMediaPlaylistNavigator navigator(&playlist);
+    navigator.setPlaybackMode(QMediaPlaylist::Random);
+
+    navigator.next();
+    navigator.next();
+    const int target = navigator.nextIndex(5);
+
+    // Jumping keeps the order, so the lap is still walked as a whole
+    navigator.jump(target);
+    QCOMPARE(navigator.currentIndex(), target);
+
+    QVector<int> visits(10, 0);
+    ++visits[target];
+    for (int i = 0; i < 3; ++i) {
+        navigator.next();
+        ++visits[navigator.currentIndex()];
+    }
+    for (int i = 0; i < 9; ++i) {
+        navigator.previous();
+        ++visits[navigator.currentIndex()];
+    }
+    QCOMPARE(visits.count(0), 0);
+}
+
+void tst_QMediaPlaylistNavigator::randomPlaybackInsertRemove()
+{
+    CountingPlaylistProvider playlist(20);
+    QMediaPlaylistNavigator navigator(&playlist);
+    navigator.setPlaybackMode(QMediaPlaylist::Random);
+
+    navigator.next();
+    navigator.next();
+    const int pos = navigator.currentIndex();
+    QVERIFY(pos != -1);
+
+    // Items appended after the current one keep it current
+    playlist.insert(20, 10);
+    QCOMPARE(navigator.currentIndex(), pos);
+
+    for (int i = 1; i <= 30; ++i) {
+        const int next = navigator.nextIndex(i);
+        QVERIFY(next >= 0 && next < 30);
+    }
+
+    // Items removed after the current one keep it current
+    playlist.remove(25, 5);
+    QCOMPARE(navigator.currentIndex(), pos);
+    for (int i = 1; i <= 25; ++i) {
+        const int next = navigator.nextIndex(i);
+        QVERIFY(next >= 0 && next < 25);
+    }
+
+    navigator.next();
+    QVERIFY(navigator.currentIndex() >= 0 && navigator.currentIndex() < 25);
+    navigator.previous();
+    QCOMPARE(navigator.currentIndex(), pos);
+
+    playlist.remove(0, 25);
+    QCOMPARE(navigator.nextIndex(), -1);
+    playlist.insert(0, 3);
+    navigator.next();
+    QVERIFY(navigator.currentIndex() >= 0 && navigator.currentIndex() < 3);
+}
+
+void tst_QMediaPlaylistNavigator::randomPlaybackChangeMidLap()
+{
+    CountingPlaylistProvider playlist(20);
+    QMediaPlaylistNavigator navigator(&playlist);
+    navigator.setPlaybackMode(QMediaPlaylist::Random);
+
+    QList<int> played;
+    for (int i = 0; i < 8; ++i) {
+        navigator.next();
+        played.append(navigator.currentIndex());
+    }
+
+    // Insert before some of the played items, their indexes shift
+    playlist.insert(3, 5);
+    for (int i = 0; i < played.count(); ++i) {
+        if (played.at(i) >= 3)
+            played[i] += 5;
+    }
+    QCOMPARE(navigator.currentIndex(), played.last());
+
+    // The steps already taken are kept
+    for (int i = 1; i < played.count(); ++i)
+        QCOMPARE(navigator.previousIndex(i), played.at(played.count() - 1 - i));
+
+    // The rest of the lap is everything not played yet, new items included
+    QList<int> remaining;
+    for (int i = 1; i <= 25 - played.count(); ++i)
+        remaining.append(navigator.nextIndex(i));
+    QSet<int> lap = played.toSet() + remaining.toSet();
+    QCOMPARE(lap.count(), 25);
+    for (int item = 3; item < 8; ++item)
+        QVERIFY(remaining.contains(item));
+
+    // Remove a played item and an unplayed one within the same lap
+    navigator.next();
+    played.append(navigator.currentIndex());
+    remaining.removeFirst();
+
+    const int removedPlayed = played.at(2);
+    const int removedUnplayed = remaining.at(3);
+    const int first = qMin(removedPlayed, removedUnplayed);
+    const int second = qMax(removedPlayed, removedUnplayed);
+    playlist.remove(second, 1);
+    playlist.remove(first, 1);
+
+    played.removeAll(removedPlayed);
+    remaining.removeAll(removedUnplayed);
+    for (QList<int>::iterator it = played.begin(); it != played.end(); ++it)
+        *it -= (*it > first) + (*it > second);
+    for (QList<int>::iterator it = remaining.begin(); it != remaining.end(); ++it)
+        *it -= (*it > first) + (*it > second);
+
+    QCOMPARE(navigator.currentIndex(), played.last());
+    for (int i = 1; i < played.count(); ++i)
+        QCOMPARE(navigator.previousIndex(i), played.at(played.count() - 1 - i));
+
+    // The unplayed items come in the same order as before the removal
+    for (int i = 0; i < remaining.count(); ++i) {
+        navigator.next();
+        QCOMPARE(navigator.currentIndex(), remaining.at(i));
+    }
+
+    // The next lap visits each remaining item once again
+    QVector<int> visits(23, 0);
+    for (int i = 0; i < 23; ++i) {
+        navigator.next();
+        ++visits[navigator.currentIndex()];
+    }
+    QCOMPARE(visits.count(1), 23);
+}
+
+void tst_QMediaPlaylistNavigator::randomPlaybackManyChangesMidLap()
+{
+    CountingPlaylistProvider playlist(1000000);
+    QMediaPlaylistNavigator navigator(&playlist);
+    navigator.setPlaybackMode(QMediaPlaylist::Random);
+
+    QList<int> played;
+    for (int i = 0; i < 10; ++i) {
+        navigator.next();
+        played.append(navigator.currentIndex());
+    }
+
+    // Single item changes anywhere in the playlist, none of them played
+    for (int i = 0; i < 100; ++i) {
+        const int position = (i * 7919) % playlist.mediaCount();
+        if (i % 2 == 0) {
+            playlist.insert(position, 1);
+            for (QList<int>::iterator it = played.begin(); it != played.end(); ++it)
+                *it += (*it >= position);
+        } else if (!played.contains(position)) {
+            playlist.remove(position, 1);
+            for (QList<int>::iterator it = played.begin(); it != played.end(); ++it)
+                *it -= (*it > position);
+        }
+    }
+
+    QCOMPARE(navigator.currentIndex(), played.last());
+    for (int i = 1; i < played.count(); ++i)
+        QCOMPARE(navigator.previousIndex(i), played.at(played.count() - 1 - i));
+
+    // The rest of the lap does not repeat what was played
+    for (int i = 0; i < 1000; ++i) {
+        navigator.next();
+        QVERIFY(!played.contains(navigator.currentIndex()));
+    }
+}
+
+void tst_QMediaPlaylistNavigator::randomPlaybackLargePlaylist_data()
+{
+    QTest::addColumn<int>("count");
+
+    QTest::newRow("10000") << 10000;
+    QTest::newRow("1000000") << 1000000;
+}
+
+void tst_QMediaPlaylistNavigator::randomPlaybackLargePlaylist()
+{
+    QFETCH(int, count);
+
+    CountingPlaylistProvider playlist(count);
+    QMediaPlaylistNavigator navigator(&playlist);
+    navigator.setPlaybackMode(QMediaPlaylist::Random);
+
+    QBENCHMARK {
+        for (int i = 0; i < 1000; ++i) {
+            navigator.next();
+            navigator.nextIndex(10);
+            navigator.previousIndex(10);
+        }
+    }
+
+    QVERIFY(navigator.currentIndex() >= 0 && navigator.currentIndex() < count);
+}
+
 void tst_QMediaPlaylistNavigator::testItemAt()
 {
     QMediaNetworkPlaylistProvider playlist;
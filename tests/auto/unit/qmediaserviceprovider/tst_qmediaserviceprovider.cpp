@@ -49,6 +49,8 @@
 
 QT_USE_NAMESPACE
 
+Q_DECLARE_METATYPE(QMediaServiceProviderHint)
+
 class MockMediaServiceProvider : public QMediaServiceProvider
 {
     QMediaService* requestService(const QByteArray &type, const QMediaServiceProviderHint &)
@@ -80,6 +82,9 @@ private slots:
     void testDefaultDevice();
     void testAvailableDevices();
     void testCameraInfo();
+    void testPluginMetaData();
+    void benchmarkRequestService_data();
+    void benchmarkRequestService();
 
 private:
     QObjectList plugins;
@@ -89,6 +94,10 @@ void tst_QMediaServiceProvider::initTestCase()
 {
 //    QMediaPluginLoader::setStaticPlugins(QLatin1String("mediaservice"), plugins);
     QCoreApplication::setLibraryPaths(QStringList() << QCoreApplication::applicationDirPath());
+
+    // Resolve every hint by probing the mock plugins, not from a device
+    // snapshot left by a previous run
+    qputenv("QT_MEDIASERVICE_DEVICE_CACHE", "0");
 }
 
 void tst_QMediaServiceProvider::testDefaultProviderAvailable()
@@ -379,6 +388,62 @@ void tst_QMediaServiceProvider::testCameraInfo()
     }
 }
 
+void tst_QMediaServiceProvider::testPluginMetaData()
+{
+    QMediaPluginLoader pluginLoader(QMediaServiceProviderFactoryInterface_iid,
+                                    QLatin1String("mediaservice"), Qt::CaseInsensitive);
+
+    const QList<QJsonObject> metaData = pluginLoader.metaData(QLatin1String(Q_MEDIASERVICE_MEDIAPLAYER));
+    QCOMPARE(metaData.count(), 4);
+
+    QStringList classNames;
+    foreach (const QJsonObject &object, metaData)
+        classNames << object.value(QStringLiteral("className")).toString();
+    QVERIFY(classNames.contains(QLatin1String("MockServicePlugin4")));
+
+    const QJsonObject plugin4 = metaData.at(classNames.indexOf(QLatin1String("MockServicePlugin4")));
+    QVERIFY(qobject_cast<QMediaServiceProviderPlugin*>(pluginLoader.instance(plugin4)) != 0);
+
+    // MockServicePlugin4 declares its features in the metadata, the provider
+    // must still honour them when selecting a service
+    QMediaServiceProvider *provider = QMediaServiceProvider::defaultServiceProvider();
+    QMediaService *service = provider->requestService(Q_MEDIASERVICE_MEDIAPLAYER,
+            QMediaServiceProviderHint(QMediaServiceProviderHint::StreamPlayback));
+    QVERIFY(service != 0);
+    QCOMPARE(service->objectName(), QLatin1String("MockServicePlugin4"));
+    provider->releaseService(service);
+}
+
+void tst_QMediaServiceProvider::benchmarkRequestService_data()
+{
+    QTest::addColumn<QByteArray>("type");
+    QTest::addColumn<QMediaServiceProviderHint>("hint");
+
+    QTest::newRow("player")
+            << QByteArray(Q_MEDIASERVICE_MEDIAPLAYER) << QMediaServiceProviderHint();
+    QTest::newRow("player, features")
+            << QByteArray(Q_MEDIASERVICE_MEDIAPLAYER)
+            << QMediaServiceProviderHint(QMediaServiceProviderHint::StreamPlayback);
+    QTest::newRow("camera, device")
+            << QByteArray(Q_MEDIASERVICE_CAMERA) << QMediaServiceProviderHint(QByteArray("backcamera"));
+    QTest::newRow("camera, position")
+            << QByteArray(Q_MEDIASERVICE_CAMERA) << QMediaServiceProviderHint(QCamera::BackFace);
+}
+
+void tst_QMediaServiceProvider::benchmarkRequestService()
+{
+    QFETCH(QByteArray, type);
+    QFETCH(QMediaServiceProviderHint, hint);
+
+    QMediaServiceProvider *provider = QMediaServiceProvider::defaultServiceProvider();
+
+    QBENCHMARK {
+        QMediaService *service = provider->requestService(type, hint);
+        QVERIFY(service != 0);
+        provider->releaseService(service);
+    }
+}
+
 QTEST_MAIN(tst_QMediaServiceProvider)
 
 #include "tst_qmediaserviceprovider.moc"
@@ -64,8 +64,38 @@ private slots:
     void testClear();
     void testComparisons();
     void testArithmetic();
+    void testIntersected();
+    void testRandomOperations();
+
+    void benchmarkAddFragments_data();
+    void benchmarkAddFragments();
+    void benchmarkContains();
+    void benchmarkUnion();
+    void benchmarkIntersection();
 };
 
+// Fragments [10 * i, 10 * i + 4] in shuffled order
+static QList<QMediaTimeInterval> fragments(int count, uint seed)
+{
+    QList<QMediaTimeInterval> result;
+    result.reserve(count);
+    for (int i = 0; i < count; ++i)
+        result.append(QMediaTimeInterval(qint64(i) * 10, qint64(i) * 10 + 4));
+
+    qsrand(seed);
+    for (int i = count - 1; i > 0; --i)
+        result.swap(i, qrand() % (i + 1));
+    return result;
+}
+
+static QMediaTimeRange fragmentRange(int count, qint64 offset)
+{
+    QMediaTimeRange range;
+    for (int i = 0; i < count; ++i)
+        range.addInterval(offset + qint64(i) * 10, offset + qint64(i) * 10 + 4);
+    return range;
+}
+
 void tst_QMediaTimeRange::testIntervalCtor()
 {
     //Default Ctor for Time Interval
@@ -793,6 +823,142 @@ void tst_QMediaTimeRange::testArithmetic()
     QVERIFY(a.latestTime() == 14);
 }
 
+void tst_QMediaTimeRange::testIntersected()
+{
+    QMediaTimeRange a;
+    a.addInterval(0, 10);
+    a.addInterval(20, 30);
+    a.addInterval(40, 50);
+
+    QMediaTimeRange b;
+    b.addInterval(5, 25);
+    b.addInterval(28, 45);
+    b.addInterval(60, 70);
+
+    QMediaTimeRange expected;
+    expected.addInterval(5, 10);
+    expected.addInterval(20, 25);
+    expected.addInterval(28, 30);
+    expected.addInterval(40, 45);
+
+    QCOMPARE(a.intersected(b), expected);
+    QCOMPARE(b.intersected(a), expected);
+    QCOMPARE(a.intersected(a), a);
+    QVERIFY(a.intersected(QMediaTimeRange()).isEmpty());
+    QVERIFY(QMediaTimeRange().intersected(a).isEmpty());
+    QVERIFY(a.intersected(QMediaTimeRange(11, 19)).isEmpty());
+
+    // a is not modified
+    QCOMPARE(a.intervals().count(), 3);
+}
+
+// Checks the range operations against a plain bitmap
+void tst_QMediaTimeRange::testRandomOperations()
+{
+    const int length = 200;
+    qsrand(42);
+
+    for (int round = 0; round < 50; ++round) {
+        QBitArray bitsA(length), bitsB(length);
+        QMediaTimeRange a, b;
+
+        for (int i = 0; i < 20; ++i) {
+            const int s = qrand() % length;
+            const int e = qMin(length - 1, s + qrand() % 15);
+            QBitArray &bits = i % 2 ? bitsB : bitsA;
+            QMediaTimeRange &range = i % 2 ? b : a;
+            const bool add = qrand() % 3 != 0;
+            for (int t = s; t <= e; ++t)
+                bits.setBit(t, add);
+            if (add)
+                range.addInterval(s, e);
+            else
+                range.removeInterval(s, e);
+        }
+
+        const QMediaTimeRange united = a + b;
+        const QMediaTimeRange subtracted = a - b;
+        const QMediaTimeRange intersected = a.intersected(b);
+
+        for (int t = 0; t < length; ++t) {
+            QCOMPARE(a.contains(t), bitsA.testBit(t));
+            QCOMPARE(united.contains(t), bitsA.testBit(t) || bitsB.testBit(t));
+            QCOMPARE(subtracted.contains(t), bitsA.testBit(t) && !bitsB.testBit(t));
+            QCOMPARE(intersected.contains(t), bitsA.testBit(t) && bitsB.testBit(t));
+        }
+
+        // Intervals stay sorted, disjoint and separated by gaps
+        foreach (const QMediaTimeRange &range, QList<QMediaTimeRange>() << a << united << subtracted << intersected) {
+            const QList<QMediaTimeInterval> intervals = range.intervals();
+            for (int i = 0; i < intervals.count(); ++i) {
+                QVERIFY(intervals.at(i).isNormal());
+                if (i > 0)
+                    QVERIFY(intervals.at(i - 1).end() + 1 < intervals.at(i).start());
+            }
+        }
+    }
+}
+
+void tst_QMediaTimeRange::benchmarkAddFragments_data()
+{
+    QTest::addColumn<int>("count");
+
+    QTest::newRow("1000") << 1000;
+    QTest::newRow("10000") << 10000;
+    QTest::newRow("100000") << 100000;
+}
+
+void tst_QMediaTimeRange::benchmarkAddFragments()
+{
+    QFETCH(int, count);
+
+    const QList<QMediaTimeInterval> list = fragments(count, 1);
+
+    QBENCHMARK {
+        QMediaTimeRange range;
+        for (int i = 0; i < list.count(); ++i)
+            range.addInterval(list.at(i));
+        QCOMPARE(range.intervals().count(), count);
+    }
+}
+
+void tst_QMediaTimeRange::benchmarkContains()
+{
+    const int count = 100000;
+    const QMediaTimeRange range = fragmentRange(count, 0);
+
+    QBENCHMARK {
+        int hits = 0;
+        for (qint64 t = 0; t < qint64(count) * 10; t += 7)
+            hits += range.contains(t) ? 1 : 0;
+        QVERIFY(hits > 0);
+    }
+}
+
+void tst_QMediaTimeRange::benchmarkUnion()
+{
+    const int count = 100000;
+    const QMediaTimeRange a = fragmentRange(count, 0);
+    const QMediaTimeRange b = fragmentRange(count, 5);
+
+    QBENCHMARK {
+        const QMediaTimeRange united = a + b;
+        QVERIFY(united.isContinuous());
+    }
+}
+
+void tst_QMediaTimeRange::benchmarkIntersection()
+{
+    const int count = 100000;
+    const QMediaTimeRange a = fragmentRange(count, 0);
+    const QMediaTimeRange b = fragmentRange(count, 2);
+
+    QBENCHMARK {
+        const QMediaTimeRange intersected = a.intersected(b);
+        QCOMPARE(intersected.intervals().count(), count);
+    }
+}
+
 QTEST_MAIN(tst_QMediaTimeRange)
 
 #include "tst_qmediatimerange.moc"
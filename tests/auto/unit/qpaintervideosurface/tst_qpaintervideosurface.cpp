@@ -34,6 +34,7 @@
 //TESTED_COMPONENT=src/multimedia
 
 #include <private/qpaintervideosurface_p.h>
+#include <private/qvideoframe_p.h>
 #include <QtTest/QtTest>
 
 #include <QtWidgets/qapplication.h>
@@ -61,6 +62,10 @@ private slots:
     void present_data();
     void present();
     void presentOpaqueFrame();
+    void presentYuv_data();
+    void presentYuv();
+    void paintFrameTime_data();
+    void paintFrameTime();
 
 #if !defined(QT_NO_OPENGL) && !defined(QT_OPENGL_ES_1_CL) && !defined(QT_OPENGL_ES_1)
 
@@ -244,14 +249,26 @@ void tst_QPainterVideoSurface::supportedFormat_data()
             << QAbstractVideoBuffer::NoHandle
             << QVideoFrame::Format_YUV420P
             << QSize(640, 480)
-            << false
-            << false;
+            << true
+            << true;
     QTest::newRow("YUV420P 640x-480")
             << QAbstractVideoBuffer::NoHandle
             << QVideoFrame::Format_YUV420P
             << QSize(640, -480)
-            << false
+            << true
             << false;
+    QTest::newRow("NV12 640x480")
+            << QAbstractVideoBuffer::NoHandle
+            << QVideoFrame::Format_NV12
+            << QSize(640, 480)
+            << true
+            << true;
+    QTest::newRow("UYVY 640x480")
+            << QAbstractVideoBuffer::NoHandle
+            << QVideoFrame::Format_UYVY
+            << QSize(640, 480)
+            << true
+            << true;
     QTest::newRow("Y8 640x480")
             << QAbstractVideoBuffer::NoHandle
             << QVideoFrame::Format_Y8
@@ -556,6 +573,116 @@ void tst_QPainterVideoSurface::presentOpaqueFrame()
     QCOMPARE(surface.error(), QAbstractVideoSurface::IncorrectFormatError);
 }
 
+static void addYuvFormats()
+{
+    QTest::newRow("YUV420P") << QVideoFrame::Format_YUV420P;
+    QTest::newRow("YV12") << QVideoFrame::Format_YV12;
+    QTest::newRow("NV12") << QVideoFrame::Format_NV12;
+    QTest::newRow("NV21") << QVideoFrame::Format_NV21;
+    QTest::newRow("UYVY") << QVideoFrame::Format_UYVY;
+    QTest::newRow("YUYV") << QVideoFrame::Format_YUYV;
+    QTest::newRow("YUV444") << QVideoFrame::Format_YUV444;
+}
+
+static QVideoFrame createYuvFrame(QVideoFrame::PixelFormat pixelFormat, const QSize &size)
+{
+    int bytesPerLine = size.width();
+    int bytes = size.width() * size.height() * 3 / 2;
+    if (pixelFormat == QVideoFrame::Format_UYVY || pixelFormat == QVideoFrame::Format_YUYV) {
+        bytesPerLine = size.width() * 2;
+        bytes = bytesPerLine * size.height();
+    } else if (pixelFormat == QVideoFrame::Format_YUV444) {
+        bytesPerLine = size.width() * 3;
+        bytes = bytesPerLine * size.height();
+    }
+
+    // Every byte of a uniform frame has the same value, whatever the layout
+    QVideoFrame frame(bytes, size, bytesPerLine, pixelFormat);
+    frame.map(QAbstractVideoBuffer::WriteOnly);
+    memset(frame.bits(), 0x60, frame.mappedBytes());
+    frame.unmap();
+
+    return frame;
+}
+
+void tst_QPainterVideoSurface::presentYuv_data()
+{
+    QTest::addColumn<QVideoFrame::PixelFormat>("pixelFormat");
+
+    addYuvFormats();
+}
+
+void tst_QPainterVideoSurface::presentYuv()
+{
+    QFETCH(QVideoFrame::PixelFormat, pixelFormat);
+
+    QPainterVideoSurface surface;
+
+    QVideoSurfaceFormat format(QSize(64, 48), pixelFormat);
+    QVERIFY(surface.start(format));
+
+    QVideoFrame frame = createYuvFrame(pixelFormat, QSize(64, 48));
+    const QRgb expected = qt_imageFromVideoFrame(frame).pixel(0, 0);
+
+    QVERIFY(surface.present(frame));
+
+    QImage image(320, 240, QImage::Format_RGB32);
+    image.fill(Qt::black);
+    {
+        QPainter painter(&image);
+        surface.paint(&painter, QRect(0, 0, 320, 240));
+    }
+    QCOMPARE(surface.error(), QAbstractVideoSurface::NoError);
+    QCOMPARE(image.pixel(0, 0), expected);
+    QCOMPARE(image.pixel(160, 120), expected);
+    QCOMPARE(image.pixel(319, 239), expected);
+
+    {   // Scaled by the painter's transform
+        QPainter painter(&image);
+        painter.scale(0.5, 0.5);
+        surface.paint(&painter, QRect(0, 0, 320, 240));
+    }
+    QCOMPARE(surface.error(), QAbstractVideoSurface::NoError);
+    QCOMPARE(image.pixel(80, 60), expected);
+}
+
+void tst_QPainterVideoSurface::paintFrameTime_data()
+{
+    QTest::addColumn<QVideoFrame::PixelFormat>("pixelFormat");
+
+    QTest::newRow("RGB32") << QVideoFrame::Format_RGB32;
+    addYuvFormats();
+}
+
+void tst_QPainterVideoSurface::paintFrameTime()
+{
+    QFETCH(QVideoFrame::PixelFormat, pixelFormat);
+
+    const QSize frameSize(1280, 720);
+
+    QPainterVideoSurface surface;
+    QVERIFY(surface.start(QVideoSurfaceFormat(frameSize, pixelFormat)));
+
+    QVideoFrame frame;
+    if (pixelFormat == QVideoFrame::Format_RGB32) {
+        QImage image(frameSize, QImage::Format_RGB32);
+        image.fill(Qt::gray);
+        frame = QVideoFrame(image);
+    } else {
+        frame = createYuvFrame(pixelFormat, frameSize);
+    }
+    QVERIFY(surface.present(frame));
+
+    // A window sized target, smaller than the frame
+    QImage image(960, 540, QImage::Format_RGB32);
+    QPainter painter(&image);
+
+    QBENCHMARK {
+        surface.paint(&painter, image.rect());
+    }
+    QCOMPARE(surface.error(), QAbstractVideoSurface::NoError);
+}
+
 #if !defined(QT_NO_OPENGL) && !defined(QT_OPENGL_ES_1_CL) && !defined(QT_OPENGL_ES_1)
 
 void tst_QPainterVideoSurface::shaderType()
@@ -36,24 +36,104 @@
 #include <QtTest/QtTest>
 #include <private/qsamplecache_p.h>
 
+#if defined(Q_OS_LINUX)
+#include <unistd.h>
+#endif
+
+static const int ColdStartSampleCount = 500;
+static const int LargeSampleFrames = 4 * 1024 * 1024;
+
 class tst_QSampleCache : public QObject
 {
     Q_OBJECT
 public:
 
 public slots:
+    void sampleReady();
 
 private slots:
+    void initTestCase();
     void testCachedSample();
     void testNotCachedSample();
     void testEnoughCapacity();
     void testNotEnoughCapacity();
     void testInvalidFile();
+    void testLoadingThreadCount();
+    void testLoadPriority();
+    void testLeastRecentlyUsed();
+    void coldStart_data();
+    void coldStart();
+    void testMappedSample();
+    void largeSample_data();
+    void largeSample();
 
 private:
+    QUrl generatedSample(int index) const;
+    QUrl largeSampleUrl() const;
 
+    QTemporaryDir m_dir;
+    QList<QObject*> m_readyOrder;
 };
 
+static bool writeWave(const QString &fileName, int frames)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+
+    const quint32 dataSize = frames * 2;
+    QDataStream out(&file);
+    out.setByteOrder(QDataStream::LittleEndian);
+    out.writeRawData("RIFF", 4);
+    out << quint32(36 + dataSize);
+    out.writeRawData("WAVEfmt ", 8);
+    out << quint32(16) << quint16(1) << quint16(1)      // PCM, mono
+        << quint32(22050) << quint32(22050 * 2)         // sample rate, byte rate
+        << quint16(2) << quint16(16);                   // block align, bits per sample
+    out.writeRawData("data", 4);
+    out << dataSize;
+    for (int i = 0; i < frames; ++i)
+        out << qint16((i % 64) * 256);
+    return out.status() == QDataStream::Ok;
+}
+
+// Resident memory of the test process, -1 where unknown
+static qint64 residentSetSize()
+{
+#if defined(Q_OS_LINUX)
+    QFile statm(QLatin1String("/proc/self/statm"));
+    if (statm.open(QIODevice::ReadOnly)) {
+        const QList<QByteArray> fields = statm.readAll().split(' ');
+        if (fields.size() > 1)
+            return fields.at(1).toLongLong() * sysconf(_SC_PAGESIZE);
+    }
+#endif
+    return -1;
+}
+
+void tst_QSampleCache::initTestCase()
+{
+    QVERIFY(m_dir.isValid());
+    for (int i = 0; i < ColdStartSampleCount; ++i)
+        QVERIFY(writeWave(m_dir.path() + QString::fromLatin1("/sample%1.wav").arg(i), 2048));
+    QVERIFY(writeWave(m_dir.path() + QLatin1String("/large.wav"), LargeSampleFrames));
+}
+
+QUrl tst_QSampleCache::largeSampleUrl() const
+{
+    return QUrl::fromLocalFile(m_dir.path() + QLatin1String("/large.wav"));
+}
+
+QUrl tst_QSampleCache::generatedSample(int index) const
+{
+    return QUrl::fromLocalFile(m_dir.path() + QString::fromLatin1("/sample%1.wav").arg(index));
+}
+
+void tst_QSampleCache::sampleReady()
+{
+    m_readyOrder.append(sender());
+}
+
 void tst_QSampleCache::testCachedSample()
 {
     QSampleCache cache;
@@ -186,6 +266,185 @@ void tst_QSampleCache::testInvalidFile()
     QVERIFY(!cache.isCached(QUrl::fromLocalFile("invalid")));
 }
 
+void tst_QSampleCache::testLoadingThreadCount()
+{
+    QSampleCache cache;
+    QVERIFY(cache.loadingThreadCount() >= 1);
+
+    cache.setLoadingThreadCount(3);
+    QCOMPARE(cache.loadingThreadCount(), 3);
+    cache.setLoadingThreadCount(0);
+    QCOMPARE(cache.loadingThreadCount(), 1);
+
+    QList<QSample*> samples;
+    for (int i = 0; i < 8; ++i)
+        samples.append(cache.requestSample(generatedSample(i)));
+    cache.setLoadingThreadCount(4); // pending requests use the new loaders
+    QTRY_VERIFY(!cache.isLoading());
+
+    foreach (QSample *sample, samples) {
+        QCOMPARE(sample->state(), QSample::Ready);
+        sample->release();
+    }
+}
+
+void tst_QSampleCache::testLoadPriority()
+{
+    QSampleCache cache;
+    cache.setLoadingThreadCount(1);
+    m_readyOrder.clear();
+
+    const int count = 32;
+    QList<QSample*> samples;
+    for (int i = 0; i < count; ++i) {
+        QSample *sample = cache.requestSample(generatedSample(i), QSampleCache::LowPriority);
+        connect(sample, SIGNAL(ready()), this, SLOT(sampleReady()));
+        samples.append(sample);
+    }
+
+    // The first request is already loading, the others wait for the only loader
+    QSample *urgent = cache.requestSample(generatedSample(count), QSampleCache::HighPriority);
+    connect(urgent, SIGNAL(ready()), this, SLOT(sampleReady()));
+    QSample *promoted = samples.last();
+    cache.setLoadPriority(promoted, QSampleCache::NormalPriority);
+
+    QTRY_COMPARE(m_readyOrder.count(), count + 1);
+    QVERIFY(m_readyOrder.indexOf(urgent) <= 1);
+    QVERIFY(m_readyOrder.indexOf(promoted) <= 2);
+    QVERIFY(m_readyOrder.indexOf(urgent) < m_readyOrder.indexOf(promoted));
+
+    foreach (QSample *sample, samples)
+        sample->release();
+    urgent->release();
+    QTRY_VERIFY(!cache.isLoading());
+}
+
+void tst_QSampleCache::testLeastRecentlyUsed()
+{
+    QSampleCache cache;
+
+    QSample *first = cache.requestSample(generatedSample(0));
+    QSample *second = cache.requestSample(generatedSample(1));
+    QTRY_VERIFY(!cache.isLoading());
+    QCOMPARE(first->state(), QSample::Ready);
+    cache.setCapacity(first->data().size() * 2);
+    first->release();
+    second->release();
+
+    // Touch the first sample so the second one is the least recently used
+    first = cache.requestSample(generatedSample(0));
+    QCOMPARE(first->state(), QSample::Ready);
+    first->release();
+
+    QSample *third = cache.requestSample(generatedSample(2));
+    QTRY_VERIFY(!cache.isLoading());
+    third->release();
+
+    QVERIFY(cache.isCached(generatedSample(0)));
+    QVERIFY(!cache.isCached(generatedSample(1)));
+    QVERIFY(cache.isCached(generatedSample(2)));
+}
+
+void tst_QSampleCache::coldStart_data()
+{
+    QTest::addColumn<int>("threads");
+
+    QTest::newRow("1 thread") << 1;
+    QTest::newRow("2 threads") << 2;
+    QTest::newRow("4 threads") << 4;
+}
+
+void tst_QSampleCache::coldStart()
+{
+    QFETCH(int, threads);
+
+    QBENCHMARK {
+        QSampleCache cache;
+        cache.setLoadingThreadCount(threads);
+
+        QList<QSample*> samples;
+        for (int i = 0; i < ColdStartSampleCount; ++i)
+            samples.append(cache.requestSample(generatedSample(i)));
+        QTRY_VERIFY_WITH_TIMEOUT(!cache.isLoading(), 60000);
+
+        foreach (QSample *sample, samples) {
+            QCOMPARE(sample->state(), QSample::Ready);
+            sample->release();
+        }
+    }
+}
+
+void tst_QSampleCache::testMappedSample()
+{
+    QSampleCache streamingCache;
+    streamingCache.setMappingThreshold(-1);
+    QSampleCache mappingCache;
+    mappingCache.setMappingThreshold(0);
+
+    QSample *streamed = streamingCache.requestSample(largeSampleUrl());
+    QSample *mapped = mappingCache.requestSample(largeSampleUrl());
+    QTRY_VERIFY(!streamingCache.isLoading());
+    QTRY_VERIFY(!mappingCache.isLoading());
+
+    QCOMPARE(streamed->state(), QSample::Ready);
+    QCOMPARE(mapped->state(), QSample::Ready);
+    QVERIFY(!streamed->isMapped());
+    QVERIFY(mapped->isMapped());
+    QCOMPARE(mapped->format(), streamed->format());
+    QCOMPARE(mapped->data().size(), LargeSampleFrames * 2);
+    QVERIFY(mapped->data() == streamed->data());
+
+    // Small files below the threshold are still read
+    mappingCache.setMappingThreshold(1024 * 1024);
+    QSample *small = mappingCache.requestSample(generatedSample(0));
+    QTRY_VERIFY(!mappingCache.isLoading());
+    QCOMPARE(small->state(), QSample::Ready);
+    QVERIFY(!small->isMapped());
+
+    small->release();
+    mapped->release();
+    streamed->release();
+}
+
+void tst_QSampleCache::largeSample_data()
+{
+    QTest::addColumn<bool>("mapping");
+
+    QTest::newRow("streaming") << false;
+    QTest::newRow("mapped") << true;
+}
+
+void tst_QSampleCache::largeSample()
+{
+    QFETCH(bool, mapping);
+
+    QSampleCache cache;
+    cache.setMappingThreshold(mapping ? 0 : -1);
+
+    const qint64 residentBefore = residentSetSize();
+    QSample *sample = cache.requestSample(largeSampleUrl());
+    QTRY_VERIFY(!cache.isLoading());
+    QCOMPARE(sample->state(), QSample::Ready);
+    QCOMPARE(sample->isMapped(), mapping);
+    const qint64 residentGrowth = residentSetSize() - residentBefore;
+    sample->release();
+
+    if (residentBefore >= 0) {
+        qDebug() << (mapping ? "mapped" : "streaming") << "load grew resident memory by"
+                 << residentGrowth / 1024 << "KiB for" << LargeSampleFrames * 2 / 1024 << "KiB of data";
+        // Mapped data is not paged in until it is played
+        if (mapping)
+            QVERIFY(residentGrowth < LargeSampleFrames);
+    }
+
+    QBENCHMARK {
+        QSample *reloaded = cache.requestSample(largeSampleUrl());
+        QTRY_VERIFY(!cache.isLoading());
+        QCOMPARE(reloaded->state(), QSample::Ready);
+        reloaded->release();
+    }
+}
+
 QTEST_MAIN(tst_QSampleCache)
 
 #include "tst_qsamplecache.moc"
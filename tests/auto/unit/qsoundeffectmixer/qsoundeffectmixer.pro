@@ -0,0 +1,6 @@
+CONFIG += testcase
+TARGET = tst_qsoundeffectmixer
+
+QT += multimedia-private testlib
+
+SOURCES += tst_qsoundeffectmixer.cpp
@@ -0,0 +1,290 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+//TESTED_COMPONENT=src/multimedia
+
+#include <QtTest/QtTest>
+#include <private/qsoundeffectmixer_p.h>
+
+class TestVoice : public QSoundEffectVoice
+{
+public:
+    TestVoice(int loops = 1) : loopsRemaining(loops), finished(false) {}
+
+    bool voiceLooped() { return --loopsRemaining > 0; }
+    void voiceFinished() { finished = true; }
+
+    int loopsRemaining;
+    bool finished;
+};
+
+class tst_QSoundEffectMixer : public QObject
+{
+    Q_OBJECT
+public:
+
+public slots:
+
+private slots:
+    void kernels_data();
+    void kernels();
+    void mixMonoAndStereo();
+    void saturation();
+    void loopAndFinish();
+    void removeWhileLooping();
+    void voicesPerCore_data();
+    void voicesPerCore();
+
+private:
+    static QAudioFormat sampleFormat(int channels, int sampleSize = 16);
+};
+
+QAudioFormat tst_QSoundEffectMixer::sampleFormat(int channels, int sampleSize)
+{
+    QAudioFormat format;
+    format.setSampleRate(48000);
+    format.setChannelCount(channels);
+    format.setSampleSize(sampleSize);
+    format.setSampleType(sampleSize == 8 ? QAudioFormat::UnSignedInt : QAudioFormat::SignedInt);
+    format.setByteOrder(QAudioFormat::Endian(QSysInfo::ByteOrder));
+    format.setCodec(QLatin1String("audio/pcm"));
+    return format;
+}
+
+void tst_QSoundEffectMixer::kernels_data()
+{
+    QTest::addColumn<int>("gain");
+    QTest::addColumn<int>("count");
+
+    QTest::newRow("silent") << 0 << 37;
+    QTest::newRow("half") << int(QSoundEffectMixer::UnityGain / 2) << 64;
+    QTest::newRow("odd gain") << 12345 << 101;
+    QTest::newRow("unity") << int(QSoundEffectMixer::UnityGain) << 3;
+    QTest::newRow("unity, long") << int(QSoundEffectMixer::UnityGain) << 1027;
+}
+
+void tst_QSoundEffectMixer::kernels()
+{
+    QFETCH(int, gain);
+    QFETCH(int, count);
+
+    // The dispatched kernels must match the scalar definition exactly.
+    QVector<qint16> samples(count);
+    QVector<qint32> expected(2 * count);
+    for (int i = 0; i < count; ++i)
+        samples[i] = qint16((i * 7919) ^ (i << 11));
+    for (int i = 0; i < expected.size(); ++i)
+        expected[i] = (i % 2 ? 40000 : -40000) + i;
+
+    QVector<qint32> stereo = expected;
+    QVector<qint32> mono = expected;
+    const QSoundEffectMixer::Kernels &kernels = QSoundEffectMixer::kernels();
+    kernels.mix(stereo.data(), samples.constData(), count, gain);
+    kernels.mixMonoToStereo(mono.data(), samples.constData(), count, gain);
+
+    for (int i = 0; i < count; ++i) {
+        const qint32 value = gain >= QSoundEffectMixer::UnityGain ? samples[i] : (samples[i] * gain) >> 15;
+        QCOMPARE(stereo.at(i), expected.at(i) + value);
+        QCOMPARE(mono.at(2 * i), expected.at(2 * i) + value);
+        QCOMPARE(mono.at(2 * i + 1), expected.at(2 * i + 1) + value);
+    }
+    for (int i = count; i < stereo.size(); ++i)
+        QCOMPARE(stereo.at(i), expected.at(i));
+
+    QVector<qint16> output(mono.size());
+    kernels.saturate(output.data(), mono.constData(), mono.size());
+    for (int i = 0; i < mono.size(); ++i)
+        QCOMPARE(output.at(i), qint16(qBound<qint32>(-32768, mono.at(i), 32767)));
+}
+
+void tst_QSoundEffectMixer::mixMonoAndStereo()
+{
+    QSoundEffectMixer mixer(48000);
+
+    QVector<qint16> mono(16, 1000);
+    QVector<qint16> stereo(32);
+    for (int i = 0; i < 16; ++i) {
+        stereo[2 * i] = 100;
+        stereo[2 * i + 1] = -100;
+    }
+    QByteArray unsignedData(16, char(128 + 1));
+
+    TestVoice monoVoice, stereoVoice, unsignedVoice;
+    mixer.addVoice(&monoVoice, reinterpret_cast<const char *>(mono.constData()), 32,
+                   sampleFormat(1), QSoundEffectMixer::UnityGain);
+    mixer.addVoice(&stereoVoice, reinterpret_cast<const char *>(stereo.constData()), 64,
+                   sampleFormat(2), QSoundEffectMixer::gainFromVolume(0.5));
+    mixer.addVoice(&unsignedVoice, unsignedData.constData(), unsignedData.size(),
+                   sampleFormat(1, 8), QSoundEffectMixer::UnityGain);
+    QCOMPARE(mixer.voiceCount(), 3);
+
+    qint16 output[2 * 8];
+    QCOMPARE(mixer.mix(output, 8), 8);
+    for (int i = 0; i < 8; ++i) {
+        QCOMPARE(output[2 * i], qint16(1000 + 50 + 256));
+        QCOMPARE(output[2 * i + 1], qint16(1000 - 50 + 256));
+    }
+}
+
+void tst_QSoundEffectMixer::saturation()
+{
+    QSoundEffectMixer mixer(48000);
+
+    QVector<qint16> loud(64, 30000);
+    TestVoice first, second;
+    mixer.addVoice(&first, reinterpret_cast<const char *>(loud.constData()), 128,
+                   sampleFormat(1), QSoundEffectMixer::UnityGain);
+    mixer.addVoice(&second, reinterpret_cast<const char *>(loud.constData()), 128,
+                   sampleFormat(1), QSoundEffectMixer::UnityGain);
+
+    qint16 output[2 * 32];
+    mixer.mix(output, 32);
+    for (int i = 0; i < 64; ++i)
+        QCOMPARE(output[i], qint16(32767));
+}
+
+void tst_QSoundEffectMixer::loopAndFinish()
+{
+    QSoundEffectMixer mixer(48000);
+
+    QVector<qint16> samples(10, 1);
+    TestVoice voice(3);
+    mixer.addVoice(&voice, reinterpret_cast<const char *>(samples.constData()), 20,
+                   sampleFormat(1), QSoundEffectMixer::UnityGain);
+
+    qint16 output[2 * 40];
+    mixer.mix(output, 40);
+
+    // Three loops of ten frames, then silence.
+    QVERIFY(voice.finished);
+    QCOMPARE(mixer.voiceCount(), 0);
+    for (int i = 0; i < 60; ++i)
+        QCOMPARE(output[i], qint16(1));
+    for (int i = 60; i < 80; ++i)
+        QCOMPARE(output[i], qint16(0));
+}
+
+class RemovingVoice : public TestVoice
+{
+public:
+    RemovingVoice(QSoundEffectMixer *mixer) : m_mixer(mixer) {}
+
+    bool voiceLooped() { m_mixer->removeVoice(this); return true; }
+
+private:
+    QSoundEffectMixer *m_mixer;
+};
+
+void tst_QSoundEffectMixer::removeWhileLooping()
+{
+    QSoundEffectMixer mixer(48000);
+
+    QVector<qint16> samples(4, 1);
+    RemovingVoice voice(&mixer);
+    TestVoice other(100);
+    mixer.addVoice(&voice, reinterpret_cast<const char *>(samples.constData()), 8,
+                   sampleFormat(1), QSoundEffectMixer::UnityGain);
+    mixer.addVoice(&other, reinterpret_cast<const char *>(samples.constData()), 8,
+                   sampleFormat(1), QSoundEffectMixer::UnityGain);
+
+    qint16 output[2 * 16];
+    mixer.mix(output, 16);
+
+    // Removed voices are not reported as finished.
+    QVERIFY(!voice.finished);
+    QVERIFY(!mixer.hasVoice(&voice));
+    QVERIFY(mixer.hasVoice(&other));
+    QCOMPARE(output[0], qint16(2));
+    QCOMPARE(output[30], qint16(1));
+}
+
+void tst_QSoundEffectMixer::voicesPerCore_data()
+{
+    QTest::addColumn<int>("voices");
+    QTest::addColumn<int>("channels");
+
+    QTest::newRow("64 mono") << 64 << 1;
+    QTest::newRow("256 mono") << 256 << 1;
+    QTest::newRow("256 stereo") << 256 << 2;
+}
+
+void tst_QSoundEffectMixer::voicesPerCore()
+{
+    QFETCH(int, voices);
+    QFETCH(int, channels);
+
+    const int sampleRate = 48000;
+    const int periodFrames = 480;   // 10 ms periods
+
+    QSoundEffectMixer mixer(sampleRate);
+
+    // One second of noise per voice, every voice starting at a different point.
+    QVector<qint16> samples(sampleRate * channels);
+    for (int i = 0; i < samples.size(); ++i)
+        samples[i] = qint16((i * 7919) ^ (i << 11));
+
+    QVector<TestVoice *> owners;
+    for (int i = 0; i < voices; ++i) {
+        TestVoice *voice = new TestVoice(1000000);
+        const int offset = (i * 997 % sampleRate) * channels;
+        mixer.addVoice(voice, reinterpret_cast<const char *>(samples.constData() + offset),
+                       (samples.size() - offset) * 2, sampleFormat(channels),
+                       QSoundEffectMixer::gainFromVolume(0.1));
+        owners.append(voice);
+    }
+
+    QVector<qint16> output(2 * periodFrames);
+    QElapsedTimer timer;
+    qint64 mixedFrames = 0;
+
+    QBENCHMARK {
+        timer.start();
+        mixedFrames = 0;
+        for (int period = 0; period < sampleRate / periodFrames; ++period)
+            mixedFrames += mixer.mix(output.data(), periodFrames);
+    }
+    const qint64 elapsed = qMax<qint64>(1, timer.nsecsElapsed());
+
+    // How many voices one core could keep mixing in real time.
+    const qreal realTime = qreal(mixedFrames) / sampleRate * 1e9;
+    qDebug() << voices << (channels == 1 ? "mono" : "stereo") << "voices:"
+             << qRound(voices * realTime / elapsed) << "voices per core";
+
+    QCOMPARE(mixer.voiceCount(), voices);
+    qDeleteAll(owners);
+}
+
+QTEST_MAIN(tst_QSoundEffectMixer)
+
+#include "tst_qsoundeffectmixer.moc"
@@ -0,0 +1,6 @@
+CONFIG += testcase
+TARGET = tst_qvideobufferpool
+
+QT += core multimedia-private testlib
+
+SOURCES += tst_qvideobufferpool.cpp
@@ -0,0 +1,350 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the test suite of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+//TESTED_COMPONENT=src/multimedia
+
+#include <QtTest/QtTest>
+
+#include <private/qvideobufferpool_p.h>
+#include <qabstractvideobuffer.h>
+
+class tst_QVideoBufferPool : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void alignedBytesPerLine_data();
+    void alignedBytesPerLine();
+    void planeLayout_data();
+    void planeLayout();
+    void unsupportedFormat();
+    void reuseOnLastUnref();
+    void bucketsBySizeAndFormat();
+    void bucketLimit();
+    void recycledContents();
+    void poolOutlivedByFrames();
+    void copyFrame();
+    void allocationsPerSecond();
+
+    void allocate_data();
+    void allocate();
+};
+
+void tst_QVideoBufferPool::alignedBytesPerLine_data()
+{
+    QTest::addColumn<QVideoFrame::PixelFormat>("format");
+    QTest::addColumn<int>("width");
+    QTest::addColumn<int>("bytesPerLine");
+
+    QTest::newRow("ARGB32 640") << QVideoFrame::Format_ARGB32 << 640 << 2560;
+    QTest::newRow("ARGB32 17") << QVideoFrame::Format_ARGB32 << 17 << 128;
+    QTest::newRow("RGB24 17") << QVideoFrame::Format_RGB24 << 17 << 64;
+    QTest::newRow("RGB565 100") << QVideoFrame::Format_RGB565 << 100 << 256;
+    QTest::newRow("UYVY 33") << QVideoFrame::Format_UYVY << 33 << 128;
+    QTest::newRow("Y8 1") << QVideoFrame::Format_Y8 << 1 << 64;
+    QTest::newRow("YUV420P 100") << QVideoFrame::Format_YUV420P << 100 << 128;
+    QTest::newRow("YV12 130") << QVideoFrame::Format_YV12 << 130 << 256;
+    QTest::newRow("NV12 100") << QVideoFrame::Format_NV12 << 100 << 128;
+    QTest::newRow("Jpeg") << QVideoFrame::Format_Jpeg << 100 << 0;
+    QTest::newRow("empty") << QVideoFrame::Format_ARGB32 << 0 << 0;
+}
+
+void tst_QVideoBufferPool::alignedBytesPerLine()
+{
+    QFETCH(QVideoFrame::PixelFormat, format);
+    QFETCH(int, width);
+    QFETCH(int, bytesPerLine);
+
+    QCOMPARE(QVideoBufferPool::alignedBytesPerLine(format, width), bytesPerLine);
+}
+
+void tst_QVideoBufferPool::planeLayout_data()
+{
+    QTest::addColumn<QVideoFrame::PixelFormat>("format");
+    QTest::addColumn<QSize>("size");
+    QTest::addColumn<int>("planeCount");
+
+    QTest::newRow("ARGB32") << QVideoFrame::Format_ARGB32 << QSize(101, 37) << 1;
+    QTest::newRow("YUYV") << QVideoFrame::Format_YUYV << QSize(100, 37) << 1;
+    QTest::newRow("YUV420P") << QVideoFrame::Format_YUV420P << QSize(100, 38) << 3;
+    QTest::newRow("YV12") << QVideoFrame::Format_YV12 << QSize(100, 36) << 3;
+    QTest::newRow("NV12") << QVideoFrame::Format_NV12 << QSize(100, 37) << 2;
+    QTest::newRow("NV21") << QVideoFrame::Format_NV21 << QSize(100, 36) << 2;
+    QTest::newRow("IMC1") << QVideoFrame::Format_IMC1 << QSize(100, 36) << 3;
+    QTest::newRow("IMC2") << QVideoFrame::Format_IMC2 << QSize(100, 37) << 2;
+}
+
+void tst_QVideoBufferPool::planeLayout()
+{
+    QFETCH(QVideoFrame::PixelFormat, format);
+    QFETCH(QSize, size);
+    QFETCH(int, planeCount);
+
+    QVideoBufferPool pool;
+    QVideoFrame frame = pool.allocateFrame(format, size);
+    QVERIFY(frame.isValid());
+    QCOMPARE(frame.handleType(), QAbstractVideoBuffer::NoHandle);
+    QCOMPARE(frame.size(), size);
+    QCOMPARE(frame.pixelFormat(), format);
+
+    QVERIFY(frame.map(QAbstractVideoBuffer::ReadWrite));
+    QCOMPARE(frame.planeCount(), planeCount);
+    QCOMPARE(frame.bytesPerLine(), QVideoBufferPool::alignedBytesPerLine(format, size.width()));
+    QCOMPARE(frame.mappedBytes(),
+             QVideoBufferPool::frameBytes(format, size, frame.bytesPerLine()));
+
+    for (int plane = 0; plane < frame.planeCount(); ++plane) {
+        QCOMPARE(quintptr(frame.bits(plane)) % QVideoBufferPool::Alignment, quintptr(0));
+        QCOMPARE(frame.bytesPerLine(plane) % QVideoBufferPool::Alignment, 0);
+    }
+
+    // The last row of the last plane is inside the buffer
+    const int last = frame.planeCount() - 1;
+    const int rows = last == 0 ? size.height() : (size.height() + 1) / 2;
+    const uchar *end = frame.bits() + frame.mappedBytes();
+    QVERIFY(frame.bits(last) + (rows - 1) * frame.bytesPerLine(last) < end);
+    QVERIFY(frame.bits(last) + rows * frame.bytesPerLine(last) <= end);
+
+    frame.unmap();
+}
+
+void tst_QVideoBufferPool::unsupportedFormat()
+{
+    QVideoBufferPool pool;
+    QVERIFY(!pool.allocateBuffer(QVideoFrame::Format_Jpeg, QSize(64, 64)));
+    QVERIFY(!pool.allocateFrame(QVideoFrame::Format_ARGB32, QSize()).isValid());
+    QCOMPARE(pool.allocationCount(), 0);
+}
+
+void tst_QVideoBufferPool::reuseOnLastUnref()
+{
+    QVideoBufferPool pool;
+    const QSize size(320, 240);
+
+    const uchar *bits = 0;
+    {
+        QVideoFrame frame = pool.allocateFrame(QVideoFrame::Format_RGB32, size);
+        QVideoFrame other = frame;
+        QVERIFY(frame.map(QAbstractVideoBuffer::WriteOnly));
+        bits = frame.bits();
+        frame.unmap();
+
+        frame = QVideoFrame();
+        // Still referenced
+        QCOMPARE(pool.pooledBufferCount(), 0);
+    }
+    QCOMPARE(pool.allocationCount(), 1);
+    QCOMPARE(pool.pooledBufferCount(), 1);
+    QVERIFY(pool.pooledBytes() >= qint64(size.width()) * size.height() * 4);
+
+    QVideoFrame frame = pool.allocateFrame(QVideoFrame::Format_RGB32, size);
+    QCOMPARE(pool.allocationCount(), 1);
+    QCOMPARE(pool.reuseCount(), 1);
+    QCOMPARE(pool.pooledBufferCount(), 0);
+    QCOMPARE(pool.pooledBytes(), qint64(0));
+
+    QVERIFY(frame.map(QAbstractVideoBuffer::ReadOnly));
+    QCOMPARE(frame.bits(), bits);
+    frame.unmap();
+}
+
+void tst_QVideoBufferPool::bucketsBySizeAndFormat()
+{
+    QVideoBufferPool pool;
+    pool.allocateFrame(QVideoFrame::Format_RGB32, QSize(64, 64));
+    QCOMPARE(pool.pooledBufferCount(), 1);
+
+    pool.allocateFrame(QVideoFrame::Format_RGB32, QSize(64, 32));
+    pool.allocateFrame(QVideoFrame::Format_ARGB32, QSize(64, 64));
+    QCOMPARE(pool.allocationCount(), 3);
+    QCOMPARE(pool.reuseCount(), 0);
+    QCOMPARE(pool.pooledBufferCount(), 3);
+
+    pool.allocateFrame(QVideoFrame::Format_ARGB32, QSize(64, 64));
+    QCOMPARE(pool.allocationCount(), 3);
+    QCOMPARE(pool.reuseCount(), 1);
+
+    pool.clear();
+    QCOMPARE(pool.pooledBufferCount(), 0);
+    QCOMPARE(pool.pooledBytes(), qint64(0));
+}
+
+void tst_QVideoBufferPool::bucketLimit()
+{
+    QVideoBufferPool pool(2);
+    QCOMPARE(pool.maxBuffersPerBucket(), 2);
+
+    {
+        QList<QVideoFrame> frames;
+        for (int i = 0; i < 5; ++i)
+            frames.append(pool.allocateFrame(QVideoFrame::Format_Y8, QSize(16, 16)));
+        QCOMPARE(pool.allocationCount(), 5);
+    }
+    QCOMPARE(pool.pooledBufferCount(), 2);
+
+    pool.setMaxBuffersPerBucket(1);
+    QCOMPARE(pool.pooledBufferCount(), 1);
+
+    pool.setMaxBuffersPerBucket(0);
+    QCOMPARE(pool.pooledBufferCount(), 0);
+    pool.allocateFrame(QVideoFrame::Format_Y8, QSize(16, 16));
+    QCOMPARE(pool.pooledBufferCount(), 0);
+}
+
+void tst_QVideoBufferPool::recycledContents()
+{
+    QVideoBufferPool pool;
+    {
+        QVideoFrame frame = pool.allocateFrame(QVideoFrame::Format_ARGB32, QSize(8, 8));
+        QVERIFY(frame.map(QAbstractVideoBuffer::ReadWrite));
+        memset(frame.bits(), 0xff, frame.mappedBytes());
+        frame.unmap();
+    }
+    QCOMPARE(pool.pooledBufferCount(), 1);
+
+    QVideoFrame frame = pool.allocateFrame(QVideoFrame::Format_ARGB32, QSize(8, 8));
+    QCOMPARE(pool.reuseCount(), 1);
+    QVERIFY(frame.map(QAbstractVideoBuffer::ReadOnly));
+    // Recycled buffers are not cleared
+    QCOMPARE(frame.bits()[0], uchar(0xff));
+    frame.unmap();
+}
+
+void tst_QVideoBufferPool::poolOutlivedByFrames()
+{
+    QVideoFrame frame;
+    {
+        QVideoBufferPool pool;
+        frame = pool.allocateFrame(QVideoFrame::Format_ARGB32, QSize(32, 32));
+    }
+    QVERIFY(frame.map(QAbstractVideoBuffer::WriteOnly));
+    memset(frame.bits(), 0, frame.mappedBytes());
+    frame.unmap();
+    frame = QVideoFrame();
+}
+
+void tst_QVideoBufferPool::copyFrame()
+{
+    const QSize size(50, 22);
+    const int sourceStride = 60;
+    const int chromaStride = sourceStride / 2;
+    const int chromaRows = size.height() / 2;
+    const int sourceBytes = sourceStride * size.height() + chromaStride * size.height();
+
+    QVideoFrame source(sourceBytes, size, sourceStride, QVideoFrame::Format_YUV420P);
+    QVERIFY(source.map(QAbstractVideoBuffer::WriteOnly));
+    for (int plane = 0; plane < source.planeCount(); ++plane) {
+        const int rows = plane == 0 ? size.height() : chromaRows;
+        const int width = plane == 0 ? size.width() : size.width() / 2;
+        for (int y = 0; y < rows; ++y) {
+            uchar *line = source.bits(plane) + y * source.bytesPerLine(plane);
+            for (int x = 0; x < width; ++x)
+                line[x] = uchar(plane * 80 + x + y);
+        }
+    }
+    source.unmap();
+    source.setStartTime(1000);
+    source.setEndTime(2000);
+    source.setFieldType(QVideoFrame::TopField);
+    source.setMetaData(QStringLiteral("key"), 42);
+
+    QVideoBufferPool pool;
+    QVideoFrame copy = pool.copyFrame(source);
+    QVERIFY(copy.isValid());
+    QCOMPARE(copy.size(), size);
+    QCOMPARE(copy.pixelFormat(), QVideoFrame::Format_YUV420P);
+    QCOMPARE(copy.startTime(), qint64(1000));
+    QCOMPARE(copy.endTime(), qint64(2000));
+    QCOMPARE(copy.fieldType(), QVideoFrame::TopField);
+    QCOMPARE(copy.metaData(QStringLiteral("key")).toInt(), 42);
+
+    QVERIFY(copy.map(QAbstractVideoBuffer::ReadOnly));
+    QCOMPARE(copy.bytesPerLine(), 128);
+    for (int plane = 0; plane < copy.planeCount(); ++plane) {
+        const int rows = plane == 0 ? size.height() : chromaRows;
+        const int width = plane == 0 ? size.width() : size.width() / 2;
+        for (int y = 0; y < rows; ++y) {
+            const uchar *line = copy.bits(plane) + y * copy.bytesPerLine(plane);
+            for (int x = 0; x < width; ++x)
+                QCOMPARE(line[x], uchar(plane * 80 + x + y));
+        }
+    }
+    copy.unmap();
+
+    QVERIFY(!pool.copyFrame(QVideoFrame()).isValid());
+}
+
+void tst_QVideoBufferPool::allocationsPerSecond()
+{
+    QVideoBufferPool pool;
+    QCOMPARE(pool.allocationsPerSecond(), qreal(0));
+
+    QList<QVideoFrame> frames;
+    for (int i = 0; i < 10; ++i)
+        frames.append(pool.allocateFrame(QVideoFrame::Format_Y8, QSize(16, 16)));
+
+    QTest::qWait(1100);
+    QVERIFY(pool.allocationsPerSecond() > 0);
+    QVERIFY(pool.allocationsPerSecond() <= 10);
+}
+
+void tst_QVideoBufferPool::allocate_data()
+{
+    QTest::addColumn<bool>("pooled");
+
+    QTest::newRow("QMemoryVideoBuffer") << false;
+    QTest::newRow("QVideoBufferPool") << true;
+}
+
+void tst_QVideoBufferPool::allocate()
+{
+    QFETCH(bool, pooled);
+
+    const QSize size(1920, 1080);
+    const int bytesPerLine = QVideoBufferPool::alignedBytesPerLine(QVideoFrame::Format_NV12, size.width());
+    const int bytes = QVideoBufferPool::frameBytes(QVideoFrame::Format_NV12, size, bytesPerLine);
+
+    QVideoBufferPool pool;
+    QBENCHMARK {
+        QVideoFrame frame = pooled
+                ? pool.allocateFrame(QVideoFrame::Format_NV12, size)
+                : QVideoFrame(bytes, size, bytesPerLine, QVideoFrame::Format_NV12);
+        frame.map(QAbstractVideoBuffer::WriteOnly);
+        frame.bits()[0] = 1;
+        frame.unmap();
+    }
+}
+
+QTEST_MAIN(tst_QVideoBufferPool)
+
+#include "tst_qvideobufferpool.moc"
@@ -0,0 +1,6 @@
+CONFIG += testcase
+TARGET = tst_qvideoframeconversion
+
+QT += multimedia-private testlib
+
+SOURCES += tst_qvideoframeconversion.cpp
@@ -0,0 +1,388 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+//TESTED_COMPONENT=src/multimedia
+
+#include <QtTest/QtTest>
+#include <QtGui/QImage>
+#include <private/qvideoframe_p.h>
+
+Q_DECLARE_METATYPE(QVideoFrame::PixelFormat)
+
+class tst_QVideoFrameConversion : public QObject
+{
+    Q_OBJECT
+public:
+
+public slots:
+    void cleanup();
+
+private slots:
+    void convert_data();
+    void convert();
+    void bands_data();
+    void bands();
+    void scaled_data();
+    void scaled();
+    void throughput_data();
+    void throughput();
+
+private:
+    static void addFormats(const QSize &size, const char *sizeName);
+    static QVideoFrame createFrame(QVideoFrame::PixelFormat format, const QSize &size);
+    static QRgb referencePixel(const QVideoFrame &frame, int x, int y);
+};
+
+void tst_QVideoFrameConversion::cleanup()
+{
+    qt_setVideoFrameConversionThreadCount(1);
+}
+
+void tst_QVideoFrameConversion::addFormats(const QSize &size, const char *sizeName)
+{
+    static const struct {
+        QVideoFrame::PixelFormat format;
+        const char *name;
+    } formats[] = {
+        { QVideoFrame::Format_YUV420P, "YUV420P" },
+        { QVideoFrame::Format_YV12, "YV12" },
+        { QVideoFrame::Format_NV12, "NV12" },
+        { QVideoFrame::Format_NV21, "NV21" },
+        { QVideoFrame::Format_UYVY, "UYVY" },
+        { QVideoFrame::Format_YUYV, "YUYV" },
+        { QVideoFrame::Format_YUV444, "YUV444" },
+        { QVideoFrame::Format_AYUV444, "AYUV444" }
+    };
+
+    for (size_t i = 0; i < sizeof(formats) / sizeof(formats[0]); ++i) {
+        QTest::newRow(QByteArray(formats[i].name).append(' ').append(sizeName).constData())
+                << formats[i].format << size;
+    }
+}
+
+QVideoFrame tst_QVideoFrameConversion::createFrame(QVideoFrame::PixelFormat format, const QSize &size)
+{
+    const int width = size.width();
+    const int height = size.height();
+
+    int bytesPerLine = 0;
+    int bytes = 0;
+    switch (format) {
+    case QVideoFrame::Format_YUV420P:
+    case QVideoFrame::Format_YV12:
+    case QVideoFrame::Format_NV12:
+    case QVideoFrame::Format_NV21:
+        bytesPerLine = width;
+        bytes = width * height * 3 / 2;
+        break;
+    case QVideoFrame::Format_UYVY:
+    case QVideoFrame::Format_YUYV:
+        bytesPerLine = width * 2;
+        bytes = bytesPerLine * height;
+        break;
+    case QVideoFrame::Format_YUV444:
+        bytesPerLine = width * 3;
+        bytes = bytesPerLine * height;
+        break;
+    default:
+        bytesPerLine = width * 4;
+        bytes = bytesPerLine * height;
+        break;
+    }
+
+    QVideoFrame frame(bytes, size, bytesPerLine, format);
+    if (frame.map(QAbstractVideoBuffer::WriteOnly)) {
+        // Deterministic noise, covering the whole 0-255 range of every component
+        quint32 seed = 0x1234567;
+        uchar *bits = frame.bits();
+        for (int i = 0; i < frame.mappedBytes(); ++i) {
+            seed = seed * 1103515245 + 12345;
+            bits[i] = uchar(seed >> 16);
+        }
+        frame.unmap();
+    }
+    return frame;
+}
+
+static inline int clampComponent(int value)
+{
+    return qBound(0, value, 255);
+}
+
+// Straightforward per pixel version of the conversion, to validate the optimized paths
+QRgb tst_QVideoFrameConversion::referencePixel(const QVideoFrame &frame, int x, int y)
+{
+    const int width = frame.width();
+    const int height = frame.height();
+    const uchar *bits = frame.bits();
+    const int stride = frame.bytesPerLine();
+    const uchar *chroma = bits + stride * height;
+
+    int a = 0xff;
+    int luma = 0;
+    int u = 0;
+    int v = 0;
+
+    switch (frame.pixelFormat()) {
+    case QVideoFrame::Format_YUV420P:
+    case QVideoFrame::Format_YV12: {
+        const int uvStride = width / 2;
+        const uchar *first = chroma + (y / 2) * uvStride + x / 2;
+        const uchar *second = first + uvStride * height / 2;
+        luma = bits[y * stride + x];
+        u = frame.pixelFormat() == QVideoFrame::Format_YUV420P ? *first : *second;
+        v = frame.pixelFormat() == QVideoFrame::Format_YUV420P ? *second : *first;
+        break;
+    }
+    case QVideoFrame::Format_NV12:
+    case QVideoFrame::Format_NV21: {
+        const uchar *uv = chroma + (y / 2) * stride + (x / 2) * 2;
+        luma = bits[y * stride + x];
+        u = frame.pixelFormat() == QVideoFrame::Format_NV12 ? uv[0] : uv[1];
+        v = frame.pixelFormat() == QVideoFrame::Format_NV12 ? uv[1] : uv[0];
+        break;
+    }
+    case QVideoFrame::Format_UYVY: {
+        const uchar *pair = bits + y * stride + (x / 2) * 4;
+        luma = pair[1 + (x & 1) * 2];
+        u = pair[0];
+        v = pair[2];
+        break;
+    }
+    case QVideoFrame::Format_YUYV: {
+        const uchar *pair = bits + y * stride + (x / 2) * 4;
+        luma = pair[(x & 1) * 2];
+        u = pair[1];
+        v = pair[3];
+        break;
+    }
+    case QVideoFrame::Format_YUV444: {
+        const uchar *pixel = bits + y * stride + x * 3;
+        luma = pixel[0];
+        u = pixel[1];
+        v = pixel[2];
+        break;
+    }
+    default: {
+        const uchar *pixel = bits + y * stride + x * 4;
+        a = pixel[0];
+        luma = pixel[1];
+        u = pixel[2];
+        v = pixel[3];
+        break;
+    }
+    }
+
+    const int yy = (luma - 16) * 298;
+    const int uu = u - 128;
+    const int vv = v - 128;
+    return qRgba(clampComponent((yy + 409 * vv + 128) >> 8),
+                 clampComponent((yy - 100 * uu - 208 * vv - 128) >> 8),
+                 clampComponent((yy + 516 * uu + 128) >> 8),
+                 a);
+}
+
+void tst_QVideoFrameConversion::convert_data()
+{
+    QTest::addColumn<QVideoFrame::PixelFormat>("pixelFormat");
+    QTest::addColumn<QSize>("size");
+
+    // Sizes which are not a multiple of the vector widths exercise the leftover paths
+    addFormats(QSize(2, 2), "2x2");
+    addFormats(QSize(46, 10), "46x10");
+    addFormats(QSize(64, 16), "64x16");
+    addFormats(QSize(318, 20), "318x20");
+}
+
+void tst_QVideoFrameConversion::convert()
+{
+    QFETCH(QVideoFrame::PixelFormat, pixelFormat);
+    QFETCH(QSize, size);
+
+    QVideoFrame frame = createFrame(pixelFormat, size);
+    const QImage image = qt_imageFromVideoFrame(frame);
+    QCOMPARE(image.size(), size);
+    QCOMPARE(image.format(), QImage::Format_ARGB32);
+
+    QVERIFY(frame.map(QAbstractVideoBuffer::ReadOnly));
+    for (int y = 0; y < size.height(); ++y) {
+        const QRgb *line = reinterpret_cast<const QRgb *>(image.constScanLine(y));
+        for (int x = 0; x < size.width(); ++x) {
+            const QRgb expected = referencePixel(frame, x, y);
+            if (line[x] != expected) {
+                frame.unmap();
+                QFAIL(qPrintable(QString::fromLatin1("Pixel (%1, %2) is %3, expected %4")
+                                 .arg(x).arg(y)
+                                 .arg(line[x], 8, 16, QLatin1Char('0'))
+                                 .arg(expected, 8, 16, QLatin1Char('0'))));
+            }
+        }
+    }
+    frame.unmap();
+}
+
+void tst_QVideoFrameConversion::bands_data()
+{
+    QTest::addColumn<QVideoFrame::PixelFormat>("pixelFormat");
+    QTest::addColumn<QSize>("size");
+
+    addFormats(QSize(1920, 1080), "1080p");
+    addFormats(QSize(1282, 722), "1282x722");
+}
+
+void tst_QVideoFrameConversion::bands()
+{
+    QFETCH(QVideoFrame::PixelFormat, pixelFormat);
+    QFETCH(QSize, size);
+
+    QVideoFrame frame = createFrame(pixelFormat, size);
+
+    qt_setVideoFrameConversionThreadCount(1);
+    const QImage expected = qt_imageFromVideoFrame(frame);
+
+    foreach (int threads, QList<int>() << 2 << 3 << 8) {
+        qt_setVideoFrameConversionThreadCount(threads);
+        QCOMPARE(qt_imageFromVideoFrame(frame), expected);
+    }
+}
+
+void tst_QVideoFrameConversion::scaled_data()
+{
+    QTest::addColumn<QVideoFrame::PixelFormat>("pixelFormat");
+    QTest::addColumn<QSize>("size");
+
+    addFormats(QSize(64, 16), "64x16");
+    addFormats(QSize(318, 20), "318x20");
+}
+
+void tst_QVideoFrameConversion::scaled()
+{
+    QFETCH(QVideoFrame::PixelFormat, pixelFormat);
+    QFETCH(QSize, size);
+
+    QVideoFrame frame = createFrame(pixelFormat, size);
+    QVERIFY(frame.map(QAbstractVideoBuffer::ReadOnly));
+
+    const QRect source(2, 2, size.width() - 4, size.height() - 2);
+    const QList<QSize> targetSizes = QList<QSize>()
+            << source.size() << source.size() / 2 << QSize(source.width() * 3 / 2 + 1, 27);
+    const QList<Qt::Orientations> orientations = QList<Qt::Orientations>()
+            << Qt::Orientations(0) << Qt::Horizontal << (Qt::Horizontal | Qt::Vertical);
+
+    if (pixelFormat == QVideoFrame::Format_AYUV444) {
+        QImage image(targetSizes.first(), QImage::Format_RGB32);
+        QVERIFY(!qt_convertVideoFrameScaled(frame, source, &image));
+        frame.unmap();
+        return;
+    }
+
+    foreach (const QSize &targetSize, targetSizes) {
+        foreach (Qt::Orientations mirrored, orientations) {
+            QImage image(targetSize, QImage::Format_RGB32);
+            QVERIFY(qt_convertVideoFrameScaled(frame, source, &image, mirrored));
+
+            for (int y = 0; y < targetSize.height(); ++y) {
+                const int row = mirrored & Qt::Vertical ? targetSize.height() - 1 - y : y;
+                const int sourceY = source.y() + (2 * row + 1) * source.height() / (2 * targetSize.height());
+                const QRgb *line = reinterpret_cast<const QRgb *>(image.constScanLine(y));
+                for (int x = 0; x < targetSize.width(); ++x) {
+                    const int column = mirrored & Qt::Horizontal ? targetSize.width() - 1 - x : x;
+                    const int sourceX = source.x() + (2 * column + 1) * source.width() / (2 * targetSize.width());
+                    const QRgb expected = referencePixel(frame, sourceX, sourceY);
+                    if (line[x] != expected) {
+                        frame.unmap();
+                        QFAIL(qPrintable(QString::fromLatin1("Pixel (%1, %2) of %3x%4 is %5, expected %6")
+                                         .arg(x).arg(y)
+                                         .arg(targetSize.width()).arg(targetSize.height())
+                                         .arg(line[x], 8, 16, QLatin1Char('0'))
+                                         .arg(expected, 8, 16, QLatin1Char('0'))));
+                    }
+                }
+            }
+        }
+    }
+    frame.unmap();
+}
+
+void tst_QVideoFrameConversion::throughput_data()
+{
+    QTest::addColumn<QVideoFrame::PixelFormat>("pixelFormat");
+    QTest::addColumn<QSize>("size");
+    QTest::addColumn<int>("threads");
+
+    static const struct {
+        QVideoFrame::PixelFormat format;
+        const char *name;
+    } formats[] = {
+        { QVideoFrame::Format_YUV420P, "YUV420P" },
+        { QVideoFrame::Format_NV12, "NV12" },
+        { QVideoFrame::Format_UYVY, "UYVY" },
+        { QVideoFrame::Format_YUV444, "YUV444" },
+        { QVideoFrame::Format_BGRA32, "BGRA32" }
+    };
+
+    const int threads = qMax(2, QThread::idealThreadCount());
+
+    for (size_t i = 0; i < sizeof(formats) / sizeof(formats[0]); ++i) {
+        const QByteArray name(formats[i].name);
+        QTest::newRow(QByteArray(name + " 1080p").constData())
+                << formats[i].format << QSize(1920, 1080) << 1;
+        QTest::newRow(QByteArray(name + " 1080p threaded").constData())
+                << formats[i].format << QSize(1920, 1080) << threads;
+        QTest::newRow(QByteArray(name + " 4K").constData())
+                << formats[i].format << QSize(3840, 2160) << 1;
+        QTest::newRow(QByteArray(name + " 4K threaded").constData())
+                << formats[i].format << QSize(3840, 2160) << threads;
+    }
+}
+
+void tst_QVideoFrameConversion::throughput()
+{
+    QFETCH(QVideoFrame::PixelFormat, pixelFormat);
+    QFETCH(QSize, size);
+    QFETCH(int, threads);
+
+    QVideoFrame frame = createFrame(pixelFormat, size);
+    qt_setVideoFrameConversionThreadCount(threads);
+
+    QImage image;
+    QBENCHMARK {
+        image = qt_imageFromVideoFrame(frame);
+    }
+    QCOMPARE(image.size(), size);
+}
+
+QTEST_MAIN(tst_QVideoFrameConversion)
+
+#include "tst_qvideoframeconversion.moc"
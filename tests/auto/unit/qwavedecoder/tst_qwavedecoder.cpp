@@ -40,6 +40,37 @@
 #include <QNetworkRequest>
 #include <QNetworkReply>
 
+// A random access device still being filled, like a download cache.
+class GrowingDevice : public QIODevice
+{
+public:
+    GrowingDevice()
+    {
+        open(QIODevice::ReadOnly);
+    }
+
+    void append(const QByteArray &data)
+    {
+        m_data.append(data);
+        emit readyRead();
+    }
+
+    qint64 size() const { return m_data.size(); }
+
+protected:
+    qint64 readData(char *data, qint64 maxSize)
+    {
+        const qint64 length = qMax<qint64>(0, qMin(maxSize, m_data.size() - pos()));
+        memcpy(data, m_data.constData() + pos(), length);
+        return length;
+    }
+
+    qint64 writeData(const char *, qint64) { return -1; }
+
+private:
+    QByteArray m_data;
+};
+
 class tst_QWaveDecoder : public QObject
 {
     Q_OBJECT
@@ -70,6 +101,7 @@ private slots:
 
     void readAllAtOnce();
     void readPerByte();
+    void randomAccessGrowing();
 };
 
 Q_DECLARE_METATYPE(tst_QWaveDecoder::Corruption)
@@ -177,6 +209,8 @@ void tst_QWaveDecoder::file()
         QCOMPARE(parsingErrorSpy.count(), 0);
         QVERIFY(waveDecoder.audioFormat().isValid());
         QVERIFY(waveDecoder.size() > 0);
+        QCOMPARE(waveDecoder.dataOffset(), stream.pos());
+        QVERIFY(waveDecoder.dataOffset() + waveDecoder.size() <= stream.size());
         QVERIFY(waveDecoder.duration() == 250);
         QAudioFormat format = waveDecoder.audioFormat();
         QVERIFY(format.isValid());
@@ -304,6 +338,45 @@ void tst_QWaveDecoder::readPerByte()
     stream.close();
 }
 
+void tst_QWaveDecoder::randomAccessGrowing()
+{
+    QFile file(testFilePath("isawav_2_8_44100.wav"));
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    const QByteArray content = file.readAll();
+    QVERIFY(content.size() > 64);
+
+    // Only part of the RIFF header is there when the decoder is created, and
+    // the second part stops inside the format chunk
+    GrowingDevice stream;
+    stream.append(content.left(6));
+    QVERIFY(!stream.isSequential());
+
+    QWaveDecoder waveDecoder(&stream);
+    QSignalSpy validFormatSpy(&waveDecoder, SIGNAL(formatKnown()));
+    QSignalSpy parsingErrorSpy(&waveDecoder, SIGNAL(parsingError()));
+
+    QTest::qWait(50);
+    QCOMPARE(validFormatSpy.count(), 0);
+    QCOMPARE(parsingErrorSpy.count(), 0);
+
+    stream.append(content.mid(6, 24));
+    QTest::qWait(50);
+    QCOMPARE(validFormatSpy.count(), 0);
+
+    stream.append(content.mid(30));
+    QTRY_COMPARE(validFormatSpy.count(), 1);
+    QCOMPARE(parsingErrorSpy.count(), 0);
+    QCOMPARE(waveDecoder.audioFormat().channelCount(), 2);
+    QCOMPARE(waveDecoder.audioFormat().sampleRate(), 44100);
+    QVERIFY(waveDecoder.size() > 0);
+
+    // Nothing is parsed again once the format is known
+    stream.append(QByteArray(16, 0));
+    QTest::qWait(50);
+    QCOMPARE(validFormatSpy.count(), 1);
+    QCOMPARE(parsingErrorSpy.count(), 0);
+}
+
 QTEST_MAIN(tst_QWaveDecoder)
 
 #include "tst_qwavedecoder.moc"